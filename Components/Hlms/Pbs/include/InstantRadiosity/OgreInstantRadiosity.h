@@ -30,13 +30,13 @@ THE SOFTWARE.
 
 #include "OgreHlmsPbsPrerequisites.h"
 
-#include "Math/Array/OgreArrayRay.h"
+#include "Math/Array/OgreObjectData.h"
 #include "OgreConstBufferPool.h"
 #include "OgreHlmsBufferManager.h"
-#include "OgreRawPtr.h"
 #include "OgreRay.h"
 #include "OgreTextureBox.h"
 #include "OgreVector2.h"
+#include "Threading/OgreWorkStealingRange.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -50,7 +50,10 @@ namespace Ogre
      */
 
     class RandomNumberGenerator;
+    class HlmsPbsDatablock;
     class IrradianceVolume;
+    class ObjectSpatialIndex;
+    class TriangleBvh;
 
     class _OgreHlmsPbsExport InstantRadiosity
     {
@@ -67,8 +70,14 @@ namespace Ogre
             size_t numVertices;
             size_t numIndices;
             bool   useIndices16bit;
+            /// Built right after downloading, in mesh space
+            TriangleBvh *bvh;
 
             float *getUvStart( uint8_t uvSet ) const;
+
+            size_t getNumTriangles() const { return ( indexData ? numIndices : numVertices ) / 3u; }
+            void   getTriangle( size_t triangleIdx, uint32 outVertexIdx[3] ) const;
+            void   buildTriangleBvh();
         };
 
         struct MaterialData
@@ -93,6 +102,29 @@ namespace Ogre
             Vector3 triNormal;
             Vector2 triUVs[5][3];  // Up to 5 UVs (one per material image)
         };
+        /// A Renderable rays can hit
+        struct MeshInstance
+        {
+            MeshData const *meshData;
+            Matrix4         worldMatrix;
+            /// Takes rays to mesh space
+            Matrix4 invWorldMatrix;
+            /// Back faces are never hit. In mesh space they depend on the sign of the scale
+            CullingMode  cullMode;
+            MaterialData material;
+        };
+
+        /// The objects of one render queue of one memory manager
+        struct RaycastRange
+        {
+            ObjectData          objData;
+            size_t              numObjects;
+            ObjectSpatialIndex *spatialIndex;
+            /// The MeshInstances of object k are in range
+            /// [mObjectInstances[firstSlot + k]; mObjectInstances[firstSlot + k + 1])
+            size_t firstSlot;
+        };
+
         struct Vpl
         {
             Light  *light;
@@ -230,10 +262,20 @@ namespace Ogre
         size_t    mTotalNumRays;  ///< Includes bounces. Autogenerated.
         VplVec    mVpls;
         RayHitVec mRayHits;
-        RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL> mArrayRays;
 
-        FastArray<size_t> mTmpRaysThatHitObject[ARRAY_PACKED_REALS];
-        SparseClusterSet  mTmpSparseClusters[3];
+        /// Gathered by gatherMeshInstances once per build; reused by all lights & bounces
+        vector<MeshInstance>::type mMeshInstances;
+        FastArray<RaycastRange>    mRaycastRanges;
+        FastArray<uint32>          mObjectInstances;
+        /// Same layout as mObjectInstances. Whether the rays of the current light can hit the object
+        FastArray<uint8> mObjectEnabled;
+
+        /// Rays being cast by _raycastThread
+        WorkStealingRange mRaycastWorkRange;
+        size_t            mRaycastStart;
+        Real              mRaycastMaxDistance;
+
+        SparseClusterSet mTmpSparseClusters[3];
 
         typedef map<VertexArrayObject *, MeshData>::type                       MeshDataMapV2;
         typedef map<v1::RenderOperation, MeshData, OrderRenderOperation>::type MeshDataMapV1;
@@ -280,12 +322,25 @@ namespace Ogre
         const MeshData *downloadRenderOp( const v1::RenderOperation &renderOp );
         const Image2   &downloadTexture( TextureGpu *texture );
 
-        void testLightVsAllObjects( uint8 lightType, Real lightRange, ObjectData objData,
-                                    size_t numNodes, const AreaOfInterest &areaOfInterest,
-                                    size_t rayStart, size_t numRays );
-        void raycastLightRayVsMesh( Real lightRange, const MeshData meshData, Matrix4 worldMatrix,
-                                    const MaterialData      &material,
-                                    const FastArray<size_t> &raysThatHitObj );
+        void getMaterialData( HlmsPbsDatablock *pbsDatablock, MaterialData &outMaterial );
+
+        /** Downloads the meshes of every visible object and builds the acceleration structures
+            (a TriangleBvh per mesh and an ObjectSpatialIndex per render queue)
+        @param onlyInAoI
+            Skip the objects outside all mAoI. For when all lights are directional.
+        */
+        void gatherMeshInstances( bool onlyInAoI );
+        /// Whether any light build processes isn't directional (i.e. isn't limited to mAoI)
+        bool hasNonDirectionalLights() const;
+        void destroyMeshInstances();
+        /// Fills mObjectEnabled with the objects the rays of the light can hit
+        void enableObjectsForLight( uint8 lightType, const AreaOfInterest &areaOfInterest );
+
+        /// Finds the closest hit of rays mRayHits[rayStart] through mRayHits[rayStart+numRays-1]
+        /// using all worker threads
+        void raycast( size_t rayStart, size_t numRays, Real lightRange );
+        void fillRayHit( RayHit &rayHit, Real distance, const MeshInstance &instance,
+                         uint32 triangleIdx ) const;
 
         Vpl convertToVpl( Vector3 lightColour, Vector3 pointOnTri, const RayHit &hit );
         /// Generates the VPLs from a particular lights, and clusters them.
@@ -321,6 +376,9 @@ namespace Ogre
 
         void build();
 
+        /// Casts the rays acquired by the given thread. Called from worker threads during build.
+        void _raycastThread( size_t threadIdx );
+
         /// "build" will download meshes for raycasting. We will not free
         /// them after build (in case you want to build again).
         /// If you wish to free that memory, call this function.
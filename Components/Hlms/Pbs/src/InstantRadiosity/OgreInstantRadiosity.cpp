@@ -30,7 +30,8 @@ THE SOFTWARE.
 
 #include "InstantRadiosity/OgreInstantRadiosity.h"
 
-#include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreObjectSpatialIndex.h"
+#include "Math/Array/OgreTriangleBvh.h"
 #include "OgreBitwise.h"
 #include "OgreHlmsManager.h"
 #include "OgreHlmsPbs.h"
@@ -44,6 +45,7 @@ THE SOFTWARE.
 #include "OgreRay.h"
 #include "OgreSceneManager.h"
 #include "OgreTextureGpu.h"
+#include "Threading/OgreUniformScalableTask.h"
 #include "Vao/OgreAsyncTicket.h"
 #include "Vao/OgreIndexBufferPacked.h"
 #include "Vao/OgreVertexArrayObject.h"
@@ -127,6 +129,33 @@ namespace Ogre
             return retVal;
         }
     };
+
+    namespace
+    {
+        /// Runs InstantRadiosity::_raycastThread in the SceneManager worker threads
+        class InstantRadiosityRaycastTask final : public UniformScalableTask
+        {
+            InstantRadiosity *mInstantRadiosity;
+
+        public:
+            InstantRadiosityRaycastTask( InstantRadiosity *instantRadiosity ) :
+                mInstantRadiosity( instantRadiosity )
+            {
+            }
+            void execute( size_t threadId, size_t ) override
+            {
+                mInstantRadiosity->_raycastThread( threadId );
+            }
+        };
+
+        /// Bounds of everything the rays of a directional light can hit
+        Aabb getAoIBounds( const InstantRadiosity::AreaOfInterest &areaOfInterest )
+        {
+            Aabb retVal = areaOfInterest.aabb;
+            retVal.merge( Aabb( retVal.mCenter, Vector3( areaOfInterest.sphereRadius ) ) );
+            return retVal;
+        }
+    }  // namespace
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
@@ -155,6 +184,8 @@ namespace Ogre
         mVplIntensityRangeMultiplier( 100.0 ),
         mMipmapBias( 0 ),
         mTotalNumRays( 0 ),
+        mRaycastStart( 0 ),
+        mRaycastMaxDistance( 0 ),
         mEnableDebugMarkers( false ),
         mUseTextures( true ),
         mUseIrradianceVolume( false )
@@ -604,8 +635,6 @@ namespace Ogre
         RandomNumberGenerator rng;
         mRayHits.resize( mTotalNumRays );
 
-        ArrayRay *RESTRICT_ALIAS arrayRays = mArrayRays.get();
-
         for( size_t i = 0; i < mNumRays; ++i )
         {
             mRayHits[i].distance = std::numeric_limits<Real>::max();
@@ -638,10 +667,6 @@ namespace Ogre
                 mRayHits[i].ray.setOrigin( randomPos );
                 mRayHits[i].ray.setDirection( -lightRot.zAxis() );
             }
-
-            arrayRays->mOrigin.setAll( mRayHits[i].ray.getOrigin() );
-            arrayRays->mDirection.setAll( mRayHits[i].ray.getDirection() );
-            ++arrayRays;
         }
 
         // Initialize all other rays (some rays may not be initialized
@@ -652,26 +677,11 @@ namespace Ogre
         size_t rayStart = 0;
         size_t numRays = mNumRays;
 
+        enableObjectsForLight( lightType, areaOfInterest );
+
         for( size_t k = 0; k < mNumRayBounces + 1u; ++k )
         {
-            for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
-            {
-                ObjectMemoryManager &memoryManager =
-                    mSceneManager->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
-
-                const size_t numRenderQueues = memoryManager.getNumRenderQueues();
-
-                size_t firstRq = std::min<size_t>( mFirstRq, numRenderQueues );
-                size_t lastRq = std::min<size_t>( mLastRq, numRenderQueues );
-
-                for( size_t j = firstRq; j < lastRq; ++j )
-                {
-                    ObjectData objData;
-                    const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                    testLightVsAllObjects( lightType, lightRange, objData, totalObjs, areaOfInterest,
-                                           rayStart, numRays );
-                }
-            }
+            raycast( rayStart, numRays, lightRange );
 
             const size_t oldRayStart = rayStart;
             const size_t oldNumRays = numRays;
@@ -698,8 +708,6 @@ namespace Ogre
 
         const Real bias = mBias;
 
-        ArrayRay *RESTRICT_ALIAS arrayRays = mArrayRays.get();
-
         while( rayIdx < raySrcLimit && raysRemaining > 0 )
         {
             while( rayIdx < raySrcLimit &&
@@ -719,8 +727,6 @@ namespace Ogre
                 mRayHits[i].ray.setOrigin( pointOnTri );
                 mRayHits[i].ray.setDirection(
                     rng.randomizeDirAroundCone( hit.triNormal, Degree( 90.0f ) ) );
-                arrayRays[i].mOrigin.setAll( mRayHits[i].ray.getOrigin() );
-                arrayRays[i].mDirection.setAll( mRayHits[i].ray.getDirection() );
 
                 ++rayIdx;
                 --raysRemaining;
@@ -879,6 +885,8 @@ namespace Ogre
             }
         }
 
+        meshData.buildTriangleBvh();
+
         mMeshDataMapV2[vao] = meshData;
 
         return &mMeshDataMapV2[vao];
@@ -1005,6 +1013,8 @@ namespace Ogre
                     renderOp.indexData->indexCount * renderOp.indexData->indexBuffer->getIndexSize() );
         }
 
+        meshData.buildTriangleBvh();
+
         mMeshDataMapV1[renderOp] = meshData;
 
         return &mMeshDataMapV1[renderOp];
@@ -1023,261 +1033,373 @@ namespace Ogre
         return itor->second;
     }
     //-----------------------------------------------------------------------------------
-    void InstantRadiosity::testLightVsAllObjects( uint8 lightType, Real lightRange, ObjectData objData,
-                                                  size_t numNodes,
-                                                  const AreaOfInterest &scalarAreaOfInterest,
-                                                  size_t rayStart, size_t numRays )
+    void InstantRadiosity::getMaterialData( HlmsPbsDatablock *pbsDatablock, MaterialData &outMaterial )
     {
-        Aabb biggestAoI = scalarAreaOfInterest.aabb;
-        biggestAoI.merge( Aabb( biggestAoI.mCenter, Vector3( scalarAreaOfInterest.sphereRadius ) ) );
+        MaterialData &material = outMaterial;
+        silent_memset( &material, 0, sizeof( material ) );
+        int imageIdx = 0;
+
+        // TODO: Should we account fresnel here? What about metalness?
+        material.diffuse = pbsDatablock->getDiffuse();
+        TextureGpu *diffuseTex = pbsDatablock->getTexture( PBSM_DIFFUSE );
+        if( diffuseTex )
+            diffuseTex->waitForMetadata();
+        if( !diffuseTex || PixelFormatGpuUtils::isCompressed( diffuseTex->getPixelFormat() ) )
+        {
+            const ColourValue &bgDiffuse = pbsDatablock->getBackgroundDiffuse();
+            material.diffuse.x *= bgDiffuse.r;
+            material.diffuse.y *= bgDiffuse.g;
+            material.diffuse.z *= bgDiffuse.b;
+        }
+        else if( mUseTextures )
+        {
+            material.image[imageIdx] = &downloadTexture( diffuseTex );
+            material.box[imageIdx] = material.image[imageIdx]->getData( 0 );
+            material.uvSet[imageIdx] = pbsDatablock->getTextureUvSource( PBSM_DIFFUSE );
+            material.needsUv = true;
+            ++imageIdx;
+        }
 
-        const ArrayInt sceneFlags =
-            Mathlib::SetAll( mVisibilityMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS );
-        ArrayAabb areaOfInterest( ArrayVector3::ZERO, ArrayVector3::ZERO );
-        areaOfInterest.setAll( biggestAoI );
+        if( mUseTextures )
+        {
+            for( int k = 0; k < 4; ++k )
+            {
+                const PbsTextureTypes texType = static_cast<PbsTextureTypes>( PBSM_DETAIL0 + k );
+                TextureGpu *detailTex = pbsDatablock->getTexture( texType );
+                if( detailTex )
+                    detailTex->waitForMetadata();
+                if( detailTex && !PixelFormatGpuUtils::isCompressed( detailTex->getPixelFormat() ) )
+                {
+                    material.image[imageIdx] = &downloadTexture( detailTex );
+                    material.box[imageIdx] = material.image[imageIdx]->getData( 0 );
+                    material.uvSet[imageIdx] = pbsDatablock->getTextureUvSource( texType );
+                    material.needsUv = true;
+                    ++imageIdx;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::gatherMeshInstances( bool onlyInAoI )
+    {
+        destroyMeshInstances();
 
-        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        const uint32 sceneFlags = mVisibilityMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
+
+        FastArray<Aabb> aoiBounds;
+        if( onlyInAoI )
+        {
+            for( size_t i = 0; i < mAoI.size(); ++i )
+                aoiBounds.push_back( getAoIBounds( mAoI[i] ) );
+        }
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
-            ArrayInt *RESTRICT_ALIAS visibilityFlags =
-                reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mVisibilityFlags );
+            ObjectMemoryManager &memoryManager =
+                mSceneManager->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
 
-            // isObjectHitByRays = isVisble;
-            ArrayMaskI isObjectHitByRays = Mathlib::TestFlags4(
-                *visibilityFlags, Mathlib::SetAll( VisibilityFlags::LAYER_VISIBILITY ) );
-            // isObjectHitByRays = isVisble & (sceneFlags & visibilityFlags);
-            isObjectHitByRays =
-                Mathlib::And( isObjectHitByRays, Mathlib::TestFlags4( sceneFlags, *visibilityFlags ) );
+            const size_t numRenderQueues = memoryManager.getNumRenderQueues();
 
-            if( lightType == Light::LT_DIRECTIONAL )
-            {
-                // Check if obj is in area of interest for directional lights
-                ArrayMaskI hitMask = CastRealToInt( areaOfInterest.intersects( *objData.mWorldAabb ) );
-                isObjectHitByRays = Mathlib::And( isObjectHitByRays, hitMask );
-            }
+            size_t firstRq = std::min<size_t>( mFirstRq, numRenderQueues );
+            size_t lastRq = std::min<size_t>( mLastRq, numRenderQueues );
 
-            if( BooleanMask4::getScalarMask( isObjectHitByRays ) == 0 )
+            for( size_t j = firstRq; j < lastRq; ++j )
             {
-                // None of these objects are visible. Early out.
-                objData.advancePack();
-                continue;
-            }
+                RaycastRange range;
+                range.numObjects = memoryManager.getFirstObjectData( range.objData, j );
+                range.spatialIndex = 0;
+                range.firstSlot = mObjectInstances.size();
 
-            for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
-                mTmpRaysThatHitObject[k].clear();
+                const ObjectData &objData = range.objData;
+                const uint32 firstInstance = static_cast<uint32>( mMeshInstances.size() );
 
-            // Make a list of rays that hit these objects (i.e. broadphase)
-            ArrayRay *RESTRICT_ALIAS arrayRays = mArrayRays.get() + rayStart;
-            for( size_t j = 0; j < numRays; ++j )
-            {
-                ArrayMaskR rayHits = arrayRays->intersects( *objData.mWorldAabb );
-                uint32 scalarRayHits = BooleanMask4::getScalarMask( rayHits );
-                for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
+                mObjectInstances.resizePOD( range.firstSlot + range.numObjects + 1u, firstInstance );
+
+                for( size_t k = 0; k < range.numObjects; ++k )
                 {
-                    if( IS_BIT_SET( k, scalarRayHits ) )
-                        mTmpRaysThatHitObject[k].push_back( j + rayStart );
-                }
+                    mObjectInstances[range.firstSlot + k] = static_cast<uint32>( mMeshInstances.size() );
 
-                ++arrayRays;
-            }
+                    // isObjectHitByRays = isVisble & (sceneFlags & visibilityFlags);
+                    const uint32 visibilityFlags = objData.mVisibilityFlags[k];
+                    if( !( visibilityFlags & VisibilityFlags::LAYER_VISIBILITY ) ||
+                        !( visibilityFlags & sceneFlags ) )
+                    {
+                        continue;
+                    }
 
-            for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
-            {
-                // Convert isObjectHitByRays into something smaller we can work with.
-                uint32 scalarIsObjectHitByRays = BooleanMask4::getScalarMask( isObjectHitByRays );
+                    if( onlyInAoI )
+                    {
+                        // No light can reach it; don't download its meshes
+                        Aabb aabb;
+                        objData.mWorldAabb[k / ARRAY_PACKED_REALS].getAsAabb( aabb,
+                                                                              k % ARRAY_PACKED_REALS );
+                        bool inAoI = false;
+                        for( size_t l = 0; l < aoiBounds.size() && !inAoI; ++l )
+                            inAoI = aoiBounds[l].intersects( aabb );
+                        if( !inAoI )
+                            continue;
+                    }
 
-                if( !mTmpRaysThatHitObject[j].empty() && IS_BIT_SET( j, scalarIsObjectHitByRays ) )
-                {
-                    MovableObject *movableObject = objData.mOwner[j];
+                    MovableObject *movableObject = objData.mOwner[k];
+
+                    MeshInstance instance;
+                    instance.worldMatrix = movableObject->_getParentNodeFullTransform();
+                    instance.invWorldMatrix = instance.worldMatrix.inverseAffine();
+                    instance.cullMode =
+                        instance.worldMatrix.hasNegativeScale() ? CULL_ANTICLOCKWISE : CULL_CLOCKWISE;
 
-                    const Matrix4 &worldMatrix = movableObject->_getParentNodeFullTransform();
                     RenderableArray::const_iterator itor = movableObject->mRenderables.begin();
                     RenderableArray::const_iterator end = movableObject->mRenderables.end();
 
                     while( itor != end )
                     {
-                        const VertexArrayObjectArray &vaos = ( *itor )->getVaos( VpNormal );
-                        MeshData const *meshData = 0;
-                        if( !vaos.empty() )
-                        {
-                            // v2 object
-                            VertexArrayObject *vao = vaos[0];  // TODO Allow picking a LOD.
-                            meshData = downloadVao( vao );
-                        }
-                        else
-                        {
-                            // v1 object
-                            v1::RenderOperation renderOp;
-                            ( *itor )->getRenderOperation( renderOp, false );
-                            meshData = downloadRenderOp( renderOp );
-                        }
-
                         HlmsDatablock *datablock = ( *itor )->getDatablock();
 
                         if( datablock->mType == HLMS_PBS )
                         {
-                            MaterialData material;
-                            silent_memset( &material, 0, sizeof( material ) );
-                            int imageIdx = 0;
-
-                            HlmsPbsDatablock *pbsDatablock =
-                                static_cast<HlmsPbsDatablock *>( datablock );
-                            // TODO: Should we account fresnel here? What about metalness?
-                            material.diffuse = pbsDatablock->getDiffuse();
-                            TextureGpu *diffuseTex = pbsDatablock->getTexture( PBSM_DIFFUSE );
-                            if( diffuseTex )
-                                diffuseTex->waitForMetadata();
-                            if( !diffuseTex ||
-                                PixelFormatGpuUtils::isCompressed( diffuseTex->getPixelFormat() ) )
+                            const VertexArrayObjectArray &vaos = ( *itor )->getVaos( VpNormal );
+                            if( !vaos.empty() )
                             {
-                                const ColourValue &bgDiffuse = pbsDatablock->getBackgroundDiffuse();
-                                material.diffuse.x *= bgDiffuse.r;
-                                material.diffuse.y *= bgDiffuse.g;
-                                material.diffuse.z *= bgDiffuse.b;
+                                // v2 object
+                                VertexArrayObject *vao = vaos[0];  // TODO Allow picking a LOD.
+                                instance.meshData = downloadVao( vao );
                             }
-                            else if( mUseTextures )
+                            else
                             {
-                                material.image[imageIdx] = &downloadTexture( diffuseTex );
-                                material.box[imageIdx] = material.image[imageIdx]->getData( 0 );
-                                material.uvSet[imageIdx] =
-                                    pbsDatablock->getTextureUvSource( PBSM_DIFFUSE );
-                                material.needsUv = true;
-                                ++imageIdx;
+                                // v1 object
+                                v1::RenderOperation renderOp;
+                                ( *itor )->getRenderOperation( renderOp, false );
+                                instance.meshData = downloadRenderOp( renderOp );
                             }
 
-                            if( mUseTextures )
+                            if( !instance.meshData->bvh->isEmpty() )
                             {
-                                for( int k = 0; k < 4; ++k )
-                                {
-                                    const PbsTextureTypes texType =
-                                        static_cast<PbsTextureTypes>( PBSM_DETAIL0 + k );
-                                    TextureGpu *detailTex = pbsDatablock->getTexture( texType );
-                                    if( detailTex )
-                                        detailTex->waitForMetadata();
-                                    if( detailTex && !PixelFormatGpuUtils::isCompressed(
-                                                         detailTex->getPixelFormat() ) )
-                                    {
-                                        material.image[imageIdx] = &downloadTexture( detailTex );
-                                        material.box[imageIdx] = material.image[imageIdx]->getData( 0 );
-                                        material.uvSet[imageIdx] =
-                                            pbsDatablock->getTextureUvSource( texType );
-                                        material.needsUv = true;
-                                        ++imageIdx;
-                                    }
-                                }
+                                getMaterialData( static_cast<HlmsPbsDatablock *>( datablock ),
+                                                 instance.material );
+                                mMeshInstances.push_back( instance );
                             }
-
-                            raycastLightRayVsMesh( lightRange, *meshData, worldMatrix, material,
-                                                   mTmpRaysThatHitObject[j] );
                         }
 
                         ++itor;
                     }
                 }
-            }
 
-            objData.advancePack();
+                const uint32 lastInstance = static_cast<uint32>( mMeshInstances.size() );
+                mObjectInstances[range.firstSlot + range.numObjects] = lastInstance;
+
+                if( firstInstance == lastInstance )
+                {
+                    // Nothing to hit in this render queue
+                    mObjectInstances.resizePOD( range.firstSlot );
+                }
+                else
+                {
+                    range.spatialIndex = OGRE_NEW ObjectSpatialIndex();
+                    range.spatialIndex->build( objData, range.numObjects, 0 );
+                    mRaycastRanges.push_back( range );
+                }
+            }
         }
+
+        mObjectEnabled.resizePOD( mObjectInstances.size(), 0 );
     }
     //-----------------------------------------------------------------------------------
-    void InstantRadiosity::raycastLightRayVsMesh( Real lightRange, const MeshData meshData,
-                                                  Matrix4 worldMatrix, const MaterialData &material,
-                                                  const FastArray<size_t> &raysThatHitObj )
+    bool InstantRadiosity::hasNonDirectionalLights() const
     {
-        const size_t numElements = meshData.indexData ? meshData.numIndices : meshData.numVertices;
+        const uint32 lightMask = mLightMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
 
-        const uint16 *RESTRICT_ALIAS indexData16 =
-            reinterpret_cast<const uint16 * RESTRICT_ALIAS>( meshData.indexData );
-        const uint32 *RESTRICT_ALIAS indexData32 =
-            reinterpret_cast<const uint32 * RESTRICT_ALIAS>( meshData.indexData );
+        ObjectMemoryManager &memoryManager = mSceneManager->_getLightMemoryManager();
+        const size_t numRenderQueues = memoryManager.getNumRenderQueues();
 
-        for( size_t i = 0; i < numElements; i += 3 )
+        for( size_t i = 0; i < numRenderQueues; ++i )
         {
-            Vector3 triVerts[3];
-
-            uint32 vertexIdx[3];
+            ObjectData objData;
+            const size_t totalObjs = memoryManager.getFirstObjectData( objData, i );
 
-            if( meshData.indexData )
+            for( size_t j = 0; j < totalObjs; ++j )
             {
-                if( meshData.useIndices16bit )
-                {
-                    vertexIdx[0] = indexData16[i + 0];
-                    vertexIdx[1] = indexData16[i + 1];
-                    vertexIdx[2] = indexData16[i + 2];
-                }
-                else
+                const uint32 visibilityFlags = objData.mVisibilityFlags[j];
+                if( visibilityFlags & VisibilityFlags::LAYER_VISIBILITY && visibilityFlags & lightMask )
                 {
-                    vertexIdx[0] = indexData32[i + 0];
-                    vertexIdx[1] = indexData32[i + 1];
-                    vertexIdx[2] = indexData32[i + 2];
+                    const Light *light = static_cast<const Light *>( objData.mOwner[j] );
+                    if( light->getType() != Light::LT_VPL && light->getType() != Light::LT_DIRECTIONAL )
+                        return true;
                 }
             }
-            else
+        }
+
+        return false;
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::destroyMeshInstances()
+    {
+        FastArray<RaycastRange>::const_iterator itor = mRaycastRanges.begin();
+        FastArray<RaycastRange>::const_iterator end = mRaycastRanges.end();
+
+        while( itor != end )
+        {
+            OGRE_DELETE itor->spatialIndex;
+            ++itor;
+        }
+
+        mRaycastRanges.clear();
+        mMeshInstances.clear();
+        mObjectInstances.clear();
+        mObjectEnabled.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::enableObjectsForLight( uint8 lightType,
+                                                  const AreaOfInterest &scalarAreaOfInterest )
+    {
+        const Aabb biggestAoI = getAoIBounds( scalarAreaOfInterest );
+
+        FastArray<RaycastRange>::const_iterator itor = mRaycastRanges.begin();
+        FastArray<RaycastRange>::const_iterator end = mRaycastRanges.end();
+
+        while( itor != end )
+        {
+            const RaycastRange &range = *itor;
+            const uint32 *objectInstances = mObjectInstances.begin() + range.firstSlot;
+            uint8 *objectEnabled = mObjectEnabled.begin() + range.firstSlot;
+
+            for( size_t i = 0; i < range.numObjects; ++i )
             {
-                vertexIdx[0] = uint32( i + 0u );
-                vertexIdx[1] = uint32( i + 1u );
-                vertexIdx[2] = uint32( i + 2u );
+                bool enabled = objectInstances[i] != objectInstances[i + 1u];
+
+                if( enabled && lightType == Light::LT_DIRECTIONAL )
+                {
+                    // Check if obj is in area of interest for directional lights
+                    Aabb aabb;
+                    range.objData.mWorldAabb[i / ARRAY_PACKED_REALS].getAsAabb(
+                        aabb, i % ARRAY_PACKED_REALS );
+                    enabled = biggestAoI.intersects( aabb );
+                }
+
+                objectEnabled[i] = enabled;
             }
 
-            triVerts[0].x = meshData.vertexData[vertexIdx[0] * 3u + 0];
-            triVerts[0].y = meshData.vertexData[vertexIdx[0] * 3u + 1];
-            triVerts[0].z = meshData.vertexData[vertexIdx[0] * 3u + 2];
-            triVerts[1].x = meshData.vertexData[vertexIdx[1] * 3u + 0];
-            triVerts[1].y = meshData.vertexData[vertexIdx[1] * 3u + 1];
-            triVerts[1].z = meshData.vertexData[vertexIdx[1] * 3u + 2];
-            triVerts[2].x = meshData.vertexData[vertexIdx[2] * 3u + 0];
-            triVerts[2].y = meshData.vertexData[vertexIdx[2] * 3u + 1];
-            triVerts[2].z = meshData.vertexData[vertexIdx[2] * 3u + 2];
-
-            triVerts[0] = worldMatrix * triVerts[0];
-            triVerts[1] = worldMatrix * triVerts[1];
-            triVerts[2] = worldMatrix * triVerts[2];
-
-            Vector3 triNormal =
-                Math::calculateBasicFaceNormalWithoutNormalize( triVerts[0], triVerts[1], triVerts[2] );
-            triNormal.normalise();
-
-            FastArray<size_t>::const_iterator itRayIdx = raysThatHitObj.begin();
-            FastArray<size_t>::const_iterator enRayIdx = raysThatHitObj.end();
-            while( itRayIdx != enRayIdx )
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::raycast( size_t rayStart, size_t numRays, Real lightRange )
+    {
+        mRaycastStart = rayStart;
+        mRaycastMaxDistance = lightRange;
+
+        const size_t numThreads = std::max<size_t>( mSceneManager->getNumWorkerThreads(), 1u );
+        mRaycastWorkRange.reset( numRays, numThreads, 1u );
+
+        if( numThreads > 1u )
+        {
+            InstantRadiosityRaycastTask task( this );
+            mSceneManager->executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            _raycastThread( 0u );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::_raycastThread( size_t threadIdx )
+    {
+        size_t start, count;
+        while( mRaycastWorkRange.acquire( threadIdx, start, count ) )
+        {
+            const size_t rayEnd = mRaycastStart + start + count;
+            for( size_t i = mRaycastStart + start; i < rayEnd; ++i )
             {
-                Ray ray = mRayHits[*itRayIdx].ray;
+                RayHit &rayHit = mRayHits[i];
 
-                const std::pair<bool, Real> inters = Math::intersects(
-                    ray, triVerts[0], triVerts[1], triVerts[2], triNormal, true, false );
+                const Vector3 &origin = rayHit.ray.getOrigin();
+                const Vector3 &dir = rayHit.ray.getDirection();
 
-                if( inters.first )
+                Real closest = std::min( rayHit.distance, mRaycastMaxDistance );
+                const MeshInstance *closestInstance = 0;
+                uint32 closestTriangle = 0;
+
+                FastArray<RaycastRange>::const_iterator itor = mRaycastRanges.begin();
+                FastArray<RaycastRange>::const_iterator end = mRaycastRanges.end();
+
+                while( itor != end )
                 {
-                    RayHit &rayHit = mRayHits[*itRayIdx];
-                    if( inters.second < rayHit.distance && inters.second <= lightRange )
-                    {
-                        rayHit.distance = inters.second;
-                        rayHit.material = material;
-                        rayHit.triVerts[0] = triVerts[0];
-                        rayHit.triVerts[1] = triVerts[1];
-                        rayHit.triVerts[2] = triVerts[2];
-                        rayHit.triNormal = triNormal;
-
-                        for( int j = 0; j < 5 && material.image[j]; ++j )
-                        {
-                            const uint8 uvSet = material.uvSet[j];
-                            const float *RESTRICT_ALIAS uvPtr = meshData.getUvStart( uvSet );
-                            rayHit.triUVs[j][0].x = uvPtr[vertexIdx[0] * 2u + 0];
-                            rayHit.triUVs[j][0].y = uvPtr[vertexIdx[0] * 2u + 1];
+                    const uint32 *objectInstances = mObjectInstances.begin() + itor->firstSlot;
+                    const uint8 *objectEnabled = mObjectEnabled.begin() + itor->firstSlot;
 
-                            rayHit.triUVs[j][1].x = uvPtr[vertexIdx[1] * 2u + 0];
-                            rayHit.triUVs[j][1].y = uvPtr[vertexIdx[1] * 2u + 1];
+                    // Objects can have one or more MeshInstances
+                    auto hitObject = [&]( uint32 objectIdx, Real &inOutClosest )
+                    {
+                        if( !objectEnabled[objectIdx] )
+                            return;
 
-                            rayHit.triUVs[j][2].x = uvPtr[vertexIdx[2] * 2u + 0];
-                            rayHit.triUVs[j][2].y = uvPtr[vertexIdx[2] * 2u + 1];
+                        for( uint32 l = objectInstances[objectIdx]; l < objectInstances[objectIdx + 1u];
+                             ++l )
+                        {
+                            // Distances along the ray in mesh space are the same
+                            // as in world space, since the direction isn't normalised
+                            const MeshInstance &instance = mMeshInstances[l];
+                            const Ray localRay(
+                                instance.invWorldMatrix.transformAffine( origin ),
+                                instance.invWorldMatrix.transformDirectionAffine( dir ) );
+
+                            TriangleBvh::Hit hit;
+                            if( instance.meshData->bvh->intersects( localRay, inOutClosest, hit,
+                                                                    instance.cullMode ) )
+                            {
+                                inOutClosest = hit.distance;
+                                closestInstance = &instance;
+                                closestTriangle = hit.triangleIdx;
+                            }
                         }
-                    }
+                    };
+                    itor->spatialIndex->raycast( rayHit.ray, closest, hitObject );
+
+                    ++itor;
                 }
 
-                ++itRayIdx;
+                if( closestInstance )
+                    fillRayHit( rayHit, closest, *closestInstance, closestTriangle );
             }
         }
     }
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::fillRayHit( RayHit &rayHit, Real distance, const MeshInstance &instance,
+                                       uint32 triangleIdx ) const
+    {
+        const MeshData &meshData = *instance.meshData;
+
+        uint32 vertexIdx[3];
+        meshData.getTriangle( triangleIdx, vertexIdx );
+
+        rayHit.distance = distance;
+        rayHit.material = instance.material;
+
+        for( size_t i = 0; i < 3u; ++i )
+        {
+            const float *RESTRICT_ALIAS vertex = meshData.vertexData + vertexIdx[i] * 3u;
+            rayHit.triVerts[i] = instance.worldMatrix * Vector3( vertex[0], vertex[1], vertex[2] );
+        }
+
+        rayHit.triNormal = Math::calculateBasicFaceNormalWithoutNormalize(
+            rayHit.triVerts[0], rayHit.triVerts[1], rayHit.triVerts[2] );
+        rayHit.triNormal.normalise();
+
+        const MaterialData &material = instance.material;
+        for( int j = 0; j < 5 && material.image[j]; ++j )
+        {
+            const uint8 uvSet = material.uvSet[j];
+            const float *RESTRICT_ALIAS uvPtr = meshData.getUvStart( uvSet );
+            rayHit.triUVs[j][0].x = uvPtr[vertexIdx[0] * 2u + 0];
+            rayHit.triUVs[j][0].y = uvPtr[vertexIdx[0] * 2u + 1];
+
+            rayHit.triUVs[j][1].x = uvPtr[vertexIdx[1] * 2u + 0];
+            rayHit.triUVs[j][1].y = uvPtr[vertexIdx[1] * 2u + 1];
+
+            rayHit.triUVs[j][2].x = uvPtr[vertexIdx[2] * 2u + 0];
+            rayHit.triUVs[j][2].y = uvPtr[vertexIdx[2] * 2u + 1];
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void InstantRadiosity::updateExistingVpls()
     {
         SceneNode *rootNode = mSceneManager->getRootSceneNode( SCENE_DYNAMIC );
@@ -1402,13 +1524,6 @@ namespace Ogre
                          "InstantRadiosity::build" );
         }
 
-        mArrayRays = RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL>( mTotalNumRays );
-
-        const uint32 lightMask = mLightMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
-
-        ObjectMemoryManager &memoryManager = mSceneManager->_getLightMemoryManager();
-        const size_t numRenderQueues = memoryManager.getNumRenderQueues();
-
         bool aoiAutogenerated = false;
         if( mAoI.empty() )
         {
@@ -1416,6 +1531,14 @@ namespace Ogre
             aoiAutogenerated = true;
         }
 
+        // Directional lights only hit objects inside the areas of interest
+        gatherMeshInstances( !hasNonDirectionalLights() );
+
+        const uint32 lightMask = mLightMask & VisibilityFlags::RESERVED_VISIBILITY_FLAGS;
+
+        ObjectMemoryManager &memoryManager = mSceneManager->_getLightMemoryManager();
+        const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+
         for( size_t i = 0; i < numRenderQueues; ++i )
         {
             ObjectData objData;
@@ -1474,8 +1597,8 @@ namespace Ogre
 
         updateExistingVpls();
 
-        // Free memory
-        mArrayRays = RawSimdUniquePtr<ArrayRay, MEMCATEGORY_GENERAL>();
+        // Free memory. The meshes (and their BVHs) are kept until freeMemory
+        destroyMeshInstances();
 
         if( aoiAutogenerated )
             mAoI.clear();
@@ -1483,6 +1606,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void InstantRadiosity::freeMemory()
     {
+        destroyMeshInstances();
+
         {
             MeshDataMapV2::iterator itor = mMeshDataMapV2.begin();
             MeshDataMapV2::iterator end = mMeshDataMapV2.end();
@@ -1492,6 +1617,8 @@ namespace Ogre
                 MeshData &meshData = itor->second;
                 OGRE_FREE_SIMD( meshData.vertexData, MEMCATEGORY_GEOMETRY );
                 meshData.vertexData = 0;
+                OGRE_DELETE meshData.bvh;
+                meshData.bvh = 0;
                 if( meshData.indexData && !itor->first->getIndexBuffer()->getShadowCopy() )
                 {
                     OGRE_FREE_SIMD( meshData.indexData, MEMCATEGORY_GEOMETRY );
@@ -1511,6 +1638,8 @@ namespace Ogre
                 MeshData &meshData = itor->second;
                 OGRE_FREE_SIMD( meshData.vertexData, MEMCATEGORY_GEOMETRY );
                 meshData.vertexData = 0;
+                OGRE_DELETE meshData.bvh;
+                meshData.bvh = 0;
                 if( meshData.indexData )
                 {
                     OGRE_FREE_SIMD( meshData.indexData, MEMCATEGORY_GEOMETRY );
@@ -1891,6 +2020,61 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
+    void InstantRadiosity::MeshData::getTriangle( size_t triangleIdx, uint32 outVertexIdx[3] ) const
+    {
+        const size_t i = triangleIdx * 3u;
+
+        if( indexData )
+        {
+            if( useIndices16bit )
+            {
+                const uint16 *RESTRICT_ALIAS indexData16 =
+                    reinterpret_cast<const uint16 * RESTRICT_ALIAS>( indexData );
+                outVertexIdx[0] = indexData16[i + 0];
+                outVertexIdx[1] = indexData16[i + 1];
+                outVertexIdx[2] = indexData16[i + 2];
+            }
+            else
+            {
+                const uint32 *RESTRICT_ALIAS indexData32 =
+                    reinterpret_cast<const uint32 * RESTRICT_ALIAS>( indexData );
+                outVertexIdx[0] = indexData32[i + 0];
+                outVertexIdx[1] = indexData32[i + 1];
+                outVertexIdx[2] = indexData32[i + 2];
+            }
+        }
+        else
+        {
+            outVertexIdx[0] = uint32( i + 0u );
+            outVertexIdx[1] = uint32( i + 1u );
+            outVertexIdx[2] = uint32( i + 2u );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void InstantRadiosity::MeshData::buildTriangleBvh()
+    {
+        bvh = OGRE_NEW TriangleBvh();
+
+        const size_t numTriangles = getNumTriangles();
+        for( size_t i = 0; i < numTriangles; ++i )
+        {
+            uint32 vertexIdx[3];
+            getTriangle( i, vertexIdx );
+
+            Vector3 triVerts[3];
+            for( size_t j = 0; j < 3u; ++j )
+            {
+                triVerts[j].x = vertexData[vertexIdx[j] * 3u + 0];
+                triVerts[j].y = vertexData[vertexIdx[j] * 3u + 1];
+                triVerts[j].z = vertexData[vertexIdx[j] * 3u + 2];
+            }
+
+            bvh->addTriangle( triVerts[0], triVerts[1], triVerts[2] );
+        }
+
+        bvh->build();
+    }
+    //-----------------------------------------------------------------------------------
     float *InstantRadiosity::MeshData::getUvStart( uint8_t uvSet ) const
     {
         return vertexData + numVertices * 3u + uvSet * 2u;
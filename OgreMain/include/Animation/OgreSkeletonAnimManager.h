@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "OgreIdString.h"
 
 #include "ogrestd/list.h"
+#include "ogrestd/unordered_map.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -47,7 +48,7 @@ namespace Ogre
      *  @{
      */
 
-    struct BySkeletonDef
+    struct _OgreExport BySkeletonDef
     {
         SkeletonDef const *skeletonDef;
         IdString           skeletonDefName;
@@ -65,6 +66,21 @@ namespace Ogre
         */
         FastArray<size_t> threadStarts;
 
+        /// Instances whose local pose was evaluated in the current update, by their pose hash.
+        /// @see SkeletonInstance::setPoseSharing
+        struct PoseCache
+        {
+            typedef unordered_map<uint32, SkeletonInstance *>::type SourceMap;
+            SourceMap sources;
+            size_t    numSharedPoses;
+
+            PoseCache() : numSharedPoses( 0 ) {}
+        };
+
+        /// One per thread. Each thread only shares poses among the skeletons it updates,
+        /// which avoids races when copying from instances living in the same memory block.
+        vector<PoseCache>::type poseCaches;
+
         BySkeletonDef( const SkeletonDef *skeletonDef, size_t threadCount );
 
         void initializeMemoryManager();
@@ -72,6 +88,18 @@ namespace Ogre
         void updateThreadStarts();
         void _updateBoneStartTransforms();
 
+        /** Animates the skeletons assigned to the given thread (see threadStarts).
+        @remarks
+            Instances with pose sharing enabled whose active animations match (within the
+            given tolerances) an instance already evaluated by this thread copy its local
+            pose instead of interpolating keyframes again.
+            The world-space transforms are still computed for every instance.
+        */
+        void _updateAnimations( size_t threadIdx, Real frameTolerance, Real weightTolerance );
+
+        /// Returns how many instances reused the local pose of another one in the last update.
+        size_t getNumSharedPoses() const;
+
         bool operator==( IdString name ) const { return skeletonDefName == name; }
     };
 
@@ -107,6 +135,18 @@ namespace Ogre
         typedef list<BySkeletonDef>::type BySkeletonDefList;
         BySkeletonDefList                 bySkeletonDefs;
 
+        /** How close, in frames, the current frame of two animations must be to be
+            considered the same when sharing poses. @see SkeletonInstance::setPoseSharing
+        @remarks
+            Frames are quantized to multiples of this value, thus instances playing slightly
+            out of sync will snap to the pose of the first one evaluated. Must be > 0.
+        */
+        Real poseSharingFrameTolerance;
+        /// Same as poseSharingFrameTolerance, for the weight of the animations. Must be > 0.
+        Real poseSharingWeightTolerance;
+
+        SkeletonAnimManager();
+
         /// Creates an instance of a skeleton based on the given definition.
         SkeletonInstance *createSkeletonInstance( const SkeletonDef *skeletonDef,
                                                   size_t             numWorkerThreads );
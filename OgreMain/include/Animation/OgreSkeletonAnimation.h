@@ -275,6 +275,18 @@ namespace Ogre
             RawSimdUniquePtr<ArrayReal, MEMCATEGORY_ANIMATION> &inOutBoneWeights );
 
         const SkeletonAnimationDef *getDefinition() const { return mDefinition; }
+
+        /// Rounds value to the nearest multiple of tolerance. Used by pose sharing.
+        /// @see SkeletonInstance::setPoseSharing
+        static int32 _quantizePoseValue( Real value, Real tolerance );
+
+        /// Combines the per-bone weights of this animation, quantized to weightTolerance,
+        /// into the given hash. @see SkeletonInstance::_getPoseHash
+        uint32 _getBoneWeightsHash( uint32 hash, Real weightTolerance ) const;
+
+        /// Returns true if every per-bone weight of both animations quantizes to the same
+        /// value. Both animations must share the same definition.
+        bool _hasSameBoneWeights( const SkeletonAnimation *other, Real weightTolerance ) const;
     };
 
     /** @} */
@@ -100,6 +100,20 @@ namespace Ogre
 
         void build( const v1::Skeleton *skeleton, const v1::Animation *animation, Real frameRate );
 
+        /** Compresses the keyframes of all tracks, see SkeletonTrack::_compress.
+            Frees the memory used by the uncompressed keyframes.
+        @remarks
+            Must be called before any SkeletonInstance using this animation gets created.
+            Calling it on an already compressed animation does nothing.
+        @param outReport [out]
+            Optional. Memory saved and max error introduced, across all tracks.
+        */
+        void compress( const KeyFrameCompressionSettings &settings,
+                       KeyFrameCompressionReport         *outReport = 0 );
+
+        /// Returns true if compress has been called
+        bool isCompressed() const { return !mTracks.empty() && mTracks.front().isCompressed(); }
+
         /// Dumps all the tracks in CSV format to the output string argument.
         /// Mostly for debugging purposes. (also easy example to show how to
         /// enumerate all the tracks and get the bones back from its block index)
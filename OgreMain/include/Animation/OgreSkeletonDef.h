@@ -156,6 +156,15 @@ namespace Ogre
         }
         void getBonesPerDepth( vector<size_t>::type &out ) const;
 
+        /** Compresses the keyframes of all the animations. See SkeletonAnimationDef::compress
+        @remarks
+            Must be called before any SkeletonInstance is created from this definition.
+        @param outReport [out]
+            Optional. Memory saved and max error introduced, across all animations.
+        */
+        void compressAnimations( const KeyFrameCompressionSettings &settings,
+                                 KeyFrameCompressionReport         *outReport = 0 );
+
         /** Returns the total number of bone blocks to reach the given level. i.e On SSE2,
             If the skeleton has 1 root node, 3 children, and 5 children of children;
             then the total number of blocks is 1 + 1 + 2 = 4
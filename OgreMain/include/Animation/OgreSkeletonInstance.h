@@ -115,6 +115,9 @@ namespace Ogre
         SceneNodeBonePairVec mCustomParentSceneNodes;
 
         uint16 mRefCount;
+        /// Number of bones set to manual via setManualBone
+        uint16 mNumManualBones;
+        bool   mPoseSharing;
 
     public:
         SkeletonInstance( const SkeletonDef *skeletonDef, BoneMemoryManager *boneMemoryManager );
@@ -149,6 +152,41 @@ namespace Ogre
         */
         bool isManualBone( Bone *bone );
 
+        /** Allows this instance to share its local pose with other instances of the same
+            SkeletonDef, which saves evaluating the same keyframes over and over in crowds.
+        @remarks
+            When enabled, if another instance (also with pose sharing enabled) has already been
+            evaluated this frame with the same active animations, in the same order, at
+            roughly the same frame and weight (see SkeletonAnimManager::poseSharingFrameTolerance),
+            its local pose is copied instead of interpolating the keyframes.
+            The world-space transforms are still computed for each instance.
+        @par
+            Instances with manual bones (see setManualBone) never share poses.
+            Per-bone weights (see SkeletonAnimation::setBoneWeight) are compared too, with the
+            same tolerance as the animation weights.
+            Disabled by default.
+        */
+        void setPoseSharing( bool bPoseSharing ) { mPoseSharing = bPoseSharing; }
+        bool getPoseSharing() const { return mPoseSharing; }
+
+        /// Returns true if this instance can share its local pose with others this frame
+        bool _canSharePose() const
+        {
+            return mPoseSharing && !mNumManualBones && !mActiveAnimations.empty();
+        }
+
+        /// Hashes the active animations, quantizing their frames, weights and per-bone
+        /// weights to the tolerances
+        uint32 _getPoseHash( Real frameTolerance, Real weightTolerance ) const;
+
+        /// Returns true if both instances would evaluate the same local pose. @see _getPoseHash
+        bool _hasSamePose( const SkeletonInstance *other, Real frameTolerance,
+                           Real weightTolerance ) const;
+
+        /// Copies the local transform of every bone from the source instance instead of
+        /// evaluating our animations. Both instances must share the same definition.
+        void _copyLocalPose( const SkeletonInstance *source );
+
         /** Sets a regular SceneNode to be parent of this Bone for manually controlling
             a bone (e.g. have a bone follow a character). You may want to also call
             setManualBone as well to prevent animation on this bone.
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "Animation/OgreSkeletonTrack.h"
 #include "OgreIdString.h"
 #include "OgreResourceManager.h"
 #include "OgreSingleton.h"
@@ -53,6 +54,12 @@ namespace Ogre
         typedef map<IdString, SkeletonDefPtr>::type SkeletonDefMap;
         SkeletonDefMap                              mSkeletonDefs;
 
+        bool                        mCompressKeyFrames;
+        KeyFrameCompressionSettings mKeyFrameCompressionSettings;
+
+        /// Compresses the animations of a newly created SkeletonDef if enabled
+        void compressNewSkeletonDef( SkeletonDef *skeletonDef );
+
     public:
         /// Constructor
         SkeletonManager();
@@ -78,6 +85,18 @@ namespace Ogre
         */
         void remove( const IdString &name );
 
+        /** When enabled, the keyframes of every SkeletonDef created by getSkeletonDef from now
+            on get compressed (see SkeletonDef::compressAnimations). The memory saved and the max
+            error introduced are logged for each skeleton. Disabled by default.
+        */
+        void setKeyFrameCompression(
+            bool enabled, const KeyFrameCompressionSettings &settings = KeyFrameCompressionSettings() );
+        bool getKeyFrameCompression() const { return mCompressKeyFrames; }
+        const KeyFrameCompressionSettings &getKeyFrameCompressionSettings() const
+        {
+            return mKeyFrameCompressionSettings;
+        }
+
         /** Override standard Singleton retrieval.
         @remarks
         Why do we do this? Well, it's because the Singleton
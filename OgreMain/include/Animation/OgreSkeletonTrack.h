@@ -31,8 +31,10 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "Math/Array/OgreArrayDispatch.h"
 #include "Math/Array/OgreArrayQuaternion.h"
 #include "Math/Array/OgreKfTransform.h"
+#include "OgreRawPtr.h"
 
 #include "ogrestd/vector.h"
 
@@ -46,9 +48,50 @@ namespace Ogre
         Real mInvNextFrameDistance;  // 1.0f / (KeyFrameRig[1].mFrame - KeyFrameRig[0].mFrame)
 
         // SoA variable. Packs posrotscale posrotscale ...
+        // Null when the track is compressed (see SkeletonTrack::_compress)
         KfTransform *RESTRICT_ALIAS mBoneTransform;
     };
 
+    /// Error tolerances used when compressing keyframes. See SkeletonAnimationDef::compress
+    struct _OgreExport KeyFrameCompressionSettings
+    {
+        /// Max distance a position may deviate from the original, in bone space units
+        Real positionTolerance;
+        /// Max angle (in radians) a rotation may deviate from the original
+        Real rotationTolerance;
+        /// Max deviation of each scale component
+        Real scaleTolerance;
+        /// When false, keyframes are only quantized; none gets removed
+        bool removeKeyFrames;
+
+        KeyFrameCompressionSettings() :
+            positionTolerance( 1e-3f ),
+            rotationTolerance( 1e-3f ),
+            scaleTolerance( 1e-3f ),
+            removeKeyFrames( true )
+        {
+        }
+    };
+
+    /// Memory saved & error introduced by keyframe compression
+    struct _OgreExport KeyFrameCompressionReport
+    {
+        size_t bytesBefore;
+        size_t bytesAfter;
+        size_t numKeyFramesBefore;
+        size_t numKeyFramesAfter;
+        /// Max errors measured at every original keyframe, across all animated bones
+        Real maxPositionError;
+        Real maxRotationError;  ///< In radians
+        Real maxScaleError;
+
+        KeyFrameCompressionReport();
+
+        void merge( const KeyFrameCompressionReport &other );
+        /// Human readable summary, e.g. for logging
+        String toString() const;
+    };
+
     typedef vector<KeyFrameRig>::type KeyFrameRigVec;
 
     typedef FastArray<BoneTransform> TransformArray;
@@ -81,6 +124,43 @@ namespace Ogre
 
         KfTransformArrayMemoryManager *mLocalMemoryManager;
 
+        enum ConstantChannels
+        {
+            ConstantPosition = 1u << 0u,
+            ConstantRotation = 1u << 1u,
+            ConstantScale = 1u << 2u
+        };
+
+        /** Compressed keyframes. Empty unless _compress was called. Layout:
+            @code
+                ArrayReal posMin[3], posExtent[3], scaleMin[3], scaleExtent[3], rot[4] (wxyz)
+                Per keyframe (mCompressedStride uint16), each entry has ARRAY_PACKED_REALS values:
+                    uint16 pos[3]               Unless ConstantPosition. pos = posMin + q * posExtent
+                    uint16 rot[3]               Unless ConstantRotation. Smallest-three encoding
+                    uint16 rotLargestIdx        Unless ConstantRotation. One value (2 bits per slot)
+                    uint16 scale[3]             Unless ConstantScale
+            @endcode
+            Constant channels are stored in posMin / scaleMin / rot.
+        */
+        RawSimdUniquePtr<uint8, MEMCATEGORY_ANIMATION> mCompressedData;
+        uint16 mCompressedStride;
+        uint8  mConstantChannels;
+
+        /// Decodes all slots of a compressed keyframe
+        inline void decompressKeyFrame( size_t keyFrameIdx, ArrayVector3 &outPos,
+                                        ArrayQuaternion &outRot, ArrayVector3 &outScale ) const;
+
+        /// Kernel of applyKeyFrameRigAt, instantiated once per ISA. See ArrayDispatch
+        inline void applyKeyFrameRigAtImpl( KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrame,
+                                            float frame, ArrayReal animWeight,
+                                            const ArrayReal *RESTRICT_ALIAS perBoneWeights,
+                                            const TransformArray &KfTransforms ) const;
+#if OGRE_ARRAY_DISPATCH_AVX2
+        OGRE_ARRAY_TARGET_AVX2 void applyKeyFrameRigAtAvx2(
+            KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrame, float frame, ArrayReal animWeight,
+            const ArrayReal *RESTRICT_ALIAS perBoneWeights, const TransformArray &KfTransforms ) const;
+#endif
+
     public:
         SkeletonTrack( uint32 boneBlockIdx, KfTransformArrayMemoryManager *kfTransformMemoryManager );
         ~SkeletonTrack();
@@ -127,6 +207,32 @@ namespace Ogre
             mUsedSlots <= (ARRAY_PACKED_REALS >> 1). Otherwise it does nothing.
         */
         void _bakeUnusedSlots();
+
+        /// Returns the transform of a slot at the given keyframe, compressed or not
+        void getKeyFrameTransform( size_t keyFrameIdx, uint32 slot, Vector3 &outPos,
+                                   Quaternion &outRot, Vector3 &outScale ) const;
+
+        bool isCompressed() const { return mCompressedData.get() != 0; }
+
+        /// Size in bytes of the compressed keyframe data. 0 if not compressed
+        size_t getCompressedSize() const { return mCompressedData.size(); }
+
+        /** Replaces the KfTransforms of all keyframes with a compressed representation:
+                - Keyframes that can be linearly interpolated from their neighbours are removed.
+                - Channels (position, rotation, scale) that never change are stored once.
+                - Positions & scales are quantized to 16 bits within their range.
+                - Rotations are stored with the smallest-three encoding (3 x 16 bits).
+            Decoding is done with SIMD in applyKeyFrameRigAt.
+        @remarks
+            Afterwards mBoneTransform is null in all keyframes; the KfTransforms are no longer
+            referenced and can be freed. Keyframes must not be modified after this call, and no
+            SkeletonAnimation must be referencing this track (their cached iterators would be
+            invalidated).
+        @param outReport [in/out]
+            Statistics of this track are added to it
+        */
+        void _compress( const KeyFrameCompressionSettings &settings,
+                        KeyFrameCompressionReport &outReport );
     };
 
     typedef vector<SkeletonTrack>::type SkeletonTrackVec;
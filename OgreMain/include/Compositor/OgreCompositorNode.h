@@ -147,6 +147,13 @@ namespace Ogre
         */
         virtual void postInitializePass( CompositorPass *pass ) {}
 
+        /** Returns true if _update would execute the given pass.
+        @param shadowNode
+            The current shadow node if we're in a caster pass, null otherwise.
+        */
+        static bool shouldExecutePass( const CompositorPassDef *passDef,
+                                       const CompositorShadowNode *shadowNode, uint8 executionMask );
+
     public:
         /** The Id must be unique across all engine so we can create unique named textures.
             The name is only unique across the workspace
@@ -98,6 +98,13 @@ namespace Ogre
 
         void execute( const Camera *lodCamera ) override;
 
+        /** Queues our cull camera to be culled ahead of time, together with other passes'.
+            See SceneManager::setConcurrentCullingEnabled.
+        @param lodCamera
+            Same value that will be passed to execute()
+        */
+        void _queuePreCull( const Camera *lodCamera );
+
         CompositorShadowNode *getShadowNode() const { return mShadowNode; }
         Camera               *getCamera() const { return mCamera; }
         void                  _setCustomCamera( Camera *camera ) { mCamera = camera; }
@@ -280,6 +280,15 @@ namespace Ogre
             return asUint32;
         }
 
+        /** Loads ARRAY_PACKED_REALS consecutive uint16 and returns them as unorm:
+                r[i] = (Real)src[i] / 65535.0f;
+            src does not need to be aligned.
+        */
+        static inline ArrayReal FromUnorm16( const uint16 *src )
+        {
+            return static_cast<ArrayReal>( src[0] ) * ( 1.0f / 65535.0f );
+        }
+
         /// Returns:
         ///     (int16)( saturate( a ) * 127.5f );
         ///
@@ -469,6 +469,16 @@ namespace Ogre
             return asInt16;
         }
 
+        /** Loads ARRAY_PACKED_REALS consecutive uint16 and returns them as unorm:
+                r[i] = (Real)src[i] / 65535.0f;
+            src does not need to be aligned.
+        */
+        static inline ArrayReal FromUnorm16( const uint16 *src )
+        {
+            const uint32x4_t asUint32 = vmovl_u16( vld1_u16( src ) );
+            return vmulq_n_f32( vcvtq_f32_u32( asUint32 ), 1.0f / 65535.0f );
+        }
+
         /// Returns:
         ///     (int16)( saturate( a ) * 127.5f );
         ///
@@ -53,6 +53,12 @@ namespace Ogre
 #            else
 #                include <x86intrin.h>  //Including separate intrinsics headers under MinGW causes compilation errors
 #            endif
+#            if defined( __FMA__ )
+// OGRE_SIMD_AVX2: same 4-wide layout, but we can use VEX-encoded FMA for madd & nmsub.
+// Don't key this on __AVX2__: it doesn't imply FMA (i.e. -mavx2 -mno-fma)
+#                include <immintrin.h>
+#                define OGRE_SIMD_USE_FMA 1
+#            endif
 #            define ARRAY_PACKED_REALS 4
 namespace Ogre
 {
@@ -88,10 +94,17 @@ namespace Ogre
     typedef __m128i ArrayToS16;
 }  // namespace Ogre
 
+#        if defined( OGRE_SIMD_USE_FMA )
 /// r = (a * b) + c
-#        define _mm_madd_ps( a, b, c ) _mm_add_ps( c, _mm_mul_ps( a, b ) )
+#            define _mm_madd_ps( a, b, c ) _mm_fmadd_ps( a, b, c )
 /// r = -(a * b) + c
-#        define _mm_nmsub_ps( a, b, c ) _mm_sub_ps( c, _mm_mul_ps( a, b ) )
+#            define _mm_nmsub_ps( a, b, c ) _mm_fnmadd_ps( a, b, c )
+#        else
+/// r = (a * b) + c
+#            define _mm_madd_ps( a, b, c ) _mm_add_ps( c, _mm_mul_ps( a, b ) )
+/// r = -(a * b) + c
+#            define _mm_nmsub_ps( a, b, c ) _mm_sub_ps( c, _mm_mul_ps( a, b ) )
+#        endif
 
 /// Does not convert, just cast ArrayReal to ArrayInt
 #        define CastRealToInt( x ) _mm_castps_si128( x )
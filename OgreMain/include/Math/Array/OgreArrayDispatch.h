@@ -0,0 +1,100 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreArrayDispatch_H_
+#define _OgreArrayDispatch_H_
+
+#include "OgreArrayConfig.h"
+
+#include "OgreHeaderPrefix.h"
+
+// OGRE_ARRAY_DISPATCH_AVX2 is 1 when hot SoA kernels can be compiled a second time
+// for AVX2 + FMA and selected at runtime. It is 0 when the whole build already
+// targets AVX2 (OGRE_SIMD_AVX2), when not using SSE2, or when the compiler doesn't
+// support per-function target attributes (MSVC).
+#if OGRE_USE_SIMD == 1 && OGRE_CPU == OGRE_CPU_X86 && OGRE_DOUBLE_PRECISION == 0 && \
+    ( OGRE_COMPILER == OGRE_COMPILER_GNUC || OGRE_COMPILER == OGRE_COMPILER_CLANG ) && \
+    !defined( __AVX2__ ) && !defined( __e2k__ )
+#    define OGRE_ARRAY_DISPATCH_AVX2 1
+#    define OGRE_ARRAY_TARGET_AVX2 __attribute__( ( target( "avx2,fma" ), flatten ) )
+#else
+#    define OGRE_ARRAY_DISPATCH_AVX2 0
+#    define OGRE_ARRAY_TARGET_AVX2
+#endif
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Math
+     *  @{
+     */
+
+    /** Runtime CPU dispatch for the SoA kernels: Node::updateAllTransforms,
+        Bone::updateAllTransforms, MovableObject::updateAllBounds, MovableObject::cullFrustum
+        and SkeletonTrack::applyKeyFrameRigAt (keyframe blending).
+    @remarks
+        The kernels are written once as a FORCEINLINE function in their .cpp and then
+        instantiated twice: once for the baseline ISA Ogre was built with (SSE2), and
+        once with OGRE_ARRAY_TARGET_AVX2. The latter lets the compiler emit VEX-encoded
+        instructions and fuse multiply-adds for the exact same SSE2 intrinsics, so a
+        single binary runs on old CPUs and gets the faster code on newer ones.
+        @par
+        Memory layout (ARRAY_PACKED_REALS) is identical for both versions, thus they
+        can be switched at any time; even in the middle of a frame.
+    */
+    class _OgreExport ArrayDispatch
+    {
+        static bool msUseAvx2;
+
+    public:
+        /// Returns true if the AVX2 + FMA versions of the kernels should be called.
+        static bool useAvx2() { return msUseAvx2; }
+
+        /** Enables or disables the AVX2 + FMA kernels. Enabled by default if the CPU
+            & OS support it.
+        @remarks
+            FMA rounds differently than separate multiply & add. Disable this if you
+            need bit-exact results across machines (e.g. lockstep simulations).
+        @param bEnable
+            Ignored (i.e. treated as false) if the CPU doesn't support AVX2 & FMA or
+            if the build doesn't contain the AVX2 versions.
+        */
+        static void setAvx2Enabled( bool bEnable );
+
+        /// Returns true if the AVX2 versions were compiled in and the CPU can run them
+        static bool isAvx2Supported();
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -37,6 +37,7 @@ namespace Ogre
 {
     enum SceneMemoryMgrTypes;
     class NullEntity;
+    class ObjectSpatialIndex;
 
     /** \addtogroup Core
      *  @{
@@ -61,6 +62,8 @@ namespace Ogre
 
         /// Tracks total number of objects in all render queues.
         size_t mTotalObjects;
+        /// Incremented every time objects are added, removed or moved between render queues
+        uint32 mLayoutRevision;
 
         /// Dummy node where to point ObjectData::mParents[i] when they're unused slots.
         SceneNode  *mDummyNode;
@@ -74,6 +77,14 @@ namespace Ogre
         SceneMemoryMgrTypes  mMemoryManagerType;
         ObjectMemoryManager *mTwinMemoryManager;
 
+        /// One per render queue when enabled. See setSpatialIndexEnabled
+        FastArray<ObjectSpatialIndex *> mSpatialIndices;
+        bool                            mSpatialIndexEnabled;
+
+        /// Bumps mLayoutRevision and flags the spatial index of the given render queue
+        /// for a rebuild
+        void notifyLayoutChanged( size_t renderQueue );
+
         /** Makes mMemoryManagers big enough to be able to fulfill mMemoryManagers[newDepth]
         @param newDepth
             Hierarchy level depth we wish to grow to.
@@ -165,10 +176,34 @@ namespace Ogre
         */
         size_t getTotalNumObjects() const { return mTotalObjects; }
 
+        /// Changes whenever objects are added, removed or moved to another render queue.
+        /// Used to tell whether results culled earlier may contain destroyed objects.
+        uint32 getLayoutRevision() const { return mLayoutRevision; }
+
         /// This is the opposite of getTotalNumObjects. This function returns the sum
         /// of the return values of getFirstObjectData
         size_t calculateTotalNumObjectDataIncludingFragmentedSlots() const;
 
+        /** Enables a bounding volume hierarchy per render queue, so that SceneManager's
+            culling and the default scene queries can skip whole groups of objects.
+        @remarks
+            The hierarchy is rebuilt when objects are added/removed and refit every time
+            SceneManager::updateAllBounds processes this manager. Worth it for managers with
+            many objects that rarely move (i.e. SCENE_STATIC), of which only a few are visible.
+            Disabled by default. See ObjectSpatialIndex.
+        */
+        void setSpatialIndexEnabled( bool bEnabled );
+        bool getSpatialIndexEnabled() const { return mSpatialIndexEnabled; }
+
+        /** Returns the spatial index of the given render queue.
+            Null if disabled or out of date (objects were added or removed after the last
+            call to _updateSpatialIndices); in which case all objects must be iterated.
+        */
+        const ObjectSpatialIndex *getSpatialIndex( size_t renderQueue ) const;
+
+        /// Rebuilds or refits the spatial indices (if enabled) with the current world Aabbs.
+        void _updateSpatialIndices();
+
         /// Returns the pointer to the dummy node (useful when detaching)
         SceneNode *_getDummyNode() const { return mDummyNode; }
 
@@ -0,0 +1,179 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreObjectSpatialIndex_H_
+#define _OgreObjectSpatialIndex_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Array/OgreObjectData.h"
+#include "OgreFastArray.h"
+#include "OgreRay.h"
+#include "OgreVector3.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Memory
+     *  @{
+     */
+
+    /** Bounding volume hierarchy over the objects of one render queue of an ObjectMemoryManager.
+    @remarks
+        Leaves are individual objects, but queries return the SIMD packs (ARRAY_PACKED_REALS
+        objects) they live in. This way culling & queries can reject whole subtrees and still
+        test the surviving packs with the regular ArrayAabb code paths.
+    @par
+        Objects are never reordered in memory: the tree is built top-down over their bounds
+        (median split on the longest axis) whenever objects are created, destroyed
+        or moved between render queues; and refit from ObjectData::mWorldAabb every time
+        SceneManager::updateAllBounds runs on its memory manager. Thus it's mostly useful
+        for SCENE_STATIC objects. See ObjectMemoryManager::setSpatialIndexEnabled.
+    */
+    class _OgreExport ObjectSpatialIndex : public OgreAllocatedObj
+    {
+    public:
+        /// Nodes are stored in depth-first order: the first child of an inner node is the
+        /// next node, the second child is the node after the end of the first one's subtree.
+        struct Node
+        {
+            Vector3 vMin;
+            Vector3 vMax;
+            /// Largest ObjectData::mWorldRadius of all the objects below
+            Real maxRadius;
+            /// Index of the next node that is not a descendant of this one
+            uint32 skipIdx;
+            /// Index of the object (its slot) for leaves. c_innerNode for inner nodes
+            uint32 objectIdx;
+        };
+
+        static const uint32 c_innerNode;
+
+    protected:
+        FastArray<Node> mNodes;
+        /// Return value of ObjectMemoryManager::getFirstObjectData when the tree was built
+        size_t mNumObjects;
+        bool   mNeedsRebuild;
+
+        /// Computes the bounds of the given object. Returns false if the slot is unused.
+        static bool calculateObjectBounds( const ObjectData &objData, size_t objectIdx,
+                                           const MovableObject *dummyObject, Node &outNode );
+
+        uint32 buildNode( FastArray<Node> &leaves, size_t first, size_t last );
+
+        /// Appends the pack of the given leaf. Duplicates are removed by sortPacks
+        static void addPack( const Node &leaf, FastArray<uint32> &outPacks )
+        {
+            outPacks.push_back( leaf.objectIdx / ARRAY_PACKED_REALS );
+        }
+
+        /// Sorts & removes duplicates of the packs appended since firstPack
+        static void sortPacks( FastArray<uint32> &outPacks, size_t firstPack );
+
+    public:
+        ObjectSpatialIndex();
+
+        /// Rebuilds the tree from scratch. Objects whose owner is dummyObject are ignored.
+        void build( const ObjectData &objData, size_t numObjects, const MovableObject *dummyObject );
+
+        /// Updates the bounds of all nodes, keeping the tree structure.
+        void refit( const ObjectData &objData, const MovableObject *dummyObject );
+
+        /// Must be called when objects are added to, removed from or moved inside this render queue.
+        void _notifyLayoutChanged() { mNeedsRebuild = true; }
+        bool needsRebuild() const { return mNeedsRebuild; }
+
+        /// Number of objects (including unused slots) the tree was built for.
+        /// See ObjectMemoryManager::getFirstObjectData
+        size_t getNumObjects() const { return mNumObjects; }
+
+        const FastArray<Node> &getNodes() const { return mNodes; }
+
+        /** Appends to outPacks the index of every pack with objects that may be inside the frustum.
+            The appended indices are sorted and unique. Same for all the other queries.
+        @param planes
+            The 6 planes of the frustum, facing inwards. See Frustum::getFrustumPlanes
+        */
+        void cullFrustum( const Plane *planes, FastArray<uint32> &outPacks ) const;
+
+        /// Appends to outPacks the index of every pack with objects that may intersect the box
+        void queryAabb( const Aabb &aabb, FastArray<uint32> &outPacks ) const;
+
+        /// Appends to outPacks the index of every pack with objects whose bounding sphere
+        /// may intersect the given sphere
+        void querySphere( const Sphere &sphere, FastArray<uint32> &outPacks ) const;
+
+        /// Appends to outPacks the index of every pack with objects that may be hit by the ray
+        void queryRay( const Ray &ray, FastArray<uint32> &outPacks ) const;
+
+        /** Calls visitor( objectIdx, inOutDistance ) for every object whose bounds the ray
+            hits closer than inOutDistance, roughly from front to back.
+        @remarks
+            For closest hit queries: the visitor may shorten inOutDistance when it finds a hit,
+            which prunes the rest of the traversal.
+        */
+        template <typename T>
+        void raycast( const Ray &ray, Real &inOutDistance, T &visitor ) const
+        {
+            const Vector3 invDir = ray.getInvDirection();
+
+            const size_t numNodes = mNodes.size();
+            size_t i = 0;
+            while( i < numNodes )
+            {
+                const Node &node = mNodes[i];
+                if( !ray.intersectsSlab( invDir, node.vMin, node.vMax, inOutDistance ) )
+                {
+                    i = node.skipIdx;
+                }
+                else
+                {
+                    if( node.objectIdx != c_innerNode )
+                        visitor( node.objectIdx, inOutDistance );
+                    ++i;
+                }
+            }
+        }
+
+        /// Returns how many objects live in the given pack (the last one may be partially used).
+        size_t getNumObjectsInPack( uint32 packIdx ) const
+        {
+            return std::min<size_t>( ARRAY_PACKED_REALS, mNumObjects - packIdx * ARRAY_PACKED_REALS );
+        }
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
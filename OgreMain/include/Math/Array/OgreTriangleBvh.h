@@ -0,0 +1,180 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreTriangleBvh_H_
+#define _OgreTriangleBvh_H_
+
+#include "OgrePrerequisites.h"
+
+#include "Math/Array/OgreArrayVector3.h"
+#include "OgreCommon.h"
+#include "OgreFastArray.h"
+#include "OgreRawPtr.h"
+#include "OgreVector3.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Math
+     *  @{
+     */
+
+    /** Bounding volume hierarchy over triangles, for exact ray casts on the CPU.
+    @remarks
+        Triangles are grouped in leaves of ARRAY_PACKED_REALS and stored in SoA, so that a ray
+        is tested against a whole leaf at once. Nodes are stored depth first: a node's first
+        child comes right after it, and skipIdx points past its subtree. This allows stackless
+        traversal.
+    @par
+        Usage:
+        @code
+            TriangleBvh bvh;
+            bvh.addTriangle( a, b, c ); // Triangle 0
+            bvh.addTriangle( d, e, f ); // Triangle 1
+            bvh.build();
+
+            TriangleBvh::Hit hit;
+            if( bvh.intersects( ray, maxDistance, hit ) )
+                doSomething( hit.triangleIdx, hit.distance );
+        @endcode
+        Queries are const and can be performed from multiple threads at the same time.
+    */
+    class _OgreExport TriangleBvh : public OgreAllocatedObj
+    {
+    public:
+        struct Node
+        {
+            Vector3 vMin;
+            /// Index of the next node after this node's subtree
+            uint32 skipIdx;
+            Vector3 vMax;
+            /// Index of the TrianglePack for leaves. c_innerNode for inner nodes
+            uint32 packIdx;
+        };
+
+        /// ARRAY_PACKED_REALS triangles. Unused lanes are degenerate and never hit.
+        struct TrianglePack
+        {
+            ArrayVector3 v0;
+            /// v1 - v0
+            ArrayVector3 edge1;
+            /// v2 - v0
+            ArrayVector3 edge2;
+        };
+
+        struct Hit
+        {
+            /// Along the ray. In units of the ray's direction length
+            Real distance;
+            /// Order in which the triangle was added with addTriangle
+            uint32 triangleIdx;
+            /// Barycentric coordinates of the hit (weights of v1 & v2)
+            Real u;
+            Real v;
+        };
+
+        /// Per triangle data used while building
+        struct BuildEntry;
+
+        static const uint32 c_innerNode;
+
+    protected:
+        /// Vertices of the triangles added since the last build
+        FastArray<Vector3> mPendingVertices;
+
+        FastArray<Node> mNodes;
+        RawSimdUniquePtr<TrianglePack, MEMCATEGORY_GEOMETRY> mPacks;
+        /// Triangle index of each lane of mPacks. c_innerNode for unused lanes
+        FastArray<uint32> mTriangleIds;
+        size_t            mNumTriangles;
+
+        uint32 buildNode( FastArray<BuildEntry> &entries, size_t first, size_t last );
+
+        /// Tests the ray against the triangles of one pack. Updates outHit if one is closer
+        /// than its distance. Returns true if so.
+        inline bool intersectsPack( const ArrayVector3 &origin, const ArrayVector3 &dir,
+                                    uint32 packIdx, CullingMode cullMode, Hit &inOutHit ) const;
+
+        /// Traverses the tree with the given ray. When bAnyHit is true, stops at the first hit.
+        template <bool bAnyHit>
+        bool traverse( const Ray &ray, CullingMode cullMode, Hit &inOutHit ) const;
+
+    public:
+        TriangleBvh();
+
+        /// Queues a triangle for the next build. Its triangleIdx is the number of triangles
+        /// added before it (since the last build).
+        void addTriangle( const Vector3 &v0, const Vector3 &v1, const Vector3 &v2 );
+
+        /// Builds the tree out of the triangles added with addTriangle, replacing the old one.
+        void build();
+
+        /// Discards the tree and any pending triangle.
+        void clear();
+
+        size_t getNumTriangles() const { return mNumTriangles; }
+        bool   isEmpty() const { return mNodes.empty(); }
+
+        const FastArray<Node> &getNodes() const { return mNodes; }
+
+        /// Returns the approximate memory used by the tree, in bytes
+        size_t getMemoryUsage() const;
+
+        /** Finds the closest triangle hit by the ray.
+        @param ray
+            The ray. Its direction doesn't need to be normalised; distances are then
+            expressed in multiples of its length.
+        @param maxDistance
+            Hits farther than this are ignored.
+        @param outHit [out]
+            The closest hit. Left untouched if returns false.
+        @param cullMode
+            Which faces can't be hit, as seen from the ray's origin. By default both faces
+            are hit. CULL_CLOCKWISE only hits triangles whose vertices are anticlockwise,
+            i.e. facing the ray (like Math::intersects with positiveSide = true).
+        @return
+            True if a triangle was hit.
+        */
+        bool intersects( const Ray &ray, Real maxDistance, Hit &outHit,
+                         CullingMode cullMode = CULL_NONE ) const;
+
+        /// Returns true as soon as any triangle closer than maxDistance is hit.
+        /// Cheaper than intersects, useful for visibility & shadow rays.
+        bool intersectsAny( const Ray &ray, Real maxDistance, CullingMode cullMode = CULL_NONE ) const;
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
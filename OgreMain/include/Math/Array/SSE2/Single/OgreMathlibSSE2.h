@@ -325,6 +325,17 @@ namespace Ogre
             return _mm_packs_epi32( asUint32, asUint32 );
         }
 
+        /** Loads ARRAY_PACKED_REALS consecutive uint16 and returns them as unorm:
+                r[i] = (Real)src[i] / 65535.0f;
+            src does not need to be aligned.
+        */
+        static inline ArrayReal FromUnorm16( const uint16 *src )
+        {
+            const __m128i asUint16 = _mm_loadl_epi64( reinterpret_cast<const __m128i *>( src ) );
+            const __m128i asUint32 = _mm_unpacklo_epi16( asUint16, _mm_setzero_si128() );
+            return _mm_mul_ps( _mm_cvtepi32_ps( asUint32 ), _mm_set_ps1( 1.0f / 65535.0f ) );
+        }
+
         /// Returns:
         ///     (int16)( saturate( a ) * 127.5f );
         ///
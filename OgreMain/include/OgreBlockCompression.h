@@ -0,0 +1,125 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreBlockCompression_H_
+#define _OgreBlockCompression_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgrePixelFormatGpu.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Image
+     *  @{
+     */
+    /** CPU encoder & decoder for block compressed formats.
+
+        Blocks are exchanged as 4x4 RGBA8 pixels (64 bytes, row major). Signed formats
+        (BC4_SNORM, BC5_SNORM, EAC_*_SNORM) exchange RGBA8_SNORM pixels instead.
+        See getUncompressedFormat.
+
+        Decoding supports BC1-BC5, BC7, ETC1, ETC2 (RGB8, RGBA8, RGB8A1) & EAC (R11, R11G11).
+        EAC is decoded to 8 bits per channel.
+
+        Encoding supports BC1-BC5, BC7, ETC1, ETC2 RGB8 & RGBA8, and EAC (R11, R11G11).
+        The encoders are meant to be used at load time and favour speed over quality:
+            - BC7 only uses mode 6.
+            - ETC2 only uses the ETC1 modes (individual & differential) for colour.
+            - BC1 uses its 3-colour mode only for blocks with alpha < 128.
+    */
+    class _OgreExport BlockCompression
+    {
+    public:
+        /// Returns true if encodeBlock & compress support the given format
+        static bool canEncode( PixelFormatGpu format );
+        /// Returns true if decodeBlock & decompress support the given format
+        static bool canDecode( PixelFormatGpu format );
+
+        /// Returns the format of the pixels exchanged by encodeBlock & decodeBlock for the
+        /// given compressed format. One of PFG_RGBA8_UNORM, PFG_RGBA8_UNORM_SRGB or
+        /// PFG_RGBA8_SNORM.
+        static PixelFormatGpu getUncompressedFormat( PixelFormatGpu format );
+
+        /** Compresses a single 4x4 block.
+        @param srcRgba
+            16 pixels in getUncompressedFormat( dstFormat ), row major.
+            Channels not present in dstFormat are ignored.
+        @param dstFormat
+            Must satisfy canEncode( dstFormat )
+        @param dstBlock [out]
+            Compressed block. PixelFormatGpuUtils::getCompressedBlockSize bytes.
+        */
+        static void encodeBlock( const uint8 *srcRgba, PixelFormatGpu dstFormat, void *dstBlock );
+
+        /** Decompresses a single 4x4 block.
+        @param srcBlock
+            Compressed block.
+        @param srcFormat
+            Must satisfy canDecode( srcFormat )
+        @param dstRgba [out]
+            16 pixels in getUncompressedFormat( srcFormat ), row major.
+            Channels not present in srcFormat are set to 0 (alpha to 1).
+        */
+        static void decodeBlock( const void *srcBlock, PixelFormatGpu srcFormat, uint8 *dstRgba );
+
+        /** Compresses a whole box. Use PixelFormatGpuUtils::bulkPixelConversion instead,
+            which calls this function when needed.
+        @param src
+            Uncompressed source. Can be in any format bulkPixelConversion can convert
+            to getUncompressedFormat( dstFormat ).
+        @param dst [out]
+            Compressed destination. Must be the same size as src. The blocks on the right
+            and bottom edges are padded by repeating the last column & row.
+        */
+        static void compress( const TextureBox &src, PixelFormatGpu srcFormat, TextureBox &dst,
+                              PixelFormatGpu dstFormat );
+
+        /** Decompresses a whole box. Use PixelFormatGpuUtils::bulkPixelConversion instead,
+            which calls this function when needed.
+        @param src
+            Compressed source.
+        @param dst [out]
+            Uncompressed destination. Can be in any format bulkPixelConversion can convert
+            to from getUncompressedFormat( srcFormat ).
+        */
+        static void decompress( const TextureBox &src, PixelFormatGpu srcFormat, TextureBox &dst,
+                                PixelFormatGpu dstFormat );
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
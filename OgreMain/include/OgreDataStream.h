@@ -310,6 +310,16 @@ namespace Ogre
 
         /** Close the stream; this makes further operations invalid. */
         virtual void close() = 0;
+
+        /** Returns a pointer to the entire contents of the stream if they are already
+            resident in memory (e.g. MemoryDataStream, MappedFileDataStream), null otherwise.
+        @remarks
+            Consumers that need the whole stream in memory can test for this and skip
+            buffering it into a MemoryDataStream. The data at the current read position
+            is at getDataPtr() + tell().
+            The pointer stays valid until the stream is closed and must not be written to.
+        */
+        virtual const uint8 *getDataPtr() const { return 0; }
     };
 
     /// List of DataStream items
@@ -477,10 +487,71 @@ namespace Ogre
          */
         void close() override;
 
+        /** @copydoc DataStream::getDataPtr
+         */
+        const uint8 *getDataPtr() const override { return mData; }
+
         /** Sets whether or not to free the encapsulated memory on close. */
         void setFreeOnClose( bool free ) { mFreeOnClose = free; }
     };
 
+    /** Read-only DataStream over a memory-mapped file.
+    @remarks
+        The contents are served straight from the OS page cache: read() is a memcpy
+        out of the mapping and getDataPtr() returns the whole file, so consumers can
+        parse or upload from it without an intermediate heap copy.
+        FileSystemArchive returns these when FileSystemArchive::setMemoryMapFiles is on.
+    @par
+        The file must not be truncated by someone else while it is mapped.
+    */
+    class _OgreExport MappedFileDataStream final : public DataStream
+    {
+    protected:
+        /// Start of the mapping. Null if the file is empty
+        const uint8 *mData;
+        /// Current read offset
+        size_t mPos;
+
+    public:
+        /** Maps the given file.
+        @param name The name to give this stream
+        @param fullPath Path of the file to map
+        @exception ERR_FILE_NOT_FOUND if the file cannot be opened
+        @exception ERR_INTERNAL_ERROR if the file cannot be mapped
+        @exception ERR_NOT_IMPLEMENTED if the platform has no memory-mapped files
+        */
+        MappedFileDataStream( const String &name, const String &fullPath );
+        ~MappedFileDataStream() override;
+
+        /** @copydoc DataStream::read
+         */
+        size_t read( void *buf, size_t count ) override;
+
+        /** @copydoc DataStream::skip
+         */
+        void skip( long count ) override;
+
+        /** @copydoc DataStream::seek
+         */
+        void seek( size_t pos ) override;
+
+        /** @copydoc DataStream::tell
+         */
+        size_t tell() const override;
+
+        /** @copydoc DataStream::eof
+         */
+        bool eof() const override;
+
+        /** @copydoc DataStream::close
+         */
+        void close() override;
+
+        /** @copydoc DataStream::getDataPtr
+         */
+        const uint8 *getDataPtr() const override { return mData; }
+    };
+
     /** Common subclass of DataStream for handling data from
         std::basic_istream.
     */
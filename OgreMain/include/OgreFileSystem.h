@@ -133,7 +133,25 @@ namespace Ogre
         /// Get whether hidden files are ignored during filesystem enumeration.
         static bool getIgnoreHidden() { return msIgnoreHidden; }
 
-        static bool msIgnoreHidden;
+        /// Set whether files opened read-only are memory-mapped (see MappedFileDataStream)
+        /// instead of being read through std::ifstream. Consumers that support
+        /// DataStream::getDataPtr then read straight from the page cache instead of
+        /// buffering the whole file on the heap. The default is false.
+        static void setMemoryMapFiles( bool mapFiles ) { msMemoryMapFiles = mapFiles; }
+
+        /// Get whether files opened read-only are memory-mapped.
+        static bool getMemoryMapFiles() { return msMemoryMapFiles; }
+
+        /// Set the minimum size in bytes a file must have to be memory-mapped when
+        /// setMemoryMapFiles is on. Smaller files are cheaper to read. The default is 64kb.
+        static void setMemoryMapMinSize( size_t bytes ) { msMemoryMapMinSize = bytes; }
+
+        /// Get the minimum size in bytes a file must have to be memory-mapped.
+        static size_t getMemoryMapMinSize() { return msMemoryMapMinSize; }
+
+        static bool   msIgnoreHidden;
+        static bool   msMemoryMapFiles;
+        static size_t msMemoryMapMinSize;
     };
 
     /** Specialisation of ArchiveFactory for FileSystem files. */
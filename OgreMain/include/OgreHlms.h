@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 #include "OgreHlmsCommon.h"
+#include "OgreHlmsPropertyMap.h"
 #include "OgreHlmsPso.h"
 #include "OgreStringVector.h"
 #include "Threading/OgreLightweightMutex.h"
@@ -43,6 +44,7 @@ THE SOFTWARE.
 namespace Ogre
 {
     class CompositorShadowNode;
+    class HlmsCompiledTemplate;
     struct QueuedRenderable;
     typedef vector<Archive *>::type ArchiveVec;
 
@@ -87,6 +89,7 @@ namespace Ogre
     {
     public:
         friend class HlmsDiskCache;
+        friend class HlmsCompiledTemplate;
 
         enum PrecisionMode
         {
@@ -224,11 +227,48 @@ namespace Ogre
         typedef vector<RenderableCache>::type RenderableCacheVec;
         typedef vector<ShaderCodeCache>::type ShaderCodeCacheVec;
 
+        /// Output of the Hlms parser for a permutation that hasn't been compiled yet.
+        /// See _pregenerateStubEntry
+        struct PregeneratedShaderCode
+        {
+            RenderableCache mergedCache;
+            String          source[NumShaderTypes];
+            /// The properties as left by the templates after generating each stage,
+            /// and after generating all of them.
+            HlmsPropertyVec stageProperties[NumShaderTypes];
+            HlmsPropertyVec properties;
+            /// False while a thread is still generating it (or once it's been compiled).
+            bool ready;
+
+            PregeneratedShaderCode( const RenderableCache &_mergedCache ) :
+                mergedCache( _mergedCache ),
+                ready( false )
+            {
+            }
+        };
+
+        typedef vector<PregeneratedShaderCode>::type PregeneratedShaderCodeVec;
+
+        /// Output of mergePropertiesForShaderCode saved by _pregenerateStubEntry, so that
+        /// compileStubEntry doesn't have to merge (and call the listener) again.
+        struct PregeneratedMerge
+        {
+            HlmsPropertyVec    setProperties;
+            TextureNameStrings textureNameStrings;
+            TextureRegsVec     textureRegs[NumShaderTypes];
+        };
+
+        typedef map<const HlmsCache *, PregeneratedMerge>::type PregeneratedMergeMap;
+
         PassCacheVec       mPassCache;
         RenderableCacheVec mRenderableCache;
         ShaderCodeCacheVec mShaderCodeCache;  // GUARDED_BY( mMutex )
         HlmsCacheVec       mShaderCache;      // GUARDED_BY( mMutex )
 
+        PregeneratedShaderCodeVec mPregeneratedShaderCode;  // GUARDED_BY( mMutex )
+        /// Keyed by the reserved stub entry the merge was done for.
+        PregeneratedMergeMap mPregeneratedMerges;  // GUARDED_BY( mMutex )
+
         typedef std::vector<HlmsPropertyVec> HlmsPropertyVecVec;
         typedef std::vector<PiecesMap>       PiecesMapVec;
 
@@ -240,6 +280,9 @@ namespace Ogre
             HlmsPropertyVec setProperties;
             PiecesMap       pieces;
 
+            /// Scratch copy of setProperties for HlmsCompiledTemplate::evaluate.
+            HlmsPropertyMap propertyMap;
+
             // Prevent false cache sharing
             uint8_t padding[64];
         };
@@ -249,6 +292,14 @@ namespace Ogre
         ThreadDataVec    mT;
         LightweightMutex mMutex;
 
+        typedef std::pair<Archive *, String>                           CompiledTemplateKey;
+        typedef map<CompiledTemplateKey, HlmsCompiledTemplate *>::type CompiledTemplateMap;
+
+        /// Template & piece files parsed once, reused by every permutation.
+        /// See HlmsCompiledTemplate.
+        CompiledTemplateMap mCompiledTemplates;  // GUARDED_BY( mCompiledTemplatesMutex )
+        LightweightMutex    mCompiledTemplatesMutex;
+
         static LightweightMutex msGlobalMutex;
 
         static bool msHasParticleFX2Plugin;
@@ -458,6 +509,26 @@ namespace Ogre
         void hashPieceFiles( Archive *archive, const StringVector &pieceFiles,
                              FastArray<uint8> &fileContents ) const;
 
+        /// Returns the parsed version of the file, loading it from the archive the first time.
+        /// Thread safe.
+        const HlmsCompiledTemplate *getCompiledTemplate( Archive *archive, const String &filename );
+        void                        clearCompiledTemplates();
+
+        /** Runs parseMath, parseForEach & parseProperties on the given template file.
+            Uses HlmsCompiledTemplate when possible.
+        @param inString [out]
+            The output.
+        @param outString [out]
+            Scratch buffer.
+        @param stopOnSyntaxError
+            When the file can't be precompiled: whether to keep expanding \@foreach blocks
+            after a syntax error. Templates stop; piece files have always kept going.
+        @return
+            True if there were syntax errors.
+        */
+        bool parseTemplate( Archive *archive, const String &filename, String &inString,
+                            String &outString, size_t tid, bool stopOnSyntaxError );
+
         void dumpProperties( std::ofstream &outFile, size_t tid );
 
         /** Modifies the PSO's macroblock if there are reasons to do that, and creates
@@ -473,10 +544,48 @@ namespace Ogre
                                                   const String &debugFilenameOutput, uint32 finalHash,
                                                   ShaderType shaderType, size_t tid );
 
+        /** Runs the Hlms parser over the template of a single stage, using the properties
+            in mT[tid]. Doesn't compile the result.
+        @param outString [out]
+            The preprocessed shader.
+        @param outDebugFilename [out]
+            Where the preprocessed shader was dumped. Only when bDebugOutput is true.
+        @return
+            False if the stage has no template, or the template disabled it
+            (see HlmsBaseProp::DisableStage).
+        */
+        bool generateShaderStage( const RenderableCache &mergedCache, ShaderType shaderType,
+                                  uint32 uniqueName, bool bDebugOutput, size_t tid, String &outString,
+                                  String &outDebugFilename );
+
+        /// Compiles the output of _pregenerateStubEntry for codeCache, if there is any.
+        /// Returns false if codeCache has not been pregenerated.
+        bool compilePregeneratedShaderCode( ShaderCodeCache &codeCache, uint32 uniqueName,
+                                            size_t tid );
+
+        /// Merges the renderable's properties with the pass' into mT[tid].setProperties,
+        /// and lets the Hlms & the listener modify them. First step of createShaderCacheEntry
+        const RenderableCache &mergePropertiesForShaderCode( uint32           renderableHash,
+                                                             const HlmsCache &passCache,
+                                                             const QueuedRenderable &queuedRenderable,
+                                                             size_t                  tid );
+
+        /// Restores into mT[tid] what _pregenerateStubEntry merged for reservedStubEntry.
+        /// Returns null if nothing was merged for it, in which case mT[tid] is left untouched.
+        const RenderableCache *restorePregeneratedMerge( uint32           renderableHash,
+                                                         const HlmsCache *reservedStubEntry,
+                                                         size_t           tid );
+
     public:
+        /** Compiles already preprocessed shaders and adds them to the shader code cache
+        @param outShaders [out]
+            Optional. When not null, must hold NumShaderTypes entries and receives the
+            compiled shaders.
+        */
         void _compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
                                                    const String           source[NumShaderTypes],
-                                                   const uint32 shaderCounter, size_t tid );
+                                                   const uint32 shaderCounter, size_t tid,
+                                                   GpuProgramPtr *outShaders = 0 );
 
         /** Compiles input properties and adds it to the shader code cache
         @param codeCache [in/out]
@@ -484,6 +593,35 @@ namespace Ogre
         */
         void compileShaderCode( ShaderCodeCache &codeCache, uint32 shaderCounter, size_t tid );
 
+        /** Runs the Hlms parser over the templates, without compiling the result.
+            Can be called concurrently as long as each thread uses a different tid
+            (see _setNumThreads).
+        @param outSource [out]
+            Preprocessed shader of each stage. Empty if the stage isn't used.
+        */
+        void _generateShaderCode( const RenderableCache &mergedCache, size_t tid,
+                                  String outSource[NumShaderTypes] );
+
+        /** Runs the Hlms parser for the permutation compileStubEntry would compile; but without
+            compiling it. The output is kept until compileStubEntry (or anything else that
+            compiles the same permutation) consumes it, or _clearPregeneratedShaderCode is called.
+
+            Meant for RenderSystems that don't support multithreaded shader compilation: the parser
+            runs in parallel, and only the compilation is left to the main thread.
+
+            Can be called concurrently as long as each thread uses a different tid.
+        @remarks
+            The merged properties are kept as well (keyed by reservedStubEntry), thus
+            HlmsListener::propertiesMergedPreGenerationStep is not called again when
+            compileStubEntry is called with the same reservedStubEntry.
+        */
+        void _pregenerateStubEntry( const HlmsCache &passCache, const HlmsCache *reservedStubEntry,
+                                    const QueuedRenderable &queuedRenderable, uint32 renderableHash,
+                                    size_t tid );
+
+        /// Frees the output of _pregenerateStubEntry that hasn't been used.
+        void _clearPregeneratedShaderCode();
+
         const ShaderCodeCacheVec &getShaderCodeCache() const { return mShaderCodeCache; }
 
     protected:
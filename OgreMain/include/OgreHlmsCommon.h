@@ -209,11 +209,17 @@ namespace Ogre
 
         HlmsPso pso;
 
-        HlmsCache() : hash( 0 ), type( HLMS_MAX ) {}
+        /// When true, this entry holds its own references to pso.macroblock & pso.blendblock
+        /// (which Hlms::clearShaderCache releases) instead of relying on the datablock's.
+        /// See HlmsDiskCache::applyTo
+        bool ownsBlocks;
+
+        HlmsCache() : hash( 0 ), type( HLMS_MAX ), ownsBlocks( false ) {}
         HlmsCache( uint32 _hash, HlmsTypes _type, const HlmsPso &_pso ) :
             hash( _hash ),
             type( _type ),
-            pso( _pso )
+            pso( _pso ),
+            ownsBlocks( false )
         {
         }
     };
@@ -0,0 +1,261 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreHlmsCompiledTemplate_H_
+#define _OgreHlmsCompiledTemplate_H_
+
+#include "OgreHlmsCommon.h"
+#include "OgreHlmsPropertyMap.h"
+#include "OgreStringVector.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    /** @class HlmsCompiledTemplate
+
+        Pre-parsed form of an Hlms template (or piece) file.
+
+        Without it, every permutation runs Hlms::parseMath, then Hlms::parseForEach until no
+        \@foreach is left, then Hlms::parseProperties recursively; and each of these passes
+        scans and rewrites the whole file as a string.
+
+        compile() parses the file once: \@pset, \@padd & co. become a list of operations,
+        and \@foreach / \@property blocks become a tree whose leaves are ranges of the source
+        text (and \@foreach counter slots). evaluate() then generates a permutation with a
+        single walk that appends the selected ranges. The output is identical to what the
+        string passes would produce, and the remaining passes (\@undefpiece, \@piece,
+        \@insertpiece, \@counter & co.) still run on it as usual.
+
+        Some constructs only make sense in the order the string passes run (e.g. a nested
+        block whose \@end is immediately followed by its parent's \@end, or \@foreach args
+        that contain counters from the parent \@foreach). compile() rejects them and the
+        caller must keep using the string passes for that file.
+    */
+    class _OgreExport HlmsCompiledTemplate : public OgreAllocatedObj
+    {
+    protected:
+        struct Operand
+        {
+            int32    number;
+            IdString property;
+            bool     isProperty;
+
+            Operand() : number( 0 ), isProperty( false ) {}
+        };
+
+        /// Range of mText to output verbatim; or the value of the \@foreach counter at
+        /// depth 'counterDepth' when counterDepth >= 0
+        struct Fragment
+        {
+            uint32 start;
+            uint32 length;
+            int32  counterDepth;
+        };
+
+        struct Expression
+        {
+            uint8 type;  ///< See Hlms::ExpressionType
+            bool  negated;
+            /// When true, the variable name contains \@foreach counters and is
+            /// built from mFragments[firstFragment] to [firstFragment + numFragments)
+            bool    isDynamic;
+            Operand operand;
+            uint32  firstFragment;
+            uint32  numFragments;
+
+            std::vector<Expression> children;
+
+            /// Used during compilation only.
+            String value;
+            uint32 srcStart;
+
+            Expression() :
+                type( 0 ),
+                negated( false ),
+                isDynamic( false ),
+                firstFragment( 0 ),
+                numFragments( 0 ),
+                srcStart( 0 )
+            {
+            }
+
+            void swap( Expression &other );
+        };
+
+        typedef std::vector<Expression> ExpressionVec;
+
+        enum NodeType
+        {
+            NodeText,
+            NodeForEach,
+            NodeProperty
+        };
+
+        struct Node
+        {
+            NodeType type;
+
+            /// NodeText
+            uint32 firstFragment;
+            uint32 numFragments;
+
+            /// NodeForEach. Index to the counter this block defines.
+            uint32  counterDepth;
+            Operand count;
+            Operand start;
+            bool    hasStart;
+
+            /// NodeProperty
+            ExpressionVec expression;
+
+            std::vector<Node> children;
+            /// NodeProperty. Children of \@else.
+            std::vector<Node> elseChildren;
+
+            Node() :
+                type( NodeText ),
+                firstFragment( 0 ),
+                numFragments( 0 ),
+                counterDepth( 0 ),
+                hasStart( false )
+            {
+            }
+        };
+
+        typedef std::vector<Node> NodeVec;
+
+        struct MathOp
+        {
+            IdString dstProperty;
+            uint8    opIdx;
+            Operand  op1;
+            Operand  op2;
+        };
+
+        typedef std::vector<MathOp> MathOpVec;
+
+        /// Max nesting of \@foreach blocks.
+        static const size_t c_maxCounterDepth = 16u;
+
+        /// Input file without the math operations. Not used if mCompiled == false.
+        String                mText;
+        MathOpVec             mMathOps;
+        std::vector<Fragment> mFragments;
+        NodeVec               mNodes;
+        size_t                mEstimatedOutputSize;
+
+        /// Original file. Only kept when mCompiled == false.
+        String mSource;
+        bool   mCompiled;
+
+        bool compileMath( const String &source );
+
+        bool isCounterSlot( size_t pos, const StringVector &counterVars, size_t &outDepth ) const;
+
+        bool addFragments( size_t start, size_t end, const StringVector &counterVars,
+                           uint32 &outFirstFragment, uint32 &outNumFragments );
+        bool addTextNode( size_t start, size_t end, const StringVector &counterVars,
+                          NodeVec &outNodes );
+
+        /// Same as the way Hlms::parseForEach & Hlms::evaluateExpression interpret values.
+        static void parseOperand( const String &value, Operand &outOperand );
+        /// Same as Hlms::interpretAsNumberThenAsProperty.
+        static void parseMathOperand( const String &value, Operand &outOperand );
+        bool compileExpression( size_t start, size_t end, const StringVector &counterVars,
+                                ExpressionVec &outExpression );
+        bool normalizeExpression( ExpressionVec &expression, const StringVector &counterVars );
+
+        /// Validates the character swallowed after a keyword (e.g. \@end) is at the
+        /// same place for us as it is for the string passes.
+        bool isValidSkip( size_t pos, size_t regionEnd ) const;
+
+        bool compileBlock( size_t start, size_t end, StringVector &counterVars, NodeVec &outNodes );
+
+        void appendFragments( uint32 firstFragment, uint32 numFragments, const int32 *counters,
+                              String &outBuffer ) const;
+
+        static int32 getOperandValue( const Operand &operand, const HlmsPropertyMap &properties,
+                                      int32 defaultVal );
+
+        int32 evaluateExpression( const ExpressionVec &expression, const HlmsPropertyMap &properties,
+                                  const int32 *counters ) const;
+
+        bool evaluateNodes( const NodeVec &nodes, const HlmsPropertyMap &properties, int32 *counters,
+                            String &outBuffer ) const;
+
+    public:
+        HlmsCompiledTemplate();
+
+        /** Parses the template file.
+        @param source
+            Contents of the template file.
+        @return
+            True if the template can be evaluated with evaluate().
+            False if the caller must use the string passes. The source is kept
+            and can be retrieved via getSource()
+        */
+        bool compile( const String &source );
+
+        bool isCompiled() const { return mCompiled; }
+
+        /// The contents of the template file. Only available when isCompiled() == false.
+        const String &getSource() const { return mSource; }
+
+        /** Equivalent to running Hlms::parseMath, Hlms::parseForEach & Hlms::parseProperties.
+            Must only be called if isCompiled() == true.
+
+            Can be called concurrently from multiple threads.
+        @param properties [in/out]
+            Properties to evaluate against. Math operations (e.g. \@pset) modify them.
+        @param scratchMap
+            Scratch memory. Gets filled with the properties so that lookups while evaluating
+            don't need a binary search. Reusing it avoids reallocations.
+        @param outBuffer [out]
+            The processed template.
+        @return
+            True if there were syntax errors.
+        */
+        bool evaluate( HlmsPropertyVec &properties, HlmsPropertyMap &scratchMap,
+                       String &outBuffer ) const;
+    };
+
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
@@ -43,6 +43,7 @@ namespace Ogre
      */
 
     struct CompilerJobParams;
+    struct PsoJobParams;
 
     /** @class HlmsDiskCache
 
@@ -124,38 +125,95 @@ namespace Ogre
                                     Depending on the API and Driver, building the PSO can be very fast
                                     or take significant time.
 
-                                    Note that due to a technical issue, this information is currently
-                                    being saved to disk but the PSO is not rebuilt (i.e. the information
-                                    is not used). Because of it, certain platforms may still experience
-                                    some stalls at runtime, due to the driver translating the Microcode
-                                    to the internal ISA.
+                                    applyTo rebuilds these PSOs (in parallel when the RenderSystem
+                                    supports it), so that the first time a Renderable is rendered
+                                    its PSO is already in the Hlms cache.
+                                    HlmsListener::shaderCacheEntryCreated is not called for them,
+                                    as there is no Renderable at that point.
+                                    The PSOs are not rebuilt for "glsl", because the Hlms
+                                    implementations must bind texture & buffer slots on the
+                                    render thread the first time a PSO is created.
     @endcode
+
+        The file is a small header (version, template checksum, shader profile, etc) followed by
+        a flat list of records (custom piece files, shader source code, PSOs) and a table of
+        contents. Each record starts with its type, a 128-bit key identifying its contents and
+        the size of its payload. The table of contents lists the type, key and location of every
+        record sorted by key, and the file ends with the offset to it.
+
+        The preprocessed shader source of each record is deflate-compressed (when Ogre was built
+        with zlib support). loadFrom doesn't read it: it's read by applyTo (only if the templates
+        are not out of date) and decompressed by its compiler threads.
+
+        appendTo reads the table of contents and overwrites it with the records that are not in
+        the file yet, followed by the updated table; so that new permutations discovered at
+        runtime can be added without reading or rewriting the whole cache. If the app gets killed
+        while appending the table is lost, and the file must be saved from scratch.
     */
     class _OgreExport HlmsDiskCache : public OgreAllocatedObj
     {
     public:
+        enum RecordType
+        {
+            RecordCustomPieceFile,
+            RecordSourceCode,
+            RecordPso
+        };
+
+        enum SourceCompression
+        {
+            SourceUncompressed,
+            SourceZlib
+        };
+
+        typedef std::pair<uint64, uint64> RecordKey;
+        typedef set<RecordKey>::type      RecordKeySet;
+
         struct SourceCode
         {
+            uint64                key[2];  // 128 bit hash
             Hlms::RenderableCache mergedCache;
-            String                sourceFile[NumShaderTypes];
+            /// Empty if the source is in storedSource instead.
+            String sourceFile[NumShaderTypes];
+
+            /// sourceFile as stored on disk. See SourceCompression.
+            /// Empty until HlmsDiskCache::readStoredSources reads it.
+            vector<uint8>::type storedSource;
+            uint32              uncompressedSize;
+            /// Size of storedSource. 0 if the source is in sourceFile instead.
+            uint32 storedSourceSize;
+            /// Where storedSource is in the stream loadFrom read from.
+            uint64 storedSourceOffset;
+            uint8  compression;
 
             SourceCode();
             SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache );
+
+            /** Retrieves the source code of each stage, decompressing it if needed.
+            @return
+                False if storedSource couldn't be read, is corrupt or its compression is not
+                supported by this build.
+            */
+            bool getSourceFiles( String outSourceFile[NumShaderTypes] ) const;
         };
 
         typedef vector<SourceCode>::type SourceCodeVec;
 
         struct Pso
         {
+            uint64                key[2];  // 128 bit hash
             Hlms::RenderableCache renderableCache;
             HlmsPropertyVec       passProperties;
             HlmsPso               pso;
             HlmsMacroblock        macroblock;
             HlmsBlendblock        blendblock;
+            /// Index to Cache::sourceCode with the shaders this PSO uses.
+            /// Out of bounds if they could not be found.
+            uint32 sourceCodeIdx;
 
             Pso();
             Pso( const Hlms::RenderableCache &srcRenderableCache, const Hlms::PassCache &srcPassCache,
-                 const HlmsCache *srcPsoCache );
+                 const HlmsCache *srcPsoCache, uint32 _sourceCodeIdx );
         };
 
         typedef vector<Pso>::type PsoVec;
@@ -169,6 +227,23 @@ namespace Ogre
 
         typedef vector<DatablockCustomPiecesCache>::type DatablockCustomPiecesCacheVec;
 
+        /// Entry of the table of contents at the end of the file
+        struct TocEntry
+        {
+            uint64 key[2];  // 128 bit hash
+            /// Offset to the payload of the record from the beginning of the file
+            uint64 payloadOffset;
+            uint32 payloadSize;
+            uint8  type;  ///< See RecordType
+
+            bool operator<( const TocEntry &other ) const
+            {
+                return key[0] < other.key[0] || ( key[0] == other.key[0] && key[1] < other.key[1] );
+            }
+        };
+
+        typedef vector<TocEntry>::type TocEntryVec;
+
         struct Cache
         {
             uint64        templateHash[2];  // 128 bit hash
@@ -188,6 +263,9 @@ namespace Ogre
         bool         mFastShaderBuildHack;
         uint16       mDebugStrSize;
 
+        /// Stream loadFrom read from, until the stored sources are read from it
+        DataStreamPtr mSourceStream;
+
         void save( DataStreamPtr &dataStream, const IdString &hashedString );
         void save( DataStreamPtr &dataStream, const String &string );
         void save( DataStreamPtr &dataStream, const HlmsPropertyVec &properties );
@@ -198,6 +276,45 @@ namespace Ogre
         void load( DataStreamPtr &dataStream, HlmsPropertyVec &properties );
         void load( DataStreamPtr &dataStream, Hlms::RenderableCache &renderableCache );
 
+        void savePsoState( DataStreamPtr &dataStream, const Pso &pso );
+        void loadPsoState( DataStreamPtr &dataStream, Pso &pso );
+
+        void saveHeader( DataStreamPtr &dataStream );
+        /// Returns false if the cache can't be used by this build (e.g. different version)
+        bool loadHeader( DataStreamPtr &dataStream );
+
+        /** Writes all records whose key is not in inOutToc yet, and adds them to it
+        @param offset
+            Position of dataStream from the beginning of the file
+        @param inOutToc
+            Table of contents of the file, sorted by key
+        @return
+            Position after the last record
+        */
+        uint64 saveRecords( DataStreamPtr &dataStream, uint64 offset, TocEntryVec &inOutToc );
+
+        /// Writes the table of contents & the end of the file
+        static void saveToc( DataStreamPtr &dataStream, const TocEntryVec &toc, uint64 tocOffset );
+        /** Reads the table of contents of a file whose header has just been read
+        @return
+            False if the file has none or it's corrupt (e.g. the file got truncated)
+        */
+        static bool loadToc( DataStreamPtr &dataStream, TocEntryVec &outToc, uint64 &outTocOffset );
+
+        /// Reads the SourceCode::storedSource loadFrom skipped, from mSourceStream
+        void readStoredSources();
+
+        /// Writes the data that identifies the properties. Unlike save(), the output
+        /// doesn't depend on OGRE_DEBUG_STR_SIZE.
+        static void writeKeyData( DataStreamPtr &keyData, const HlmsPropertyVec &properties,
+                                  bool bSkipPsoProperties );
+        static void writeKeyData( DataStreamPtr &keyData, const Hlms::RenderableCache &renderableCache,
+                                  bool bSkipPsoProperties );
+
+        void calculateKey( const DatablockCustomPiecesCache &datablockPiece, uint64 outKey[2] );
+        void calculateKey( const SourceCode &sourceCode, uint64 outKey[2] );
+        void calculateKey( const Pso &pso, uint64 outKey[2] );
+
     public:
         HlmsDiskCache( HlmsManager *hlmsManager );
         ~HlmsDiskCache();
@@ -208,9 +325,26 @@ namespace Ogre
         void applyTo( Hlms *hlms, size_t numThreads );
 
         void saveTo( DataStreamPtr &dataStream );
+
+        /** Loads a cache written by saveTo (and/or appendTo).
+        @remarks
+            The shader source is read when it's needed (by applyTo or saveTo). Until then
+            (or clearCache) we keep a reference to dataStream, and the file must not be modified.
+        */
         void loadFrom( DataStreamPtr &dataStream );
 
+        /** Adds to an existing cache file the entries that are not in it yet.
+        @param dataStream
+            Read & write stream to a file previously written by saveTo (and/or appendTo).
+        @return
+            False if the file can't be appended to (e.g. it's from a different version, the
+            templates have changed, the file is truncated, etc). Nothing gets written in that
+            case and saveTo should be used instead.
+        */
+        bool appendTo( DataStreamPtr &dataStream );
+
         static void _compileShadersThread( CompilerJobParams &threadHandle, size_t threadIdx );
+        static void _createPsosThread( PsoJobParams &jobParams, size_t threadIdx );
     };
 
     /** @} */
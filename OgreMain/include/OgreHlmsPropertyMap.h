@@ -0,0 +1,140 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreHlmsPropertyMap_H_
+#define _OgreHlmsPropertyMap_H_
+
+#include "OgreHlmsCommon.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    /** @class HlmsPropertyMap
+
+        Open addressing hash table (linear probing) of Hlms properties, keyed by the hash
+        already stored in IdString.
+
+        HlmsPropertyVec is sorted so that it can be compared and hashed cheaply (e.g. by
+        Hlms::addRenderableCache), but every lookup is a binary search over a few hundred
+        entries. Use this container when a large number of lookups is done against the same
+        set of properties (i.e. generating a shader), and only materialise the sorted
+        ordering via getSortedProperties when it's actually needed.
+
+        Unlike HlmsPropertyVec, iteration order is unspecified.
+    */
+    class _OgreExport HlmsPropertyMap
+    {
+    protected:
+        struct Slot
+        {
+            IdString keyName;
+            int32    value;
+            bool     used;
+
+            Slot() : value( 0 ), used( false ) {}
+        };
+
+        typedef vector<Slot>::type SlotVec;
+
+        SlotVec mSlots;
+        size_t  mSize;
+        /// mSlots.size() - 1u. mSlots.size() is always a power of 2 (or 0).
+        uint32 mMask;
+        /// 32 - log2( mSlots.size() )
+        uint8 mShift;
+
+        uint32 getHomeSlot( IdString key ) const
+        {
+            // Fibonacci hashing. Takes the high bits as IdString's low bits are not
+            // guaranteed to be well distributed after IdString::getU32Value
+            return ( key.getU32Value() * 2654435769u ) >> mShift;
+        }
+
+        /// Returns the index of the slot that contains key, or the empty slot
+        /// where it would be inserted. mSlots must not be empty.
+        uint32 findSlot( IdString key ) const
+        {
+            uint32 idx = getHomeSlot( key );
+            while( mSlots[idx].used && mSlots[idx].keyName != key )
+                idx = ( idx + 1u ) & mMask;
+            return idx;
+        }
+
+        void rehash( size_t newCapacity );
+
+    public:
+        HlmsPropertyMap();
+
+        /// Removes all properties. Keeps the memory.
+        void clear();
+
+        /// Makes room for numProperties without rehashing.
+        void reserve( size_t numProperties );
+
+        size_t size() const { return mSize; }
+        bool   empty() const { return mSize == 0u; }
+
+        void setProperty( IdString key, int32 value );
+
+        int32 getProperty( IdString key, int32 defaultVal = 0 ) const
+        {
+            if( mSize == 0u )
+                return defaultVal;
+            const Slot &slot = mSlots[findSlot( key )];
+            return slot.used ? slot.value : defaultVal;
+        }
+
+        void unsetProperty( IdString key );
+
+        /// Replaces the contents with the given properties.
+        void setProperties( const HlmsPropertyVec &properties );
+
+        /** Materialises the properties in the same order as HlmsPropertyVec expects them
+            (see OrderPropertyByIdString), so the result can be used for e.g.
+            Hlms::addRenderableCache.
+        @param outProperties [out]
+            Previous contents are discarded.
+        */
+        void getSortedProperties( HlmsPropertyVec &outProperties ) const;
+    };
+
+    /** @} */
+    /** @} */
+
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
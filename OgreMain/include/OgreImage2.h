@@ -415,10 +415,16 @@ namespace Ogre
             True if the filter should be applied in linear space.
         @param filter
             The type of filter to use.
+        @param numThreads
+            Large 2D and Cubemap mips are split in bands of rows which are downsampled
+            by up to this many threads (the calling thread included). 1 to do all the
+            work in the calling thread.
+            3D textures and the blur pass of FILTER_GAUSSIAN_HIGH are always single threaded.
         @return
             False if failed to generate and mipmaps properties won't be changed. True on success.
         */
-        bool generateMipmaps( bool gammaCorrected, Filter filter = FILTER_BILINEAR );
+        bool generateMipmaps( bool gammaCorrected, Filter filter = FILTER_BILINEAR,
+                              uint32 numThreads = 1u );
 
         /// Static function to get an image type string from a stream via magic numbers
         static String getFileExtFromMagic( DataStreamPtr &stream );
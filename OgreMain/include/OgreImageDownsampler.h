@@ -46,12 +46,18 @@ namespace Ogre
     @param kernelEndX
     @param kernelStartY
     @param kernelEndY
+    @param dstRowStart
+        First dst row to write. Rows in range [dstRowStart; dstRowEnd) can be
+        processed from different threads concurrently.
+    @param dstRowEnd
+        Last dst row to write, exclusive. Pass dstHeight to write all rows.
      */
     typedef void( ImageDownsampler2D )( uint8 *dstPtr, uint8 const *srcPtr, int32 dstWidth,
                                         int32 dstHeight, int32 dstBytesPerRow, int32 srcWidth,
                                         int32 srcBytesPerRow, const uint8 kernel[5][5],
                                         const int8 kernelStartX, const int8 kernelEndX,
-                                        const int8 kernelStartY, const int8 kernelEndY );
+                                        const int8 kernelStartY, const int8 kernelEndY,
+                                        int32 dstRowStart, int32 dstRowEnd );
 
     ImageDownsampler2D downscale2x_XXXA8888;
     ImageDownsampler2D downscale2x_XXX888;
@@ -83,12 +89,14 @@ namespace Ogre
     //  CUBEMAP versions
     //
 
+    /// See ImageDownsampler2D for dstRowStart & dstRowEnd
     typedef void( ImageDownsamplerCube )( uint8 *dstPtr, uint8 const **srcPtr, int32 dstWidth,
                                           int32 dstHeight, int32 dstBytesPerRow, int32 srcWidth,
                                           int32 srcHeight, int32 srcBytesPerRow,
                                           const uint8 kernel[5][5], const int8 kernelStartX,
                                           const int8 kernelEndX, const int8 kernelStartY,
-                                          const int8 kernelEndY, uint8 currentFace );
+                                          const int8 kernelEndY, uint8 currentFace,
+                                          int32 dstRowStart, int32 dstRowEnd );
 
     ImageDownsamplerCube downscale2x_XXXA8888_cube;
     ImageDownsamplerCube downscale2x_XXX888_cube;
@@ -81,7 +81,9 @@ namespace Ogre
     @note
         No functions were declared virtual to improve performance.
     */
-    class _OgreExport Item : public MovableObject, public Resource::Listener
+    class _OgreExport Item : public MovableObject,
+                             public Resource::Listener,
+                             public LodStreamingListener
     {
         // Allow ItemFItemy full access
         friend class ItemFactory;
@@ -275,6 +277,9 @@ namespace Ogre
         /** Resource::Listener hook to notify Entity that a Mesh is (re)loaded. */
         void loadingComplete( Resource *res ) override;
 
+        /// LodStreamingListener hook to pick up the Vaos of LODs that got streamed in or evicted
+        void meshLodResidencyChanged( Mesh *mesh ) override;
+
         void _notifyParentNodeMemoryChanged() override;
     };
 
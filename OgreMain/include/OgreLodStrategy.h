@@ -31,6 +31,9 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 #include "Math/Array/OgreArrayConfig.h"
+
+#include <atomic>
+
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre
@@ -41,6 +44,38 @@ namespace Ogre
     /** \addtogroup LOD
      *  @{
      */
+    /** Residency of a Mesh whose finer LODs are streamed in on demand (see Mesh::msLodStreaming).
+        Shared by the Mesh and every MovableObject using it, so that LodStrategy::lodSet never
+        selects a LOD that isn't in GPU memory, and records which LOD it would have liked instead.
+    */
+    struct LodStreamingState
+    {
+        /// Finest LOD in GPU memory. Only modified by the main thread, at the end of the frame.
+        uint8 firstResidentLod;
+        /// Finest LOD selected since the last MeshManager::_updateLodStreaming. 255 if none.
+        std::atomic<uint8> requestedLod;
+
+        LodStreamingState() : firstResidentLod( 0u ), requestedLod( 255u ) {}
+
+        /// Records that lod was selected. Returns the LOD that can actually be used.
+        uint8 request( uint8 lod )
+        {
+            // Not a CAS loop: a request lost to a racing thread gets repeated next frame.
+            if( lod < requestedLod.load( std::memory_order_relaxed ) )
+                requestedLod.store( lod, std::memory_order_relaxed );
+            return lod > firstResidentLod ? lod : firstResidentLod;
+        }
+    };
+
+    /// Gets told when LODs of a Mesh get streamed in or evicted (see Mesh::msLodStreaming),
+    /// which changes the Vaos in SubMesh::mVao.
+    class _OgreExport LodStreamingListener
+    {
+    public:
+        virtual ~LodStreamingListener() {}
+        virtual void meshLodResidencyChanged( Mesh *mesh ) = 0;
+    };
+
     /** Strategy for determining level of detail.
     @remarks
         Generally, to create a new LOD strategy, all of the following will
@@ -39,8 +39,11 @@ namespace Ogre
             {
                 FastArray<Real>::const_iterator it =
                     std::lower_bound( owner->mLodMesh->begin(), owner->mLodMesh->end(), lodValues[j] );
-                owner->mCurrentMeshLod =
+                const uint8 meshLod =
                     static_cast<uint8>( std::max<ptrdiff_t>( it - owner->mLodMesh->begin() - 1, 0 ) );
+                // Streamed meshes may not have the LOD we want yet; use the finest one available.
+                LodStreamingState *lodStreaming = owner->mLodMeshStreaming;
+                owner->mCurrentMeshLod = lodStreaming ? lodStreaming->request( meshLod ) : meshLod;
             }
 
             RenderableArray::iterator itor = owner->mRenderables.begin();
@@ -32,6 +32,8 @@ THE SOFTWARE.
 
 #include "Math/Simple/OgreAabb.h"
 #include "OgreDataStream.h"
+#include "OgreLodStrategy.h"
+#include "OgreMesh2Optimizer.h"
 #include "OgreResource.h"
 #include "OgreVertexBoneAssignment.h"
 #include "Vao/OgreBufferPacked.h"
@@ -50,6 +52,52 @@ namespace Ogre
      */
 
     class LodStrategy;
+    class TriangleBvh;
+
+    /** Where the LODs of a Mesh streamed in on demand live in its file. See Mesh::msLodStreaming.
+    @remarks
+        LODs are grouped in steps. A step is a range of consecutive LODs that don't reference
+        vertex buffers of finer LODs, so it can be streamed in & evicted on its own. The
+        coarsest step is always resident.
+    */
+    struct MeshLodStreamingInfo
+    {
+        /// Offset of the M_SUBMESH_LOD chunk of each LOD, ordered [submesh][vao pass][lod]
+        FastArray<size_t> chunkOffsets;
+        /// First LOD of each step, ascending. The first one is always 0.
+        FastArray<uint8> stepLods;
+        /// Size in bytes of the data of each step, both Vao passes included.
+        FastArray<size_t> stepBytes;
+        uint8 numLods;
+        uint8 numVaoPasses;
+        /// Endianness of the file
+        bool flipEndian;
+        /// First LOD being streamed in. 255 if none.
+        uint8 pendingLod;
+        /// Last frame the finest resident step was requested
+        unsigned long lastUsedFrame;
+        /// Identifies this load of the Mesh, so that stale requests get discarded.
+        uint32 ticket;
+
+        MeshLodStreamingInfo() :
+            numLods( 0u ),
+            numVaoPasses( 1u ),
+            flipEndian( false ),
+            pendingLod( 255u ),
+            lastUsedFrame( 0u ),
+            ticket( 0u )
+        {
+        }
+
+        /// Returns the index in stepLods of the step containing lod
+        size_t getStepIdx( uint8 lod ) const
+        {
+            size_t stepIdx = stepLods.size() - 1u;
+            while( stepIdx > 0u && stepLods[stepIdx] > lod )
+                --stepIdx;
+            return stepIdx;
+        }
+    };
 
     /** Resource holding data about 3D mesh.
     @remarks
@@ -115,6 +163,20 @@ namespace Ogre
         String        mLodStrategyName;
         LodValueArray mLodValues;
 
+        /// Non-null when the finer LODs are streamed in on demand. See msLodStreaming
+        MeshLodStreamingInfo *mLodStreaming;
+        LodStreamingState     mLodStreamingState;
+
+        typedef vector<LodStreamingListener *>::type LodStreamingListenerVec;
+        LodStreamingListenerVec                     mLodStreamingListeners;
+
+        /// Built on demand by _getTriangleBvh. Null otherwise
+        TriangleBvh *mTriangleBvh;
+        /// First triangle of each SubMesh in mTriangleBvh
+        FastArray<uint32> mTriangleBvhSubMeshStarts;
+        /// LOD mTriangleBvh was built from
+        uint8 mTriangleBvhLod;
+
         uint64 mHashForCaches[2];
 
         VaoManager *mVaoManager;
@@ -416,6 +478,34 @@ namespace Ogre
 
         const LodValueArray *_getLodValueArray() const { return &mLodValues; }
 
+        /// Returns null if the LODs of this Mesh aren't streamed. See msLodStreaming
+        LodStreamingState *_getLodStreamingState()
+        {
+            return mLodStreaming ? &mLodStreamingState : 0;
+        }
+        /// Returns null if the LODs of this Mesh aren't streamed. See msLodStreaming
+        MeshLodStreamingInfo *_getLodStreamingInfo() { return mLodStreaming; }
+
+        /// Finest LOD whose data is in GPU memory. Always 0 unless LODs are streamed.
+        uint8 getFirstResidentLod() const { return mLodStreamingState.firstResidentLod; }
+
+        void _addLodStreamingListener( LodStreamingListener *listener );
+        void _removeLodStreamingListener( LodStreamingListener *listener );
+
+        /** Makes LODs [firstLod; getFirstResidentLod()) resident. Their Vaos must
+            already be in SubMesh::mVao. Notifies LodStreamingListeners.
+        @remarks
+            The entries in SubMesh::mVao of non-resident LODs point to the Vao of
+            the finest resident LOD, so that code looking at mVao[0] keeps working.
+        */
+        void _setFirstResidentLod( uint8 firstLod );
+
+        /** Destroys the Vaos of the finest resident step, which must not be the coarsest.
+        @return
+            The bytes freed, as in MeshLodStreamingInfo::stepBytes.
+        */
+        size_t _evictLodStep();
+
         /** Imports a v1 mesh to this mesh, with optional optimization conversions.
             This mesh must be in unloaded state. Resulting mesh would be non-reloadable, use
             MeshManager::createByImportingV1 to create mesh that will survive device lost event.
@@ -464,6 +554,46 @@ namespace Ogre
         /// which are more compatible for doing certain operations vertex operations in the CPU.
         void dearrangeToInefficient();
 
+        /** Reorders the triangles and vertices of every SubMesh so they render faster:
+            better post-transform vertex cache usage, less overdraw and linear vertex fetching.
+            Usually called right after importV1 or before saving the mesh.
+            See SubMesh::optimizeGeometry.
+        @param flags
+            Bitmask of MeshOptimizer::Flags.
+        @param overdrawThreshold
+            See MeshOptimizer::optimizeOverdraw.
+        @return
+            ACMR & ATVR before and after, of all SubMeshes combined.
+        */
+        MeshOptimizer::Report optimizeGeometry( uint32 flags = MeshOptimizer::OptimizeAll,
+                                                float  overdrawThreshold = 1.05f );
+
+        /** Splits every SubMesh in clusters of triangles for cluster culling.
+            See SubMesh::buildClusters. Clusters get saved with the mesh.
+        */
+        void buildClusters( uint32 maxTriangles = 128u );
+
+        /** Returns a TriangleBvh over the triangles of every SubMesh, in mesh space; for exact
+            ray casts on the CPU (e.g. DefaultBatchRaySceneQuery).
+        @remarks
+            It's built on the first call from the finest resident LOD (see
+            SubMesh::_addTrianglesToBvh) and cached until the Mesh is unloaded, its geometry
+            changes, or a finer LOD becomes resident.
+        @par
+            Building it may read back GPU buffers, thus it must be called from the main thread.
+            Once built, the returned BVH can be queried from any thread.
+            Poses & skeletal animation are not taken into account.
+        */
+        const TriangleBvh *_getTriangleBvh();
+
+        /// Converts a TriangleBvh::Hit::triangleIdx of _getTriangleBvh into the index of
+        /// the SubMesh and of the triangle within that SubMesh's index buffer.
+        void _getTriangleBvhSubMesh( uint32 triangleIdx, uint32 &outSubMeshIdx,
+                                     uint32 &outTriangleIdx ) const;
+
+        /// Frees the BVH built by _getTriangleBvh. It will be rebuilt when needed again.
+        void _discardTriangleBvh();
+
         /// When this bool is false, prepareForShadowMapping will use the same Vaos for
         /// both regular and shadow mapping rendering. When it's true, it will
         /// calculate an optimized version to speed up shadow map rendering (uses a bit
@@ -484,6 +614,32 @@ namespace Ogre
         /// hurt loading times with unnecessary disk access
         static bool msUseTimestampAsHash;
 
+        /// When non-zero, meshes loaded from a file that has no clusters get them built
+        /// (see buildClusters) with up to this many triangles each.
+        /// Large meshes can take a while, it is recommended to build them offline
+        /// and save them into the mesh file.
+        /// It's 0 (disabled) by default.
+        static uint32 msBuildClustersOnLoad;
+
+        /** When true, meshes loaded from a file only load their coarsest LODs, and become
+            renderable right away. Finer LODs get streamed in the background (see WorkQueue)
+            once the LodStrategy selects them, and are evicted again when the budget set with
+            MeshManager::setLodStreamingBudget is exceeded.
+        @remarks
+            Until a LOD is resident, objects render the finest resident one instead.
+        @par
+            Only LODs whose vertex data doesn't come from a finer LOD can be streamed
+            separately (meshes whose LODs share the vertex buffer of LOD 0 load entirely).
+            msOptimizeForShadowMapping isn't applied to streamed meshes; save the
+            optimized shadow mapping Vaos in the file instead.
+        @par
+            Exporting the mesh, or modifying its geometry (e.g. optimizeGeometry, buildClusters)
+            requires all of its LODs to be resident.
+        @par
+            It's off by default.
+        */
+        static bool msLodStreaming;
+
         void prepareForShadowMapping( bool forceSameBuffers );
 
         /// Returns true if the mesh is ready for rendering with valid shadow mapping Vaos
@@ -0,0 +1,227 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreMesh2Optimizer_H_
+#define _OgreMesh2Optimizer_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgreFastArray.h"
+#include "OgreVector3.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    /** Cluster of consecutive triangles (a.k.a. meshlet) of a SubMesh LOD.
+        See SubMesh::buildClusters and MeshOptimizer::cullClusters.
+    */
+    struct MeshCluster
+    {
+        /// Bounding sphere of the triangles, in object space
+        Vector3 center;
+        Real    radius;
+        /// Every triangle's normal is at most acos( coneCos ) away from coneAxis.
+        /// coneCos <= 0 means the cone is too wide for back-face culling.
+        Vector3 coneAxis;
+        Real    coneCos;
+        /// Range of indices, relative to the primitive start of the LOD's VAO
+        uint32 indexStart;
+        uint32 indexCount;
+    };
+
+    typedef FastArray<MeshCluster> MeshClusterArray;
+
+    /** Reorders the triangles and vertices of v2 meshes so the GPU processes them faster.
+        See Mesh::optimizeGeometry and SubMesh::optimizeGeometry.
+    @remarks
+        The static functions work on raw triangle lists with 32-bit indices so they can be
+        used on any geometry, not just Mesh. They're applied in this order:
+            1. weldVertices: finds vertices which are byte-by-byte identical.
+            2. optimizeVertexCache: reorders triangles so that recently transformed vertices
+               get reused (Tom Forsyth's "Linear-Speed Vertex Cache Optimisation").
+            3. optimizeOverdraw: splits the result in clusters and sorts them so that
+               triangles which occlude others are rendered first (Sander, Nehab & Barczak's
+               "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+            4. optimizeVertexFetch: orders the vertices by first use and drops unused ones,
+               so that vertex fetching accesses memory linearly.
+    */
+    class _OgreExport MeshOptimizer
+    {
+    public:
+        enum Flags
+        {
+            /// Reorder triangles for the post-transform vertex cache
+            OptimizeVertexCache = 1u << 0u,
+            /// Reorder clusters of triangles to reduce overdraw. Requires VES_POSITION
+            OptimizeOverdraw = 1u << 1u,
+            /// Reorder vertices by first use and remove unused ones
+            OptimizeVertexFetch = 1u << 2u,
+            /// Merge vertices whose data is exactly the same
+            WeldVertices = 1u << 3u,
+            OptimizeAll = OptimizeVertexCache | OptimizeOverdraw | OptimizeVertexFetch | WeldVertices
+        };
+
+        /// Vertex cache efficiency of a triangle list.
+        struct _OgreExport Stats
+        {
+            size_t numTriangles;
+            /// Vertices referenced by the triangles
+            size_t numVertices;
+            /// Vertices stored in the vertex buffer (may include unreferenced ones)
+            size_t numVerticesStored;
+            /// Vertices transformed, assuming a FIFO post-transform cache
+            size_t numCacheMisses;
+
+            Stats();
+
+            /// Average Cache Miss Ratio: transformed vertices per triangle. Optimum is 0.5
+            float getAcmr() const;
+            /// Average Transform to Vertex Ratio: transformed vertices per vertex. Optimum is 1.0
+            float getAtvr() const;
+
+            void merge( const Stats &other );
+        };
+
+        struct _OgreExport Report
+        {
+            Stats before;
+            Stats after;
+
+            void merge( const Report &other );
+        };
+
+        /// Interleaved vertex data to compare when welding
+        struct VertexStream
+        {
+            uint8 const *data;
+            size_t       bytesPerVertex;
+        };
+
+        typedef FastArray<VertexStream> VertexStreamArray;
+
+        /// Cache size used by the reports. Most GPUs behave close to a FIFO of this size
+        static const uint32 DefaultCacheSize = 16u;
+
+        /** Measures how well the vertex cache is used.
+        @param indices
+            Triangle list.
+        @param numVertices
+            Number of vertices in the vertex buffer. All indices must be below it.
+        @param cacheSize
+            Entries in the simulated FIFO cache.
+        */
+        static Stats analyze( const uint32 *indices, size_t numIndices, size_t numVertices,
+                              uint32 cacheSize = DefaultCacheSize );
+
+        /** Finds duplicated vertices.
+        @param outRemap [out]
+            Array of numVertices. outRemap[i] is the first vertex identical to vertex i
+            (i.e. outRemap[i] <= i, and outRemap[i] == i if it is unique).
+        @return
+            Number of unique vertices.
+        */
+        static size_t weldVertices( const VertexStreamArray &streams, size_t numVertices,
+                                    uint32 *outRemap );
+
+        /// Reorders the triangles in-place to maximize post-transform vertex cache hits.
+        static void optimizeVertexCache( uint32 *indices, size_t numIndices, size_t numVertices );
+
+        /** Reorders clusters of triangles in-place to reduce overdraw, keeping vertex cache
+            efficiency. The input should have gone through optimizeVertexCache first.
+        @param positions
+            XYZ position of every vertex, packed.
+        @param threshold
+            How much ACMR may be worsened in exchange of smaller clusters (i.e. better
+            sorting). 1.05 allows 5% more cache misses.
+        */
+        static void optimizeOverdraw( uint32 *indices, size_t numIndices, const float *positions,
+                                      size_t numVertices, float threshold = 1.05f,
+                                      uint32 cacheSize = DefaultCacheSize );
+
+        /** Builds a table that orders the vertices by first use.
+        @param outRemap [out]
+            Array of numVertices. outRemap[i] is the new location of vertex i,
+            or 0xFFFFFFFF if no triangle uses it.
+        @return
+            Number of vertices after remapping.
+        */
+        static size_t optimizeVertexFetch( const uint32 *indices, size_t numIndices,
+                                           size_t numVertices, uint32 *outRemap );
+
+        /** Splits a triangle list in clusters of consecutive triangles. The triangles are
+            not reordered, so it should be called after optimizing the geometry; the
+            spatial locality left by optimizeVertexCache produces tighter clusters.
+        @remarks
+            A cluster ends when it reaches maxTriangles, or once it has a quarter of that
+            if the next triangle doesn't share a vertex with it or deviates too much
+            from its average normal.
+        @param positions
+            XYZ position of every vertex, packed.
+        @param maxTriangles
+            Maximum number of triangles per cluster. 64-128 balances culling granularity
+            against the cost of culling on the CPU.
+        @param outClusters [out]
+            Clusters are appended to it.
+        */
+        static void buildClusters( const uint32 *indices, size_t numIndices, const float *positions,
+                                   size_t numVertices, uint32 maxTriangles,
+                                   MeshClusterArray &outClusters );
+
+        /** Culls clusters against the frustum and by their normal cones (back-facing
+            clusters), and merges the visible ones that are contiguous in the index buffer.
+        @param worldMatrix
+            Affine transform of the object.
+        @param planes
+            Frustum planes in world space, facing inwards.
+        @param localCameraPos
+            Camera position in object space. Null to skip back-face culling (i.e.
+            double-sided materials).
+        @param outRanges [out]
+            (indexStart, indexCount) pairs of visible ranges are appended to it.
+        @return
+            Number of visible indices.
+        */
+        static size_t cullClusters( const MeshClusterArray &clusters, const Matrix4 &worldMatrix,
+                                    const Plane *planes, size_t numPlanes,
+                                    const Vector3 *localCameraPos, FastArray<uint32> &outRanges );
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
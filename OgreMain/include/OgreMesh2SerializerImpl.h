@@ -84,10 +84,7 @@ namespace Ogre
         */
         void importMesh( DataStreamPtr &stream, Mesh *pDest, MeshSerializerListener *listener );
 
-    protected:
-        typedef vector<uint8>::type                     LodLevelVertexBufferTable;
-        typedef vector<LodLevelVertexBufferTable>::type LodLevelVertexBufferTableVec;  // One per submesh
-        typedef vector<uint8 *>::type                   Uint8Vec;
+        typedef vector<uint8 *>::type Uint8Vec;
 
         struct SubMeshLod
         {
@@ -105,9 +102,66 @@ namespace Ogre
 
         typedef vector<SubMeshLod>::type SubMeshLodVec;
 
+        /** Reads LODs [firstLod; endLod) of a Mesh whose LODs are streamed
+            (see Mesh::msLodStreaming) into CPU memory. Can be called from any thread,
+            as it doesn't touch the Mesh.
+        @param stream
+            The file of the Mesh, opened by the caller.
+        @param flipEndian
+            See MeshLodStreamingInfo::flipEndian.
+        @param chunkOffsets
+            Offset of every LOD to read, ordered [submesh][vao pass][lod].
+        @param outLods
+            The LODs read, in the same order. Pass them to createStreamedLodVaos.
+        */
+        void readStreamedLods( DataStreamPtr &stream, bool flipEndian,
+                               const FastArray<size_t> &chunkOffsets, uint8 firstLod, uint8 endLod,
+                               SubMeshLodVec &outLods );
+
+        /// Creates the Vaos of the LODs read by readStreamedLods into SubMesh::mVao.
+        /// Must be called from the main thread.
+        void createStreamedLodVaos( Mesh *pMesh, SubMeshLodVec &lods, uint8 firstLod, uint8 endLod );
+
+        /// Frees the CPU memory still owned by the given LODs
+        static void freeSubMeshLods( SubMeshLodVec &lods );
+
+    protected:
+        typedef vector<uint8>::type                     LodLevelVertexBufferTable;
+        typedef vector<LodLevelVertexBufferTable>::type LodLevelVertexBufferTableVec;  // One per submesh
+
+        /// Location of a M_SUBMESH_LOD chunk, see scanSubMeshLods
+        struct ScannedLod
+        {
+            size_t offset;
+            size_t size;
+            uint8  lodSource;
+        };
+        typedef vector<ScannedLod>::type ScannedLodVec;
+
+        /// When true, readSubMesh only records where its LODs are (Mesh::msLodStreaming)
+        bool                mScanLods;
+        uint8               mScannedNumVaoPasses;
+        ScannedLodVec       mScannedLods;
+        vector<uint8>::type mScannedNumLods;  // One per submesh
+
+        /// Fills mScannedLods with the M_SUBMESH_LOD chunks of a SubMesh, skipping their data
+        void scanSubMeshLods( DataStreamPtr &stream, uint8 numLodLevels, uint8 numVaoPasses );
+        /// Splits the LODs found by scanSubMeshLods in steps that can be streamed
+        /// separately, and loads the coarsest one (or all LODs if they can't be split).
+        void loadScannedLods( DataStreamPtr &stream, Mesh *pMesh );
+        /// Reads numLods consecutive M_SUBMESH_LOD chunks of a SubMesh, starting at firstLod.
+        /// pMesh is null when called from readStreamedLods.
+        void readSubMeshLods( DataStreamPtr &stream, Mesh *pMesh, const size_t *chunkOffsets,
+                              uint8 firstLod, uint8 numLods, SubMeshLodVec &outLods );
+        /// Like createSubMeshVao, but sm->mVao[casterPass] must already have room
+        /// for LODs [firstLod; firstLod + numLods)
+        void createSubMeshLodVaos( SubMesh *sm, SubMeshLod *submeshLods, uint8 numLods,
+                                   uint8 casterPass, uint8 firstLod );
+
         // Internal methods
         virtual void writeSubMeshNameTable( const Mesh *pMesh );
         virtual void writeMeshHashForCaches( const Mesh *pMesh );
+        virtual void writeMeshClusters( const Mesh *pMesh );
         virtual void writeMesh( const Mesh *pMesh );
         virtual void writeSubMesh( const SubMesh *s, const LodLevelVertexBufferTable &lodVertexTable );
         virtual void writeSubMeshLod( const VertexArrayObject *vao, uint8 lodLevel, uint8 lodSource );
@@ -136,6 +190,7 @@ namespace Ogre
         virtual size_t calcGeometrySize( const VertexBufferPackedVec &vertexData );
         virtual size_t calcVertexDeclSize( const VertexBufferPackedVec &vertexData );
         size_t         calcHashForCachesSize();
+        virtual size_t calcMeshClustersSize( const Mesh *pMesh );
         virtual size_t calcSkeletonLinkSize( const String &skelName );
         virtual size_t calcSubMeshLodOperationSize( const VertexArrayObject *vao );
         virtual size_t calcSubMeshNameTableSize( const Mesh *pMesh );
@@ -157,6 +212,7 @@ namespace Ogre
         virtual void readTextureLayer( DataStreamPtr &stream, Mesh *pMesh, MaterialPtr &pMat );
         virtual void readSubMeshNameTable( DataStreamPtr &stream, Mesh *pMesh );
         virtual void readHashForCaches( DataStreamPtr &stream, Mesh *pMesh );
+        virtual void readMeshClusters( DataStreamPtr &stream, Mesh *pMesh );
         virtual void readMesh( DataStreamPtr &stream, Mesh *pMesh, MeshSerializerListener *listener );
         virtual void readSubMesh( DataStreamPtr &stream, Mesh *pMesh, MeshSerializerListener *listener,
                                   uint8 numVaoPasses );
@@ -62,6 +62,14 @@ namespace Ogre
         M_MESH                = 0x3000,
             // Optional hash data for caches
             M_HASH_FOR_CACHES = 0x3200,
+            // Optional triangle clusters for cluster culling. For each submesh:
+            // uint8 numLodLevels
+            //     For each LOD:
+            //     uint32 numClusters
+            //         For each cluster:
+            //         float center[3], radius, coneAxis[3], coneCos
+            //         uint32 indexStart, indexCount
+            M_MESH_CLUSTERS = 0x3300,
 
             // bool skeletallyAnimated   // --removed in 2.1 (flag was never used!)
             // unsigned char numPasses. // Number of caster passes data. Must be 1 or 2.
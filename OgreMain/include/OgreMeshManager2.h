@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include "OgreResourceManager.h"
 #include "OgreSingleton.h"
 #include "OgreVector3.h"
+#include "OgreWorkQueue.h"
 #include "Vao/OgreBufferPacked.h"
 
 #include "OgreHeaderPrefix.h"
@@ -54,7 +55,9 @@ namespace Ogre
     */
     class _OgreExport MeshManager final : public ResourceManager,
                                           public Singleton<MeshManager>,
-                                          public ManualResourceLoader
+                                          public ManualResourceLoader,
+                                          public WorkQueue::RequestHandler,
+                                          public WorkQueue::ResponseHandler
     {
     protected:
         /// @copydoc ResourceManager::createImpl
@@ -67,6 +70,15 @@ namespace Ogre
         // the factor by which the bounding box of an entity is padded
         Real mBoundsPaddingFactor;
 
+        typedef vector<Mesh *>::type MeshVec;
+        /// Meshes whose LODs are streamed in on demand. See Mesh::msLodStreaming
+        MeshVec mLodStreamingMeshes;
+        size_t  mLodStreamingBudget;
+        size_t  mLodStreamingUsage;
+        uint32  mLodStreamingTicket;
+        /// 0 until the first streamed Mesh registers with the WorkQueue
+        uint16 mWorkQueueChannel;
+
     public:
         MeshManager();
         ~MeshManager() override;
@@ -274,6 +286,32 @@ namespace Ogre
         /** @see ManualResourceLoader::loadResource */
         void loadResource( Resource *res ) override;
 
+        /** Sets how many bytes the streamed-in LODs (see Mesh::msLodStreaming) of all meshes
+            can use. Once exceeded, the finest LODs of the meshes that haven't needed them for
+            the longest get evicted, at the end of the frame.
+            Default is unlimited.
+        */
+        void setLodStreamingBudget( size_t bytes ) { mLodStreamingBudget = bytes; }
+        size_t getLodStreamingBudget() const { return mLodStreamingBudget; }
+
+        /// Bytes used by streamed-in LODs, as of the last _updateLodStreaming.
+        /// The coarsest LODs, which always stay resident, don't count.
+        size_t getLodStreamingUsage() const { return mLodStreamingUsage; }
+
+        void _addLodStreamingMesh( Mesh *mesh );
+        void _removeLodStreamingMesh( Mesh *mesh );
+
+        /** Streams in the LODs of streamed meshes the LodStrategy asked for during this frame,
+            and evicts LODs until we're within budget. Called by Root at the end of the frame.
+        */
+        void _updateLodStreaming();
+
+        /// Reads streamed LODs from disk. See WorkQueue::RequestHandler
+        WorkQueue::Response *handleRequest( const WorkQueue::Request *req,
+                                            const WorkQueue           *srcQ ) override;
+        /// Creates the Vaos of streamed LODs. See WorkQueue::ResponseHandler
+        void handleResponse( const WorkQueue::Response *res, const WorkQueue *srcQ ) override;
+
     protected:
         /** Saved parameters used to (re)build a manual mesh built by this class */
         struct V1MeshImportParams
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 // Precompiler options
+#include "Math/Array/OgreArrayDispatch.h"
 #include "Math/Array/OgreObjectData.h"
 #include "OgreAnimable.h"
 #include "OgreId.h"
@@ -78,7 +79,12 @@ namespace Ogre
         ArrayPlane   planes[6];
 
         ArrayMaskR ignoreRenderingDistance;
-        bool       isShadowMappingCasterPass;
+        /// Camera::CameraSortMode of the frustum
+        uint32 cameraSortMode;
+        bool   isShadowMappingCasterPass;
+        /// When false, cullFrustum won't write to ObjectData::mDistanceToCamera. Needed when
+        /// multiple frustums are culled concurrently, as they would race to write it.
+        bool updateDistanceToCamera;
     };
 
     /** Abstract class defining a movable object in a scene.
@@ -121,6 +127,8 @@ namespace Ogre
         // One for each submesh/Renderable
         FastArray<Real> const *mLodMesh;
         unsigned char          mCurrentMeshLod;
+        /// Non-null when mLodMesh belongs to a Mesh that streams its LODs in on demand
+        LodStreamingState *mLodMeshStreaming;
 
         /// Minimum pixel size to still render
         Real mMinPixelSize;
@@ -236,7 +244,7 @@ namespace Ogre
         /// @see Node::_callMemoryChangeListeners
         virtual void _notifyParentNodeMemoryChanged() {}
 
-        /// Sets mCurrentMeshLod to 0.
+        /// Sets mCurrentMeshLod to 0 (or to the finest resident LOD, see Mesh::msLodStreaming).
         void resetMeshLod();
 
         unsigned char getCurrentMeshLod() const { return mCurrentMeshLod; }
@@ -297,7 +305,8 @@ namespace Ogre
             We don't pass by reference on purpose (avoid implicit aliasing)
             We perform frustum culling AND test visibility mask at the same time
         @param frustum
-            Frustum to clip against
+            Unused. Everything needed from the frustum to clip against (planes, sort mode)
+            was baked into pd by cullFrustumPrepare
         @param sceneVisibilityFlags
             Combined scene's visibility flags (i.e. viewport | scene). Set LAYER_SHADOW_CASTER
             bit if you want to exclude non-shadow casters.
@@ -314,6 +323,19 @@ namespace Ogre
                                  MovableObjectArray            &outCulledObjects,
                                  const CullFrustumPreparedData &pd );
 
+    private:
+        /// Kernel of cullFrustum, instantiated once per ISA. See ArrayDispatch
+        static inline void cullFrustumImpl( const size_t numNodes, ObjectData t,
+                                            MovableObjectArray            &outCulledObjects,
+                                            const CullFrustumPreparedData &pd );
+#if OGRE_ARRAY_DISPATCH_AVX2
+        OGRE_ARRAY_TARGET_AVX2 static void cullFrustumAvx2( const size_t numNodes, ObjectData t,
+                                                            MovableObjectArray &outCulledObjects,
+                                                            const CullFrustumPreparedData &pd );
+#endif
+
+    public:
+
         /// @see InstancingTheadedCullingMethod, @see InstanceBatch::instanceBatchCullFrustumThreaded
         virtual void instanceBatchCullFrustumThreaded( const Frustum *frustum, const Camera *lodCamera,
                                                        uint32 combinedVisibilityFlags )
@@ -539,6 +561,12 @@ namespace Ogre
         /// Returns the distance to camera as calculated in cullFrustum()
         inline Real getCachedDistanceToCameraAsReal() const;
 
+        /** Calculates the distance to camera the same way cullFrustum() does and caches it.
+            For objects that were culled with CullFrustumPreparedData::updateDistanceToCamera
+            set to false.
+        */
+        void _updateCachedDistanceToCamera( const Camera *camera );
+
         /** Sets the visibility flags for this object.
         @remarks
             As well as a simple true/false value for visibility (as seen in setVisible),
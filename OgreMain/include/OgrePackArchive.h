@@ -0,0 +1,237 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgrePackArchive_H_
+#define _OgrePackArchive_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgreArchive.h"
+#include "OgreArchiveFactory.h"
+#include "ogrestd/map.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    class PackFile;
+
+    /** Specialisation of the Archive class for Pack files: a read-only archive format
+        built for streaming from very large files.
+    @remarks
+        Each entry is split in fixed-size blocks (64kb by default) which are compressed
+        independently, and the table of contents stores the location of every block.
+        This means:
+            - Seeking is O(1): only the block containing the new position gets decompressed.
+            - Large entries are decompressed in parallel (see setNumDecompressionThreads).
+            - Every entry can use its own codec (see Codec).
+    @par
+        The pack file is memory-mapped when possible (see MappedFileDataStream), so several
+        threads can open & read entries at the same time without contention. Entries stored
+        uncompressed are then served straight from the mapping (DataStream::getDataPtr).
+    @par
+        Pack files are created with PackArchiveWriter. Layout (native endianness):
+        @code
+            uint32 magic ('OPAK'), uint32 version, uint32 blockSize, uint32 numEntries
+            uint64 tocOffset, uint64 tocSize
+            Compressed blocks
+            TOC at tocOffset. For each entry:
+                uint16 nameLength, char name[nameLength]
+                uint64 uncompressedSize, int64 modifiedTime, uint8 codec
+                { uint64 offset, uint32 compressedSize } per block
+        @endcode
+        A block whose compressedSize equals its uncompressed size is stored as is.
+    */
+    class _OgreExport PackArchive final : public Archive
+    {
+    public:
+        enum Codec
+        {
+            /// Blocks are stored uncompressed
+            CodecStored,
+            /// LZ4 block format. Fast to decompress, lower ratio. Always available
+            CodecLz4,
+            /// zlib (deflate). Slower, higher ratio. Requires OGRE_NO_ZIP_ARCHIVE == 0
+            CodecDeflate,
+            NumCodecs
+        };
+
+    protected:
+        SharedPtr<PackFile> mPackFile;
+        /// Files and (synthesised) folders. Folders have compressedSize = size_t( -1 )
+        FileInfoList mFileList;
+        /// Maps a full filename to its index in PackFile's entries
+        map<String, size_t>::type mEntryLookup;
+
+        static uint32 msNumDecompressionThreads;
+        static size_t msParallelMinSize;
+
+        DataStreamPtr decompressInParallel( size_t entryIdx );
+
+    public:
+        PackArchive( const String &name, const String &archType );
+        ~PackArchive() override;
+
+        /// @copydoc Archive::isCaseSensitive
+        bool isCaseSensitive() const override { return true; }
+
+        /// @copydoc Archive::load
+        void load() override;
+
+        /// @copydoc Archive::unload
+        void unload() override;
+
+        /** @copydoc Archive::open
+        @remarks
+            Returns a seekable stream that decompresses one block at a time.
+            Entries of at least getParallelMinSize() bytes are instead decompressed
+            upfront in parallel and returned as a MemoryDataStream.
+        */
+        DataStreamPtr open( const String &filename, bool readOnly = true ) override;
+
+        /// @copydoc Archive::list
+        StringVectorPtr list( bool recursive = true, bool dirs = false ) override;
+
+        /// @copydoc Archive::listFileInfo
+        FileInfoListPtr listFileInfo( bool recursive = true, bool dirs = false ) override;
+
+        /// @copydoc Archive::find
+        StringVectorPtr find( const String &pattern, bool recursive = true, bool dirs = false ) override;
+
+        /// @copydoc Archive::findFileInfo
+        FileInfoListPtr findFileInfo( const String &pattern, bool recursive = true,
+                                      bool dirs = false ) override;
+
+        /// @copydoc Archive::exists
+        bool exists( const String &filename ) override;
+
+        /// @copydoc Archive::getModifiedTime
+        time_t getModifiedTime( const String &filename ) override;
+
+        /** Sets how many threads (the calling one included) decompress a large entry.
+            0 (default) uses one per logical core. 1 disables parallel decompression.
+        */
+        static void setNumDecompressionThreads( uint32 numThreads )
+        {
+            msNumDecompressionThreads = numThreads;
+        }
+        static uint32 getNumDecompressionThreads() { return msNumDecompressionThreads; }
+
+        /// Sets the minimum uncompressed size in bytes of an entry to be decompressed
+        /// in parallel when opened. Default is 1MB.
+        static void setParallelMinSize( size_t bytes ) { msParallelMinSize = bytes; }
+        static size_t getParallelMinSize() { return msParallelMinSize; }
+    };
+
+    /** Specialisation of ArchiveFactory for Pack files. */
+    class _OgreExport PackArchiveFactory final : public ArchiveFactory
+    {
+    public:
+        ~PackArchiveFactory() override {}
+        /// @copydoc FactoryObj::getType
+        const String &getType() const override;
+        /// @copydoc FactoryObj::createInstance
+        Archive *createInstance( const String &name, bool readOnly ) override
+        {
+            if( !readOnly )
+                return NULL;
+            return OGRE_NEW PackArchive( name, "Pack" );
+        }
+        /// @copydoc FactoryObj::destroyInstance
+        void destroyInstance( Archive *ptr ) override { OGRE_DELETE ptr; }
+    };
+
+    /** Creates Pack files to be read by PackArchive.
+    @code
+        PackArchiveWriter writer( "Media.pack" );
+        writer.addFile( "Models/Robot.mesh", stream, PackArchive::CodecLz4 );
+        writer.finish();
+    @endcode
+    */
+    class _OgreExport PackArchiveWriter : public OgreAllocatedObj
+    {
+    protected:
+        std::ofstream *mFile;
+        String         mFilename;
+        uint32         mBlockSize;
+        uint32         mNumEntries;
+        /// TOC built as entries are added; written by finish
+        vector<uint8>::type mToc;
+        /// Scratch memory for compressing a block
+        vector<uint8>::type mCompressed;
+
+        /// Compresses & writes a block, appending its TOC entry to outBlocksToc
+        void writeBlock( const uint8 *data, size_t size, PackArchive::Codec codec,
+                         vector<uint8>::type &outBlocksToc );
+
+    public:
+        /**
+        @param filename
+            Path to the pack file to create. It gets overwritten if it already exists.
+        @param blockSize
+            Size of each independently compressed block. Smaller blocks make seeking
+            cheaper but compress worse.
+        */
+        PackArchiveWriter( const String &filename, uint32 blockSize = 64u * 1024u );
+        /// Calls finish if it hasn't been called yet
+        ~PackArchiveWriter();
+
+        /** Adds a file to the pack.
+        @param name
+            Full name of the file inside the pack, using '/' as separator.
+        @param data
+            Contents of the file.
+        @param codec
+            How to compress it. Blocks that don't shrink are stored uncompressed.
+        @param modifiedTime
+            What PackArchive::getModifiedTime returns. 0 to use the time of the pack file.
+        */
+        void addFile( const String &name, const void *data, size_t size, PackArchive::Codec codec,
+                      time_t modifiedTime = 0 );
+
+        /// Adds a file to the pack, reading it from the stream one block at a time.
+        void addFile( const String &name, DataStreamPtr &stream, PackArchive::Codec codec,
+                      time_t modifiedTime = 0 );
+
+        /// Writes the table of contents and closes the file. No files can be added after this.
+        void finish();
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
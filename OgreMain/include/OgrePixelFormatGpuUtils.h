@@ -212,6 +212,12 @@ namespace Ogre
 
         static void convertForNormalMapping( TextureBox src, PixelFormatGpu srcFormat, TextureBox dst,
                                              PixelFormatGpu dstFormat );
+        /** Converts between the two formats.
+
+            Compressed formats are encoded / decoded on the CPU via BlockCompression (see
+            BlockCompression::canEncode & canDecode). Compressing is slow; and vertical flipping
+            is not supported when either format is compressed.
+        */
         static void bulkPixelConversion( const TextureBox &src, PixelFormatGpu srcFormat,
                                          TextureBox &dst, PixelFormatGpu dstFormat,
                                          bool verticalFlip = false );
@@ -72,6 +72,12 @@ namespace Ogre
             CPU_FEATURE_FPU         = 1 << 9,
             CPU_FEATURE_PRO         = 1 << 10,
             CPU_FEATURE_HTT         = 1 << 11,
+            CPU_FEATURE_SSE41       = 1 << 15,
+            CPU_FEATURE_SSE42       = 1 << 16,
+            /// AVX, AVX2 & FMA are only reported if the OS also saves the YMM registers.
+            CPU_FEATURE_AVX         = 1 << 17,
+            CPU_FEATURE_AVX2        = 1 << 18,
+            CPU_FEATURE_FMA         = 1 << 19,
 #elif OGRE_CPU == OGRE_CPU_ARM
             CPU_FEATURE_NEON        = 1 << 13,
 #elif OGRE_CPU == OGRE_CPU_MIPS
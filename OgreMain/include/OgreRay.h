@@ -66,6 +66,43 @@ namespace Ogre
         /** Gets the direction of the ray. */
         const Vector3 &getDirection() const { return mDirection; }
 
+        /** Gets 1 / direction, per component. For use with intersectsSlab.
+        @remarks
+            Components of the direction that are zero become +/- infinity, on purpose.
+        */
+        Vector3 getInvDirection() const
+        {
+            return Vector3( Real( 1.0 ) / mDirection.x, Real( 1.0 ) / mDirection.y,
+                            Real( 1.0 ) / mDirection.z );
+        }
+
+        /** Fast ray vs box test (slab test) meant for walking bounding volume hierarchies.
+        @param invDir
+            Must be getInvDirection()
+        @param maxDistance
+            Boxes further away than this, along the ray, are not hit.
+        @return
+            True if the ray hits [vMin; vMax] closer than maxDistance, or starts inside it.
+        */
+        bool intersectsSlab( const Vector3 &invDir, const Vector3 &vMin, const Vector3 &vMax,
+                             Real maxDistance ) const
+        {
+            Real tMin = 0;
+            Real tMax = maxDistance;
+            for( size_t i = 0; i < 3u; ++i )
+            {
+                Real t0 = ( vMin[i] - mOrigin[i] ) * invDir[i];
+                Real t1 = ( vMax[i] - mOrigin[i] ) * invDir[i];
+                if( invDir[i] < Real( 0 ) )
+                    std::swap( t0, t1 );
+                // A ray parallel to the slab gives +/- infinity, or NaN if it starts at
+                // the boundary; the comparisons are written so that NaN is ignored.
+                tMin = t0 > tMin ? t0 : tMin;
+                tMax = t1 < tMax ? t1 : tMax;
+            }
+            return tMin <= tMax;
+        }
+
         /** Gets the position of a point t units along the ray. */
         Vector3 getPoint( Real t ) const { return Vector3( mOrigin + ( mDirection * t ) ); }
 
@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "OgreSharedPtr.h"
 #include "Threading/OgreLightweightMutex.h"
 #include "Threading/OgreSemaphore.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -89,6 +90,8 @@ namespace Ogre
         LightweightMutex     mMutex;
         Semaphore            mSemaphore;
         std::atomic<bool>    mKeepCompiling;
+        /// Next entry in mRequests for updateWarmUpPregenerateThread()
+        std::atomic<size_t>  mNextPregenerateRequest;
 
         bool               mExceptionFound;     // GUARDED_BY( mMutex )
         std::exception_ptr mThreadedException;  // GUARDED_BY( mMutex )
@@ -139,6 +142,20 @@ namespace Ogre
         /// Serial alternative of fireWarmUpParallel() + updateWarmUpThread() for when
         /// RenderSystem::supportsMultithreadedShaderCompilation is false.
         void warmUpSerial( HlmsManager *hlmsManager, const HlmsCache *passCaches );
+
+        /// For when RenderSystem::supportsMultithreadedShaderCompilation is false:
+        /// Runs the Hlms parser in parallel over all the requests gathered via pushWarmUpRequest()
+        /// (see Hlms::_pregenerateStubEntry) so that the following warmUpSerial() only has
+        /// to compile.
+        ///
+        /// It will wait until all threads are done. mRequests is left untouched, unless a
+        /// thread raised an exception: then mRequests & the pregenerated output are cleared
+        /// and the exception is rethrown in this thread.
+        void fireWarmUpPregenerateParallel( SceneManager *sceneManager, HlmsManager *hlmsManager );
+
+        /// The actual work done by fireWarmUpPregenerateParallel().
+        void updateWarmUpPregenerateThread( size_t threadIdx, HlmsManager *hlmsManager,
+                                            const HlmsCache *passCaches );
     };
 
     /** Class to manage the scene object rendering queue.
@@ -169,7 +186,7 @@ namespace Ogre
             200-224: FAST \n
             225-255: V1_FAST
     */
-    class _OgreExport RenderQueue : public OgreAllocatedObj
+    class _OgreExport RenderQueue : public OgreAllocatedObj, public UniformScalableTask
     {
     public:
         enum Modes
@@ -206,16 +223,41 @@ namespace Ogre
             DisableSort,
             NormalSort,
             StableSort,
+            /// Exploits temporal coherence across frames. The sorted order from the previous
+            /// frame is kept per camera (and per caster/non-caster pass), applied to the new
+            /// frame's renderables and then repaired with an insertion sort.
+            /// If the order changed too much (or there are fewer renderables than last frame)
+            /// it falls back to a full sort.
+            ///
+            /// Works best when the camera and the scene don't change dramatically from one
+            /// frame to the next. The resulting order is the same as StableSort's.
+            CoherentSort,
         };
 
-    private:
         typedef FastArray<QueuedRenderable> QueuedRenderableArray;
 
+        struct CoherentSortKey
+        {
+            uint64 hash;
+            uint32 idx;
+
+            bool operator<( const CoherentSortKey &_r ) const
+            {
+                return this->hash < _r.hash || ( this->hash == _r.hash && this->idx < _r.idx );
+            }
+        };
+        typedef FastArray<CoherentSortKey> CoherentSortKeyArray;
+
+    private:
         struct ThreadRenderQueue
         {
             QueuedRenderableArray q;
+            /// Sum of Renderable::getMaxExtraClusterDraws of q. See setClusterCulling
+            size_t numExtraClusterDraws;
             /// The padding prevents false cache sharing when multithreading.
             uint8 padding[128];
+
+            ThreadRenderQueue() : numExtraClusterDraws( 0u ) {}
         };
 
         typedef FastArray<ThreadRenderQueue> QueuedRenderableArrayPerThread;
@@ -226,10 +268,34 @@ namespace Ogre
             QueuedRenderableArray          mQueuedRenderables;
             RqSortMode                     mSortMode;
             bool                           mSorted;
-            Modes                          mMode;
+            /// When true, each mQueuedRenderablesPerThread[i] is being (or has been) sorted
+            /// by the worker threads and only needs to be merged.
+            bool  mSortPerThread;
+            Modes mMode;
+
+            RenderQueueGroup() :
+                mSortMode( NormalSort ),
+                mSorted( false ),
+                mSortPerThread( false ),
+                mMode( FAST )
+            {
+            }
+        };
 
-            RenderQueueGroup() : mSortMode( NormalSort ), mSorted( false ), mMode( FAST ) {}
+        /// Sorted order from the last time a RQ was rendered by a given camera.
+        struct CoherentSortEntry
+        {
+            Camera const *camera;
+            uint8         rqId;
+            bool          casterPass;
+            /// Frame in which this entry was last used. Entries that go unused
+            /// are purged in frameEnded().
+            uint32 lastFrame;
+            /// order[i] = Index in the merged (unsorted) mQueuedRenderables that
+            /// ended up in position i after sorting.
+            vector<uint32>::type order;
         };
+        typedef vector<CoherentSortEntry>::type CoherentSortEntryVec;
 
         typedef vector<IndirectBufferPacked *>::type IndirectBufferPackedVec;
 
@@ -270,6 +336,20 @@ namespace Ogre
 
         ParallelHlmsCompileQueue mParallelHlmsCompileQueue;
 
+        /// Scratch memory for sorting (radix sort, merge and coherent sort's gather).
+        QueuedRenderableArray mSortScratch;
+        FastArray<size_t>     mSortRunOffsets;
+        CoherentSortKeyArray  mCoherentSortKeys;
+        CoherentSortEntryVec  mCoherentSortCache;
+        uint32                mFrameCount;
+        size_t                mParallelSortThreshold;
+        uint8                 mParallelSortFirstRq;
+        uint8                 mParallelSortLastRq;
+
+        bool mClusterCulling;
+        /// Scratch memory for the visible (indexStart, indexCount) ranges of a Renderable
+        FastArray<uint32> mClusterRanges;
+
         /** Returns a new (or an existing) indirect buffer that can hold the requested number of
         draws.
         @param numDraws
@@ -306,7 +386,53 @@ namespace Ogre
 
         void warmUpShaders( bool casterPass, const RenderQueueGroup &renderQueueGroup );
 
+        /** Merges the per-thread queues of all RQs in range [firstRq; lastRq) into
+            mQueuedRenderables and sorts them according to their RqSortMode.
+
+            RQs with lots of renderables get each of their per-thread queues sorted in
+            parallel by the worker threads and the results are merged afterwards.
+        @remarks
+            Must be called before ParallelHlmsCompileQueue::start, as the worker threads
+            are occupied afterwards.
+        */
+        void sortRenderQueues( uint8 firstRq, uint8 lastRq, bool casterPass );
+
+        /// Merges the (already sorted) per-thread queues into renderQueueGroup.mQueuedRenderables
+        void mergeSortedPerThreadQueues( RenderQueueGroup &renderQueueGroup );
+
+        /// Sorts renderQueueGroup.mQueuedRenderables using the order from the previous frame
+        /// as starting point. See CoherentSort.
+        void coherentSort( RenderQueueGroup &renderQueueGroup, uint8 rqId, const Camera *camera,
+                           bool casterPass );
+
     public:
+        /// Stable LSD radix sort on the 64-bit hash. Produces the same result as std::stable_sort.
+        static void _radixSort( QueuedRenderableArray &inOut, QueuedRenderableArray &scratch );
+
+        /** Merges consecutive sorted runs of inOut into a single sorted array. Stable: on ties,
+            earlier runs go first. Produces the same result as std::stable_sort.
+        @param inOutRunOffsets
+            Start of each run, plus inOut.size() at the end. Gets overwritten.
+        @param scratch
+            Scratch memory. May be swapped with inOut.
+        */
+        static void _mergeSortedRuns( QueuedRenderableArray &inOut, FastArray<size_t> &inOutRunOffsets,
+                                      QueuedRenderableArray &scratch );
+
+        /** Sorts inOut using the order of the previous call as starting point (CoherentSort).
+            Produces the same result as std::stable_sort.
+        @param inOutOrder
+            The order from the previous call (empty the first time). As output,
+            the order of this call: inOutOrder[i] = index in the unsorted inOut that
+            ended up in position i.
+        @param keys
+            Scratch memory.
+        @param scratch
+            Scratch memory. May be swapped with inOut.
+        */
+        static void _coherentSort( QueuedRenderableArray &inOut, vector<uint32>::type &inOutOrder,
+                                   CoherentSortKeyArray &keys, QueuedRenderableArray &scratch );
+
         RenderQueue( HlmsManager *hlmsManager, SceneManager *sceneManager, VaoManager *vaoManager );
         ~RenderQueue();
 
@@ -386,8 +512,13 @@ namespace Ogre
 
         void _warmUpShadersThread( size_t threadIdx );
 
+        void _warmUpShadersPregenerateThread( size_t threadIdx );
+
         void _compileShadersThread( size_t threadIdx );
 
+        /// Sorts the per-thread queues in parallel. See sortRenderQueues. @see UniformScalableTask
+        void execute( size_t threadId, size_t numThreads ) override;
+
         /// Don't call this too often. Only renders v1 objects at the moment.
         void renderSingleObject( Renderable *pRend, const MovableObject *pMovableObject,
                                  RenderSystem *rs, bool casterPass, bool dualParaboloid );
@@ -407,14 +538,45 @@ namespace Ogre
         /** Sets whether we should sort the render queue ID every frame.
         @param rqId
             ID of the render queue
-        @param bSort
-            When false, the render queue group won't be sorted. Useful when the RQ
+        @param sortMode
+            When DisableSort, the render queue group won't be sorted. Useful when the RQ
             needs to be drawn exactly in the order that Renderables were added,
             or when you have a deep CPU bottleneck where the time taken to
             sort hurts more than it is supposed to help.
+            CoherentSort is usually the cheapest option when the scene is mostly
+            static from one frame to the next. See RqSortMode.
         */
         void       setSortRenderQueue( uint8 rqId, RqSortMode sortMode );
         RqSortMode getSortRenderQueue( uint8 rqId ) const;
+
+        /** Sets the minimum number of renderables a render queue ID must have in order to
+            sort each thread's queue in parallel using the worker threads, and then merge them.
+            Only applies to NormalSort and StableSort.
+        @remarks
+            Parallel sorting has a fixed cost of waking up the worker threads; which is
+            not worth it for small queues.
+            Use std::numeric_limits<size_t>::max() to disable parallel sorting.
+        @param threshold
+            Minimum number of renderables. Default is 4096.
+        */
+        void   setParallelSortThreshold( size_t threshold );
+        size_t getParallelSortThreshold() const { return mParallelSortThreshold; }
+
+        /** Culls the triangle clusters of Renderables in FAST render queues against the
+            camera before drawing them (see SubMesh::buildClusters). Each range of
+            consecutive visible clusters becomes a draw in the indirect buffer.
+        @remarks
+            Only affects Renderables whose mesh LOD has clusters, and isn't applied to
+            shadow caster passes, dual paraboloid passes nor instanced stereo.
+            Back-facing clusters are only culled for materials with CULL_CLOCKWISE.
+            Clustered Renderables don't get instanced with other Renderables of the same mesh.
+        @par
+            It's worth it for large meshes which are often only partially visible
+            (i.e. terrain-like meshes, buildings, interiors).
+            Disabled by default.
+        */
+        void setClusterCulling( bool bEnabled ) { mClusterCulling = bEnabled; }
+        bool getClusterCulling() const { return mClusterCulling; }
     };
 
 #define OGRE_RQ_MAKE_MASK( x ) ( ( 1 << ( x ) ) - 1 )
@@ -45,6 +45,8 @@ THE SOFTWARE.
 namespace Ogre
 {
     typedef FastArray<VertexArrayObject *> VertexArrayObjectArray;
+    struct MeshCluster;
+    typedef FastArray<MeshCluster> MeshClusterArray;
     class GpuProgramParameters_AutoConstantEntry;
 
     /** \addtogroup Core
@@ -408,6 +410,18 @@ namespace Ogre
             return mVaoPerLod[vertexPass];
         }
 
+        /** Clusters of the given mesh LOD for cluster culling (see SubMesh::buildClusters).
+            Null if that LOD has none.
+        @remarks
+            Also null if we have skeletal animation or poses: the clusters' bounds and
+            normal cones are those of the bind pose, which animated vertices can leave.
+        */
+        const MeshClusterArray *getMeshClusters( uint8 meshLod ) const;
+
+        /// Upper bound of the draws cluster culling may add for us on top of the regular one,
+        /// for any LOD. See SubMesh::getMaxExtraClusterDraws. 0 if getMeshClusters is null.
+        uint32 getMaxExtraClusterDraws() const;
+
         uint32         getHlmsHash() const { return mHlmsHash; }
         uint32         getHlmsCasterHash() const { return mHlmsCasterHash; }
         HlmsDatablock *getDatablock() const { return mHlmsDatablock; }
@@ -488,6 +502,8 @@ namespace Ogre
         /// But if they're not exactly the same VertexArrayObject pointers,
         /// then they won't share any pointer.
         VertexArrayObjectArray mVaoPerLod[NumVertexPass];
+        /// Has the clusters of each LOD in mVaoPerLod[VpNormal]. May be null.
+        SubMesh const *mClusteredSubMesh;
         uint32                 mHlmsHash;
         uint32                 mHlmsCasterHash;
         HlmsDatablock         *mHlmsDatablock;
@@ -53,6 +53,8 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    struct ScriptParseJobs;
+
     /** \addtogroup Core
      *  @{
      */
@@ -305,6 +307,9 @@ namespace Ogre
 
         ResourceLoadingListener *mLoadingListener;
 
+        /// See setNumScriptParsingThreads
+        uint32 mNumScriptParsingThreads;
+
         /// Resource index entry, resourcename->location
         typedef map<String, Archive *>::type ResourceLocationIndex;
 
@@ -360,6 +365,13 @@ namespace Ogre
             Called as part of initialiseResourceGroup
         */
         void parseResourceGroupScripts( ResourceGroup *grp );
+        /** Prepares the given scripts on numThreads threads, then parses them in order.
+        @remarks
+            Called as part of parseResourceGroupScripts. scriptParseStarted must have been
+            fired for all of them already. Empties scriptJobs.
+        */
+        void parseScriptBatch( ScriptParseJobs &scriptJobs, uint32 numThreads,
+                               const String &groupName );
         /** Create all the pre-declared resources.
         @remarks
             Called as part of initialiseResourceGroup
@@ -1019,6 +1031,23 @@ namespace Ogre
         /// Returns the current loading listener
         ResourceLoadingListener *getLoadingListener();
 
+        /** Sets how many threads (the calling one included) prepare the scripts of a group
+            when it gets initialised. See ScriptLoader::prepareScript.
+        @remarks
+            Only lexing & parsing runs in parallel, and only for loaders that
+            supportsPrepareScript. Resources are still created one script at a time on
+            the calling thread, in the same order as when parsing serially.
+            Scripts are prepared in batches: ResourceGroupListener::scriptParseStarted is
+            fired for every script of a batch before any of them gets parsed.
+        @param numThreads
+            0 (default) uses one per logical core. 1 prepares everything on the calling thread.
+        */
+        void setNumScriptParsingThreads( uint32 numThreads )
+        {
+            mNumScriptParsingThreads = numThreads;
+        }
+        uint32 getNumScriptParsingThreads() const { return mNumScriptParsingThreads; }
+
         /** Override standard Singleton retrieval.
         @remarks
         Why do we do this? Well, it's because the Singleton
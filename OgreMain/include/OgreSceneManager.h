@@ -48,6 +48,7 @@ Torus Knot Software Ltd.
 #include "OgreResourceGroupManager.h"
 #include "OgreSceneQuery.h"
 #include "Threading/OgreThreads.h"
+#include "Threading/OgreWorkStealingRange.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -73,6 +74,7 @@ namespace Ogre
     typedef FastArray<VisibleObjectsPerRq>               VisibleObjectsPerThreadArray;
 
     // Forward declarations
+    class DefaultBatchRaySceneQuery;
     class DefaultIntersectionSceneQuery;
     class DefaultRaySceneQuery;
     class DefaultSphereSceneQuery;
@@ -83,6 +85,8 @@ namespace Ogre
     struct EntityMaterialLodChangedEvent;
     class CompositorShadowNode;
     class UniformScalableTask;
+    class ArrayAabb;
+    class TriangleBvh;
 
     class RadialDensityMask;
 
@@ -157,15 +161,14 @@ namespace Ogre
     struct UpdateTransformRequest
     {
         Transform t;
-        /// Number of nodes to process for each thread. Must be multiple of ARRAY_PACKED_REALS
-        size_t numNodesPerThread;
+        /// Threads grab chunks (multiple of ARRAY_PACKED_REALS) of these nodes
+        /// via SceneManager::mWorkStealingRange
         size_t numTotalNodes;
 
-        UpdateTransformRequest() : numNodesPerThread( 0 ), numTotalNodes( 0 ) {}
+        UpdateTransformRequest() : numTotalNodes( 0 ) {}
 
-        UpdateTransformRequest( const Transform &_t, size_t _numNodesPerThread, size_t _numTotalNodes ) :
+        UpdateTransformRequest( const Transform &_t, size_t _numTotalNodes ) :
             t( _t ),
-            numNodesPerThread( _numNodesPerThread ),
             numTotalNodes( _numTotalNodes )
         {
         }
@@ -810,8 +813,11 @@ namespace Ogre
             BUILD_LIGHT_LIST02,
             WARM_UP_SHADERS,
             WARM_UP_SHADERS_COMPILE,
+            WARM_UP_SHADERS_PREGENERATE,
             PARALLEL_HLMS_COMPILE,
             PARTICLE_SYSTEM_MANAGER2,
+            PRE_CULL_FRUSTUMS,
+            ADD_PRE_CULLED_TO_RENDER_QUEUE,
             USER_UNIFORM_SCALABLE_TASK,
             STOP_THREADS,
             NUM_REQUESTS
@@ -832,6 +838,90 @@ namespace Ogre
         Barrier                      *mWorkerThreadsBarrier;
         ThreadHandleVec               mWorkerThreads;
 
+        /// A (ObjectMemoryManager, render queue) pair with objects to be processed by the
+        /// current request. See prepareObjectWork.
+        struct ObjectWorkSegment
+        {
+            ObjectMemoryManager *memoryManager;
+            size_t               rqId;
+            /// Where this segment starts in mWorkStealingRange. Multiple of ARRAY_PACKED_REALS.
+            size_t start;
+            size_t numObjs;
+            /// See appendObjectWork
+            size_t requestIdx;
+            /// When not c_noPackList, the segment only covers the packs (ARRAY_PACKED_REALS
+            /// objects) listed in mObjectWorkPacks starting at this index, which the spatial
+            /// index of memoryManager didn't cull. numObjs is then numPacks * ARRAY_PACKED_REALS.
+            size_t firstPack;
+            /// Total objects in the render queue (needed for the last pack)
+            size_t rqNumObjs;
+
+            bool operator<( size_t _start ) const { return this->start < _start; }
+        };
+        typedef FastArray<ObjectWorkSegment> ObjectWorkSegmentArray;
+
+        /// Per-thread state of acquireObjectWork
+        struct ObjectWorkCursor
+        {
+            size_t start;
+            size_t count;
+            size_t segmentIdx;
+            /// Request the last batch returned by acquireObjectWork belongs to
+            size_t requestIdx;
+
+            ObjectWorkCursor() : start( 0 ), count( 0 ), segmentIdx( 0 ), requestIdx( 0 ) {}
+        };
+
+        /// Balances the work of the request being executed by the worker threads
+        /// (nodes, objects) so that threads which finish early steal from the others
+        /// instead of waiting on mWorkerThreadsBarrier.
+        WorkStealingRange      mWorkStealingRange;
+        ObjectWorkSegmentArray mObjectWorkSegments;
+        /// Packs that survived the spatial indices. See ObjectWorkSegment::firstPack
+        FastArray<uint32> mObjectWorkPacks;
+        static const size_t c_noPackList;
+
+        /// A frustum culled ahead of time by _flushPreCullFrustums. See setConcurrentCullingEnabled
+        struct PreCulledFrustum
+        {
+            /// firstRq & lastRq are already clamped to the range of RQs in use
+            CullFrustumRequest request;
+            /// Combined (viewport & scene) visibility mask the objects were culled with
+            uint32 visibilityMask;
+            /// State of the cameras at the time of culling. If they've changed by the time
+            /// the pass wants the results, they are discarded and the pass culls again.
+            Plane   planes[6];
+            Vector3 lodCameraPos;
+            bool    lodUseRenderingDistance;
+            bool    consumed;
+            /// Sum of ObjectMemoryManager::getLayoutRevision at the time of culling
+            uint32 layoutRevision;
+            /// Per-thread results. Swapped with mVisibleObjects when consumed.
+            VisibleObjectsPerThreadArray visibleObjects;
+
+            PreCulledFrustum() :
+                visibilityMask( 0 ),
+                lodCameraPos( Vector3::ZERO ),
+                lodUseRenderingDistance( true ),
+                consumed( true ),
+                layoutRevision( 0 )
+            {
+            }
+        };
+        typedef vector<PreCulledFrustum>::type PreCulledFrustumVec;
+
+        bool mConcurrentCullingEnabled;
+        /// Only the first mNumPreCulledFrustums entries are in use this frame. The rest are
+        /// kept around so that their per-thread buffers don't need to be reallocated.
+        PreCulledFrustumVec mPreCulledFrustums;
+        size_t              mNumPreCulledFrustums;
+        /// Entries in range [mFirstPendingPreCull; mNumPreCulledFrustums) haven't been culled yet
+        size_t                   mFirstPendingPreCull;
+        CullFrustumPreparedData *mPreCullPreparedData;
+        size_t                   mPreCullPreparedDataCapacity;
+        /// Entry being consumed by ADD_PRE_CULLED_TO_RENDER_QUEUE
+        PreCulledFrustum *mCurrentPreCulledFrustum;
+
         /** Contains MovableObjects to be visited and rendered.
         @rermarks
             Declared here to avoid allocating and deallocating every frame. Declared as array of
@@ -943,6 +1033,43 @@ namespace Ogre
         */
         void cullFrustum( const CullFrustumRequest &request, size_t threadIdx );
 
+        /// Adds the Renderables of the given v2 objects to the render queue. See cullFrustum
+        void addToRenderQueueV2( const MovableObject::MovableObjectArray &visibleObjects, uint8 rqId,
+                                 bool casterPass, size_t threadIdx );
+
+        /// Adds ParticleSystemManager2's particles in the request's RQs. See cullFrustum
+        void addParticleSystems2ToRenderQueue( const CullFrustumRequest &request,
+                                               uint32 visibilityMask, size_t threadIdx );
+
+        /// Culls all pending frustums queued via _queuePreCullFrustum. See _flushPreCullFrustums
+        void preCullFrustumsThread( size_t threadIdx );
+
+        /// Forgets every frustum queued or culled ahead of time. Their results can't be trusted
+        /// anymore once the frame is over or the scene graph got updated.
+        void clearPreCulledFrustums();
+
+        /// The second half of cullFrustum(), for a frustum culled by preCullFrustumsThread:
+        /// hands the results over to mVisibleObjects and adds v2 objects to the render queue.
+        void addPreCulledToRenderQueueThread( PreCulledFrustum &preCulled, size_t threadIdx );
+
+        /** Looks for pre-culled results matching the given request and, if they're still valid,
+            uses them instead of culling again.
+        @return
+            False if there were no valid results. The caller must cull normally.
+        */
+        bool consumePreCulledFrustum( const CullFrustumRequest &request );
+
+        /// Clamps [firstRq; lastRq) to the range of render queues that are actually in use
+        void getRealRenderQueueRange( uint8 firstRq, uint8 lastRq, uint8 &outRealFirstRq,
+                                      uint8 &outRealLastRq ) const;
+
+        /// Combines the viewport's visibility mask with ours, the way cullFrustum does
+        uint32 getCombinedVisibilityMask( uint32 viewportVisibilityMask ) const
+        {
+            return ( viewportVisibilityMask & mVisibilityMask ) |
+                   ( viewportVisibilityMask & ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS );
+        }
+
         /** Builds a list of all lights that are visible by all queued cameras (this should be fed by
             Compositor). Then calls MovableObject::buildLightList with that list so that each
             MovableObject gets it's own sorted list of the closest lights.
@@ -964,6 +1091,51 @@ namespace Ogre
         */
         void warmUpShaders( const CullFrustumRequest &request, size_t threadIdx );
 
+        /** Flattens all the objects from the given memory managers in render queues
+            [firstRq; lastRq) into mObjectWorkSegments and sets up mWorkStealingRange
+            so that worker threads can retrieve them via acquireObjectWork.
+        @remarks
+            Must be called from the main thread, before firing the worker threads.
+        @param cullCamera
+            When not null, render queues with a spatial index (see
+            ObjectMemoryManager::setSpatialIndexEnabled) only include the objects that
+            may be inside this camera's frustum. Its frustum planes must be up to date.
+        */
+        void prepareObjectWork( const ObjectMemoryManagerVec &objectMemManager, size_t firstRq,
+                                size_t lastRq, const Camera *cullCamera = 0 );
+
+        /** Like prepareObjectWork, but appends to mObjectWorkSegments instead of replacing it.
+            Used to process the objects of multiple requests in the same dispatch.
+            The caller must reset mWorkStealingRange once done appending.
+        @param requestIdx
+            Arbitrary index, returned in ObjectWorkCursor::requestIdx.
+        @param totalObjs
+            Value returned by the previous call. 0 for the first call.
+        @return
+            The total number of objects to process (padding included).
+        */
+        size_t appendObjectWork( const ObjectMemoryManagerVec &objectMemManager, size_t firstRq,
+                                 size_t lastRq, size_t requestIdx, size_t totalObjs,
+                                 const Camera *cullCamera = 0 );
+
+        /** Retrieves the next batch of objects to process by the calling thread.
+            Batches never straddle multiple render queues.
+        @param threadIdx
+            Unique index of the worker thread.
+        @param cursor [in/out]
+            Per-thread state. Must be default-constructed before the first call.
+        @param outObjData [out]
+            ObjectData pointing at the first object of the batch.
+        @param outNumObjs [out]
+            Number of objects in the batch.
+        @param outRqId [out]
+            Render queue the objects belong to.
+        @return
+            False when there's no more work.
+        */
+        bool acquireObjectWork( size_t threadIdx, ObjectWorkCursor &cursor, ObjectData &outObjData,
+                                size_t &outNumObjs, size_t &outRqId );
+
     public:
         /** Constructor.
          */
@@ -1013,6 +1185,71 @@ namespace Ogre
 
         size_t getNumWorkerThreads() const { return mNumWorkerThreads; }
 
+        /** Worker threads load balance node updates, bounds updates, LOD updates, frustum
+            culling and per-object light lists: each thread processes its share in chunks and,
+            when done, steals chunks from the threads that are lagging behind.
+
+            When disabled, each thread processes exactly its own contiguous share of the
+            whole phase. This makes the order in which v1 objects and Renderables from
+            RQs with RqSortMode::DisableSort are added to the render queue deterministic.
+        @remarks
+            This is not the split older versions used. Back then every render queue was split
+            across all threads; now the objects of all render queues (and all
+            ObjectMemoryManagers) are laid out back to back and that range is split instead.
+            Thus with stealing disabled, a thread may get entire render queues while another
+            thread gets none of their objects. The resulting order is still deterministic,
+            but it is not the same as older versions.
+        @param bEnabled
+            True to enable work stealing. Default is true.
+        */
+        void setWorkStealingEnabled( bool bEnabled );
+        bool getWorkStealingEnabled() const { return mWorkStealingRange.getStealingEnabled(); }
+
+        /** When enabled, a scene pass that updates its shadow node culls its own camera and
+            the cameras of all the shadow node's scene passes (e.g. every PSSM split) in a
+            single dispatch to the worker threads, instead of one dispatch per camera.
+            Each pass later picks up its results without culling again.
+        @remarks
+            Results are validated before being used: if a listener modified the camera, the
+            LOD camera or the visibility mask in the meantime, or objects were created or
+            destroyed, the pass culls again.
+        @par
+            Objects are culled by _flushPreCullFrustums, not when queued. Changes to visibility
+            flags, setVisible or attachments made between _flushPreCullFrustums and the pass
+            aren't seen, and aren't detected either: the pass uses the old results. Node
+            transforms don't matter, since world bounds only get updated by updateSceneGraph.
+        @param bEnabled
+            True to enable. Default is false.
+        */
+        void setConcurrentCullingEnabled( bool bEnabled );
+        bool getConcurrentCullingEnabled() const { return mConcurrentCullingEnabled; }
+
+        /** Queues the given camera to be culled on the next _flushPreCullFrustums.
+            Its results will be used by the next _cullPhase01 with matching arguments.
+            Does nothing if concurrent culling is disabled.
+        @remarks
+            The render stage (i.e. whether this is a shadow caster pass) is taken from
+            _getCurrentRenderStage, thus it must be the same as when the pass executes.
+        @param viewportVisibilityMask
+            Visibility mask the viewport will have when the pass executes.
+        */
+        void _queuePreCullFrustum( const Camera *camera, const Camera *lodCamera, uint8 firstRq,
+                                   uint8 lastRq, uint32 viewportVisibilityMask );
+
+        /// Culls all frustums queued via _queuePreCullFrustum at once.
+        void _flushPreCullFrustums();
+
+        /// Results of the last _cullPhase01 for objects in non-FAST render queues, per thread.
+        const VisibleObjectsPerThreadArray &_getVisibleObjects() const { return mVisibleObjects; }
+
+        /// Number of frustums queued via _queuePreCullFrustum this frame (culled or not).
+        size_t _getNumPreCulledFrustums() const { return mNumPreCulledFrustums; }
+        /// Number of frustums queued via _queuePreCullFrustum waiting for _flushPreCullFrustums.
+        size_t _getNumPendingPreCullFrustums() const
+        {
+            return mNumPreCulledFrustums - mFirstPendingPreCull;
+        }
+
         /// Finds all the movable objects with the type and name passed as parameters.
         virtual MovableObjectVec findMovableObjects( const String &type, const String &name );
 
@@ -1366,6 +1603,11 @@ namespace Ogre
         {
             return mEntityMemoryManager[sceneType];
         }
+
+        /// Returns the manager of the skeleton instances created with createSkeletonInstance,
+        /// e.g. to tweak its pose sharing tolerances.
+        SkeletonAnimManager &_getSkeletonAnimManager() { return mSkeletonAnimationManager; }
+
         ObjectMemoryManager &_getLightMemoryManager() { return mLightMemoryManager; }
 
         ObjectMemoryManager &_getParticleSysDefMemoryManager() { return mParticleSysDefMemoryManager; }
@@ -1985,6 +2227,7 @@ namespace Ogre
         void _warmUpShadersTrigger();
 
         void _fireWarmUpShadersCompile();
+        void _fireWarmUpShadersPregenerate();
 
         void _fireParallelHlmsCompile();
         void waitForParallelHlmsCompile();
@@ -2307,6 +2550,17 @@ namespace Ogre
         */
         virtual IntersectionSceneQuery *createIntersectionQuery(
             uint32 mask = QUERY_ENTITY_DEFAULT_MASK );
+        /** Creates a BatchRaySceneQuery for this scene manager.
+        @remarks
+            This method creates a new instance of a query object for casting many rays
+            at once, returning the closest hit of each. See BatchRaySceneQuery for details.
+        @par
+            The instance returned from this method must be destroyed by calling
+            SceneManager::destroyQuery when it is no longer required.
+        @param mask The query mask to apply to this query; can be used to filter out
+            certain objects; see SceneQuery for details.
+        */
+        virtual BatchRaySceneQuery *createBatchRayQuery( uint32 mask = QUERY_ENTITY_DEFAULT_MASK );
 
         /** Destroys a scene query of any type. */
         virtual void destroyQuery( SceneQuery *query );
@@ -2738,15 +2992,164 @@ namespace Ogre
         inline bool updateWorkerThreadImpl( size_t threadIdx );
     };
 
-    /** Default implementation of IntersectionSceneQuery. */
+    /** Default implementation of IntersectionSceneQuery.
+    @remarks
+        Sort & sweep broadphase over ObjectData::mWorldAabb of every object that passes the
+        query mask and is inside [mFirstRq; mLastRq). Objects are sorted along the axis where
+        they're most spread out, and each one is tested against the following ones (whose
+        minimum along that axis is below its maximum) in groups of ARRAY_PACKED_REALS.
+    @par
+        The sorted order of the previous execution is kept and used as the starting point of
+        the next one. When objects move little between frames, sorting becomes almost O(N).
+        Large scenes are swept in the SceneManager worker threads; thus don't execute this
+        query while they're busy (i.e. from inside a UniformScalableTask).
+    @par
+        Results are reported from the calling thread, and always in the same order for
+        the same scene.
+    */
     class _OgreExport DefaultIntersectionSceneQuery : public IntersectionSceneQuery
     {
+    public:
+        struct Proxy
+        {
+            /// Minimum & maximum along the sweep axis
+            Real minKey;
+            Real maxKey;
+            /// Position in the sorted list during the previous execution. Only a hint
+            uint32 prevRank;
+            /// Where to store the sorted position for the next execution
+            uint32 *rank;
+
+            MovableObject *owner;
+            Aabb           aabb;
+        };
+
+        /// Pairs found by a thread in one chunk of the sorted list
+        struct ChunkResult
+        {
+            /// First proxy of the chunk in mProxies
+            size_t firstProxy;
+            size_t threadIdx;
+            /// Range in mThreadPairs[threadIdx]
+            size_t start;
+            size_t end;
+
+            bool operator<( const ChunkResult &other ) const
+            {
+                return this->firstProxy < other.firstProxy;
+            }
+        };
+
+        /// Below this many proxies, the sweep runs in the calling thread
+        static const size_t c_minProxiesForThreads;
+
+    protected:
+        /// Proxies sorted by minKey.
+        FastArray<Proxy> mProxies;
+        FastArray<Proxy> mTmpProxies;
+        FastArray<uint32> mRankCounts;
+        /// Number of proxies in the previous execution
+        size_t mNumPrevProxies;
+        uint32 mSweepAxis;
+
+        /// Same as mProxies' Aabbs, in SoA. Padded to ARRAY_PACKED_REALS
+        RawSimdUniquePtr<ArrayAabb, MEMCATEGORY_SCENE_OBJECTS> mSortedAabbs;
+
+        /// Per memory manager type & render queue, the sorted position
+        /// of the object in each slot during the previous execution
+        vector<FastArray<uint32> >::type mPrevRanks[NUM_SCENE_MEMORY_MANAGER_TYPES];
+
+        /// Pair of objects (2 entries per pair) found by each thread
+        vector<FastArray<MovableObject *> >::type mThreadPairs;
+        vector<FastArray<ChunkResult> >::type     mThreadChunks;
+        WorkStealingRange                          mWorkRange;
+
+        void gatherProxies( Vector3 &outCenterSum, Vector3 &outCenterSqSum );
+        void sortProxies( bool useRankHints );
+        void prepareSortedAabbs();
+
     public:
         DefaultIntersectionSceneQuery( SceneManager *creator );
         ~DefaultIntersectionSceneQuery() override;
 
         /** See IntersectionSceneQuery. */
         void execute( IntersectionSceneQueryListener *listener ) override;
+
+        /// Sweeps the chunks of the sorted list acquired by the given thread.
+        /// Called from worker threads.
+        void _sweepThread( size_t threadIdx );
+
+    private:
+        using IntersectionSceneQuery::execute;  // Shut up compiler warnings
+    };
+
+    /** Default implementation of BatchRaySceneQuery.
+    @remarks
+        Rays are grouped in packets of ARRAY_PACKED_REALS, and each packet traverses the
+        objects once: through the ObjectSpatialIndex of the render queue when there is one,
+        or testing every object otherwise. Batches of at least c_minRaysForThreads rays are
+        split across the SceneManager worker threads; thus don't execute this query while
+        they're busy (i.e. from inside a UniformScalableTask).
+    @par
+        The triangle BVHs of the Meshes are built (or rebuilt after their LOD changes) by
+        execute, from the calling thread, before any ray is cast.
+    */
+    class _OgreExport DefaultBatchRaySceneQuery : public BatchRaySceneQuery
+    {
+    public:
+        /// Objects of one render queue of one memory manager
+        struct QueryRange
+        {
+            ObjectData                objData;
+            size_t                    numObjects;
+            const ObjectSpatialIndex *spatialIndex;
+            /// Offset of this range's slots in mObjectStates
+            size_t firstSlot;
+        };
+
+        /// What's needed to refine hits against an Item down to triangles
+        struct RefineData
+        {
+            /// Inverse of the Item's world transform
+            Matrix4            invWorld;
+            const TriangleBvh *bvh;
+            Mesh              *mesh;
+        };
+
+        /// Objects that don't pass the query & visibility masks
+        static const uint32 c_objectRejected;
+        /// Objects whose hits are reported at their bounding box
+        static const uint32 c_objectNoRefine;
+
+        /// Below this many rays, they're cast in the calling thread
+        static const size_t c_minRaysForThreads;
+
+    protected:
+        FastArray<QueryRange> mRanges;
+        /// Per object slot of every range: c_objectRejected, c_objectNoRefine,
+        /// or an index to mRefineData
+        FastArray<uint32>     mObjectStates;
+        FastArray<RefineData> mRefineData;
+        WorkStealingRange     mWorkRange;
+
+        void gatherRanges();
+        /// Reports the hits of the rays in rayMask against an object, if closer than their
+        /// best so far (refining them to triangles if needed). tMin is where they enter its Aabb
+        void hitObject( const QueryRange &range, size_t objectIdx, uint32 rayMask, const Real *tMin,
+                        const Ray *rays, BatchRaySceneQueryResult *results, Real *best );
+        /// Casts rays [firstRay; firstRay + numRays), with numRays <= ARRAY_PACKED_REALS
+        void castPacket( size_t firstRay, size_t numRays );
+
+    public:
+        DefaultBatchRaySceneQuery( SceneManager *creator );
+        ~DefaultBatchRaySceneQuery() override;
+
+        /** See BatchRaySceneQuery. */
+        const BatchRaySceneQueryResultArray &execute() override;
+
+        /// Casts the packets of rays acquired by the given thread.
+        /// Called from worker threads.
+        void _castRaysThread( size_t threadIdx );
     };
 
     /** Default implementation of RaySceneQuery. */
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "OgreFastArray.h"
 #include "OgreRay.h"
 #include "OgreSphere.h"
 
@@ -543,6 +544,74 @@ namespace Ogre
         bool queryResult( MovableObject *movable, SceneQuery::WorldFragment *fragment ) override;
     };
 
+    /** A single result of a BatchRaySceneQuery: the closest hit of one ray. */
+    struct BatchRaySceneQueryResult
+    {
+        /// The hit object. NULL if the ray didn't hit anything.
+        MovableObject *movable;
+        /// Distance along the ray to the hit (to the bounding box unless refined to triangles)
+        Real distance;
+        /// SubMesh & triangle (within that SubMesh) hit by the ray.
+        /// 0xFFFFFFFF if the hit was not refined down to triangles.
+        uint32 subMeshIdx;
+        uint32 triangleIdx;
+    };
+
+    typedef FastArray<BatchRaySceneQueryResult> BatchRaySceneQueryResultArray;
+
+    /** Specialises the SceneQuery class for casting many rays at once.
+    @remarks
+        Unlike RaySceneQuery, which returns every object whose bounds are crossed by
+        a single ray, this query only returns the closest hit of each ray, and is
+        designed to process thousands of rays per call: rays are traversed in SIMD
+        packets and the work is split across the SceneManager's worker threads.
+    @par
+        When triangle level is enabled (see setTriangleLevel) hits against Items are
+        refined against the actual triangles of their Mesh, using a BVH built the first
+        time the Mesh gets queried (see Mesh::_getTriangleBvh). The BVH only knows the bind
+        pose, thus Items with a skeleton or with poses are not refined: like other
+        MovableObjects, they're reported at their bounding box (subMeshIdx and triangleIdx
+        are 0xFFFFFFFF).
+    */
+    class _OgreExport BatchRaySceneQuery : public SceneQuery
+    {
+    protected:
+        FastArray<Ray> mRays;
+        Real           mMaxDistance;
+        bool           mTriangleLevel;
+
+        BatchRaySceneQueryResultArray mResults;
+
+    public:
+        BatchRaySceneQuery( SceneManager *mgr );
+        ~BatchRaySceneQuery() override;
+
+        /// Sets the rays to cast. The array is copied.
+        virtual void setRays( const Ray *rays, size_t numRays );
+        const FastArray<Ray> &getRays() const { return mRays; }
+
+        /// Hits further than this distance are ignored. Default is infinity.
+        virtual void setMaxDistance( Real maxDistance );
+        Real getMaxDistance() const { return mMaxDistance; }
+
+        /** When true, hits against Items are refined against their triangles, except
+            for Items with a skeleton or poses.
+            When false (default) rays only get tested against bounding boxes.
+        */
+        virtual void setTriangleLevel( bool triangleLevel );
+        bool getTriangleLevel() const { return mTriangleLevel; }
+
+        /** Executes the query.
+        @return
+            One result per ray, in the same order as the rays given to setRays.
+            The results persist until the next call to execute.
+        */
+        virtual const BatchRaySceneQueryResultArray &execute() = 0;
+
+        /// Gets the results of the last execution.
+        const BatchRaySceneQueryResultArray &getLastResults() const { return mResults; }
+    };
+
     /** @} */
     /** @} */
 
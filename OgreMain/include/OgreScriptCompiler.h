@@ -442,6 +442,9 @@ namespace Ogre
         // A pointer to the specific compiler instance used
         OGRE_THREAD_POINTER( ScriptCompiler, mScriptCompiler );
 
+        // Where parsed scripts get cached. May be null
+        Archive *mAstCache;
+
     public:
         ScriptCompilerManager();
         ~ScriptCompilerManager() override;
@@ -477,8 +480,33 @@ namespace Ogre
         void addScriptPattern( const String &pattern );
         /// @copydoc ScriptLoader::getScriptPatterns
         const StringVector &getScriptPatterns() const override;
+        /** Sets where the parsed scripts (the concrete syntax tree) are cached, so unchanged
+            scripts skip lexing and parsing the next time they're loaded.
+        @remarks
+            There is one entry per script. An entry is used only if both the modified time
+            and the hash of the script match the ones it was created from; otherwise it gets
+            overwritten.
+        @param archive
+            A writable archive, e.g. a "FileSystem" archive loaded with readOnly = false.
+            Scripts are prepared from several threads, thus it must support opening &
+            creating different files at the same time (FileSystem does).
+            Null to disable the cache (default). The archive is not owned.
+        */
+        void setAstCache( Archive *archive );
+        Archive *getAstCache() const { return mAstCache; }
+
         /// @copydoc ScriptLoader::parseScript
         void parseScript( DataStreamPtr &stream, const String &groupName ) override;
+        /// @copydoc ScriptLoader::supportsPrepareScript
+        bool supportsPrepareScript() const override { return true; }
+        /** @copydoc ScriptLoader::prepareScript
+        @remarks
+            Lexes & parses the script, or loads it from the AST cache.
+            Returns a ConcreteNodeListPtr.
+        */
+        Any prepareScript( DataStreamPtr &stream, time_t modifiedTime ) override;
+        /// @copydoc ScriptLoader::parsePreparedScript
+        void parsePreparedScript( const Any &prepared, const String &groupName ) override;
         /// @copydoc ScriptLoader::getLoadingOrder
         Real getLoadingOrder() const override;
 
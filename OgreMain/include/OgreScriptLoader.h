@@ -30,9 +30,12 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "OgreAny.h"
 #include "OgreDataStream.h"
 #include "OgreStringVector.h"
 
+#include <ctime>
+
 #include "OgreHeaderPrefix.h"
 
 namespace Ogre
@@ -79,6 +82,30 @@ namespace Ogre
         */
         virtual void parseScript( DataStreamPtr &stream, const String &groupName ) = 0;
 
+        /// Returns true if prepareScript & parsePreparedScript are implemented.
+        /// Only then ResourceGroupManager spawns threads to prepare scripts.
+        virtual bool supportsPrepareScript() const { return false; }
+
+        /** Optional first half of parseScript: does the work that doesn't create anything
+            (i.e. lexing & parsing) so it can run ahead of time. See supportsPrepareScript.
+        @remarks
+            ResourceGroupManager calls this from several worker threads at once for a batch
+            of scripts, then calls parsePreparedScript on the main thread in the same order
+            parseScript would have been called. Thus implementations must be thread safe.
+        @param stream
+            The script. Only this call will read from it.
+        @param modifiedTime
+            Last time the script was modified as reported by its Archive. 0 if unknown.
+        @return
+            Whatever parsePreparedScript needs.
+        */
+        virtual Any prepareScript( DataStreamPtr &stream, time_t modifiedTime ) { return Any(); }
+
+        /** Second half of parseScript: creates the resources from the data returned by
+            prepareScript. Always called from the main thread.
+        */
+        virtual void parsePreparedScript( const Any &prepared, const String &groupName ) {}
+
         /** Gets the relative loading order of scripts of this type.
         @remarks
             There are dependencies between some kinds of scripts, and to enforce
@@ -93,6 +93,9 @@ namespace Ogre
 
         void _setHlmsHashes( uint32 hash, uint32 casterHash ) override;
 
+        /// Copies the Vaos of our SubMesh again, after its LODs got streamed in or evicted
+        void _updateVaosFromSubMesh();
+
         /** Accessor to get parent Item */
         Item *getParent() const { return mParentItem; }
 
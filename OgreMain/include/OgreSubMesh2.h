@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "OgrePrerequisites.h"
 
+#include "OgreMesh2Optimizer.h"
 #include "OgreVertexBoneAssignment.h"
 #include "Vao/OgreVertexArrayObject.h"
 
@@ -39,6 +40,8 @@ namespace Ogre
 {
     typedef FastArray<VertexArrayObject *> VertexArrayObjectArray;
 
+    class TriangleBvh;
+
     /** \addtogroup Core
      *  @{
      */
@@ -76,6 +79,10 @@ namespace Ogre
         /// then they won't share any pointer.
         VertexArrayObjectArray mVao[NumVertexPass];
 
+        /// Clusters of triangles of each LOD in mVao[VpNormal], used for cluster culling.
+        /// Empty (or with empty entries) when not built. See buildClusters.
+        vector<MeshClusterArray>::type mClusters;
+
         /** Dedicated index map for translate blend index to bone index
             @par
                 We collect actually used bones of all bone assignments, and build the
@@ -117,6 +124,12 @@ namespace Ogre
         std::map<Ogre::String, size_t> mPoseIndexMap;
         TexBufferPacked               *mPoseTexBuffer;
 
+        /// See getMaxExtraClusterDraws
+        uint32 mMaxExtraClusterDraws;
+
+        /// Recalculates mMaxExtraClusterDraws from mClusters.
+        void updateMaxExtraClusterDraws();
+
     public:
         SubMesh();
         ~SubMesh();
@@ -205,6 +218,51 @@ namespace Ogre
 
         void _prepareForShadowMapping( bool forceSameBuffers );
 
+        /** Reorders the triangles and vertices of every LOD so they render faster.
+            See MeshOptimizer. Can be called right after Mesh::importV1.
+        @remarks
+            LODs which aren't indexed triangle lists are left untouched.
+            If the SubMesh has poses, vertices are neither welded nor reordered since the
+            pose buffer refers to them by position.
+            Shadow mapping Vaos with their own buffers are rebuilt from the new ones.
+        @param flags
+            Bitmask of MeshOptimizer::Flags.
+        @param overdrawThreshold
+            See MeshOptimizer::optimizeOverdraw.
+        @return
+            Vertex cache efficiency before and after, of all LODs combined.
+        */
+        MeshOptimizer::Report optimizeGeometry( uint32 flags = MeshOptimizer::OptimizeAll,
+                                                float  overdrawThreshold = 1.05f );
+
+        /** Splits every LOD in clusters of up to maxTriangles triangles with their bounding
+            sphere and normal cone, so that RenderQueue can skip the clusters outside the
+            camera or facing away from it. See MeshOptimizer::buildClusters.
+        @remarks
+            Call it after optimizeGeometry, which discards the clusters.
+            LODs which aren't indexed triangle lists or whose positions aren't float or
+            half get no clusters.
+        */
+        void buildClusters( uint32 maxTriangles = 128u );
+
+        /// Discards the clusters. See buildClusters.
+        void clearClusters();
+
+        /// Worst case number of draws cluster culling may add to a single draw of this
+        /// SubMesh (every other cluster visible), out of all its LODs. RenderQueue uses it
+        /// to size the indirect buffer. 0 if there are no clusters.
+        uint32 getMaxExtraClusterDraws() const { return mMaxExtraClusterDraws; }
+
+        /** Adds the triangles of the finest resident LOD to the given TriangleBvh, reading
+            them from the shadow copies of the buffers when available.
+        @remarks
+            Triangles are added in index buffer order. LODs which aren't triangle lists or whose
+            positions aren't float or half add no triangles. See Mesh::_getTriangleBvh.
+        @return
+            Number of triangles added.
+        */
+        size_t _addTrianglesToBvh( TriangleBvh &bvh ) const;
+
         uint16 getNumPoses() { return mNumPoses; }
 
         bool getPoseHalfPrecision() { return mPoseHalfPrecision; }
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgrePrerequisites.h"
 
 #include "OgrePixelFormatGpu.h"
+#include "OgreTextureGpu.h"
 
 #include "OgreHeaderPrefix.h"
 
@@ -59,6 +60,9 @@ namespace Ogre
             TypePrepareForNormalMapping         = 1u << 2u,
             TypeLeaveChannelR                   = 1u << 3u,
             TypePremultiplyAlpha                = 1u << 4u,
+            /// Compresses the texture to BCn (or ETC2 / EAC if BCn is not supported) using
+            /// the CPU after all other filters ran. See CompressOnLoad
+            TypeCompressOnLoad                  = 1u << 5u,
             // clang-format on
 
             TypeGenerateDefaultMipmaps = TypeGenerateSwMipmaps | TypeGenerateHwMipmaps
@@ -157,6 +161,34 @@ namespace Ogre
         public:
             void _executeStreaming( Image2 &image, TextureGpu *texture ) override;
         };
+        //-----------------------------------------------------------------------------------
+        /** Compresses uncompressed 8-bit images with BlockCompression, so textures authored
+            as PNG / JPG take 4x-8x less VRAM and bandwidth.
+
+            RGB becomes BC1, RGBA becomes BC7 (or BC3 if BC7 is not supported), R becomes BC4
+            and RG becomes BC5 (ETC2 RGB8 / RGBA8, EAC R11 / RG11 when BCn is not supported).
+            This includes the RG8_SNORM output of TypePrepareForNormalMapping.
+
+            Mipmaps are always generated in SW first, since compressed formats don't support
+            HW mipmap generation. Images whose resolution is not a multiple of 4 are left
+            untouched.
+
+            Compressing is slow. See TextureGpuManager::setCompressOnLoadCacheFolder to only
+            pay the cost once.
+        */
+        class _OgreExport CompressOnLoad : public FilterBase
+        {
+        public:
+            /// Returns srcFormat if the image can't be compressed.
+            static PixelFormatGpu getDestinationFormat( PixelFormatGpu srcFormat, const Image2 &image,
+                                                        const TextureGpuManager *textureManager );
+            /// Same as above, without checking the resolution.
+            /// The result depends on which formats the RenderSystem supports.
+            static PixelFormatGpu getDestinationFormat( PixelFormatGpu             srcFormat,
+                                                        TextureTypes::TextureTypes textureType,
+                                                        const TextureGpuManager   *textureManager );
+            void _executeStreaming( Image2 &image, TextureGpu *texture ) override;
+        };
     }  // namespace TextureFilter
     /** @} */
     /** @} */
@@ -552,6 +552,12 @@ namespace Ogre
         Semaphore                    mMultiLoadsSemaphore;
         std::atomic<uint32>          mPendingMultiLoads;
 
+        /// See setNumSwMipmapThreads(). Read by the streaming thread.
+        std::atomic<uint32> mNumSwMipmapThreads;
+
+        /// See setCompressOnLoadCacheFolder()
+        String mCompressOnLoadCacheFolder;
+
         TexturePoolList  mTexturePool;
         ResourceEntryMap mEntries;
         /// Protects mEntries
@@ -792,6 +798,12 @@ namespace Ogre
         void processLoadRequest( ObjCmdBuffer *commandBuffer, ThreadData &workerData,
                                  const LoadRequest &loadRequest );
 
+        /// Returns the file where the result of TextureFilter::CompressOnLoad is cached.
+        /// Empty if the request can't be cached. See setCompressOnLoadCacheFolder
+        String getCompressOnLoadCachePath( const LoadRequest &loadRequest ) const;
+        /// Returns a null pointer if there is no cache file at that path.
+        static DataStreamPtr openCompressOnLoadCache( const String &cachePath );
+
     public:
         void _updateStreaming();
 
@@ -1126,6 +1138,46 @@ namespace Ogre
         */
         void setMultiLoadPool( uint32 numThreads );
 
+        /** Sets how many threads generate mipmaps in software (see DefaultMipmapGen::SwMode)
+            for a single large texture. The streaming thread (or the MultiLoad thread) that
+            loaded the image is one of them.
+
+            Large textures without baked mipmaps can dominate streaming time, because of
+            mipmap generation on a single thread. See Image2::generateMipmaps.
+        @remarks
+            If the MultiLoad pool is enabled (see setMultiLoadPool), textures are already
+            processed in parallel and extra threads per texture may oversubscribe the CPU.
+
+            Call this function before loading textures. Changing it while textures are
+            being streamed takes effect at some point during streaming.
+        @param numThreads
+            1 to generate them in the thread that loaded the image (default).
+            Values of 0 are treated as 1.
+        */
+        void setNumSwMipmapThreads( uint32 numThreads );
+        uint32 getNumSwMipmapThreads() const
+        {
+            return mNumSwMipmapThreads.load( std::memory_order_relaxed );
+        }
+
+        /** Sets a folder where textures compressed by TextureFilter::TypeCompressOnLoad
+            are saved as OITD files. The next time the same texture is loaded with the same
+            filters, the compressed file is loaded instead and no compression happens.
+
+            Entries are keyed by the texture's file name, its modification time (as reported
+            by its Archive) and the filters. Stale entries are never loaded but are not
+            deleted either.
+        @remarks
+            Only textures loaded from an Archive as a whole (i.e. not cubemaps made of
+            6 separate images) are cached.
+
+            Call this function before loading textures.
+        @param folder
+            Folder must exist and be writable. Empty to disable (default).
+        */
+        void setCompressOnLoadCacheFolder( const String &folder );
+        const String &getCompressOnLoadCacheFolder() const { return mCompressOnLoadCacheFolder; }
+
         /** Background streaming works by having a bunch of preallocated StagingTextures so
             we're ready to start uploading as soon as we see a request to load a texture
             from file.
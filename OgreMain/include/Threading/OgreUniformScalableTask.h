@@ -45,6 +45,8 @@ namespace Ogre
     class _OgreExport UniformScalableTask
     {
     public:
+        virtual ~UniformScalableTask() {}
+
         /** Overload this function to perform whatever you want. It will be
             called from all worker threads at the same time.
         @param threadId
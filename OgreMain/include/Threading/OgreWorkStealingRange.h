@@ -0,0 +1,125 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreWorkStealingRange_H_
+#define _OgreWorkStealingRange_H_
+
+#include "OgrePrerequisites.h"
+
+#include <atomic>
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** Distributes the work items in range [0; numItems) across worker threads, with work stealing.
+
+        The range is split in one contiguous slice per thread (the same split the static
+        "threadIdx * numItemsPerThread" partition would produce). Each thread consumes its own
+        slice in small chunks and, once it runs out of work, steals chunks from the slices
+        of the other threads. This way a thread that got preempted or got the more expensive
+        items doesn't stall everyone else waiting on the Barrier.
+
+        Chunks always start at a multiple of the granularity (i.e. ARRAY_PACKED_REALS for
+        SoA data) and their size is a multiple of it, except for the very last one.
+
+        Usage:
+        @code
+            // Main thread, before firing the worker threads:
+            workRange.reset( numItems, numThreads, ARRAY_PACKED_REALS );
+
+            // Inside each worker thread (e.g. UniformScalableTask::execute):
+            size_t start, count;
+            while( workRange.acquire( threadIdx, start, count ) )
+                processItems( start, count );
+        @endcode
+    @remarks
+        reset() must not be called while worker threads are still acquiring from it.
+        acquire() is lock free.
+    */
+    class _OgreExport WorkStealingRange
+    {
+        struct Slice
+        {
+            std::atomic<size_t> next;
+            size_t              end;
+            /// The padding prevents false cache sharing when multithreading.
+            uint8 padding[64];
+        };
+
+        Slice *mSlices;
+        size_t mNumSlices;
+        size_t mCapacity;
+        size_t mChunkSize;
+        bool   mStealingEnabled;
+
+        /// Tries to grab the next chunk from the given slice. Returns false if it's exhausted.
+        inline bool acquireFrom( Slice &slice, size_t &outStart, size_t &outCount );
+
+    public:
+        WorkStealingRange();
+        ~WorkStealingRange();
+
+        /** Sets up a new range. Must be called from a single thread.
+        @param numItems
+            Number of work items. Threads will process the range [0; numItems)
+        @param numThreads
+            Number of threads that will call acquire(). Valid threadIdx for acquire
+            will be in range [0; numThreads)
+        @param granularity
+            Chunk starts and sizes will be multiple of this value. Must be > 0.
+        @param chunksPerThread
+            How many chunks each thread's slice is split into. Higher values
+            balance better at the cost of more atomic operations.
+        */
+        void reset( size_t numItems, size_t numThreads, size_t granularity,
+                    size_t chunksPerThread = 8u );
+
+        /** Retrieves the next chunk of work to process for the given thread.
+        @param threadIdx
+            Index of the calling thread, in range [0; numThreads). Must be unique per thread.
+        @param outStart [out]
+            First item to process.
+        @param outCount [out]
+            Number of items to process. Always > 0 if returned true.
+        @return
+            False when there is no more work left.
+        */
+        bool acquire( size_t threadIdx, size_t &outStart, size_t &outCount );
+
+        /** When disabled, threads only consume their own slice (i.e. equivalent to a
+            static partition). Useful when the order in which items are processed by each
+            thread must be deterministic.
+        */
+        void setStealingEnabled( bool bEnabled ) { mStealingEnabled = bEnabled; }
+        bool getStealingEnabled() const { return mStealingEnabled; }
+    };
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
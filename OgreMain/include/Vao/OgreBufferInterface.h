@@ -63,6 +63,10 @@ namespace Ogre
         BufferPacked *getBufferPacked() { return mBuffer; }
 
         virtual void _ensureDelayedImmutableBuffersAreReady();
+
+        /// Moves the buffer to another offset (in elements) of the same pool.
+        /// The caller is responsible for copying the contents.
+        void _setInternalBufferStart( size_t internalBufferStart );
     };
 }  // namespace Ogre
 
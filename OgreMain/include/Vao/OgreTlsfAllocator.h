@@ -0,0 +1,196 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreTlsfAllocator_H_
+#define _OgreTlsfAllocator_H_
+
+#include "OgrePrerequisites.h"
+
+#include "OgreFastArray.h"
+#include "ogrestd/unordered_map.h"
+#include "ogrestd/vector.h"
+
+#include "OgreHeaderPrefix.h"
+
+namespace Ogre
+{
+    /** \addtogroup Core
+     *  @{
+     */
+    /** \addtogroup Resources
+     *  @{
+     */
+
+    /** Sub-allocates ranges of a larger buffer (i.e. a GPU pool) in constant time,
+        using Two-Level Segregated Fit.
+    @remarks
+        Free ranges are kept in lists segregated by size: the first level splits sizes in
+        powers of two, the second level splits each power of two in 16 linear steps.
+        Two bitmasks track which lists are non-empty, thus finding a free range that fits
+        takes a couple of bit scans instead of walking every free block. Freed ranges are
+        merged with their free neighbours right away.
+    @par
+        Only offsets are tracked; the memory itself is never touched. This makes the
+        allocator usable by every VaoManager backend, and testable without a GPU.
+    */
+    class _OgreExport TlsfAllocator
+    {
+    public:
+        struct Block
+        {
+            size_t offset;
+            size_t size;
+            bool   used;
+        };
+        typedef vector<Block>::type BlockVec;
+
+    protected:
+        static const uint32 c_slCountLog2 = 4u;
+        static const uint32 c_slCount = 1u << c_slCountLog2;
+        static const uint32 c_invalidNode = 0xFFFFFFFF;
+
+        struct Node
+        {
+            size_t offset;
+            size_t size;
+            uint32 prevPhys;
+            uint32 nextPhys;
+            uint32 prevFree;
+            uint32 nextFree;
+            bool   used;
+        };
+
+        typedef unordered_map<size_t, uint32>::type UsedNodeMap;
+
+        FastArray<Node>   mNodes;
+        FastArray<uint32> mUnusedNodes;
+        /// Node at offset 0. Physical neighbours are walked from here
+        uint32 mFirstNode;
+
+        uint32 mNumFl;
+        uint64 mFlBitmap;
+        /// One bitmask per first level
+        FastArray<uint32> mSlBitmaps;
+        /// Head of the free list of each [fl][sl]
+        FastArray<uint32> mFreeHeads;
+
+        /// Maps the offset returned by allocate to its node
+        UsedNodeMap mUsedNodes;
+
+        size_t mCapacity;
+        size_t mFreeBytes;
+        size_t mNumFreeBlocks;
+
+        static void mapping( uint64 size, uint32 &outFl, uint32 &outSl );
+
+        /// Returns the head of the first free list whose nodes are all
+        /// at least the given size, or c_invalidNode
+        uint32 findFreeListHead( uint64 size ) const;
+
+        bool fits( uint32 nodeIdx, size_t size, size_t alignment ) const;
+
+        /// Returns a free node that can hold the request, or c_invalidNode.
+        /// The node stays in its free list.
+        uint32 findFreeNode( size_t size, size_t alignment ) const;
+
+        void insertFreeNode( uint32 nodeIdx );
+        void removeFreeNode( uint32 nodeIdx );
+
+        uint32 createNode( size_t offset, size_t size );
+        void   releaseNode( uint32 nodeIdx );
+
+        /// Takes the request out of a free node that fits it. Returns the offset
+        size_t allocateFrom( uint32 nodeIdx, size_t sizeBytes, size_t alignment );
+
+        /// Shrinks the node to the given size and returns a new node with the remainder
+        uint32 splitNode( uint32 nodeIdx, size_t size );
+        /// Absorbs the next physical node, which gets released
+        void mergeWithNext( uint32 nodeIdx );
+
+    public:
+        TlsfAllocator();
+
+        /// Discards all allocations and makes [0; capacity) available
+        void initialize( size_t capacity );
+
+        /** Reserves a range.
+        @param sizeBytes
+            Size of the range. A size of 0 still gets a unique offset.
+        @param alignment
+            The returned offset will be a multiple of this value. Doesn't need to
+            be a power of 2 (i.e. vertex buffers align to their vertex size).
+        @param outOffset [out]
+            Start of the range, if successful.
+        @return
+            False if there is no free range that can hold the request.
+        */
+        bool allocate( size_t sizeBytes, size_t alignment, size_t &outOffset );
+
+        /** Reserves a range that starts before the given offset, as low as possible.
+            Used to compact a pool: allocate a lower range, copy the data, then
+            deallocate the old range.
+        @remarks
+            Unlike allocate, this walks the free blocks in address order, thus it is O(N)
+            where N is the number of blocks below maxOffset.
+        @param maxOffset
+            The returned offset will be lower than this value.
+        @return
+            False if no free range below maxOffset can hold the request.
+        */
+        bool allocateBelow( size_t sizeBytes, size_t alignment, size_t maxOffset,
+                            size_t &outOffset );
+
+        /// Releases a range. offset must be the value returned by allocate
+        void deallocate( size_t offset );
+
+        size_t getCapacity() const { return mCapacity; }
+        size_t getFreeBytes() const { return mFreeBytes; }
+        size_t getNumFreeBlocks() const { return mNumFreeBlocks; }
+        size_t getNumAllocations() const { return mUsedNodes.size(); }
+        bool   isEmpty() const { return mUsedNodes.empty(); }
+
+        /// Size of the biggest range that can currently be allocated (with alignment 1)
+        size_t getLargestFreeBlock() const;
+
+        /** Returns how fragmented the free memory is, in range [0; 1].
+            0 means all free memory is contiguous; values close to 1 mean it's scattered
+            in many small blocks and big requests may fail despite there being
+            enough free memory.
+        */
+        float getFragmentation() const;
+
+        /// Returns all ranges, used and free, sorted by offset
+        void getBlocks( BlockVec &outBlocks ) const;
+    };
+
+    /** @} */
+    /** @} */
+}  // namespace Ogre
+
+#include "OgreHeaderSuffix.h"
+
+#endif
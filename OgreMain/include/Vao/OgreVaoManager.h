@@ -94,6 +94,9 @@ namespace Ogre
         size_t mReadOnlyBufferMaxSize;
         size_t mUavBufferMaxSize;
 
+        /// Bytes relocated by _update every frame. 0 to disable
+        size_t mDefragmentationBudget;
+
         virtual VertexBufferPacked *createVertexBufferImpl(
             size_t numElements, uint32 bytesPerElement, BufferType bufferType, void *initialData,
             bool keepAsShadow, const VertexElement2Vec &vertexElements ) = 0;
@@ -167,6 +170,12 @@ namespace Ogre
         virtual void switchVboPoolIndexImpl( unsigned internalVboBufferType, size_t oldPoolIdx,
                                              size_t newPoolIdx, BufferPacked *buffer ) = 0;
 
+        /** Collects the buffers defragment() may relocate: vertex and index buffers
+            that live in GPU-only pools, are not mapped and don't belong to a
+            MultiSourceVertexBufferPool.
+        */
+        void getRelocatableBuffers( BufferPackedVec &outBuffers ) const;
+
     public:
         VaoManager( const NameValuePairList *params );
         virtual ~VaoManager();
@@ -271,6 +280,56 @@ namespace Ogre
                                      size_t &outFreeBytes, Log *log,
                                      bool &outIncludesTextures ) const = 0;
 
+        struct _OgreExport PoolFragmentationEntry
+        {
+            /// @see MemoryStatsEntry::poolType
+            uint32 poolType;
+            uint32 poolIdx;
+            size_t poolCapacity;
+            size_t freeBytes;
+            /// Biggest request that can be served without creating a new pool
+            size_t largestFreeBlock;
+            size_t numFreeBlocks;
+
+            /// In range [0; 1]. 0 means all free memory in the pool is contiguous
+            float getFragmentation() const
+            {
+                return freeBytes ? 1.0f - float( largestFreeBlock ) / float( freeBytes ) : 0.0f;
+            }
+        };
+
+        typedef vector<PoolFragmentationEntry>::type PoolFragmentationEntryVec;
+
+        /** Retrieves how fragmented the free memory of each GPU pool is.
+            RenderSystems that track it also dump it to the Log in getMemoryStats.
+        @remarks
+            RenderSystems that don't track it leave outStats empty.
+        */
+        virtual void getFragmentationStats( PoolFragmentationEntryVec &outStats ) const
+        {
+            outStats.clear();
+        }
+
+        /** Compacts the GPU pools by moving buffers to lower offsets, so that free memory
+            gathers at the end of each pool. Buffers are relocated with GPU copies; their
+            Vaos remain valid.
+        @remarks
+            RenderSystems that don't support relocation do nothing.
+        @param maxBytesToMove
+            Stop once this many bytes have been copied, to bound the cost per call.
+        @return
+            The number of bytes moved.
+        */
+        virtual size_t defragment( size_t maxBytesToMove ) { return 0; }
+
+        /** Runs defragment() every frame, from _update.
+        @param bytesPerFrame
+            Maximum number of bytes to relocate per frame. 0 (the default) disables it.
+        */
+        void setDefragmentationBudget( size_t bytesPerFrame );
+
+        size_t getDefragmentationBudget() const { return mDefragmentationBudget; }
+
         /// Frees GPU memory if there are empty, unused pools
         virtual void cleanupEmptyPools() = 0;
 
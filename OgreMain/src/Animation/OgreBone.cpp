@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "Animation/OgreBone.h"
 
 #include "Animation/OgreTagPoint.h"
+#include "Math/Array/OgreArrayDispatch.h"
 #include "Math/Array/OgreBoneMemoryManager.h"
 #include "Math/Array/OgreBooleanMask.h"
 #include "Math/Array/OgreKfTransform.h"
@@ -321,9 +322,9 @@ namespace Ogre
 #endif*/
     }
     //-----------------------------------------------------------------------
-    void Bone::updateAllTransforms( const size_t numNodes, BoneTransform t,
-                                    ArrayMatrixAf4x3 const *RESTRICT_ALIAS _reverseBind,
-                                    size_t numBinds )
+    static FORCEINLINE void updateAllTransformsImpl( const size_t numNodes, BoneTransform t,
+                                                     ArrayMatrixAf4x3 const *RESTRICT_ALIAS _reverseBind,
+                                                     size_t numBinds )
     {
         size_t currentBind = 0;
         numBinds = ( numBinds + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS;
@@ -367,17 +368,42 @@ namespace Ogre
             derivedTransform = nodeMat * derivedTransform;
             derivedTransform.streamToAoS( t.mFinalTransform );
 
+            t.advancePack();
+            currentBind = ( currentBind + 1 ) % numBinds;
+        }
+    }
+    //-----------------------------------------------------------------------
+#if OGRE_ARRAY_DISPATCH_AVX2
+    OGRE_ARRAY_TARGET_AVX2 static void updateAllTransformsAvx2(
+        const size_t numNodes, BoneTransform t, ArrayMatrixAf4x3 const *RESTRICT_ALIAS _reverseBind,
+        size_t numBinds )
+    {
+        updateAllTransformsImpl( numNodes, t, _reverseBind, numBinds );
+    }
+#endif
+    //-----------------------------------------------------------------------
+    void Bone::updateAllTransforms( const size_t numNodes, BoneTransform t,
+                                    ArrayMatrixAf4x3 const *RESTRICT_ALIAS _reverseBind,
+                                    size_t numBinds )
+    {
+#if OGRE_ARRAY_DISPATCH_AVX2
+        if( ArrayDispatch::useAvx2() )
+            updateAllTransformsAvx2( numNodes, t, _reverseBind, numBinds );
+        else
+#endif
+            updateAllTransformsImpl( numNodes, t, _reverseBind, numBinds );
+
 #if OGRE_DEBUG_MODE
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
             {
                 if( t.mOwner[j] )
                     t.mOwner[j]->mCachedTransformOutOfDate = false;
             }
-#endif
-
             t.advancePack();
-            currentBind = ( currentBind + 1 ) % numBinds;
         }
+#endif
     }
     //-----------------------------------------------------------------------
     void Bone::removeChild( Bone *child )
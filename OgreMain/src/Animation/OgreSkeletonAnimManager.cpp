@@ -41,6 +41,7 @@ namespace Ogre
         skeletonDefName( _skeletonDef->getNameStr() )
     {
         threadStarts.resize( threadCount + 1, 0 );
+        poseCaches.resize( threadCount );
     }
     //-----------------------------------------------------------------------
     void BySkeletonDef::initializeMemoryManager()
@@ -85,6 +86,71 @@ namespace Ogre
         }
     }
 
+    //-----------------------------------------------------------------------
+    void BySkeletonDef::_updateAnimations( size_t threadIdx, Real frameTolerance,
+                                           Real weightTolerance )
+    {
+        PoseCache &poseCache = poseCaches[threadIdx];
+        poseCache.sources.clear();
+        poseCache.numSharedPoses = 0;
+
+        FastArray<SkeletonInstance *>::const_iterator itor = skeletons.begin() + threadStarts[threadIdx];
+        FastArray<SkeletonInstance *>::const_iterator endt =
+            skeletons.begin() + threadStarts[threadIdx + 1];
+
+        while( itor != endt )
+        {
+            SkeletonInstance *skeleton = *itor;
+
+            if( !skeleton->_canSharePose() )
+            {
+                skeleton->update();
+            }
+            else
+            {
+                const uint32 poseHash = skeleton->_getPoseHash( frameTolerance, weightTolerance );
+                PoseCache::SourceMap::const_iterator itSource = poseCache.sources.find( poseHash );
+
+                if( itSource != poseCache.sources.end() &&
+                    itSource->second->_hasSamePose( skeleton, frameTolerance, weightTolerance ) )
+                {
+                    skeleton->_copyLocalPose( itSource->second );
+                    ++poseCache.numSharedPoses;
+                }
+                else
+                {
+                    skeleton->update();
+                    // On hash collisions the first instance stays as the source
+                    if( itSource == poseCache.sources.end() )
+                        poseCache.sources[poseHash] = skeleton;
+                }
+            }
+
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    size_t BySkeletonDef::getNumSharedPoses() const
+    {
+        size_t numSharedPoses = 0;
+        vector<PoseCache>::type::const_iterator itor = poseCaches.begin();
+        vector<PoseCache>::type::const_iterator endt = poseCaches.end();
+
+        while( itor != endt )
+        {
+            numSharedPoses += itor->numSharedPoses;
+            ++itor;
+        }
+
+        return numSharedPoses;
+    }
+
+    //-----------------------------------------------------------------------
+    SkeletonAnimManager::SkeletonAnimManager() :
+        poseSharingFrameTolerance( 0.1f ),
+        poseSharingWeightTolerance( 0.01f )
+    {
+    }
     //-----------------------------------------------------------------------
     SkeletonInstance *SkeletonAnimManager::createSkeletonInstance( const SkeletonDef *skeletonDef,
                                                                    size_t numWorkerThreads )
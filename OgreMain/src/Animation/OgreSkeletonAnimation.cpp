@@ -332,6 +332,76 @@ namespace Ogre
     {
         inOutBoneWeights.swap( mBoneWeights );
     }
+    //-----------------------------------------------------------------------------------
+    int32 SkeletonAnimation::_quantizePoseValue( Real value, Real tolerance )
+    {
+        return static_cast<int32>( std::floor( value / tolerance + 0.5f ) );
+    }
+    //-----------------------------------------------------------------------------------
+    /// Returns the first slot of the bone weights belonging to this instance in the given track
+    static inline size_t getBoneWeightsSlotStart( const SkeletonTrack &track,
+                                                  const FastArray<size_t> &slotStarts )
+    {
+        if( track.getUsedSlots() <= ( ARRAY_PACKED_REALS >> 1 ) )
+            return slotStarts[track.getBoneBlockIdx() >> 24];
+        return 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 SkeletonAnimation::_getBoneWeightsHash( uint32 hash, Real weightTolerance ) const
+    {
+        const Real *boneWeightsScalar = reinterpret_cast<const Real *>( mBoneWeights.get() );
+
+        SkeletonTrackVec::const_iterator itor = mDefinition->mTracks.begin();
+        SkeletonTrackVec::const_iterator endt = mDefinition->mTracks.end();
+
+        while( itor != endt )
+        {
+            const size_t slotStart = getBoneWeightsSlotStart( *itor, *mSlotStarts );
+            for( size_t i = slotStart; i < slotStart + itor->getUsedSlots(); ++i )
+            {
+                hash =
+                    HashCombine( hash, _quantizePoseValue( boneWeightsScalar[i], weightTolerance ) );
+            }
+
+            boneWeightsScalar += ARRAY_PACKED_REALS;
+            ++itor;
+        }
+
+        return hash;
+    }
+    //-----------------------------------------------------------------------------------
+    bool SkeletonAnimation::_hasSameBoneWeights( const SkeletonAnimation *other,
+                                                 Real weightTolerance ) const
+    {
+        assert( other->mDefinition == mDefinition );
+
+        const Real *boneWeightsScalar = reinterpret_cast<const Real *>( mBoneWeights.get() );
+        const Real *otherWeightsScalar = reinterpret_cast<const Real *>( other->mBoneWeights.get() );
+
+        SkeletonTrackVec::const_iterator itor = mDefinition->mTracks.begin();
+        SkeletonTrackVec::const_iterator endt = mDefinition->mTracks.end();
+
+        while( itor != endt )
+        {
+            const size_t slotStart = getBoneWeightsSlotStart( *itor, *mSlotStarts );
+            const size_t otherSlotStart = getBoneWeightsSlotStart( *itor, *other->mSlotStarts );
+
+            for( size_t i = 0; i < itor->getUsedSlots(); ++i )
+            {
+                if( _quantizePoseValue( boneWeightsScalar[slotStart + i], weightTolerance ) !=
+                    _quantizePoseValue( otherWeightsScalar[otherSlotStart + i], weightTolerance ) )
+                {
+                    return false;
+                }
+            }
+
+            boneWeightsScalar += ARRAY_PACKED_REALS;
+            otherWeightsScalar += ARRAY_PACKED_REALS;
+            ++itor;
+        }
+
+        return true;
+    }
 }  // namespace Ogre
 #if defined( __GNUC__ ) && !defined( __clang__ )
 #    pragma GCC diagnostic pop
@@ -219,6 +219,37 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonAnimationDef::compress( const KeyFrameCompressionSettings &settings,
+                                         KeyFrameCompressionReport *outReport )
+    {
+        KeyFrameCompressionReport report;
+
+        if( mKfTransformMemoryManager )
+        {
+            SkeletonTrackVec::iterator itor = mTracks.begin();
+            SkeletonTrackVec::iterator endt = mTracks.end();
+
+            while( itor != endt )
+            {
+                itor->_compress( settings, report );
+                ++itor;
+            }
+
+            // Tracks only account for the KfTransforms they use. Add what the memory manager
+            // reserved on top (i.e. prefetch padding)
+            report.bytesBefore += mKfTransformMemoryManager->getAllMemory() -
+                                  report.numKeyFramesBefore * sizeof( KfTransform );
+
+            // No keyframe references the KfTransforms anymore
+            mKfTransformMemoryManager->destroy();
+            delete mKfTransformMemoryManager;
+            mKfTransformMemoryManager = 0;
+        }
+
+        if( outReport )
+            *outReport = report;
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonAnimationDef::getInterpolatedUnnormalizedKeyFrame( v1::OldNodeAnimationTrack *oldTrack,
                                                                     const v1::TimeIndex &timeIndex,
                                                                     v1::TransformKeyFrame *kf )
@@ -411,22 +442,14 @@ namespace Ogre
                     outText += boneDef.name;
                     outText += ",";
 
-                    KeyFrameRigVec::const_iterator itKeyFrames = keyFrames.begin();
-                    KeyFrameRigVec::const_iterator enKeyFrames = keyFrames.end();
-
-                    while( itKeyFrames != enKeyFrames )
+                    for( size_t k = 0u; k < keyFrames.size(); ++k )
                     {
-                        outText += StringConverter::toString( itKeyFrames->mFrame );
+                        outText += StringConverter::toString( keyFrames[k].mFrame );
                         outText += ",";
 
-                        const KfTransform *RESTRICT_ALIAS boneTransform = itKeyFrames->mBoneTransform;
-
                         Vector3 vPos, vScale;
                         Quaternion qRot;
-
-                        boneTransform->mPosition.getAsVector3( vPos, i );
-                        boneTransform->mOrientation.getAsQuaternion( qRot, i );
-                        boneTransform->mScale.getAsVector3( vScale, i );
+                        track.getKeyFrameTransform( k, static_cast<uint32>( i ), vPos, qRot, vScale );
 
                         outText += StringConverter::toString( vPos.x ) + ",";
                         outText += StringConverter::toString( vPos.y ) + ",";
@@ -438,7 +461,6 @@ namespace Ogre
                         outText += StringConverter::toString( vScale.x ) + ",";
                         outText += StringConverter::toString( vScale.y ) + ",";
                         outText += StringConverter::toString( vScale.z ) + ",";
-                        ++itKeyFrames;
                     }
 
                     outText += "\n";
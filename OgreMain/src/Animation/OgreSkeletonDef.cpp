@@ -310,6 +310,26 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void SkeletonDef::compressAnimations( const KeyFrameCompressionSettings &settings,
+                                          KeyFrameCompressionReport *outReport )
+    {
+        KeyFrameCompressionReport report;
+
+        SkeletonAnimationDefVec::iterator itor = mAnimationDefs.begin();
+        SkeletonAnimationDefVec::iterator endt = mAnimationDefs.end();
+
+        while( itor != endt )
+        {
+            KeyFrameCompressionReport animReport;
+            itor->compress( settings, &animReport );
+            report.merge( animReport );
+            ++itor;
+        }
+
+        if( outReport )
+            *outReport = report;
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonDef::getBonesPerDepth( vector<size_t>::type &out ) const
     {
         out.clear();
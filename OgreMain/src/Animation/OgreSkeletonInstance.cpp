@@ -49,7 +49,9 @@ namespace Ogre
                                         BoneMemoryManager *boneMemoryManager ) :
         mDefinition( skeletonDef ),
         mParentNode( 0 ),
-        mRefCount( 1 )
+        mRefCount( 1 ),
+        mNumManualBones( 0 ),
+        mPoseSharing( false )
     {
         mBones.resize( mDefinition->getBones().size(), Bone() );
 
@@ -253,6 +255,108 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    uint32 SkeletonInstance::_getPoseHash( Real frameTolerance, Real weightTolerance ) const
+    {
+        uint32 hash = 0;
+
+        ActiveAnimationsVec::const_iterator itor = mActiveAnimations.begin();
+        ActiveAnimationsVec::const_iterator endt = mActiveAnimations.end();
+
+        while( itor != endt )
+        {
+            const SkeletonAnimation *animation = *itor;
+            hash = HashCombine( hash, animation->getDefinition() );
+            hash = HashCombine( hash, SkeletonAnimation::_quantizePoseValue(
+                                          animation->getCurrentFrame(), frameTolerance ) );
+            hash = HashCombine( hash, SkeletonAnimation::_quantizePoseValue( animation->mWeight,
+                                                                             weightTolerance ) );
+            hash = animation->_getBoneWeightsHash( hash, weightTolerance );
+            ++itor;
+        }
+
+        return hash;
+    }
+    //-----------------------------------------------------------------------------------
+    bool SkeletonInstance::_hasSamePose( const SkeletonInstance *other, Real frameTolerance,
+                                         Real weightTolerance ) const
+    {
+        if( other->mDefinition != mDefinition ||
+            other->mActiveAnimations.size() != mActiveAnimations.size() )
+        {
+            return false;
+        }
+
+        for( size_t i = 0; i < mActiveAnimations.size(); ++i )
+        {
+            const SkeletonAnimation *a = mActiveAnimations[i];
+            const SkeletonAnimation *b = other->mActiveAnimations[i];
+
+            if( a->getDefinition() != b->getDefinition() ||
+                SkeletonAnimation::_quantizePoseValue( a->getCurrentFrame(), frameTolerance ) !=
+                    SkeletonAnimation::_quantizePoseValue( b->getCurrentFrame(), frameTolerance ) ||
+                SkeletonAnimation::_quantizePoseValue( a->mWeight, weightTolerance ) !=
+                    SkeletonAnimation::_quantizePoseValue( b->mWeight, weightTolerance ) ||
+                !a->_hasSameBoneWeights( b, weightTolerance ) )
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonInstance::_copyLocalPose( const SkeletonInstance *source )
+    {
+        assert( source->mDefinition == mDefinition );
+
+        const SkeletonDef::DepthLevelInfoVec &depthLevelInfo = mDefinition->getDepthLevelInfo();
+
+        for( size_t i = 0; i < mBoneStartTransforms.size(); ++i )
+        {
+            const BoneTransform &srcTransform = source->mBoneStartTransforms[i];
+            const BoneTransform &dstTransform = mBoneStartTransforms[i];
+            const size_t numBones = depthLevelInfo[i].numBonesInLevel;
+
+            if( numBones > ( ARRAY_PACKED_REALS >> 1 ) )
+            {
+                // Each instance owns whole SIMD blocks at this depth (the leftover
+                // slots are our unused nodes), thus we can copy entire blocks.
+                assert( !srcTransform.mIndex && !dstTransform.mIndex );
+                const size_t numBlocks = ( numBones + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+                for( size_t j = 0; j < numBlocks; ++j )
+                {
+                    dstTransform.mPosition[j] = srcTransform.mPosition[j];
+                    dstTransform.mOrientation[j] = srcTransform.mOrientation[j];
+                    dstTransform.mScale[j] = srcTransform.mScale[j];
+                }
+            }
+            else
+            {
+                // The block is shared with other instances. Copy our slots only.
+                for( size_t j = 0; j < numBones; ++j )
+                {
+                    const size_t srcIdx = srcTransform.mIndex + j;
+                    const size_t dstIdx = dstTransform.mIndex + j;
+
+                    Vector3 vTmp;
+                    Quaternion qTmp;
+                    srcTransform.mPosition[srcIdx / ARRAY_PACKED_REALS].getAsVector3(
+                        vTmp, srcIdx % ARRAY_PACKED_REALS );
+                    dstTransform.mPosition[dstIdx / ARRAY_PACKED_REALS].setFromVector3(
+                        vTmp, dstIdx % ARRAY_PACKED_REALS );
+                    srcTransform.mOrientation[srcIdx / ARRAY_PACKED_REALS].getAsQuaternion(
+                        qTmp, srcIdx % ARRAY_PACKED_REALS );
+                    dstTransform.mOrientation[dstIdx / ARRAY_PACKED_REALS].setFromQuaternion(
+                        qTmp, dstIdx % ARRAY_PACKED_REALS );
+                    srcTransform.mScale[srcIdx / ARRAY_PACKED_REALS].getAsVector3(
+                        vTmp, srcIdx % ARRAY_PACKED_REALS );
+                    dstTransform.mScale[dstIdx / ARRAY_PACKED_REALS].setFromVector3(
+                        vTmp, dstIdx % ARRAY_PACKED_REALS );
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonInstance::resetToPose()
     {
         KfTransform const *RESTRICT_ALIAS bindPose = mDefinition->getBindPose();
@@ -309,6 +413,14 @@ namespace Ogre
                 "Offset incorrectly calculated. manualBones[diff] will overflow!" );
 
         Real *manualBones = reinterpret_cast<Real *>( mManualBones.get() );
+        const bool wasManual = manualBones[diff] == 0.0f;
+        if( wasManual != isManual )
+        {
+            if( isManual )
+                ++mNumManualBones;
+            else
+                --mNumManualBones;
+        }
         manualBones[diff] = isManual ? 0.0f : 1.0f;
     }
     //-----------------------------------------------------------------------------------
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "Animation/OgreSkeletonManager.h"
 
 #include "Animation/OgreSkeletonDef.h"
+#include "OgreLogManager.h"
 #include "OgreOldSkeletonManager.h"
 #include "OgreSkeleton.h"
 
@@ -45,10 +46,21 @@ namespace Ogre
         return ( *msSingleton );
     }
     //-----------------------------------------------------------------------
-    SkeletonManager::SkeletonManager() {}
+    SkeletonManager::SkeletonManager() : mCompressKeyFrames( false ) {}
     //-----------------------------------------------------------------------
     SkeletonManager::~SkeletonManager() {}
     //-----------------------------------------------------------------------
+    void SkeletonManager::compressNewSkeletonDef( SkeletonDef *skeletonDef )
+    {
+        if( !mCompressKeyFrames )
+            return;
+
+        KeyFrameCompressionReport report;
+        skeletonDef->compressAnimations( mKeyFrameCompressionSettings, &report );
+        LogManager::getSingleton().logMessage( "Compressed keyframes of skeleton " +
+                                               skeletonDef->getNameStr() + ". " + report.toString() );
+    }
+    //-----------------------------------------------------------------------
     SkeletonDefPtr SkeletonManager::getSkeletonDef( v1::Skeleton *oldSkeletonBase )
     {
         IdString idName( oldSkeletonBase->getName() );
@@ -58,6 +70,7 @@ namespace Ogre
         {
             oldSkeletonBase->load();
             retVal = SkeletonDefPtr( new SkeletonDef( oldSkeletonBase, 1.0f ) );
+            compressNewSkeletonDef( retVal.get() );
             mSkeletonDefs[idName] = retVal;
         }
         else
@@ -91,6 +104,7 @@ namespace Ogre
             if( oldSkeleton->isLoaded() )
             {
                 retVal = SkeletonDefPtr( new SkeletonDef( oldSkeleton.get(), 1.0f ) );
+                compressNewSkeletonDef( retVal.get() );
                 if( wasUnloaded )
                     oldSkeleton->unload();
                 if( wasNonExistent )
@@ -120,6 +134,13 @@ namespace Ogre
         mSkeletonDefs[idName] = skeletonDef;
     }
     //-----------------------------------------------------------------------
+    void SkeletonManager::setKeyFrameCompression( bool enabled,
+                                                  const KeyFrameCompressionSettings &settings )
+    {
+        mCompressKeyFrames = enabled;
+        mKeyFrameCompressionSettings = settings;
+    }
+    //-----------------------------------------------------------------------
     void SkeletonManager::remove( const IdString &name )
     {
         SkeletonDefMap::iterator itor = mSkeletonDefs.find( name );
@@ -34,16 +34,127 @@ THE SOFTWARE.
 #include "Math/Array/OgreKfTransformArrayMemoryManager.h"
 #include "Math/Array/OgreMathlib.h"
 #include "OgreException.h"
+#include "OgreStringConverter.h"
 
 namespace Ogre
 {
+    /// Header of SkeletonTrack::mCompressedData
+    struct CompressedTrackHeader
+    {
+        ArrayVector3    posMin;
+        ArrayVector3    posExtent;
+        ArrayVector3    scaleMin;
+        ArrayVector3    scaleExtent;
+        ArrayQuaternion rotation;
+    };
+
+    /// Range of each of the smallest three components of a unit quaternion
+    static const Real c_smallestThreeMin = -0.70710678118654752440f;  // -1 / sqrt( 2 )
+    static const Real c_smallestThreeRange = 1.41421356237309504880f;  // sqrt( 2 )
+
+    static uint16 quantizeUnorm16( Real value, Real minValue, Real extent )
+    {
+        if( extent <= 0.0f )
+            return 0u;
+        const Real q = ( value - minValue ) / extent * 65535.0f + 0.5f;
+        return static_cast<uint16>( std::min( std::max( q, 0.0f ), 65535.0f ) );
+    }
+
+    /// Angle between two unit quaternions, in radians
+    static Real rotationDifference( const Quaternion &a, const Quaternion &b )
+    {
+        const Real dot = std::min( Math::Abs( a.Dot( b ) ), Real( 1.0f ) );
+        return 2.0f * Math::ACos( dot ).valueRadians();
+    }
+
+    static Real maxAbsDifference( const Vector3 &a, const Vector3 &b )
+    {
+        const Vector3 diff = a - b;
+        return std::max( std::max( Math::Abs( diff.x ), Math::Abs( diff.y ) ), Math::Abs( diff.z ) );
+    }
+
+    /// Scalar copy of a track's keyframes before compression
+    struct OriginalKeyFrames
+    {
+        vector<Real>::type       frames;
+        vector<Vector3>::type    positions;  // numKeyFrames * ARRAY_PACKED_REALS
+        vector<Quaternion>::type rotations;
+        vector<Vector3>::type    scales;
+
+        /// Returns true if all the keyframes in range (first; last) are within tolerance of
+        /// the interpolation between first & last, on all slots.
+        bool canInterpolate( size_t first, size_t last,
+                             const KeyFrameCompressionSettings &settings ) const
+        {
+            const Real invDistance = 1.0f / ( frames[last] - frames[first] );
+            for( size_t k = first + 1u; k < last; ++k )
+            {
+                const Real w = ( frames[k] - frames[first] ) * invDistance;
+                for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+                {
+                    const size_t a = first * ARRAY_PACKED_REALS + i;
+                    const size_t b = last * ARRAY_PACKED_REALS + i;
+                    const size_t c = k * ARRAY_PACKED_REALS + i;
+
+                    const Vector3 pos = Math::lerp( positions[a], positions[b], w );
+                    const Quaternion rot = Quaternion::nlerp( w, rotations[a], rotations[b], true );
+                    const Vector3 scale = Math::lerp( scales[a], scales[b], w );
+                    if( pos.distance( positions[c] ) > settings.positionTolerance ||
+                        rotationDifference( rot, rotations[c] ) > settings.rotationTolerance ||
+                        maxAbsDifference( scale, scales[c] ) > settings.scaleTolerance )
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
+    KeyFrameCompressionReport::KeyFrameCompressionReport() :
+        bytesBefore( 0 ),
+        bytesAfter( 0 ),
+        numKeyFramesBefore( 0 ),
+        numKeyFramesAfter( 0 ),
+        maxPositionError( 0 ),
+        maxRotationError( 0 ),
+        maxScaleError( 0 )
+    {
+    }
+    //-----------------------------------------------------------------------------------
+    void KeyFrameCompressionReport::merge( const KeyFrameCompressionReport &other )
+    {
+        bytesBefore += other.bytesBefore;
+        bytesAfter += other.bytesAfter;
+        numKeyFramesBefore += other.numKeyFramesBefore;
+        numKeyFramesAfter += other.numKeyFramesAfter;
+        maxPositionError = std::max( maxPositionError, other.maxPositionError );
+        maxRotationError = std::max( maxRotationError, other.maxRotationError );
+        maxScaleError = std::max( maxScaleError, other.maxScaleError );
+    }
+    //-----------------------------------------------------------------------------------
+    String KeyFrameCompressionReport::toString() const
+    {
+        return "Keyframes: " + StringConverter::toString( numKeyFramesBefore ) + " -> " +
+               StringConverter::toString( numKeyFramesAfter ) +
+               ". Bytes: " + StringConverter::toString( bytesBefore ) + " -> " +
+               StringConverter::toString( bytesAfter ) +
+               ". Max error: position " + StringConverter::toString( maxPositionError ) +
+               ", rotation " + StringConverter::toString( maxRotationError ) +
+               " rad, scale " + StringConverter::toString( maxScaleError );
+    }
+    //-----------------------------------------------------------------------------------
+    //-----------------------------------------------------------------------------------
     SkeletonTrack::SkeletonTrack( uint32 boneBlockIdx,
                                   KfTransformArrayMemoryManager *kfTransformMemoryManager ) :
         mKeyFrameRigs( 0 ),
         mNumFrames( 0 ),
         mBoneBlockIdx( boneBlockIdx ),
         mUsedSlots( 0 ),
-        mLocalMemoryManager( kfTransformMemoryManager )
+        mLocalMemoryManager( kfTransformMemoryManager ),
+        mCompressedStride( 0 ),
+        mConstantChannels( 0 )
     {
     }
     //-----------------------------------------------------------------------------------
@@ -74,7 +185,7 @@ namespace Ogre
         KeyFrameRigVec::iterator itor = mKeyFrameRigs.begin();
         KeyFrameRigVec::iterator endt = mKeyFrameRigs.end();
 
-        while( itor != endt && Math::Abs( itor->mFrame - frame ) < 1e-6f )
+        while( itor != endt && Math::Abs( itor->mFrame - frame ) >= 1e-6f )
             ++itor;
 
         if( itor == mKeyFrameRigs.end() )
@@ -83,6 +194,12 @@ namespace Ogre
                          "SkeletonTrack::setKeyFrameTransform" );
         }
 
+        if( isCompressed() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALID_STATE, "Compressed tracks can't be modified.",
+                         "SkeletonTrack::setKeyFrameTransform" );
+        }
+
         itor->mBoneTransform->mPosition.setFromVector3( vPos, slot );
         itor->mBoneTransform->mOrientation.setFromQuaternion( qRot, slot );
         itor->mBoneTransform->mScale.setFromVector3( vScale, slot );
@@ -112,10 +229,83 @@ namespace Ogre
         outNextFrame = nextFrame;
     }
     //-----------------------------------------------------------------------------------
-    void SkeletonTrack::applyKeyFrameRigAt( KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrameRig,
-                                            float frame, ArrayReal animWeight,
-                                            const ArrayReal *RESTRICT_ALIAS perBoneWeights,
-                                            const TransformArray &boneTransforms ) const
+    inline void SkeletonTrack::decompressKeyFrame( size_t keyFrameIdx, ArrayVector3 &outPos,
+                                                   ArrayQuaternion &outRot,
+                                                   ArrayVector3 &outScale ) const
+    {
+        const CompressedTrackHeader *RESTRICT_ALIAS header =
+            reinterpret_cast<const CompressedTrackHeader *>( mCompressedData.get() );
+        const uint16 *RESTRICT_ALIAS src =
+            reinterpret_cast<const uint16 *>( mCompressedData.get() +
+                                              sizeof( CompressedTrackHeader ) ) +
+            keyFrameIdx * mCompressedStride;
+
+        if( mConstantChannels & ConstantPosition )
+            outPos = header->posMin;
+        else
+        {
+            const ArrayVector3 q( Mathlib::FromUnorm16( src ),
+                                  Mathlib::FromUnorm16( src + ARRAY_PACKED_REALS ),
+                                  Mathlib::FromUnorm16( src + 2u * ARRAY_PACKED_REALS ) );
+            outPos = header->posMin + q * header->posExtent;
+            src += 3u * ARRAY_PACKED_REALS;
+        }
+
+        if( mConstantChannels & ConstantRotation )
+            outRot = header->rotation;
+        else
+        {
+            // Smallest-three: the 3 stored components are in range [-1/sqrt(2); 1/sqrt(2)];
+            // the largest one is reconstructed knowing that the quaternion has unit length
+            const ArrayVector3 q( Mathlib::FromUnorm16( src ),
+                                  Mathlib::FromUnorm16( src + ARRAY_PACKED_REALS ),
+                                  Mathlib::FromUnorm16( src + 2u * ARRAY_PACKED_REALS ) );
+            const ArrayVector3 v = q * c_smallestThreeRange + c_smallestThreeMin;
+            const uint16 packedIdx = src[3u * ARRAY_PACKED_REALS];
+            src += 3u * ARRAY_PACKED_REALS + 1u;
+
+            ArrayReal largestSq = Mathlib::Max( Mathlib::SetAll( 1.0f ) - v.dotProduct( v ),
+                                                Mathlib::SetAll( 1e-30f ) );
+            const ArrayReal largest = largestSq * Mathlib::InvSqrt4( largestSq );
+
+            // Unpack the 2-bit index of the largest component of each slot as a unorm16
+            uint16 largestIdx[ARRAY_PACKED_REALS];
+            for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+                largestIdx[i] = ( packedIdx >> ( i * 2u ) ) & 0x03u;
+            const ArrayReal idx = Mathlib::FromUnorm16( largestIdx );
+
+            const ArrayMaskR isX = Mathlib::CompareLess( idx, Mathlib::SetAll( 0.5f / 65535.0f ) );
+            const ArrayMaskR isXOrY =
+                Mathlib::CompareLess( idx, Mathlib::SetAll( 1.5f / 65535.0f ) );
+            const ArrayMaskR isNotW =
+                Mathlib::CompareLess( idx, Mathlib::SetAll( 2.5f / 65535.0f ) );
+
+            // Stored components are the ones that aren't the largest, in xyzw order
+            const ArrayReal v0 = v.mChunkBase[0];
+            const ArrayReal v1 = v.mChunkBase[1];
+            const ArrayReal v2 = v.mChunkBase[2];
+            outRot.mChunkBase[1] = Mathlib::Cmov4( largest, v0, isX );
+            outRot.mChunkBase[2] =
+                Mathlib::Cmov4( v0, Mathlib::Cmov4( largest, v1, isXOrY ), isX );
+            outRot.mChunkBase[3] =
+                Mathlib::Cmov4( v1, Mathlib::Cmov4( largest, v2, isNotW ), isXOrY );
+            outRot.mChunkBase[0] = Mathlib::Cmov4( v2, largest, isNotW );
+        }
+
+        if( mConstantChannels & ConstantScale )
+            outScale = header->scaleMin;
+        else
+        {
+            const ArrayVector3 q( Mathlib::FromUnorm16( src ),
+                                  Mathlib::FromUnorm16( src + ARRAY_PACKED_REALS ),
+                                  Mathlib::FromUnorm16( src + 2u * ARRAY_PACKED_REALS ) );
+            outScale = header->scaleMin + q * header->scaleExtent;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    FORCEINLINE void SkeletonTrack::applyKeyFrameRigAtImpl(
+        KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrameRig, float frame, ArrayReal animWeight,
+        const ArrayReal *RESTRICT_ALIAS perBoneWeights, const TransformArray &boneTransforms ) const
     {
         KeyFrameRigVec::const_iterator prevFrame = inOutLastKnownKeyFrameRig;
         KeyFrameRigVec::const_iterator nextFrame;
@@ -131,17 +321,34 @@ namespace Ogre
         ArrayVector3 *RESTRICT_ALIAS finalScale = boneTransforms[level].mScale + offset;
         ArrayQuaternion *RESTRICT_ALIAS finalRot = boneTransforms[level].mOrientation + offset;
 
-        KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
-        KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
-
         ArrayVector3 interpPos, interpScale;
         ArrayQuaternion interpRot;
-        // Interpolate keyframes' rotation not using shortestPath to respect the original animation
-        interpPos = Math::lerp( prevTransf->mPosition, nextTransf->mPosition, fTimeW );
-        interpRot = ArrayQuaternion::nlerpShortest( fTimeW,                    //
-                                                    prevTransf->mOrientation,  //
-                                                    nextTransf->mOrientation );
-        interpScale = Math::lerp( prevTransf->mScale, nextTransf->mScale, fTimeW );
+        if( !isCompressed() )
+        {
+            KfTransform *RESTRICT_ALIAS prevTransf = prevFrame->mBoneTransform;
+            KfTransform *RESTRICT_ALIAS nextTransf = nextFrame->mBoneTransform;
+
+            // Interpolate keyframes' rotation not using shortestPath to respect the original
+            // animation
+            interpPos = Math::lerp( prevTransf->mPosition, nextTransf->mPosition, fTimeW );
+            interpRot = ArrayQuaternion::nlerpShortest( fTimeW,                    //
+                                                        prevTransf->mOrientation,  //
+                                                        nextTransf->mOrientation );
+            interpScale = Math::lerp( prevTransf->mScale, nextTransf->mScale, fTimeW );
+        }
+        else
+        {
+            ArrayVector3 prevPos, prevScale, nextPos, nextScale;
+            ArrayQuaternion prevRot, nextRot;
+            decompressKeyFrame( static_cast<size_t>( prevFrame - mKeyFrameRigs.begin() ),  //
+                                prevPos, prevRot, prevScale );
+            decompressKeyFrame( static_cast<size_t>( nextFrame - mKeyFrameRigs.begin() ),  //
+                                nextPos, nextRot, nextScale );
+
+            interpPos = Math::lerp( prevPos, nextPos, fTimeW );
+            interpRot = ArrayQuaternion::nlerpShortest( fTimeW, prevRot, nextRot );
+            interpScale = Math::lerp( prevScale, nextScale, fTimeW );
+        }
 
         // Combine our internal flag (that prevents blending
         // unanimated bones) with user's custom weights
@@ -156,6 +363,33 @@ namespace Ogre
         inOutLastKnownKeyFrameRig = prevFrame;
     }
     //-----------------------------------------------------------------------------------
+#if OGRE_ARRAY_DISPATCH_AVX2
+    OGRE_ARRAY_TARGET_AVX2 void SkeletonTrack::applyKeyFrameRigAtAvx2(
+        KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrameRig, float frame, ArrayReal animWeight,
+        const ArrayReal *RESTRICT_ALIAS perBoneWeights, const TransformArray &boneTransforms ) const
+    {
+        applyKeyFrameRigAtImpl( inOutLastKnownKeyFrameRig, frame, animWeight, perBoneWeights,
+                                boneTransforms );
+    }
+#endif
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::applyKeyFrameRigAt( KeyFrameRigVec::const_iterator &inOutLastKnownKeyFrameRig,
+                                            float frame, ArrayReal animWeight,
+                                            const ArrayReal *RESTRICT_ALIAS perBoneWeights,
+                                            const TransformArray &boneTransforms ) const
+    {
+#if OGRE_ARRAY_DISPATCH_AVX2
+        if( ArrayDispatch::useAvx2() )
+        {
+            applyKeyFrameRigAtAvx2( inOutLastKnownKeyFrameRig, frame, animWeight, perBoneWeights,
+                                    boneTransforms );
+            return;
+        }
+#endif
+        applyKeyFrameRigAtImpl( inOutLastKnownKeyFrameRig, frame, animWeight, perBoneWeights,
+                                boneTransforms );
+    }
+    //-----------------------------------------------------------------------------------
     void SkeletonTrack::_bakeUnusedSlots()
     {
         assert( mUsedSlots <= ARRAY_PACKED_REALS );
@@ -185,4 +419,269 @@ namespace Ogre
             }
         }
     }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::getKeyFrameTransform( size_t keyFrameIdx, uint32 slot, Vector3 &outPos,
+                                              Quaternion &outRot, Vector3 &outScale ) const
+    {
+        assert( keyFrameIdx < mKeyFrameRigs.size() && slot < ARRAY_PACKED_REALS );
+
+        if( !isCompressed() )
+        {
+            const KfTransform *RESTRICT_ALIAS transf = mKeyFrameRigs[keyFrameIdx].mBoneTransform;
+            transf->mPosition.getAsVector3( outPos, slot );
+            transf->mOrientation.getAsQuaternion( outRot, slot );
+            transf->mScale.getAsVector3( outScale, slot );
+        }
+        else
+        {
+            ArrayVector3 pos, scale;
+            ArrayQuaternion rot;
+            decompressKeyFrame( keyFrameIdx, pos, rot, scale );
+            pos.getAsVector3( outPos, slot );
+            rot.getAsQuaternion( outRot, slot );
+            scale.getAsVector3( outScale, slot );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void SkeletonTrack::_compress( const KeyFrameCompressionSettings &settings,
+                                   KeyFrameCompressionReport &outReport )
+    {
+        OGRE_STATIC_ASSERT( ARRAY_PACKED_REALS <= 8u );  // rotLargestIdx has 2 bits per slot
+
+        const size_t numKeyFrames = mKeyFrameRigs.size();
+        if( isCompressed() || numKeyFrames == 0u )
+            return;
+
+        // Keep a copy of the original keyframes. Rotations get normalized, as the
+        // smallest-three encoding needs unit quaternions (playback normalizes them anyway)
+        OriginalKeyFrames original;
+        original.frames.resize( numKeyFrames );
+        original.positions.resize( numKeyFrames * ARRAY_PACKED_REALS );
+        original.rotations.resize( numKeyFrames * ARRAY_PACKED_REALS );
+        original.scales.resize( numKeyFrames * ARRAY_PACKED_REALS );
+        for( size_t k = 0u; k < numKeyFrames; ++k )
+        {
+            original.frames[k] = mKeyFrameRigs[k].mFrame;
+            for( uint32 i = 0u; i < ARRAY_PACKED_REALS; ++i )
+            {
+                const size_t idx = k * ARRAY_PACKED_REALS + i;
+                getKeyFrameTransform( k, i, original.positions[idx], original.rotations[idx],
+                                      original.scales[idx] );
+                original.rotations[idx].normalise();
+            }
+        }
+
+        // Find the channels that never change
+        uint8 constantChannels = ConstantPosition | ConstantRotation | ConstantScale;
+        for( size_t idx = ARRAY_PACKED_REALS; idx < original.positions.size(); ++idx )
+        {
+            const size_t firstIdx = idx % ARRAY_PACKED_REALS;
+            if( original.positions[idx].distance( original.positions[firstIdx] ) >
+                settings.positionTolerance )
+            {
+                constantChannels &= ~ConstantPosition;
+            }
+            if( rotationDifference( original.rotations[idx], original.rotations[firstIdx] ) >
+                settings.rotationTolerance )
+            {
+                constantChannels &= ~ConstantRotation;
+            }
+            if( maxAbsDifference( original.scales[idx], original.scales[firstIdx] ) >
+                settings.scaleTolerance )
+            {
+                constantChannels &= ~ConstantScale;
+            }
+        }
+
+        // Remove the keyframes that can be linearly predicted from their neighbours
+        vector<size_t>::type keptKeyFrames;
+        keptKeyFrames.reserve( numKeyFrames );
+        keptKeyFrames.push_back( 0u );
+        for( size_t k = 1u; k + 1u < numKeyFrames; ++k )
+        {
+            if( !settings.removeKeyFrames ||
+                !original.canInterpolate( keptKeyFrames.back(), k + 1u, settings ) )
+            {
+                keptKeyFrames.push_back( k );
+            }
+        }
+        if( numKeyFrames > 1u )
+            keptKeyFrames.push_back( numKeyFrames - 1u );
+        const size_t numKeptKeyFrames = keptKeyFrames.size();
+
+        // Quantization range of each slot
+        Vector3 posMin[ARRAY_PACKED_REALS], posMax[ARRAY_PACKED_REALS];
+        Vector3 scaleMin[ARRAY_PACKED_REALS], scaleMax[ARRAY_PACKED_REALS];
+        for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+        {
+            posMin[i] = posMax[i] = original.positions[i];
+            scaleMin[i] = scaleMax[i] = original.scales[i];
+            for( size_t k = 1u; k < numKeptKeyFrames; ++k )
+            {
+                const size_t idx = keptKeyFrames[k] * ARRAY_PACKED_REALS + i;
+                posMin[i].makeFloor( original.positions[idx] );
+                posMax[i].makeCeil( original.positions[idx] );
+                scaleMin[i].makeFloor( original.scales[idx] );
+                scaleMax[i].makeCeil( original.scales[idx] );
+            }
+            if( constantChannels & ConstantPosition )
+                posMax[i] = posMin[i] = original.positions[i];
+            if( constantChannels & ConstantScale )
+                scaleMax[i] = scaleMin[i] = original.scales[i];
+        }
+
+        size_t stride = 0u;
+        if( !( constantChannels & ConstantPosition ) )
+            stride += 3u * ARRAY_PACKED_REALS;
+        if( !( constantChannels & ConstantRotation ) )
+            stride += 3u * ARRAY_PACKED_REALS + 1u;
+        if( !( constantChannels & ConstantScale ) )
+            stride += 3u * ARRAY_PACKED_REALS;
+
+        RawSimdUniquePtr<uint8, MEMCATEGORY_ANIMATION> compressedData(
+            sizeof( CompressedTrackHeader ) + numKeptKeyFrames * stride * sizeof( uint16 ) );
+
+        CompressedTrackHeader *header =
+            reinterpret_cast<CompressedTrackHeader *>( compressedData.get() );
+        for( uint32 i = 0u; i < ARRAY_PACKED_REALS; ++i )
+        {
+            header->posMin.setFromVector3( posMin[i], i );
+            header->posExtent.setFromVector3( posMax[i] - posMin[i], i );
+            header->scaleMin.setFromVector3( scaleMin[i], i );
+            header->scaleExtent.setFromVector3( scaleMax[i] - scaleMin[i], i );
+            header->rotation.setFromQuaternion( original.rotations[i], i );
+        }
+
+        uint16 *dst = reinterpret_cast<uint16 *>( compressedData.get() +
+                                                  sizeof( CompressedTrackHeader ) );
+        for( size_t k = 0u; k < numKeptKeyFrames; ++k )
+        {
+            const size_t baseIdx = keptKeyFrames[k] * ARRAY_PACKED_REALS;
+
+            if( !( constantChannels & ConstantPosition ) )
+            {
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+                    {
+                        *dst++ = quantizeUnorm16( original.positions[baseIdx + i][c], posMin[i][c],
+                                                  posMax[i][c] - posMin[i][c] );
+                    }
+                }
+            }
+
+            if( !( constantChannels & ConstantRotation ) )
+            {
+                uint16 packedIdx = 0u;
+                for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+                {
+                    const Quaternion &q = original.rotations[baseIdx + i];
+                    Real xyzw[4] = { q.x, q.y, q.z, q.w };
+
+                    size_t largestIdx = 0u;
+                    for( size_t c = 1u; c < 4u; ++c )
+                    {
+                        if( Math::Abs( xyzw[c] ) > Math::Abs( xyzw[largestIdx] ) )
+                            largestIdx = c;
+                    }
+                    // q and -q are the same rotation. Make the largest one positive
+                    // so it can be reconstructed from the other three
+                    const Real sign = xyzw[largestIdx] < 0.0f ? -1.0f : 1.0f;
+
+                    size_t c = 0u;
+                    for( size_t j = 0u; j < 4u; ++j )
+                    {
+                        if( j != largestIdx )
+                        {
+                            dst[c * ARRAY_PACKED_REALS + i] = quantizeUnorm16(
+                                xyzw[j] * sign, c_smallestThreeMin, c_smallestThreeRange );
+                            ++c;
+                        }
+                    }
+                    packedIdx |= static_cast<uint16>( largestIdx << ( i * 2u ) );
+                }
+                dst += 3u * ARRAY_PACKED_REALS;
+                *dst++ = packedIdx;
+            }
+
+            if( !( constantChannels & ConstantScale ) )
+            {
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    for( size_t i = 0u; i < ARRAY_PACKED_REALS; ++i )
+                    {
+                        *dst++ = quantizeUnorm16( original.scales[baseIdx + i][c], scaleMin[i][c],
+                                                  scaleMax[i][c] - scaleMin[i][c] );
+                    }
+                }
+            }
+        }
+
+        // Keep only the surviving keyframes, which no longer use KfTransforms
+        KeyFrameRigVec keyFrameRigs;
+        keyFrameRigs.reserve( numKeptKeyFrames );
+        for( size_t k = 0u; k < numKeptKeyFrames; ++k )
+        {
+            keyFrameRigs.push_back( mKeyFrameRigs[keptKeyFrames[k]] );
+            keyFrameRigs.back().mBoneTransform = 0;
+            if( k > 0u )
+            {
+                KeyFrameRig &prevKeyFrame = keyFrameRigs[k - 1u];
+                prevKeyFrame.mInvNextFrameDistance =
+                    1.0f / ( keyFrameRigs[k].mFrame - prevKeyFrame.mFrame );
+            }
+        }
+        keyFrameRigs.back().mInvNextFrameDistance = 1.0f;
+
+        outReport.numKeyFramesBefore += numKeyFrames;
+        outReport.numKeyFramesAfter += numKeptKeyFrames;
+        outReport.bytesBefore += numKeyFrames * ( sizeof( KeyFrameRig ) + sizeof( KfTransform ) );
+        outReport.bytesAfter += numKeptKeyFrames * sizeof( KeyFrameRig ) + compressedData.size();
+
+        mKeyFrameRigs.swap( keyFrameRigs );
+        mCompressedData.swap( compressedData );
+        mCompressedStride = static_cast<uint16>( stride );
+        mConstantChannels = constantChannels;
+        mLocalMemoryManager = 0;
+
+        // Measure the error at every original keyframe, the way playback would evaluate it
+        KeyFrameRigVec::const_iterator prevFrame = mKeyFrameRigs.begin();
+        for( size_t k = 0u; k < numKeyFrames; ++k )
+        {
+            KeyFrameRigVec::const_iterator nextFrame;
+            getKeyFrameRigAt( prevFrame, nextFrame, original.frames[k] );
+
+            ArrayVector3 prevPos, prevScale, nextPos, nextScale;
+            ArrayQuaternion prevRot, nextRot;
+            decompressKeyFrame( static_cast<size_t>( prevFrame - mKeyFrameRigs.begin() ),  //
+                                prevPos, prevRot, prevScale );
+            decompressKeyFrame( static_cast<size_t>( nextFrame - mKeyFrameRigs.begin() ),  //
+                                nextPos, nextRot, nextScale );
+
+            const ArrayReal fTimeW = Mathlib::SetAll( ( original.frames[k] - prevFrame->mFrame ) *
+                                                      prevFrame->mInvNextFrameDistance );
+            const ArrayVector3 interpPos = Math::lerp( prevPos, nextPos, fTimeW );
+            const ArrayQuaternion interpRot =
+                ArrayQuaternion::nlerpShortest( fTimeW, prevRot, nextRot );
+            const ArrayVector3 interpScale = Math::lerp( prevScale, nextScale, fTimeW );
+
+            for( uint32 i = 0u; i < mUsedSlots; ++i )
+            {
+                const size_t idx = k * ARRAY_PACKED_REALS + i;
+                Vector3 vPos, vScale;
+                Quaternion qRot;
+                interpPos.getAsVector3( vPos, i );
+                interpRot.getAsQuaternion( qRot, i );
+                interpScale.getAsVector3( vScale, i );
+
+                outReport.maxPositionError = std::max(
+                    outReport.maxPositionError, vPos.distance( original.positions[idx] ) );
+                outReport.maxRotationError =
+                    std::max( outReport.maxRotationError,
+                              rotationDifference( qRot, original.rotations[idx] ) );
+                outReport.maxScaleError = std::max(
+                    outReport.maxScaleError, maxAbsDifference( vScale, original.scales[idx] ) );
+            }
+        }
+    }
 }  // namespace Ogre
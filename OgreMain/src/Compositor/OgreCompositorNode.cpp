@@ -792,6 +792,19 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    bool CompositorNode::shouldExecutePass( const CompositorPassDef *passDef,
+                                            const CompositorShadowNode *shadowNode,
+                                            uint8 executionMask )
+    {
+        const CompositorTargetDef *targetDef = passDef->getParentTargetDef();
+
+        return executionMask & passDef->mExecutionMask &&
+               ( !shadowNode || ( !shadowNode->isShadowMapIdxInValidRange( passDef->mShadowMapIdx ) ||
+                                  ( shadowNode->_shouldUpdateShadowMapIdx( passDef->mShadowMapIdx ) &&
+                                    ( shadowNode->getShadowMapLightTypeMask( passDef->mShadowMapIdx ) &
+                                      targetDef->getShadowMapSupportedLightTypes() ) ) ) );
+    }
+    //-----------------------------------------------------------------------------------
     void CompositorNode::_update( const Camera *lodCamera, SceneManager *sceneManager )
     {
         // If we're in a caster pass, we need to skip shadow map passes that have no light associated
@@ -809,13 +822,7 @@ namespace Ogre
             CompositorPass *pass = *itor;
             const CompositorPassDef *passDef = pass->getDefinition();
 
-            const CompositorTargetDef *targetDef = passDef->getParentTargetDef();
-
-            if( executionMask & passDef->mExecutionMask &&
-                ( !shadowNode || ( !shadowNode->isShadowMapIdxInValidRange( passDef->mShadowMapIdx ) ||
-                                   ( shadowNode->_shouldUpdateShadowMapIdx( passDef->mShadowMapIdx ) &&
-                                     ( shadowNode->getShadowMapLightTypeMask( passDef->mShadowMapIdx ) &
-                                       targetDef->getShadowMapSupportedLightTypes() ) ) ) ) )
+            if( shouldExecutePass( passDef, shadowNode, executionMask ) )
             {
                 // Make explicitly exposed textures available to materials during this pass.
                 const size_t oldNumTextures = sceneManager->getNumCompositorTextures();
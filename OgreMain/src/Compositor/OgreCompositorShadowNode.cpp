@@ -642,6 +642,30 @@ namespace Ogre
         SceneManager::IlluminationRenderStage previous = sceneManager->_getCurrentRenderStage();
         sceneManager->_setCurrentRenderStage( SceneManager::IRS_RENDER_TO_TEXTURE );
 
+        if( sceneManager->getConcurrentCullingEnabled() )
+        {
+            // Cull the cameras of all the passes we're about to execute (plus whatever our
+            // parent pass queued) at once. Must mirror the filtering in CompositorNode::_update
+            const CompositorShadowNode *shadowNode = sceneManager->getCurrentShadowNode();
+            const uint8 executionMask = mWorkspace->getExecutionMask();
+
+            CompositorPassVec::const_iterator itPass = mPasses.begin();
+            CompositorPassVec::const_iterator enPass = mPasses.end();
+
+            while( itPass != enPass )
+            {
+                CompositorPass *pass = *itPass;
+                if( pass->getType() == PASS_SCENE &&
+                    shouldExecutePass( pass->getDefinition(), shadowNode, executionMask ) )
+                {
+                    static_cast<CompositorPassScene *>( pass )->_queuePreCull( lodCamera );
+                }
+                ++itPass;
+            }
+
+            sceneManager->_flushPreCullFrustums();
+        }
+
         // Now render all passes
         CompositorNode::_update( lodCamera, sceneManager );
 
@@ -169,6 +169,22 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void CompositorPassScene::_queuePreCull( const Camera *lodCamera )
+    {
+        // Don't bother with passes that won't execute, won't cull, or will modify
+        // the camera right before culling. Must mirror execute()
+        if( !mNumPassesLeft || mDefinition->mReuseCullData || mDefinition->mCameraCubemapReorient )
+            return;
+
+        Camera const *usedLodCamera = mLodCamera;
+        if( lodCamera && mDefinition->mLodCameraName == IdString() )
+            usedLodCamera = lodCamera;
+
+        SceneManager *sceneManager = mCamera->getSceneManager();
+        sceneManager->_queuePreCullFrustum( mCullCamera, usedLodCamera, mDefinition->mFirstRQ,
+                                            mDefinition->mLastRQ, mDefinition->mVisibilityMask );
+    }
+    //-----------------------------------------------------------------------------------
     void CompositorPassScene::execute( const Camera *lodCamera )
     {
         // Execute a limited number of times?
@@ -253,6 +269,14 @@ namespace Ogre
             // (ie VR) shadows are not 'over culled'
             mCullCamera->_notifyViewport( viewport );
 
+            if( !mDefinition->mReuseCullData )
+            {
+                // Get culled together with the shadow node's cameras
+                sceneManager->_queuePreCullFrustum( mCullCamera, usedLodCamera,
+                                                    mDefinition->mFirstRQ, mDefinition->mLastRQ,
+                                                    oldVisibilityMask );
+            }
+
             shadowNode->_update( mCullCamera, usedLodCamera, sceneManager );
 
             // ShadowNode passes may've overriden these settings.
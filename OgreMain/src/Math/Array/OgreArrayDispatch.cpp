@@ -0,0 +1,51 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Math/Array/OgreArrayDispatch.h"
+
+#include "OgrePlatformInformation.h"
+
+namespace Ogre
+{
+    bool ArrayDispatch::msUseAvx2 = ArrayDispatch::isAvx2Supported();
+    //-----------------------------------------------------------------------------------
+    void ArrayDispatch::setAvx2Enabled( bool bEnable ) { msUseAvx2 = bEnable && isAvx2Supported(); }
+    //-----------------------------------------------------------------------------------
+    bool ArrayDispatch::isAvx2Supported()
+    {
+#if OGRE_ARRAY_DISPATCH_AVX2
+        const uint requiredFeatures =
+            PlatformInformation::CPU_FEATURE_AVX2 | PlatformInformation::CPU_FEATURE_FMA;
+        return ( PlatformInformation::getCpuFeatures() & requiredFeatures ) == requiredFeatures;
+#else
+        return false;
+#endif
+    }
+}  // namespace Ogre
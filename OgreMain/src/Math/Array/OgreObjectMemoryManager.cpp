@@ -30,16 +30,19 @@ THE SOFTWARE.
 
 #include "Math/Array/OgreObjectMemoryManager.h"
 
+#include "Math/Array/OgreObjectSpatialIndex.h"
 #include "OgreMovableObject.h"
 
 namespace Ogre
 {
     ObjectMemoryManager::ObjectMemoryManager() :
         mTotalObjects( 0 ),
+        mLayoutRevision( 0 ),
         mDummyNode( 0 ),
         mDummyObject( 0 ),
         mMemoryManagerType( SCENE_DYNAMIC ),
-        mTwinMemoryManager( 0 )
+        mTwinMemoryManager( 0 ),
+        mSpatialIndexEnabled( false )
     {
         // Manually allocate the memory for the dummy scene nodes (since we can't pass ourselves
         // or yet another object) We only allocate what's needed to prevent access violations.
@@ -76,6 +79,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     ObjectMemoryManager::~ObjectMemoryManager()
     {
+        setSpatialIndexEnabled( false );
+
         ArrayMemoryManagerVec::iterator itor = mMemoryManagers.begin();
         ArrayMemoryManagerVec::iterator endt = mMemoryManagers.end();
 
@@ -132,6 +137,7 @@ namespace Ogre
 
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[renderQueue];
         mgr.createNewNode( outObjectData );
+        notifyLayoutChanged( renderQueue );
 
         ++mTotalObjects;
     }
@@ -149,6 +155,9 @@ namespace Ogre
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[oldRenderQueue];
         mgr.destroyNode( inOutObjectData );
 
+        notifyLayoutChanged( oldRenderQueue );
+        notifyLayoutChanged( newRenderQueue );
+
         inOutObjectData = tmp;
     }
     //-----------------------------------------------------------------------------------
@@ -156,6 +165,7 @@ namespace Ogre
     {
         ObjectDataArrayMemoryManager &mgr = mMemoryManagers[renderQueue];
         mgr.destroyNode( outObjectData );
+        notifyLayoutChanged( renderQueue );
 
         --mTotalObjects;
     }
@@ -178,6 +188,7 @@ namespace Ogre
         while( itor != endt )
         {
             itor->defragment();
+            notifyLayoutChanged( static_cast<size_t>( itor - mMemoryManagers.begin() ) );
             ++itor;
         }
     }
@@ -227,6 +238,60 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::setSpatialIndexEnabled( bool bEnabled )
+    {
+        mSpatialIndexEnabled = bEnabled;
+
+        if( !bEnabled )
+        {
+            FastArray<ObjectSpatialIndex *>::const_iterator itor = mSpatialIndices.begin();
+            FastArray<ObjectSpatialIndex *>::const_iterator endt = mSpatialIndices.end();
+
+            while( itor != endt )
+            {
+                OGRE_DELETE *itor;
+                ++itor;
+            }
+
+            mSpatialIndices.clear();
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    const ObjectSpatialIndex *ObjectMemoryManager::getSpatialIndex( size_t renderQueue ) const
+    {
+        if( renderQueue >= mSpatialIndices.size() || mSpatialIndices[renderQueue]->needsRebuild() )
+            return 0;
+        return mSpatialIndices[renderQueue];
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::notifyLayoutChanged( size_t renderQueue )
+    {
+        ++mLayoutRevision;
+        if( renderQueue < mSpatialIndices.size() )
+            mSpatialIndices[renderQueue]->_notifyLayoutChanged();
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectMemoryManager::_updateSpatialIndices()
+    {
+        if( !mSpatialIndexEnabled )
+            return;
+
+        while( mSpatialIndices.size() < mMemoryManagers.size() )
+            mSpatialIndices.push_back( OGRE_NEW ObjectSpatialIndex() );
+
+        for( size_t i = 0; i < mMemoryManagers.size(); ++i )
+        {
+            ObjectData objData;
+            const size_t numObjs = getFirstObjectData( objData, i );
+
+            ObjectSpatialIndex *spatialIndex = mSpatialIndices[i];
+            if( spatialIndex->needsRebuild() || spatialIndex->getNumObjects() != numObjs )
+                spatialIndex->build( objData, numObjs, mDummyObject );
+            else
+                spatialIndex->refit( objData, mDummyObject );
+        }
+    }
+    //-----------------------------------------------------------------------------------
     size_t ObjectMemoryManager::getFirstObjectData( ObjectData &outObjectData, size_t renderQueue )
     {
         return mMemoryManagers[renderQueue].getFirstNode( outObjectData );
@@ -257,6 +322,8 @@ namespace Ogre
     void ObjectMemoryManager::applyRebase( uint16 level, const MemoryPoolVec &newBasePtrs,
                                            const ArrayMemoryManager::PtrdiffVec &diffsList )
     {
+        notifyLayoutChanged( level );
+
         ObjectData objectData;
         const size_t numObjs = this->getFirstObjectData( objectData, level );
 
@@ -279,6 +346,8 @@ namespace Ogre
                                               size_t const *elementsMemSizes, size_t startInstance,
                                               size_t diffInstances )
     {
+        notifyLayoutChanged( level );
+
         ObjectData objectData;
         const size_t numObjs = this->getFirstObjectData( objectData, level );
 
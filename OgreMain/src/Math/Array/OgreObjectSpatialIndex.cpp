@@ -0,0 +1,316 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Math/Array/OgreObjectSpatialIndex.h"
+
+#include "Math/Simple/OgreAabb.h"
+#include "OgrePlane.h"
+#include "OgreRay.h"
+#include "OgreSphere.h"
+
+namespace Ogre
+{
+    const uint32 ObjectSpatialIndex::c_innerNode = std::numeric_limits<uint32>::max();
+
+    /// Objects with infinite bounds are clamped to this, so that the math stays NaN-free
+    static const Real c_maxExtent = Real( 1e30 );
+
+    struct CompareNodeCentroids
+    {
+        size_t axis;
+        CompareNodeCentroids( size_t _axis ) : axis( _axis ) {}
+        bool operator()( const ObjectSpatialIndex::Node &a, const ObjectSpatialIndex::Node &b ) const
+        {
+            return a.vMin[axis] + a.vMax[axis] < b.vMin[axis] + b.vMax[axis];
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    ObjectSpatialIndex::ObjectSpatialIndex() : mNumObjects( 0 ), mNeedsRebuild( true ) {}
+    //-----------------------------------------------------------------------------------
+    bool ObjectSpatialIndex::calculateObjectBounds( const ObjectData &objData, size_t objectIdx,
+                                                    const MovableObject *dummyObject, Node &outNode )
+    {
+        const MovableObject *owner = objData.mOwner[objectIdx];
+        if( !owner || owner == dummyObject )
+        {
+            // Unused slots get an inverted box, which fails every test
+            outNode.vMin = Vector3( c_maxExtent );
+            outNode.vMax = Vector3( -c_maxExtent );
+            outNode.maxRadius = 0;
+            return false;
+        }
+
+        Aabb aabb;
+        objData.mWorldAabb[objectIdx / ARRAY_PACKED_REALS].getAsAabb( aabb,
+                                                                   objectIdx % ARRAY_PACKED_REALS );
+        outNode.vMin = aabb.getMinimum();
+        outNode.vMax = aabb.getMaximum();
+        outNode.vMin.makeCeil( Vector3( -c_maxExtent ) );
+        outNode.vMax.makeFloor( Vector3( c_maxExtent ) );
+        outNode.maxRadius = std::min( objData.mWorldRadius[objectIdx], c_maxExtent );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 ObjectSpatialIndex::buildNode( FastArray<Node> &leaves, size_t first, size_t last )
+    {
+        const uint32 nodeIdx = static_cast<uint32>( mNodes.size() );
+
+        if( last - first == 1u )
+        {
+            mNodes.push_back( leaves[first] );
+            mNodes.back().skipIdx = nodeIdx + 1u;
+            return nodeIdx;
+        }
+
+        Node node;
+        node.vMin = Vector3( c_maxExtent );
+        node.vMax = Vector3( -c_maxExtent );
+        node.maxRadius = 0;
+        node.objectIdx = c_innerNode;
+
+        Vector3 centroidMin( c_maxExtent );
+        Vector3 centroidMax( -c_maxExtent );
+        for( size_t i = first; i < last; ++i )
+        {
+            node.vMin.makeFloor( leaves[i].vMin );
+            node.vMax.makeCeil( leaves[i].vMax );
+            node.maxRadius = std::max( node.maxRadius, leaves[i].maxRadius );
+            const Vector3 centroid = ( leaves[i].vMin + leaves[i].vMax ) * 0.5f;
+            centroidMin.makeFloor( centroid );
+            centroidMax.makeCeil( centroid );
+        }
+        mNodes.push_back( node );
+
+        // Split at the median along the axis where the centroids are most spread
+        const Vector3 centroidExtent = centroidMax - centroidMin;
+        size_t axis = 0;
+        if( centroidExtent.y > centroidExtent[axis] )
+            axis = 1;
+        if( centroidExtent.z > centroidExtent[axis] )
+            axis = 2;
+
+        const size_t mid = ( first + last ) >> 1u;
+        std::nth_element( leaves.begin() + first, leaves.begin() + mid, leaves.begin() + last,
+                          CompareNodeCentroids( axis ) );
+
+        buildNode( leaves, first, mid );
+        buildNode( leaves, mid, last );
+
+        mNodes[nodeIdx].skipIdx = static_cast<uint32>( mNodes.size() );
+
+        return nodeIdx;
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::build( const ObjectData &objData, size_t numObjects,
+                                    const MovableObject *dummyObject )
+    {
+        mNodes.clear();
+        mNumObjects = numObjects;
+        mNeedsRebuild = false;
+
+        FastArray<Node> leaves;
+        leaves.reserve( numObjects );
+
+        for( size_t i = 0; i < numObjects; ++i )
+        {
+            Node leaf;
+            if( calculateObjectBounds( objData, i, dummyObject, leaf ) )
+            {
+                leaf.objectIdx = static_cast<uint32>( i );
+                leaves.push_back( leaf );
+            }
+        }
+
+        if( !leaves.empty() )
+        {
+            mNodes.reserve( leaves.size() * 2u - 1u );
+            buildNode( leaves, 0u, leaves.size() );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::refit( const ObjectData &objData, const MovableObject *dummyObject )
+    {
+        // Children always come after their parent, thus going backwards
+        // guarantees they have been refit by the time we reach the parent.
+        for( size_t i = mNodes.size(); i--; )
+        {
+            Node &node = mNodes[i];
+            if( node.objectIdx != c_innerNode )
+            {
+                calculateObjectBounds( objData, node.objectIdx, dummyObject, node );
+            }
+            else
+            {
+                const Node &firstChild = mNodes[i + 1u];
+                const Node &secondChild = mNodes[firstChild.skipIdx];
+                node.vMin = firstChild.vMin;
+                node.vMin.makeFloor( secondChild.vMin );
+                node.vMax = firstChild.vMax;
+                node.vMax.makeCeil( secondChild.vMax );
+                node.maxRadius = std::max( firstChild.maxRadius, secondChild.maxRadius );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::sortPacks( FastArray<uint32> &outPacks, size_t firstPack )
+    {
+        std::sort( outPacks.begin() + firstPack, outPacks.end() );
+        FastArray<uint32>::iterator newEnd =
+            std::unique( outPacks.begin() + firstPack, outPacks.end() );
+        outPacks.resizePOD( static_cast<size_t>( newEnd - outPacks.begin() ) );
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::cullFrustum( const Plane *planes, FastArray<uint32> &outPacks ) const
+    {
+        const size_t firstPack = outPacks.size();
+        const size_t numNodes = mNodes.size();
+        size_t i = 0;
+        while( i < numNodes )
+        {
+            const Node &node = mNodes[i];
+
+            bool isOutside = false;
+            bool isFullyInside = true;
+            for( size_t j = 0; j < 6u && !isOutside; ++j )
+            {
+                // Same test as MovableObject::cullFrustum, with the corners closest
+                // to & farthest from the plane in the direction of its normal.
+                const Vector3 &normal = planes[j].normal;
+                const Vector3 farCorner( normal.x >= 0 ? node.vMax.x : node.vMin.x,
+                                         normal.y >= 0 ? node.vMax.y : node.vMin.y,
+                                         normal.z >= 0 ? node.vMax.z : node.vMin.z );
+                const Vector3 nearCorner( normal.x >= 0 ? node.vMin.x : node.vMax.x,
+                                          normal.y >= 0 ? node.vMin.y : node.vMax.y,
+                                          normal.z >= 0 ? node.vMin.z : node.vMax.z );
+                if( normal.dotProduct( farCorner ) <= -planes[j].d )
+                    isOutside = true;
+                else if( normal.dotProduct( nearCorner ) <= -planes[j].d )
+                    isFullyInside = false;
+            }
+
+            if( isOutside )
+            {
+                i = node.skipIdx;
+            }
+            else if( isFullyInside )
+            {
+                // Everything below is inside. No need to test further
+                for( size_t j = i; j < node.skipIdx; ++j )
+                {
+                    if( mNodes[j].objectIdx != c_innerNode )
+                        addPack( mNodes[j], outPacks );
+                }
+                i = node.skipIdx;
+            }
+            else
+            {
+                if( node.objectIdx != c_innerNode )
+                    addPack( node, outPacks );
+                ++i;
+            }
+        }
+
+        sortPacks( outPacks, firstPack );
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::queryAabb( const Aabb &aabb, FastArray<uint32> &outPacks ) const
+    {
+        const size_t firstPack = outPacks.size();
+        const Vector3 vMin = aabb.getMinimum();
+        const Vector3 vMax = aabb.getMaximum();
+
+        const size_t numNodes = mNodes.size();
+        size_t i = 0;
+        while( i < numNodes )
+        {
+            const Node &node = mNodes[i];
+
+            if( node.vMin.x > vMax.x || node.vMin.y > vMax.y || node.vMin.z > vMax.z ||
+                node.vMax.x < vMin.x || node.vMax.y < vMin.y || node.vMax.z < vMin.z )
+            {
+                i = node.skipIdx;
+            }
+            else
+            {
+                if( node.objectIdx != c_innerNode )
+                    addPack( node, outPacks );
+                ++i;
+            }
+        }
+
+        sortPacks( outPacks, firstPack );
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::querySphere( const Sphere &sphere, FastArray<uint32> &outPacks ) const
+    {
+        const size_t firstPack = outPacks.size();
+        const Vector3 &center = sphere.getCenter();
+
+        const size_t numNodes = mNodes.size();
+        size_t i = 0;
+        while( i < numNodes )
+        {
+            const Node &node = mNodes[i];
+
+            // The centers of the objects are inside the node, thus an object's sphere can only
+            // touch ours if the node is within our radius + the largest object radius.
+            Vector3 closest = center;
+            closest.makeCeil( node.vMin );
+            closest.makeFloor( node.vMax );
+            const Real maxDistance = sphere.getRadius() + node.maxRadius;
+
+            if( closest.squaredDistance( center ) > maxDistance * maxDistance )
+            {
+                i = node.skipIdx;
+            }
+            else
+            {
+                if( node.objectIdx != c_innerNode )
+                    addPack( node, outPacks );
+                ++i;
+            }
+        }
+
+        sortPacks( outPacks, firstPack );
+    }
+    //-----------------------------------------------------------------------------------
+    void ObjectSpatialIndex::queryRay( const Ray &ray, FastArray<uint32> &outPacks ) const
+    {
+        const size_t firstPack = outPacks.size();
+
+        Real maxDistance = std::numeric_limits<Real>::infinity();
+        auto addLeafPack = [&]( uint32 objectIdx, Real & )
+        { outPacks.push_back( objectIdx / ARRAY_PACKED_REALS ); };
+        raycast( ray, maxDistance, addLeafPack );
+
+        sortPacks( outPacks, firstPack );
+    }
+}  // namespace Ogre
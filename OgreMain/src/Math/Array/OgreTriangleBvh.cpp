@@ -0,0 +1,317 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Math/Array/OgreTriangleBvh.h"
+
+#include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreMathlib.h"
+#include "OgreRay.h"
+
+namespace Ogre
+{
+    const uint32 TriangleBvh::c_innerNode = std::numeric_limits<uint32>::max();
+
+    struct TriangleBvh::BuildEntry
+    {
+        Vector3 vMin;
+        Vector3 vMax;
+        uint32  triangleIdx;
+    };
+
+    struct CompareTriangleCentroids
+    {
+        size_t axis;
+        CompareTriangleCentroids( size_t _axis ) : axis( _axis ) {}
+        bool operator()( const TriangleBvh::BuildEntry &a, const TriangleBvh::BuildEntry &b ) const
+        {
+            return a.vMin[axis] + a.vMax[axis] < b.vMin[axis] + b.vMax[axis];
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    TriangleBvh::TriangleBvh() : mNumTriangles( 0 ) {}
+    //-----------------------------------------------------------------------------------
+    void TriangleBvh::addTriangle( const Vector3 &v0, const Vector3 &v1, const Vector3 &v2 )
+    {
+        mPendingVertices.push_back( v0 );
+        mPendingVertices.push_back( v1 );
+        mPendingVertices.push_back( v2 );
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 TriangleBvh::buildNode( FastArray<BuildEntry> &entries, size_t first, size_t last )
+    {
+        const uint32 nodeIdx = static_cast<uint32>( mNodes.size() );
+
+        Node node;
+        node.vMin = entries[first].vMin;
+        node.vMax = entries[first].vMax;
+        node.skipIdx = nodeIdx + 1u;
+        node.packIdx = c_innerNode;
+
+        Vector3 centroidMin( entries[first].vMin + entries[first].vMax );
+        Vector3 centroidMax( centroidMin );
+        for( size_t i = first + 1u; i < last; ++i )
+        {
+            node.vMin.makeFloor( entries[i].vMin );
+            node.vMax.makeCeil( entries[i].vMax );
+            const Vector3 centroid = entries[i].vMin + entries[i].vMax;
+            centroidMin.makeFloor( centroid );
+            centroidMax.makeCeil( centroid );
+        }
+
+        if( last - first <= ARRAY_PACKED_REALS )
+        {
+            // Leaf. Every leaf but the last one is full, see below
+            node.packIdx = static_cast<uint32>( first / ARRAY_PACKED_REALS );
+            mNodes.push_back( node );
+
+            TrianglePack &pack = mPacks.get()[node.packIdx];
+            for( size_t i = first; i < last; ++i )
+            {
+                const uint32 triangleIdx = entries[i].triangleIdx;
+                const Vector3 &v0 = mPendingVertices[triangleIdx * 3u + 0u];
+                const Vector3 &v1 = mPendingVertices[triangleIdx * 3u + 1u];
+                const Vector3 &v2 = mPendingVertices[triangleIdx * 3u + 2u];
+
+                const size_t lane = i % ARRAY_PACKED_REALS;
+                pack.v0.setFromVector3( v0, lane );
+                pack.edge1.setFromVector3( v1 - v0, lane );
+                pack.edge2.setFromVector3( v2 - v0, lane );
+                mTriangleIds[i] = triangleIdx;
+            }
+
+            return nodeIdx;
+        }
+
+        mNodes.push_back( node );
+
+        // Split at the median along the axis where the centroids are most spread.
+        // The left side always gets a multiple of ARRAY_PACKED_REALS so that leaves are full.
+        const Vector3 centroidExtent = centroidMax - centroidMin;
+        size_t axis = 0;
+        if( centroidExtent.y > centroidExtent[axis] )
+            axis = 1;
+        if( centroidExtent.z > centroidExtent[axis] )
+            axis = 2;
+
+        const size_t mid =
+            first + alignToNextMultiple<size_t>( ( last - first ) >> 1u, ARRAY_PACKED_REALS );
+        std::nth_element( entries.begin() + first, entries.begin() + mid, entries.begin() + last,
+                          CompareTriangleCentroids( axis ) );
+
+        buildNode( entries, first, mid );
+        buildNode( entries, mid, last );
+
+        mNodes[nodeIdx].skipIdx = static_cast<uint32>( mNodes.size() );
+
+        return nodeIdx;
+    }
+    //-----------------------------------------------------------------------------------
+    void TriangleBvh::build()
+    {
+        mNodes.clear();
+        mTriangleIds.clear();
+
+        mNumTriangles = mPendingVertices.size() / 3u;
+        const size_t numPacks = ( mNumTriangles + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+
+        RawSimdUniquePtr<TrianglePack, MEMCATEGORY_GEOMETRY> packs( numPacks );
+        mPacks.swap( packs );
+
+        if( numPacks )
+        {
+            // Unused lanes stay degenerate (all zeroes), which never hit
+            memset( static_cast<void *>( mPacks.get() ), 0, numPacks * sizeof( TrianglePack ) );
+            mTriangleIds.resizePOD( numPacks * ARRAY_PACKED_REALS, c_innerNode );
+
+            FastArray<BuildEntry> entries;
+            entries.resizePOD( mNumTriangles );
+            for( size_t i = 0; i < mNumTriangles; ++i )
+            {
+                const Vector3 &v0 = mPendingVertices[i * 3u + 0u];
+                const Vector3 &v1 = mPendingVertices[i * 3u + 1u];
+                const Vector3 &v2 = mPendingVertices[i * 3u + 2u];
+                entries[i].vMin = v0;
+                entries[i].vMin.makeFloor( v1 );
+                entries[i].vMin.makeFloor( v2 );
+                entries[i].vMax = v0;
+                entries[i].vMax.makeCeil( v1 );
+                entries[i].vMax.makeCeil( v2 );
+                entries[i].triangleIdx = static_cast<uint32>( i );
+            }
+
+            mNodes.reserve( numPacks * 2u );
+            buildNode( entries, 0u, mNumTriangles );
+        }
+
+        mPendingVertices.destroy();
+    }
+    //-----------------------------------------------------------------------------------
+    void TriangleBvh::clear()
+    {
+        mPendingVertices.destroy();
+        mNodes.destroy();
+        mTriangleIds.destroy();
+        RawSimdUniquePtr<TrianglePack, MEMCATEGORY_GEOMETRY> packs;
+        mPacks.swap( packs );
+        mNumTriangles = 0;
+    }
+    //-----------------------------------------------------------------------------------
+    size_t TriangleBvh::getMemoryUsage() const
+    {
+        return mNodes.capacity() * sizeof( Node ) + mPacks.size() * sizeof( TrianglePack ) +
+               mTriangleIds.capacity() * sizeof( uint32 );
+    }
+    //-----------------------------------------------------------------------------------
+    inline bool TriangleBvh::intersectsPack( const ArrayVector3 &origin, const ArrayVector3 &dir,
+                                             uint32 packIdx, CullingMode cullMode,
+                                             Hit &inOutHit ) const
+    {
+        // Möller-Trumbore, against ARRAY_PACKED_REALS triangles at once
+        const TrianglePack &pack = mPacks.get()[packIdx];
+
+        const ArrayVector3 pvec = dir.crossProduct( pack.edge2 );
+        const ArrayReal det = pack.edge1.dotProduct( pvec );
+        const ArrayReal invDet = Mathlib::Inv4( det );
+
+        const ArrayVector3 tvec = origin - pack.v0;
+        const ArrayReal u = tvec.dotProduct( pvec ) * invDet;
+
+        const ArrayVector3 qvec = tvec.crossProduct( pack.edge1 );
+        const ArrayReal v = dir.dotProduct( qvec ) * invDet;
+        const ArrayReal t = pack.edge2.dotProduct( qvec ) * invDet;
+
+        // det > 0 when the triangle is anticlockwise as seen from the ray's origin.
+        // Degenerate triangles (and the unused lanes) have det = 0
+        ArrayReal cullDet;
+        if( cullMode == CULL_CLOCKWISE )
+            cullDet = det;
+        else if( cullMode == CULL_ANTICLOCKWISE )
+            cullDet = ARRAY_REAL_ZERO - det;
+        else
+            cullDet = Mathlib::Abs4( det );
+
+        ArrayMaskR mask = Mathlib::CompareGreater( cullDet, Mathlib::SetAll( 1e-20f ) );
+        mask = Mathlib::And( mask, Mathlib::CompareGreaterEqual( u, ARRAY_REAL_ZERO ) );
+        mask = Mathlib::And( mask, Mathlib::CompareGreaterEqual( v, ARRAY_REAL_ZERO ) );
+        mask = Mathlib::And( mask, Mathlib::CompareLessEqual( u + v, Mathlib::ONE ) );
+        mask = Mathlib::And( mask, Mathlib::CompareGreaterEqual( t, ARRAY_REAL_ZERO ) );
+        mask = Mathlib::And( mask, Mathlib::CompareLess( t, Mathlib::SetAll( inOutHit.distance ) ) );
+
+        const uint32 scalarMask = BooleanMask4::getScalarMask( mask );
+        if( !scalarMask )
+            return false;
+
+        OGRE_ALIGNED_DECL( Real, tValues[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        OGRE_ALIGNED_DECL( Real, uValues[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        OGRE_ALIGNED_DECL( Real, vValues[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        CastArrayToReal( tValues, t );
+        CastArrayToReal( uValues, u );
+        CastArrayToReal( vValues, v );
+
+        for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+        {
+            if( IS_BIT_SET( i, scalarMask ) && tValues[i] < inOutHit.distance )
+            {
+                inOutHit.distance = tValues[i];
+                inOutHit.triangleIdx = mTriangleIds[packIdx * ARRAY_PACKED_REALS + i];
+                inOutHit.u = uValues[i];
+                inOutHit.v = vValues[i];
+            }
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    template <bool bAnyHit>
+    bool TriangleBvh::traverse( const Ray &ray, CullingMode cullMode, Hit &inOutHit ) const
+    {
+        const FastArray<Node> &nodes = mNodes;
+
+        const Vector3 invDir = ray.getInvDirection();
+
+        ArrayVector3 arrayOrigin, arrayDir;
+        arrayOrigin.setAll( ray.getOrigin() );
+        arrayDir.setAll( ray.getDirection() );
+
+        bool hit = false;
+
+        const size_t numNodes = nodes.size();
+        size_t i = 0;
+        while( i < numNodes )
+        {
+            const Node &node = nodes[i];
+
+            // Up to the closest hit so far
+            if( !ray.intersectsSlab( invDir, node.vMin, node.vMax, inOutHit.distance ) )
+            {
+                i = node.skipIdx;
+            }
+            else
+            {
+                if( node.packIdx != c_innerNode )
+                {
+                    if( intersectsPack( arrayOrigin, arrayDir, node.packIdx, cullMode, inOutHit ) )
+                    {
+                        hit = true;
+                        if( bAnyHit )
+                            return true;
+                    }
+                }
+                ++i;
+            }
+        }
+
+        return hit;
+    }
+    //-----------------------------------------------------------------------------------
+    bool TriangleBvh::intersects( const Ray &ray, Real maxDistance, Hit &outHit,
+                                  CullingMode cullMode ) const
+    {
+        Hit hit;
+        hit.distance = maxDistance;
+        hit.triangleIdx = c_innerNode;
+        hit.u = 0;
+        hit.v = 0;
+        if( !traverse<false>( ray, cullMode, hit ) )
+            return false;
+        outHit = hit;
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool TriangleBvh::intersectsAny( const Ray &ray, Real maxDistance, CullingMode cullMode ) const
+    {
+        Hit hit;
+        hit.distance = maxDistance;
+        hit.triangleIdx = c_innerNode;
+        hit.u = 0;
+        hit.v = 0;
+        return traverse<true>( ray, cullMode, hit );
+    }
+}  // namespace Ogre
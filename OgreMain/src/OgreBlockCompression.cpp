@@ -0,0 +1,1885 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreBlockCompression.h"
+
+#include "OgreException.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureBox.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#if __OGRE_HAVE_SSE
+#    include <emmintrin.h>
+#elif __OGRE_HAVE_NEON
+#    include <arm_neon.h>
+#endif
+
+namespace Ogre
+{
+    namespace
+    {
+        // clang-format off
+        /// BC7 partitions with 2 subsets. Bit i is the subset of pixel i.
+        const uint16 c_bc7Partitions2[64] =
+        {
+            0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+            0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+            0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+            0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+            0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+            0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+            0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+            0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+        };
+        /// BC7 partitions with 3 subsets. Bits [2i; 2i + 1] are the subset of pixel i.
+        const uint32 c_bc7Partitions3[64] =
+        {
+            0xAA685050, 0x6A5A5040, 0x5A5A4200, 0x5450A0A8, 0xA5A50000, 0xA0A05050,
+            0x5555A0A0, 0x5A5A5050, 0xAA550000, 0xAA555500, 0xAAAA5500, 0x90909090,
+            0x94949494, 0xA4A4A4A4, 0xA9A59450, 0x2A0A4250, 0xA5945040, 0x0A425054,
+            0xA5A5A500, 0x55A0A0A0, 0xA8A85454, 0x6A6A4040, 0xA4A45000, 0x1A1A0500,
+            0x0050A4A4, 0xAAA59090, 0x14696914, 0x69691400, 0xA08585A0, 0xAA821414,
+            0x50A4A450, 0x6A5A0200, 0xA9A58000, 0x5090A0A8, 0xA8A09050, 0x24242424,
+            0x00AA5500, 0x24924924, 0x24499224, 0x50A50A50, 0x500AA550, 0xAAAA4444,
+            0x66660000, 0xA5A0A5A0, 0x50A050A0, 0x69286928, 0x44AAAA44, 0x66666600,
+            0xAA444444, 0x54A854A8, 0x95809580, 0x96969600, 0xA85454A8, 0x80959580,
+            0xAA141414, 0x96960000, 0xAAAA1414, 0xA05050A0, 0xA0A5A5A0, 0x96000000,
+            0x40804080, 0xA9A8A9A8, 0xAAAAAA44, 0x2A4A5254
+        };
+        /// Anchor pixel of the 2nd subset, for 2 subsets. The anchor of the 1st subset is always 0.
+        const uint8 c_bc7Anchors2[64] =
+        {
+            15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+            15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+            15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+             6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15
+        };
+        /// Anchor pixel of the 2nd subset, for 3 subsets
+        const uint8 c_bc7Anchors3a[64] =
+        {
+             3,  3, 15, 15,  8,  3, 15, 15,  8,  8,  6,  6,  6,  5,  3,  3,
+             3,  3,  8, 15,  3,  3,  6, 10,  5,  8,  8,  6,  8,  5, 15, 15,
+             8, 15,  3,  5,  6, 10,  8, 15, 15,  3, 15,  5, 15, 15, 15, 15,
+             3, 15,  5,  5,  5,  8,  5, 10,  5, 10,  8, 13, 15, 12,  3,  3
+        };
+        /// Anchor pixel of the 3rd subset, for 3 subsets
+        const uint8 c_bc7Anchors3b[64] =
+        {
+            15,  8,  8,  3, 15, 15,  3,  8, 15, 15, 15, 15, 15, 15, 15,  8,
+            15,  8, 15,  3, 15,  8, 15,  8,  3, 15,  6, 10, 15, 15, 10,  8,
+            15,  3, 15, 10, 10,  8,  9, 10,  6, 15,  8, 15,  3,  6,  6,  8,
+            15,  3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,  3, 15, 15,  8
+        };
+        const uint8 c_bc7Weights2[4] = { 0, 21, 43, 64 };
+        const uint8 c_bc7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+        const uint8 c_bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        struct Bc7ModeInfo
+        {
+            uint8 numSubsets;
+            uint8 partitionBits;
+            uint8 rotationBits;
+            uint8 indexSelectionBits;
+            uint8 colourBits;
+            uint8 alphaBits;
+            uint8 endpointPBits;
+            uint8 sharedPBits;
+            uint8 indexBits;
+            uint8 indexBits2;
+        };
+
+        const Bc7ModeInfo c_bc7Modes[8] =
+        {
+            { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+            { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+            { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+            { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+            { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+            { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+            { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+            { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+        };
+
+        /// ETC1 intensity modifiers. Pixel indices 0 & 1 add them, 2 & 3 subtract them.
+        const int32 c_etc1Modifiers[8][2] =
+        {
+            { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 }, { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+        };
+        /// ETC2 T & H mode distances
+        const int32 c_etc2Distances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+        const int32 c_eacModifiers[16][8] =
+        {
+            { -3, -6,  -9, -15, 2, 5, 8, 14 },
+            { -3, -7, -10, -13, 2, 6, 9, 12 },
+            { -2, -5,  -8, -13, 1, 4, 7, 12 },
+            { -2, -4,  -6, -13, 1, 3, 5, 12 },
+            { -3, -6,  -8, -12, 2, 5, 7, 11 },
+            { -3, -7,  -9, -11, 2, 6, 8, 10 },
+            { -4, -7,  -8, -11, 3, 6, 7, 10 },
+            { -3, -5,  -8, -11, 2, 4, 7, 10 },
+            { -2, -6,  -8, -10, 1, 5, 7,  9 },
+            { -2, -5,  -8, -10, 1, 4, 7,  9 },
+            { -2, -4,  -8, -10, 1, 3, 7,  9 },
+            { -2, -5,  -7, -10, 1, 4, 6,  9 },
+            { -3, -4,  -7, -10, 2, 3, 6,  9 },
+            { -1, -2,  -3, -10, 0, 1, 2,  9 },
+            { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+            { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+        };
+        // clang-format on
+
+        inline int32 clampInt( int32 value, int32 minValue, int32 maxValue )
+        {
+            return std::min( std::max( value, minValue ), maxValue );
+        }
+
+        inline uint8 clampU8( int32 value ) { return static_cast<uint8>( clampInt( value, 0, 255 ) ); }
+
+        /// Division rounding to nearest, halves away from zero
+        inline int32 roundedDiv( int32 num, int32 den )
+        {
+            return num >= 0 ? ( num + den / 2 ) / den : -( ( -num + den / 2 ) / den );
+        }
+
+        /// Reads signed 8-bit values the way the GPU does (i.e. -128 is treated as -127)
+        inline int32 readSnorm8( uint8 value )
+        {
+            return std::max<int32>( static_cast<int8>( value ), -127 );
+        }
+
+        struct BitWriter
+        {
+            uint8 *data;
+            uint32 bitPos;
+
+            BitWriter( uint8 *_data, size_t numBytes ) : data( _data ), bitPos( 0u )
+            {
+                memset( data, 0, numBytes );
+            }
+
+            void write( uint32 value, uint32 numBits )
+            {
+                for( uint32 i = 0u; i < numBits; ++i, ++bitPos )
+                {
+                    data[bitPos >> 3u] |=
+                        static_cast<uint8>( ( ( value >> i ) & 0x01u ) << ( bitPos & 0x07u ) );
+                }
+            }
+        };
+
+        struct BitReader
+        {
+            const uint8 *data;
+            uint32 bitPos;
+
+            BitReader( const uint8 *_data ) : data( _data ), bitPos( 0u ) {}
+
+            uint32 read( uint32 numBits )
+            {
+                uint32 retVal = 0u;
+                for( uint32 i = 0u; i < numBits; ++i, ++bitPos )
+                    retVal |= ( ( data[bitPos >> 3u] >> ( bitPos & 0x07u ) ) & 0x01u ) << i;
+                return retVal;
+            }
+        };
+
+        /** For each pixel, finds the closest palette entry (squared RGBA distance).
+        @param pixels
+            RGBA8 pixels. numPixels must be a multiple of 4.
+        @param palette
+            RGBA8 entries. Ties are resolved in favour of the lowest index.
+        @param outIndices [out]
+            Index of the closest entry for each pixel.
+        @return
+            Sum of the squared errors.
+        */
+        uint32 findClosestColours( const uint8 *pixels, size_t numPixels, const uint8 *palette,
+                                   size_t paletteSize, uint8 *outIndices )
+        {
+            uint32 totalError = 0u;
+#if __OGRE_HAVE_SSE
+            const __m128i zero = _mm_setzero_si128();
+            for( size_t i = 0u; i < numPixels; i += 4u )
+            {
+                const __m128i px =
+                    _mm_loadu_si128( reinterpret_cast<const __m128i *>( pixels + i * 4u ) );
+                const __m128i pxLo = _mm_unpacklo_epi8( px, zero );
+                const __m128i pxHi = _mm_unpackhi_epi8( px, zero );
+
+                __m128i bestError = _mm_set1_epi32( 0x7FFFFFFF );
+                __m128i bestIdx = zero;
+                for( size_t j = 0u; j < paletteSize; ++j )
+                {
+                    int32 entry;
+                    memcpy( &entry, palette + j * 4u, sizeof( entry ) );
+                    const __m128i colour = _mm_unpacklo_epi8( _mm_set1_epi32( entry ), zero );
+                    const __m128i diffLo = _mm_sub_epi16( pxLo, colour );
+                    const __m128i diffHi = _mm_sub_epi16( pxHi, colour );
+                    // [r^2 + g^2, b^2 + a^2] for 2 pixels each
+                    const __m128 sqLo = _mm_castsi128_ps( _mm_madd_epi16( diffLo, diffLo ) );
+                    const __m128 sqHi = _mm_castsi128_ps( _mm_madd_epi16( diffHi, diffHi ) );
+                    const __m128i error = _mm_add_epi32(
+                        _mm_castps_si128( _mm_shuffle_ps( sqLo, sqHi, _MM_SHUFFLE( 2, 0, 2, 0 ) ) ),
+                        _mm_castps_si128( _mm_shuffle_ps( sqLo, sqHi, _MM_SHUFFLE( 3, 1, 3, 1 ) ) ) );
+
+                    const __m128i better = _mm_cmplt_epi32( error, bestError );
+                    bestError = _mm_or_si128( _mm_and_si128( better, error ),
+                                              _mm_andnot_si128( better, bestError ) );
+                    bestIdx = _mm_or_si128( _mm_and_si128( better, _mm_set1_epi32( (int)j ) ),
+                                            _mm_andnot_si128( better, bestIdx ) );
+                }
+
+                int32 indices[4];
+                int32 errors[4];
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( indices ), bestIdx );
+                _mm_storeu_si128( reinterpret_cast<__m128i *>( errors ), bestError );
+                for( size_t k = 0u; k < 4u; ++k )
+                {
+                    outIndices[i + k] = static_cast<uint8>( indices[k] );
+                    totalError += static_cast<uint32>( errors[k] );
+                }
+            }
+#elif __OGRE_HAVE_NEON
+            for( size_t i = 0u; i < numPixels; i += 4u )
+            {
+                const uint8x16_t px = vld1q_u8( pixels + i * 4u );
+
+                uint32x4_t bestError = vdupq_n_u32( 0xFFFFFFFFu );
+                uint32x4_t bestIdx = vdupq_n_u32( 0u );
+                for( size_t j = 0u; j < paletteSize; ++j )
+                {
+                    uint32 entry;
+                    memcpy( &entry, palette + j * 4u, sizeof( entry ) );
+                    const uint8x16_t diff = vabdq_u8( px, vreinterpretq_u8_u32( vdupq_n_u32( entry ) ) );
+                    // [r^2 + g^2, b^2 + a^2] for 2 pixels each
+                    const uint32x4_t sqLo =
+                        vpaddlq_u16( vmull_u8( vget_low_u8( diff ), vget_low_u8( diff ) ) );
+                    const uint32x4_t sqHi =
+                        vpaddlq_u16( vmull_u8( vget_high_u8( diff ), vget_high_u8( diff ) ) );
+                    const uint32x4_t error =
+                        vcombine_u32( vpadd_u32( vget_low_u32( sqLo ), vget_high_u32( sqLo ) ),
+                                      vpadd_u32( vget_low_u32( sqHi ), vget_high_u32( sqHi ) ) );
+
+                    const uint32x4_t better = vcltq_u32( error, bestError );
+                    bestError = vbslq_u32( better, error, bestError );
+                    bestIdx = vbslq_u32( better, vdupq_n_u32( static_cast<uint32>( j ) ), bestIdx );
+                }
+
+                uint32 indices[4];
+                uint32 errors[4];
+                vst1q_u32( indices, bestIdx );
+                vst1q_u32( errors, bestError );
+                for( size_t k = 0u; k < 4u; ++k )
+                {
+                    outIndices[i + k] = static_cast<uint8>( indices[k] );
+                    totalError += errors[k];
+                }
+            }
+#else
+            for( size_t i = 0u; i < numPixels; ++i )
+            {
+                const uint8 *px = pixels + i * 4u;
+                uint32 bestError = std::numeric_limits<uint32>::max();
+                uint8 bestIdx = 0u;
+                for( size_t j = 0u; j < paletteSize; ++j )
+                {
+                    uint32 error = 0u;
+                    for( size_t c = 0u; c < 4u; ++c )
+                    {
+                        const int32 diff = int32( px[c] ) - int32( palette[j * 4u + c] );
+                        error += static_cast<uint32>( diff * diff );
+                    }
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        bestIdx = static_cast<uint8>( j );
+                    }
+                }
+                outIndices[i] = bestIdx;
+                totalError += bestError;
+            }
+#endif
+            return totalError;
+        }
+
+        /** For each of the 16 values, finds the closest of the 8 palette entries.
+        @return
+            Sum of the absolute errors.
+        */
+        uint32 findClosestValues( const uint8 *values, const uint8 *palette, uint8 *outIndices )
+        {
+#if __OGRE_HAVE_SSE
+            const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( values ) );
+            __m128i bestError = _mm_set1_epi8( -1 );
+            __m128i bestIdx = _mm_setzero_si128();
+            for( int j = 0; j < 8; ++j )
+            {
+                const __m128i entry = _mm_set1_epi8( static_cast<char>( palette[j] ) );
+                const __m128i error =
+                    _mm_or_si128( _mm_subs_epu8( v, entry ), _mm_subs_epu8( entry, v ) );
+                const __m128i minError = _mm_min_epu8( error, bestError );
+                // error < bestError <=> min( error, bestError ) != bestError
+                const __m128i notBetter = _mm_cmpeq_epi8( minError, bestError );
+                bestIdx = _mm_or_si128( _mm_and_si128( notBetter, bestIdx ),
+                                        _mm_andnot_si128( notBetter, _mm_set1_epi8( (char)j ) ) );
+                bestError = minError;
+            }
+            _mm_storeu_si128( reinterpret_cast<__m128i *>( outIndices ), bestIdx );
+            const __m128i sad = _mm_sad_epu8( bestError, _mm_setzero_si128() );
+            return static_cast<uint32>( _mm_cvtsi128_si32( sad ) +
+                                        _mm_cvtsi128_si32( _mm_srli_si128( sad, 8 ) ) );
+#elif __OGRE_HAVE_NEON
+            const uint8x16_t v = vld1q_u8( values );
+            uint8x16_t bestError = vdupq_n_u8( 255u );
+            uint8x16_t bestIdx = vdupq_n_u8( 0u );
+            for( uint8 j = 0u; j < 8u; ++j )
+            {
+                const uint8x16_t error = vabdq_u8( v, vdupq_n_u8( palette[j] ) );
+                const uint8x16_t better = vcltq_u8( error, bestError );
+                bestError = vminq_u8( error, bestError );
+                bestIdx = vbslq_u8( better, vdupq_n_u8( j ), bestIdx );
+            }
+            vst1q_u8( outIndices, bestIdx );
+            const uint64x2_t sum = vpaddlq_u32( vpaddlq_u16( vpaddlq_u8( bestError ) ) );
+            return static_cast<uint32>( vgetq_lane_u64( sum, 0 ) + vgetq_lane_u64( sum, 1 ) );
+#else
+            uint32 totalError = 0u;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                uint32 bestError = 256u;
+                for( uint8 j = 0u; j < 8u; ++j )
+                {
+                    const uint32 error = static_cast<uint32>( abs( int32( values[i] ) - palette[j] ) );
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        outIndices[i] = j;
+                    }
+                }
+                totalError += bestError;
+            }
+            return totalError;
+#endif
+        }
+
+        /** Finds the extremes of the pixels along their principal axis.
+        @param pixels
+            RGBA8 pixels.
+        @param numChannels
+            3 to only consider RGB, 4 for RGBA.
+        @param outE0 [out]
+        @param outE1 [out]
+            Endpoints, in range [0; 255].
+        */
+        void computeAxisEndpoints( const uint8 *pixels, size_t numPixels, size_t numChannels,
+                                   float *outE0, float *outE1 )
+        {
+            float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for( size_t i = 0u; i < numPixels; ++i )
+            {
+                for( size_t c = 0u; c < numChannels; ++c )
+                    mean[c] += pixels[i * 4u + c];
+            }
+            for( size_t c = 0u; c < numChannels; ++c )
+                mean[c] /= static_cast<float>( numPixels );
+
+            float covariance[4][4];
+            memset( covariance, 0, sizeof( covariance ) );
+            for( size_t i = 0u; i < numPixels; ++i )
+            {
+                float diff[4];
+                for( size_t c = 0u; c < numChannels; ++c )
+                    diff[c] = pixels[i * 4u + c] - mean[c];
+                for( size_t a = 0u; a < numChannels; ++a )
+                {
+                    for( size_t b = 0u; b < numChannels; ++b )
+                        covariance[a][b] += diff[a] * diff[b];
+                }
+            }
+
+            // Power iteration, starting from the row of the channel with the largest variance
+            size_t maxChannel = 0u;
+            for( size_t c = 1u; c < numChannels; ++c )
+            {
+                if( covariance[c][c] > covariance[maxChannel][maxChannel] )
+                    maxChannel = c;
+            }
+
+            float axis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for( size_t c = 0u; c < numChannels; ++c )
+                axis[c] = covariance[maxChannel][c];
+
+            for( int iter = 0; iter < 8; ++iter )
+            {
+                float newAxis[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+                float maxValue = 0.0f;
+                for( size_t a = 0u; a < numChannels; ++a )
+                {
+                    for( size_t b = 0u; b < numChannels; ++b )
+                        newAxis[a] += covariance[a][b] * axis[b];
+                    maxValue = std::max( maxValue, fabsf( newAxis[a] ) );
+                }
+
+                if( maxValue <= FLT_EPSILON )
+                    break;
+
+                for( size_t c = 0u; c < numChannels; ++c )
+                    axis[c] = newAxis[c] / maxValue;
+            }
+
+            float lengthSq = 0.0f;
+            for( size_t c = 0u; c < numChannels; ++c )
+                lengthSq += axis[c] * axis[c];
+
+            float minT = 0.0f;
+            float maxT = 0.0f;
+            if( lengthSq > FLT_EPSILON )
+            {
+                const float invLength = 1.0f / sqrtf( lengthSq );
+                for( size_t c = 0u; c < numChannels; ++c )
+                    axis[c] *= invLength;
+
+                minT = FLT_MAX;
+                maxT = -FLT_MAX;
+                for( size_t i = 0u; i < numPixels; ++i )
+                {
+                    float t = 0.0f;
+                    for( size_t c = 0u; c < numChannels; ++c )
+                        t += ( pixels[i * 4u + c] - mean[c] ) * axis[c];
+                    minT = std::min( minT, t );
+                    maxT = std::max( maxT, t );
+                }
+            }
+
+            for( size_t c = 0u; c < 4u; ++c )
+            {
+                outE0[c] = 255.0f;
+                outE1[c] = 255.0f;
+            }
+            for( size_t c = 0u; c < numChannels; ++c )
+            {
+                outE0[c] = Math::Clamp( mean[c] + axis[c] * minT, 0.0f, 255.0f );
+                outE1[c] = Math::Clamp( mean[c] + axis[c] * maxT, 0.0f, 255.0f );
+            }
+        }
+
+        /** Refits the endpoints so that ( 1 - w ) * e0 + w * e1 matches the pixels with the least
+            squared error, given the palette index each pixel was assigned to.
+        @param weights
+            Weight of e1 for each palette index.
+        @return
+            False if the system is degenerate (e.g. all pixels use the same index).
+            The endpoints are left untouched.
+        */
+        bool refitEndpoints( const uint8 *pixels, size_t numPixels, size_t numChannels,
+                             const uint8 *indices, const float *weights, float *inOutE0,
+                             float *inOutE1 )
+        {
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+            float ax[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+            for( size_t i = 0u; i < numPixels; ++i )
+            {
+                const float w = weights[indices[i]];
+                const float a = 1.0f - w;
+                aa += a * a;
+                ab += a * w;
+                bb += w * w;
+                for( size_t c = 0u; c < numChannels; ++c )
+                {
+                    ax[c] += a * pixels[i * 4u + c];
+                    bx[c] += w * pixels[i * 4u + c];
+                }
+            }
+
+            const float det = aa * bb - ab * ab;
+            if( fabsf( det ) < 1e-4f )
+                return false;
+
+            const float invDet = 1.0f / det;
+            for( size_t c = 0u; c < numChannels; ++c )
+            {
+                inOutE0[c] = Math::Clamp( ( bb * ax[c] - ab * bx[c] ) * invDet, 0.0f, 255.0f );
+                inOutE1[c] = Math::Clamp( ( aa * bx[c] - ab * ax[c] ) * invDet, 0.0f, 255.0f );
+            }
+
+            return true;
+        }
+        //-------------------------------------------------------------------------------
+        // BC1 - BC5
+        //-------------------------------------------------------------------------------
+        inline uint16 packRgb565( const float *rgb )
+        {
+            const int32 r = clampInt( static_cast<int32>( rgb[0] * ( 31.0f / 255.0f ) + 0.5f ), 0, 31 );
+            const int32 g = clampInt( static_cast<int32>( rgb[1] * ( 63.0f / 255.0f ) + 0.5f ), 0, 63 );
+            const int32 b = clampInt( static_cast<int32>( rgb[2] * ( 31.0f / 255.0f ) + 0.5f ), 0, 31 );
+            return static_cast<uint16>( ( r << 11u ) | ( g << 5u ) | b );
+        }
+
+        inline void unpackRgb565( uint16 colour, uint8 *outRgba )
+        {
+            const uint32 r = ( colour >> 11u ) & 0x1Fu;
+            const uint32 g = ( colour >> 5u ) & 0x3Fu;
+            const uint32 b = colour & 0x1Fu;
+            outRgba[0] = static_cast<uint8>( ( r << 3u ) | ( r >> 2u ) );
+            outRgba[1] = static_cast<uint8>( ( g << 2u ) | ( g >> 4u ) );
+            outRgba[2] = static_cast<uint8>( ( b << 3u ) | ( b >> 2u ) );
+            outRgba[3] = 255u;
+        }
+
+        /** Builds the palette the GPU decodes from the two endpoints.
+        @param allowThreeColourMode
+            BC1 switches to 3 colours + transparent black when c0 <= c1.
+            BC2 & BC3 always use 4 colours.
+        */
+        void buildBc1Palette( uint16 c0, uint16 c1, bool allowThreeColourMode, uint8 *outPalette )
+        {
+            unpackRgb565( c0, outPalette );
+            unpackRgb565( c1, outPalette + 4u );
+
+            const uint8 *a = outPalette;
+            const uint8 *b = outPalette + 4u;
+            if( c0 > c1 || !allowThreeColourMode )
+            {
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    outPalette[8u + c] = static_cast<uint8>( ( 2u * a[c] + b[c] + 1u ) / 3u );
+                    outPalette[12u + c] = static_cast<uint8>( ( a[c] + 2u * b[c] + 1u ) / 3u );
+                }
+                outPalette[11] = 255u;
+                outPalette[15] = 255u;
+            }
+            else
+            {
+                for( size_t c = 0u; c < 3u; ++c )
+                    outPalette[8u + c] = static_cast<uint8>( ( a[c] + b[c] + 1u ) / 2u );
+                outPalette[11] = 255u;
+                memset( outPalette + 12u, 0, 4u );
+            }
+        }
+
+        /// Fits c0 > c1 (4 colour mode). pixels must have alpha = 255.
+        void encodeBc1FourColours( const uint8 *pixels, uint16 &outC0, uint16 &outC1, uint8 *outIndices )
+        {
+            // Weight of c1 for each palette index
+            const float c_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+            float e0[4], e1[4];
+            computeAxisEndpoints( pixels, 16u, 3u, e0, e1 );
+
+            uint32 bestError = std::numeric_limits<uint32>::max();
+            for( int iter = 0; iter < 3; ++iter )
+            {
+                uint16 c0 = packRgb565( e0 );
+                uint16 c1 = packRgb565( e1 );
+                if( c0 < c1 )
+                    std::swap( c0, c1 );
+
+                uint8 palette[16];
+                uint8 indices[16];
+                buildBc1Palette( c0, c1, false, palette );
+                // c0 == c1 would select the 3 colour mode. All indices must be 0 then.
+                const uint32 error =
+                    findClosestColours( pixels, 16u, palette, c0 == c1 ? 1u : 4u, indices );
+
+                if( error < bestError )
+                {
+                    bestError = error;
+                    outC0 = c0;
+                    outC1 = c1;
+                    memcpy( outIndices, indices, sizeof( indices ) );
+                }
+
+                if( error == 0u || c0 == c1 ||
+                    !refitEndpoints( pixels, 16u, 3u, indices, c_weights, e0, e1 ) )
+                {
+                    break;
+                }
+            }
+        }
+
+        /// Fits c0 <= c1 (3 colour mode + transparent). Pixels with alpha < 128 use index 3.
+        void encodeBc1ThreeColours( const uint8 *pixels, const uint8 *srcRgba, uint16 &outC0,
+                                    uint16 &outC1, uint8 *outIndices )
+        {
+            const float c_weights[3] = { 0.0f, 1.0f, 0.5f };
+
+            uint8 opaque[64];
+            size_t numOpaque = 0u;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                if( srcRgba[i * 4u + 3u] >= 128u )
+                    memcpy( opaque + 4u * numOpaque++, pixels + i * 4u, 4u );
+            }
+
+            if( numOpaque == 0u )
+            {
+                outC0 = 0u;
+                outC1 = 0u;
+                memset( outIndices, 3, 16u );
+                return;
+            }
+
+            // findClosestColours works in groups of 4. Pad with copies of the first pixel
+            const size_t numPadded = ( numOpaque + 3u ) & ~size_t( 3u );
+            for( size_t i = numOpaque; i < numPadded; ++i )
+                memcpy( opaque + 4u * i, opaque, 4u );
+
+            float e0[4], e1[4];
+            computeAxisEndpoints( opaque, numOpaque, 3u, e0, e1 );
+
+            uint8 opaqueIndices[16];
+            uint32 bestError = std::numeric_limits<uint32>::max();
+            for( int iter = 0; iter < 3; ++iter )
+            {
+                uint16 c0 = packRgb565( e0 );
+                uint16 c1 = packRgb565( e1 );
+                if( c0 > c1 )
+                    std::swap( c0, c1 );
+
+                uint8 palette[16];
+                uint8 indices[16];
+                buildBc1Palette( c0, c1, true, palette );
+                const uint32 error = findClosestColours( opaque, numPadded, palette, 3u, indices );
+
+                if( error < bestError )
+                {
+                    bestError = error;
+                    outC0 = c0;
+                    outC1 = c1;
+                    memcpy( opaqueIndices, indices, sizeof( indices ) );
+                }
+
+                if( error == 0u || !refitEndpoints( opaque, numOpaque, 3u, indices, c_weights, e0, e1 ) )
+                    break;
+            }
+
+            size_t opaqueIdx = 0u;
+            for( size_t i = 0u; i < 16u; ++i )
+                outIndices[i] = srcRgba[i * 4u + 3u] >= 128u ? opaqueIndices[opaqueIdx++] : 3u;
+        }
+
+        /// Writes the 8-byte BC1 colour block.
+        void encodeBc1( const uint8 *srcRgba, bool allowPunchThrough, uint8 *outBlock )
+        {
+            uint8 pixels[64];
+            bool hasTransparency = false;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                memcpy( pixels + i * 4u, srcRgba + i * 4u, 3u );
+                pixels[i * 4u + 3u] = 255u;
+                hasTransparency |= srcRgba[i * 4u + 3u] < 128u;
+            }
+
+            uint16 c0 = 0u, c1 = 0u;
+            uint8 indices[16];
+            if( allowPunchThrough && hasTransparency )
+                encodeBc1ThreeColours( pixels, srcRgba, c0, c1, indices );
+            else
+                encodeBc1FourColours( pixels, c0, c1, indices );
+
+            outBlock[0] = static_cast<uint8>( c0 & 0xFFu );
+            outBlock[1] = static_cast<uint8>( c0 >> 8u );
+            outBlock[2] = static_cast<uint8>( c1 & 0xFFu );
+            outBlock[3] = static_cast<uint8>( c1 >> 8u );
+            for( size_t i = 0u; i < 4u; ++i )
+            {
+                outBlock[4u + i] = static_cast<uint8>( indices[i * 4u + 0u] |         //
+                                                       ( indices[i * 4u + 1u] << 2u ) |  //
+                                                       ( indices[i * 4u + 2u] << 4u ) |  //
+                                                       ( indices[i * 4u + 3u] << 6u ) );
+            }
+        }
+
+        void decodeBc1( const uint8 *block, bool allowThreeColourMode, uint8 *outRgba )
+        {
+            const uint16 c0 = static_cast<uint16>( block[0] | ( block[1] << 8u ) );
+            const uint16 c1 = static_cast<uint16>( block[2] | ( block[3] << 8u ) );
+
+            uint8 palette[16];
+            buildBc1Palette( c0, c1, allowThreeColourMode, palette );
+
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const size_t idx = ( block[4u + ( i >> 2u )] >> ( ( i & 0x03u ) * 2u ) ) & 0x03u;
+                memcpy( outRgba + i * 4u, palette + idx * 4u, 4u );
+            }
+        }
+
+        /// BC2 explicit 4-bit alpha
+        void encodeBc2Alpha( const uint8 *srcRgba, uint8 *outBlock )
+        {
+            for( size_t i = 0u; i < 8u; ++i )
+            {
+                const uint32 a0 = ( srcRgba[( i * 2u + 0u ) * 4u + 3u] * 15u + 127u ) / 255u;
+                const uint32 a1 = ( srcRgba[( i * 2u + 1u ) * 4u + 3u] * 15u + 127u ) / 255u;
+                outBlock[i] = static_cast<uint8>( a0 | ( a1 << 4u ) );
+            }
+        }
+
+        void decodeBc2Alpha( const uint8 *block, uint8 *outRgba )
+        {
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const uint32 alpha = ( block[i >> 1u] >> ( ( i & 0x01u ) * 4u ) ) & 0x0Fu;
+                outRgba[i * 4u + 3u] = static_cast<uint8>( alpha * 17u );
+            }
+        }
+
+        /// Palette of BC3's alpha, BC4 & BC5 blocks
+        void buildAlphaPalette( int32 a0, int32 a1, bool isSigned, int32 *outPalette )
+        {
+            outPalette[0] = a0;
+            outPalette[1] = a1;
+            if( a0 > a1 )
+            {
+                for( int32 i = 1; i < 7; ++i )
+                    outPalette[i + 1] = roundedDiv( ( 7 - i ) * a0 + i * a1, 7 );
+            }
+            else
+            {
+                for( int32 i = 1; i < 5; ++i )
+                    outPalette[i + 1] = roundedDiv( ( 5 - i ) * a0 + i * a1, 5 );
+                outPalette[6] = isSigned ? -127 : 0;
+                outPalette[7] = isSigned ? 127 : 255;
+            }
+        }
+
+        /** Encodes one channel as BC3's alpha / BC4 block.
+        @param isSigned
+            When true the channel is read as snorm8 and the block is written as BC4_SNORM.
+        */
+        void encodeAlphaBlock( const uint8 *srcRgba, size_t channel, bool isSigned, uint8 *outBlock )
+        {
+            // Work in biased unsigned space, which preserves ordering & distances
+            const int32 bias = isSigned ? 128 : 0;
+            const int32 extremeMin = isSigned ? -127 : 0;
+            const int32 extremeMax = isSigned ? 127 : 255;
+
+            uint8 biased[16];
+            int32 minValue = extremeMax, maxValue = extremeMin;
+            int32 innerMin = extremeMax, innerMax = extremeMin;
+            bool hasExtremes = false;
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const uint8 raw = srcRgba[i * 4u + channel];
+                const int32 value = isSigned ? readSnorm8( raw ) : raw;
+                biased[i] = static_cast<uint8>( value + bias );
+                minValue = std::min( minValue, value );
+                maxValue = std::max( maxValue, value );
+                if( value == extremeMin || value == extremeMax )
+                    hasExtremes = true;
+                else
+                {
+                    innerMin = std::min( innerMin, value );
+                    innerMax = std::max( innerMax, value );
+                }
+            }
+
+            int32 palette[8];
+            uint8 biasedPalette[8];
+
+            // 8 interpolated values (a0 > a1)
+            int32 a0 = maxValue;
+            int32 a1 = minValue;
+            uint8 indices[16];
+            buildAlphaPalette( a0, a1, isSigned, palette );
+            for( size_t j = 0u; j < 8u; ++j )
+                biasedPalette[j] = static_cast<uint8>( palette[j] + bias );
+            uint32 bestError = findClosestValues( biased, biasedPalette, indices );
+
+            // 6 interpolated values + explicit extremes (a0 <= a1). Helps e.g. cut-out alpha
+            if( hasExtremes && innerMin <= innerMax && bestError != 0u )
+            {
+                uint8 indices6[16];
+                buildAlphaPalette( innerMin, innerMax, isSigned, palette );
+                for( size_t j = 0u; j < 8u; ++j )
+                    biasedPalette[j] = static_cast<uint8>( palette[j] + bias );
+                const uint32 error = findClosestValues( biased, biasedPalette, indices6 );
+                if( error < bestError )
+                {
+                    a0 = innerMin;
+                    a1 = innerMax;
+                    memcpy( indices, indices6, sizeof( indices ) );
+                }
+            }
+
+            outBlock[0] = static_cast<uint8>( a0 );
+            outBlock[1] = static_cast<uint8>( a1 );
+            uint64 bits = 0u;
+            for( size_t i = 0u; i < 16u; ++i )
+                bits |= uint64( indices[i] ) << ( i * 3u );
+            for( size_t i = 0u; i < 6u; ++i )
+                outBlock[2u + i] = static_cast<uint8>( bits >> ( i * 8u ) );
+        }
+
+        void decodeAlphaBlock( const uint8 *block, size_t channel, bool isSigned, uint8 *outRgba )
+        {
+            const int32 a0 = isSigned ? readSnorm8( block[0] ) : block[0];
+            const int32 a1 = isSigned ? readSnorm8( block[1] ) : block[1];
+
+            int32 palette[8];
+            buildAlphaPalette( a0, a1, isSigned, palette );
+
+            uint64 bits = 0u;
+            for( size_t i = 0u; i < 6u; ++i )
+                bits |= uint64( block[2u + i] ) << ( i * 8u );
+
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const size_t idx = ( bits >> ( i * 3u ) ) & 0x07u;
+                outRgba[i * 4u + channel] = static_cast<uint8>( palette[idx] );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        // BC7
+        //-------------------------------------------------------------------------------
+        /// Finds the best 7-bit endpoint + shared p-bit for mode 6.
+        void quantizeBc7Mode6( const float *endpoint, uint8 *outQuantized, uint8 &outPBit )
+        {
+            float bestError = FLT_MAX;
+            for( uint8 pBit = 0u; pBit < 2u; ++pBit )
+            {
+                uint8 quantized[4];
+                float error = 0.0f;
+                for( size_t c = 0u; c < 4u; ++c )
+                {
+                    const float halved = floorf( ( endpoint[c] - pBit ) * 0.5f + 0.5f );
+                    quantized[c] =
+                        static_cast<uint8>( clampInt( static_cast<int32>( halved ), 0, 127 ) );
+                    const float diff = float( quantized[c] * 2u + pBit ) - endpoint[c];
+                    error += diff * diff;
+                }
+
+                if( error < bestError )
+                {
+                    bestError = error;
+                    memcpy( outQuantized, quantized, sizeof( quantized ) );
+                    outPBit = pBit;
+                }
+            }
+        }
+
+        /// Encodes the block using mode 6 (single subset, RGBA 7.7.7.7 + p-bit, 4-bit indices)
+        void encodeBc7( const uint8 *srcRgba, uint8 *outBlock )
+        {
+            float weights[16];
+            for( size_t i = 0u; i < 16u; ++i )
+                weights[i] = c_bc7Weights4[i] / 64.0f;
+
+            float e0[4], e1[4];
+            computeAxisEndpoints( srcRgba, 16u, 4u, e0, e1 );
+
+            uint8 bestQ0[4], bestQ1[4], bestIndices[16];
+            uint8 bestP0 = 0u, bestP1 = 0u;
+            uint32 bestError = std::numeric_limits<uint32>::max();
+            for( int iter = 0; iter < 3; ++iter )
+            {
+                uint8 q0[4], q1[4];
+                uint8 p0, p1;
+                quantizeBc7Mode6( e0, q0, p0 );
+                quantizeBc7Mode6( e1, q1, p1 );
+
+                uint8 palette[64];
+                for( size_t i = 0u; i < 16u; ++i )
+                {
+                    const uint32 w = c_bc7Weights4[i];
+                    for( size_t c = 0u; c < 4u; ++c )
+                    {
+                        const uint32 v0 = q0[c] * 2u + p0;
+                        const uint32 v1 = q1[c] * 2u + p1;
+                        palette[i * 4u + c] =
+                            static_cast<uint8>( ( ( 64u - w ) * v0 + w * v1 + 32u ) >> 6u );
+                    }
+                }
+
+                uint8 indices[16];
+                const uint32 error = findClosestColours( srcRgba, 16u, palette, 16u, indices );
+                if( error < bestError )
+                {
+                    bestError = error;
+                    memcpy( bestQ0, q0, sizeof( q0 ) );
+                    memcpy( bestQ1, q1, sizeof( q1 ) );
+                    memcpy( bestIndices, indices, sizeof( indices ) );
+                    bestP0 = p0;
+                    bestP1 = p1;
+                }
+
+                if( error == 0u || !refitEndpoints( srcRgba, 16u, 4u, indices, weights, e0, e1 ) )
+                    break;
+            }
+
+            // The MSB of the anchor index (pixel 0) is implicitly 0
+            if( bestIndices[0] & 0x08u )
+            {
+                for( size_t c = 0u; c < 4u; ++c )
+                    std::swap( bestQ0[c], bestQ1[c] );
+                std::swap( bestP0, bestP1 );
+                for( size_t i = 0u; i < 16u; ++i )
+                    bestIndices[i] = static_cast<uint8>( 15u - bestIndices[i] );
+            }
+
+            BitWriter writer( outBlock, 16u );
+            writer.write( 1u << 6u, 7u );
+            for( size_t c = 0u; c < 4u; ++c )
+            {
+                writer.write( bestQ0[c], 7u );
+                writer.write( bestQ1[c], 7u );
+            }
+            writer.write( bestP0, 1u );
+            writer.write( bestP1, 1u );
+            for( size_t i = 0u; i < 16u; ++i )
+                writer.write( bestIndices[i], i == 0u ? 3u : 4u );
+        }
+
+        inline uint8 unquantizeBc7( uint32 value, uint32 numBits )
+        {
+            value <<= 8u - numBits;
+            return static_cast<uint8>( value | ( value >> numBits ) );
+        }
+
+        inline const uint8 *getBc7Weights( uint32 numBits )
+        {
+            return numBits == 2u ? c_bc7Weights2 : ( numBits == 3u ? c_bc7Weights3 : c_bc7Weights4 );
+        }
+
+        void decodeBc7( const uint8 *block, uint8 *outRgba )
+        {
+            uint32 mode = 0u;
+            while( mode < 8u && !( block[0] & ( 1u << mode ) ) )
+                ++mode;
+
+            if( mode == 8u )
+            {
+                // Reserved. Decodes to transparent black
+                memset( outRgba, 0, 64u );
+                return;
+            }
+
+            const Bc7ModeInfo &info = c_bc7Modes[mode];
+            BitReader reader( block );
+            reader.bitPos = mode + 1u;
+
+            const uint32 partition = reader.read( info.partitionBits );
+            const uint32 rotation = reader.read( info.rotationBits );
+            const uint32 indexSelection = reader.read( info.indexSelectionBits );
+
+            const size_t numEndpoints = info.numSubsets * 2u;
+            uint32 endpoints[6][4];
+            for( size_t c = 0u; c < 3u; ++c )
+            {
+                for( size_t e = 0u; e < numEndpoints; ++e )
+                    endpoints[e][c] = reader.read( info.colourBits );
+            }
+            for( size_t e = 0u; e < numEndpoints; ++e )
+                endpoints[e][3] = info.alphaBits ? reader.read( info.alphaBits ) : 255u;
+
+            uint32 colourBits = info.colourBits;
+            uint32 alphaBits = info.alphaBits;
+            if( info.endpointPBits || info.sharedPBits )
+            {
+                uint32 pBits[6];
+                if( info.endpointPBits )
+                {
+                    for( size_t e = 0u; e < numEndpoints; ++e )
+                        pBits[e] = reader.read( 1u );
+                }
+                else
+                {
+                    for( size_t s = 0u; s < info.numSubsets; ++s )
+                        pBits[s * 2u] = pBits[s * 2u + 1u] = reader.read( 1u );
+                }
+
+                for( size_t e = 0u; e < numEndpoints; ++e )
+                {
+                    for( size_t c = 0u; c < ( info.alphaBits ? 4u : 3u ); ++c )
+                        endpoints[e][c] = ( endpoints[e][c] << 1u ) | pBits[e];
+                }
+                ++colourBits;
+                if( alphaBits )
+                    ++alphaBits;
+            }
+
+            for( size_t e = 0u; e < numEndpoints; ++e )
+            {
+                for( size_t c = 0u; c < 3u; ++c )
+                    endpoints[e][c] = unquantizeBc7( endpoints[e][c], colourBits );
+                if( alphaBits )
+                    endpoints[e][3] = unquantizeBc7( endpoints[e][3], alphaBits );
+            }
+
+            uint8 subsets[16];
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                if( info.numSubsets == 1u )
+                    subsets[i] = 0u;
+                else if( info.numSubsets == 2u )
+                    subsets[i] = static_cast<uint8>( ( c_bc7Partitions2[partition] >> i ) & 0x01u );
+                else
+                {
+                    subsets[i] =
+                        static_cast<uint8>( ( c_bc7Partitions3[partition] >> ( i * 2u ) ) & 0x03u );
+                }
+            }
+
+            const uint32 anchor1 = info.numSubsets == 2u ? c_bc7Anchors2[partition]
+                                                         : c_bc7Anchors3a[partition];
+            const uint32 anchor2 = c_bc7Anchors3b[partition];
+
+            uint8 indices[16];
+            uint8 indices2[16];
+            for( uint32 i = 0u; i < 16u; ++i )
+            {
+                const bool isAnchor = i == 0u || ( info.numSubsets > 1u && i == anchor1 ) ||
+                                      ( info.numSubsets > 2u && i == anchor2 );
+                indices[i] =
+                    static_cast<uint8>( reader.read( info.indexBits - ( isAnchor ? 1u : 0u ) ) );
+            }
+            if( info.indexBits2 )
+            {
+                for( uint32 i = 0u; i < 16u; ++i )
+                {
+                    indices2[i] =
+                        static_cast<uint8>( reader.read( info.indexBits2 - ( i == 0u ? 1u : 0u ) ) );
+                }
+            }
+
+            const uint8 *colourWeights = getBc7Weights( info.indexBits );
+            const uint8 *alphaWeights = colourWeights;
+            const uint8 *colourIndices = indices;
+            const uint8 *alphaIndices = indices;
+            if( info.indexBits2 )
+            {
+                alphaWeights = getBc7Weights( info.indexBits2 );
+                alphaIndices = indices2;
+                if( indexSelection )
+                {
+                    std::swap( colourWeights, alphaWeights );
+                    std::swap( colourIndices, alphaIndices );
+                }
+            }
+
+            for( size_t i = 0u; i < 16u; ++i )
+            {
+                const uint32 *e0 = endpoints[subsets[i] * 2u];
+                const uint32 *e1 = endpoints[subsets[i] * 2u + 1u];
+                uint8 *pixel = outRgba + i * 4u;
+
+                const uint32 wc = colourWeights[colourIndices[i]];
+                for( size_t c = 0u; c < 3u; ++c )
+                    pixel[c] = static_cast<uint8>( ( ( 64u - wc ) * e0[c] + wc * e1[c] + 32u ) >> 6u );
+                const uint32 wa = alphaWeights[alphaIndices[i]];
+                pixel[3] = static_cast<uint8>( ( ( 64u - wa ) * e0[3] + wa * e1[3] + 32u ) >> 6u );
+
+                if( rotation )
+                    std::swap( pixel[3], pixel[rotation - 1u] );
+            }
+        }
+        //-------------------------------------------------------------------------------
+        // ETC1 / ETC2 / EAC
+        //-------------------------------------------------------------------------------
+        inline uint32 readBigEndian32( const uint8 *data )
+        {
+            return ( uint32( data[0] ) << 24u ) | ( uint32( data[1] ) << 16u ) |
+                   ( uint32( data[2] ) << 8u ) | uint32( data[3] );
+        }
+
+        inline void writeBigEndian32( uint32 value, uint8 *outData )
+        {
+            outData[0] = static_cast<uint8>( value >> 24u );
+            outData[1] = static_cast<uint8>( value >> 16u );
+            outData[2] = static_cast<uint8>( value >> 8u );
+            outData[3] = static_cast<uint8>( value );
+        }
+
+        /// Sign-extends the 3-bit deltas of the differential mode
+        inline int32 signExtend3( uint32 value ) { return static_cast<int32>( value << 29u ) >> 29; }
+
+        /// Expands a numBits value to 8 bits by replicating its MSBs
+        inline int32 extendTo8( uint32 value, uint32 numBits )
+        {
+            return static_cast<int32>( ( value << ( 8u - numBits ) ) |
+                                       ( value >> ( 2u * numBits - 8u ) ) );
+        }
+        inline int32 extend4To8( uint32 value ) { return static_cast<int32>( ( value << 4u ) | value ); }
+        inline int32 extend5To8( uint32 value ) { return extendTo8( value, 5u ); }
+        inline int32 extend6To8( uint32 value ) { return extendTo8( value, 6u ); }
+        inline int32 extend7To8( uint32 value ) { return extendTo8( value, 7u ); }
+
+        /// ETC stores pixels in column-major order
+        inline size_t etcPixelToRowMajor( size_t p ) { return ( p & 0x03u ) * 4u + ( p >> 2u ); }
+
+        /** Decodes the 8-byte ETC1 / ETC2 RGB block.
+        @param punchThrough
+            True for ETC2 RGB8A1. The 'diff' bit becomes the 'opaque' bit.
+        */
+        void decodeEtc( const uint8 *block, bool punchThrough, uint8 *outRgba )
+        {
+            const uint32 hi = readBigEndian32( block );
+            const uint32 lo = readBigEndian32( block + 4u );
+
+            const bool diffBit = ( hi & 0x02u ) != 0u;
+            const bool flip = ( hi & 0x01u ) != 0u;
+            const bool opaque = !punchThrough || diffBit;
+
+            int32 paint[4][3];
+            bool usePaintColours = false;
+            int32 base[2][3];
+
+            if( !diffBit && !punchThrough )
+            {
+                // Individual mode
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    base[0][c] = extend4To8( ( hi >> ( 28u - c * 8u ) ) & 0x0Fu );
+                    base[1][c] = extend4To8( ( hi >> ( 24u - c * 8u ) ) & 0x0Fu );
+                }
+            }
+            else
+            {
+                const int32 r = static_cast<int32>( ( hi >> 27u ) & 0x1Fu );
+                const int32 g = static_cast<int32>( ( hi >> 19u ) & 0x1Fu );
+                const int32 b = static_cast<int32>( ( hi >> 11u ) & 0x1Fu );
+                const int32 dr = signExtend3( hi >> 24u );
+                const int32 dg = signExtend3( hi >> 16u );
+                const int32 db = signExtend3( hi >> 8u );
+
+                if( r + dr < 0 || r + dr > 31 )
+                {
+                    // T mode
+                    const int32 c0[3] = {
+                        extend4To8( ( ( hi >> 25u ) & 0x0Cu ) | ( ( hi >> 24u ) & 0x03u ) ),
+                        extend4To8( ( hi >> 20u ) & 0x0Fu ), extend4To8( ( hi >> 16u ) & 0x0Fu )
+                    };
+                    const int32 c1[3] = { extend4To8( ( hi >> 12u ) & 0x0Fu ),
+                                          extend4To8( ( hi >> 8u ) & 0x0Fu ),
+                                          extend4To8( ( hi >> 4u ) & 0x0Fu ) };
+                    const int32 dist = c_etc2Distances[( ( hi >> 1u ) & 0x06u ) | ( hi & 0x01u )];
+                    for( size_t c = 0u; c < 3u; ++c )
+                    {
+                        paint[0][c] = c0[c];
+                        paint[1][c] = clampU8( c1[c] + dist );
+                        paint[2][c] = c1[c];
+                        paint[3][c] = clampU8( c1[c] - dist );
+                    }
+                    usePaintColours = true;
+                }
+                else if( g + dg < 0 || g + dg > 31 )
+                {
+                    // H mode
+                    const uint32 r0 = ( hi >> 27u ) & 0x0Fu;
+                    const uint32 g0 = ( ( hi >> 23u ) & 0x0Eu ) | ( ( hi >> 20u ) & 0x01u );
+                    const uint32 b0 = ( ( hi >> 16u ) & 0x08u ) | ( ( hi >> 15u ) & 0x07u );
+                    const uint32 r1 = ( hi >> 11u ) & 0x0Fu;
+                    const uint32 g1 = ( hi >> 7u ) & 0x0Fu;
+                    const uint32 b1 = ( hi >> 3u ) & 0x0Fu;
+                    const uint32 ordering =
+                        ( ( r0 << 8u ) | ( g0 << 4u ) | b0 ) >= ( ( r1 << 8u ) | ( g1 << 4u ) | b1 ) ? 1u
+                                                                                                 : 0u;
+                    const int32 dist =
+                        c_etc2Distances[( hi & 0x04u ) | ( ( hi & 0x01u ) << 1u ) | ordering];
+                    const int32 c0[3] = { extend4To8( r0 ), extend4To8( g0 ), extend4To8( b0 ) };
+                    const int32 c1[3] = { extend4To8( r1 ), extend4To8( g1 ), extend4To8( b1 ) };
+                    for( size_t c = 0u; c < 3u; ++c )
+                    {
+                        paint[0][c] = clampU8( c0[c] + dist );
+                        paint[1][c] = clampU8( c0[c] - dist );
+                        paint[2][c] = clampU8( c1[c] + dist );
+                        paint[3][c] = clampU8( c1[c] - dist );
+                    }
+                    usePaintColours = true;
+                }
+                else if( b + db < 0 || b + db > 31 )
+                {
+                    // Planar mode. Always opaque
+                    const int32 o[3] = {
+                        extend6To8( ( hi >> 25u ) & 0x3Fu ),
+                        extend7To8( ( ( hi >> 18u ) & 0x40u ) | ( ( hi >> 17u ) & 0x3Fu ) ),
+                        extend6To8( ( ( hi >> 11u ) & 0x20u ) | ( ( hi >> 8u ) & 0x18u ) |
+                                    ( ( hi >> 7u ) & 0x07u ) )
+                    };
+                    const int32 h[3] = { extend6To8( ( ( hi >> 1u ) & 0x3Eu ) | ( hi & 0x01u ) ),
+                                         extend7To8( ( lo >> 25u ) & 0x7Fu ),
+                                         extend6To8( ( lo >> 19u ) & 0x3Fu ) };
+                    const int32 v[3] = { extend6To8( ( lo >> 13u ) & 0x3Fu ),
+                                         extend7To8( ( lo >> 6u ) & 0x7Fu ), extend6To8( lo & 0x3Fu ) };
+                    for( int32 y = 0; y < 4; ++y )
+                    {
+                        for( int32 x = 0; x < 4; ++x )
+                        {
+                            uint8 *pixel = outRgba + ( y * 4 + x ) * 4;
+                            for( size_t c = 0u; c < 3u; ++c )
+                            {
+                                pixel[c] = clampU8(
+                                    ( x * ( h[c] - o[c] ) + y * ( v[c] - o[c] ) + 4 * o[c] + 2 ) >> 2 );
+                            }
+                            pixel[3] = 255u;
+                        }
+                    }
+                    return;
+                }
+                else
+                {
+                    // Differential mode
+                    const int32 r2 = r + dr, g2 = g + dg, b2 = b + db;
+                    base[0][0] = extend5To8( static_cast<uint32>( r ) );
+                    base[0][1] = extend5To8( static_cast<uint32>( g ) );
+                    base[0][2] = extend5To8( static_cast<uint32>( b ) );
+                    base[1][0] = extend5To8( static_cast<uint32>( r2 ) );
+                    base[1][1] = extend5To8( static_cast<uint32>( g2 ) );
+                    base[1][2] = extend5To8( static_cast<uint32>( b2 ) );
+                }
+            }
+
+            const uint32 tables[2] = { ( hi >> 5u ) & 0x07u, ( hi >> 2u ) & 0x07u };
+
+            for( size_t p = 0u; p < 16u; ++p )
+            {
+                const uint32 idx = ( ( ( lo >> ( 16u + p ) ) & 0x01u ) << 1u ) | ( ( lo >> p ) & 0x01u );
+                uint8 *pixel = outRgba + etcPixelToRowMajor( p ) * 4u;
+
+                if( !opaque && idx == 2u )
+                {
+                    memset( pixel, 0, 4u );
+                    continue;
+                }
+
+                if( usePaintColours )
+                {
+                    for( size_t c = 0u; c < 3u; ++c )
+                        pixel[c] = static_cast<uint8>( paint[idx][c] );
+                }
+                else
+                {
+                    const size_t x = p >> 2u;
+                    const size_t y = p & 0x03u;
+                    const size_t subBlock = flip ? ( y >> 1u ) : ( x >> 1u );
+                    int32 modifier = c_etc1Modifiers[tables[subBlock]][idx & 0x01u];
+                    if( idx & 0x02u )
+                        modifier = -modifier;
+                    // Punch-through blocks with the opaque bit cleared have no modifier for idx 0
+                    if( !opaque && idx == 0u )
+                        modifier = 0;
+                    for( size_t c = 0u; c < 3u; ++c )
+                        pixel[c] = clampU8( base[subBlock][c] + modifier );
+                }
+                pixel[3] = 255u;
+            }
+        }
+
+        /// Returns the error of the best modifier table for the sub-block & base colour.
+        uint32 fitEtcSubBlock( const uint8 *subPixels, const int32 *base, uint8 &outTable,
+                               uint8 *outIndices )
+        {
+            uint32 bestError = std::numeric_limits<uint32>::max();
+            for( uint8 t = 0u; t < 8u; ++t )
+            {
+                uint8 palette[16];
+                for( size_t i = 0u; i < 4u; ++i )
+                {
+                    const int32 modifier = ( i & 0x02u ) ? -c_etc1Modifiers[t][i & 0x01u]
+                                                         : c_etc1Modifiers[t][i & 0x01u];
+                    for( size_t c = 0u; c < 3u; ++c )
+                        palette[i * 4u + c] = clampU8( base[c] + modifier );
+                    palette[i * 4u + 3u] = 255u;
+                }
+
+                uint8 indices[8];
+                const uint32 error = findClosestColours( subPixels, 8u, palette, 4u, indices );
+                if( error < bestError )
+                {
+                    bestError = error;
+                    outTable = t;
+                    memcpy( outIndices, indices, sizeof( indices ) );
+                }
+            }
+            return bestError;
+        }
+
+        /// Encodes the RGB channels using the ETC1 modes (also valid ETC2).
+        void encodeEtc1( const uint8 *srcRgba, uint8 *outBlock )
+        {
+            uint32 bestError = std::numeric_limits<uint32>::max();
+            uint32 bestHi = 0u;
+            uint32 bestLo = 0u;
+
+            for( uint32 flip = 0u; flip < 2u; ++flip )
+            {
+                // Gather the 8 pixels of each sub-block & remember where they came from
+                uint8 subPixels[2][32];
+                uint8 subPixelIdx[2][8];
+                size_t numSubPixels[2] = { 0u, 0u };
+                uint32 sums[2][3] = { { 0u, 0u, 0u }, { 0u, 0u, 0u } };
+                for( size_t p = 0u; p < 16u; ++p )
+                {
+                    const size_t x = p >> 2u;
+                    const size_t y = p & 0x03u;
+                    const size_t s = flip ? ( y >> 1u ) : ( x >> 1u );
+                    const uint8 *src = srcRgba + ( y * 4u + x ) * 4u;
+                    uint8 *dst = subPixels[s] + numSubPixels[s] * 4u;
+                    for( size_t c = 0u; c < 3u; ++c )
+                    {
+                        dst[c] = src[c];
+                        sums[s][c] += src[c];
+                    }
+                    dst[3] = 255u;
+                    subPixelIdx[s][numSubPixels[s]++] = static_cast<uint8>( p );
+                }
+
+                // Candidate 0: individual mode (4-bit bases)
+                // Candidate 1: differential mode (5-bit base + 3-bit delta), if the delta fits
+                int32 quant4[2][3], quant5[2][3];
+                bool canUseDiff = true;
+                for( size_t s = 0u; s < 2u; ++s )
+                {
+                    for( size_t c = 0u; c < 3u; ++c )
+                    {
+                        quant4[s][c] = static_cast<int32>( ( sums[s][c] * 15u + 1020u ) / 2040u );
+                        quant5[s][c] = static_cast<int32>( ( sums[s][c] * 31u + 1020u ) / 2040u );
+                    }
+                }
+                for( size_t c = 0u; c < 3u; ++c )
+                {
+                    const int32 delta = quant5[1][c] - quant5[0][c];
+                    canUseDiff &= delta >= -4 && delta <= 3;
+                }
+
+                for( uint32 diff = 0u; diff < ( canUseDiff ? 2u : 1u ); ++diff )
+                {
+                    uint32 error = 0u;
+                    uint8 tables[2];
+                    uint8 indices[2][8];
+                    for( size_t s = 0u; s < 2u; ++s )
+                    {
+                        int32 base[3];
+                        for( size_t c = 0u; c < 3u; ++c )
+                        {
+                            base[c] = diff ? extend5To8( static_cast<uint32>( quant5[s][c] ) )
+                                           : extend4To8( static_cast<uint32>( quant4[s][c] ) );
+                        }
+                        error += fitEtcSubBlock( subPixels[s], base, tables[s], indices[s] );
+                    }
+
+                    if( error < bestError )
+                    {
+                        bestError = error;
+                        uint32 hi = ( uint32( tables[0] ) << 5u ) | ( uint32( tables[1] ) << 2u ) |
+                                    ( diff << 1u ) | flip;
+                        for( size_t c = 0u; c < 3u; ++c )
+                        {
+                            if( diff )
+                            {
+                                hi |= uint32( quant5[0][c] ) << ( 27u - c * 8u );
+                                const uint32 delta = uint32( quant5[1][c] - quant5[0][c] ) & 0x07u;
+                                hi |= delta << ( 24u - c * 8u );
+                            }
+                            else
+                            {
+                                hi |= uint32( quant4[0][c] ) << ( 28u - c * 8u );
+                                hi |= uint32( quant4[1][c] ) << ( 24u - c * 8u );
+                            }
+                        }
+
+                        uint32 lo = 0u;
+                        for( size_t s = 0u; s < 2u; ++s )
+                        {
+                            for( size_t i = 0u; i < 8u; ++i )
+                            {
+                                const uint32 p = subPixelIdx[s][i];
+                                lo |= uint32( indices[s][i] >> 1u ) << ( 16u + p );
+                                lo |= uint32( indices[s][i] & 0x01u ) << p;
+                            }
+                        }
+
+                        bestHi = hi;
+                        bestLo = lo;
+                    }
+                }
+            }
+
+            writeBigEndian32( bestHi, outBlock );
+            writeBigEndian32( bestLo, outBlock + 4u );
+        }
+
+        enum EacMode
+        {
+            /// ETC2 RGBA8's alpha block
+            EacAlpha8,
+            EacR11Unorm,
+            EacR11Snorm
+        };
+
+        /// Returns the decoded value. 8 bits for EacAlpha8, 11 bits (signed for EacR11Snorm) otherwise
+        inline int32 decodeEacValue( int32 base, int32 multiplier, int32 modifier, EacMode mode )
+        {
+            const int32 step = multiplier ? multiplier * 8 : 1;
+            switch( mode )
+            {
+            case EacAlpha8:
+                return clampInt( base + modifier * multiplier, 0, 255 );
+            case EacR11Unorm:
+                return clampInt( base * 8 + 4 + modifier * step, 0, 2047 );
+            case EacR11Snorm:
+            default:
+                return clampInt( base * 8 + modifier * step, -1023, 1023 );
+            }
+        }
+
+        void encodeEac( const uint8 *srcRgba, size_t channel, EacMode mode, uint8 *outBlock )
+        {
+            // Targets in the decoded domain, in ETC's (column-major) pixel order
+            int32 targets[16];
+            int32 minTarget = std::numeric_limits<int32>::max();
+            int32 maxTarget = std::numeric_limits<int32>::min();
+            for( size_t p = 0u; p < 16u; ++p )
+            {
+                const uint8 raw = srcRgba[etcPixelToRowMajor( p ) * 4u + channel];
+                if( mode == EacAlpha8 )
+                    targets[p] = raw;
+                else if( mode == EacR11Unorm )
+                    targets[p] = ( raw * 2047 + 127 ) / 255;
+                else
+                    targets[p] = roundedDiv( readSnorm8( raw ) * 1023, 127 );
+                minTarget = std::min( minTarget, targets[p] );
+                maxTarget = std::max( maxTarget, targets[p] );
+            }
+
+            const int32 scale = mode == EacAlpha8 ? 1 : 8;
+            const int32 minBase = mode == EacR11Snorm ? -127 : 0;
+            const int32 maxBase = mode == EacR11Snorm ? 127 : 255;
+
+            uint32 bestError = std::numeric_limits<uint32>::max();
+            int32 bestBase = 0, bestMultiplier = 1, bestTable = 0;
+            uint8 bestIndices[16];
+            memset( bestIndices, 0, sizeof( bestIndices ) );
+
+            for( int32 t = 0; t < 16 && bestError != 0u; ++t )
+            {
+                const int32 lo = c_eacModifiers[t][3];
+                const int32 hi = c_eacModifiers[t][7];
+                const int32 idealMultiplier =
+                    clampInt( roundedDiv( maxTarget - minTarget, ( hi - lo ) * scale ), 1, 15 );
+
+                for( int32 m = idealMultiplier; m <= std::min( idealMultiplier + 1, 15 ); ++m )
+                {
+                    // Centre the table's range on the targets' range
+                    const int32 centre = ( minTarget + maxTarget - ( lo + hi ) * m * scale ) / 2;
+                    int32 idealBase;
+                    if( mode == EacAlpha8 )
+                        idealBase = centre;
+                    else if( mode == EacR11Unorm )
+                        idealBase = roundedDiv( centre - 4, 8 );
+                    else
+                        idealBase = roundedDiv( centre, 8 );
+
+                    for( int32 b = idealBase - 1; b <= idealBase + 1; ++b )
+                    {
+                        const int32 base = clampInt( b, minBase, maxBase );
+
+                        int32 palette[8];
+                        for( size_t k = 0u; k < 8u; ++k )
+                            palette[k] = decodeEacValue( base, m, c_eacModifiers[t][k], mode );
+
+                        uint32 error = 0u;
+                        uint8 indices[16];
+                        for( size_t p = 0u; p < 16u && error < bestError; ++p )
+                        {
+                            uint32 bestPixelError = std::numeric_limits<uint32>::max();
+                            for( uint8 k = 0u; k < 8u; ++k )
+                            {
+                                const int32 diff = palette[k] - targets[p];
+                                const uint32 pixelError = static_cast<uint32>( diff * diff );
+                                if( pixelError < bestPixelError )
+                                {
+                                    bestPixelError = pixelError;
+                                    indices[p] = k;
+                                }
+                            }
+                            error += bestPixelError;
+                        }
+
+                        if( error < bestError )
+                        {
+                            bestError = error;
+                            bestBase = base;
+                            bestMultiplier = m;
+                            bestTable = t;
+                            memcpy( bestIndices, indices, sizeof( indices ) );
+                        }
+                    }
+                }
+            }
+
+            outBlock[0] = static_cast<uint8>( bestBase );
+            outBlock[1] = static_cast<uint8>( ( bestMultiplier << 4 ) | bestTable );
+            uint64 bits = 0u;
+            for( size_t p = 0u; p < 16u; ++p )
+                bits |= uint64( bestIndices[p] ) << ( 45u - p * 3u );
+            for( size_t i = 0u; i < 6u; ++i )
+                outBlock[2u + i] = static_cast<uint8>( bits >> ( 40u - i * 8u ) );
+        }
+
+        void decodeEac( const uint8 *block, size_t channel, EacMode mode, uint8 *outRgba )
+        {
+            const int32 base = mode == EacR11Snorm ? readSnorm8( block[0] ) : block[0];
+            const int32 multiplier = block[1] >> 4u;
+            const int32 table = block[1] & 0x0Fu;
+
+            uint64 bits = 0u;
+            for( size_t i = 0u; i < 6u; ++i )
+                bits |= uint64( block[2u + i] ) << ( 40u - i * 8u );
+
+            for( size_t p = 0u; p < 16u; ++p )
+            {
+                const size_t idx = ( bits >> ( 45u - p * 3u ) ) & 0x07u;
+                const int32 value = decodeEacValue( base, multiplier, c_eacModifiers[table][idx], mode );
+
+                uint8 result;
+                if( mode == EacAlpha8 )
+                    result = static_cast<uint8>( value );
+                else if( mode == EacR11Unorm )
+                    result = static_cast<uint8>( ( value * 255 + 1023 ) / 2047 );
+                else
+                    result = static_cast<uint8>( static_cast<int8>( roundedDiv( value * 127, 1023 ) ) );
+                outRgba[etcPixelToRowMajor( p ) * 4u + channel] = result;
+            }
+        }
+    }  // namespace
+    //-----------------------------------------------------------------------------------
+    bool BlockCompression::canEncode( PixelFormatGpu format )
+    {
+        switch( format )
+        {
+            // clang-format off
+        case PFG_BC1_UNORM: case PFG_BC1_UNORM_SRGB:
+        case PFG_BC2_UNORM: case PFG_BC2_UNORM_SRGB:
+        case PFG_BC3_UNORM: case PFG_BC3_UNORM_SRGB:
+        case PFG_BC4_UNORM: case PFG_BC4_SNORM:
+        case PFG_BC5_UNORM: case PFG_BC5_SNORM:
+        case PFG_BC7_UNORM: case PFG_BC7_UNORM_SRGB:
+        case PFG_ETC1_RGB8_UNORM:
+        case PFG_ETC2_RGB8_UNORM:   case PFG_ETC2_RGB8_UNORM_SRGB:
+        case PFG_ETC2_RGBA8_UNORM:  case PFG_ETC2_RGBA8_UNORM_SRGB:
+        case PFG_EAC_R11_UNORM:     case PFG_EAC_R11_SNORM:
+        case PFG_EAC_R11G11_UNORM:  case PFG_EAC_R11G11_SNORM:
+            return true;
+            // clang-format on
+        default:
+            return false;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    bool BlockCompression::canDecode( PixelFormatGpu format )
+    {
+        return canEncode( format ) || format == PFG_ETC2_RGB8A1_UNORM ||
+               format == PFG_ETC2_RGB8A1_UNORM_SRGB;
+    }
+    //-----------------------------------------------------------------------------------
+    PixelFormatGpu BlockCompression::getUncompressedFormat( PixelFormatGpu format )
+    {
+        if( PixelFormatGpuUtils::isSRgb( format ) )
+            return PFG_RGBA8_UNORM_SRGB;
+        if( PixelFormatGpuUtils::isSigned( format ) )
+            return PFG_RGBA8_SNORM;
+        return PFG_RGBA8_UNORM;
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompression::encodeBlock( const uint8 *srcRgba, PixelFormatGpu dstFormat, void *dstBlock )
+    {
+        uint8 *dst = reinterpret_cast<uint8 *>( dstBlock );
+
+        switch( dstFormat )
+        {
+        case PFG_BC1_UNORM:
+        case PFG_BC1_UNORM_SRGB:
+            encodeBc1( srcRgba, true, dst );
+            break;
+        case PFG_BC2_UNORM:
+        case PFG_BC2_UNORM_SRGB:
+            encodeBc2Alpha( srcRgba, dst );
+            encodeBc1( srcRgba, false, dst + 8u );
+            break;
+        case PFG_BC3_UNORM:
+        case PFG_BC3_UNORM_SRGB:
+            encodeAlphaBlock( srcRgba, 3u, false, dst );
+            encodeBc1( srcRgba, false, dst + 8u );
+            break;
+        case PFG_BC4_UNORM:
+        case PFG_BC4_SNORM:
+            encodeAlphaBlock( srcRgba, 0u, dstFormat == PFG_BC4_SNORM, dst );
+            break;
+        case PFG_BC5_UNORM:
+        case PFG_BC5_SNORM:
+            encodeAlphaBlock( srcRgba, 0u, dstFormat == PFG_BC5_SNORM, dst );
+            encodeAlphaBlock( srcRgba, 1u, dstFormat == PFG_BC5_SNORM, dst + 8u );
+            break;
+        case PFG_BC7_UNORM:
+        case PFG_BC7_UNORM_SRGB:
+            encodeBc7( srcRgba, dst );
+            break;
+        case PFG_ETC1_RGB8_UNORM:
+        case PFG_ETC2_RGB8_UNORM:
+        case PFG_ETC2_RGB8_UNORM_SRGB:
+            encodeEtc1( srcRgba, dst );
+            break;
+        case PFG_ETC2_RGBA8_UNORM:
+        case PFG_ETC2_RGBA8_UNORM_SRGB:
+            encodeEac( srcRgba, 3u, EacAlpha8, dst );
+            encodeEtc1( srcRgba, dst + 8u );
+            break;
+        case PFG_EAC_R11_UNORM:
+            encodeEac( srcRgba, 0u, EacR11Unorm, dst );
+            break;
+        case PFG_EAC_R11_SNORM:
+            encodeEac( srcRgba, 0u, EacR11Snorm, dst );
+            break;
+        case PFG_EAC_R11G11_UNORM:
+            encodeEac( srcRgba, 0u, EacR11Unorm, dst );
+            encodeEac( srcRgba, 1u, EacR11Unorm, dst + 8u );
+            break;
+        case PFG_EAC_R11G11_SNORM:
+            encodeEac( srcRgba, 0u, EacR11Snorm, dst );
+            encodeEac( srcRgba, 1u, EacR11Snorm, dst + 8u );
+            break;
+        default:
+            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                         "Compressing to " + String( PixelFormatGpuUtils::toString( dstFormat ) ) +
+                             " is not supported",
+                         "BlockCompression::encodeBlock" );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompression::decodeBlock( const void *srcBlock, PixelFormatGpu srcFormat, uint8 *dstRgba )
+    {
+        const uint8 *src = reinterpret_cast<const uint8 *>( srcBlock );
+
+        // Defaults for the channels the format doesn't have
+        const uint8 one = PixelFormatGpuUtils::isSigned( srcFormat ) ? 127u : 255u;
+        for( size_t i = 0u; i < 16u; ++i )
+        {
+            dstRgba[i * 4u + 0u] = 0u;
+            dstRgba[i * 4u + 1u] = 0u;
+            dstRgba[i * 4u + 2u] = 0u;
+            dstRgba[i * 4u + 3u] = one;
+        }
+
+        switch( srcFormat )
+        {
+        case PFG_BC1_UNORM:
+        case PFG_BC1_UNORM_SRGB:
+            decodeBc1( src, true, dstRgba );
+            break;
+        case PFG_BC2_UNORM:
+        case PFG_BC2_UNORM_SRGB:
+            decodeBc1( src + 8u, false, dstRgba );
+            decodeBc2Alpha( src, dstRgba );
+            break;
+        case PFG_BC3_UNORM:
+        case PFG_BC3_UNORM_SRGB:
+            decodeBc1( src + 8u, false, dstRgba );
+            decodeAlphaBlock( src, 3u, false, dstRgba );
+            break;
+        case PFG_BC4_UNORM:
+        case PFG_BC4_SNORM:
+            decodeAlphaBlock( src, 0u, srcFormat == PFG_BC4_SNORM, dstRgba );
+            break;
+        case PFG_BC5_UNORM:
+        case PFG_BC5_SNORM:
+            decodeAlphaBlock( src, 0u, srcFormat == PFG_BC5_SNORM, dstRgba );
+            decodeAlphaBlock( src + 8u, 1u, srcFormat == PFG_BC5_SNORM, dstRgba );
+            break;
+        case PFG_BC7_UNORM:
+        case PFG_BC7_UNORM_SRGB:
+            decodeBc7( src, dstRgba );
+            break;
+        case PFG_ETC1_RGB8_UNORM:
+        case PFG_ETC2_RGB8_UNORM:
+        case PFG_ETC2_RGB8_UNORM_SRGB:
+            decodeEtc( src, false, dstRgba );
+            break;
+        case PFG_ETC2_RGB8A1_UNORM:
+        case PFG_ETC2_RGB8A1_UNORM_SRGB:
+            decodeEtc( src, true, dstRgba );
+            break;
+        case PFG_ETC2_RGBA8_UNORM:
+        case PFG_ETC2_RGBA8_UNORM_SRGB:
+            decodeEtc( src + 8u, false, dstRgba );
+            decodeEac( src, 3u, EacAlpha8, dstRgba );
+            break;
+        case PFG_EAC_R11_UNORM:
+            decodeEac( src, 0u, EacR11Unorm, dstRgba );
+            break;
+        case PFG_EAC_R11_SNORM:
+            decodeEac( src, 0u, EacR11Snorm, dstRgba );
+            break;
+        case PFG_EAC_R11G11_UNORM:
+            decodeEac( src, 0u, EacR11Unorm, dstRgba );
+            decodeEac( src + 8u, 1u, EacR11Unorm, dstRgba );
+            break;
+        case PFG_EAC_R11G11_SNORM:
+            decodeEac( src, 0u, EacR11Snorm, dstRgba );
+            decodeEac( src + 8u, 1u, EacR11Snorm, dstRgba );
+            break;
+        default:
+            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                         "Decompressing " + String( PixelFormatGpuUtils::toString( srcFormat ) ) +
+                             " is not supported",
+                         "BlockCompression::decodeBlock" );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompression::compress( const TextureBox &src, PixelFormatGpu srcFormat, TextureBox &dst,
+                                     PixelFormatGpu dstFormat )
+    {
+        if( !canEncode( dstFormat ) )
+        {
+            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                         "Compressing to " + String( PixelFormatGpuUtils::toString( dstFormat ) ) +
+                             " is not supported",
+                         "BlockCompression::compress" );
+        }
+
+        assert( src.equalSize( dst ) );
+        assert( !src.isCompressed() );
+
+        const PixelFormatGpu rgbaFormat = getUncompressedFormat( dstFormat );
+        const size_t blockSize = PixelFormatGpuUtils::getCompressedBlockSize( dstFormat );
+
+        const uint32 width = src.width;
+        const uint32 height = src.height;
+        const uint32 depthOrSlices = src.getDepthOrSlices();
+        const uint32 numBlocksX = ( width + 3u ) / 4u;
+
+        // A row of blocks, in the format the encoder takes
+        const uint32 rgbaBytesPerRow = numBlocksX * 4u * 4u;
+        uint8 *rgbaRows =
+            reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( rgbaBytesPerRow * 4u, MEMCATEGORY_RESOURCE ) );
+
+        for( uint32 z = 0u; z < depthOrSlices; ++z )
+        {
+            for( uint32 y = 0u; y < height; y += 4u )
+            {
+                const uint32 numRows = std::min( height - y, 4u );
+
+                TextureBox srcRows( width, numRows, 1u, 1u, src.bytesPerPixel, src.bytesPerRow,
+                                    src.bytesPerRow * numRows );
+                srcRows.data = src.at( src.x, src.y + y, src.getZOrSlice() + z );
+                TextureBox rgbaBox( width, numRows, 1u, 1u, 4u, rgbaBytesPerRow,
+                                    rgbaBytesPerRow * numRows );
+                rgbaBox.data = rgbaRows;
+                PixelFormatGpuUtils::bulkPixelConversion( srcRows, srcFormat, rgbaBox, rgbaFormat );
+
+                // Pad partial blocks by repeating the last column & row
+                for( uint32 row = 0u; row < 4u; ++row )
+                {
+                    uint8 *rowPtr = rgbaRows + row * rgbaBytesPerRow;
+                    if( row >= numRows )
+                        memcpy( rowPtr, rgbaRows + ( numRows - 1u ) * rgbaBytesPerRow, width * 4u );
+                    for( uint32 x = width; x < numBlocksX * 4u; ++x )
+                        memcpy( rowPtr + x * 4u, rowPtr + ( width - 1u ) * 4u, 4u );
+                }
+
+                uint8 *dstBlock =
+                    reinterpret_cast<uint8 *>( dst.at( dst.x, dst.y + y, dst.getZOrSlice() + z ) );
+                for( uint32 blockX = 0u; blockX < numBlocksX; ++blockX )
+                {
+                    uint8 rgba[64];
+                    for( uint32 row = 0u; row < 4u; ++row )
+                        memcpy( rgba + row * 16u, rgbaRows + row * rgbaBytesPerRow + blockX * 16u, 16u );
+                    encodeBlock( rgba, dstFormat, dstBlock );
+                    dstBlock += blockSize;
+                }
+            }
+        }
+
+        OGRE_FREE_SIMD( rgbaRows, MEMCATEGORY_RESOURCE );
+    }
+    //-----------------------------------------------------------------------------------
+    void BlockCompression::decompress( const TextureBox &src, PixelFormatGpu srcFormat, TextureBox &dst,
+                                       PixelFormatGpu dstFormat )
+    {
+        if( !canDecode( srcFormat ) )
+        {
+            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                         "Decompressing " + String( PixelFormatGpuUtils::toString( srcFormat ) ) +
+                             " is not supported",
+                         "BlockCompression::decompress" );
+        }
+
+        assert( src.equalSize( dst ) );
+        assert( !dst.isCompressed() );
+
+        const PixelFormatGpu rgbaFormat = getUncompressedFormat( srcFormat );
+        const size_t blockSize = PixelFormatGpuUtils::getCompressedBlockSize( srcFormat );
+
+        const uint32 width = src.width;
+        const uint32 height = src.height;
+        const uint32 depthOrSlices = src.getDepthOrSlices();
+        const uint32 numBlocksX = ( width + 3u ) / 4u;
+
+        const uint32 rgbaBytesPerRow = numBlocksX * 4u * 4u;
+        uint8 *rgbaRows =
+            reinterpret_cast<uint8 *>( OGRE_MALLOC_SIMD( rgbaBytesPerRow * 4u, MEMCATEGORY_RESOURCE ) );
+
+        for( uint32 z = 0u; z < depthOrSlices; ++z )
+        {
+            for( uint32 y = 0u; y < height; y += 4u )
+            {
+                const uint32 numRows = std::min( height - y, 4u );
+
+                const uint8 *srcBlock =
+                    reinterpret_cast<const uint8 *>( src.at( src.x, src.y + y, src.getZOrSlice() + z ) );
+                for( uint32 blockX = 0u; blockX < numBlocksX; ++blockX )
+                {
+                    uint8 rgba[64];
+                    decodeBlock( srcBlock, srcFormat, rgba );
+                    for( uint32 row = 0u; row < 4u; ++row )
+                        memcpy( rgbaRows + row * rgbaBytesPerRow + blockX * 16u, rgba + row * 16u, 16u );
+                    srcBlock += blockSize;
+                }
+
+                TextureBox rgbaBox( width, numRows, 1u, 1u, 4u, rgbaBytesPerRow,
+                                    rgbaBytesPerRow * numRows );
+                rgbaBox.data = rgbaRows;
+                TextureBox dstRows( width, numRows, 1u, 1u, dst.bytesPerPixel, dst.bytesPerRow,
+                                    dst.bytesPerRow * numRows );
+                dstRows.data = dst.at( dst.x, dst.y + y, dst.getZOrSlice() + z );
+                PixelFormatGpuUtils::bulkPixelConversion( rgbaBox, rgbaFormat, dstRows, dstFormat );
+            }
+        }
+
+        OGRE_FREE_SIMD( rgbaRows, MEMCATEGORY_RESOURCE );
+    }
+}  // namespace Ogre
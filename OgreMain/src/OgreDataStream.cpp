@@ -35,6 +35,19 @@ THE SOFTWARE.
 
 #include <fstream>
 
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    if !defined( NOMINMAX ) && defined( _MSC_VER )
+#        define NOMINMAX  // required to stop windows.h messing up std::min
+#    endif
+#    include <windows.h>
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
 namespace Ogre
 {
     //-----------------------------------------------------------------------
@@ -765,5 +778,117 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    MappedFileDataStream::MappedFileDataStream( const String &name, const String &fullPath ) :
+        DataStream( name, READ ),
+        mData( 0 ),
+        mPos( 0 )
+    {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+        HANDLE fileHandle = CreateFileA( fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0,
+                                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0 );
+        if( fileHandle == INVALID_HANDLE_VALUE )
+        {
+            OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot open file: " + fullPath,
+                         "MappedFileDataStream::MappedFileDataStream" );
+        }
+
+        LARGE_INTEGER fileSize;
+        if( !GetFileSizeEx( fileHandle, &fileSize ) )
+            fileSize.QuadPart = 0;
+        mSize = static_cast<size_t>( fileSize.QuadPart );
+
+        if( mSize > 0u )
+        {
+            // The view keeps the mapping (and the file) alive, the handles can be closed right away
+            HANDLE mappingHandle = CreateFileMappingA( fileHandle, 0, PAGE_READONLY, 0, 0, 0 );
+            if( mappingHandle )
+            {
+                mData = static_cast<const uint8 *>(
+                    MapViewOfFile( mappingHandle, FILE_MAP_READ, 0, 0, 0 ) );
+                CloseHandle( mappingHandle );
+            }
+        }
+        CloseHandle( fileHandle );
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+        const int fd = open( fullPath.c_str(), O_RDONLY );
+        if( fd == -1 )
+        {
+            OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot open file: " + fullPath,
+                         "MappedFileDataStream::MappedFileDataStream" );
+        }
+
+        struct stat fileStat;
+        if( fstat( fd, &fileStat ) != 0 )
+            fileStat.st_size = 0;
+        mSize = static_cast<size_t>( fileStat.st_size );
+
+        if( mSize > 0u )
+        {
+            // The mapping keeps the file alive, the descriptor can be closed right away
+            void *mapping = mmap( 0, mSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if( mapping != MAP_FAILED )
+                mData = static_cast<const uint8 *>( mapping );
+        }
+        ::close( fd );
+#else
+        OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                     "Memory-mapped files are not supported on this platform",
+                     "MappedFileDataStream::MappedFileDataStream" );
+#endif
+
+        if( mSize > 0u && !mData )
+        {
+            OGRE_EXCEPT( Exception::ERR_INTERNAL_ERROR, "Cannot map file: " + fullPath,
+                         "MappedFileDataStream::MappedFileDataStream" );
+        }
+    }
+    //-----------------------------------------------------------------------
+    MappedFileDataStream::~MappedFileDataStream() { close(); }
+    //-----------------------------------------------------------------------
+    size_t MappedFileDataStream::read( void *buf, size_t count )
+    {
+        const size_t cnt = std::min( count, mSize - mPos );
+        if( cnt == 0 )
+            return 0;
+
+        memcpy( buf, mData + mPos, cnt );
+        mPos += cnt;
+        return cnt;
+    }
+    //-----------------------------------------------------------------------
+    void MappedFileDataStream::skip( long count )
+    {
+        const size_t newPos = static_cast<size_t>( static_cast<long>( mPos ) + count );
+        assert( newPos <= mSize );
+        mPos = std::min( newPos, mSize );
+    }
+    //-----------------------------------------------------------------------
+    void MappedFileDataStream::seek( size_t pos )
+    {
+        assert( pos <= mSize );
+        mPos = std::min( pos, mSize );
+    }
+    //-----------------------------------------------------------------------
+    size_t MappedFileDataStream::tell() const { return mPos; }
+    //-----------------------------------------------------------------------
+    bool MappedFileDataStream::eof() const { return mPos >= mSize; }
+    //-----------------------------------------------------------------------
+    void MappedFileDataStream::close()
+    {
+        mAccess = 0;
+        if( mData )
+        {
+#if OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+            UnmapViewOfFile( mData );
+#elif OGRE_PLATFORM != OGRE_PLATFORM_WINRT
+            munmap( const_cast<uint8 *>( mData ), mSize );
+#endif
+            mData = 0;
+        }
+        mPos = 0;
+        mSize = 0;
+    }
+    //-----------------------------------------------------------------------
 
 }  // namespace Ogre
@@ -32,13 +32,122 @@ THE SOFTWARE.
 #include "Math/Array/OgreArraySphere.h"
 #include "Math/Array/OgreBooleanMask.h"
 #include "Math/Array/OgreMathlib.h"
+#include "Math/Array/OgreObjectSpatialIndex.h"
+#include "Math/Array/OgreTriangleBvh.h"
+#include "OgreItem.h"
+#include "OgreMesh2.h"
 #include "OgreRoot.h"
+#include "Threading/OgreUniformScalableTask.h"
 
 namespace Ogre
 {
+    /// Runs the query only on the packs that the spatial index didn't reject
+    template <typename TQuery, typename TListener>
+    static bool executeOnPacks( TQuery *query, const ObjectData &firstObjData,
+                                const ObjectSpatialIndex *spatialIndex,
+                                const FastArray<uint32> &packs, TListener *listener )
+    {
+        FastArray<uint32>::const_iterator itor = packs.begin();
+        FastArray<uint32>::const_iterator endt = packs.end();
+
+        while( itor != endt )
+        {
+            ObjectData objData( firstObjData );
+            objData.advancePack( *itor );
+            if( !query->execute( objData, spatialIndex->getNumObjectsInPack( *itor ), listener ) )
+                return false;
+            ++itor;
+        }
+
+        return true;
+    }
+    //---------------------------------------------------------------------
+    namespace
+    {
+        /// Returns true if the vertices of the Item may not be where its Mesh says, because
+        /// of skeletal animation or poses. Its triangle BVH only knows the bind pose.
+        bool hasAnimatedVertices( const Item *item )
+        {
+            const size_t numSubItems = item->getNumSubItems();
+            for( size_t i = 0; i < numSubItems; ++i )
+            {
+                const SubItem *subItem = item->getSubItem( i );
+                if( subItem->hasSkeletonAnimation() || subItem->getNumPoses() )
+                    return true;
+            }
+
+            return false;
+        }
+
+        /// Runs DefaultIntersectionSceneQuery::_sweepThread in the SceneManager worker threads
+        class IntersectionSweepTask final : public UniformScalableTask
+        {
+            DefaultIntersectionSceneQuery *mQuery;
+
+        public:
+            IntersectionSweepTask( DefaultIntersectionSceneQuery *query ) : mQuery( query ) {}
+            void execute( size_t threadId, size_t ) override { mQuery->_sweepThread( threadId ); }
+        };
+
+        struct ProxyMinKeyLess
+        {
+            bool operator()( const DefaultIntersectionSceneQuery::Proxy &a,
+                             const DefaultIntersectionSceneQuery::Proxy &b ) const
+            {
+                return a.minKey < b.minKey;
+            }
+        };
+
+        const uint32 c_noRank = std::numeric_limits<uint32>::max();
+
+        /// Runs DefaultBatchRaySceneQuery::_castRaysThread in the SceneManager worker threads
+        class BatchRayCastTask final : public UniformScalableTask
+        {
+            DefaultBatchRaySceneQuery *mQuery;
+
+        public:
+            BatchRayCastTask( DefaultBatchRaySceneQuery *query ) : mQuery( query ) {}
+            void execute( size_t threadId, size_t ) override { mQuery->_castRaysThread( threadId ); }
+        };
+
+        /// Slab test of a packet of rays against a box. Returns the mask of the rays that hit
+        /// it closer than their best distance so far, and where they enter it in outTMin
+        inline uint32 intersectsPacket( const ArrayVector3 &origin, const ArrayVector3 &invDir,
+                                        const Vector3 &boxMin, const Vector3 &boxMax,
+                                        const Real *RESTRICT_ALIAS best,
+                                        Real *RESTRICT_ALIAS outTMin )
+        {
+            ArrayVector3 vMin, vMax;
+            vMin.setAll( boxMin );
+            vMax.setAll( boxMax );
+
+            const ArrayVector3 t0 = ( vMin - origin ) * invDir;
+            const ArrayVector3 t1 = ( vMax - origin ) * invDir;
+            ArrayVector3 tNear( t0 ), tFar( t0 );
+            tNear.makeFloor( t1 );
+            tFar.makeCeil( t1 );
+
+            const ArrayReal tMin =
+                Mathlib::Max( Mathlib::Max( tNear.mChunkBase[0], tNear.mChunkBase[1] ),
+                              Mathlib::Max( tNear.mChunkBase[2], ARRAY_REAL_ZERO ) );
+            const ArrayReal tMax = Mathlib::Min( Mathlib::Min( tFar.mChunkBase[0], tFar.mChunkBase[1] ),
+                                                 tFar.mChunkBase[2] );
+            const ArrayReal arrayBest = *reinterpret_cast<const ArrayReal *>( best );
+
+            // mask = tMin <= tMax && tMin < best
+            const ArrayMaskR mask = Mathlib::And( Mathlib::CompareLessEqual( tMin, tMax ),
+                                                  Mathlib::CompareLess( tMin, arrayBest ) );
+            CastArrayToReal( outTMin, tMin );
+            return BooleanMask4::getScalarMask( mask );
+        }
+    }  // namespace
+
+    const size_t DefaultIntersectionSceneQuery::c_minProxiesForThreads = 2048u;
     //---------------------------------------------------------------------
     DefaultIntersectionSceneQuery::DefaultIntersectionSceneQuery( SceneManager *creator ) :
-        IntersectionSceneQuery( creator )
+        IntersectionSceneQuery( creator ),
+        mNumPrevProxies( 0 ),
+        mSweepAxis( 0 )
     {
         // No world geometry results supported
         mSupportedWorldFragments.insert( SceneQuery::WFT_NONE );
@@ -46,79 +155,302 @@ namespace Ogre
     //---------------------------------------------------------------------
     DefaultIntersectionSceneQuery::~DefaultIntersectionSceneQuery() {}
     //---------------------------------------------------------------------
-    void DefaultIntersectionSceneQuery::execute( IntersectionSceneQueryListener *listener )
+    void DefaultIntersectionSceneQuery::gatherProxies( Vector3 &outCenterSum, Vector3 &outCenterSqSum )
     {
-        OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
-                     "IntersectionSceneQuery not yet ported to Ogre 2.x!",
-                     "DefaultIntersectionSceneQuery::execute" );
-#ifdef ENABLE_INCOMPATIBLE_OGRE_2_0
-        // Iterate over all movable types
-        Root::MovableObjectFactoryIterator factIt =
-            Root::getSingleton().getMovableObjectFactoryIterator();
-        while( factIt.hasMoreElements() )
-        {
-            SceneManager::MovableObjectIterator objItA =
-                mParentSceneMgr->getMovableObjectIterator( factIt.getNext()->getType() );
-            while( objItA.hasMoreElements() )
+        mProxies.clear();
+        outCenterSum = Vector3::ZERO;
+        outCenterSqSum = Vector3::ZERO;
+
+        const ArrayInt ourQueryMask = Mathlib::SetAll( mQueryMask );
+        const ArrayInt layerVisibility = Mathlib::SetAll( VisibilityFlags::LAYER_VISIBILITY );
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            ObjectMemoryManager &memoryManager =
+                mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+
+            const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+            const size_t firstRq = std::min<size_t>( mFirstRq, numRenderQueues );
+            const size_t lastRq = std::min<size_t>( mLastRq, numRenderQueues );
+
+            // Must happen before taking pointers to the ranks
+            mPrevRanks[i].resize( numRenderQueues );
+
+            for( size_t j = firstRq; j < lastRq; ++j )
             {
-                MovableObject *a = objItA.getNext();
-                // skip entire section if type doesn't match
-                if( !( a->getTypeFlags() & mQueryTypeMask ) )
-                    break;
+                ObjectData objData;
+                const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
 
-                // Skip if a does not pass the mask
-                if( !( a->getQueryFlags() & mQueryMask ) || !a->isInScene() )
-                    continue;
+                FastArray<uint32> &prevRanks = mPrevRanks[i][j];
+                prevRanks.resizePOD( alignToNextMultiple<size_t>( totalObjs, ARRAY_PACKED_REALS ),
+                                     c_noRank );
 
-                // Check against later objects in the same group
-                SceneManager::MovableObjectIterator objItB = objItA;
-                while( objItB.hasMoreElements() )
+                for( size_t k = 0; k < totalObjs; k += ARRAY_PACKED_REALS )
                 {
-                    MovableObject *b = objItB.getNext();
+                    ArrayInt *RESTRICT_ALIAS visibilityFlags =
+                        reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mVisibilityFlags );
+                    ArrayInt *RESTRICT_ALIAS queryFlags =
+                        reinterpret_cast<ArrayInt * RESTRICT_ALIAS>( objData.mQueryFlags );
 
-                    // Apply mask to b (both must pass)
-                    if( ( b->getQueryFlags() & mQueryMask ) && b->isInScene() )
-                    {
-                        const AxisAlignedBox &box1 = a->getWorldBoundingBox();
-                        const AxisAlignedBox &box2 = b->getWorldBoundingBox();
+                    // passMask = ( (*queryFlags & ourQueryMask) != 0 ) && isVisible;
+                    const ArrayMaskI passMask =
+                        Mathlib::And( Mathlib::TestFlags4( *queryFlags, ourQueryMask ),
+                                      Mathlib::TestFlags4( *visibilityFlags, layerVisibility ) );
+
+                    const uint32 scalarMask = BooleanMask4::getScalarMask( passMask );
 
-                        if( box1.intersects( box2 ) )
+                    for( size_t l = 0; l < ARRAY_PACKED_REALS; ++l )
+                    {
+                        // There's no need to check objData.mOwner[l] is null because
+                        // we set mVisibilityFlags to 0 on slot removals
+                        if( IS_BIT_SET( l, scalarMask ) )
                         {
-                            if( !listener->queryResult( a, b ) )
-                                return;
+                            Proxy proxy;
+                            objData.mWorldAabb->getAsAabb( proxy.aabb, l );
+                            proxy.prevRank = prevRanks[k + l];
+                            proxy.rank = &prevRanks[k + l];
+                            proxy.owner = objData.mOwner[l];
+                            mProxies.push_back( proxy );
+
+                            outCenterSum += proxy.aabb.mCenter;
+                            outCenterSqSum += proxy.aabb.mCenter * proxy.aabb.mCenter;
+
+#if OGRE_DEBUG_MODE
+                            // Queries must be performed after all bounds have been updated
+                            assert( !proxy.owner->isCachedAabbOutOfDate() &&
+                                    "Perform the queries after MovableObject::updateAllBounds "
+                                    "has been called!" );
+#endif
                         }
                     }
+
+                    objData.advancePack();
                 }
-                // Check  against later groups
-                Root::MovableObjectFactoryIterator factItLater = factIt;
-                while( factItLater.hasMoreElements() )
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultIntersectionSceneQuery::sortProxies( bool useRankHints )
+    {
+        const size_t numProxies = mProxies.size();
+
+        if( !useRankHints )
+        {
+            std::sort( mProxies.begin(), mProxies.end(), ProxyMinKeyLess() );
+            return;
+        }
+
+        // Put the proxies back in the order they were sorted last time (counting sort).
+        // Objects that weren't there go last.
+        const size_t numPrevProxies = mNumPrevProxies;
+        mRankCounts.clear();
+        mRankCounts.resizePOD( numPrevProxies + 2u, 0u );
+
+        size_t numRanked = 0;
+        FastArray<Proxy>::iterator itor = mProxies.begin();
+        FastArray<Proxy>::iterator endt = mProxies.end();
+        while( itor != endt )
+        {
+            const size_t bucket = std::min<size_t>( itor->prevRank, numPrevProxies );
+            ++mRankCounts[bucket + 1u];
+            if( bucket != numPrevProxies )
+                ++numRanked;
+            ++itor;
+        }
+
+        for( size_t i = 1u; i < numPrevProxies + 2u; ++i )
+            mRankCounts[i] += mRankCounts[i - 1u];
+
+        mTmpProxies.resizePOD( numProxies );
+        itor = mProxies.begin();
+        while( itor != endt )
+        {
+            const size_t bucket = std::min<size_t>( itor->prevRank, numPrevProxies );
+            mTmpProxies[mRankCounts[bucket]++] = *itor;
+            ++itor;
+        }
+        mProxies.swap( mTmpProxies );
+
+        // The old order is almost sorted if objects didn't move much: insertion sort is ~O(N).
+        // If it turns out to be far from sorted (e.g. slots got reused), give up on it.
+        size_t budget = numRanked * 8u;
+        for( size_t i = 1u; i < numRanked && budget; ++i )
+        {
+            const Proxy proxy = mProxies[i];
+            size_t j = i;
+            while( j > 0u && mProxies[j - 1u].minKey > proxy.minKey && budget )
+            {
+                mProxies[j] = mProxies[j - 1u];
+                --j;
+                --budget;
+            }
+            mProxies[j] = proxy;
+        }
+
+        if( !budget )
+            std::sort( mProxies.begin(), mProxies.begin() + ptrdiff_t( numRanked ), ProxyMinKeyLess() );
+
+        std::sort( mProxies.begin() + ptrdiff_t( numRanked ), mProxies.end(), ProxyMinKeyLess() );
+        std::inplace_merge( mProxies.begin(), mProxies.begin() + ptrdiff_t( numRanked ), mProxies.end(),
+                            ProxyMinKeyLess() );
+    }
+    //---------------------------------------------------------------------
+    void DefaultIntersectionSceneQuery::prepareSortedAabbs()
+    {
+        const size_t numProxies = mProxies.size();
+        const size_t numPacks = ( numProxies + ARRAY_PACKED_REALS - 1u ) / ARRAY_PACKED_REALS;
+
+        if( mSortedAabbs.size() < numPacks )
+        {
+            RawSimdUniquePtr<ArrayAabb, MEMCATEGORY_SCENE_OBJECTS> sortedAabbs(
+                std::max<size_t>( numPacks, mSortedAabbs.size() * 2u ) );
+            mSortedAabbs.swap( sortedAabbs );
+        }
+
+        ArrayAabb *sortedAabbs = mSortedAabbs.get();
+        for( size_t i = 0; i < numProxies; ++i )
+            sortedAabbs[i / ARRAY_PACKED_REALS].setFromAabb( mProxies[i].aabb, i % ARRAY_PACKED_REALS );
+    }
+    //---------------------------------------------------------------------
+    void DefaultIntersectionSceneQuery::_sweepThread( size_t threadIdx )
+    {
+        FastArray<MovableObject *> &pairs = mThreadPairs[threadIdx];
+        FastArray<ChunkResult> &chunks = mThreadChunks[threadIdx];
+
+        const size_t numProxies = mProxies.size();
+        const Proxy *proxies = mProxies.begin();
+        const ArrayAabb *sortedAabbs = mSortedAabbs.get();
+
+        size_t start, count;
+        while( mWorkRange.acquire( threadIdx, start, count ) )
+        {
+            ChunkResult chunk;
+            chunk.firstProxy = start;
+            chunk.threadIdx = threadIdx;
+            chunk.start = pairs.size();
+
+            for( size_t i = start; i < start + count; ++i )
+            {
+                ArrayAabb aabb( ArrayVector3::ZERO, ArrayVector3::ZERO );
+                aabb.setAll( proxies[i].aabb );
+                const Real maxKey = proxies[i].maxKey;
+
+                // Start at the pack containing i + 1 ignoring the lanes up to i, and stop once
+                // the pack starts beyond our maximum along the sweep axis (they're sorted).
+                size_t j = ( ( i + 1u ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
+                uint32 laneMask = ~0u << ( ( i + 1u ) % ARRAY_PACKED_REALS );
+
+                while( j < numProxies && proxies[j].minKey <= maxKey )
                 {
-                    SceneManager::MovableObjectIterator objItC =
-                        mParentSceneMgr->getMovableObjectIterator( factItLater.getNext()->getType() );
-                    while( objI7tC.hasMoreElements() )
-                    {
-                        MovableObject *c = objItC.getNext();
-                        // skip entire section if type doesn't match
-                        if( !( c->getTypeFlags() & mQueryTypeMask ) )
-                            break;
+                    const size_t numLanes = std::min<size_t>( numProxies - j, ARRAY_PACKED_REALS );
+                    laneMask &= ( 1u << numLanes ) - 1u;
 
-                        // Apply mask to c (both must pass)
-                        if( ( c->getQueryFlags() & mQueryMask ) && c->isInScene() )
+                    const ArrayMaskR hitMask = aabb.intersects( sortedAabbs[j / ARRAY_PACKED_REALS] );
+                    const uint32 scalarMask = BooleanMask4::getScalarMask( hitMask ) & laneMask;
+
+                    for( size_t k = 0; k < ARRAY_PACKED_REALS; ++k )
+                    {
+                        if( IS_BIT_SET( k, scalarMask ) )
                         {
-                            const AxisAlignedBox &box1 = a->getWorldBoundingBox();
-                            const AxisAlignedBox &box2 = c->getWorldBoundingBox();
-
-                            if( box1.intersects( box2 ) )
-                            {
-                                if( !listener->queryResult( a, c ) )
-                                    return;
-                            }
+                            pairs.push_back( proxies[i].owner );
+                            pairs.push_back( proxies[j + k].owner );
                         }
                     }
+
+                    laneMask = ~0u;
+                    j += ARRAY_PACKED_REALS;
                 }
             }
+
+            chunk.end = pairs.size();
+            chunks.push_back( chunk );
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultIntersectionSceneQuery::execute( IntersectionSceneQueryListener *listener )
+    {
+        assert( mFirstRq < mLastRq && "This query will never hit any result!" );
+
+        Vector3 centerSum, centerSqSum;
+        gatherProxies( centerSum, centerSqSum );
+
+        const size_t numProxies = mProxies.size();
+
+        // Sweep along the axis where objects are most spread out. Only switch axes
+        // when another one is clearly better, since that discards the previous order.
+        const Real invNumProxies = numProxies ? Real( 1.0 ) / Real( numProxies ) : Real( 0 );
+        const Vector3 centerMean = centerSum * invNumProxies;
+        const Vector3 variance = centerSqSum * invNumProxies - centerMean * centerMean;
+
+        uint32 sweepAxis = mSweepAxis;
+        for( uint32 i = 0; i < 3u; ++i )
+        {
+            if( variance[i] > variance[sweepAxis] && variance[i] > variance[mSweepAxis] * 1.5f )
+                sweepAxis = i;
+        }
+        const bool useRankHints = sweepAxis == mSweepAxis;
+        mSweepAxis = sweepAxis;
+
+        FastArray<Proxy>::iterator itor = mProxies.begin();
+        FastArray<Proxy>::iterator endt = mProxies.end();
+        while( itor != endt )
+        {
+            itor->minKey = itor->aabb.mCenter[sweepAxis] - itor->aabb.mHalfSize[sweepAxis];
+            itor->maxKey = itor->aabb.mCenter[sweepAxis] + itor->aabb.mHalfSize[sweepAxis];
+            ++itor;
+        }
+
+        sortProxies( useRankHints );
+
+        for( size_t i = 0; i < numProxies; ++i )
+            *mProxies[i].rank = static_cast<uint32>( i );
+        mNumPrevProxies = numProxies;
+
+        if( numProxies < 2u )
+            return;
+
+        prepareSortedAabbs();
+
+        const size_t numThreads = numProxies >= c_minProxiesForThreads
+                                      ? std::max<size_t>( mParentSceneMgr->getNumWorkerThreads(), 1u )
+                                      : 1u;
+        mThreadPairs.resize( numThreads );
+        mThreadChunks.resize( numThreads );
+        for( size_t i = 0; i < numThreads; ++i )
+        {
+            mThreadPairs[i].clear();
+            mThreadChunks[i].clear();
+        }
+
+        mWorkRange.reset( numProxies, numThreads, ARRAY_PACKED_REALS );
+        if( numThreads > 1u )
+        {
+            IntersectionSweepTask task( this );
+            mParentSceneMgr->executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            _sweepThread( 0u );
+        }
+
+        // Report from this thread, in the order of the sorted list
+        FastArray<ChunkResult> chunks;
+        for( size_t i = 0; i < numThreads; ++i )
+            chunks.appendPOD( mThreadChunks[i].begin(), mThreadChunks[i].end() );
+        std::sort( chunks.begin(), chunks.end() );
+
+        FastArray<ChunkResult>::const_iterator itChunk = chunks.begin();
+        FastArray<ChunkResult>::const_iterator enChunk = chunks.end();
+        while( itChunk != enChunk )
+        {
+            const FastArray<MovableObject *> &pairs = mThreadPairs[itChunk->threadIdx];
+            for( size_t i = itChunk->start; i < itChunk->end; i += 2u )
+            {
+                if( !listener->queryResult( pairs[i], pairs[i + 1u] ) )
+                    return;
+            }
+            ++itChunk;
         }
-#endif
     }
     //---------------------------------------------------------------------
     DefaultAxisAlignedBoxSceneQuery::DefaultAxisAlignedBoxSceneQuery( SceneManager *creator ) :
@@ -134,6 +466,9 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        const Aabb aabb = Aabb::newFromExtents( mAABB.getMinimum(), mAABB.getMaximum() );
+        FastArray<uint32> packs;
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
@@ -149,7 +484,19 @@ namespace Ogre
             {
                 ObjectData objData;
                 const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                keepIterating = execute( objData, totalObjs, listener );
+
+                const ObjectSpatialIndex *spatialIndex =
+                    mAABB.isFinite() ? memoryManager.getSpatialIndex( j ) : 0;
+                if( spatialIndex )
+                {
+                    packs.clear();
+                    spatialIndex->queryAabb( aabb, packs );
+                    keepIterating = executeOnPacks( this, objData, spatialIndex, packs, listener );
+                }
+                else
+                {
+                    keepIterating = execute( objData, totalObjs, listener );
+                }
             }
         }
     }
@@ -208,6 +555,253 @@ namespace Ogre
         return true;
     }
     //---------------------------------------------------------------------
+    const uint32 DefaultBatchRaySceneQuery::c_objectRejected = std::numeric_limits<uint32>::max();
+    const uint32 DefaultBatchRaySceneQuery::c_objectNoRefine = std::numeric_limits<uint32>::max() - 1u;
+    const size_t DefaultBatchRaySceneQuery::c_minRaysForThreads = 256u;
+    //---------------------------------------------------------------------
+    DefaultBatchRaySceneQuery::DefaultBatchRaySceneQuery( SceneManager *creator ) :
+        BatchRaySceneQuery( creator )
+    {
+        // No world geometry results supported
+        mSupportedWorldFragments.insert( SceneQuery::WFT_NONE );
+    }
+    //---------------------------------------------------------------------
+    DefaultBatchRaySceneQuery::~DefaultBatchRaySceneQuery() {}
+    //---------------------------------------------------------------------
+    void DefaultBatchRaySceneQuery::gatherRanges()
+    {
+        mRanges.clear();
+        mObjectStates.clear();
+        mRefineData.clear();
+
+        for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
+        {
+            ObjectMemoryManager &memoryManager =
+                mParentSceneMgr->_getEntityMemoryManager( static_cast<SceneMemoryMgrTypes>( i ) );
+
+            const size_t numRenderQueues = memoryManager.getNumRenderQueues();
+            const size_t firstRq = std::min<size_t>( mFirstRq, numRenderQueues );
+            const size_t lastRq = std::min<size_t>( mLastRq, numRenderQueues );
+
+            for( size_t j = firstRq; j < lastRq; ++j )
+            {
+                QueryRange range;
+                range.numObjects = memoryManager.getFirstObjectData( range.objData, j );
+                range.spatialIndex = memoryManager.getSpatialIndex( j );
+                range.firstSlot = mObjectStates.size();
+
+                if( !range.numObjects )
+                    continue;
+
+                mObjectStates.resizePOD( range.firstSlot + range.numObjects, c_objectRejected );
+
+                const ObjectData &objData = range.objData;
+                for( size_t k = 0; k < range.numObjects; ++k )
+                {
+                    MovableObject *owner = objData.mOwner[k];
+                    if( !owner || !( objData.mQueryFlags[k] & mQueryMask ) ||
+                        !( objData.mVisibilityFlags[k] & VisibilityFlags::LAYER_VISIBILITY ) )
+                    {
+                        continue;
+                    }
+
+                    uint32 state = c_objectNoRefine;
+
+                    // Animated Items are reported at their bounding box, like other objects
+                    Item *item = mTriangleLevel ? dynamic_cast<Item *>( owner ) : 0;
+                    if( item && item->getParentNode() && !hasAnimatedVertices( item ) )
+                    {
+                        // Builds the BVH the first time the Mesh is queried
+                        Mesh *mesh = item->getMesh().get();
+                        const TriangleBvh *bvh = mesh->_getTriangleBvh();
+                        if( !bvh->isEmpty() )
+                        {
+                            RefineData refineData;
+                            refineData.invWorld =
+                                item->getParentNode()->_getFullTransform().inverseAffine();
+                            refineData.bvh = bvh;
+                            refineData.mesh = mesh;
+                            state = static_cast<uint32>( mRefineData.size() );
+                            mRefineData.push_back( refineData );
+                        }
+                    }
+
+                    mObjectStates[range.firstSlot + k] = state;
+                }
+
+                mRanges.push_back( range );
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultBatchRaySceneQuery::hitObject( const QueryRange &range, size_t objectIdx,
+                                               uint32 rayMask, const Real *tMin, const Ray *rays,
+                                               BatchRaySceneQueryResult *results, Real *best )
+    {
+        const uint32 state = mObjectStates[range.firstSlot + objectIdx];
+        if( state == c_objectRejected )
+            return;
+
+        MovableObject *owner = range.objData.mOwner[objectIdx];
+
+        for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+        {
+            if( !IS_BIT_SET( i, rayMask ) || tMin[i] >= best[i] )
+                continue;
+
+            if( state == c_objectNoRefine )
+            {
+                best[i] = tMin[i];
+                results[i].movable = owner;
+                results[i].distance = tMin[i];
+                results[i].subMeshIdx = std::numeric_limits<uint32>::max();
+                results[i].triangleIdx = std::numeric_limits<uint32>::max();
+            }
+            else
+            {
+                // Transform the ray to mesh space. Its direction is not normalised
+                // so that distances along both rays are the same
+                const RefineData &refineData = mRefineData[state];
+                const Ray localRay( refineData.invWorld.transformAffine( rays[i].getOrigin() ),
+                                    refineData.invWorld.transformDirectionAffine(
+                                        rays[i].getDirection() ) );
+
+                TriangleBvh::Hit hit;
+                if( refineData.bvh->intersects( localRay, best[i], hit ) )
+                {
+                    best[i] = hit.distance;
+                    results[i].movable = owner;
+                    results[i].distance = hit.distance;
+                    refineData.mesh->_getTriangleBvhSubMesh( hit.triangleIdx, results[i].subMeshIdx,
+                                                             results[i].triangleIdx );
+                }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultBatchRaySceneQuery::castPacket( size_t firstRay, size_t numRays )
+    {
+        const Ray *rays = mRays.begin() + firstRay;
+        BatchRaySceneQueryResult *results = mResults.begin() + firstRay;
+
+        ArrayVector3 origin, invDir;
+        origin.setAll( Vector3::ZERO );
+        invDir.setAll( Vector3::UNIT_SCALE );
+
+        OGRE_ALIGNED_DECL( Real, best[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+        OGRE_ALIGNED_DECL( Real, tMin[ARRAY_PACKED_REALS], OGRE_SIMD_ALIGNMENT );
+
+        for( size_t i = 0; i < ARRAY_PACKED_REALS; ++i )
+        {
+            if( i < numRays )
+            {
+                origin.setFromVector3( rays[i].getOrigin(), i );
+                invDir.setFromVector3( rays[i].getInvDirection(), i );
+                best[i] = mMaxDistance;
+
+                results[i].movable = 0;
+                results[i].distance = mMaxDistance;
+                results[i].subMeshIdx = std::numeric_limits<uint32>::max();
+                results[i].triangleIdx = std::numeric_limits<uint32>::max();
+            }
+            else
+            {
+                // Unused lanes never hit anything
+                best[i] = -1.0f;
+            }
+        }
+
+        FastArray<QueryRange>::const_iterator itor = mRanges.begin();
+        FastArray<QueryRange>::const_iterator endt = mRanges.end();
+
+        while( itor != endt )
+        {
+            const QueryRange &range = *itor;
+
+            if( range.spatialIndex )
+            {
+                // Stackless traversal. Leaves' boxes are the objects' world Aabbs
+                const FastArray<ObjectSpatialIndex::Node> &nodes = range.spatialIndex->getNodes();
+                const size_t numNodes = nodes.size();
+                size_t i = 0;
+                while( i < numNodes )
+                {
+                    const ObjectSpatialIndex::Node &node = nodes[i];
+                    const uint32 rayMask =
+                        intersectsPacket( origin, invDir, node.vMin, node.vMax, best, tMin );
+                    if( !rayMask )
+                    {
+                        i = node.skipIdx;
+                    }
+                    else
+                    {
+                        if( node.objectIdx != ObjectSpatialIndex::c_innerNode )
+                            hitObject( range, node.objectIdx, rayMask, tMin, rays, results, best );
+                        ++i;
+                    }
+                }
+            }
+            else
+            {
+                const uint32 *objectStates = mObjectStates.begin() + range.firstSlot;
+                for( size_t i = 0; i < range.numObjects; ++i )
+                {
+                    if( objectStates[i] == c_objectRejected )
+                        continue;
+
+                    Aabb aabb;
+                    range.objData.mWorldAabb[i / ARRAY_PACKED_REALS].getAsAabb(
+                        aabb, i % ARRAY_PACKED_REALS );
+                    const uint32 rayMask = intersectsPacket( origin, invDir, aabb.getMinimum(),
+                                                             aabb.getMaximum(), best, tMin );
+                    if( rayMask )
+                        hitObject( range, i, rayMask, tMin, rays, results, best );
+                }
+            }
+
+            ++itor;
+        }
+    }
+    //---------------------------------------------------------------------
+    void DefaultBatchRaySceneQuery::_castRaysThread( size_t threadIdx )
+    {
+        size_t start, count;
+        while( mWorkRange.acquire( threadIdx, start, count ) )
+        {
+            for( size_t i = start; i < start + count; i += ARRAY_PACKED_REALS )
+                castPacket( i, std::min<size_t>( ARRAY_PACKED_REALS, start + count - i ) );
+        }
+    }
+    //---------------------------------------------------------------------
+    const BatchRaySceneQueryResultArray &DefaultBatchRaySceneQuery::execute()
+    {
+        assert( mFirstRq < mLastRq && "This query will never hit any result!" );
+
+        const size_t numRays = mRays.size();
+        mResults.resizePOD( numRays );
+        if( !numRays )
+            return mResults;
+
+        gatherRanges();
+
+        const size_t numThreads = numRays >= c_minRaysForThreads
+                                      ? std::max<size_t>( mParentSceneMgr->getNumWorkerThreads(), 1u )
+                                      : 1u;
+
+        mWorkRange.reset( numRays, numThreads, ARRAY_PACKED_REALS );
+        if( numThreads > 1u )
+        {
+            BatchRayCastTask task( this );
+            mParentSceneMgr->executeUserScalableTask( &task, true );
+        }
+        else
+        {
+            _castRaysThread( 0u );
+        }
+
+        return mResults;
+    }
+    //---------------------------------------------------------------------
     DefaultRaySceneQuery::DefaultRaySceneQuery( SceneManager *creator ) : RaySceneQuery( creator )
     {
         // No world geometry results supported
@@ -220,6 +814,8 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        FastArray<uint32> packs;
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
@@ -235,7 +831,18 @@ namespace Ogre
             {
                 ObjectData objData;
                 const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                keepIterating = execute( objData, totalObjs, listener );
+
+                const ObjectSpatialIndex *spatialIndex = memoryManager.getSpatialIndex( j );
+                if( spatialIndex )
+                {
+                    packs.clear();
+                    spatialIndex->queryRay( mRay, packs );
+                    keepIterating = executeOnPacks( this, objData, spatialIndex, packs, listener );
+                }
+                else
+                {
+                    keepIterating = execute( objData, totalObjs, listener );
+                }
             }
         }
     }
@@ -363,6 +970,8 @@ namespace Ogre
     {
         assert( mFirstRq < mLastRq && "This query will never hit any result!" );
 
+        FastArray<uint32> packs;
+
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
             ObjectMemoryManager &memoryManager =
@@ -378,7 +987,18 @@ namespace Ogre
             {
                 ObjectData objData;
                 const size_t totalObjs = memoryManager.getFirstObjectData( objData, j );
-                keepIterating = execute( objData, totalObjs, listener );
+
+                const ObjectSpatialIndex *spatialIndex = memoryManager.getSpatialIndex( j );
+                if( spatialIndex )
+                {
+                    packs.clear();
+                    spatialIndex->querySphere( mSphere, packs );
+                    keepIterating = executeOnPacks( this, objData, spatialIndex, packs, listener );
+                }
+                else
+                {
+                    keepIterating = execute( objData, totalObjs, listener );
+                }
             }
         }
     }
@@ -64,6 +64,8 @@ THE SOFTWARE.
 namespace Ogre
 {
     bool FileSystemArchive::msIgnoreHidden = true;
+    bool FileSystemArchive::msMemoryMapFiles = false;
+    size_t FileSystemArchive::msMemoryMapMinSize = 64u * 1024u;
 
     //-----------------------------------------------------------------------
     FileSystemArchive::FileSystemArchive( const String &name, const String &archType, bool readOnly ) :
@@ -329,6 +331,20 @@ namespace Ogre
                          "FileSystemArchive::open" );
         }
 
+#ifndef _OGRE_FILESYSTEM_ARCHIVE_UNICODE
+        if( readOnly && msMemoryMapFiles && (size_t)tagStat.st_size >= msMemoryMapMinSize )
+        {
+            try
+            {
+                return DataStreamPtr( OGRE_NEW MappedFileDataStream( filename, full_path ) );
+            }
+            catch( Exception & )
+            {
+                // Not mappable (or not supported on this platform). Use std::ifstream instead
+            }
+        }
+#endif
+
         if( !readOnly )
         {
             mode |= std::ios::out;
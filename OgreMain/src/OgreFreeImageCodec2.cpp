@@ -459,11 +459,15 @@ namespace Ogre
     //---------------------------------------------------------------------
     Codec::DecodeResult FreeImageCodec2::decode( DataStreamPtr &input ) const
     {
-        // Buffer stream into memory (TODO: override IO functions instead?)
-        MemoryDataStream memStream( input, true );
+        // Buffer stream into memory unless it's already there (TODO: override IO functions instead?)
+        DataStreamPtr memStream = input;
+        if( !input->getDataPtr() )
+            memStream.reset( OGRE_NEW MemoryDataStream( input, true ) );
+        const size_t offset = memStream->tell();
 
         FIMEMORY *fiMem =
-            FreeImage_OpenMemory( memStream.getPtr(), static_cast<uint32_t>( memStream.size() ) );
+            FreeImage_OpenMemory( const_cast<uint8 *>( memStream->getDataPtr() + offset ),
+                                  static_cast<uint32_t>( memStream->size() - offset ) );
         FIBITMAP *fiBitmap = FreeImage_LoadFromMemory( (FREE_IMAGE_FORMAT)mFreeImageType, fiMem );
         if( !fiBitmap )
         {
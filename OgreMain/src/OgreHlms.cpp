@@ -39,6 +39,7 @@ THE SOFTWARE.
 #include "OgreForward3D.h"
 #include "OgreHighLevelGpuProgram.h"
 #include "OgreHighLevelGpuProgramManager.h"
+#include "OgreHlmsCompiledTemplate.h"
 #include "OgreHlmsListener.h"
 #include "OgreHlmsManager.h"
 #include "OgreLight.h"
@@ -2092,8 +2093,10 @@ namespace Ogre
         while( itor != endt )
         {
             mRenderSystem->_hlmsPipelineStateObjectDestroyed( &( *itor )->pso );
-            if( ( *itor )->pso.pass.hasStrongMacroblock() )
+            if( ( *itor )->pso.pass.hasStrongMacroblock() || ( *itor )->ownsBlocks )
                 mHlmsManager->destroyMacroblock( ( *itor )->pso.macroblock );
+            if( ( *itor )->ownsBlocks )
+                mHlmsManager->destroyBlendblock( ( *itor )->pso.blendblock );
 
             delete *itor;
             ++itor;
@@ -2102,8 +2105,13 @@ namespace Ogre
         shaderCache.clear();
 
         mShaderCodeCache.clear();
+        mPregeneratedShaderCode.clear();
+        mPregeneratedMerges.clear();
         mShadersGenerated = 0u;
         mShaderCodeCacheDirty = true;
+
+        // Templates may have changed on disk (or the RenderSystem, thus the files we use)
+        clearCompiledTemplates();
     }
     //-----------------------------------------------------------------------------------
     void Hlms::processPieces( Archive *archive, const StringVector &pieceFiles, const size_t tid )
@@ -2118,21 +2126,12 @@ namespace Ogre
             const String::size_type extPos1 = itor->find( ".any" );
             if( extPos0 == itor->size() - mShaderFileExt.size() || extPos1 == itor->size() - 4u )
             {
-                DataStreamPtr inFile = archive->open( *itor );
-
                 String inString;
                 String outString;
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
-
-                this->parseMath( inString, outString, tid );
-                while( outString.find( "@foreach" ) != String::npos )
-                {
-                    this->parseForEach( outString, inString, tid );
-                    inString.swap( outString );
-                }
-                this->parseProperties( outString, inString, tid );
+                // Piece files never stopped on syntax errors; errors in them are
+                // reported when the template that uses them gets parsed
+                this->parseTemplate( archive, *itor, inString, outString, tid, false );
                 this->parseUndefPieces( inString, outString, tid );
                 this->collectPieces( outString, inString, tid );
                 this->parseCounter( inString, outString, tid );
@@ -2141,6 +2140,80 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    const HlmsCompiledTemplate *Hlms::getCompiledTemplate( Archive *archive, const String &filename )
+    {
+        ScopedLock lock( mCompiledTemplatesMutex );
+
+        const CompiledTemplateKey key( archive, filename );
+        CompiledTemplateMap::iterator itor = mCompiledTemplates.find( key );
+        if( itor == mCompiledTemplates.end() )
+        {
+            DataStreamPtr inFile = archive->open( filename );
+
+            String source;
+            source.resize( inFile->size() );
+            if( !source.empty() )
+                inFile->read( &source[0], inFile->size() );
+
+            HlmsCompiledTemplate *compiledTemplate = OGRE_NEW HlmsCompiledTemplate();
+            if( !compiledTemplate->compile( source ) )
+            {
+                LogManager::getSingleton().logMessage(
+                    "HLMS: '" + filename +
+                        "' uses constructs that cannot be precompiled. Falling back to slower "
+                        "string parsing for this file.",
+                    LML_TRIVIAL );
+            }
+
+            itor = mCompiledTemplates.insert( std::make_pair( key, compiledTemplate ) ).first;
+        }
+
+        return itor->second;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::clearCompiledTemplates()
+    {
+        ScopedLock lock( mCompiledTemplatesMutex );
+
+        CompiledTemplateMap::const_iterator itor = mCompiledTemplates.begin();
+        CompiledTemplateMap::const_iterator endt = mCompiledTemplates.end();
+
+        while( itor != endt )
+        {
+            OGRE_DELETE itor->second;
+            ++itor;
+        }
+
+        mCompiledTemplates.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::parseTemplate( Archive *archive, const String &filename, String &inString,
+                              String &outString, const size_t tid, const bool stopOnSyntaxError )
+    {
+        const HlmsCompiledTemplate *compiledTemplate = getCompiledTemplate( archive, filename );
+
+        if( compiledTemplate->isCompiled() )
+        {
+            return compiledTemplate->evaluate( mT[tid].setProperties, mT[tid].propertyMap,
+                                               inString );
+        }
+
+        inString = compiledTemplate->getSource();
+
+        bool syntaxError = false;
+
+        syntaxError |= this->parseMath( inString, outString, tid );
+        while( ( !syntaxError || !stopOnSyntaxError ) &&
+               outString.find( "@foreach" ) != String::npos )
+        {
+            syntaxError |= this->parseForEach( outString, inString, tid );
+            inString.swap( outString );
+        }
+        syntaxError |= this->parseProperties( outString, inString, tid );
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
     void Hlms::dumpProperties( std::ofstream &outFile, const size_t tid )
     {
         outFile.write( "#if 0", sizeof( "#if 0" ) - 1u );
@@ -2285,7 +2358,8 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void Hlms::_compileShaderFromPreprocessedSource( const RenderableCache &mergedCache,
                                                      const String source[NumShaderTypes],
-                                                     const uint32 shaderCounter, const size_t tid )
+                                                     const uint32 shaderCounter, const size_t tid,
+                                                     GpuProgramPtr *outShaders )
     {
         OgreProfileExhaustive( "Hlms::_compileShaderFromPreprocessedSource" );
 
@@ -2329,171 +2403,322 @@ namespace Ogre
         // Ensure code didn't accidentally modify mSetProperties
         OGRE_ASSERT_HIGH( codeCache.mergedCache.setProperties == mergedCache.setProperties );
 
+        if( outShaders )
+        {
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+                outShaders[i] = codeCache.shaders[i];
+        }
+
         ScopedLock lock( mMutex );
         mShaderCodeCache.push_back( codeCache );
         mShaderCodeCacheDirty = true;
     }
     //-----------------------------------------------------------------------------------
-    void Hlms::compileShaderCode( ShaderCodeCache &codeCache, const uint32 shaderCounter,
-                                  const size_t tid )
+    bool Hlms::generateShaderStage( const RenderableCache &mergedCache, const ShaderType shaderType,
+                                    const uint32 uniqueName, const bool bDebugOutput, const size_t tid,
+                                    String &outString, String &outDebugFilename )
     {
-        OgreProfileExhaustive( "Hlms::compileShaderCode" );
-
-        // Give the shaders friendly base-10 names
-        const uint32 uniqueName = mType * 100000000u + shaderCounter;
+        const size_t i = shaderType;
 
-        mT[tid].setProperties = codeCache.mergedCache.setProperties;
+        // Collect pieces
+        mT[tid].pieces = mergedCache.pieces[i];
 
-        // Generate the shaders
-        for( size_t i = 0; i < NumShaderTypes; ++i )
-        {
-            // Collect pieces
-            mT[tid].pieces = codeCache.mergedCache.pieces[i];
+        const String filename = ShaderFiles[i] + mShaderFileExt;
+        if( !mDataFolder->exists( filename ) )
+            return false;
 
-            const String filename = ShaderFiles[i] + mShaderFileExt;
-            if( mDataFolder->exists( filename ) )
-            {
-                if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
-                {
-                    setProperty( tid, HlmsBaseProp::GL3Plus,
-                                 mRenderSystem->getNativeShadingLanguageVersion() );
-                }
+        if( mShaderProfile == "glsl" || mShaderProfile == "glslvk" )  // TODO: String comparision
+            setProperty( tid, HlmsBaseProp::GL3Plus, mRenderSystem->getNativeShadingLanguageVersion() );
 
-                setProperty( tid, HlmsBaseProp::Syntax,
-                             static_cast<int32>( mShaderSyntax.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Hlsl,
-                             static_cast<int32>( HlmsBaseProp::Hlsl.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Glsl,
-                             static_cast<int32>( HlmsBaseProp::Glsl.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Glslvk,
-                             static_cast<int32>( HlmsBaseProp::Glslvk.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Hlslvk,
-                             static_cast<int32>( HlmsBaseProp::Hlslvk.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Metal,
-                             static_cast<int32>( HlmsBaseProp::Metal.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Syntax, static_cast<int32>( mShaderSyntax.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Hlsl, static_cast<int32>( HlmsBaseProp::Hlsl.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Glsl, static_cast<int32>( HlmsBaseProp::Glsl.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Glslvk,
+                     static_cast<int32>( HlmsBaseProp::Glslvk.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Hlslvk,
+                     static_cast<int32>( HlmsBaseProp::Hlslvk.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Metal, static_cast<int32>( HlmsBaseProp::Metal.getU32Value() ) );
 
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE_IOS
-                setProperty( tid, HlmsBaseProp::iOS, 1 );
+        setProperty( tid, HlmsBaseProp::iOS, 1 );
 #endif
 #if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
-                setProperty( tid, HlmsBaseProp::macOS, 1 );
+        setProperty( tid, HlmsBaseProp::macOS, 1 );
 #endif
-                setProperty( tid, HlmsBaseProp::Full32,
-                             static_cast<int32>( HlmsBaseProp::Full32.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Midf16,
-                             static_cast<int32>( HlmsBaseProp::Midf16.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::Relaxed,
-                             static_cast<int32>( HlmsBaseProp::Relaxed.getU32Value() ) );
-                setProperty( tid, HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
+        setProperty( tid, HlmsBaseProp::Full32,
+                     static_cast<int32>( HlmsBaseProp::Full32.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Midf16,
+                     static_cast<int32>( HlmsBaseProp::Midf16.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::Relaxed,
+                     static_cast<int32>( HlmsBaseProp::Relaxed.getU32Value() ) );
+        setProperty( tid, HlmsBaseProp::PrecisionMode, getSupportedPrecisionModeHash() );
 
-                if( mFastShaderBuildHack )
-                    setProperty( tid, HlmsBaseProp::FastShaderBuildHack, 1 );
+        if( mFastShaderBuildHack )
+            setProperty( tid, HlmsBaseProp::FastShaderBuildHack, 1 );
 
-                String debugFilenameOutput;
-                std::ofstream debugDumpFile;
-                if( mDebugOutput )
-                {
-                    debugFilenameOutput = mOutputPath + "./" + StringConverter::toString( uniqueName ) +
-                                          ShaderFiles[i] + mShaderFileExt;
-                    debugDumpFile.open( Ogre::fileSystemPathFromString( debugFilenameOutput ).c_str(),
-                                        std::ios::out | std::ios::binary );
+        std::ofstream debugDumpFile;
+        if( bDebugOutput )
+        {
+            outDebugFilename = mOutputPath + "./" + StringConverter::toString( uniqueName ) +
+                               ShaderFiles[i] + mShaderFileExt;
+            debugDumpFile.open( Ogre::fileSystemPathFromString( outDebugFilename ).c_str(),
+                                std::ios::out | std::ios::binary );
+
+            // We need to dump the properties before processing the files, as these
+            // may be overwritten or polluted by the files, thus hiding why we
+            // got this permutation.
+            if( mDebugOutputProperties )
+                dumpProperties( debugDumpFile, tid );
+        }
 
-                    // We need to dump the properties before processing the files, as these
-                    // may be overwritten or polluted by the files, thus hiding why we
-                    // got this permutation.
-                    if( mDebugOutputProperties )
-                        dumpProperties( debugDumpFile, tid );
-                }
+        const int32 customPieceName =
+            getProperty( tid, HlmsBaseProp::_DatablockCustomPieceShaderName[i] );
+        if( customPieceName )
+        {
+            // Parse custom arbitrary shader piece specified by the datablock.
+            DatablockCustomPieceFileMap::const_iterator it =
+                mDatablockCustomPieceFiles.find( customPieceName );
+            OGRE_ASSERT_LOW( it != mDatablockCustomPieceFiles.end() );
 
-                const int32 customPieceName =
-                    getProperty( tid, HlmsBaseProp::_DatablockCustomPieceShaderName[i] );
-                if( customPieceName )
-                {
-                    // Parse custom arbitrary shader piece specified by the datablock.
-                    DatablockCustomPieceFileMap::const_iterator it =
-                        mDatablockCustomPieceFiles.find( customPieceName );
-                    OGRE_ASSERT_LOW( it != mDatablockCustomPieceFiles.end() );
+            String pieceInString = it->second.sourceCode;
+            String pieceOutString;
 
-                    String inString = it->second.sourceCode;
-                    String outString;
+            this->parseMath( pieceInString, pieceOutString, tid );
+            while( pieceOutString.find( "@foreach" ) != String::npos )
+            {
+                this->parseForEach( pieceOutString, pieceInString, tid );
+                pieceInString.swap( pieceOutString );
+            }
+            this->parseProperties( pieceOutString, pieceInString, tid );
+            this->parseUndefPieces( pieceInString, pieceOutString, tid );
+            this->collectPieces( pieceOutString, pieceInString, tid );
+            this->parseCounter( pieceInString, pieceOutString, tid );
+        }
 
-                    this->parseMath( inString, outString, tid );
-                    while( outString.find( "@foreach" ) != String::npos )
-                    {
-                        this->parseForEach( outString, inString, tid );
-                        inString.swap( outString );
-                    }
-                    this->parseProperties( outString, inString, tid );
-                    this->parseUndefPieces( inString, outString, tid );
-                    this->collectPieces( outString, inString, tid );
-                    this->parseCounter( inString, outString, tid );
-                }
+        // Library piece files first
+        LibraryVec::const_iterator itor = mLibrary.begin();
+        LibraryVec::const_iterator endt = mLibrary.end();
 
-                // Library piece files first
-                LibraryVec::const_iterator itor = mLibrary.begin();
-                LibraryVec::const_iterator endt = mLibrary.end();
+        while( itor != endt )
+        {
+            processPieces( itor->dataFolder, itor->pieceFiles[i], tid );
+            ++itor;
+        }
 
-                while( itor != endt )
-                {
-                    processPieces( itor->dataFolder, itor->pieceFiles[i], tid );
-                    ++itor;
-                }
+        // Main piece files
+        processPieces( mDataFolder, mPieceFiles[i], tid );
 
-                // Main piece files
-                processPieces( mDataFolder, mPieceFiles[i], tid );
+        // Generate the shader file.
+        String inString;
+        outString.clear();
 
-                // Generate the shader file.
-                DataStreamPtr inFile = mDataFolder->open( filename );
+        bool syntaxError = false;
 
-                String inString;
-                String outString;
+        syntaxError |= this->parseTemplate( mDataFolder, filename, inString, outString, tid, true );
+        syntaxError |= this->parseUndefPieces( inString, outString, tid );
+        while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
+                                 outString.find( "@insertpiece" ) != String::npos ) )
+        {
+            syntaxError |= this->collectPieces( outString, inString, tid );
+            syntaxError |= this->insertPieces( inString, outString, tid );
+        }
+        syntaxError |= this->parseCounter( outString, inString, tid );
 
-                inString.resize( inFile->size() );
-                inFile->read( &inString[0], inFile->size() );
+        outString.swap( inString );
 
-                bool syntaxError = false;
+        if( syntaxError )
+        {
+            LogManager::getSingleton().logMessage( "There were HLMS syntax errors while parsing " +
+                                                   StringConverter::toString( uniqueName ) +
+                                                   ShaderFiles[i] );
+        }
 
-                syntaxError |= this->parseMath( inString, outString, tid );
-                while( !syntaxError && outString.find( "@foreach" ) != String::npos )
-                {
-                    syntaxError |= this->parseForEach( outString, inString, tid );
-                    inString.swap( outString );
-                }
-                syntaxError |= this->parseProperties( outString, inString, tid );
-                syntaxError |= this->parseUndefPieces( inString, outString, tid );
-                while( !syntaxError && ( outString.find( "@piece" ) != String::npos ||
-                                         outString.find( "@insertpiece" ) != String::npos ) )
-                {
-                    syntaxError |= this->collectPieces( outString, inString, tid );
-                    syntaxError |= this->insertPieces( inString, outString, tid );
-                }
-                syntaxError |= this->parseCounter( outString, inString, tid );
+        // Now dump the processed file.
+        if( bDebugOutput )
+            debugDumpFile.write( &outString[0], static_cast<std::streamsize>( outString.size() ) );
 
-                outString.swap( inString );
+        // Don't create and compile if template requested not to
+        const bool bStageEnabled = !getProperty( tid, HlmsBaseProp::DisableStage );
 
-                if( syntaxError )
-                {
-                    LogManager::getSingleton().logMessage(
-                        "There were HLMS syntax errors while parsing " +
-                        StringConverter::toString( uniqueName ) + ShaderFiles[i] );
-                }
+        // Reset the disable flag.
+        setProperty( tid, HlmsBaseProp::DisableStage, 0 );
+
+        return bStageEnabled;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_generateShaderCode( const RenderableCache &mergedCache, const size_t tid,
+                                    String outSource[NumShaderTypes] )
+    {
+        OgreProfileExhaustive( "Hlms::_generateShaderCode" );
+
+        mT[tid].setProperties = mergedCache.setProperties;
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            String debugFilenameOutput;
+            if( !generateShaderStage( mergedCache, static_cast<ShaderType>( i ), 0u, false, tid,
+                                      outSource[i], debugFilenameOutput ) )
+            {
+                outSource[i].clear();
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_pregenerateStubEntry( const HlmsCache &passCache, const HlmsCache *reservedStubEntry,
+                                      const QueuedRenderable &queuedRenderable,
+                                      const uint32 renderableHash, const size_t tid )
+    {
+        OgreProfileExhaustive( "Hlms::_pregenerateStubEntry" );
+
+        // Same as createShaderCacheEntry
+        const RenderableCache &renderableCache =
+            mergePropertiesForShaderCode( renderableHash, passCache, queuedRenderable, tid );
+
+        {
+            // Keep the merge so compileStubEntry doesn't have to do it again
+            PregeneratedMerge merge;
+            merge.setProperties = mT[tid].setProperties;
+            merge.textureNameStrings = mT[tid].textureNameStrings;
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+                merge.textureRegs[i] = mT[tid].textureRegs[i];
+
+            ScopedLock lock( mMutex );
+            std::swap( mPregeneratedMerges[reservedStubEntry], merge );
+        }
+
+        ShaderCodeCache codeCache( renderableCache.pieces );
+        unsetProperty( tid, HlmsPsoProp::Macroblock );
+        unsetProperty( tid, HlmsPsoProp::Blendblock );
+        unsetProperty( tid, HlmsPsoProp::InputLayoutId );
+        codeCache.mergedCache.setProperties.swap( mT[tid].setProperties );
+
+        size_t entryIdx;
+        {
+            ScopedLock lock( mMutex );
+            if( std::find( mShaderCodeCache.begin(), mShaderCodeCache.end(), codeCache ) !=
+                mShaderCodeCache.end() )
+            {
+                return;  // Already compiled
+            }
+
+            for( const PregeneratedShaderCode &pregenerated : mPregeneratedShaderCode )
+            {
+                if( pregenerated.mergedCache == codeCache.mergedCache )
+                    return;  // Another thread is (or was) on it
+            }
+
+            // Reserve the slot now so that no other thread generates the same permutation
+            entryIdx = mPregeneratedShaderCode.size();
+            mPregeneratedShaderCode.push_back( PregeneratedShaderCode( codeCache.mergedCache ) );
+        }
+
+        PregeneratedShaderCode entry( codeCache.mergedCache );
+
+        mT[tid].setProperties = codeCache.mergedCache.setProperties;
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            String debugFilenameOutput;
+            if( generateShaderStage( entry.mergedCache, static_cast<ShaderType>( i ), 0u, false, tid,
+                                     entry.source[i], debugFilenameOutput ) )
+            {
+                entry.stageProperties[i] = mT[tid].setProperties;
+            }
+            else
+            {
+                entry.source[i].clear();
+            }
+        }
+
+        entry.properties.swap( mT[tid].setProperties );
+        entry.ready = true;
+
+        ScopedLock lock( mMutex );
+        std::swap( mPregeneratedShaderCode[entryIdx], entry );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Hlms::compilePregeneratedShaderCode( ShaderCodeCache &codeCache, const uint32 uniqueName,
+                                              const size_t tid )
+    {
+        PregeneratedShaderCode entry( codeCache.mergedCache );
+        {
+            ScopedLock lock( mMutex );
+            PregeneratedShaderCodeVec::iterator itor = mPregeneratedShaderCode.begin();
+            PregeneratedShaderCodeVec::iterator endt = mPregeneratedShaderCode.end();
 
-                // Now dump the processed file.
+            while( itor != endt && !( itor->ready && itor->mergedCache == codeCache.mergedCache ) )
+                ++itor;
+
+            if( itor == endt )
+                return false;
+
+            // Leave it there (but not ready) so that nobody generates it again
+            std::swap( *itor, entry );
+        }
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            if( !entry.source[i].empty() )
+            {
+                // Restore the properties the template left when this stage was generated
+                mT[tid].setProperties.swap( entry.stageProperties[i] );
+
+                String debugFilenameOutput;
                 if( mDebugOutput )
                 {
-                    debugDumpFile.write( &outString[0],
-                                         static_cast<std::streamsize>( outString.size() ) );
+                    debugFilenameOutput = mOutputPath + "./" +
+                                          StringConverter::toString( uniqueName ) + ShaderFiles[i] +
+                                          mShaderFileExt;
+                    std::ofstream debugDumpFile(
+                        Ogre::fileSystemPathFromString( debugFilenameOutput ).c_str(),
+                        std::ios::out | std::ios::binary );
+                    if( mDebugOutputProperties )
+                        dumpProperties( debugDumpFile, tid );
+                    debugDumpFile.write( entry.source[i].c_str(),
+                                         static_cast<std::streamsize>( entry.source[i].size() ) );
                 }
 
-                // Don't create and compile if template requested not to
-                if( !getProperty( tid, HlmsBaseProp::DisableStage ) )
+                codeCache.shaders[i] =
+                    compileShaderCode( entry.source[i], debugFilenameOutput, uniqueName,
+                                       static_cast<ShaderType>( i ), tid );
+            }
+        }
+
+        mT[tid].setProperties.swap( entry.properties );
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::_clearPregeneratedShaderCode()
+    {
+        ScopedLock lock( mMutex );
+        mPregeneratedShaderCode.clear();
+        mPregeneratedMerges.clear();
+    }
+    //-----------------------------------------------------------------------------------
+    void Hlms::compileShaderCode( ShaderCodeCache &codeCache, const uint32 shaderCounter,
+                                  const size_t tid )
+    {
+        OgreProfileExhaustive( "Hlms::compileShaderCode" );
+
+        // Give the shaders friendly base-10 names
+        const uint32 uniqueName = mType * 100000000u + shaderCounter;
+
+        mT[tid].setProperties = codeCache.mergedCache.setProperties;
+
+        if( !compilePregeneratedShaderCode( codeCache, uniqueName, tid ) )
+        {
+            // Generate the shaders
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+            {
+                String source;
+                String debugFilenameOutput;
+                if( generateShaderStage( codeCache.mergedCache, static_cast<ShaderType>( i ),
+                                         uniqueName, mDebugOutput, tid, source, debugFilenameOutput ) )
                 {
-                    codeCache.shaders[i] = compileShaderCode( outString, debugFilenameOutput, uniqueName,
-                                                              static_cast<ShaderType>( i ), tid );
+                    codeCache.shaders[i] = compileShaderCode(
+                        source, debugFilenameOutput, uniqueName, static_cast<ShaderType>( i ), tid );
                 }
-
-                // Reset the disable flag.
-                setProperty( tid, HlmsBaseProp::DisableStage, 0 );
             }
         }
 
@@ -2502,13 +2727,10 @@ namespace Ogre
         mShaderCodeCacheDirty = true;
     }
     //-----------------------------------------------------------------------------------
-    const HlmsCache *Hlms::createShaderCacheEntry( uint32 renderableHash, const HlmsCache &passCache,
-                                                   uint32 finalHash,
-                                                   const QueuedRenderable &queuedRenderable,
-                                                   HlmsCache *reservedStubEntry, const size_t tid )
+    const Hlms::RenderableCache &Hlms::mergePropertiesForShaderCode(
+        uint32 renderableHash, const HlmsCache &passCache, const QueuedRenderable &queuedRenderable,
+        const size_t tid )
     {
-        OgreProfileExhaustive( "Hlms::createShaderCacheEntry" );
-
         // Set the properties by merging the cache from the pass, with the cache from renderable
         mT[tid].setProperties.clear();
         // If retVal is null, we did something wrong earlier
@@ -2549,8 +2771,49 @@ namespace Ogre
                                                       renderableCache.pieces, mT[tid].setProperties,
                                                       queuedRenderable, tid );
 
+        return renderableCache;
+    }
+    //-----------------------------------------------------------------------------------
+    const Hlms::RenderableCache *Hlms::restorePregeneratedMerge( uint32           renderableHash,
+                                                                 const HlmsCache *reservedStubEntry,
+                                                                 const size_t     tid )
+    {
+        PregeneratedMerge merge;
+        {
+            ScopedLock lock( mMutex );
+            PregeneratedMergeMap::iterator itor = mPregeneratedMerges.find( reservedStubEntry );
+            if( itor == mPregeneratedMerges.end() )
+                return 0;
+            std::swap( itor->second, merge );
+            mPregeneratedMerges.erase( itor );
+        }
+
+        mT[tid].setProperties.swap( merge.setProperties );
+        mT[tid].textureNameStrings.swap( merge.textureNameStrings );
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+            mT[tid].textureRegs[i].swap( merge.textureRegs[i] );
+
+        return &getRenderableCache( renderableHash );
+    }
+    //-----------------------------------------------------------------------------------
+    const HlmsCache *Hlms::createShaderCacheEntry( uint32 renderableHash, const HlmsCache &passCache,
+                                                   uint32 finalHash,
+                                                   const QueuedRenderable &queuedRenderable,
+                                                   HlmsCache *reservedStubEntry, const size_t tid )
+    {
+        OgreProfileExhaustive( "Hlms::createShaderCacheEntry" );
+
+        const RenderableCache *renderableCache = 0;
+        if( reservedStubEntry )
+            renderableCache = restorePregeneratedMerge( renderableHash, reservedStubEntry, tid );
+        if( !renderableCache )
+        {
+            renderableCache =
+                &mergePropertiesForShaderCode( renderableHash, passCache, queuedRenderable, tid );
+        }
+
         // Retrieve the shader code from the code cache
-        ShaderCodeCache codeCache( renderableCache.pieces );
+        ShaderCodeCache codeCache( renderableCache->pieces );
         unsetProperty( tid, HlmsPsoProp::Macroblock );
         unsetProperty( tid, HlmsPsoProp::Blendblock );
         unsetProperty( tid, HlmsPsoProp::InputLayoutId );
@@ -0,0 +1,832 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreHlmsCompiledTemplate.h"
+
+#include "OgreHlms.h"
+#include "OgreStringConverter.h"
+
+namespace Ogre
+{
+    // Must be kept in sync with c_operations in OgreHlms.cpp
+    static const char *c_mathOpNames[8] = { "pset", "padd", "psub", "pmul",
+                                            "pdiv", "pmod", "pmin", "pmax" };
+    // Keywords whose meaning would change if a @foreach counter were substituted into them
+    static const char *c_blockKeywords[5] = { "end", "else", "foreach", "property", "piece" };
+
+    static int32 executeMathOp( uint8 opIdx, int32 op1, int32 op2 )
+    {
+        switch( opIdx )
+        {
+        case 0:
+            return op2;
+        case 1:
+            return op1 + op2;
+        case 2:
+            return op1 - op2;
+        case 3:
+            return op1 * op2;
+        case 4:
+            return op1 / op2;
+        case 5:
+            return op1 % op2;
+        case 6:
+            return std::min( op1, op2 );
+        case 7:
+        default:
+            return std::max( op1, op2 );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsCompiledTemplate::Expression::swap( Expression &other )
+    {
+        std::swap( this->type, other.type );
+        std::swap( this->negated, other.negated );
+        std::swap( this->isDynamic, other.isDynamic );
+        std::swap( this->operand, other.operand );
+        std::swap( this->firstFragment, other.firstFragment );
+        std::swap( this->numFragments, other.numFragments );
+        this->children.swap( other.children );
+        this->value.swap( other.value );
+        std::swap( this->srcStart, other.srcStart );
+    }
+    //-----------------------------------------------------------------------------------
+    HlmsCompiledTemplate::HlmsCompiledTemplate() : mEstimatedOutputSize( 0 ), mCompiled( false ) {}
+    //-----------------------------------------------------------------------------------
+    void HlmsCompiledTemplate::parseOperand( const String &value, Operand &outOperand )
+    {
+        // Same as Hlms::parseForEach & Hlms::evaluateExpressionRecursive
+        char *endPtr;
+        outOperand.number = static_cast<int32>( strtol( value.c_str(), &endPtr, 10 ) );
+        outOperand.isProperty = value.c_str() == endPtr;
+        if( outOperand.isProperty )
+            outOperand.property = value;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsCompiledTemplate::parseMathOperand( const String &value, Operand &outOperand )
+    {
+        // Same as Hlms::interpretAsNumberThenAsProperty
+        outOperand.number = StringConverter::parseInt( value, -std::numeric_limits<int>::max() );
+        outOperand.isProperty = outOperand.number == -std::numeric_limits<int>::max();
+        if( outOperand.isProperty )
+            outOperand.property = value;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::compileMath( const String &source )
+    {
+        // Mirrors Hlms::parseMath, but records the operations instead of executing them.
+        mText.clear();
+        mText.reserve( source.size() );
+
+        StringVector argValues;
+        SubStringRef subString( &source, 0 );
+
+        bool syntaxError = false;
+
+        size_t pos = subString.find( "@" );
+        size_t keyword = std::numeric_limits<size_t>::max();
+
+        while( pos != String::npos && !syntaxError )
+        {
+            while( pos != String::npos && keyword == std::numeric_limits<size_t>::max() )
+            {
+                size_t maxSize = subString.findFirstOf( " \t(", pos + 1 );
+                maxSize = maxSize == String::npos ? subString.getSize() : maxSize;
+                SubStringRef keywordStr( &source, subString.getStart() + pos + 1,
+                                         subString.getStart() + maxSize );
+
+                for( size_t i = 0; i < 8 && keyword == std::numeric_limits<size_t>::max(); ++i )
+                {
+                    if( keywordStr.matchEqual( c_mathOpNames[i] ) )
+                        keyword = i;
+                }
+
+                if( keyword == std::numeric_limits<size_t>::max() )
+                    pos = subString.find( "@", pos + 1 );
+            }
+
+            if( pos == String::npos )
+                break;
+
+            mText.append( source, subString.getStart(), pos );
+
+            // sizeof( "@pset" ), sizeof( "@padd" ), etc
+            subString.setStart( subString.getStart() + pos + strlen( c_mathOpNames[keyword] ) + 2u );
+            Hlms::evaluateParamArgs( subString, argValues, syntaxError );
+
+            syntaxError |= argValues.size() < 2 || argValues.size() > 3;
+
+            if( !syntaxError )
+            {
+                const size_t idx = argValues.size() == 3 ? 1 : 0;
+
+                MathOp mathOp;
+                mathOp.dstProperty = argValues[0];
+                mathOp.opIdx = static_cast<uint8>( keyword );
+                parseMathOperand( argValues[idx], mathOp.op1 );
+                parseMathOperand( argValues[idx + 1], mathOp.op2 );
+                mMathOps.push_back( mathOp );
+            }
+
+            pos = subString.find( "@" );
+            keyword = std::numeric_limits<size_t>::max();
+        }
+
+        mText.append( source, subString.getStart(), subString.getSize() );
+
+        return !syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::isCounterSlot( size_t pos, const StringVector &counterVars,
+                                              size_t &outDepth ) const
+    {
+        if( pos >= mText.size() || mText[pos] != '@' )
+            return false;
+
+        // Outermost @foreach gets substituted first, thus it has priority.
+        for( size_t i = 0; i < counterVars.size(); ++i )
+        {
+            const String &counterVar = counterVars[i];
+            if( !counterVar.empty() &&
+                strncmp( mText.c_str() + pos + 1u, counterVar.c_str(), counterVar.size() ) == 0 )
+            {
+                outDepth = i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::addFragments( size_t start, size_t end, const StringVector &counterVars,
+                                             uint32 &outFirstFragment, uint32 &outNumFragments )
+    {
+        outFirstFragment = static_cast<uint32>( mFragments.size() );
+
+        size_t textStart = start;
+        size_t pos = mText.find( '@', start );
+        while( pos < end )
+        {
+            size_t depth;
+            if( isCounterSlot( pos, counterVars, depth ) )
+            {
+                const size_t slotEnd = pos + counterVars[depth].size() + 1u;
+                if( slotEnd > end )
+                    return false;
+
+                if( pos != textStart )
+                {
+                    Fragment fragment = { static_cast<uint32>( textStart ),
+                                          static_cast<uint32>( pos - textStart ), -1 };
+                    mFragments.push_back( fragment );
+                }
+
+                Fragment fragment = { 0u, 0u, static_cast<int32>( depth ) };
+                mFragments.push_back( fragment );
+
+                textStart = slotEnd;
+                pos = mText.find( '@', slotEnd );
+            }
+            else
+            {
+                pos = mText.find( '@', pos + 1u );
+            }
+        }
+
+        if( textStart < end )
+        {
+            Fragment fragment = { static_cast<uint32>( textStart ),
+                                  static_cast<uint32>( end - textStart ), -1 };
+            mFragments.push_back( fragment );
+        }
+
+        outNumFragments = static_cast<uint32>( mFragments.size() ) - outFirstFragment;
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::addTextNode( size_t start, size_t end, const StringVector &counterVars,
+                                            NodeVec &outNodes )
+    {
+        if( start >= end )
+            return true;
+
+        Node node;
+        node.type = NodeText;
+        if( !addFragments( start, end, counterVars, node.firstFragment, node.numFragments ) )
+            return false;
+
+        outNodes.push_back( node );
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::compileExpression( size_t start, size_t end,
+                                                  const StringVector &counterVars,
+                                                  ExpressionVec &outExpression )
+    {
+        // Mirrors the tokenizer in Hlms::evaluateExpression
+        bool textStarted = false;
+        bool syntaxError = false;
+        bool nextExpressionNegates = false;
+
+        std::vector<Expression *> expressionParents;
+        outExpression.clear();
+        outExpression.resize( 1 );
+
+        Expression *currentExpression = &outExpression.back();
+
+        for( size_t i = start; i < end && !syntaxError; ++i )
+        {
+            const char c = mText[i];
+
+            if( c == '(' )
+            {
+                currentExpression->children.push_back( Expression() );
+                expressionParents.push_back( currentExpression );
+
+                currentExpression->children.back().negated = nextExpressionNegates;
+
+                textStarted = false;
+                nextExpressionNegates = false;
+
+                currentExpression = &currentExpression->children.back();
+            }
+            else if( c == ')' )
+            {
+                if( expressionParents.empty() )
+                    syntaxError = true;
+                else
+                {
+                    currentExpression = expressionParents.back();
+                    expressionParents.pop_back();
+                }
+
+                textStarted = false;
+            }
+            else if( c == ' ' || c == '\t' || c == '\n' || c == '\r' )
+            {
+                textStarted = false;
+            }
+            else if( c == '!' && ( i + 1u == end || mText[i + 1u] != '=' ) )
+            {
+                nextExpressionNegates = true;
+            }
+            else
+            {
+                if( !textStarted )
+                {
+                    textStarted = true;
+                    currentExpression->children.push_back( Expression() );
+                    currentExpression->children.back().negated = nextExpressionNegates;
+                    currentExpression->children.back().srcStart = static_cast<uint32>( i );
+                }
+
+                if( c == '&' || c == '|' || c == '=' || c == '<' || c == '>' || c == '!' )
+                {
+                    if( currentExpression->children.empty() || nextExpressionNegates )
+                    {
+                        syntaxError = true;
+                    }
+                    else if( !currentExpression->children.back().value.empty() &&
+                             c != *( currentExpression->children.back().value.end() - 1 ) && c != '=' )
+                    {
+                        currentExpression->children.push_back( Expression() );
+                        currentExpression->children.back().srcStart = static_cast<uint32>( i );
+                    }
+                }
+
+                Expression &token = currentExpression->children.back();
+                // Tokens must be contiguous in the source so that we can
+                // substitute @foreach counters into them (e.g. "a!b" is not)
+                syntaxError |= token.srcStart + token.value.size() != i;
+                token.value.push_back( c );
+                nextExpressionNegates = false;
+            }
+        }
+
+        if( !expressionParents.empty() )
+            syntaxError = true;
+
+        return !syntaxError && normalizeExpression( outExpression, counterVars );
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::normalizeExpression( ExpressionVec &expression,
+                                                    const StringVector &counterVars )
+    {
+        // Mirrors the parts of Hlms::evaluateExpressionRecursive that
+        // do not depend on the value of the properties.
+        bool syntaxError = false;
+        bool lastExpWasOperator = true;
+        ExpressionVec::iterator itor = expression.begin();
+        ExpressionVec::iterator endt = expression.end();
+
+        while( itor != endt && !syntaxError )
+        {
+            Expression &exp = *itor;
+
+            if( exp.value == "&&" )
+                exp.type = Hlms::EXPR_OPERATOR_AND;
+            else if( exp.value == "||" )
+                exp.type = Hlms::EXPR_OPERATOR_OR;
+            else if( exp.value == "<" )
+                exp.type = Hlms::EXPR_OPERATOR_LE;
+            else if( exp.value == "<=" )
+                exp.type = Hlms::EXPR_OPERATOR_LEEQ;
+            else if( exp.value == "==" )
+                exp.type = Hlms::EXPR_OPERATOR_EQ;
+            else if( exp.value == "!=" )
+                exp.type = Hlms::EXPR_OPERATOR_NEQ;
+            else if( exp.value == ">" )
+                exp.type = Hlms::EXPR_OPERATOR_GR;
+            else if( exp.value == ">=" )
+                exp.type = Hlms::EXPR_OPERATOR_GREQ;
+            else if( !exp.children.empty() )
+                exp.type = Hlms::EXPR_OBJECT;
+            else
+                exp.type = Hlms::EXPR_VAR;
+
+            const bool isOperator = exp.type <= Hlms::EXPR_OPERATOR_GREQ;
+            syntaxError = isOperator == lastExpWasOperator;
+            lastExpWasOperator = isOperator;
+
+            ++itor;
+        }
+
+        if( !syntaxError && expression.size() > 3u )
+        {
+            // Enclose "a < b" into "(a < b)". See Hlms::evaluateExpressionRecursive
+            itor = expression.begin() + 1;
+            endt = expression.end();
+            while( itor != endt )
+            {
+                if( itor->type >= Hlms::EXPR_OPERATOR_LE && itor->type <= Hlms::EXPR_OPERATOR_GREQ )
+                {
+                    itor->children.resize( 3 );
+
+                    itor->children[1].type = itor->type;
+                    itor->children[1].value.swap( itor->value );
+                    itor->children[0].swap( *( itor - 1 ) );
+                    itor->children[2].swap( *( itor + 1 ) );
+
+                    itor->type = Hlms::EXPR_OBJECT;
+
+                    ( itor - 1 )->swap( *itor );
+
+                    itor = expression.erase( itor, itor + 2 );
+                    endt = expression.end();
+                }
+                else
+                {
+                    ++itor;
+                }
+            }
+        }
+
+        itor = expression.begin();
+        endt = expression.end();
+        while( itor != endt && !syntaxError )
+        {
+            Expression &exp = *itor;
+            if( exp.type == Hlms::EXPR_VAR )
+            {
+                syntaxError = !addFragments( exp.srcStart, exp.srcStart + exp.value.size(), counterVars,
+                                             exp.firstFragment, exp.numFragments );
+                exp.isDynamic = false;
+                for( uint32 i = 0u; i < exp.numFragments && !syntaxError; ++i )
+                    exp.isDynamic |= mFragments[exp.firstFragment + i].counterDepth >= 0;
+
+                if( !exp.isDynamic )
+                {
+                    parseOperand( exp.value, exp.operand );
+                    mFragments.resize( exp.firstFragment );
+                    exp.numFragments = 0u;
+                }
+            }
+            else if( exp.type == Hlms::EXPR_OBJECT )
+            {
+                syntaxError = !normalizeExpression( exp.children, counterVars );
+            }
+
+            exp.value.clear();
+            ++itor;
+        }
+
+        return !syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::isValidSkip( size_t pos, size_t regionEnd ) const
+    {
+        // The string passes skip one character after some keywords (e.g. "@end" + 1).
+        // We can only resolve that at compile time if it's a regular character inside our
+        // region: at the end of a nested block the skipped character depends on the output
+        // of the parent; and skipping an '@' (a @foreach counter, or the start of another
+        // keyword) changes the meaning of what follows depending on which pass runs first.
+        if( pos >= regionEnd )
+            return regionEnd == mText.size();
+
+        return mText[pos] != '@';
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::compileBlock( size_t start, size_t end, StringVector &counterVars,
+                                             NodeVec &outNodes )
+    {
+        StringVector argValues;
+
+        bool syntaxError = false;
+
+        size_t pos = start;
+        while( pos < end && !syntaxError )
+        {
+            size_t forEachPos = mText.find( "@foreach", pos );
+            size_t propertyPos = mText.find( "@property", pos );
+            forEachPos = forEachPos >= end ? String::npos : forEachPos;
+            propertyPos = propertyPos >= end ? String::npos : propertyPos;
+
+            if( forEachPos == String::npos && propertyPos == String::npos )
+                break;
+
+            const bool isForEach = forEachPos < propertyPos;
+            const size_t blockPos = isForEach ? forEachPos : propertyPos;
+
+            syntaxError |= !addTextNode( pos, blockPos, counterVars, outNodes );
+
+            Node node;
+            size_t blockEnd = 0;
+
+            if( isForEach )
+            {
+                const size_t argsPos = blockPos + sizeof( "@foreach" );
+                syntaxError |= argsPos > end || !isValidSkip( argsPos - 1u, end );
+
+                if( !syntaxError )
+                {
+                    SubStringRef subString( &mText, argsPos, end );
+                    Hlms::evaluateParamArgs( subString, argValues, syntaxError );
+
+                    // evaluateParamArgs extends the range to the end of the buffer
+                    SubStringRef blockSubString = subString;
+                    if( !syntaxError )
+                    {
+                        blockSubString.setEnd( end );
+                        Hlms::findBlockEnd( blockSubString, syntaxError );
+                    }
+
+                    if( !syntaxError )
+                    {
+                        node.type = NodeForEach;
+                        parseOperand( argValues[0], node.count );
+                        node.hasStart = argValues.size() > 2u;
+                        if( node.hasStart )
+                            parseOperand( argValues[2], node.start );
+
+                        String counterVar;
+                        if( argValues.size() > 1u )
+                            counterVar = argValues[1];
+
+                        for( size_t i = 0; i < counterVar.size() && !syntaxError; ++i )
+                        {
+                            const char c = counterVar[i];
+                            syntaxError = !( ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) ||
+                                             c == '_' || ( i > 0u && c >= '0' && c <= '9' ) );
+                        }
+                        for( size_t i = 0; i < 5u && !syntaxError && !counterVar.empty(); ++i )
+                        {
+                            const size_t minLength =
+                                std::min( counterVar.size(), strlen( c_blockKeywords[i] ) );
+                            syntaxError = strncmp( counterVar.c_str(), c_blockKeywords[i],
+                                                   minLength ) == 0;
+                        }
+
+                        syntaxError |= counterVars.size() >= c_maxCounterDepth;
+
+                        if( !syntaxError )
+                        {
+                            node.counterDepth = static_cast<uint32>( counterVars.size() );
+                            counterVars.push_back( counterVar );
+                            syntaxError = !compileBlock( blockSubString.getStart(),
+                                                         blockSubString.getEnd(), counterVars,
+                                                         node.children );
+                            counterVars.pop_back();
+                        }
+
+                        blockEnd = blockSubString.getEnd();
+                    }
+                }
+            }
+            else
+            {
+                const size_t expressionPos = blockPos + sizeof( "@property" );
+                syntaxError |=
+                    expressionPos > end || !isValidSkip( expressionPos - 1u, end );
+
+                if( !syntaxError )
+                {
+                    SubStringRef subString( &mText, expressionPos, end );
+                    const size_t expEnd = Hlms::evaluateExpressionEnd( subString );
+                    syntaxError = expEnd == String::npos;
+
+                    if( !syntaxError )
+                    {
+                        node.type = NodeProperty;
+                        syntaxError = !compileExpression( expressionPos, expressionPos + expEnd,
+                                                          counterVars, node.expression );
+                    }
+
+                    if( !syntaxError )
+                    {
+                        SubStringRef blockSubString( &mText, expressionPos + expEnd + 1u, end );
+                        const bool isElse = Hlms::findBlockEnd( blockSubString, syntaxError, true );
+
+                        if( !syntaxError )
+                        {
+                            syntaxError = !compileBlock( blockSubString.getStart(),
+                                                         blockSubString.getEnd(), counterVars,
+                                                         node.children );
+                        }
+
+                        if( !syntaxError && isElse )
+                        {
+                            const size_t elsePos = blockSubString.getEnd() + sizeof( "@else" );
+                            syntaxError = elsePos > end ||
+                                          !isValidSkip( elsePos - 1u, end );
+
+                            if( !syntaxError )
+                            {
+                                blockSubString = SubStringRef( &mText, elsePos, end );
+                                Hlms::findBlockEnd( blockSubString, syntaxError );
+                            }
+
+                            if( !syntaxError )
+                            {
+                                syntaxError = !compileBlock( blockSubString.getStart(),
+                                                             blockSubString.getEnd(), counterVars,
+                                                             node.elseChildren );
+                            }
+                        }
+
+                        blockEnd = blockSubString.getEnd();
+                    }
+                }
+            }
+
+            if( !syntaxError )
+            {
+                const size_t skipPos = blockEnd + sizeof( "@end" ) - 1u;
+                syntaxError = !isValidSkip( skipPos, end );
+                outNodes.push_back( node );
+                pos = std::min( skipPos + 1u, mText.size() );
+            }
+        }
+
+        if( !syntaxError )
+            syntaxError = !addTextNode( pos, end, counterVars, outNodes );
+
+        return !syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::compile( const String &source )
+    {
+        mText.clear();
+        mMathOps.clear();
+        mFragments.clear();
+        mNodes.clear();
+        mSource.clear();
+
+        mCompiled = compileMath( source );
+
+        if( mCompiled )
+        {
+            StringVector counterVars;
+            mCompiled = compileBlock( 0u, mText.size(), counterVars, mNodes );
+        }
+
+        if( !mCompiled )
+        {
+            mText.clear();
+            mMathOps.clear();
+            mFragments.clear();
+            mNodes.clear();
+            mSource = source;
+        }
+
+        mEstimatedOutputSize = mText.size();
+
+        return mCompiled;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsCompiledTemplate::appendFragments( uint32 firstFragment, uint32 numFragments,
+                                                const int32 *counters, String &outBuffer ) const
+    {
+        std::vector<Fragment>::const_iterator itor = mFragments.begin() + firstFragment;
+        std::vector<Fragment>::const_iterator endt = itor + numFragments;
+
+        while( itor != endt )
+        {
+            if( itor->counterDepth < 0 )
+                outBuffer.append( mText, itor->start, itor->length );
+            else
+            {
+                char tmp[16];
+                std::snprintf( tmp, sizeof( tmp ), "%lu",
+                               (unsigned long)counters[itor->counterDepth] );
+                outBuffer += tmp;
+            }
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    int32 HlmsCompiledTemplate::getOperandValue( const Operand &operand,
+                                                 const HlmsPropertyMap &properties, int32 defaultVal )
+    {
+        if( !operand.isProperty )
+            return operand.number;
+        return properties.getProperty( operand.property, defaultVal );
+    }
+    //-----------------------------------------------------------------------------------
+    int32 HlmsCompiledTemplate::evaluateExpression( const ExpressionVec &expression,
+                                                    const HlmsPropertyMap &properties,
+                                                    const int32 *counters ) const
+    {
+        // Mirrors Hlms::evaluateExpressionRecursive
+        int32 retVal = 1;
+        uint8 nextOperation = Hlms::EXPR_VAR;
+
+        ExpressionVec::const_iterator itor = expression.begin();
+        ExpressionVec::const_iterator endt = expression.end();
+
+        while( itor != endt )
+        {
+            int32 result;
+            if( itor->type == Hlms::EXPR_VAR )
+            {
+                if( !itor->isDynamic )
+                    result = getOperandValue( itor->operand, properties, 0 );
+                else
+                {
+                    String value;
+                    appendFragments( itor->firstFragment, itor->numFragments, counters, value );
+                    Operand operand;
+                    parseOperand( value, operand );
+                    result = getOperandValue( operand, properties, 0 );
+                }
+            }
+            else
+            {
+                result = evaluateExpression( itor->children, properties, counters );
+            }
+
+            if( itor->negated )
+                result = !result;
+
+            switch( nextOperation )
+            {
+            case Hlms::EXPR_OPERATOR_OR:
+                retVal = ( retVal != 0 ) | ( result != 0 );
+                break;
+            case Hlms::EXPR_OPERATOR_AND:
+                retVal = ( retVal != 0 ) & ( result != 0 );
+                break;
+            case Hlms::EXPR_OPERATOR_LE:
+                retVal = retVal < result;
+                break;
+            case Hlms::EXPR_OPERATOR_LEEQ:
+                retVal = retVal <= result;
+                break;
+            case Hlms::EXPR_OPERATOR_EQ:
+                retVal = retVal == result;
+                break;
+            case Hlms::EXPR_OPERATOR_NEQ:
+                retVal = retVal != result;
+                break;
+            case Hlms::EXPR_OPERATOR_GR:
+                retVal = retVal > result;
+                break;
+            case Hlms::EXPR_OPERATOR_GREQ:
+                retVal = retVal >= result;
+                break;
+            default:
+                if( itor->type > Hlms::EXPR_OPERATOR_GREQ )
+                    retVal = result;
+                break;
+            }
+
+            nextOperation = itor->type;
+
+            ++itor;
+        }
+
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::evaluateNodes( const NodeVec &nodes, const HlmsPropertyMap &properties,
+                                              int32 *counters, String &outBuffer ) const
+    {
+        bool syntaxError = false;
+
+        NodeVec::const_iterator itor = nodes.begin();
+        NodeVec::const_iterator endt = nodes.end();
+
+        while( itor != endt )
+        {
+            const Node &node = *itor;
+
+            switch( node.type )
+            {
+            case NodeText:
+                appendFragments( node.firstFragment, node.numFragments, counters, outBuffer );
+                break;
+            case NodeForEach:
+            {
+                int32 count = getOperandValue( node.count, properties, 0 );
+                int32 start = 0;
+                if( node.hasStart )
+                {
+                    start = getOperandValue( node.start, properties, -1 );
+                    if( start < 0 )
+                    {
+                        printf(
+                            "Invalid parameter (@foreach)."
+                            " '%s' is not a number nor a variable\n",
+                            node.start.property.getFriendlyText().c_str() );
+                        syntaxError = true;
+                        start = 0;
+                        count = 0;
+                    }
+                }
+
+                for( int32 i = start; i < count; ++i )
+                {
+                    counters[node.counterDepth] = i;
+                    syntaxError |= evaluateNodes( node.children, properties, counters, outBuffer );
+                }
+                break;
+            }
+            case NodeProperty:
+                if( evaluateExpression( node.expression, properties, counters ) != 0 )
+                    syntaxError |= evaluateNodes( node.children, properties, counters, outBuffer );
+                else
+                    syntaxError |= evaluateNodes( node.elseChildren, properties, counters, outBuffer );
+                break;
+            }
+
+            ++itor;
+        }
+
+        return syntaxError;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsCompiledTemplate::evaluate( HlmsPropertyVec &properties, HlmsPropertyMap &scratchMap,
+                                         String &outBuffer ) const
+    {
+        OGRE_ASSERT_LOW( mCompiled );
+
+        scratchMap.setProperties( properties );
+
+        MathOpVec::const_iterator itor = mMathOps.begin();
+        MathOpVec::const_iterator endt = mMathOps.end();
+
+        while( itor != endt )
+        {
+            const int32 op1Value = getOperandValue( itor->op1, scratchMap, 0 );
+            const int32 op2Value = getOperandValue( itor->op2, scratchMap, 0 );
+            const int32 result = executeMathOp( itor->opIdx, op1Value, op2Value );
+            // The caller still sees the results in the (sorted) vector
+            scratchMap.setProperty( itor->dstProperty, result );
+            Hlms::setProperty( properties, itor->dstProperty, result );
+            ++itor;
+        }
+
+        outBuffer.clear();
+        outBuffer.reserve( mEstimatedOutputSize );
+
+        int32 counters[c_maxCounterDepth];
+        return evaluateNodes( mNodes, scratchMap, counters, outBuffer );
+    }
+}  // namespace Ogre
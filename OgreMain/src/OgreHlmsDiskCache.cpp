@@ -41,11 +41,90 @@ THE SOFTWARE.
 #    include "iOS/macUtils.h"
 #endif
 
+#include "Hash/MurmurHash3.h"
+
+#if OGRE_NO_ZIP_ARCHIVE == 0
+#    include <zlib.h>
+#endif
+
 #include <atomic>
 
+#if OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
+#    define OGRE_HASH128_FUNC MurmurHash3_x86_128
+#else
+#    define OGRE_HASH128_FUNC MurmurHash3_x64_128
+#endif
+
 namespace Ogre
 {
-    static const uint16 c_hlmsDiskCacheVersion = 5u;
+    static const uint16 c_hlmsDiskCacheVersion = 8u;
+
+    /// Size of the header of each record: type, key & payload size
+    static const size_t c_recordHeaderSize = sizeof( uint8 ) + sizeof( uint64 ) * 2u + sizeof( uint32 );
+    /// Size of each entry of the table of contents: key, payload offset & size, type
+    static const size_t c_tocEntrySize = sizeof( uint64 ) * 3u + sizeof( uint32 ) + sizeof( uint8 );
+    /// What the file ends with: offset to the table of contents, its number of entries & c_tocMagic
+    static const size_t c_tocFooterSize = sizeof( uint64 ) + sizeof( uint32 ) * 2u;
+    static const uint32 c_tocMagic = 0x434F5448u;  // 'HTOC'
+
+    /// In-memory stream that grows as it gets written to. Used to build record payloads
+    /// (whose size must be known before writing them) and the data hashed into record keys.
+    class GrowableMemoryDataStream final : public DataStream
+    {
+        vector<uint8>::type mData;
+        size_t              mPos;
+
+    public:
+        GrowableMemoryDataStream() : DataStream( READ | WRITE ), mPos( 0 ) {}
+
+        size_t read( void *buf, size_t count ) override
+        {
+            count = std::min( count, mData.size() - mPos );
+            if( count )
+                memcpy( buf, mData.data() + mPos, count );
+            mPos += count;
+            return count;
+        }
+        size_t write( const void *buf, size_t count ) override
+        {
+            if( mPos + count > mData.size() )
+                mData.resize( mPos + count );
+            if( count )
+                memcpy( mData.data() + mPos, buf, count );
+            mPos += count;
+            mSize = mData.size();
+            return count;
+        }
+        void skip( long count ) override
+        {
+            mPos = static_cast<size_t>( std::max<long>( static_cast<long>( mPos ) + count, 0 ) );
+            mPos = std::min( mPos, mData.size() );
+        }
+        void   seek( size_t pos ) override { mPos = std::min( pos, mData.size() ); }
+        size_t tell() const override { return mPos; }
+        bool   eof() const override { return mPos >= mData.size(); }
+        void   close() override {}
+
+        void clear()
+        {
+            mData.clear();
+            mPos = 0;
+            mSize = 0;
+        }
+
+        const vector<uint8>::type &getData() const { return mData; }
+    };
+
+    /// Used to identify which ShaderCodeCache entry a PSO was built from
+    static const GpuProgram *getFirstShader( const GpuProgramPtr shaders[NumShaderTypes] )
+    {
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            if( shaders[i] )
+                return shaders[i].get();
+        }
+        return 0;
+    }
 
     HlmsDiskCache::HlmsDiskCache( HlmsManager *hlmsManager ) :
         mTemplatesOutOfDate( false ),
@@ -64,6 +143,7 @@ namespace Ogre
         mCache.pso.clear();
         mCache.datablockCustomPieceFiles.clear();
         mShaderProfile.clear();
+        mSourceStream.reset();
 
         mNativeShadingLangVer = 0u;
         mPrecisionMode = Hlms::PrecisionFull32;
@@ -72,11 +152,24 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
-    HlmsDiskCache::SourceCode::SourceCode() : mergedCache( HlmsPropertyVec(), 0 ) {}
+    HlmsDiskCache::SourceCode::SourceCode() :
+        mergedCache( HlmsPropertyVec(), 0 ),
+        uncompressedSize( 0 ),
+        storedSourceSize( 0 ),
+        storedSourceOffset( 0 ),
+        compression( SourceUncompressed )
+    {
+        key[0] = key[1] = 0u;
+    }
     //-----------------------------------------------------------------------------------
     HlmsDiskCache::SourceCode::SourceCode( const Hlms::ShaderCodeCache &shaderCodeCache ) :
-        mergedCache( shaderCodeCache.mergedCache )
+        mergedCache( shaderCodeCache.mergedCache ),
+        uncompressedSize( 0 ),
+        storedSourceSize( 0 ),
+        storedSourceOffset( 0 ),
+        compression( SourceUncompressed )
     {
+        key[0] = key[1] = 0u;
         for( size_t i = 0; i < NumShaderTypes; ++i )
         {
             if( shaderCodeCache.shaders[i] )
@@ -84,16 +177,80 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    HlmsDiskCache::Pso::Pso() : renderableCache( HlmsPropertyVec(), 0 ) {}
+    bool HlmsDiskCache::SourceCode::getSourceFiles( String outSourceFile[NumShaderTypes] ) const
+    {
+        if( !storedSourceSize )
+        {
+            for( size_t i = 0; i < NumShaderTypes; ++i )
+                outSourceFile[i] = sourceFile[i];
+            return true;
+        }
+
+        if( storedSource.size() != storedSourceSize )
+            return false;  // Not read (or couldn't be read). See HlmsDiskCache::readStoredSources
+
+        const uint8 *srcData = storedSource.data();
+        size_t srcSize = storedSource.size();
+
+        vector<uint8>::type uncompressed;
+        if( compression == SourceZlib )
+        {
+#if OGRE_NO_ZIP_ARCHIVE == 0
+            uncompressed.resize( uncompressedSize );
+            uLongf destLen = static_cast<uLongf>( uncompressedSize );
+            if( uncompress( uncompressed.data(), &destLen, storedSource.data(),
+                            static_cast<uLong>( storedSource.size() ) ) != Z_OK ||
+                destLen != uncompressedSize )
+            {
+                return false;
+            }
+            srcData = uncompressed.data();
+            srcSize = uncompressed.size();
+#else
+            return false;
+#endif
+        }
+        else if( compression != SourceUncompressed )
+        {
+            return false;
+        }
+
+        // Each stage is stored as uint32 length + characters
+        size_t offset = 0u;
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            uint32 length;
+            if( offset + sizeof( length ) > srcSize )
+                return false;
+            memcpy( &length, srcData + offset, sizeof( length ) );
+            offset += sizeof( length );
+            if( offset + length > srcSize )
+                return false;
+            outSourceFile[i].assign( reinterpret_cast<const char *>( srcData + offset ), length );
+            offset += length;
+        }
+
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    HlmsDiskCache::Pso::Pso() :
+        renderableCache( HlmsPropertyVec(), 0 ),
+        sourceCodeIdx( std::numeric_limits<uint32>::max() )
+    {
+        key[0] = key[1] = 0u;
+    }
     //-----------------------------------------------------------------------------------
     HlmsDiskCache::Pso::Pso( const Hlms::RenderableCache &srcRenderableCache,
-                             const Hlms::PassCache &srcPassCache, const HlmsCache *srcPsoCache ) :
+                             const Hlms::PassCache &srcPassCache, const HlmsCache *srcPsoCache,
+                             uint32 _sourceCodeIdx ) :
         renderableCache( srcRenderableCache ),
         passProperties( srcPassCache.properties ),
         pso( srcPsoCache->pso ),
         macroblock( *srcPsoCache->pso.macroblock ),
-        blendblock( *srcPsoCache->pso.blendblock )
+        blendblock( *srcPsoCache->pso.blendblock ),
+        sourceCodeIdx( _sourceCodeIdx )
     {
+        key[0] = key[1] = 0u;
     }
     //-----------------------------------------------------------------------------------
     //-----------------------------------------------------------------------------------
@@ -127,6 +284,9 @@ namespace Ogre
             }
         }
 
+        // Shader -> index in mCache.sourceCode
+        map<const GpuProgram *, uint32>::type sourceCodeIndices;
+
         {
             // Copy shaders
             mCache.sourceCode.reserve( hlms->mShaderCodeCache.size() );
@@ -151,7 +311,15 @@ namespace Ogre
 
                 if( bCacheable )
                 {
+                    const GpuProgram *firstShader = getFirstShader( itor->shaders );
+                    if( firstShader )
+                    {
+                        sourceCodeIndices[firstShader] =
+                            static_cast<uint32>( mCache.sourceCode.size() );
+                    }
+
                     SourceCode sourceCode( *itor );
+                    calculateKey( sourceCode, sourceCode.key );
                     mCache.sourceCode.push_back( sourceCode );
                 }
                 ++itor;
@@ -191,7 +359,21 @@ namespace Ogre
 
                 if( bCacheable )
                 {
-                    Pso pso( hlms->mRenderableCache[renderableIdx], hlms->mPassCache[passIdx], *itor );
+                    const HlmsPso &srcPso = ( *itor )->pso;
+                    const GpuProgramPtr shaders[NumShaderTypes] = {
+                        srcPso.vertexShader, srcPso.pixelShader, srcPso.geometryShader,
+                        srcPso.tesselationHullShader, srcPso.tesselationDomainShader
+                    };
+
+                    uint32 sourceCodeIdx = std::numeric_limits<uint32>::max();
+                    map<const GpuProgram *, uint32>::type::const_iterator itIdx =
+                        sourceCodeIndices.find( getFirstShader( shaders ) );
+                    if( itIdx != sourceCodeIndices.end() )
+                        sourceCodeIdx = itIdx->second;
+
+                    Pso pso( hlms->mRenderableCache[renderableIdx], hlms->mPassCache[passIdx], *itor,
+                             sourceCodeIdx );
+                    calculateKey( pso, pso.key );
                     mCache.pso.push_back( pso );
                 }
                 ++itor;
@@ -206,6 +388,16 @@ namespace Ogre
         uint32 numEntries;
         const HlmsDiskCache::SourceCode *sourceCode;
         bool templatesOutOfDate;
+        /// Output. The compiled shaders. NumShaderTypes entries per sourceCode entry
+        vector<GpuProgramPtr>::type shaders;
+
+        /// Threads only process entries in range [batchStart; batchEnd)
+        uint32 batchStart;
+        uint32 batchEnd;
+        /// When not empty, threads don't compile. They only write the preprocessed
+        /// source of each entry in the batch here (NumShaderTypes per entry),
+        /// for the caller to compile it.
+        vector<String>::type sources;
 
         CompilerJobParams( Hlms *_hlms, const HlmsDiskCache::SourceCodeVec &_sourceCode,
                            bool _templatesOutOfDate ) :
@@ -213,7 +405,35 @@ namespace Ogre
             currentEntry( 0u ),
             numEntries( static_cast<uint32>( _sourceCode.size() ) ),
             sourceCode( _sourceCode.data() ),
-            templatesOutOfDate( _templatesOutOfDate )
+            templatesOutOfDate( _templatesOutOfDate ),
+            shaders( _sourceCode.size() * NumShaderTypes ),
+            batchStart( 0u ),
+            batchEnd( static_cast<uint32>( _sourceCode.size() ) )
+        {
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    struct PsoJobParams
+    {
+        struct Entry
+        {
+            const HlmsDiskCache::Pso *pso;
+            const HlmsMacroblock     *macroblock;
+            const HlmsBlendblock     *blendblock;
+            HlmsCache                *stubEntry;
+        };
+
+        Hlms *hlms;
+        std::atomic<uint32> currentEntry;
+        vector<Entry>::type entries;
+        const HlmsDiskCache::SourceCode *sourceCode;
+        const GpuProgramPtr *shaders;
+
+        PsoJobParams( Hlms *_hlms, const CompilerJobParams &compilerJobParams ) :
+            hlms( _hlms ),
+            currentEntry( 0u ),
+            sourceCode( compilerJobParams.sourceCode ),
+            shaders( compilerJobParams.shaders.data() )
         {
         }
     };
@@ -231,6 +451,19 @@ namespace Ogre
     }
     THREAD_DECLARE( compileShadersThread );
     //-----------------------------------------------------------------------------------
+    static void runCompileShadersThreads( CompilerJobParams &jobParams, const size_t numThreads )
+    {
+        std::vector<ThreadHandlePtr> multiLoadWorkerThreads;
+        multiLoadWorkerThreads.resize( numThreads );
+        for( size_t i = 0u; i < numThreads; ++i )
+        {
+            multiLoadWorkerThreads[i] =
+                Threads::CreateThread( THREAD_GET( compileShadersThread ), i, &jobParams );
+        }
+
+        Threads::WaitForThreads( multiLoadWorkerThreads.size(), multiLoadWorkerThreads.data() );
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsDiskCache::_compileShadersThread( CompilerJobParams &jobParams, const size_t threadIdx )
     {
 #ifdef OGRE_SHADER_THREADING_BACKWARDS_COMPATIBLE_API
@@ -240,34 +473,116 @@ namespace Ogre
 #endif
 
         Hlms *hlms = jobParams.hlms;
-        const uint32 numEntries = jobParams.numEntries;
+        const uint32 batchEnd = jobParams.batchEnd;
         const bool templatesOutOfDate = jobParams.templatesOutOfDate;
         const HlmsDiskCache::SourceCode *sourceCode = jobParams.sourceCode;
+        GpuProgramPtr *shaders = jobParams.shaders.data();
+        String *sources = jobParams.sources.empty() ? 0 : jobParams.sources.data();
 
         while( true )
         {
             const uint32 idx = jobParams.currentEntry++;
-            if( idx >= numEntries )
+            if( idx >= batchEnd )
                 break;
 
+            if( sources )
+            {
+                // Only preprocess. The caller compiles
+                String *sourceFile = &sources[( idx - jobParams.batchStart ) * NumShaderTypes];
+                if( templatesOutOfDate || !sourceCode[idx].getSourceFiles( sourceFile ) )
+                    hlms->_generateShaderCode( sourceCode[idx].mergedCache, threadIdx, sourceFile );
+                continue;
+            }
+
             // Compile shaders
-            if( !templatesOutOfDate )
+            bool bParseTemplates = templatesOutOfDate;
+            if( !bParseTemplates )
             {
                 // Templates haven't changed, send the Hlms-processed shader code for compilation
-                hlms->_compileShaderFromPreprocessedSource( sourceCode[idx].mergedCache,
-                                                            sourceCode[idx].sourceFile, idx, threadIdx );
+                String sourceFile[NumShaderTypes];
+                if( sourceCode[idx].getSourceFiles( sourceFile ) )
+                {
+                    hlms->_compileShaderFromPreprocessedSource( sourceCode[idx].mergedCache,
+                                                                sourceFile, idx, threadIdx,
+                                                                &shaders[idx * NumShaderTypes] );
+                }
+                else
+                {
+                    // The stored source is unusable, but we can still generate it again
+                    bParseTemplates = true;
+                }
             }
-            else
+
+            if( bParseTemplates )
             {
                 // Templates have changed, they need to be run through the Hlms
                 // preprocessor again before they can be compiled again
                 Hlms::ShaderCodeCache shaderCodeCache( sourceCode[idx].mergedCache.pieces );
                 shaderCodeCache.mergedCache.setProperties = sourceCode[idx].mergedCache.setProperties;
                 hlms->compileShaderCode( shaderCodeCache, idx, threadIdx );
+                for( size_t i = 0; i < NumShaderTypes; ++i )
+                    shaders[idx * NumShaderTypes + i] = shaderCodeCache.shaders[i];
             }
         }
     }
     //-----------------------------------------------------------------------------------
+    static unsigned long createPsosThread( ThreadHandle *threadHandle )
+    {
+        Threads::SetThreadName( threadHandle,
+                                "PsoCrtr#" + StringConverter::toString( threadHandle->getThreadIdx() ) );
+
+        PsoJobParams &jobParams = *reinterpret_cast<PsoJobParams *>( threadHandle->getUserParam() );
+
+        HlmsDiskCache::_createPsosThread( jobParams, threadHandle->getThreadIdx() );
+        return 0u;
+    }
+    THREAD_DECLARE( createPsosThread );
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::_createPsosThread( PsoJobParams &jobParams, size_t threadIdx )
+    {
+        RenderSystem *renderSystem = jobParams.hlms->getRenderSystem();
+        const uint32 numEntries = static_cast<uint32>( jobParams.entries.size() );
+
+        while( true )
+        {
+            const uint32 idx = jobParams.currentEntry++;
+            if( idx >= numEntries )
+                break;
+
+            const PsoJobParams::Entry &entry = jobParams.entries[idx];
+            const Pso &cachedPso = *entry.pso;
+            const GpuProgramPtr *shaders = &jobParams.shaders[cachedPso.sourceCodeIdx * NumShaderTypes];
+
+            // Mirrors Hlms::createShaderCacheEntry. Except that the macroblock already had
+            // Hlms::applyStrongMacroblockRules applied when it was saved.
+            HlmsPso pso;
+            pso.initialize();
+            pso.vertexShader = shaders[VertexShader];
+            pso.geometryShader = shaders[GeometryShader];
+            pso.tesselationHullShader = shaders[HullShader];
+            pso.tesselationDomainShader = shaders[DomainShader];
+            pso.pixelShader = shaders[PixelShader];
+
+            pso.macroblock = entry.macroblock;
+            pso.blendblock = entry.blendblock;
+            pso.pass = cachedPso.pso.pass;
+
+            const size_t numGlobalClipDistances = (size_t)Hlms::getProperty(
+                jobParams.sourceCode[cachedPso.sourceCodeIdx].mergedCache.setProperties,
+                HlmsBaseProp::PsoClipDistances );
+            pso.clipDistances = static_cast<uint8>( ( 1u << numGlobalClipDistances ) - 1u );
+
+            pso.sampleMask = cachedPso.pso.sampleMask;
+            pso.operationType = cachedPso.pso.operationType;
+            pso.vertexElements = cachedPso.pso.vertexElements;
+            pso.enablePrimitiveRestart = cachedPso.pso.enablePrimitiveRestart;
+
+            renderSystem->_hlmsPipelineStateObjectCreated( &pso );
+
+            entry.stubEntry->pso = pso;
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void HlmsDiskCache::applyTo( Hlms *hlms, const size_t numThreads )
     {
         LogManager::getSingleton().logMessage( "Applying HlmsDiskCache " +
@@ -368,6 +683,10 @@ namespace Ogre
             }
         }
 
+        // The source is only needed if the templates haven't changed
+        if( !mTemplatesOutOfDate )
+            readStoredSources();
+
         {
             CompilerJobParams jobParams( hlms, mCache.sourceCode, mTemplatesOutOfDate );
 
@@ -375,17 +694,38 @@ namespace Ogre
             if( hlms->getRenderSystem()->supportsMultithreadedShaderCompilation() && numThreads > 1u )
             {
                 hlms->_setNumThreads( numThreads );
+                runCompileShadersThreads( jobParams, numThreads );
+            }
+            else if( numThreads > 1u && jobParams.numEntries > 1u )
+            {
+                // We can only compile from this thread. But parsing the templates (or decompressing
+                // the cached source) can still be done in parallel. Do it in batches, to bound the
+                // memory used by the preprocessed source.
+                hlms->_setNumThreads( numThreads );
 
-                std::vector<ThreadHandlePtr> multiLoadWorkerThreads;
-                multiLoadWorkerThreads.resize( numThreads );
-                for( size_t i = 0u; i < numThreads; ++i )
+                const uint32 batchSize = static_cast<uint32>( numThreads * 64u );
+                jobParams.sources.resize( batchSize * NumShaderTypes );
+
+                for( uint32 batchStart = 0u; batchStart < jobParams.numEntries;
+                     batchStart += batchSize )
                 {
-                    multiLoadWorkerThreads[i] =
-                        Threads::CreateThread( THREAD_GET( compileShadersThread ), i, &jobParams );
+                    jobParams.batchStart = batchStart;
+                    jobParams.batchEnd = std::min( batchStart + batchSize, jobParams.numEntries );
+                    jobParams.currentEntry = batchStart;
+
+                    runCompileShadersThreads( jobParams, numThreads );
+
+                    // Compile in order, so that shader names are the same as in the serial path
+                    for( uint32 idx = batchStart; idx < jobParams.batchEnd; ++idx )
+                    {
+                        hlms->_compileShaderFromPreprocessedSource(
+                            mCache.sourceCode[idx].mergedCache,
+                            &jobParams.sources[( idx - batchStart ) * NumShaderTypes], idx,
+                            Hlms::kNoTid, &jobParams.shaders[idx * NumShaderTypes] );
+                    }
                 }
 
-                Threads::WaitForThreads( multiLoadWorkerThreads.size(), multiLoadWorkerThreads.data() );
-                multiLoadWorkerThreads.clear();
+                jobParams.sources.clear();
             }
             else
             {
@@ -393,20 +733,23 @@ namespace Ogre
             }
 
             hlms->_setShadersGenerated( jobParams.numEntries );
-        }
 
-        {
-            hlms->mRenderableCache.reserve( hlms->mRenderableCache.size() + mCache.pso.size() );
+            // Rebuild the PSOs. The saved renderable & pass caches are registered so that
+            // Renderables and passes get these same hashes (and thus these PSOs) at runtime.
+            const bool bCreatePsos = hlms->getShaderProfile() != "glsl";
+
+            PsoJobParams psoJobParams( hlms, jobParams );
+            psoJobParams.entries.reserve( mCache.pso.size() );
+
+            if( bCreatePsos )
+                hlms->mRenderableCache.reserve( hlms->mRenderableCache.size() + mCache.pso.size() );
 
             PsoVec::const_iterator itor = mCache.pso.begin();
             PsoVec::const_iterator endt = mCache.pso.end();
 
             while( itor != endt )
             {
-                // uint32 renderableHash = static_cast<uint32>( hlms->addRenderableCache(
-                //        itor->renderableCache.setProperties, itor->renderableCache.pieces ) );
-
-                // uint32 passHash = 0;
+                uint32 passHash = 0;
                 {
                     assert( hlms->mPassCache.size() <= (uint32)HlmsBits::PassMask &&
                             "Too many passes combinations, we'll overflow "
@@ -424,14 +767,59 @@ namespace Ogre
                         it = hlms->mPassCache.end() - 1u;
                     }
 
-                    // passHash = (uint32)(it - hlms->mPassCache.begin()) << (uint32)HlmsBits::PassShift;
+                    passHash = (uint32)( it - hlms->mPassCache.begin() ) << (uint32)HlmsBits::PassShift;
                 }
 
-                // const uint32 finalHash = renderableHash | passHash;
-                // hlms->createShaderCacheEntry( renderableHash, passHash, finalHash, );
+                if( bCreatePsos && itor->sourceCodeIdx < mCache.sourceCode.size() &&
+                    jobParams.shaders[itor->sourceCodeIdx * NumShaderTypes + VertexShader] )
+                {
+                    const uint32 renderableHash = hlms->addRenderableCache(
+                        itor->renderableCache.setProperties, itor->renderableCache.pieces );
+                    const uint32 finalHash = renderableHash | passHash;
+
+                    if( !hlms->getShaderCache( finalHash ) )
+                    {
+                        // The blocks loadFrom retrieved were released right away (only their
+                        // lifetime IDs were needed) and no datablock may be using them yet.
+                        // The PSO needs references of its own, released by clearShaderCache.
+                        PsoJobParams::Entry entry;
+                        entry.pso = &( *itor );
+                        {
+                            ScopedLock lock( Hlms::msGlobalMutex );
+                            entry.macroblock = mHlmsManager->getMacroblock( itor->macroblock );
+                            entry.blendblock = mHlmsManager->getBlendblock( itor->blendblock );
+                        }
+                        entry.stubEntry = hlms->addStubShaderCache( finalHash );
+                        entry.stubEntry->ownsBlocks = true;
+
+                        psoJobParams.entries.push_back( entry );
+                    }
+                }
 
                 ++itor;
             }
+
+            if( hlms->getRenderSystem()->supportsMultithreadedShaderCompilation() && numThreads > 1u &&
+                psoJobParams.entries.size() > 1u )
+            {
+                std::vector<ThreadHandlePtr> workerThreads;
+                workerThreads.resize( numThreads );
+                for( size_t i = 0u; i < numThreads; ++i )
+                {
+                    workerThreads[i] =
+                        Threads::CreateThread( THREAD_GET( createPsosThread ), i, &psoJobParams );
+                }
+
+                Threads::WaitForThreads( workerThreads.size(), workerThreads.data() );
+            }
+            else
+            {
+                _createPsosThread( psoJobParams, Hlms::kNoTid );
+            }
+
+            LogManager::getSingleton().logMessage(
+                "HlmsDiskCache: Created " + StringConverter::toString( psoJobParams.entries.size() ) +
+                " PSOs out of " + StringConverter::toString( mCache.pso.size() ) + " cached." );
         }
 
         hlms->_tagShaderCodeCacheUpToDate();
@@ -502,10 +890,58 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void HlmsDiskCache::saveTo( DataStreamPtr &dataStream )
+    void HlmsDiskCache::savePsoState( DataStreamPtr &dataStream, const Pso &pso )
     {
-        LogManager::getSingleton().logMessage( "Saving HlmsDiskCache to " + dataStream->getName() );
+        write<uint32>( dataStream, static_cast<uint32>( pso.pso.vertexElements.size() ) );
+        VertexElement2VecVec::const_iterator itElem = pso.pso.vertexElements.begin();
+        VertexElement2VecVec::const_iterator enElem = pso.pso.vertexElements.end();
+
+        while( itElem != enElem )
+        {
+            write<uint32>( dataStream, static_cast<uint32>( itElem->size() ) );
+            VertexElement2Vec::const_iterator itElem2 = itElem->begin();
+            VertexElement2Vec::const_iterator enElem2 = itElem->end();
+
+            while( itElem2 != enElem2 )
+            {
+                write( dataStream, itElem2->mType );
+                write( dataStream, itElem2->mSemantic );
+                write( dataStream, itElem2->mInstancingStepRate );
+                ++itElem2;
+            }
+
+            ++itElem;
+        }
 
+        write( dataStream, pso.pso.operationType );
+        write( dataStream, pso.pso.enablePrimitiveRestart );
+        write( dataStream, pso.pso.sampleMask );
+        write( dataStream, pso.pso.pass );
+
+        write( dataStream, pso.macroblock.mScissorTestEnabled );
+        write( dataStream, pso.macroblock.mDepthClamp );
+        write( dataStream, pso.macroblock.mDepthCheck );
+        write( dataStream, pso.macroblock.mDepthWrite );
+        write( dataStream, pso.macroblock.mDepthFunc );
+        write( dataStream, pso.macroblock.mDepthBiasConstant );
+        write( dataStream, pso.macroblock.mDepthBiasSlopeScale );
+        write( dataStream, pso.macroblock.mCullMode );
+        write( dataStream, pso.macroblock.mPolygonMode );
+
+        write( dataStream, pso.blendblock.mAlphaToCoverage );
+        write( dataStream, pso.blendblock.mBlendChannelMask );
+        write<uint8>( dataStream, pso.blendblock.mIsTransparent & 0x02u );
+        write( dataStream, pso.blendblock.mSeparateBlend );
+        write( dataStream, pso.blendblock.mSourceBlendFactor );
+        write( dataStream, pso.blendblock.mDestBlendFactor );
+        write( dataStream, pso.blendblock.mSourceBlendFactorAlpha );
+        write( dataStream, pso.blendblock.mDestBlendFactorAlpha );
+        write( dataStream, pso.blendblock.mBlendOperation );
+        write( dataStream, pso.blendblock.mBlendOperationAlpha );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::saveHeader( DataStreamPtr &dataStream )
+    {
         write<uint16>( dataStream, c_hlmsDiskCacheVersion );
 #if OGRE_DEBUG_STR_SIZE > 0
         write<uint16>( dataStream, OGRE_DEBUG_STR_SIZE );
@@ -520,27 +956,230 @@ namespace Ogre
         write<uint16>( dataStream, mNativeShadingLangVer );
         write<uint8>( dataStream, mPrecisionMode );
         write<bool>( dataStream, mFastShaderBuildHack );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::writeKeyData( DataStreamPtr &keyData, const HlmsPropertyVec &properties,
+                                      const bool bSkipPsoProperties )
+    {
+        write<uint32>( keyData, static_cast<uint32>( properties.size() ) );
+
+        for( const HlmsProperty &property : properties )
+        {
+            // These are reset by loadFrom, and may change from run to run.
+            if( bSkipPsoProperties && ( property.keyName == HlmsPsoProp::Macroblock ||
+                                        property.keyName == HlmsPsoProp::Blendblock ||
+                                        property.keyName == HlmsPsoProp::InputLayoutId ) )
+            {
+                continue;
+            }
+
+            write( keyData, property.keyName.mHash );
+            write( keyData, property.value );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::writeKeyData( DataStreamPtr &keyData,
+                                      const Hlms::RenderableCache &renderableCache,
+                                      const bool bSkipPsoProperties )
+    {
+        writeKeyData( keyData, renderableCache.setProperties, bSkipPsoProperties );
+
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            write<uint32>( keyData, static_cast<uint32>( renderableCache.pieces[i].size() ) );
+
+            PiecesMap::const_iterator itor = renderableCache.pieces[i].begin();
+            PiecesMap::const_iterator endt = renderableCache.pieces[i].end();
+
+            while( itor != endt )
+            {
+                write( keyData, itor->first.mHash );
+                write<uint32>( keyData, static_cast<uint32>( itor->second.size() ) );
+                keyData->write( itor->second.c_str(), itor->second.size() );
+                ++itor;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    static void hashKeyData( const GrowableMemoryDataStream &keyData, uint64 outKey[2] )
+    {
+        OGRE_HASH128_FUNC( keyData.getData().data(), static_cast<int>( keyData.getData().size() ),
+                           IdString::Seed, outKey );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::calculateKey( const DatablockCustomPiecesCache &datablockPiece,
+                                      uint64 outKey[2] )
+    {
+        GrowableMemoryDataStream *keyData = OGRE_NEW GrowableMemoryDataStream();
+        DataStreamPtr keyDataPtr( keyData );
+
+        write<uint8>( keyDataPtr, RecordCustomPieceFile );
+        save( keyDataPtr, datablockPiece.filename );
+        save( keyDataPtr, datablockPiece.resourceGroup );
+
+        hashKeyData( *keyData, outKey );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::calculateKey( const SourceCode &sourceCode, uint64 outKey[2] )
+    {
+        GrowableMemoryDataStream *keyData = OGRE_NEW GrowableMemoryDataStream();
+        DataStreamPtr keyDataPtr( keyData );
+
+        write<uint8>( keyDataPtr, RecordSourceCode );
+        writeKeyData( keyDataPtr, sourceCode.mergedCache, false );
+
+        hashKeyData( *keyData, outKey );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::calculateKey( const Pso &pso, uint64 outKey[2] )
+    {
+        GrowableMemoryDataStream *keyData = OGRE_NEW GrowableMemoryDataStream();
+        DataStreamPtr keyDataPtr( keyData );
+
+        write<uint8>( keyDataPtr, RecordPso );
+        writeKeyData( keyDataPtr, pso.renderableCache, true );
+        writeKeyData( keyDataPtr, pso.passProperties, false );
+        savePsoState( keyDataPtr, pso );
+
+        hashKeyData( *keyData, outKey );
+    }
+    //-----------------------------------------------------------------------------------
+    static void compressSourceFiles( const String sourceFile[NumShaderTypes], uint8 &outCompression,
+                                     uint32 &outUncompressedSize, vector<uint8>::type &outData )
+    {
+        // Each stage is stored as uint32 length + characters
+        vector<uint8>::type uncompressed;
+        for( size_t i = 0; i < NumShaderTypes; ++i )
+        {
+            const uint32 length = static_cast<uint32>( sourceFile[i].size() );
+            const size_t offset = uncompressed.size();
+            uncompressed.resize( offset + sizeof( length ) + length );
+            memcpy( uncompressed.data() + offset, &length, sizeof( length ) );
+            if( length )
+                memcpy( uncompressed.data() + offset + sizeof( length ), sourceFile[i].data(), length );
+        }
+
+        outUncompressedSize = static_cast<uint32>( uncompressed.size() );
+
+#if OGRE_NO_ZIP_ARCHIVE == 0
+        uLongf destLen = compressBound( static_cast<uLong>( uncompressed.size() ) );
+        outData.resize( destLen );
+        if( compress2( outData.data(), &destLen, uncompressed.data(),
+                       static_cast<uLong>( uncompressed.size() ), Z_DEFAULT_COMPRESSION ) == Z_OK )
+        {
+            outData.resize( destLen );
+            outCompression = HlmsDiskCache::SourceZlib;
+            return;
+        }
+#endif
+        outData.swap( uncompressed );
+        outCompression = HlmsDiskCache::SourceUncompressed;
+    }
+    //-----------------------------------------------------------------------------------
+    /// Writes a record at inOutOffset, advancing it, and adds it to outToc
+    static void writeRecord( DataStreamPtr &dataStream, uint8 recordType, const uint64 key[2],
+                             const GrowableMemoryDataStream &payload, uint64 &inOutOffset,
+                             HlmsDiskCache::TocEntryVec &outToc )
+    {
+        const uint32 payloadSize = static_cast<uint32>( payload.getData().size() );
+
+        write( dataStream, recordType );
+        write( dataStream, key[0] );
+        write( dataStream, key[1] );
+        write<uint32>( dataStream, payloadSize );
+        dataStream->write( payload.getData().data(), payloadSize );
+
+        HlmsDiskCache::TocEntry tocEntry;
+        tocEntry.key[0] = key[0];
+        tocEntry.key[1] = key[1];
+        tocEntry.payloadOffset = inOutOffset + c_recordHeaderSize;
+        tocEntry.payloadSize = payloadSize;
+        tocEntry.type = recordType;
+        outToc.push_back( tocEntry );
+
+        inOutOffset += c_recordHeaderSize + payloadSize;
+    }
+    //-----------------------------------------------------------------------------------
+    /// Whether a record with the given key is in the file (fileToc) or has just been written
+    static bool isRecordWritten( const HlmsDiskCache::TocEntryVec &fileToc, const uint64 key[2],
+                                 HlmsDiskCache::RecordKeySet &inOutWrittenKeys )
+    {
+        HlmsDiskCache::TocEntry tocEntry;
+        tocEntry.key[0] = key[0];
+        tocEntry.key[1] = key[1];
+        HlmsDiskCache::TocEntryVec::const_iterator itor =
+            std::lower_bound( fileToc.begin(), fileToc.end(), tocEntry );
+        if( itor != fileToc.end() && itor->key[0] == key[0] && itor->key[1] == key[1] )
+            return true;
+
+        return !inOutWrittenKeys.insert( HlmsDiskCache::RecordKey( key[0], key[1] ) ).second;
+    }
+    //-----------------------------------------------------------------------------------
+    uint64 HlmsDiskCache::saveRecords( DataStreamPtr &dataStream, uint64 offset,
+                                       TocEntryVec &inOutToc )
+    {
+        // We may be overwriting the file loadFrom read from
+        readStoredSources();
+
+        GrowableMemoryDataStream *payload = OGRE_NEW GrowableMemoryDataStream();
+        DataStreamPtr payloadPtr( payload );
+
+        TocEntryVec newToc;
+        RecordKeySet writtenKeys;
 
-        write<uint32>( dataStream, static_cast<uint32>( mCache.datablockCustomPieceFiles.size() ) );
         for( const DatablockCustomPiecesCache &datablockPiece : mCache.datablockCustomPieceFiles )
         {
-            write( dataStream, datablockPiece.sourceCodeHash );
-            save( dataStream, datablockPiece.filename );
-            save( dataStream, datablockPiece.resourceGroup );
+            uint64 key[2];
+            calculateKey( datablockPiece, key );
+            if( isRecordWritten( inOutToc, key, writtenKeys ) )
+                continue;
+
+            payload->clear();
+            write( payloadPtr, datablockPiece.sourceCodeHash );
+            save( payloadPtr, datablockPiece.filename );
+            save( payloadPtr, datablockPiece.resourceGroup );
+            writeRecord( dataStream, RecordCustomPieceFile, key, *payload, offset, newToc );
         }
 
         {
             // Save shaders
-            write<uint32>( dataStream, static_cast<uint32>( mCache.sourceCode.size() ) );
+            vector<uint8>::type compressedSource;
 
             SourceCodeVec::const_iterator itor = mCache.sourceCode.begin();
             SourceCodeVec::const_iterator endt = mCache.sourceCode.end();
 
             while( itor != endt )
             {
-                save( dataStream, itor->mergedCache );
-                for( size_t i = 0; i < NumShaderTypes; ++i )
-                    save( dataStream, itor->sourceFile[i] );
+                // Skip the ones loadFrom couldn't read. The PSOs using them won't find them.
+                if( ( !itor->storedSourceSize ||
+                      itor->storedSource.size() == itor->storedSourceSize ) &&
+                    !isRecordWritten( inOutToc, itor->key, writtenKeys ) )
+                {
+                    payload->clear();
+                    save( payloadPtr, itor->mergedCache );
+
+                    if( itor->storedSourceSize )
+                    {
+                        // Came from loadFrom, it's already in its on-disk form
+                        write( payloadPtr, itor->compression );
+                        write( payloadPtr, itor->uncompressedSize );
+                        write<uint32>( payloadPtr, itor->storedSourceSize );
+                        payloadPtr->write( itor->storedSource.data(), itor->storedSourceSize );
+                    }
+                    else
+                    {
+                        uint8 compression;
+                        uint32 uncompressedSize;
+                        compressSourceFiles( itor->sourceFile, compression, uncompressedSize,
+                                             compressedSource );
+                        write( payloadPtr, compression );
+                        write( payloadPtr, uncompressedSize );
+                        write<uint32>( payloadPtr, static_cast<uint32>( compressedSource.size() ) );
+                        payloadPtr->write( compressedSource.data(), compressedSource.size() );
+                    }
+
+                    writeRecord( dataStream, RecordSourceCode, itor->key, *payload, offset, newToc );
+                }
 
                 ++itor;
             }
@@ -548,66 +1187,80 @@ namespace Ogre
 
         {
             // Save PSOs
-            write<uint32>( dataStream, static_cast<uint32>( mCache.pso.size() ) );
-
             PsoVec::const_iterator itor = mCache.pso.begin();
             PsoVec::const_iterator endt = mCache.pso.end();
 
             while( itor != endt )
             {
-                save( dataStream, itor->renderableCache );
-                save( dataStream, itor->passProperties );
-
-                write<uint32>( dataStream, static_cast<uint32>( itor->pso.vertexElements.size() ) );
-                VertexElement2VecVec::const_iterator itElem = itor->pso.vertexElements.begin();
-                VertexElement2VecVec::const_iterator enElem = itor->pso.vertexElements.end();
-
-                while( itElem != enElem )
+                if( !isRecordWritten( inOutToc, itor->key, writtenKeys ) )
                 {
-                    write<uint32>( dataStream, static_cast<uint32>( itElem->size() ) );
-                    VertexElement2Vec::const_iterator itElem2 = itElem->begin();
-                    VertexElement2Vec::const_iterator enElem2 = itElem->end();
+                    payload->clear();
+                    save( payloadPtr, itor->renderableCache );
+                    save( payloadPtr, itor->passProperties );
 
-                    while( itElem2 != enElem2 )
+                    // Reference the shaders by key, as their index may be different when loading
+                    uint64 sourceCodeKey[2] = { 0u, 0u };
+                    if( itor->sourceCodeIdx < mCache.sourceCode.size() )
                     {
-                        write( dataStream, itElem2->mType );
-                        write( dataStream, itElem2->mSemantic );
-                        write( dataStream, itElem2->mInstancingStepRate );
-                        ++itElem2;
+                        sourceCodeKey[0] = mCache.sourceCode[itor->sourceCodeIdx].key[0];
+                        sourceCodeKey[1] = mCache.sourceCode[itor->sourceCodeIdx].key[1];
                     }
+                    write( payloadPtr, sourceCodeKey );
 
-                    ++itElem;
-                }
+                    savePsoState( payloadPtr, *itor );
 
-                write( dataStream, itor->pso.operationType );
-                write( dataStream, itor->pso.enablePrimitiveRestart );
-                write( dataStream, itor->pso.sampleMask );
-                write( dataStream, itor->pso.pass );
-
-                write( dataStream, itor->macroblock.mScissorTestEnabled );
-                write( dataStream, itor->macroblock.mDepthClamp );
-                write( dataStream, itor->macroblock.mDepthCheck );
-                write( dataStream, itor->macroblock.mDepthWrite );
-                write( dataStream, itor->macroblock.mDepthFunc );
-                write( dataStream, itor->macroblock.mDepthBiasConstant );
-                write( dataStream, itor->macroblock.mDepthBiasSlopeScale );
-                write( dataStream, itor->macroblock.mCullMode );
-                write( dataStream, itor->macroblock.mPolygonMode );
-
-                write( dataStream, itor->blendblock.mAlphaToCoverage );
-                write( dataStream, itor->blendblock.mBlendChannelMask );
-                write<uint8>( dataStream, itor->blendblock.mIsTransparent & 0x02u );
-                write( dataStream, itor->blendblock.mSeparateBlend );
-                write( dataStream, itor->blendblock.mSourceBlendFactor );
-                write( dataStream, itor->blendblock.mDestBlendFactor );
-                write( dataStream, itor->blendblock.mSourceBlendFactorAlpha );
-                write( dataStream, itor->blendblock.mDestBlendFactorAlpha );
-                write( dataStream, itor->blendblock.mBlendOperation );
-                write( dataStream, itor->blendblock.mBlendOperationAlpha );
+                    writeRecord( dataStream, RecordPso, itor->key, *payload, offset, newToc );
+                }
 
                 ++itor;
             }
         }
+
+        LogManager::getSingleton().logMessage(
+            "HlmsDiskCache: Wrote " + StringConverter::toString( newToc.size() ) + " records." );
+
+        std::sort( newToc.begin(), newToc.end() );
+        const size_t numOldEntries = inOutToc.size();
+        inOutToc.insert( inOutToc.end(), newToc.begin(), newToc.end() );
+        std::inplace_merge( inOutToc.begin(), inOutToc.begin() + ptrdiff_t( numOldEntries ),
+                            inOutToc.end() );
+
+        return offset;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::saveToc( DataStreamPtr &dataStream, const TocEntryVec &toc,
+                                 const uint64 tocOffset )
+    {
+        vector<uint8>::type tocData( toc.size() * c_tocEntrySize );
+        uint8 *dst = tocData.data();
+        for( const TocEntry &tocEntry : toc )
+        {
+            memcpy( dst, tocEntry.key, sizeof( tocEntry.key ) );
+            memcpy( dst + 16u, &tocEntry.payloadOffset, sizeof( tocEntry.payloadOffset ) );
+            memcpy( dst + 24u, &tocEntry.payloadSize, sizeof( tocEntry.payloadSize ) );
+            dst[28] = tocEntry.type;
+            dst += c_tocEntrySize;
+        }
+        dataStream->write( tocData.data(), tocData.size() );
+
+        write<uint64>( dataStream, tocOffset );
+        write<uint32>( dataStream, static_cast<uint32>( toc.size() ) );
+        write<uint32>( dataStream, c_tocMagic );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::saveTo( DataStreamPtr &dataStream )
+    {
+        LogManager::getSingleton().logMessage( "Saving HlmsDiskCache to " + dataStream->getName() );
+
+        // Write the header to memory first to know where the records start
+        GrowableMemoryDataStream *header = OGRE_NEW GrowableMemoryDataStream();
+        DataStreamPtr headerPtr( header );
+        saveHeader( headerPtr );
+        dataStream->write( header->getData().data(), header->getData().size() );
+
+        TocEntryVec toc;
+        const uint64 tocOffset = saveRecords( dataStream, header->getData().size(), toc );
+        saveToc( dataStream, toc, tocOffset );
     }
     //-----------------------------------------------------------------------------------
     template <typename T>
@@ -705,17 +1358,64 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
-    void HlmsDiskCache::loadFrom( DataStreamPtr &dataStream )
+    void HlmsDiskCache::loadPsoState( DataStreamPtr &dataStream, Pso &pso )
     {
-        LogManager::getSingleton().logMessage( "Loading HlmsDiskCache from " + dataStream->getName() );
+        const uint32 numVertexElements = read<uint32>( dataStream );
+        pso.pso.vertexElements.clear();
+        pso.pso.vertexElements.reserve( numVertexElements );
 
-        clearCache();
+        for( size_t j = 0; j < numVertexElements; ++j )
+        {
+            pso.pso.vertexElements.push_back( VertexElement2Vec() );
+            VertexElement2Vec &vertexElements = pso.pso.vertexElements.back();
 
+            const uint32 numVertexElements2 = read<uint32>( dataStream );
+            vertexElements.reserve( numVertexElements2 );
+
+            for( size_t k = 0; k < numVertexElements2; ++k )
+            {
+                VertexElementType type = read<VertexElementType>( dataStream );
+                VertexElementSemantic semantic = read<VertexElementSemantic>( dataStream );
+                uint32 instancingStepRate = read<uint32>( dataStream );
+                vertexElements.push_back( VertexElement2( type, semantic ) );
+                vertexElements.back().mInstancingStepRate = instancingStepRate;
+            }
+        }
+
+        read( dataStream, pso.pso.operationType );
+        read( dataStream, pso.pso.enablePrimitiveRestart );
+        read( dataStream, pso.pso.sampleMask );
+        read( dataStream, pso.pso.pass );
+
+        read( dataStream, pso.macroblock.mScissorTestEnabled );
+        read( dataStream, pso.macroblock.mDepthClamp );
+        read( dataStream, pso.macroblock.mDepthCheck );
+        read( dataStream, pso.macroblock.mDepthWrite );
+        read( dataStream, pso.macroblock.mDepthFunc );
+        read( dataStream, pso.macroblock.mDepthBiasConstant );
+        read( dataStream, pso.macroblock.mDepthBiasSlopeScale );
+        read( dataStream, pso.macroblock.mCullMode );
+        read( dataStream, pso.macroblock.mPolygonMode );
+
+        read( dataStream, pso.blendblock.mAlphaToCoverage );
+        read( dataStream, pso.blendblock.mBlendChannelMask );
+        read( dataStream, pso.blendblock.mIsTransparent );
+        read( dataStream, pso.blendblock.mSeparateBlend );
+        read( dataStream, pso.blendblock.mSourceBlendFactor );
+        read( dataStream, pso.blendblock.mDestBlendFactor );
+        read( dataStream, pso.blendblock.mSourceBlendFactorAlpha );
+        read( dataStream, pso.blendblock.mDestBlendFactorAlpha );
+        read( dataStream, pso.blendblock.mBlendOperation );
+        read( dataStream, pso.blendblock.mBlendOperationAlpha );
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::loadHeader( DataStreamPtr &dataStream )
+    {
         const uint16 version = read<uint16>( dataStream );
         if( version != c_hlmsDiskCacheVersion )
         {
             LogManager::getSingleton().logMessage( "HlmsDiskCache: Version mismatch. Not loading." );
-            return;
+            return false;
         }
 
         mDebugStrSize = read<uint16>( dataStream );
@@ -725,7 +1425,7 @@ namespace Ogre
             LogManager::getSingleton().logMessage(
                 "HlmsDiskCache: This cache was built with a OGRE_DEBUG_STR_SIZE (IdString) of " +
                 StringConverter::toString( mDebugStrSize ) + ". It cannot be used. Not loading." );
-            return;
+            return false;
         }
 #endif
 
@@ -736,7 +1436,7 @@ namespace Ogre
                 LogManager::getSingleton().logMessage(
                     "HlmsDiskCache: This cache was built with a OGRE_HASH_BITS (IdString) of " +
                     StringConverter::toString( hashBitSize ) + ". It cannot be used. Not loading." );
-                return;
+                return false;
             }
         }
 
@@ -748,116 +1448,286 @@ namespace Ogre
         read<uint8>( dataStream, mPrecisionMode );
         read<bool>( dataStream, mFastShaderBuildHack );
 
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::loadToc( DataStreamPtr &dataStream, TocEntryVec &outToc,
+                                 uint64 &outTocOffset )
+    {
+        outToc.clear();
+
+        const uint64 headerEnd = dataStream->tell();
+        const uint64 streamSize = dataStream->size();
+        if( streamSize < headerEnd + c_tocFooterSize )
+            return false;
+
+        dataStream->seek( static_cast<size_t>( streamSize - c_tocFooterSize ) );
+        const uint64 tocOffset = read<uint64>( dataStream );
+        const uint32 numEntries = read<uint32>( dataStream );
+        const uint32 magic = read<uint32>( dataStream );
+
+        if( magic != c_tocMagic || tocOffset < headerEnd ||
+            tocOffset + uint64( numEntries ) * c_tocEntrySize + c_tocFooterSize != streamSize )
         {
-            // Load datablock's custom pieces
-            // (Those that came from files. The ones from memory cannot be cached).
-            const uint32 numPieceFiles = read<uint32>( dataStream );
-            mCache.datablockCustomPieceFiles.reserve( numPieceFiles );
-            for( size_t i = 0u; i < numPieceFiles; ++i )
+            return false;
+        }
+
+        vector<uint8>::type tocData( numEntries * c_tocEntrySize );
+        dataStream->seek( static_cast<size_t>( tocOffset ) );
+        if( dataStream->read( tocData.data(), tocData.size() ) != tocData.size() )
+            return false;
+
+        outToc.resize( numEntries );
+        const uint8 *src = tocData.data();
+        for( TocEntry &tocEntry : outToc )
+        {
+            memcpy( tocEntry.key, src, sizeof( tocEntry.key ) );
+            memcpy( &tocEntry.payloadOffset, src + 16u, sizeof( tocEntry.payloadOffset ) );
+            memcpy( &tocEntry.payloadSize, src + 24u, sizeof( tocEntry.payloadSize ) );
+            tocEntry.type = src[28];
+            src += c_tocEntrySize;
+
+            if( tocEntry.payloadOffset < headerEnd + c_recordHeaderSize ||
+                tocEntry.payloadOffset + tocEntry.payloadSize > tocOffset )
             {
-                DatablockCustomPiecesCache datablockPiece;
-                read( dataStream, datablockPiece.sourceCodeHash );
-                load( dataStream, datablockPiece.filename );
-                load( dataStream, datablockPiece.resourceGroup );
-                mCache.datablockCustomPieceFiles.emplace_back( datablockPiece );
+                outToc.clear();
+                return false;
             }
         }
 
+        outTocOffset = tocOffset;
+        return true;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::readStoredSources()
+    {
+        if( !mSourceStream )
+            return;
+
+        // Read them in the order they're in the file
+        vector<SourceCode *>::type pendingSources;
+        for( SourceCode &sourceCode : mCache.sourceCode )
         {
-            // Load shaders
-            uint32 numEntries = read<uint32>( dataStream );
-            mCache.sourceCode.reserve( numEntries );
+            if( sourceCode.storedSourceSize && sourceCode.storedSource.empty() )
+                pendingSources.push_back( &sourceCode );
+        }
+        std::sort( pendingSources.begin(), pendingSources.end(),
+                   []( const SourceCode *a, const SourceCode *b )
+                   { return a->storedSourceOffset < b->storedSourceOffset; } );
 
-            SourceCode sourceCode;
-            for( size_t i = 0; i < numEntries; ++i )
+        for( SourceCode *sourceCode : pendingSources )
+        {
+            sourceCode->storedSource.resize( sourceCode->storedSourceSize );
+            mSourceStream->seek( static_cast<size_t>( sourceCode->storedSourceOffset ) );
+            if( mSourceStream->read( sourceCode->storedSource.data(),
+                                     sourceCode->storedSourceSize ) != sourceCode->storedSourceSize )
             {
-                load( dataStream, sourceCode.mergedCache );
-                for( size_t j = 0; j < NumShaderTypes; ++j )
-                    load( dataStream, sourceCode.sourceFile[j] );
-                mCache.sourceCode.push_back( sourceCode );
+                // getSourceFiles will fail and the shader will be generated again
+                sourceCode->storedSource.clear();
             }
         }
 
+        mSourceStream.reset();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsDiskCache::loadFrom( DataStreamPtr &dataStream )
+    {
+        LogManager::getSingleton().logMessage( "Loading HlmsDiskCache from " + dataStream->getName() );
+
+        clearCache();
+
+        if( !loadHeader( dataStream ) )
+            return;
+
+        TocEntryVec toc;
+        uint64 tocOffset;
+        if( !loadToc( dataStream, toc, tocOffset ) )
         {
-            // Load PSOs
-            const uint32 numEntries = read<uint32>( dataStream );
-            mCache.pso.reserve( numEntries );
+            // Can happen if the app was killed while saving
+            LogManager::getSingleton().logMessage(
+                "HlmsDiskCache: The file is truncated or corrupt. Not loading." );
+            return;
+        }
 
-            Pso pso;
-            for( size_t i = 0; i < numEntries; ++i )
-            {
-                load( dataStream, pso.renderableCache );
-                load( dataStream, pso.passProperties );
+        // Read the records in the order they're in the file
+        std::sort( toc.begin(), toc.end(), []( const TocEntry &a, const TocEntry &b )
+                   { return a.payloadOffset < b.payloadOffset; } );
 
-                const uint32 numVertexElements = read<uint32>( dataStream );
-                pso.pso.vertexElements.reserve( numVertexElements );
+        // Key of the source code -> index in mCache.sourceCode
+        map<RecordKey, uint32>::type sourceCodeIndices;
 
-                for( size_t j = 0; j < numVertexElements; ++j )
-                {
-                    pso.pso.vertexElements.push_back( VertexElement2Vec() );
-                    VertexElement2Vec &vertexElements = pso.pso.vertexElements.back();
+        // PSOs reference source code records, so load them in a second pass
+        for( int pass = 0; pass < 2; ++pass )
+        {
+            for( const TocEntry &tocEntry : toc )
+            {
+                if( ( tocEntry.type == RecordPso ) != ( pass == 1 ) )
+                    continue;
 
-                    const uint32 numVertexElements2 = read<uint32>( dataStream );
-                    vertexElements.reserve( numVertexElements2 );
+                dataStream->seek( static_cast<size_t>( tocEntry.payloadOffset ) );
 
-                    for( size_t k = 0; k < numVertexElements2; ++k )
+                switch( tocEntry.type )
+                {
+                case RecordCustomPieceFile:
+                {
+                    // Datablock's custom pieces
+                    // (Those that came from files. The ones from memory cannot be cached).
+                    DatablockCustomPiecesCache datablockPiece;
+                    read( dataStream, datablockPiece.sourceCodeHash );
+                    load( dataStream, datablockPiece.filename );
+                    load( dataStream, datablockPiece.resourceGroup );
+                    mCache.datablockCustomPieceFiles.emplace_back( datablockPiece );
+                    break;
+                }
+                case RecordSourceCode:
+                {
+                    mCache.sourceCode.push_back( SourceCode() );
+                    SourceCode &sourceCode = mCache.sourceCode.back();
+                    sourceCode.key[0] = tocEntry.key[0];
+                    sourceCode.key[1] = tocEntry.key[1];
+                    load( dataStream, sourceCode.mergedCache );
+                    read( dataStream, sourceCode.compression );
+                    read( dataStream, sourceCode.uncompressedSize );
+                    read( dataStream, sourceCode.storedSourceSize );
+
+                    // Don't read it yet. See readStoredSources
+                    sourceCode.storedSourceOffset = dataStream->tell();
+                    if( sourceCode.storedSourceOffset + sourceCode.storedSourceSize >
+                        tocEntry.payloadOffset + tocEntry.payloadSize )
                     {
-                        VertexElementType type = read<VertexElementType>( dataStream );
-                        VertexElementSemantic semantic = read<VertexElementSemantic>( dataStream );
-                        uint32 instancingStepRate = read<uint32>( dataStream );
-                        vertexElements.push_back( VertexElement2( type, semantic ) );
-                        vertexElements.back().mInstancingStepRate = instancingStepRate;
+                        // Corrupt. It will be generated again
+                        sourceCode.storedSourceOffset = std::numeric_limits<uint64>::max();
                     }
+
+                    sourceCodeIndices[RecordKey( tocEntry.key[0], tocEntry.key[1] )] =
+                        static_cast<uint32>( mCache.sourceCode.size() - 1u );
+                    break;
                 }
+                case RecordPso:
+                {
+                    mCache.pso.push_back( Pso() );
+                    Pso &pso = mCache.pso.back();
+                    pso.key[0] = tocEntry.key[0];
+                    pso.key[1] = tocEntry.key[1];
+                    load( dataStream, pso.renderableCache );
+                    load( dataStream, pso.passProperties );
+
+                    uint64 sourceCodeKey[2];
+                    read( dataStream, sourceCodeKey );
+                    map<RecordKey, uint32>::type::const_iterator itIdx =
+                        sourceCodeIndices.find( RecordKey( sourceCodeKey[0], sourceCodeKey[1] ) );
+                    if( itIdx != sourceCodeIndices.end() )
+                        pso.sourceCodeIdx = itIdx->second;
+
+                    loadPsoState( dataStream, pso );
+
+                    // We retrieve the Macroblock & Blendblock from HlmsManager and immediately
+                    // remove them. This allows us to create a permanent pointer, while the actual
+                    // internal pointer is released (i.e. it becomes inactive)
+                    pso.pso.macroblock = mHlmsManager->getMacroblock( pso.macroblock );
+                    mHlmsManager->destroyMacroblock( pso.pso.macroblock );
+
+                    pso.pso.blendblock = mHlmsManager->getBlendblock( pso.blendblock );
+                    mHlmsManager->destroyBlendblock( pso.pso.blendblock );
+
+                    uint16 inputLayoutId = mHlmsManager->_getInputLayoutId( pso.pso.vertexElements,
+                                                                            pso.pso.operationType );
+
+                    // Reset these properties because they may be different now
+                    Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Macroblock,
+                                       pso.pso.macroblock->mLifetimeId );
+                    Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Blendblock,
+                                       pso.pso.blendblock->mLifetimeId );
+                    Hlms::setProperty( pso.renderableCache.setProperties,
+                                       HlmsPsoProp::InputLayoutId, inputLayoutId );
+                    break;
+                }
+                default:
+                    // Written by a newer version. Skip it.
+                    break;
+                }
+            }
+        }
+
+        if( !mCache.sourceCode.empty() )
+            mSourceStream = dataStream;
 
-                read( dataStream, pso.pso.operationType );
-                read( dataStream, pso.pso.enablePrimitiveRestart );
-                read( dataStream, pso.pso.sampleMask );
-                read( dataStream, pso.pso.pass );
-
-                read( dataStream, pso.macroblock.mScissorTestEnabled );
-                read( dataStream, pso.macroblock.mDepthClamp );
-                read( dataStream, pso.macroblock.mDepthCheck );
-                read( dataStream, pso.macroblock.mDepthWrite );
-                read( dataStream, pso.macroblock.mDepthFunc );
-                read( dataStream, pso.macroblock.mDepthBiasConstant );
-                read( dataStream, pso.macroblock.mDepthBiasSlopeScale );
-                read( dataStream, pso.macroblock.mCullMode );
-                read( dataStream, pso.macroblock.mPolygonMode );
-
-                read( dataStream, pso.blendblock.mAlphaToCoverage );
-                read( dataStream, pso.blendblock.mBlendChannelMask );
-                read( dataStream, pso.blendblock.mIsTransparent );
-                read( dataStream, pso.blendblock.mSeparateBlend );
-                read( dataStream, pso.blendblock.mSourceBlendFactor );
-                read( dataStream, pso.blendblock.mDestBlendFactor );
-                read( dataStream, pso.blendblock.mSourceBlendFactorAlpha );
-                read( dataStream, pso.blendblock.mDestBlendFactorAlpha );
-                read( dataStream, pso.blendblock.mBlendOperation );
-                read( dataStream, pso.blendblock.mBlendOperationAlpha );
-
-                // We retrieve the Macroblock & Blendblock from HlmsManager and immediately remove them
-                // This allows us to create a permanent pointer, while the actual internal pointer is
-                // released (i.e. it becomes inactive)
-                pso.pso.macroblock = mHlmsManager->getMacroblock( pso.macroblock );
-                mHlmsManager->destroyMacroblock( pso.pso.macroblock );
-
-                pso.pso.blendblock = mHlmsManager->getBlendblock( pso.blendblock );
-                mHlmsManager->destroyBlendblock( pso.pso.blendblock );
-
-                uint16 inputLayoutId =
-                    mHlmsManager->_getInputLayoutId( pso.pso.vertexElements, pso.pso.operationType );
-
-                // Reset these properties because they may be different now
-                Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Macroblock,
-                                   pso.pso.macroblock->mLifetimeId );
-                Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::Blendblock,
-                                   pso.pso.blendblock->mLifetimeId );
-                Hlms::setProperty( pso.renderableCache.setProperties, HlmsPsoProp::InputLayoutId,
-                                   inputLayoutId );
-
-                mCache.pso.push_back( pso );
+        LogManager::getSingleton().logMessage(
+            "HlmsDiskCache: Loaded " + StringConverter::toString( mCache.sourceCode.size() ) +
+            " shaders and " + StringConverter::toString( mCache.pso.size() ) + " PSOs." );
+    }
+    //-----------------------------------------------------------------------------------
+    bool HlmsDiskCache::appendTo( DataStreamPtr &dataStream )
+    {
+        LogManager::getSingleton().logMessage( "Appending HlmsDiskCache to " + dataStream->getName() );
+
+        {
+            HlmsDiskCache fileCache( mHlmsManager );
+            fileCache.clearCache();
+#if OGRE_DEBUG_STR_SIZE > 0
+            const uint16 debugStrSize = OGRE_DEBUG_STR_SIZE;
+#else
+            const uint16 debugStrSize = 0u;
+#endif
+            // Our records must be readable with the file's header
+            if( !fileCache.loadHeader( dataStream ) ||                            //
+                fileCache.mDebugStrSize != debugStrSize ||                        //
+                fileCache.mCache.templateHash[0] != mCache.templateHash[0] ||     //
+                fileCache.mCache.templateHash[1] != mCache.templateHash[1] ||     //
+                fileCache.mCache.type != mCache.type ||                           //
+                fileCache.mShaderProfile != mShaderProfile ||                     //
+                fileCache.mNativeShadingLangVer != mNativeShadingLangVer ||       //
+                fileCache.mPrecisionMode != mPrecisionMode ||                     //
+                fileCache.mFastShaderBuildHack != mFastShaderBuildHack )
+            {
+                LogManager::getSingleton().logMessage(
+                    "HlmsDiskCache: The file is out of date. It must be saved from scratch." );
+                return false;
+            }
+        }
+
+        // Only the table of contents is read; not the records
+        TocEntryVec toc;
+        uint64 tocOffset;
+        if( !loadToc( dataStream, toc, tocOffset ) )
+        {
+            LogManager::getSingleton().logMessage(
+                "HlmsDiskCache: The file is truncated or corrupt. It must be saved from scratch." );
+            return false;
+        }
+
+        for( const DatablockCustomPiecesCache &datablockPiece : mCache.datablockCustomPieceFiles )
+        {
+            // If the piece file changed, the records that used the old version are stale
+            TocEntry tocEntry;
+            calculateKey( datablockPiece, tocEntry.key );
+            TocEntryVec::const_iterator itor = std::lower_bound( toc.begin(), toc.end(), tocEntry );
+            if( itor != toc.end() && itor->key[0] == tocEntry.key[0] &&
+                itor->key[1] == tocEntry.key[1] )
+            {
+                uint64 sourceCodeHash[2];
+                dataStream->seek( static_cast<size_t>( itor->payloadOffset ) );
+                read( dataStream, sourceCodeHash );
+                if( datablockPiece.sourceCodeHash[0] != sourceCodeHash[0] ||
+                    datablockPiece.sourceCodeHash[1] != sourceCodeHash[1] )
+                {
+                    LogManager::getSingleton().logMessage(
+                        "HlmsDiskCache: Custom piece file '" + datablockPiece.filename +
+                        "' changed. It must be saved from scratch." );
+                    return false;
+                }
             }
         }
+
+        // The new records overwrite the table of contents, and the updated one goes after them
+        const size_t numOldEntries = toc.size();
+        dataStream->seek( static_cast<size_t>( tocOffset ) );
+        const uint64 newTocOffset = saveRecords( dataStream, tocOffset, toc );
+        if( toc.size() != numOldEntries )
+            saveToc( dataStream, toc, newTocOffset );
+
+        return true;
     }
 }  // namespace Ogre
+
+#undef OGRE_HASH128_FUNC
@@ -0,0 +1,176 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgreHlmsPropertyMap.h"
+
+#include "OgreBitwise.h"
+
+namespace Ogre
+{
+    static const size_t c_minPropertyMapCapacity = 16u;
+
+    HlmsPropertyMap::HlmsPropertyMap() : mSize( 0u ), mMask( 0u ), mShift( 32u ) {}
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::rehash( size_t newCapacity )
+    {
+        OGRE_ASSERT_LOW( Bitwise::isPO2( newCapacity ) && newCapacity >= c_minPropertyMapCapacity );
+
+        SlotVec oldSlots;
+        oldSlots.swap( mSlots );
+
+        mSlots.resize( newCapacity );
+        mMask = static_cast<uint32>( newCapacity - 1u );
+        mShift = static_cast<uint8>(
+            32u - Bitwise::mostSignificantBitSet( static_cast<unsigned int>( newCapacity ) ) );
+
+        SlotVec::const_iterator itor = oldSlots.begin();
+        SlotVec::const_iterator endt = oldSlots.end();
+
+        while( itor != endt )
+        {
+            if( itor->used )
+                mSlots[findSlot( itor->keyName )] = *itor;
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::clear()
+    {
+        if( mSize == 0u )
+            return;
+
+        SlotVec::iterator itor = mSlots.begin();
+        SlotVec::iterator endt = mSlots.end();
+
+        while( itor != endt )
+        {
+            itor->used = false;
+            ++itor;
+        }
+
+        mSize = 0u;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::reserve( size_t numProperties )
+    {
+        // Keep the load factor <= 0.5
+        const size_t newCapacity = std::max(
+            c_minPropertyMapCapacity, size_t( Bitwise::firstPO2From( uint32( numProperties * 2u ) ) ) );
+        if( newCapacity > mSlots.size() )
+            rehash( newCapacity );
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::setProperty( IdString key, int32 value )
+    {
+        if( ( mSize + 1u ) * 2u > mSlots.size() )
+            rehash( std::max( c_minPropertyMapCapacity, mSlots.size() * 2u ) );
+
+        Slot &slot = mSlots[findSlot( key )];
+        if( !slot.used )
+        {
+            slot.keyName = key;
+            slot.used = true;
+            ++mSize;
+        }
+        slot.value = value;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::unsetProperty( IdString key )
+    {
+        if( mSize == 0u )
+            return;
+
+        uint32 idx = findSlot( key );
+        if( !mSlots[idx].used )
+            return;
+
+        // Backward shift deletion: move back every entry of the probe sequence that
+        // would no longer be reachable once there is a hole at idx.
+        uint32 nextIdx = idx;
+        while( true )
+        {
+            nextIdx = ( nextIdx + 1u ) & mMask;
+            if( !mSlots[nextIdx].used )
+                break;
+
+            const uint32 homeIdx = getHomeSlot( mSlots[nextIdx].keyName );
+            // Distance travelled from its home slot vs distance to the hole
+            const uint32 probeDist = ( nextIdx - homeIdx ) & mMask;
+            const uint32 holeDist = ( nextIdx - idx ) & mMask;
+            if( probeDist >= holeDist )
+            {
+                mSlots[idx] = mSlots[nextIdx];
+                idx = nextIdx;
+            }
+        }
+
+        mSlots[idx].used = false;
+        --mSize;
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::setProperties( const HlmsPropertyVec &properties )
+    {
+        clear();
+        reserve( properties.size() );
+
+        HlmsPropertyVec::const_iterator itor = properties.begin();
+        HlmsPropertyVec::const_iterator endt = properties.end();
+
+        while( itor != endt )
+        {
+            // Keys in HlmsPropertyVec are unique
+            Slot &slot = mSlots[findSlot( itor->keyName )];
+            slot.keyName = itor->keyName;
+            slot.value = itor->value;
+            slot.used = true;
+            ++itor;
+        }
+
+        mSize = properties.size();
+    }
+    //-----------------------------------------------------------------------------------
+    void HlmsPropertyMap::getSortedProperties( HlmsPropertyVec &outProperties ) const
+    {
+        outProperties.clear();
+        outProperties.reserve( mSize );
+
+        SlotVec::const_iterator itor = mSlots.begin();
+        SlotVec::const_iterator endt = mSlots.end();
+
+        while( itor != endt )
+        {
+            if( itor->used )
+                outProperties.push_back( HlmsProperty( itor->keyName, itor->value ) );
+            ++itor;
+        }
+
+        std::sort( outProperties.begin(), outProperties.end(), OrderPropertyByIdString );
+    }
+}  // namespace Ogre
@@ -41,6 +41,7 @@ THE SOFTWARE.
 #include "OgreResourceGroupManager.h"
 #include "OgreStagingTexture.h"
 #include "OgreTextureGpuManager.h"
+#include "Threading/OgreThreads.h"
 
 namespace Ogre
 {
@@ -1080,7 +1081,96 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    bool Image2::generateMipmaps( bool gammaCorrected, Filter filter )
+    /// Parameters to downsample one 2D or Cubemap mip, split in bands of rows
+    struct DownsampleMipJob
+    {
+        ImageDownsampler2D   *downsampler2DFunc;
+        ImageDownsamplerCube *downsamplerCubeFunc;
+        const FilterKernel   *filter;
+        TextureBox            srcBox;
+        TextureBox            dstBox;
+        /// Same layout as srcBox. Differs from srcBox.data when the src was blurred first
+        uint8 const *srcData;
+        uint32       numBands;
+    };
+    //-----------------------------------------------------------------------------------
+    static void downsampleMipBand( const DownsampleMipJob &job, const size_t bandIdx )
+    {
+        const FilterKernel &filter = *job.filter;
+        const TextureBox &srcBox = job.srcBox;
+        const TextureBox &dstBox = job.dstBox;
+
+        const int32 rowStart = static_cast<int32>( dstBox.height * bandIdx / job.numBands );
+        const int32 rowEnd = static_cast<int32>( dstBox.height * ( bandIdx + 1u ) / job.numBands );
+
+        if( job.downsamplerCubeFunc )
+        {
+            uint8 const *upFaces[6];
+            for( size_t j = 0; j < 6; ++j )
+                upFaces[j] = reinterpret_cast<uint8 *>( srcBox.at( 0, 0, j ) );
+
+            for( size_t j = 0; j < 6; ++j )
+            {
+                uint8 *downFace = reinterpret_cast<uint8 *>( dstBox.at( 0, 0, j ) );
+                ( *job.downsamplerCubeFunc )(
+                    downFace, upFaces, static_cast<int32>( dstBox.width ),
+                    static_cast<int32>( dstBox.height ), static_cast<int32>( dstBox.bytesPerRow ),
+                    static_cast<int32>( srcBox.width ), static_cast<int32>( srcBox.height ),
+                    static_cast<int32>( srcBox.bytesPerRow ), filter.kernel, filter.kernelStartX,
+                    filter.kernelEndX, filter.kernelStartY, filter.kernelEndY, static_cast<uint8>( j ),
+                    rowStart, rowEnd );
+            }
+        }
+        else
+        {
+            ( *job.downsampler2DFunc )(
+                reinterpret_cast<uint8 *>( dstBox.data ), job.srcData,
+                static_cast<int32>( dstBox.width ), static_cast<int32>( dstBox.height ),
+                static_cast<int32>( dstBox.bytesPerRow ), static_cast<int32>( srcBox.width ),
+                static_cast<int32>( srcBox.bytesPerRow ), filter.kernel, filter.kernelStartX,
+                filter.kernelEndX, filter.kernelStartY, filter.kernelEndY, rowStart, rowEnd );
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    static unsigned long downsampleMipThread( ThreadHandle *threadHandle )
+    {
+        const DownsampleMipJob &job =
+            *reinterpret_cast<const DownsampleMipJob *>( threadHandle->getUserParam() );
+        downsampleMipBand( job, threadHandle->getThreadIdx() );
+        return 0;
+    }
+    THREAD_DECLARE( downsampleMipThread );
+    //-----------------------------------------------------------------------------------
+    static void downsampleMip( DownsampleMipJob &job, const uint32 numThreads )
+    {
+        // Spawning threads isn't free. Only split mips that are worth it,
+        // and in bands of at least 32 rows.
+        const uint32 numPixels = job.dstBox.width * job.dstBox.height;
+        job.numBands = 1u;
+        if( numThreads > 1u && numPixels >= 256u * 256u )
+            job.numBands = std::max( 1u, std::min( numThreads, job.dstBox.height / 32u ) );
+
+        if( job.numBands == 1u )
+        {
+            downsampleMipBand( job, 0u );
+            return;
+        }
+
+        // The calling thread does band 0
+        std::vector<ThreadHandlePtr> workerThreads;
+        workerThreads.resize( job.numBands - 1u );
+        for( size_t i = 1u; i < job.numBands; ++i )
+        {
+            workerThreads[i - 1u] =
+                Threads::CreateThread( THREAD_GET( downsampleMipThread ), i, &job );
+        }
+
+        downsampleMipBand( job, 0u );
+
+        Threads::WaitForThreads( workerThreads.size(), workerThreads.data() );
+    }
+    //-----------------------------------------------------------------------------------
+    bool Image2::generateMipmaps( bool gammaCorrected, Filter filter, uint32 numThreads )
     {
         OgreProfileExhaustive( "Image2::generateMipmaps" );
 
@@ -1166,6 +1256,14 @@ namespace Ogre
 
         const FilterKernel &chosenFilter = c_filterKernels[filterIdx];
 
+        DownsampleMipJob downsampleJob;
+        downsampleJob.downsampler2DFunc = downsampler2DFunc;
+        downsampleJob.downsamplerCubeFunc =
+            mTextureType == TextureTypes::TypeCube ? downsamplerCubeFunc : 0;
+        downsampleJob.filter = &chosenFilter;
+        downsampleJob.srcData = 0;
+        downsampleJob.numBands = 1u;
+
         for( uint8 i = 1u; i < mNumMipmaps; ++i )
         {
             uint32 srcWidth = dstWidth;
@@ -1178,23 +1276,13 @@ namespace Ogre
             TextureBox box0 = this->getData( i - 1u );
             TextureBox box1 = this->getData( i );
 
+            downsampleJob.srcBox = box0;
+            downsampleJob.dstBox = box1;
+            downsampleJob.srcData = reinterpret_cast<uint8 *>( box0.data );
+
             if( mTextureType == TextureTypes::TypeCube )
             {
-                uint8 const *upFaces[6];
-                for( size_t j = 0; j < 6; ++j )
-                    upFaces[j] = reinterpret_cast<uint8 *>( box0.at( 0, 0, j ) );
-
-                for( size_t j = 0; j < 6; ++j )
-                {
-                    uint8 *downFace = reinterpret_cast<uint8 *>( box1.at( 0, 0, j ) );
-                    ( *downsamplerCubeFunc )(
-                        reinterpret_cast<uint8 *>( downFace ), upFaces, static_cast<int32>( dstWidth ),
-                        static_cast<int32>( dstHeight ), static_cast<int32>( box1.bytesPerRow ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( srcHeight ),
-                        static_cast<int32>( box0.bytesPerRow ), chosenFilter.kernel,
-                        chosenFilter.kernelStartX, chosenFilter.kernelEndX, chosenFilter.kernelStartY,
-                        chosenFilter.kernelEndY, static_cast<uint8>( j ) );
-                }
+                downsampleMip( downsampleJob, numThreads );
             }
             else if( mTextureType == TextureTypes::Type3D )
             {
@@ -1210,13 +1298,7 @@ namespace Ogre
             {
                 if( filter != FILTER_GAUSSIAN_HIGH )
                 {
-                    ( *downsampler2DFunc )(
-                        reinterpret_cast<uint8 *>( box1.data ), reinterpret_cast<uint8 *>( box0.data ),
-                        static_cast<int32>( dstWidth ), static_cast<int32>( dstHeight ),
-                        static_cast<int32>( box1.bytesPerRow ), static_cast<int32>( srcWidth ),
-                        static_cast<int32>( box0.bytesPerRow ), chosenFilter.kernel,
-                        chosenFilter.kernelStartX, chosenFilter.kernelEndX, chosenFilter.kernelStartY,
-                        chosenFilter.kernelEndY );
+                    downsampleMip( downsampleJob, numThreads );
                 }
                 else
                 {
@@ -1244,13 +1326,8 @@ namespace Ogre
                                               separableKernel.kernelEnd );
 
                     // Now that tmpImage0 is blurred, bilinear downsample its contents into box1.
-                    ( *downsampler2DFunc )(
-                        reinterpret_cast<uint8 *>( box1.data ),
-                        reinterpret_cast<uint8 *>( tmpImage0.mBuffer ), static_cast<int32>( dstWidth ),
-                        static_cast<int32>( dstHeight ), static_cast<int32>( box1.bytesPerRow ),
-                        static_cast<int32>( srcWidth ), static_cast<int32>( box0.bytesPerRow ),
-                        chosenFilter.kernel, chosenFilter.kernelStartX, chosenFilter.kernelEndX,
-                        chosenFilter.kernelStartY, chosenFilter.kernelEndY );
+                    downsampleJob.srcData = reinterpret_cast<uint8 *>( tmpImage0.mBuffer );
+                    downsampleMip( downsampleJob, numThreads );
                 }
             }
         }
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgreMatrix3.h"
 
 #include "OgreImageDownsampler.h"
+#include "OgreImageDownsamplerBox.h"
 
 namespace Ogre
 {
@@ -189,6 +190,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_XXXA8888
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<4, 3, false>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XXXA8888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XXXA8888_cube
 #define BLUR_NAME separableBlur_XXXA8888
@@ -199,6 +202,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_B 2
 #define OGRE_TOTAL_SIZE 3
 #define DOWNSAMPLE_NAME downscale2x_XXX888
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<3, -1, false>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XXX888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XXX888_cube
 #define BLUR_NAME separableBlur_XXX888
@@ -208,6 +213,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_G 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_XX88
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<2, -1, false>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XX88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XX88_cube
 #define BLUR_NAME separableBlur_XX88
@@ -216,6 +223,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_X8
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<1, -1, false>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_X8
 #define DOWNSAMPLE_CUBE_NAME downscale2x_X8_cube
 #define BLUR_NAME separableBlur_X8
@@ -224,6 +233,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_A8
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<1, 0, false>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_A8
 #define DOWNSAMPLE_CUBE_NAME downscale2x_A8_cube
 #define BLUR_NAME separableBlur_A8
@@ -233,6 +244,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_XA88
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<2, 1, false>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_XA88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_XA88_cube
 #define BLUR_NAME separableBlur_XA88
@@ -319,6 +332,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_Float32_XXXA
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowF32<4, 3>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XXXA
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XXXA_cube
 #define BLUR_NAME separableBlur_Float32_XXXA
@@ -329,6 +344,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_B 2
 #define OGRE_TOTAL_SIZE 3
 #define DOWNSAMPLE_NAME downscale2x_Float32_XXX
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowF32<3, -1>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XXX
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XXX_cube
 #define BLUR_NAME separableBlur_Float32_XXX
@@ -338,6 +355,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_G 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_Float32_XX
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowF32<2, -1>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XX
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XX_cube
 #define BLUR_NAME separableBlur_Float32_XX
@@ -346,6 +365,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_Float32_X
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowF32<1, -1>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_X
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_X_cube
 #define BLUR_NAME separableBlur_Float32_X
@@ -354,6 +375,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_Float32_A
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowF32<1, 0>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_A
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_A_cube
 #define BLUR_NAME separableBlur_Float32_A
@@ -363,6 +386,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_Float32_XA
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowF32<2, 1>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_Float32_XA
 #define DOWNSAMPLE_CUBE_NAME downscale2x_Float32_XA_cube
 #define BLUR_NAME separableBlur_Float32_XA
@@ -390,6 +415,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_sRGB_XXXA8888
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<4, 3, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_XXXA8888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_XXXA8888_cube
 #define BLUR_NAME separableBlur_sRGB_XXXA8888
@@ -401,6 +428,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_B 3
 #define OGRE_TOTAL_SIZE 4
 #define DOWNSAMPLE_NAME downscale2x_sRGB_AXXX8888
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<4, 0, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_AXXX8888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_AXXX8888_cube
 #define BLUR_NAME separableBlur_sRGB_AXXX8888
@@ -411,6 +440,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_B 2
 #define OGRE_TOTAL_SIZE 3
 #define DOWNSAMPLE_NAME downscale2x_sRGB_XXX888
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<3, -1, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_XXX888
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_XXX888_cube
 #define BLUR_NAME separableBlur_sRGB_XXX888
@@ -420,6 +451,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_G 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_sRGB_XX88
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<2, -1, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_XX88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_XX88_cube
 #define BLUR_NAME separableBlur_sRGB_XX88
@@ -428,6 +461,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_R 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_sRGB_X8
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<1, -1, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_X8
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_X8_cube
 #define BLUR_NAME separableBlur_sRGB_X8
@@ -436,6 +471,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 0
 #define OGRE_TOTAL_SIZE 1
 #define DOWNSAMPLE_NAME downscale2x_sRGB_A8
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<1, 0, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_A8
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_A8_cube
 #define BLUR_NAME separableBlur_sRGB_A8
@@ -445,6 +482,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_A 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_sRGB_XA88
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<2, 1, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_XA88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_XA88_cube
 #define BLUR_NAME separableBlur_sRGB_XA88
@@ -454,6 +493,8 @@ namespace Ogre
 #define OGRE_DOWNSAMPLE_R 1
 #define OGRE_TOTAL_SIZE 2
 #define DOWNSAMPLE_NAME downscale2x_sRGB_AX88
+#define DOWNSAMPLE_BOX_ROW( dst, src0, src1, numPixels ) \
+    DownsampleBox::rowU8<2, 0, true>( dst, src0, src1, numPixels )
 #define DOWNSAMPLE_3D_NAME downscale3D2x_sRGB_AX88
 #define DOWNSAMPLE_CUBE_NAME downscale2x_sRGB_AX88_cube
 #define BLUR_NAME separableBlur_sRGB_AX88
@@ -0,0 +1,588 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2014 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef _OgreImageDownsamplerBox_H_
+#define _OgreImageDownsamplerBox_H_
+
+#include "OgrePrerequisites.h"
+
+#include <math.h>
+
+#if __OGRE_HAVE_SSE
+#    include <emmintrin.h>
+#elif __OGRE_HAVE_NEON
+#    include <arm_neon.h>
+#    if defined( __aarch64__ ) || defined( _M_ARM64 )
+#        define OGRE_DOWNSAMPLE_BOX_NEON_SQRT 1
+#    endif
+#endif
+
+namespace Ogre
+{
+    /** Fast path of the 2D downsamplers for the bilinear filter.
+
+        With the bilinear kernel, every dst pixel except those in the last row and the
+        last column is the average of its 2x2 src pixels. The generic loop in
+        OgreImageDownsamplerImpl.inl still spends most of its time clamping and walking
+        the 5x5 kernel for them, so it hands those rows to these functions instead.
+        Cubemaps and 3D textures don't use them (cubemaps sample rotated directions,
+        not 2x2 blocks).
+
+        The results (including the rounding) are bit-exact with the generic loop:
+            - Colour channels round to nearest: ( sum + 2 ) / 4
+            - The alpha channel rounds up: ( sum + 3 ) / 4
+            - sRGB colour channels are averaged as x * x and converted back with sqrtf
+            - Float alpha keeps the generic loop's ( sum + 4 - 1 ) / 4
+    @tparam N
+        Number of channels.
+    @tparam AlphaIdx
+        Index of the alpha channel. -1 if there is none.
+    @tparam SRgb
+        True to average colour channels in (approximate) linear space.
+    */
+    namespace DownsampleBox
+    {
+        template <int N, int AlphaIdx, bool SRgb>
+        inline void rowU8Scalar( uint8 *dst, const uint8 *src0, const uint8 *src1, int32 x,
+                                 const int32 numPixels )
+        {
+            for( ; x < numPixels; ++x )
+            {
+                for( int c = 0; c < N; ++c )
+                {
+                    const uint32 a = src0[x * 2 * N + c];
+                    const uint32 b = src0[x * 2 * N + N + c];
+                    const uint32 d0 = src1[x * 2 * N + c];
+                    const uint32 d1 = src1[x * 2 * N + N + c];
+
+                    if( c == AlphaIdx )
+                    {
+                        dst[x * N + c] = static_cast<uint8>( ( a + b + d0 + d1 + 3u ) >> 2u );
+                    }
+                    else if( SRgb )
+                    {
+                        const uint32 accum = a * a + b * b + d0 * d0 + d1 * d1;
+                        dst[x * N + c] =
+                            static_cast<uint8>( sqrtf( static_cast<float>( accum ) * 0.25f ) + 0.5f );
+                    }
+                    else
+                    {
+                        dst[x * N + c] = static_cast<uint8>( ( a + b + d0 + d1 + 2u ) >> 2u );
+                    }
+                }
+            }
+        }
+        //-------------------------------------------------------------------------------
+        template <int N, int AlphaIdx>
+        inline void rowF32Scalar( float *dst, const float *src0, const float *src1, int32 x,
+                                  const int32 numPixels )
+        {
+            for( ; x < numPixels; ++x )
+            {
+                for( int c = 0; c < N; ++c )
+                {
+                    // Same order of operations as the generic loop
+                    float accum = 0.0f;
+                    accum += src0[x * 2 * N + c];
+                    accum += src0[x * 2 * N + N + c];
+                    accum += src1[x * 2 * N + c];
+                    accum += src1[x * 2 * N + N + c];
+
+                    if( c == AlphaIdx )
+                        dst[x * N + c] = ( accum + 4.0f - 1.0f ) / 4.0f;
+                    else
+                        dst[x * N + c] = accum * 0.25f + 0.0f;
+                }
+            }
+        }
+
+#if __OGRE_HAVE_SSE
+        /// Loads 16 bytes (16 / N pixels) and splits them into the channels of the even and
+        /// the odd pixels, as 16-bit lanes. N = 3 is not supported.
+        template <int N>
+        struct LoadU8
+        {
+            enum
+            {
+                Supported = 0
+            };
+            static void load( const uint8 *, __m128i &, __m128i & ) {}
+        };
+        template <>
+        struct LoadU8<1>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const uint8 *src, __m128i &outEven, __m128i &outOdd )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src ) );
+                outEven = _mm_and_si128( v, _mm_set1_epi16( 0x00FF ) );
+                outOdd = _mm_srli_epi16( v, 8 );
+            }
+        };
+        template <>
+        struct LoadU8<2>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const uint8 *src, __m128i &outEven, __m128i &outOdd )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src ) );
+                // [P0 P2 P1 P3] & [P4 P6 P5 P7]
+                const __m128i lo =
+                    _mm_shuffle_epi32( _mm_unpacklo_epi8( v, _mm_setzero_si128() ), 0xD8 );
+                const __m128i hi =
+                    _mm_shuffle_epi32( _mm_unpackhi_epi8( v, _mm_setzero_si128() ), 0xD8 );
+                outEven = _mm_unpacklo_epi64( lo, hi );
+                outOdd = _mm_unpackhi_epi64( lo, hi );
+            }
+        };
+        template <>
+        struct LoadU8<4>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const uint8 *src, __m128i &outEven, __m128i &outOdd )
+            {
+                const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i *>( src ) );
+                const __m128i lo = _mm_unpacklo_epi8( v, _mm_setzero_si128() );
+                const __m128i hi = _mm_unpackhi_epi8( v, _mm_setzero_si128() );
+                outEven = _mm_unpacklo_epi64( lo, hi );
+                outOdd = _mm_unpackhi_epi64( lo, hi );
+            }
+        };
+
+        /// Returns the number of pixels processed
+        template <int N, int AlphaIdx, bool SRgb>
+        inline int32 rowU8Simd( uint8 *dst, const uint8 *src0, const uint8 *src1,
+                                const int32 numPixels )
+        {
+            if( !LoadU8<N>::Supported )
+                return 0;
+
+            const int32 pixelsPerIter = 8 / N;
+
+            int16 laneMask[8];
+            for( int i = 0; i < 8; ++i )
+                laneMask[i] = ( i % N ) == AlphaIdx ? -1 : 0;
+            const __m128i alphaMask =
+                _mm_loadu_si128( reinterpret_cast<const __m128i *>( laneMask ) );
+            // 2 for colour, 3 for alpha
+            const __m128i bias = _mm_sub_epi16( _mm_set1_epi16( 2 ), alphaMask );
+
+            int32 x = 0;
+            for( ; x + pixelsPerIter <= numPixels; x += pixelsPerIter )
+            {
+                __m128i a, b, c, d;
+                LoadU8<N>::load( src0 + x * 2 * N, a, b );
+                LoadU8<N>::load( src1 + x * 2 * N, c, d );
+
+                const __m128i sum = _mm_add_epi16( _mm_add_epi16( a, b ), _mm_add_epi16( c, d ) );
+                __m128i result = _mm_srli_epi16( _mm_add_epi16( sum, bias ), 2 );
+
+                if( SRgb )
+                {
+                    const __m128i zero = _mm_setzero_si128();
+                    // x * x <= 65025 fits in 16 bits, but the sum of 4 doesn't
+                    a = _mm_mullo_epi16( a, a );
+                    b = _mm_mullo_epi16( b, b );
+                    c = _mm_mullo_epi16( c, c );
+                    d = _mm_mullo_epi16( d, d );
+                    const __m128i sqLo = _mm_add_epi32(
+                        _mm_add_epi32( _mm_unpacklo_epi16( a, zero ), _mm_unpacklo_epi16( b, zero ) ),
+                        _mm_add_epi32( _mm_unpacklo_epi16( c, zero ), _mm_unpacklo_epi16( d, zero ) ) );
+                    const __m128i sqHi = _mm_add_epi32(
+                        _mm_add_epi32( _mm_unpackhi_epi16( a, zero ), _mm_unpackhi_epi16( b, zero ) ),
+                        _mm_add_epi32( _mm_unpackhi_epi16( c, zero ), _mm_unpackhi_epi16( d, zero ) ) );
+
+                    const __m128 quarter = _mm_set1_ps( 0.25f );
+                    const __m128 half = _mm_set1_ps( 0.5f );
+                    const __m128 gammaLo = _mm_add_ps(
+                        _mm_sqrt_ps( _mm_mul_ps( _mm_cvtepi32_ps( sqLo ), quarter ) ), half );
+                    const __m128 gammaHi = _mm_add_ps(
+                        _mm_sqrt_ps( _mm_mul_ps( _mm_cvtepi32_ps( sqHi ), quarter ) ), half );
+                    const __m128i gamma =
+                        _mm_packs_epi32( _mm_cvttps_epi32( gammaLo ), _mm_cvttps_epi32( gammaHi ) );
+
+                    result = _mm_or_si128( _mm_and_si128( alphaMask, result ),
+                                           _mm_andnot_si128( alphaMask, gamma ) );
+                }
+
+                _mm_storel_epi64( reinterpret_cast<__m128i *>( dst + x * N ),
+                                  _mm_packus_epi16( result, result ) );
+            }
+
+            return x;
+        }
+        //-------------------------------------------------------------------------------
+        /// Loads 8 floats (8 / N pixels) and splits them into the channels of the even and
+        /// the odd pixels. N = 3 is not supported.
+        template <int N>
+        struct LoadF32
+        {
+            enum
+            {
+                Supported = 0
+            };
+            static void load( const float *, __m128 &, __m128 & ) {}
+        };
+        template <>
+        struct LoadF32<1>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const float *src, __m128 &outEven, __m128 &outOdd )
+            {
+                const __m128 lo = _mm_loadu_ps( src );
+                const __m128 hi = _mm_loadu_ps( src + 4 );
+                outEven = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+                outOdd = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+            }
+        };
+        template <>
+        struct LoadF32<2>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const float *src, __m128 &outEven, __m128 &outOdd )
+            {
+                const __m128 lo = _mm_loadu_ps( src );
+                const __m128 hi = _mm_loadu_ps( src + 4 );
+                outEven = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 1, 0, 1, 0 ) );
+                outOdd = _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 2, 3, 2 ) );
+            }
+        };
+        template <>
+        struct LoadF32<4>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const float *src, __m128 &outEven, __m128 &outOdd )
+            {
+                outEven = _mm_loadu_ps( src );
+                outOdd = _mm_loadu_ps( src + 4 );
+            }
+        };
+
+        /// Returns the number of pixels processed
+        template <int N, int AlphaIdx>
+        inline int32 rowF32Simd( float *dst, const float *src0, const float *src1,
+                                 const int32 numPixels )
+        {
+            if( !LoadF32<N>::Supported )
+                return 0;
+
+            const int32 pixelsPerIter = 4 / N;
+
+            int32 laneMask[4];
+            for( int i = 0; i < 4; ++i )
+                laneMask[i] = ( i % N ) == AlphaIdx ? -1 : 0;
+            const __m128 alphaMask =
+                _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i *>( laneMask ) ) );
+
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps( 1.0f );
+            const __m128 four = _mm_set1_ps( 4.0f );
+            const __m128 quarter = _mm_set1_ps( 0.25f );
+
+            int32 x = 0;
+            for( ; x + pixelsPerIter <= numPixels; x += pixelsPerIter )
+            {
+                __m128 a, b, c, d;
+                LoadF32<N>::load( src0 + x * 2 * N, a, b );
+                LoadF32<N>::load( src1 + x * 2 * N, c, d );
+
+                // Same order of operations as the generic loop
+                const __m128 sum =
+                    _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_add_ps( zero, a ), b ), c ), d );
+                const __m128 colour = _mm_add_ps( _mm_mul_ps( sum, quarter ), zero );
+                const __m128 alpha =
+                    _mm_mul_ps( _mm_sub_ps( _mm_add_ps( sum, four ), one ), quarter );
+
+                _mm_storeu_ps( dst + x * N, _mm_or_ps( _mm_and_ps( alphaMask, alpha ),
+                                                       _mm_andnot_ps( alphaMask, colour ) ) );
+            }
+
+            return x;
+        }
+#elif __OGRE_HAVE_NEON
+        /// Loads 16 pixels and deinterleaves them, one register per channel.
+        template <int N>
+        struct LoadU8;
+        template <>
+        struct LoadU8<1>
+        {
+            static void load( const uint8 *src, uint8x16_t *out ) { out[0] = vld1q_u8( src ); }
+            static void store( uint8 *dst, const uint8x8_t *in ) { vst1_u8( dst, in[0] ); }
+        };
+        template <>
+        struct LoadU8<2>
+        {
+            static void load( const uint8 *src, uint8x16_t *out )
+            {
+                const uint8x16x2_t v = vld2q_u8( src );
+                out[0] = v.val[0];
+                out[1] = v.val[1];
+            }
+            static void store( uint8 *dst, const uint8x8_t *in )
+            {
+                uint8x8x2_t v;
+                v.val[0] = in[0];
+                v.val[1] = in[1];
+                vst2_u8( dst, v );
+            }
+        };
+        template <>
+        struct LoadU8<3>
+        {
+            static void load( const uint8 *src, uint8x16_t *out )
+            {
+                const uint8x16x3_t v = vld3q_u8( src );
+                out[0] = v.val[0];
+                out[1] = v.val[1];
+                out[2] = v.val[2];
+            }
+            static void store( uint8 *dst, const uint8x8_t *in )
+            {
+                uint8x8x3_t v;
+                v.val[0] = in[0];
+                v.val[1] = in[1];
+                v.val[2] = in[2];
+                vst3_u8( dst, v );
+            }
+        };
+        template <>
+        struct LoadU8<4>
+        {
+            static void load( const uint8 *src, uint8x16_t *out )
+            {
+                const uint8x16x4_t v = vld4q_u8( src );
+                out[0] = v.val[0];
+                out[1] = v.val[1];
+                out[2] = v.val[2];
+                out[3] = v.val[3];
+            }
+            static void store( uint8 *dst, const uint8x8_t *in )
+            {
+                uint8x8x4_t v;
+                v.val[0] = in[0];
+                v.val[1] = in[1];
+                v.val[2] = in[2];
+                v.val[3] = in[3];
+                vst4_u8( dst, v );
+            }
+        };
+
+        /// Returns the number of pixels processed
+        template <int N, int AlphaIdx, bool SRgb>
+        inline int32 rowU8Simd( uint8 *dst, const uint8 *src0, const uint8 *src1,
+                                const int32 numPixels )
+        {
+#    ifndef OGRE_DOWNSAMPLE_BOX_NEON_SQRT
+            // vsqrtq_f32 is AArch64-only
+            if( SRgb && !( N == 1 && AlphaIdx == 0 ) )
+                return 0;
+#    endif
+
+            int32 x = 0;
+            for( ; x + 8 <= numPixels; x += 8 )
+            {
+                uint8x16_t row0[N], row1[N];
+                uint8x8_t result[N];
+                LoadU8<N>::load( src0 + x * 2 * N, row0 );
+                LoadU8<N>::load( src1 + x * 2 * N, row1 );
+
+                for( int c = 0; c < N; ++c )
+                {
+                    if( !SRgb || c == AlphaIdx )
+                    {
+                        uint16x8_t sum = vpadalq_u8( vpaddlq_u8( row0[c] ), row1[c] );
+                        sum = vaddq_u16( sum, vdupq_n_u16( c == AlphaIdx ? 3u : 2u ) );
+                        result[c] = vshrn_n_u16( sum, 2 );
+                    }
+#    ifdef OGRE_DOWNSAMPLE_BOX_NEON_SQRT
+                    else
+                    {
+                        const uint8x8_t lo0 = vget_low_u8( row0[c] );
+                        const uint8x8_t hi0 = vget_high_u8( row0[c] );
+                        const uint8x8_t lo1 = vget_low_u8( row1[c] );
+                        const uint8x8_t hi1 = vget_high_u8( row1[c] );
+                        const uint32x4_t sqLo =
+                            vpadalq_u16( vpaddlq_u16( vmull_u8( lo0, lo0 ) ), vmull_u8( lo1, lo1 ) );
+                        const uint32x4_t sqHi =
+                            vpadalq_u16( vpaddlq_u16( vmull_u8( hi0, hi0 ) ), vmull_u8( hi1, hi1 ) );
+                        const float32x4_t gammaLo = vaddq_f32(
+                            vsqrtq_f32( vmulq_n_f32( vcvtq_f32_u32( sqLo ), 0.25f ) ),
+                            vdupq_n_f32( 0.5f ) );
+                        const float32x4_t gammaHi = vaddq_f32(
+                            vsqrtq_f32( vmulq_n_f32( vcvtq_f32_u32( sqHi ), 0.25f ) ),
+                            vdupq_n_f32( 0.5f ) );
+                        result[c] = vmovn_u16( vcombine_u16( vmovn_u32( vcvtq_u32_f32( gammaLo ) ),
+                                                             vmovn_u32( vcvtq_u32_f32( gammaHi ) ) ) );
+                    }
+#    endif
+                }
+
+                LoadU8<N>::store( dst + x * N, result );
+            }
+
+            return x;
+        }
+        //-------------------------------------------------------------------------------
+        /// Loads 8 floats (8 / N pixels) and splits them into the channels of the even and
+        /// the odd pixels. N = 3 is not supported.
+        template <int N>
+        struct LoadF32
+        {
+            enum
+            {
+                Supported = 0
+            };
+            static void load( const float *, float32x4_t &, float32x4_t & ) {}
+        };
+        template <>
+        struct LoadF32<1>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const float *src, float32x4_t &outEven, float32x4_t &outOdd )
+            {
+                const float32x4x2_t v = vuzpq_f32( vld1q_f32( src ), vld1q_f32( src + 4 ) );
+                outEven = v.val[0];
+                outOdd = v.val[1];
+            }
+        };
+        template <>
+        struct LoadF32<2>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const float *src, float32x4_t &outEven, float32x4_t &outOdd )
+            {
+                const float32x4_t lo = vld1q_f32( src );
+                const float32x4_t hi = vld1q_f32( src + 4 );
+                outEven = vcombine_f32( vget_low_f32( lo ), vget_low_f32( hi ) );
+                outOdd = vcombine_f32( vget_high_f32( lo ), vget_high_f32( hi ) );
+            }
+        };
+        template <>
+        struct LoadF32<4>
+        {
+            enum
+            {
+                Supported = 1
+            };
+            static void load( const float *src, float32x4_t &outEven, float32x4_t &outOdd )
+            {
+                outEven = vld1q_f32( src );
+                outOdd = vld1q_f32( src + 4 );
+            }
+        };
+
+        /// Returns the number of pixels processed
+        template <int N, int AlphaIdx>
+        inline int32 rowF32Simd( float *dst, const float *src0, const float *src1,
+                                 const int32 numPixels )
+        {
+            if( !LoadF32<N>::Supported )
+                return 0;
+
+            const int32 pixelsPerIter = 4 / N;
+
+            uint32 laneMask[4];
+            for( int i = 0; i < 4; ++i )
+                laneMask[i] = ( i % N ) == AlphaIdx ? 0xFFFFFFFFu : 0u;
+            const uint32x4_t alphaMask = vld1q_u32( laneMask );
+
+            const float32x4_t zero = vdupq_n_f32( 0.0f );
+
+            int32 x = 0;
+            for( ; x + pixelsPerIter <= numPixels; x += pixelsPerIter )
+            {
+                float32x4_t a, b, c, d;
+                LoadF32<N>::load( src0 + x * 2 * N, a, b );
+                LoadF32<N>::load( src1 + x * 2 * N, c, d );
+
+                // Same order of operations as the generic loop
+                const float32x4_t sum =
+                    vaddq_f32( vaddq_f32( vaddq_f32( vaddq_f32( zero, a ), b ), c ), d );
+                const float32x4_t colour = vaddq_f32( vmulq_n_f32( sum, 0.25f ), zero );
+                const float32x4_t alpha = vmulq_n_f32(
+                    vsubq_f32( vaddq_f32( sum, vdupq_n_f32( 4.0f ) ), vdupq_n_f32( 1.0f ) ), 0.25f );
+
+                vst1q_f32( dst + x * N, vbslq_f32( alphaMask, alpha, colour ) );
+            }
+
+            return x;
+        }
+#else
+        template <int N, int AlphaIdx, bool SRgb>
+        inline int32 rowU8Simd( uint8 *, const uint8 *, const uint8 *, const int32 )
+        {
+            return 0;
+        }
+        template <int N, int AlphaIdx>
+        inline int32 rowF32Simd( float *, const float *, const float *, const int32 )
+        {
+            return 0;
+        }
+#endif
+        //-------------------------------------------------------------------------------
+        /// Averages numPixels dst pixels from the 2x2 src pixels in rows src0 & src1
+        template <int N, int AlphaIdx, bool SRgb>
+        inline void rowU8( uint8 *dst, const uint8 *src0, const uint8 *src1, const int32 numPixels )
+        {
+            const int32 x = rowU8Simd<N, AlphaIdx, SRgb>( dst, src0, src1, numPixels );
+            rowU8Scalar<N, AlphaIdx, SRgb>( dst, src0, src1, x, numPixels );
+        }
+        //-------------------------------------------------------------------------------
+        template <int N, int AlphaIdx>
+        inline void rowF32( float *dst, const float *src0, const float *src1, const int32 numPixels )
+        {
+            const int32 x = rowF32Simd<N, AlphaIdx>( dst, src0, src1, numPixels );
+            rowF32Scalar<N, AlphaIdx>( dst, src0, src1, x, numPixels );
+        }
+    }  // namespace DownsampleBox
+}  // namespace Ogre
+
+#endif
@@ -34,7 +34,8 @@ namespace Ogre
     void DOWNSAMPLE_NAME( uint8 *_dstPtr, uint8 const *_srcPtr, int32 dstWidth, int32 dstHeight,
                           int32 dstBytesPerRow, int32 srcWidth, int32 srcBytesPerRow,
                           const uint8 kernel[5][5], const int8 kernelStartX, const int8 kernelEndX,
-                          const int8 kernelStartY, const int8 kernelEndY )
+                          const int8 kernelStartY, const int8 kernelEndY, int32 dstRowStart,
+                          int32 dstRowEnd )
     {
         OGRE_UINT8 *dstPtr = reinterpret_cast<OGRE_UINT8 *>( _dstPtr );
         OGRE_UINT8 const *srcPtr = reinterpret_cast<OGRE_UINT8 const *>( _srcPtr );
@@ -45,9 +46,29 @@ namespace Ogre
         int32 srcBytesPerRowSkip = srcBytesPerRow - srcWidth * OGRE_TOTAL_SIZE;
         int32 dstBytesPerRowSkip = dstBytesPerRow - dstWidth * OGRE_TOTAL_SIZE;
 
-        for( int32 y = 0; y < dstHeight; ++y )
+        dstPtr += dstRowStart * dstBytesPerRow;
+        srcPtr += dstRowStart * 2 * srcBytesPerRow;
+
+#ifdef DOWNSAMPLE_BOX_ROW
+        const bool bBoxFilter = kernelStartX == 0 && kernelEndX == 1 && kernelStartY == 0 &&
+                                kernelEndY == 1 && kernel[2][2] == 1u && kernel[2][3] == 1u &&
+                                kernel[3][2] == 1u && kernel[3][3] == 1u;
+#endif
+
+        for( int32 y = dstRowStart; y < dstRowEnd; ++y )
         {
-            for( int32 x = 0; x < dstWidth; ++x )
+            int32 x = 0;
+#ifdef DOWNSAMPLE_BOX_ROW
+            if( bBoxFilter && y + 1 < dstHeight )
+            {
+                // All but the last column average 2x2 pixels. See DownsampleBox
+                x = dstWidth - 1;
+                DOWNSAMPLE_BOX_ROW( dstPtr, srcPtr, srcPtr + srcBytesPerRow, x );
+                dstPtr += x * OGRE_TOTAL_SIZE;
+                srcPtr += x * OGRE_TOTAL_SIZE * 2;
+            }
+#endif
+            for( ; x < dstWidth; ++x )
             {
                 int kStartY = std::max<int>( -y, kernelStartY );
                 int kEndY = std::min<int>( dstHeight - y - 1, kernelEndY );
@@ -246,7 +267,7 @@ namespace Ogre
                                int32 dstBytesPerRow, int32 srcWidth, int32 srcHeight,
                                int32 srcBytesPerRow, const uint8 kernel[5][5], const int8 kernelStartX,
                                const int8 kernelEndX, const int8 kernelStartY, const int8 kernelEndY,
-                               uint8 currentFace )
+                               uint8 currentFace, int32 dstRowStart, int32 dstRowEnd )
     {
         OGRE_UINT8 *dstPtr = reinterpret_cast<OGRE_UINT8 *>( _dstPtr );
         OGRE_UINT8 const **allPtr = reinterpret_cast<OGRE_UINT8 const **>( _allPtr );
@@ -280,7 +301,11 @@ namespace Ogre
 
         OGRE_UINT8 const *srcPtr = 0;
 
-        for( int32 y = 0; y < dstHeight; ++y )
+        dstPtr += dstRowStart * dstBytesPerRow;
+
+        // No DOWNSAMPLE_BOX_ROW here: the kernel taps are rotated directions projected back
+        // onto the faces, which don't land on the 2x2 src pixels (not even with the box kernel)
+        for( int32 y = dstRowStart; y < dstRowEnd; ++y )
         {
             for( int32 x = 0; x < dstWidth; ++x )
             {
@@ -703,3 +728,6 @@ namespace Ogre
 #undef DOWNSAMPLE_CUBE_NAME
 #undef BLUR_NAME
 #undef OGRE_TOTAL_SIZE
+#ifdef DOWNSAMPLE_BOX_ROW
+#    undef DOWNSAMPLE_BOX_ROW
+#endif
@@ -73,6 +73,15 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void Item::meshLodResidencyChanged( Mesh *mesh )
+    {
+        for( SubItem &subitem : mSubItems )
+            subitem._updateVaosFromSubMesh();
+
+        // Evicted LODs must not get rendered even if our LOD doesn't get updated again
+        mCurrentMeshLod = std::max( mCurrentMeshLod, mLodMeshStreaming->firstResidentLod );
+    }
+    //-----------------------------------------------------------------------
     void Item::_initialise( bool forceReinitialise /*= false*/, bool bUseMeshMat /*= true */ )
     {
         vector<String>::type prevMaterialsList;
@@ -108,6 +117,12 @@ namespace Ogre
         }
 
         mLodMesh = mMesh->_getLodValueArray();
+        mLodMeshStreaming = mMesh->_getLodStreamingState();
+        if( mLodMeshStreaming )
+        {
+            mCurrentMeshLod = mLodMeshStreaming->firstResidentLod;
+            mMesh->_addLodStreamingListener( this );
+        }
 
         // Build main subItem list
         buildSubItems( prevMaterialsList.empty() ? 0 : &prevMaterialsList, bUseMeshMat );
@@ -144,6 +159,12 @@ namespace Ogre
         mSubItems.clear();
         mRenderables.clear();
 
+        if( mLodMeshStreaming )
+        {
+            mMesh->_removeLodStreamingListener( this );
+            mLodMeshStreaming = 0;
+        }
+
         // If mesh is skeletally animated: destroy instance
         assert( mManager || !mSkeletonInstance );
         if( mSkeletonInstance )
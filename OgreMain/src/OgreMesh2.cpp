@@ -31,6 +31,7 @@ THE SOFTWARE.
 
 #include "Animation/OgreSkeletonDef.h"
 #include "Animation/OgreSkeletonManager.h"
+#include "Math/Array/OgreTriangleBvh.h"
 #include "OgreException.h"
 #include "OgreHardwareBufferManager.h"
 #include "OgreIteratorWrappers.h"
@@ -54,6 +55,8 @@ namespace Ogre
 {
     bool Mesh::msOptimizeForShadowMapping = false;
     bool Mesh::msUseTimestampAsHash = false;
+    uint32 Mesh::msBuildClustersOnLoad = 0u;
+    bool Mesh::msLodStreaming = false;
 
     //-----------------------------------------------------------------------
     Mesh::Mesh( ResourceManager *creator, const String &name, ResourceHandle handle, const String &group,
@@ -61,6 +64,9 @@ namespace Ogre
         Resource( creator, name, handle, group, isManual, loader ),
         mBoundRadius( 0.0f ),
         mLodStrategyName( LodStrategyManager::getSingleton().getDefaultStrategy()->getName() ),
+        mLodStreaming( 0 ),
+        mTriangleBvh( 0 ),
+        mTriangleBvhLod( 0 ),
         mVaoManager( vaoManager ),
         mVertexBufferDefaultType( BT_IMMUTABLE ),
         mIndexBufferDefaultType( BT_IMMUTABLE ),
@@ -93,6 +99,7 @@ namespace Ogre
 
         index = std::min( index, mSubMeshes.size() );
         mSubMeshes.insert( mSubMeshes.begin() + static_cast<ptrdiff_t>( index ), sub );
+        _discardTriangleBvh();
 
         if( isLoaded() )
             _dirtyState();
@@ -111,6 +118,7 @@ namespace Ogre
         OGRE_DELETE *itor;
 
         mSubMeshes.erase( itor );
+        _discardTriangleBvh();
 
         if( isLoaded() )
             _dirtyState();
@@ -157,8 +165,9 @@ namespace Ogre
 
         mFreshFromDisk = ResourceGroupManager::getSingleton().openResource( mName, mGroup, true, this );
 
-        // fully prebuffer into host RAM
-        mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
+        // fully prebuffer into host RAM (unless it's already there, e.g. memory-mapped)
+        if( !mFreshFromDisk->getDataPtr() )
+            mFreshFromDisk = DataStreamPtr( OGRE_NEW MemoryDataStream( mName, mFreshFromDisk ) );
     }
     //-----------------------------------------------------------------------
     void Mesh::unprepareImpl() { mFreshFromDisk.reset(); }
@@ -183,6 +192,15 @@ namespace Ogre
 
         serializer.importMesh( data, this );
 
+        if( msBuildClustersOnLoad != 0u && !mLodStreaming )
+        {
+            for( SubMesh *submesh : mSubMeshes )
+            {
+                if( submesh->mClusters.empty() )
+                    submesh->buildClusters( msBuildClustersOnLoad );
+            }
+        }
+
         if( mHashForCaches[0] == 0u && mHashForCaches[1] == 0u && Mesh::msUseTimestampAsHash )
         {
             try
@@ -205,11 +223,24 @@ namespace Ogre
     {
         OgreProfileExhaustive( "Mesh2::unloadImpl" );
 
+        _discardTriangleBvh();
+
         // Teardown submeshes
         for( SubMesh *submesh : mSubMeshes )
             OGRE_DELETE submesh;
 
         mSubMeshes.clear();
+
+        if( mLodStreaming )
+        {
+            MeshManager *meshManager = MeshManager::getSingletonPtr();
+            if( meshManager )
+                meshManager->_removeLodStreamingMesh( this );
+            OGRE_DELETE_T( mLodStreaming, MeshLodStreamingInfo, MEMCATEGORY_RESOURCE );
+            mLodStreaming = 0;
+            mLodStreamingState.firstResidentLod = 0u;
+            mLodStreamingState.requestedLod.store( 255u, std::memory_order_relaxed );
+        }
 #if !OGRE_NO_MESHLOD
         // Removes all LOD data
         removeLodLevels();
@@ -470,6 +501,13 @@ namespace Ogre
                 while( itVao != enVao )
                 {
                     VertexArrayObject *vao = *itVao;
+                    if( itVao != submesh->mVao[i].begin() && vao == *( itVao - 1 ) )
+                    {
+                        // Non-resident streamed LOD (see msLodStreaming)
+                        ++itVao;
+                        continue;
+                    }
+
                     VertexBufferPackedVec::const_iterator itVertexBuf = vao->getVertexBuffers().begin();
                     VertexBufferPackedVec::const_iterator enVertexBuf = vao->getVertexBuffers().end();
 
@@ -563,16 +601,147 @@ namespace Ogre
     //---------------------------------------------------------------------
     void Mesh::arrangeEfficient( bool halfPos, bool halfTexCoords, bool qTangents )
     {
+        _discardTriangleBvh();
         for( SubMesh *submesh : mSubMeshes )
             submesh->arrangeEfficient( halfPos, halfTexCoords, qTangents );
     }
     //---------------------------------------------------------------------
     void Mesh::dearrangeToInefficient()
     {
+        _discardTriangleBvh();
         for( SubMesh *submesh : mSubMeshes )
             submesh->dearrangeToInefficient();
     }
     //---------------------------------------------------------------------
+    MeshOptimizer::Report Mesh::optimizeGeometry( uint32 flags, float overdrawThreshold )
+    {
+        OgreProfileExhaustive( "Mesh2::optimizeGeometry" );
+
+        _discardTriangleBvh();
+
+        MeshOptimizer::Report report;
+        for( SubMesh *submesh : mSubMeshes )
+            report.merge( submesh->optimizeGeometry( flags, overdrawThreshold ) );
+        return report;
+    }
+    //---------------------------------------------------------------------
+    void Mesh::buildClusters( uint32 maxTriangles )
+    {
+        OgreProfileExhaustive( "Mesh2::buildClusters" );
+
+        for( SubMesh *submesh : mSubMeshes )
+            submesh->buildClusters( maxTriangles );
+    }
+    //---------------------------------------------------------------------
+    const TriangleBvh *Mesh::_getTriangleBvh()
+    {
+        // Stale if a finer LOD became resident. Evicting finer LODs doesn't invalidate it
+        const uint8 firstResidentLod = getFirstResidentLod();
+        if( mTriangleBvh && mTriangleBvhLod <= firstResidentLod )
+            return mTriangleBvh;
+
+        OgreProfileExhaustive( "Mesh2::_getTriangleBvh" );
+
+        if( !mTriangleBvh )
+            mTriangleBvh = OGRE_NEW TriangleBvh();
+
+        mTriangleBvhSubMeshStarts.clear();
+        uint32 numTriangles = 0u;
+        for( const SubMesh *submesh : mSubMeshes )
+        {
+            mTriangleBvhSubMeshStarts.push_back( numTriangles );
+            numTriangles += static_cast<uint32>( submesh->_addTrianglesToBvh( *mTriangleBvh ) );
+        }
+
+        mTriangleBvh->build();
+        mTriangleBvhLod = firstResidentLod;
+
+        return mTriangleBvh;
+    }
+    //---------------------------------------------------------------------
+    void Mesh::_getTriangleBvhSubMesh( uint32 triangleIdx, uint32 &outSubMeshIdx,
+                                       uint32 &outTriangleIdx ) const
+    {
+        OGRE_ASSERT_LOW( !mTriangleBvhSubMeshStarts.empty() );
+
+        // SubMeshes without triangles share their start with the next one
+        FastArray<uint32>::const_iterator itor = std::upper_bound(
+            mTriangleBvhSubMeshStarts.begin(), mTriangleBvhSubMeshStarts.end(), triangleIdx );
+        outSubMeshIdx = static_cast<uint32>( itor - mTriangleBvhSubMeshStarts.begin() ) - 1u;
+        outTriangleIdx = triangleIdx - mTriangleBvhSubMeshStarts[outSubMeshIdx];
+    }
+    //---------------------------------------------------------------------
+    void Mesh::_discardTriangleBvh()
+    {
+        OGRE_DELETE mTriangleBvh;
+        mTriangleBvh = 0;
+        mTriangleBvhSubMeshStarts.clear();
+    }
+    //---------------------------------------------------------------------
+    void Mesh::_addLodStreamingListener( LodStreamingListener *listener )
+    {
+        mLodStreamingListeners.push_back( listener );
+    }
+    //---------------------------------------------------------------------
+    void Mesh::_removeLodStreamingListener( LodStreamingListener *listener )
+    {
+        LodStreamingListenerVec::iterator itor =
+            std::find( mLodStreamingListeners.begin(), mLodStreamingListeners.end(), listener );
+        if( itor != mLodStreamingListeners.end() )
+            efficientVectorRemove( mLodStreamingListeners, itor );
+    }
+    //---------------------------------------------------------------------
+    void Mesh::_setFirstResidentLod( uint8 firstLod )
+    {
+        OGRE_ASSERT_LOW( mLodStreaming && firstLod < mLodStreaming->numLods );
+
+        const uint8 numVaoPasses = mLodStreaming->numVaoPasses;
+
+        for( SubMesh *submesh : mSubMeshes )
+        {
+            for( uint8 i = 0; i < numVaoPasses; ++i )
+            {
+                VertexArrayObjectArray &vaos = submesh->mVao[i];
+                std::fill( vaos.begin(), vaos.begin() + firstLod, vaos[firstLod] );
+            }
+
+            if( numVaoPasses == 1u )
+                submesh->mVao[VpShadow] = submesh->mVao[VpNormal];
+        }
+
+        mLodStreamingState.firstResidentLod = firstLod;
+
+        for( LodStreamingListener *listener : mLodStreamingListeners )
+            listener->meshLodResidencyChanged( this );
+    }
+    //---------------------------------------------------------------------
+    size_t Mesh::_evictLodStep()
+    {
+        const uint8 firstLod = mLodStreamingState.firstResidentLod;
+        const size_t stepIdx = mLodStreaming->getStepIdx( firstLod );
+
+        OGRE_ASSERT_LOW( stepIdx + 1u < mLodStreaming->stepLods.size() &&
+                         "Can't evict the coarsest LOD step" );
+
+        const uint8 endLod = mLodStreaming->stepLods[stepIdx + 1u];
+
+        // Grab the Vaos before _setFirstResidentLod overwrites them
+        VertexArrayObjectArray evictedVaos;
+        for( SubMesh *submesh : mSubMeshes )
+        {
+            for( uint8 i = 0; i < mLodStreaming->numVaoPasses; ++i )
+            {
+                evictedVaos.appendPOD( submesh->mVao[i].begin() + firstLod,
+                                       submesh->mVao[i].begin() + endLod );
+            }
+        }
+
+        _setFirstResidentLod( endLod );
+        SubMesh::destroyVaos( evictedVaos, mVaoManager );
+
+        return mLodStreaming->stepBytes[stepIdx];
+    }
+    //---------------------------------------------------------------------
     void Mesh::prepareForShadowMapping( bool forceSameBuffers )
     {
         OgreProfileExhaustive( "Mesh2::prepareForShadowMapping" );
@@ -0,0 +1,668 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "OgreStableHeaders.h"
+
+#include "OgreMesh2Optimizer.h"
+
+#include "OgreMatrix4.h"
+#include "OgrePlane.h"
+#include "OgreVector3.h"
+#include "ogrestd/vector.h"
+
+#include <algorithm>
+
+namespace Ogre
+{
+    static const uint32 c_invalidIndex = 0xFFFFFFFF;
+
+    // Forsyth's vertex scoring parameters. The cache size is the one the algorithm
+    // targets, and works well for GPUs with smaller (or no strict FIFO) caches.
+    static const uint32 c_forsythCacheSize = 32u;
+    static const float c_forsythCacheDecayPower = 1.5f;
+    static const float c_forsythLastTriScore = 0.75f;
+    static const float c_forsythValenceBoostScale = 2.0f;
+    static const float c_forsythValenceBoostPower = 0.5f;
+    //-------------------------------------------------------------------------
+    static float forsythVertexScore( int32 cachePos, uint32 numLiveTris )
+    {
+        if( numLiveTris == 0u )
+            return -1.0f;  // No triangle needs this vertex anymore
+
+        float score = 0.0f;
+        if( cachePos >= 0 )
+        {
+            if( cachePos < 3 )
+            {
+                // Used by the last triangle. Fixed score so the algorithm doesn't favour
+                // the vertices of the previous triangle over the ones before
+                score = c_forsythLastTriScore;
+            }
+            else
+            {
+                const float scaler = 1.0f / float( c_forsythCacheSize - 3u );
+                score = 1.0f - float( cachePos - 3 ) * scaler;
+                score = std::pow( score, c_forsythCacheDecayPower );
+            }
+        }
+
+        // Boost vertices with few triangles left so that they get finished
+        // instead of leaving lone triangles behind
+        score += c_forsythValenceBoostScale *
+                 std::pow( float( numLiveTris ), -c_forsythValenceBoostPower );
+        return score;
+    }
+    //-------------------------------------------------------------------------
+    /// Simulates a FIFO cache: a vertex is in the cache if it got inserted
+    /// less than cacheSize misses ago. Returns the number of misses.
+    static inline uint32 simulateFifoCache( const uint32 *triangle, vector<uint32>::type &timestamps,
+                                            uint32 &timestamp, uint32 cacheSize )
+    {
+        uint32 numMisses = 0u;
+        for( size_t i = 0u; i < 3u; ++i )
+        {
+            const uint32 vertexIdx = triangle[i];
+            if( timestamp - timestamps[vertexIdx] > cacheSize )
+            {
+                timestamps[vertexIdx] = timestamp++;
+                ++numMisses;
+            }
+        }
+        return numMisses;
+    }
+    //-------------------------------------------------------------------------
+    static inline Vector3 getPosition( const float *positions, size_t vertexIdx )
+    {
+        return Vector3( positions[vertexIdx * 3u + 0u], positions[vertexIdx * 3u + 1u],
+                        positions[vertexIdx * 3u + 2u] );
+    }
+    //-------------------------------------------------------------------------
+    /// Unit normal of the triangle, or zero if it's degenerate
+    static Vector3 getTriangleNormal( const float *positions, const uint32 *triangle )
+    {
+        const Vector3 p0 = getPosition( positions, triangle[0] );
+        const Vector3 p1 = getPosition( positions, triangle[1] );
+        const Vector3 p2 = getPosition( positions, triangle[2] );
+        Vector3 normal = ( p1 - p0 ).crossProduct( p2 - p0 );
+        const Real length = normal.length();
+        return length > Real( 1e-12 ) ? normal / length : Vector3::ZERO;
+    }
+    //-------------------------------------------------------------------------
+    /// Calculates the bounding sphere & normal cone of triangles [triStart; triEnd)
+    static void addCluster( const uint32 *indices, const float *positions, size_t triStart,
+                            size_t triEnd, MeshClusterArray &outClusters )
+    {
+        Vector3 vMin( getPosition( positions, indices[triStart * 3u] ) );
+        Vector3 vMax( vMin );
+        Vector3 normalSum( Vector3::ZERO );
+        for( size_t i = triStart * 3u; i < triEnd * 3u; ++i )
+        {
+            const Vector3 pos = getPosition( positions, indices[i] );
+            vMin.makeFloor( pos );
+            vMax.makeCeil( pos );
+        }
+        for( size_t i = triStart; i < triEnd; ++i )
+            normalSum += getTriangleNormal( positions, indices + i * 3u );
+
+        MeshCluster cluster;
+        cluster.center = ( vMin + vMax ) * Real( 0.5 );
+        Real radiusSq = 0;
+        for( size_t i = triStart * 3u; i < triEnd * 3u; ++i )
+        {
+            radiusSq = std::max(
+                radiusSq, cluster.center.squaredDistance( getPosition( positions, indices[i] ) ) );
+        }
+        cluster.radius = std::sqrt( radiusSq );
+
+        const Real normalLength = normalSum.length();
+        if( normalLength > Real( 1e-6 ) )
+        {
+            cluster.coneAxis = normalSum / normalLength;
+            cluster.coneCos = 1;
+            for( size_t i = triStart; i < triEnd; ++i )
+            {
+                const Vector3 normal = getTriangleNormal( positions, indices + i * 3u );
+                if( normal != Vector3::ZERO )
+                    cluster.coneCos = std::min( cluster.coneCos, cluster.coneAxis.dotProduct( normal ) );
+            }
+        }
+        else
+        {
+            cluster.coneAxis = Vector3::UNIT_Z;
+            cluster.coneCos = -1;
+        }
+
+        cluster.indexStart = static_cast<uint32>( triStart * 3u );
+        cluster.indexCount = static_cast<uint32>( ( triEnd - triStart ) * 3u );
+        outClusters.push_back( cluster );
+    }
+    //-------------------------------------------------------------------------
+    static uint32 hashVertex( const MeshOptimizer::VertexStreamArray &streams, size_t vertexIdx )
+    {
+        // FNV-1a
+        uint32 hash = 2166136261u;
+        MeshOptimizer::VertexStreamArray::const_iterator itor = streams.begin();
+        MeshOptimizer::VertexStreamArray::const_iterator endt = streams.end();
+        while( itor != endt )
+        {
+            const uint8 *data = itor->data + vertexIdx * itor->bytesPerVertex;
+            for( size_t i = 0u; i < itor->bytesPerVertex; ++i )
+            {
+                hash ^= data[i];
+                hash *= 16777619u;
+            }
+            ++itor;
+        }
+        return hash;
+    }
+    //-------------------------------------------------------------------------
+    static bool equalVertices( const MeshOptimizer::VertexStreamArray &streams, size_t a, size_t b )
+    {
+        MeshOptimizer::VertexStreamArray::const_iterator itor = streams.begin();
+        MeshOptimizer::VertexStreamArray::const_iterator endt = streams.end();
+        while( itor != endt )
+        {
+            if( memcmp( itor->data + a * itor->bytesPerVertex, itor->data + b * itor->bytesPerVertex,
+                        itor->bytesPerVertex ) != 0 )
+            {
+                return false;
+            }
+            ++itor;
+        }
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    MeshOptimizer::Stats::Stats() :
+        numTriangles( 0 ),
+        numVertices( 0 ),
+        numVerticesStored( 0 ),
+        numCacheMisses( 0 )
+    {
+    }
+    //-------------------------------------------------------------------------
+    float MeshOptimizer::Stats::getAcmr() const
+    {
+        return numTriangles ? float( numCacheMisses ) / float( numTriangles ) : 0.0f;
+    }
+    //-------------------------------------------------------------------------
+    float MeshOptimizer::Stats::getAtvr() const
+    {
+        return numVertices ? float( numCacheMisses ) / float( numVertices ) : 0.0f;
+    }
+    //-------------------------------------------------------------------------
+    void MeshOptimizer::Stats::merge( const Stats &other )
+    {
+        numTriangles += other.numTriangles;
+        numVertices += other.numVertices;
+        numVerticesStored += other.numVerticesStored;
+        numCacheMisses += other.numCacheMisses;
+    }
+    //-------------------------------------------------------------------------
+    void MeshOptimizer::Report::merge( const Report &other )
+    {
+        before.merge( other.before );
+        after.merge( other.after );
+    }
+    //-------------------------------------------------------------------------
+    //-------------------------------------------------------------------------
+    MeshOptimizer::Stats MeshOptimizer::analyze( const uint32 *indices, size_t numIndices,
+                                                 size_t numVertices, uint32 cacheSize )
+    {
+        Stats retVal;
+        retVal.numTriangles = numIndices / 3u;
+        retVal.numVerticesStored = numVertices;
+
+        vector<uint32>::type timestamps( numVertices, 0u );
+        uint32 timestamp = cacheSize + 1u;
+
+        for( size_t i = 0u; i < retVal.numTriangles; ++i )
+        {
+            const uint32 *triangle = indices + i * 3u;
+            for( size_t j = 0u; j < 3u; ++j )
+            {
+                if( timestamps[triangle[j]] == 0u )
+                    ++retVal.numVertices;
+            }
+            retVal.numCacheMisses += simulateFifoCache( triangle, timestamps, timestamp, cacheSize );
+        }
+
+        return retVal;
+    }
+    //-------------------------------------------------------------------------
+    size_t MeshOptimizer::weldVertices( const VertexStreamArray &streams, size_t numVertices,
+                                        uint32 *outRemap )
+    {
+        // Open addressing with linear probing, at most 80% full
+        size_t tableSize = 1u;
+        while( tableSize < numVertices + numVertices / 4u )
+            tableSize <<= 1u;
+        const size_t tableMask = tableSize - 1u;
+
+        vector<uint32>::type table( tableSize, c_invalidIndex );
+
+        size_t numUnique = 0u;
+        for( size_t i = 0u; i < numVertices; ++i )
+        {
+            size_t bucket = hashVertex( streams, i ) & tableMask;
+            while( table[bucket] != c_invalidIndex && !equalVertices( streams, table[bucket], i ) )
+                bucket = ( bucket + 1u ) & tableMask;
+
+            if( table[bucket] == c_invalidIndex )
+            {
+                table[bucket] = static_cast<uint32>( i );
+                outRemap[i] = static_cast<uint32>( i );
+                ++numUnique;
+            }
+            else
+            {
+                outRemap[i] = table[bucket];
+            }
+        }
+
+        return numUnique;
+    }
+    //-------------------------------------------------------------------------
+    void MeshOptimizer::optimizeVertexCache( uint32 *indices, size_t numIndices, size_t numVertices )
+    {
+        const size_t numTriangles = numIndices / 3u;
+        if( numTriangles == 0u )
+            return;
+
+        // Build the triangle adjacency of each vertex. The first numLiveTris[v]
+        // entries of each list are the triangles that haven't been emitted yet.
+        vector<uint32>::type numLiveTris( numVertices, 0u );
+        for( size_t i = 0u; i < numTriangles * 3u; ++i )
+            ++numLiveTris[indices[i]];
+
+        vector<uint32>::type adjacencyOffsets( numVertices + 1u, 0u );
+        for( size_t i = 0u; i < numVertices; ++i )
+            adjacencyOffsets[i + 1u] = adjacencyOffsets[i] + numLiveTris[i];
+
+        vector<uint32>::type adjacency( numTriangles * 3u );
+        {
+            vector<uint32>::type cursors( adjacencyOffsets.begin(), adjacencyOffsets.end() - 1 );
+            for( size_t i = 0u; i < numTriangles * 3u; ++i )
+                adjacency[cursors[indices[i]]++] = static_cast<uint32>( i / 3u );
+        }
+
+        vector<int32>::type cachePositions( numVertices, -1 );
+        vector<float>::type vertexScores( numVertices );
+        for( size_t i = 0u; i < numVertices; ++i )
+            vertexScores[i] = forsythVertexScore( -1, numLiveTris[i] );
+
+        vector<float>::type triangleScores( numTriangles );
+        uint32 bestTriangle = 0u;
+        for( size_t i = 0u; i < numTriangles; ++i )
+        {
+            const uint32 *triangle = indices + i * 3u;
+            triangleScores[i] = vertexScores[triangle[0]] + vertexScores[triangle[1]] +
+                                vertexScores[triangle[2]];
+            if( triangleScores[i] > triangleScores[bestTriangle] )
+                bestTriangle = static_cast<uint32>( i );
+        }
+
+        vector<uint8>::type emitted( numTriangles, 0u );
+        vector<uint32>::type output;
+        output.reserve( numTriangles * 3u );
+
+        uint32 cache[c_forsythCacheSize + 3u];
+        uint32 newCache[c_forsythCacheSize + 3u];
+        size_t cacheCount = 0u;
+        size_t nextCandidate = 0u;
+
+        for( size_t n = 0u; n < numTriangles; ++n )
+        {
+            if( bestTriangle == c_invalidIndex )
+            {
+                // Nothing in the cache has triangles left. Restart from anywhere
+                while( emitted[nextCandidate] )
+                    ++nextCandidate;
+                bestTriangle = static_cast<uint32>( nextCandidate );
+            }
+
+            emitted[bestTriangle] = 1u;
+            const uint32 *triangle = indices + bestTriangle * 3u;
+            output.insert( output.end(), triangle, triangle + 3u );
+
+            size_t newCacheCount = 0u;
+            for( size_t i = 0u; i < 3u; ++i )
+            {
+                const uint32 vertexIdx = triangle[i];
+
+                // Remove the triangle from the live list of this vertex
+                uint32 *adjacent = &adjacency[adjacencyOffsets[vertexIdx]];
+                const uint32 numAdjacent = numLiveTris[vertexIdx];
+                for( uint32 j = 0u; j < numAdjacent; ++j )
+                {
+                    if( adjacent[j] == bestTriangle )
+                    {
+                        adjacent[j] = adjacent[numAdjacent - 1u];
+                        adjacent[numAdjacent - 1u] = bestTriangle;
+                        --numLiveTris[vertexIdx];
+                        break;
+                    }
+                }
+
+                // Degenerate triangles repeat vertices
+                if( std::find( newCache, newCache + newCacheCount, vertexIdx ) ==
+                    newCache + newCacheCount )
+                {
+                    newCache[newCacheCount++] = vertexIdx;
+                }
+            }
+
+            // The triangle's vertices go to the front of the LRU cache
+            for( size_t i = 0u; i < cacheCount; ++i )
+            {
+                const uint32 vertexIdx = cache[i];
+                if( vertexIdx != triangle[0] && vertexIdx != triangle[1] && vertexIdx != triangle[2] )
+                    newCache[newCacheCount++] = vertexIdx;
+            }
+
+            // Update the scores of the cached (and just evicted) vertices and their
+            // triangles, while looking for the best triangle to emit next.
+            bestTriangle = c_invalidIndex;
+            float bestScore = -1.0f;
+            for( size_t i = 0u; i < newCacheCount; ++i )
+            {
+                const uint32 vertexIdx = newCache[i];
+                cachePositions[vertexIdx] = i < c_forsythCacheSize ? static_cast<int32>( i ) : -1;
+
+                const float newScore =
+                    forsythVertexScore( cachePositions[vertexIdx], numLiveTris[vertexIdx] );
+                const float scoreDelta = newScore - vertexScores[vertexIdx];
+                vertexScores[vertexIdx] = newScore;
+
+                const uint32 *adjacent = &adjacency[adjacencyOffsets[vertexIdx]];
+                const uint32 numAdjacent = numLiveTris[vertexIdx];
+                for( uint32 j = 0u; j < numAdjacent; ++j )
+                {
+                    const uint32 triangleIdx = adjacent[j];
+                    triangleScores[triangleIdx] += scoreDelta;
+                    if( triangleScores[triangleIdx] > bestScore )
+                    {
+                        bestScore = triangleScores[triangleIdx];
+                        bestTriangle = triangleIdx;
+                    }
+                }
+            }
+
+            cacheCount = std::min<size_t>( newCacheCount, c_forsythCacheSize );
+            memcpy( cache, newCache, cacheCount * sizeof( uint32 ) );
+        }
+
+        memcpy( indices, output.data(), numTriangles * 3u * sizeof( uint32 ) );
+    }
+    //-------------------------------------------------------------------------
+    void MeshOptimizer::optimizeOverdraw( uint32 *indices, size_t numIndices, const float *positions,
+                                          size_t numVertices, float threshold, uint32 cacheSize )
+    {
+        const size_t numTriangles = numIndices / 3u;
+        if( numTriangles == 0u )
+            return;
+
+        vector<uint32>::type timestamps( numVertices, 0u );
+        uint32 timestamp = cacheSize + 1u;
+
+        // Hard boundaries: the triangles where the cache got fully trashed.
+        // Clusters can be moved around there without affecting cache efficiency.
+        vector<uint32>::type hardBoundaries;
+        for( size_t i = 0u; i < numTriangles; ++i )
+        {
+            const uint32 numMisses = simulateFifoCache( indices + i * 3u, timestamps, timestamp,
+                                                        cacheSize );
+            if( i == 0u || numMisses == 3u )
+                hardBoundaries.push_back( static_cast<uint32>( i ) );
+        }
+        hardBoundaries.push_back( static_cast<uint32>( numTriangles ) );
+
+        // Soft boundaries: split the clusters further as long as their ACMR, starting
+        // with an empty cache, stays within threshold of the ACMR of the whole cluster.
+        vector<uint32>::type clusters;
+        for( size_t i = 0u; i < hardBoundaries.size() - 1u; ++i )
+        {
+            const uint32 clusterStart = hardBoundaries[i];
+            const uint32 clusterEnd = hardBoundaries[i + 1u];
+
+            timestamp += cacheSize + 1u;
+            uint32 clusterMisses = 0u;
+            for( uint32 j = clusterStart; j < clusterEnd; ++j )
+            {
+                clusterMisses +=
+                    simulateFifoCache( indices + j * 3u, timestamps, timestamp, cacheSize );
+            }
+
+            const float maxAcmr =
+                threshold * float( clusterMisses ) / float( clusterEnd - clusterStart );
+
+            clusters.push_back( clusterStart );
+            timestamp += cacheSize + 1u;
+            uint32 subclusterStart = clusterStart;
+            uint32 subclusterMisses = 0u;
+            for( uint32 j = clusterStart; j < clusterEnd - 1u; ++j )
+            {
+                subclusterMisses += simulateFifoCache( indices + j * 3u, timestamps, timestamp,
+                                                       cacheSize );
+                if( float( subclusterMisses ) <= maxAcmr * float( j + 1u - subclusterStart ) )
+                {
+                    subclusterStart = j + 1u;
+                    subclusterMisses = 0u;
+                    clusters.push_back( subclusterStart );
+                    timestamp += cacheSize + 1u;
+                }
+            }
+        }
+        clusters.push_back( static_cast<uint32>( numTriangles ) );
+
+        vector<Vector3>::type vertexPos( numVertices );
+        for( size_t i = 0u; i < numVertices; ++i )
+            vertexPos[i] = getPosition( positions, i );
+
+        Vector3 meshCentroid( Vector3::ZERO );
+        for( size_t i = 0u; i < numTriangles * 3u; ++i )
+            meshCentroid += vertexPos[indices[i]];
+        meshCentroid /= Real( numTriangles * 3u );
+
+        // Clusters facing away from the centre of the mesh are more likely to occlude
+        // the rest, thus render them first.
+        const size_t numClusters = clusters.size() - 1u;
+        vector<std::pair<float, uint32> >::type sortKeys( numClusters );
+        for( size_t i = 0u; i < numClusters; ++i )
+        {
+            Vector3 centroid( Vector3::ZERO );
+            Vector3 normal( Vector3::ZERO );
+            Real area = 0;
+            for( uint32 j = clusters[i]; j < clusters[i + 1u]; ++j )
+            {
+                const Vector3 &p0 = vertexPos[indices[j * 3u + 0u]];
+                const Vector3 &p1 = vertexPos[indices[j * 3u + 1u]];
+                const Vector3 &p2 = vertexPos[indices[j * 3u + 2u]];
+                const Vector3 triNormal = ( p1 - p0 ).crossProduct( p2 - p0 );
+                const Real triArea = triNormal.length();
+                centroid += ( p0 + p1 + p2 ) * ( triArea / Real( 3.0 ) );
+                normal += triNormal;
+                area += triArea;
+            }
+
+            if( area > Real( 0 ) )
+                centroid /= area;
+            normal.normalise();
+
+            sortKeys[i].first = float( ( centroid - meshCentroid ).dotProduct( normal ) );
+            sortKeys[i].second = static_cast<uint32>( i );
+        }
+
+        std::stable_sort( sortKeys.begin(), sortKeys.end(),
+                          []( const std::pair<float, uint32> &a, const std::pair<float, uint32> &b )
+                          { return a.first > b.first; } );
+
+        vector<uint32>::type output;
+        output.reserve( numTriangles * 3u );
+        for( size_t i = 0u; i < numClusters; ++i )
+        {
+            const uint32 clusterIdx = sortKeys[i].second;
+            output.insert( output.end(), indices + clusters[clusterIdx] * 3u,
+                           indices + clusters[clusterIdx + 1u] * 3u );
+        }
+
+        memcpy( indices, output.data(), numTriangles * 3u * sizeof( uint32 ) );
+    }
+    //-------------------------------------------------------------------------
+    size_t MeshOptimizer::optimizeVertexFetch( const uint32 *indices, size_t numIndices,
+                                               size_t numVertices, uint32 *outRemap )
+    {
+        std::fill( outRemap, outRemap + numVertices, c_invalidIndex );
+
+        uint32 nextVertex = 0u;
+        for( size_t i = 0u; i < numIndices; ++i )
+        {
+            const uint32 vertexIdx = indices[i];
+            if( outRemap[vertexIdx] == c_invalidIndex )
+                outRemap[vertexIdx] = nextVertex++;
+        }
+
+        return nextVertex;
+    }
+    //-------------------------------------------------------------------------
+    void MeshOptimizer::buildClusters( const uint32 *indices, size_t numIndices,
+                                       const float *positions, size_t numVertices,
+                                       uint32 maxTriangles, MeshClusterArray &outClusters )
+    {
+        const size_t numTriangles = numIndices / 3u;
+        if( numTriangles == 0u )
+            return;
+
+        maxTriangles = std::max( maxTriangles, 1u );
+        const size_t minTriangles = std::max( maxTriangles / 4u, 1u );
+        // Beyond ~60 degrees the normal cone becomes useless for back-face culling
+        const Real c_minNormalDot = Real( 0.5 );
+
+        // vertexStamps[i] == stamp if the current cluster uses vertex i
+        vector<uint32>::type vertexStamps( numVertices, 0u );
+        uint32 stamp = 1u;
+
+        size_t clusterStart = 0u;
+        Vector3 normalSum( Vector3::ZERO );
+        for( size_t i = 0u; i < numTriangles; ++i )
+        {
+            const uint32 *triangle = indices + i * 3u;
+            const Vector3 triNormal = getTriangleNormal( positions, triangle );
+
+            const size_t clusterSize = i - clusterStart;
+            bool split = clusterSize >= maxTriangles;
+            if( !split && clusterSize >= minTriangles )
+            {
+                const bool sharesVertex = vertexStamps[triangle[0]] == stamp ||
+                                          vertexStamps[triangle[1]] == stamp ||
+                                          vertexStamps[triangle[2]] == stamp;
+                const Vector3 axis = normalSum.normalisedCopy();
+                split = !sharesVertex ||
+                        ( triNormal != Vector3::ZERO && axis.dotProduct( triNormal ) < c_minNormalDot );
+            }
+
+            if( split )
+            {
+                addCluster( indices, positions, clusterStart, i, outClusters );
+                clusterStart = i;
+                normalSum = Vector3::ZERO;
+                ++stamp;
+            }
+
+            normalSum += triNormal;
+            for( size_t j = 0u; j < 3u; ++j )
+                vertexStamps[triangle[j]] = stamp;
+        }
+
+        addCluster( indices, positions, clusterStart, numTriangles, outClusters );
+    }
+    //-------------------------------------------------------------------------
+    size_t MeshOptimizer::cullClusters( const MeshClusterArray &clusters, const Matrix4 &worldMatrix,
+                                        const Plane *planes, size_t numPlanes,
+                                        const Vector3 *localCameraPos, FastArray<uint32> &outRanges )
+    {
+        // Spheres grow at most by the largest scale of the three axes
+        Real maxScaleSq = 0;
+        for( size_t i = 0u; i < 3u; ++i )
+        {
+            const Vector3 axis( worldMatrix[0][i], worldMatrix[1][i], worldMatrix[2][i] );
+            maxScaleSq = std::max( maxScaleSq, axis.squaredLength() );
+        }
+        const Real maxScale = std::sqrt( maxScaleSq );
+
+        const size_t firstRange = outRanges.size();
+        size_t numVisibleIndices = 0u;
+
+        MeshClusterArray::const_iterator itor = clusters.begin();
+        MeshClusterArray::const_iterator endt = clusters.end();
+        while( itor != endt )
+        {
+            const MeshCluster &cluster = *itor;
+            bool isVisible = true;
+
+            if( localCameraPos && cluster.coneCos > Real( 0 ) )
+            {
+                // Back-facing if, from the camera, every point in the sphere sees every
+                // normal in the cone from behind. Done in object space since whether a
+                // triangle faces the camera doesn't change with affine transforms.
+                const Vector3 toCluster = cluster.center - *localCameraPos;
+                const Real coneSin = std::sqrt(
+                    std::max( Real( 1 ) - cluster.coneCos * cluster.coneCos, Real( 0 ) ) );
+                isVisible = toCluster.dotProduct( cluster.coneAxis ) <
+                            coneSin * toCluster.length() + cluster.radius * ( Real( 1 ) + coneSin );
+            }
+
+            if( isVisible )
+            {
+                const Vector3 worldCenter = worldMatrix.transformAffine( cluster.center );
+                const Real worldRadius = cluster.radius * maxScale;
+                for( size_t i = 0u; i < numPlanes && isVisible; ++i )
+                    isVisible = planes[i].getDistance( worldCenter ) >= -worldRadius;
+            }
+
+            if( isVisible )
+            {
+                const size_t numRanges = outRanges.size();
+                if( numRanges > firstRange &&
+                    outRanges[numRanges - 2u] + outRanges[numRanges - 1u] == cluster.indexStart )
+                {
+                    outRanges[numRanges - 1u] += cluster.indexCount;
+                }
+                else
+                {
+                    outRanges.push_back( cluster.indexStart );
+                    outRanges.push_back( cluster.indexCount );
+                }
+                numVisibleIndices += cluster.indexCount;
+            }
+
+            ++itor;
+        }
+
+        return numVisibleIndices;
+    }
+}  // namespace Ogre
@@ -41,6 +41,7 @@ THE SOFTWARE.
 #include "OgreMesh2.h"
 #include "OgreMesh2Serializer.h"
 #include "OgreMeshFileFormat.h"
+#include "OgreMeshManager2.h"
 #include "OgreRoot.h"
 #include "OgreSubMesh2.h"
 #include "Vao/OgreAsyncTicket.h"
@@ -61,7 +62,20 @@ namespace Ogre
     /// stream overhead = ID + size
     const long MSTREAM_OVERHEAD_SIZE = sizeof( uint16 ) + sizeof( uint32 );
     //---------------------------------------------------------------------
-    MeshSerializerImpl::MeshSerializerImpl( VaoManager *vaoManager ) : mVaoManager( vaoManager )
+    static bool hasClusters( const Mesh *pMesh )
+    {
+        for( const SubMesh *s : pMesh->getSubMeshes() )
+        {
+            if( !s->mClusters.empty() )
+                return true;
+        }
+        return false;
+    }
+    //---------------------------------------------------------------------
+    MeshSerializerImpl::MeshSerializerImpl( VaoManager *vaoManager ) :
+        mScanLods( false ),
+        mScannedNumVaoPasses( 1u ),
+        mVaoManager( vaoManager )
     {
         // Version number
         mVersion = "[MeshSerializer_v2.1 R2]";
@@ -109,6 +123,14 @@ namespace Ogre
             }
         }
 
+        if( pMesh->getFirstResidentLod() != 0u )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALID_STATE,
+                         "Mesh " + pMesh->getName() +
+                             " can't be exported while its finer LODs aren't streamed in.",
+                         "MeshSerializerImpl::exportMesh" );
+        }
+
         writeFileHeader();
         LogManager::getSingleton().logMessage( "File header written." );
 
@@ -132,6 +154,12 @@ namespace Ogre
 #endif
         // Check header
         readFileHeader( stream );
+
+        // Only this version's readSubMesh knows how to defer reading its LODs
+        mScanLods = Mesh::msLodStreaming;
+        mScannedLods.clear();
+        mScannedNumLods.clear();
+
         pushInnerChunk( stream );
         uint16 streamID;
         while( !stream->eof() )
@@ -146,6 +174,10 @@ namespace Ogre
         }
         popInnerChunk( stream );
 
+        if( !mScannedNumLods.empty() )
+            loadScannedLods( stream, pMesh );
+        mScanLods = false;
+
         if( !pMesh->hasValidShadowMappingVaos() )
             pMesh->prepareForShadowMapping( false );
     }
@@ -229,6 +261,13 @@ namespace Ogre
             writeMeshHashForCaches( pMesh );
             LogManager::getSingleton().logMessage( "Exporting hash for caches exported." );
 
+            if( hasClusters( pMesh ) )
+            {
+                LogManager::getSingleton().logMessage( "Exporting clusters..." );
+                writeMeshClusters( pMesh );
+                LogManager::getSingleton().logMessage( "Clusters exported." );
+            }
+
             // Write edge lists
             /*if (pMesh->isEdgeListBuilt())
             {
@@ -280,6 +319,33 @@ namespace Ogre
         writeInts64( mCalculatedHash, 2u );
     }
     //---------------------------------------------------------------------
+    void MeshSerializerImpl::writeMeshClusters( const Mesh *pMesh )
+    {
+        writeChunkHeader( M_MESH_CLUSTERS, calcMeshClustersSize( pMesh ) );
+
+        for( const SubMesh *s : pMesh->getSubMeshes() )
+        {
+            const uint8 numLodLevels = static_cast<uint8>( s->mClusters.size() );
+            writeData( &numLodLevels, 1, 1 );
+
+            for( const MeshClusterArray &clusters : s->mClusters )
+            {
+                const uint32 numClusters = static_cast<uint32>( clusters.size() );
+                writeInts( &numClusters, 1 );
+
+                for( const MeshCluster &cluster : clusters )
+                {
+                    writeFloats( cluster.center.ptr(), 3 );
+                    writeFloats( &cluster.radius, 1 );
+                    writeFloats( cluster.coneAxis.ptr(), 3 );
+                    writeFloats( &cluster.coneCos, 1 );
+                    writeInts( &cluster.indexStart, 1 );
+                    writeInts( &cluster.indexCount, 1 );
+                }
+            }
+        }
+    }
+    //---------------------------------------------------------------------
     void MeshSerializerImpl::writeSubMesh( const SubMesh *s,
                                            const LodLevelVertexBufferTable &lodVertexTable )
     {
@@ -558,6 +624,9 @@ namespace Ogre
 
         size += calcHashForCachesSize();
 
+        if( hasClusters( pMesh ) )
+            size += calcMeshClustersSize( pMesh );
+
         size += calcBoundsInfoSize( pMesh );
 
         // Submesh name table
@@ -753,6 +822,39 @@ namespace Ogre
         pMesh->_setHashForCaches( hash );
     }
     //---------------------------------------------------------------------
+    void MeshSerializerImpl::readMeshClusters( DataStreamPtr &stream, Mesh *pMesh )
+    {
+        for( SubMesh *s : pMesh->mSubMeshes )
+        {
+            uint8 numLodLevels = 0;
+            readChar( stream, &numLodLevels );
+
+            s->mClusters.clear();
+            s->mClusters.resize( numLodLevels );
+            for( MeshClusterArray &clusters : s->mClusters )
+            {
+                uint32 numClusters = 0;
+                readInts( stream, &numClusters, 1 );
+
+                clusters.resize( numClusters );
+                for( MeshCluster &cluster : clusters )
+                {
+                    readFloats( stream, cluster.center.ptr(), 3 );
+                    readFloats( stream, &cluster.radius, 1 );
+                    readFloats( stream, cluster.coneAxis.ptr(), 3 );
+                    readFloats( stream, &cluster.coneCos, 1 );
+                    readInts( stream, &cluster.indexStart, 1 );
+                    readInts( stream, &cluster.indexCount, 1 );
+                }
+            }
+
+            // Clusters that don't match the LODs can't be used
+            if( s->mClusters.size() != s->mVao[VpNormal].size() )
+                s->mClusters.clear();
+            s->updateMaxExtraClusterDraws();
+        }
+    }
+    //---------------------------------------------------------------------
     void MeshSerializerImpl::readMesh( DataStreamPtr &stream, Mesh *pMesh,
                                        MeshSerializerListener *listener )
     {
@@ -775,7 +877,8 @@ namespace Ogre
                  streamID == M_MESH_BOUNDS ||
                  streamID == M_SUBMESH_NAME_TABLE ||
                  streamID == M_MESH_LOD_LEVEL ||
-                 streamID == M_HASH_FOR_CACHES /*||
+                 streamID == M_HASH_FOR_CACHES ||
+                 streamID == M_MESH_CLUSTERS /*||
                  streamID == M_EDGE_LISTS ||
                  streamID == M_POSES ||
                  streamID == M_ANIMATIONS*/))
@@ -800,6 +903,9 @@ namespace Ogre
                 case M_HASH_FOR_CACHES:
                     readHashForCaches( stream, pMesh );
                     break;
+                case M_MESH_CLUSTERS:
+                    readMeshClusters( stream, pMesh );
+                    break;
                     /*case M_EDGE_LISTS:
                         readEdgeList(stream, pMesh);
                         break;
@@ -847,6 +953,15 @@ namespace Ogre
         uint8 numLodLevels = 0;
         readChar( stream, &numLodLevels );
 
+        if( mScanLods )
+        {
+            // M_SUBMESH_LOD. Read later by loadScannedLods
+            pushInnerChunk( stream );
+            scanSubMeshLods( stream, numLodLevels, numVaoPasses );
+            popInnerChunk( stream );
+            return;
+        }
+
         SubMeshLodVec totalSubmeshLods;
         totalSubmeshLods.reserve( numLodLevels * numVaoPasses );
 
@@ -892,34 +1007,244 @@ namespace Ogre
         }
         catch( Exception & )
         {
-            SubMeshLodVec::iterator itor = totalSubmeshLods.begin();
-            SubMeshLodVec::iterator endt = totalSubmeshLods.end();
+            freeSubMeshLods( totalSubmeshLods );
 
-            while( itor != endt )
+            // TODO: Delete created mVaos. Don't erase the data from those vaos?
+
+            throw;
+        }
+
+        popInnerChunk( stream );
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::freeSubMeshLods( SubMeshLodVec &lods )
+    {
+        SubMeshLodVec::iterator itor = lods.begin();
+        SubMeshLodVec::iterator endt = lods.end();
+
+        while( itor != endt )
+        {
+            Uint8Vec::iterator it = itor->vertexBuffers.begin();
+            Uint8Vec::iterator en = itor->vertexBuffers.end();
+
+            while( it != en )
+                OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
+
+            itor->vertexBuffers.clear();
+
+            if( itor->indexData )
             {
-                Uint8Vec::iterator it = itor->vertexBuffers.begin();
-                Uint8Vec::iterator en = itor->vertexBuffers.end();
+                OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
+                itor->indexData = 0;
+            }
 
-                while( it != en )
-                    OGRE_FREE_SIMD( *it++, MEMCATEGORY_GEOMETRY );
+            ++itor;
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::scanSubMeshLods( DataStreamPtr &stream, uint8 numLodLevels,
+                                              uint8 numVaoPasses )
+    {
+        mScannedNumLods.push_back( numLodLevels );
+        mScannedNumVaoPasses = numVaoPasses;
 
-                itor->vertexBuffers.clear();
+        for( uint8 i = 0; i < numVaoPasses; ++i )
+        {
+            for( uint8 j = 0; j < numLodLevels; ++j )
+            {
+                ScannedLod scannedLod;
+                scannedLod.offset = stream->tell();
+                scannedLod.lodSource = j;
 
-                if( itor->indexData )
+                const uint16 streamID = readChunk( stream );
+                if( streamID != M_SUBMESH_LOD || stream->eof() )
                 {
-                    OGRE_FREE_SIMD( itor->indexData, MEMCATEGORY_GEOMETRY );
-                    itor->indexData = 0;
+                    OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                                 "Missing M_SUBMESH_LOD in " + stream->getName(),
+                                 "MeshSerializerImpl::scanSubMeshLods" );
                 }
+                scannedLod.size = mCurrentstreamLen;
 
-                ++itor;
+                // Skip the indices
+                uint32 numIndices = 0;
+                readInts( stream, &numIndices, 1 );
+                if( numIndices > 0 )
+                {
+                    bool index32Bit = false;
+                    readBools( stream, &index32Bit, 1 );
+                    stream->skip( long( numIndices * ( index32Bit ? 4u : 2u ) ) );
+                }
+
+                // Only M_SUBMESH_M_GEOMETRY_EXTERNAL_SOURCE matters. Skip the rest.
+                const size_t chunkEnd = scannedLod.offset + scannedLod.size;
+                pushInnerChunk( stream );
+                while( stream->tell() < chunkEnd )
+                {
+                    const size_t innerChunkStart = stream->tell();
+                    if( readChunk( stream ) == M_SUBMESH_M_GEOMETRY_EXTERNAL_SOURCE )
+                        readChar( stream, &scannedLod.lodSource );
+                    stream->seek( innerChunkStart + mCurrentstreamLen );
+                }
+                popInnerChunk( stream );
+
+                mScannedLods.push_back( scannedLod );
             }
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::loadScannedLods( DataStreamPtr &stream, Mesh *pMesh )
+    {
+        const uint8 numVaoPasses = mScannedNumVaoPasses;
+        const uint8 numLods = mScannedNumLods.front();
 
-            // TODO: Delete created mVaos. Don't erase the data from those vaos?
+        bool canStream = numLods > 1u && numLods == pMesh->getNumLodLevels();
+        for( size_t i = 0; i < mScannedNumLods.size(); ++i )
+            canStream &= mScannedNumLods[i] == numLods;
+
+        // A step can start at LOD j if no LOD >= j takes its vertex buffers from a LOD < j
+        FastArray<uint8> stepLods;
+        stepLods.push_back( 0u );
+        if( canStream )
+        {
+            FastArray<uint8> minLodSource;
+            minLodSource.resize( numLods, 255u );
+            for( size_t i = 0; i < mScannedLods.size(); ++i )
+            {
+                const size_t lod = i % numLods;
+                minLodSource[lod] = std::min( minLodSource[lod], mScannedLods[i].lodSource );
+            }
+            for( size_t lod = numLods - 1u; lod-- > 0u; )
+                minLodSource[lod] = std::min( minLodSource[lod], minLodSource[lod + 1u] );
+
+            for( uint8 lod = 1u; lod < numLods; ++lod )
+            {
+                if( minLodSource[lod] >= lod )
+                    stepLods.push_back( lod );
+            }
+        }
 
+        const uint8 firstLod = stepLods.back();
+
+        if( firstLod != 0u )
+        {
+            MeshLodStreamingInfo *info =
+                OGRE_NEW_T( MeshLodStreamingInfo, MEMCATEGORY_RESOURCE )();
+            info->stepLods.swap( stepLods );
+            info->stepBytes.resize( info->stepLods.size(), 0u );
+            info->chunkOffsets.reserve( mScannedLods.size() );
+            for( size_t i = 0; i < mScannedLods.size(); ++i )
+            {
+                const uint8 lod = static_cast<uint8>( i % numLods );
+                info->chunkOffsets.push_back( mScannedLods[i].offset );
+                info->stepBytes[info->getStepIdx( lod )] += mScannedLods[i].size;
+            }
+            info->numLods = numLods;
+            info->numVaoPasses = numVaoPasses;
+            info->flipEndian = mFlipEndian;
+            pMesh->mLodStreaming = info;
+        }
+
+        // Load the LODs that start resident
+        SubMeshLodVec     submeshLods;
+        FastArray<size_t> chunkOffsets;
+        size_t            scannedIdx = 0;
+        try
+        {
+            for( size_t i = 0; i < mScannedNumLods.size(); ++i )
+            {
+                SubMesh *sm = pMesh->getSubMesh( static_cast<unsigned>( i ) );
+                const uint8 numLodLevels = mScannedNumLods[i];
+                const uint8 numResidentLods = static_cast<uint8>( numLodLevels - firstLod );
+
+                for( uint8 pass = 0; pass < numVaoPasses; ++pass )
+                {
+                    sm->mVao[pass].resize( numLodLevels, 0 );
+
+                    chunkOffsets.clear();
+                    for( uint8 lod = firstLod; lod < numLodLevels; ++lod )
+                        chunkOffsets.push_back( mScannedLods[scannedIdx + lod].offset );
+                    scannedIdx += numLodLevels;
+
+                    submeshLods.clear();
+                    readSubMeshLods( stream, pMesh, chunkOffsets.begin(), firstLod, numResidentLods,
+                                     submeshLods );
+                    createSubMeshLodVaos( sm, submeshLods.data(), numResidentLods, pass, firstLod );
+                }
+            }
+        }
+        catch( Exception & )
+        {
+            freeSubMeshLods( submeshLods );
             throw;
         }
 
-        popInnerChunk( stream );
+        if( firstLod != 0u )
+        {
+            pMesh->_setFirstResidentLod( firstLod );
+            MeshManager *meshManager = MeshManager::getSingletonPtr();
+            if( meshManager )
+                meshManager->_addLodStreamingMesh( pMesh );
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::readSubMeshLods( DataStreamPtr &stream, Mesh *pMesh,
+                                              const size_t *chunkOffsets, uint8 firstLod,
+                                              uint8 numLods, SubMeshLodVec &outLods )
+    {
+        for( uint8 i = 0; i < numLods; ++i )
+        {
+            stream->seek( chunkOffsets[i] );
+            pushInnerChunk( stream );
+#if OGRE_DEBUG_MODE >= OGRE_DEBUG_LOW
+            const uint16 streamID =
+#endif
+                readChunk( stream );
+            OGRE_ASSERT_LOW( streamID == M_SUBMESH_LOD && !stream->eof() );
+
+            outLods.push_back( SubMeshLod() );
+            readSubMeshLod( stream, pMesh, &outLods.back(), static_cast<uint8>( firstLod + i ) );
+            popInnerChunk( stream );
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::readStreamedLods( DataStreamPtr &stream, bool flipEndian,
+                                               const FastArray<size_t> &chunkOffsets, uint8 firstLod,
+                                               uint8 endLod, SubMeshLodVec &outLods )
+    {
+        mFlipEndian = flipEndian;
+
+        const uint8 numLods = static_cast<uint8>( endLod - firstLod );
+        outLods.reserve( chunkOffsets.size() );
+
+        try
+        {
+            for( size_t i = 0; i < chunkOffsets.size(); i += numLods )
+                readSubMeshLods( stream, 0, &chunkOffsets[i], firstLod, numLods, outLods );
+        }
+        catch( Exception & )
+        {
+            freeSubMeshLods( outLods );
+            throw;
+        }
+    }
+    //---------------------------------------------------------------------
+    void MeshSerializerImpl::createStreamedLodVaos( Mesh *pMesh, SubMeshLodVec &lods, uint8 firstLod,
+                                                    uint8 endLod )
+    {
+        const uint8 numVaoPasses = pMesh->_getLodStreamingInfo()->numVaoPasses;
+        const uint8 numLods = static_cast<uint8>( endLod - firstLod );
+
+        OGRE_ASSERT_LOW( lods.size() == pMesh->getNumSubMeshes() * numVaoPasses * numLods );
+
+        size_t lodIdx = 0;
+        for( SubMesh *sm : pMesh->getSubMeshes() )
+        {
+            for( uint8 pass = 0; pass < numVaoPasses; ++pass )
+            {
+                createSubMeshLodVaos( sm, &lods[lodIdx], numLods, pass, firstLod );
+                lodIdx += numLods;
+            }
+        }
     }
     //---------------------------------------------------------------------
     void MeshSerializerImpl::createSubMeshVao( SubMesh *sm, SubMeshLodVec &submeshLods,
@@ -1006,6 +1331,78 @@ namespace Ogre
         }
     }
     //---------------------------------------------------------------------
+    void MeshSerializerImpl::createSubMeshLodVaos( SubMesh *sm, SubMeshLod *submeshLods, uint8 numLods,
+                                                   uint8 casterPass, uint8 firstLod )
+    {
+        const bool vertexBufferShadowed = sm->mParent->isVertexBufferShadowed();
+        const bool indexBufferShadowed = sm->mParent->isIndexBufferShadowed();
+
+        VertexBufferPackedVec vertexBuffers;
+        for( uint8 i = 0; i < numLods; ++i )
+        {
+            SubMeshLod &subMeshLod = submeshLods[i];
+            const uint8 currentLod = static_cast<uint8>( firstLod + i );
+
+            vertexBuffers.clear();
+
+            if( subMeshLod.lodSource == currentLod )
+            {
+                if( subMeshLod.vertexDeclarations.size() != 1u )
+                {
+                    OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                                 "Meshes with multiple vertex buffer sources aren't yet supported."
+                                 " Load it as v1 mesh and import it to a v2 mesh",
+                                 "MeshSerializerImpl::createSubMeshLodVaos" );
+                }
+
+                vertexBuffers.push_back( mVaoManager->createVertexBuffer(
+                    subMeshLod.vertexDeclarations[0], subMeshLod.numVertices,
+                    sm->mParent->getVertexBufferDefaultType(), subMeshLod.vertexBuffers[0],
+                    vertexBufferShadowed ) );
+            }
+            else
+            {
+                vertexBuffers = sm->mVao[casterPass][subMeshLod.lodSource]->getVertexBuffers();
+            }
+
+            IndexBufferPacked *indexBuffer = 0;
+            if( subMeshLod.indexData )
+            {
+                indexBuffer = mVaoManager->createIndexBuffer(
+                    subMeshLod.index32Bit ? IndexBufferPacked::IT_32BIT : IndexBufferPacked::IT_16BIT,
+                    subMeshLod.numIndices, sm->mParent->getIndexBufferDefaultType(),
+                    subMeshLod.indexData, indexBufferShadowed );
+            }
+
+            sm->mVao[casterPass][currentLod] = mVaoManager->createVertexArrayObject(
+                vertexBuffers, indexBuffer, subMeshLod.operationType );
+
+            if( currentLod == 0u && casterPass == VpNormal && !subMeshLod.vertexBuffers.empty() )
+            {
+                // Populate mBoneAssignments while we still have the data in CPU memory
+                size_t indexSource = 0;
+                size_t unusedVar = 0;
+                if( sm->mVao[VpNormal][0]->findBySemantic( VES_BLEND_INDICES, indexSource,
+                                                           unusedVar ) )
+                {
+                    sm->_buildBoneAssignmentsFromVertexData(
+                        subMeshLod.vertexBuffers[indexSource] );
+                }
+            }
+
+            // Shadowed buffers took ownership of the data
+            if( !vertexBufferShadowed )
+            {
+                for( uint8 *vertexData : subMeshLod.vertexBuffers )
+                    OGRE_FREE_SIMD( vertexData, MEMCATEGORY_GEOMETRY );
+            }
+            subMeshLod.vertexBuffers.clear();
+            if( subMeshLod.indexData && !indexBufferShadowed )
+                OGRE_FREE_SIMD( subMeshLod.indexData, MEMCATEGORY_GEOMETRY );
+            subMeshLod.indexData = 0;
+        }
+    }
+    //---------------------------------------------------------------------
     void MeshSerializerImpl::readSubMeshLod( DataStreamPtr &stream, Mesh *pMesh, SubMeshLod *subLod,
                                              uint8 currentLod )
     {
@@ -1013,6 +1410,9 @@ namespace Ogre
 
         pushInnerChunk( stream );
 
+        // Unless M_SUBMESH_M_GEOMETRY_EXTERNAL_SOURCE says otherwise
+        subLod->lodSource = currentLod;
+
         subLod->operationType = OT_TRIANGLE_LIST;
 
         uint16 streamID = readChunk( stream );
@@ -1029,7 +1429,7 @@ namespace Ogre
                         Exception::ERR_INVALIDPARAMS,
                         "Submesh contains both M_SUBMESH_M_GEOMETRY and "
                         "M_SUBMESH_M_GEOMETRY_EXTERNAL_SOURCE streams. They're mutually exclusive. " +
-                            pMesh->getName(),
+                            stream->getName(),
                         "MeshSerializerImpl::readSubMeshLod" );
                 }
                 readGeometry( stream, subLod );
@@ -1041,7 +1441,7 @@ namespace Ogre
                     OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
                                  "Submesh contains both M_SUBMESH_M_GEOMETRY_EXTERNAL_SOURCE "
                                  "and M_SUBMESH_M_GEOMETRY streams. They're mutually exclusive. " +
-                                     pMesh->getName(),
+                                     stream->getName(),
                                  "MeshSerializerImpl::readSubMeshLod" );
                 }
 
@@ -1053,7 +1453,7 @@ namespace Ogre
                 break;
 
             default:
-                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Invalid stream in " + pMesh->getName(),
+                OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Invalid stream in " + stream->getName(),
                              "MeshSerializerImpl::readSubMeshLod" );
                 break;
             }
@@ -1235,6 +1635,24 @@ namespace Ogre
         return size;
     }
     //---------------------------------------------------------------------
+    size_t MeshSerializerImpl::calcMeshClustersSize( const Mesh *pMesh )
+    {
+        size_t size = MSTREAM_OVERHEAD_SIZE;
+        for( const SubMesh *s : pMesh->getSubMeshes() )
+        {
+            // uint8 numLodLevels
+            size += sizeof( uint8 );
+            for( const MeshClusterArray &clusters : s->mClusters )
+            {
+                // uint32 numClusters
+                size += sizeof( uint32 );
+                // float center[3], radius, coneAxis[3], coneCos; uint32 indexStart, indexCount
+                size += clusters.size() * ( sizeof( float ) * 8u + sizeof( uint32 ) * 2u );
+            }
+        }
+        return size;
+    }
+    //---------------------------------------------------------------------
     size_t MeshSerializerImpl::calcSkeletonLinkSize( const String &skelName )
     {
         size_t size = MSTREAM_OVERHEAD_SIZE;
@@ -30,15 +30,42 @@ THE SOFTWARE.
 #include "OgreMeshManager2.h"
 
 #include "OgreException.h"
+#include "OgreLogManager.h"
 #include "OgreMatrix4.h"
 #include "OgreMesh2.h"
+#include "OgreMesh2SerializerImpl.h"
 #include "OgreMeshManager.h"
 #include "OgrePatchMesh.h"
 #include "OgrePrefabFactory.h"
+#include "OgreRoot.h"
 #include "OgreSubMesh2.h"
 
 namespace Ogre
 {
+    /** LODs of a Mesh being streamed in. See Mesh::msLodStreaming.
+        Shared by the main thread, which fills the request & creates the Vaos,
+        and the worker thread, which only reads the stream into lods.
+    */
+    struct LodStreamingRequest
+    {
+        MeshPtr           mesh;
+        uint32            ticket;
+        uint8             firstLod;
+        uint8             endLod;
+        bool              flipEndian;
+        FastArray<size_t> chunkOffsets;
+        /// Opened by the main thread
+        DataStreamPtr stream;
+        /// Filled by the worker thread
+        MeshSerializerImpl::SubMeshLodVec lods;
+
+        // createStreamedLodVaos takes the data. Whatever is left (i.e. the Mesh got
+        // unloaded or the request got aborted) is freed here.
+        ~LodStreamingRequest() { MeshSerializerImpl::freeSubMeshLods( lods ); }
+    };
+
+    typedef SharedPtr<LodStreamingRequest> LodStreamingRequestPtr;
+
     template <>
     MeshManager *Singleton<MeshManager>::msSingleton = 0;
     //-----------------------------------------------------------------------
@@ -49,7 +76,13 @@ namespace Ogre
         return ( *msSingleton );
     }
     //-----------------------------------------------------------------------
-    MeshManager::MeshManager() : mVaoManager( 0 ), mBoundsPaddingFactor( Real( 0.01 ) )
+    MeshManager::MeshManager() :
+        mVaoManager( 0 ),
+        mBoundsPaddingFactor( Real( 0.01 ) ),
+        mLodStreamingBudget( std::numeric_limits<size_t>::max() ),
+        mLodStreamingUsage( 0u ),
+        mLodStreamingTicket( 0u ),
+        mWorkQueueChannel( 0u )
     {
         mLoadOrder = 300.0f;
         mResourceType = "Mesh2";
@@ -59,6 +92,14 @@ namespace Ogre
     //-----------------------------------------------------------------------
     MeshManager::~MeshManager()
     {
+        if( mWorkQueueChannel )
+        {
+            WorkQueue *wq = Root::getSingleton().getWorkQueue();
+            wq->abortRequestsByChannel( mWorkQueueChannel );
+            wq->removeRequestHandler( mWorkQueueChannel, this );
+            wq->removeResponseHandler( mWorkQueueChannel, this );
+        }
+
         ResourceGroupManager::getSingleton()._unregisterResourceManager( mResourceType );
     }
     //-----------------------------------------------------------------------
@@ -178,6 +219,174 @@ namespace Ogre
             meshV1->unload();
     }
     //-----------------------------------------------------------------------
+    void MeshManager::_addLodStreamingMesh( Mesh *mesh )
+    {
+        if( !mWorkQueueChannel )
+        {
+            WorkQueue *wq = Root::getSingleton().getWorkQueue();
+            mWorkQueueChannel = wq->getChannel( "Ogre/MeshLodStreaming" );
+            wq->addRequestHandler( mWorkQueueChannel, this );
+            wq->addResponseHandler( mWorkQueueChannel, this );
+        }
+
+        mesh->_getLodStreamingInfo()->ticket = ++mLodStreamingTicket;
+        mLodStreamingMeshes.push_back( mesh );
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::_removeLodStreamingMesh( Mesh *mesh )
+    {
+        MeshVec::iterator itor =
+            std::find( mLodStreamingMeshes.begin(), mLodStreamingMeshes.end(), mesh );
+        if( itor != mLodStreamingMeshes.end() )
+            efficientVectorRemove( mLodStreamingMeshes, itor );
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::_updateLodStreaming()
+    {
+        if( mLodStreamingMeshes.empty() )
+            return;
+
+        const unsigned long currentFrame = Root::getSingleton().getNextFrameNumber();
+        WorkQueue *workQueue = Root::getSingleton().getWorkQueue();
+
+        mLodStreamingUsage = 0u;
+
+        for( Mesh *mesh : mLodStreamingMeshes )
+        {
+            MeshLodStreamingInfo *info = mesh->_getLodStreamingInfo();
+            const uint8 firstResidentLod = mesh->getFirstResidentLod();
+            const size_t residentStepIdx = info->getStepIdx( firstResidentLod );
+
+            // The coarsest step never gets evicted, thus it doesn't count
+            for( size_t i = residentStepIdx; i + 1u < info->stepLods.size(); ++i )
+                mLodStreamingUsage += info->stepBytes[i];
+
+            const uint8 requestedLod = mesh->_getLodStreamingState()->requestedLod.exchange(
+                255u, std::memory_order_relaxed );
+
+            if( requestedLod == 255u )
+                continue;
+
+            if( info->getStepIdx( requestedLod ) <= residentStepIdx )
+                info->lastUsedFrame = currentFrame;
+
+            if( requestedLod < firstResidentLod && info->pendingLod == 255u )
+            {
+                // Stream in every step up to the requested one at once
+                LodStreamingRequestPtr request(
+                    OGRE_NEW_T( LodStreamingRequest, MEMCATEGORY_GENERAL )(), SPFM_DELETE_T );
+                request->ticket = info->ticket;
+                request->firstLod = info->stepLods[info->getStepIdx( requestedLod )];
+                request->endLod = firstResidentLod;
+                request->flipEndian = info->flipEndian;
+
+                for( size_t i = 0; i < info->chunkOffsets.size(); i += info->numLods )
+                {
+                    request->chunkOffsets.appendPOD(
+                        info->chunkOffsets.begin() + i + request->firstLod,
+                        info->chunkOffsets.begin() + i + request->endLod );
+                }
+
+                // If the file can't be opened we leave pendingLod set,
+                // so we don't keep retrying every frame.
+                info->pendingLod = request->firstLod;
+
+                // Resource locations & listeners aren't thread safe. Only the worker
+                // thread reads from the stream, and it never touches the Mesh.
+                try
+                {
+                    request->stream = ResourceGroupManager::getSingleton().openResource(
+                        mesh->getName(), mesh->getGroup(), true, mesh );
+                }
+                catch( Exception &e )
+                {
+                    LogManager::getSingleton().logMessage( "Failed to stream in LODs of Mesh " +
+                                                               mesh->getName() + ": " +
+                                                               e.getFullDescription(),
+                                                           LML_CRITICAL );
+                    continue;
+                }
+
+                request->mesh = std::static_pointer_cast<Mesh>( getByHandle( mesh->getHandle() ) );
+                workQueue->addRequest( mWorkQueueChannel, 0u, Any( request ) );
+            }
+        }
+
+        // Evict the finest steps of the meshes that went unused for the longest.
+        // Meshes used this frame are left alone, so we don't thrash.
+        while( mLodStreamingUsage > mLodStreamingBudget )
+        {
+            Mesh *lruMesh = 0;
+            unsigned long lruFrame = currentFrame;
+
+            for( Mesh *mesh : mLodStreamingMeshes )
+            {
+                const MeshLodStreamingInfo *info = mesh->_getLodStreamingInfo();
+                if( info->lastUsedFrame < lruFrame && info->pendingLod == 255u &&
+                    mesh->getFirstResidentLod() < info->stepLods.back() )
+                {
+                    lruMesh = mesh;
+                    lruFrame = info->lastUsedFrame;
+                }
+            }
+
+            if( !lruMesh )
+                break;
+
+            mLodStreamingUsage -= lruMesh->_evictLodStep();
+        }
+    }
+    //-----------------------------------------------------------------------
+    WorkQueue::Response *MeshManager::handleRequest( const WorkQueue::Request *req,
+                                                     const WorkQueue *srcQ )
+    {
+        const LodStreamingRequestPtr &request = any_cast<LodStreamingRequestPtr>( req->getData() );
+
+        try
+        {
+            MeshSerializerImpl serializer( mVaoManager );
+            serializer.readStreamedLods( request->stream, request->flipEndian, request->chunkOffsets,
+                                         request->firstLod, request->endLod, request->lods );
+        }
+        catch( Exception &e )
+        {
+            return OGRE_NEW WorkQueue::Response( req, false, req->getData(), e.getFullDescription() );
+        }
+
+        return OGRE_NEW WorkQueue::Response( req, true, req->getData() );
+    }
+    //-----------------------------------------------------------------------
+    void MeshManager::handleResponse( const WorkQueue::Response *res, const WorkQueue *srcQ )
+    {
+        const LodStreamingRequestPtr &request = any_cast<LodStreamingRequestPtr>( res->getData() );
+
+        // Close the file now, rather than whenever the Response gets deleted
+        request->stream.reset();
+
+        Mesh *mesh = request->mesh.get();
+        MeshLodStreamingInfo *info = mesh->_getLodStreamingInfo();
+
+        if( !info || info->ticket != request->ticket || !res->succeeded() )
+        {
+            // Either the Mesh got unloaded meanwhile, or the file can't be read. In the
+            // latter case we leave pendingLod set, so we don't keep retrying every frame.
+            if( !res->succeeded() )
+            {
+                LogManager::getSingleton().logMessage(
+                    "Failed to stream in LODs of Mesh " + mesh->getName() + ": " + res->getMessages(),
+                    LML_CRITICAL );
+            }
+            return;
+        }
+
+        MeshSerializerImpl serializer( mVaoManager );
+        serializer.createStreamedLodVaos( mesh, request->lods, request->firstLod, request->endLod );
+
+        mesh->_setFirstResidentLod( request->firstLod );
+        info->pendingLod = 255u;
+        info->lastUsedFrame = Root::getSingleton().getNextFrameNumber();
+    }
+    //-----------------------------------------------------------------------
     Real MeshManager::getBoundsPaddingFactor() { return mBoundsPaddingFactor; }
     //-----------------------------------------------------------------------
     void MeshManager::setBoundsPaddingFactor( Real paddingFactor )
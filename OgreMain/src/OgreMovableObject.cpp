@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include "OgreMovableObject.h"
 
 #include "Animation/OgreSkeletonInstance.h"
+#include "Math/Array/OgreArrayDispatch.h"
 #include "Math/Array/OgreArraySphere.h"
 #include "Math/Array/OgreBooleanMask.h"
 #include "OgreCamera.h"
@@ -67,6 +68,7 @@ namespace Ogre
         mManager( manager ),
         mLodMesh( &c_DefaultLodMesh ),
         mCurrentMeshLod( 0 ),
+        mLodMeshStreaming( 0 ),
         mMinPixelSize( 0 ),
         mListener( 0 ),
         mSkeletonInstance( 0 ),
@@ -91,6 +93,7 @@ namespace Ogre
         mManager( 0 ),
         mLodMesh( &c_DefaultLodMesh ),
         mCurrentMeshLod( 0 ),
+        mLodMeshStreaming( 0 ),
         mMinPixelSize( 0 ),
         mListener( 0 ),
         mSkeletonInstance( 0 ),
@@ -166,7 +169,10 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
-    void MovableObject::resetMeshLod() { mCurrentMeshLod = 0u; }
+    void MovableObject::resetMeshLod()
+    {
+        mCurrentMeshLod = mLodMeshStreaming ? mLodMeshStreaming->firstResidentLod : 0u;
+    }
     //-----------------------------------------------------------------------
     bool MovableObject::isStatic() const
     {
@@ -367,7 +373,7 @@ namespace Ogre
         return mWorldBoundingSphere;
     }*/
     //-----------------------------------------------------------------------
-    void MovableObject::updateAllBounds( const size_t numNodes, ObjectData objData )
+    static FORCEINLINE void updateAllBoundsImpl( const size_t numNodes, ObjectData objData )
     {
         SimpleMatrix4 mats[ARRAY_PACKED_REALS];
         for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
@@ -414,16 +420,37 @@ namespace Ogre
             objData.mWorldAabb->transformAffine( parentMat );
             *worldRadius = ( *localRadius ) * parentScale.getMaxComponent();
 
+            objData.advanceBoundsPack();
+        }
+    }
+    //-----------------------------------------------------------------------
+#if OGRE_ARRAY_DISPATCH_AVX2
+    OGRE_ARRAY_TARGET_AVX2 static void updateAllBoundsAvx2( const size_t numNodes, ObjectData objData )
+    {
+        updateAllBoundsImpl( numNodes, objData );
+    }
+#endif
+    //-----------------------------------------------------------------------
+    void MovableObject::updateAllBounds( const size_t numNodes, ObjectData objData )
+    {
+#if OGRE_ARRAY_DISPATCH_AVX2
+        if( ArrayDispatch::useAvx2() )
+            updateAllBoundsAvx2( numNodes, objData );
+        else
+#endif
+            updateAllBoundsImpl( numNodes, objData );
+
 #if OGRE_DEBUG_MODE
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
             {
                 if( objData.mOwner[j] )
                     objData.mOwner[j]->mCachedAabbOutOfDate = false;
             }
-#endif
-
             objData.advanceBoundsPack();
         }
+#endif
     }
     //-----------------------------------------------------------------------
     inline ArrayReal MovableObject::calculateCameraDistance( uint32 _cameraSortMode,
@@ -451,6 +478,35 @@ namespace Ogre
         return cameraDir.dotProduct( worldAabb->mCenter - cameraPos ) - *worldRadius;
     }
     //-----------------------------------------------------------------------
+    void MovableObject::_updateCachedDistanceToCamera( const Camera *camera )
+    {
+        const Vector3 center = mObjectData.mWorldAabb->getAsAabb( mObjectData.mIndex ).mCenter;
+        const Real worldRadius = mObjectData.mWorldRadius[mObjectData.mIndex];
+        const Vector3 &cameraPos = camera->_getCachedDerivedPosition();
+        const Vector3 cameraDir = -camera->_getCachedDerivedOrientation().zAxis();
+
+        Real distance;
+        switch( camera->mSortMode )
+        {
+        case Camera::SortModeDistance:
+            distance = cameraPos.distance( center ) - worldRadius;
+            break;
+        case Camera::SortModeDistanceRadiusIgnoring:
+            distance = cameraPos.distance( center );
+            break;
+        case Camera::SortModeDepthRadiusIgnoring:
+            distance = cameraDir.dotProduct( center - cameraPos );
+            break;
+        case Camera::SortModeDepth:
+        default:
+            distance = cameraDir.dotProduct( center - cameraPos ) - worldRadius;
+            break;
+        }
+
+        reinterpret_cast<Real *RESTRICT_ALIAS>( mObjectData.mDistanceToCamera )[mObjectData.mIndex] =
+            distance;
+    }
+    //-----------------------------------------------------------------------
     void MovableObject::cullFrustumPrepare( const Camera *frustum, uint32 sceneVisibilityFlags,
                                             const Camera *lodCamera, CullFrustumPreparedData &pd )
     {
@@ -466,7 +522,9 @@ namespace Ogre
 
         pd.includeNonCasters = Mathlib::SetAll( includeNonCastersTest );
 
+        pd.cameraSortMode = frustum->mSortMode;
         pd.isShadowMappingCasterPass = includeNonCastersTest == 0;
+        pd.updateDistanceToCamera = true;
 
         sceneVisibilityFlags &= RESERVED_VISIBILITY_FLAGS;
 
@@ -486,9 +544,9 @@ namespace Ogre
             CastIntToReal( Mathlib::SetAll( lodCamera->getUseRenderingDistance() ? 0 : 0xffffffff ) );
     }
     //-----------------------------------------------------------------------
-    void MovableObject::cullFrustum( const size_t numNodes, ObjectData objData, const Camera *frustum,
-                                     MovableObjectArray &outCulledObjects,
-                                     const CullFrustumPreparedData &pd )
+    FORCEINLINE void MovableObject::cullFrustumImpl( const size_t numNodes, ObjectData objData,
+                                                     MovableObjectArray &outCulledObjects,
+                                                     const CullFrustumPreparedData &pd )
     {
         // On threaded environments, the internal variables from outCulledObjects cause
         // a false cache sharing because they're too close to each other. Perfoming
@@ -500,10 +558,11 @@ namespace Ogre
         const ArrayVector3 cameraDir = pd.cameraDir;
         const ArrayVector3 lodCameraPos = pd.lodCameraPos;
 
-        const Camera::CameraSortMode cameraSortMode = frustum->mSortMode;
+        const uint32 cameraSortMode = pd.cameraSortMode;
 
         const ArrayInt includeNonCasters = pd.includeNonCasters;
         const bool isShadowMappingCasterPass = pd.isShadowMappingCasterPass;
+        const bool updateDistanceToCamera = pd.updateDistanceToCamera;
 
         const ArrayInt sceneFlags = pd.sceneFlags;
         const ArrayPlane *RESTRICT_ALIAS planes = pd.planes;
@@ -578,8 +637,11 @@ namespace Ogre
                 Mathlib::TestFlags4( Mathlib::Or( *visibilityFlags, includeNonCasters ),
                                      Mathlib::SetAll( LAYER_SHADOW_CASTER ) ) );
 
-            *distanceToCamera = calculateCameraDistance( cameraSortMode, cameraPos, cameraDir,
-                                                         objData.mWorldAabb, worldRadius );
+            if( updateDistanceToCamera )
+            {
+                *distanceToCamera = calculateCameraDistance( cameraSortMode, cameraPos, cameraDir,
+                                                             objData.mWorldAabb, worldRadius );
+            }
 
             // Fuse result with visibility flag
             // finalMask = ((visible|infinite_aabb) & sceneFlags & visibilityFlags) != 0 ? 0xffffffff : 0
@@ -606,6 +668,30 @@ namespace Ogre
         culledObjects.swap( outCulledObjects );
     }
     //-----------------------------------------------------------------------
+#if OGRE_ARRAY_DISPATCH_AVX2
+    OGRE_ARRAY_TARGET_AVX2 void MovableObject::cullFrustumAvx2( const size_t numNodes,
+                                                                ObjectData objData,
+                                                                MovableObjectArray &outCulledObjects,
+                                                                const CullFrustumPreparedData &pd )
+    {
+        cullFrustumImpl( numNodes, objData, outCulledObjects, pd );
+    }
+#endif
+    //-----------------------------------------------------------------------
+    void MovableObject::cullFrustum( const size_t numNodes, ObjectData objData, const Camera *frustum,
+                                     MovableObjectArray &outCulledObjects,
+                                     const CullFrustumPreparedData &pd )
+    {
+#if OGRE_ARRAY_DISPATCH_AVX2
+        if( ArrayDispatch::useAvx2() )
+        {
+            cullFrustumAvx2( numNodes, objData, outCulledObjects, pd );
+            return;
+        }
+#endif
+        cullFrustumImpl( numNodes, objData, outCulledObjects, pd );
+    }
+    //-----------------------------------------------------------------------
     void MovableObject::cullLights( const size_t numNodes, ObjectData objData, uint32 sceneLightMask,
                                     LightListInfo &outGlobalLightList, const FrustumVec &frustums,
                                     const FrustumVec &cubemapFrustums )
@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include "OgreNode.h"
 
+#include "Math/Array/OgreArrayDispatch.h"
 #include "Math/Array/OgreBooleanMask.h"
 #include "Math/Array/OgreNodeMemoryManager.h"
 #include "OgreCamera.h"
@@ -394,7 +395,7 @@ namespace Ogre
 #endif
     }
     //-----------------------------------------------------------------------
-    void Node::updateAllTransforms( const size_t numNodes, Transform t )
+    static FORCEINLINE void updateAllTransformsImpl( const size_t numNodes, Transform t )
     {
         ArrayMatrix4 derivedTransform;
         for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
@@ -406,7 +407,7 @@ namespace Ogre
 
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
             {
-                const Transform &parentTransform = t.mParents[j]->mTransform;
+                const Transform &parentTransform = t.mParents[j]->_getTransform();
                 const Matrix4 &parentFullTransform =
                     parentTransform.mDerivedTransform[parentTransform.mIndex];
 
@@ -454,7 +455,7 @@ namespace Ogre
             {
                 Vector3 pos, scale;
                 Quaternion qRot;
-                const Transform &parentTransform = t.mParents[j]->mTransform;
+                const Transform &parentTransform = t.mParents[j]->_getTransform();
                 parentTransform.mDerivedPosition->getAsVector3( pos, parentTransform.mIndex );
                 parentTransform.mDerivedOrientation->getAsQuaternion( qRot, parentTransform.mIndex );
                 parentTransform.mDerivedScale->getAsVector3( scale, parentTransform.mIndex );
@@ -484,16 +485,37 @@ namespace Ogre
                                             *t.mDerivedOrientation );
             derivedTransform.storeToAoS( t.mDerivedTransform );
 #endif
+            t.advancePack();
+        }
+    }
+    //-----------------------------------------------------------------------
+#if OGRE_ARRAY_DISPATCH_AVX2
+    OGRE_ARRAY_TARGET_AVX2 static void updateAllTransformsAvx2( const size_t numNodes, Transform t )
+    {
+        updateAllTransformsImpl( numNodes, t );
+    }
+#endif
+    //-----------------------------------------------------------------------
+    void Node::updateAllTransforms( const size_t numNodes, Transform t )
+    {
+#if OGRE_ARRAY_DISPATCH_AVX2
+        if( ArrayDispatch::useAvx2() )
+            updateAllTransformsAvx2( numNodes, t );
+        else
+#endif
+            updateAllTransformsImpl( numNodes, t );
+
 #if OGRE_DEBUG_MODE >= OGRE_DEBUG_MEDIUM
+        for( size_t i = 0; i < numNodes; i += ARRAY_PACKED_REALS )
+        {
             for( size_t j = 0; j < ARRAY_PACKED_REALS; ++j )
             {
                 if( t.mOwner[j] )
                     t.mOwner[j]->mCachedTransformOutOfDate = false;
             }
-#endif
-
             t.advancePack();
         }
+#endif
     }
     //-----------------------------------------------------------------------
     Node *Node::createChild( SceneMemoryMgrTypes sceneType, const Vector3 &inTranslate,
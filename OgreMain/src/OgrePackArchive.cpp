@@ -0,0 +1,1028 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "OgrePackArchive.h"
+
+#include "OgreException.h"
+#include "OgreLogManager.h"
+#include "OgrePlatformInformation.h"
+#include "OgreString.h"
+#include "OgreStringVector.h"
+#include "Threading/OgreLightweightMutex.h"
+#include "Threading/OgreThreads.h"
+#include "ogrestd/set.h"
+
+#include <atomic>
+#include <exception>
+#include <fstream>
+
+#include <sys/stat.h>
+
+#if OGRE_NO_ZIP_ARCHIVE == 0
+#    include <zlib.h>
+#endif
+
+#define OGRE_PACK_MAGIC 0x4B41504F  // 'OPAK'
+#define OGRE_PACK_VERSION 1u
+
+namespace Ogre
+{
+    uint32 PackArchive::msNumDecompressionThreads = 0u;
+    size_t PackArchive::msParallelMinSize = 1024u * 1024u;
+
+    struct PackHeader
+    {
+        uint32 magic;
+        uint32 version;
+        uint32 blockSize;
+        uint32 numEntries;
+        uint64 tocOffset;
+        uint64 tocSize;
+    };
+
+    struct PackBlock
+    {
+        uint64 offset;
+        uint32 compressedSize;
+    };
+
+    struct PackEntry
+    {
+        String name;
+        uint64 size;
+        int64  modifiedTime;
+        uint8  codec;
+        size_t firstBlock;
+        size_t numBlocks;
+        uint64 compressedSize;
+    };
+
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    // LZ4 block format. See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+    // The compressor is a plain greedy one; it favours speed over ratio.
+    static const size_t c_lz4MinMatch = 4u;
+    static const size_t c_lz4LastLiterals = 5u;
+    static const size_t c_lz4MatchLimit = 12u;
+    static const uint32 c_lz4HashLog = 12u;
+
+    static inline uint32 lz4Read32( const uint8 *p )
+    {
+        uint32 value;
+        memcpy( &value, p, sizeof( value ) );
+        return value;
+    }
+    //-----------------------------------------------------------------------
+    static inline bool lz4WriteLength( size_t length, uint8 *&op, const uint8 *oend )
+    {
+        for( ; length >= 255u; length -= 255u )
+        {
+            if( op >= oend )
+                return false;
+            *op++ = 255u;
+        }
+        if( op >= oend )
+            return false;
+        *op++ = static_cast<uint8>( length );
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    static bool lz4WriteSequence( const uint8 *literals, size_t numLiterals, size_t offset,
+                                  size_t matchLength, uint8 *&op, const uint8 *oend )
+    {
+        if( op >= oend )
+            return false;
+
+        uint8 *token = op++;
+        *token = static_cast<uint8>( std::min<size_t>( numLiterals, 15u ) << 4u );
+        if( numLiterals >= 15u && !lz4WriteLength( numLiterals - 15u, op, oend ) )
+            return false;
+
+        if( numLiterals > static_cast<size_t>( oend - op ) )
+            return false;
+        memcpy( op, literals, numLiterals );
+        op += numLiterals;
+
+        if( matchLength == 0u )
+            return true;  // Last sequence; literals only
+
+        if( oend - op < 2 )
+            return false;
+        *op++ = static_cast<uint8>( offset & 0xFF );
+        *op++ = static_cast<uint8>( offset >> 8u );
+
+        matchLength -= c_lz4MinMatch;
+        *token |= static_cast<uint8>( std::min<size_t>( matchLength, 15u ) );
+        if( matchLength >= 15u && !lz4WriteLength( matchLength - 15u, op, oend ) )
+            return false;
+
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    /// Returns the compressed size, 0 if it doesn't fit in dstCapacity
+    static size_t lz4Compress( const uint8 *src, size_t srcSize, uint8 *dst, size_t dstCapacity )
+    {
+        uint32 hashTable[1u << c_lz4HashLog];
+        memset( hashTable, 0, sizeof( hashTable ) );  // Stores position + 1; 0 means empty
+
+        uint8 *op = dst;
+        const uint8 *oend = dst + dstCapacity;
+
+        size_t anchor = 0u;
+        size_t ip = 0u;
+
+        if( srcSize > c_lz4MatchLimit )
+        {
+            const size_t matchStartLimit = srcSize - c_lz4MatchLimit;
+            const size_t matchEndLimit = srcSize - c_lz4LastLiterals;
+
+            while( ip < matchStartLimit )
+            {
+                const uint32 sequence = lz4Read32( src + ip );
+                const uint32 hash = ( sequence * 2654435761u ) >> ( 32u - c_lz4HashLog );
+                const size_t ref = hashTable[hash];
+                hashTable[hash] = static_cast<uint32>( ip + 1u );
+
+                if( ref == 0u || ip - ( ref - 1u ) > 0xFFFFu ||
+                    lz4Read32( src + ref - 1u ) != sequence )
+                {
+                    ++ip;
+                    continue;
+                }
+
+                const size_t matchPos = ref - 1u;
+                size_t matchEnd = ip + c_lz4MinMatch;
+                while( matchEnd < matchEndLimit && src[matchEnd] == src[matchPos + matchEnd - ip] )
+                    ++matchEnd;
+
+                if( !lz4WriteSequence( src + anchor, ip - anchor, ip - matchPos, matchEnd - ip, op,
+                                       oend ) )
+                {
+                    return 0u;
+                }
+
+                ip = matchEnd;
+                anchor = ip;
+            }
+        }
+
+        if( !lz4WriteSequence( src + anchor, srcSize - anchor, 0u, 0u, op, oend ) )
+            return 0u;
+
+        return static_cast<size_t>( op - dst );
+    }
+    //-----------------------------------------------------------------------
+    static inline bool lz4ReadLength( size_t &length, const uint8 *&ip, const uint8 *iend )
+    {
+        uint8 value;
+        do
+        {
+            if( ip >= iend )
+                return false;
+            value = *ip++;
+            length += value;
+        } while( value == 255u );
+        return true;
+    }
+    //-----------------------------------------------------------------------
+    /// Returns false if src is corrupt or doesn't decompress to exactly dstSize bytes
+    static bool lz4Decompress( const uint8 *src, size_t srcSize, uint8 *dst, size_t dstSize )
+    {
+        const uint8 *ip = src;
+        const uint8 *iend = src + srcSize;
+        uint8 *op = dst;
+        const uint8 *oend = dst + dstSize;
+
+        while( ip < iend )
+        {
+            const uint8 token = *ip++;
+
+            size_t numLiterals = token >> 4u;
+            if( numLiterals == 15u && !lz4ReadLength( numLiterals, ip, iend ) )
+                return false;
+            if( numLiterals > static_cast<size_t>( iend - ip ) ||
+                numLiterals > static_cast<size_t>( oend - op ) )
+            {
+                return false;
+            }
+            memcpy( op, ip, numLiterals );
+            ip += numLiterals;
+            op += numLiterals;
+
+            if( ip == iend )
+                break;  // Last sequence has no match
+
+            if( iend - ip < 2 )
+                return false;
+            const size_t offset = size_t( ip[0] ) | ( size_t( ip[1] ) << 8u );
+            ip += 2;
+            if( offset == 0u || offset > static_cast<size_t>( op - dst ) )
+                return false;
+
+            size_t matchLength = token & 0x0Fu;
+            if( matchLength == 15u && !lz4ReadLength( matchLength, ip, iend ) )
+                return false;
+            matchLength += c_lz4MinMatch;
+            if( matchLength > static_cast<size_t>( oend - op ) )
+                return false;
+
+            const uint8 *match = op - offset;
+            if( offset >= matchLength )
+            {
+                memcpy( op, match, matchLength );
+                op += matchLength;
+            }
+            else
+            {
+                // Overlapping copy (e.g. runs of the same byte)
+                for( size_t i = 0u; i < matchLength; ++i )
+                    *op++ = *match++;
+            }
+        }
+
+        return op == oend;
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    /// The contents of a pack file. Shared by PackArchive and all the streams it opened,
+    /// so that streams outlive unloading the archive.
+    class PackFile : public OgreAllocatedObj
+    {
+        String mName;
+        /// The whole pack file. Empty when it couldn't be mapped
+        DataStreamPtr mMapped;
+        const uint8  *mMappedData;
+        /// Used instead of mMapped when it couldn't be mapped. Guarded by mMutex
+        std::ifstream    mFile;
+        LightweightMutex mMutex;
+        uint64           mFileSize;
+
+    public:
+        uint32                     mBlockSize;
+        vector<PackBlock>::type    mBlocks;
+        vector<PackEntry>::type    mEntries;
+
+        PackFile( const String &name );
+
+        /// Returns size bytes at the given offset. Either a pointer to the mapping or to
+        /// scratch, which gets resized as needed. Thread safe.
+        const uint8 *getRaw( uint64 offset, size_t size, vector<uint8>::type &scratch );
+
+        /// Returns a pointer to the uncompressed data of an entry if it's stored as is in
+        /// the mapped file. Null otherwise.
+        const uint8 *getStoredPtr( const PackEntry &entry ) const;
+
+        /// Returns the uncompressed size of block blockIdx of the entry.
+        size_t getBlockSize( const PackEntry &entry, size_t blockIdx ) const
+        {
+            const uint64 blockStart = uint64( blockIdx ) * mBlockSize;
+            return static_cast<size_t>( std::min<uint64>( mBlockSize, entry.size - blockStart ) );
+        }
+
+        /// Decompresses block blockIdx of the entry into dst, which must hold getBlockSize
+        /// bytes. Thread safe.
+        void decompressBlock( const PackEntry &entry, size_t blockIdx, uint8 *dst,
+                              vector<uint8>::type &scratch );
+    };
+
+    /// Bounds-checked reader for the table of contents
+    struct PackTocReader
+    {
+        const uint8 *data;
+        size_t       size;
+        size_t       pos;
+        bool         valid;
+
+        template <typename T>
+        T read()
+        {
+            T value = T();
+            if( size - pos >= sizeof( T ) )
+                memcpy( &value, data + pos, sizeof( T ) );
+            else
+                valid = false;
+            pos = valid ? pos + sizeof( T ) : size;
+            return value;
+        }
+
+        String readString( size_t length )
+        {
+            if( size - pos < length )
+            {
+                valid = false;
+                pos = size;
+                return String();
+            }
+            String value( reinterpret_cast<const char *>( data + pos ), length );
+            pos += length;
+            return value;
+        }
+    };
+    //-----------------------------------------------------------------------
+    PackFile::PackFile( const String &name ) : mName( name ), mMappedData( 0 ), mFileSize( 0 )
+    {
+        try
+        {
+            mMapped.reset( OGRE_NEW MappedFileDataStream( name, name ) );
+            mMappedData = mMapped->getDataPtr();
+            mFileSize = mMapped->size();
+        }
+        catch( Exception & )
+        {
+            // Not mappable (e.g. too big for the address space). Use std::ifstream instead
+            mMapped.reset();
+            mFile.open( name.c_str(), std::ios::in | std::ios::binary );
+            if( mFile.fail() )
+            {
+                OGRE_EXCEPT( Exception::ERR_FILE_NOT_FOUND, "Cannot open file: " + name,
+                             "PackFile::PackFile" );
+            }
+            mFile.seekg( 0, std::ios::end );
+            mFileSize = static_cast<uint64>( mFile.tellg() );
+        }
+
+        const String corruptMsg = "Not a valid pack file: " + name;
+
+        PackHeader header;
+        if( mFileSize < sizeof( header ) )
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, corruptMsg, "PackFile::PackFile" );
+
+        vector<uint8>::type scratch;
+        memcpy( &header, getRaw( 0u, sizeof( header ), scratch ), sizeof( header ) );
+
+        if( header.magic != OGRE_PACK_MAGIC || header.version != OGRE_PACK_VERSION ||
+            header.blockSize == 0u || header.tocOffset < sizeof( header ) ||
+            header.tocOffset > mFileSize || header.tocSize > mFileSize - header.tocOffset )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, corruptMsg, "PackFile::PackFile" );
+        }
+
+        mBlockSize = header.blockSize;
+
+        PackTocReader toc;
+        toc.data = getRaw( header.tocOffset, static_cast<size_t>( header.tocSize ), scratch );
+        toc.size = static_cast<size_t>( header.tocSize );
+        toc.pos = 0u;
+        toc.valid = true;
+
+        mEntries.resize( header.numEntries );
+        for( uint32 i = 0u; i < header.numEntries && toc.valid; ++i )
+        {
+            PackEntry &entry = mEntries[i];
+            entry.name = toc.readString( toc.read<uint16>() );
+            entry.size = toc.read<uint64>();
+            entry.modifiedTime = toc.read<int64>();
+            entry.codec = toc.read<uint8>();
+            entry.firstBlock = mBlocks.size();
+            entry.numBlocks = static_cast<size_t>( ( entry.size + mBlockSize - 1u ) / mBlockSize );
+            entry.compressedSize = 0u;
+
+            // Each block takes 12 bytes in the TOC. Check before resizing mBlocks
+            if( entry.numBlocks > ( toc.size - toc.pos ) / 12u )
+                toc.valid = false;
+
+            // The writer places the blocks of an entry contiguously, and getStoredPtr relies
+            // on it. Every block must start where the previous one ended, and the last one
+            // must end before the TOC (thus inside the file)
+            uint64 nextOffset = 0u;
+            for( size_t j = 0u; j < entry.numBlocks && toc.valid; ++j )
+            {
+                PackBlock block;
+                block.offset = toc.read<uint64>();
+                block.compressedSize = toc.read<uint32>();
+                if( block.offset < sizeof( header ) || block.offset > header.tocOffset ||
+                    block.compressedSize > header.tocOffset - block.offset ||
+                    ( j != 0u && block.offset != nextOffset ) )
+                {
+                    toc.valid = false;
+                }
+                nextOffset = block.offset + block.compressedSize;
+                entry.compressedSize += block.compressedSize;
+                mBlocks.push_back( block );
+            }
+        }
+
+        if( !toc.valid )
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, corruptMsg, "PackFile::PackFile" );
+    }
+    //-----------------------------------------------------------------------
+    const uint8 *PackFile::getRaw( uint64 offset, size_t size, vector<uint8>::type &scratch )
+    {
+        if( mMappedData )
+            return mMappedData + offset;
+
+        scratch.resize( std::max<size_t>( size, 1u ) );
+        ScopedLock lock( mMutex );
+        mFile.clear();
+        mFile.seekg( static_cast<std::streamoff>( offset ), std::ios::beg );
+        mFile.read( reinterpret_cast<char *>( scratch.data() ), static_cast<std::streamsize>( size ) );
+        if( static_cast<size_t>( mFile.gcount() ) != size )
+        {
+            OGRE_EXCEPT( Exception::ERR_INTERNAL_ERROR, "Error reading pack file: " + mName,
+                         "PackFile::getRaw" );
+        }
+        return scratch.data();
+    }
+    //-----------------------------------------------------------------------
+    const uint8 *PackFile::getStoredPtr( const PackEntry &entry ) const
+    {
+        if( !mMappedData || entry.numBlocks == 0u )
+            return 0;
+
+        // The constructor validated that the blocks of an entry are contiguous
+        for( size_t i = 0u; i < entry.numBlocks; ++i )
+        {
+            if( mBlocks[entry.firstBlock + i].compressedSize != getBlockSize( entry, i ) )
+                return 0;
+        }
+        return mMappedData + mBlocks[entry.firstBlock].offset;
+    }
+    //-----------------------------------------------------------------------
+    void PackFile::decompressBlock( const PackEntry &entry, size_t blockIdx, uint8 *dst,
+                                    vector<uint8>::type &scratch )
+    {
+        const PackBlock &block = mBlocks[entry.firstBlock + blockIdx];
+        const size_t dstSize = getBlockSize( entry, blockIdx );
+        const uint8 *src = getRaw( block.offset, block.compressedSize, scratch );
+
+        bool success = false;
+        if( block.compressedSize == dstSize )
+        {
+            memcpy( dst, src, dstSize );
+            success = true;
+        }
+        else if( entry.codec == PackArchive::CodecLz4 )
+        {
+            success = lz4Decompress( src, block.compressedSize, dst, dstSize );
+        }
+        else if( entry.codec == PackArchive::CodecDeflate )
+        {
+#if OGRE_NO_ZIP_ARCHIVE == 0
+            uLongf destLen = static_cast<uLongf>( dstSize );
+            success = uncompress( dst, &destLen, src, static_cast<uLong>( block.compressedSize ) ) ==
+                          Z_OK &&
+                      destLen == dstSize;
+#else
+            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                         "Ogre was built without zlib. Cannot read deflated entry " + entry.name +
+                             " from " + mName,
+                         "PackFile::decompressBlock" );
+#endif
+        }
+
+        if( !success )
+        {
+            OGRE_EXCEPT( Exception::ERR_INTERNAL_ERROR,
+                         "Corrupt block in entry " + entry.name + " of " + mName,
+                         "PackFile::decompressBlock" );
+        }
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    /// Seekable stream over a pack entry. Only the block containing the read position
+    /// is kept decompressed.
+    class PackDataStream final : public DataStream
+    {
+        SharedPtr<PackFile> mPackFile;
+        const PackEntry    &mEntry;
+        size_t              mPos;
+        /// Index of the block in mBlockData. Invalid if >= mEntry.numBlocks
+        size_t              mCurrentBlock;
+        vector<uint8>::type mBlockData;
+        vector<uint8>::type mScratch;
+
+    public:
+        PackDataStream( const SharedPtr<PackFile> &packFile, const PackEntry &entry ) :
+            DataStream( entry.name ),
+            mPackFile( packFile ),
+            mEntry( entry ),
+            mPos( 0u ),
+            mCurrentBlock( std::numeric_limits<size_t>::max() )
+        {
+            mSize = static_cast<size_t>( entry.size );
+        }
+
+        size_t read( void *buf, size_t count ) override
+        {
+            if( !mPackFile )
+                return 0u;
+
+            const size_t blockSize = mPackFile->mBlockSize;
+
+            uint8 *dst = reinterpret_cast<uint8 *>( buf );
+            count = std::min( count, mSize - mPos );
+            size_t totalRead = 0u;
+            while( totalRead < count )
+            {
+                const size_t blockIdx = mPos / blockSize;
+                const size_t offsetInBlock = mPos - blockIdx * blockSize;
+                const size_t currBlockSize = mPackFile->getBlockSize( mEntry, blockIdx );
+                const size_t toCopy = std::min( count - totalRead, currBlockSize - offsetInBlock );
+
+                if( offsetInBlock == 0u && toCopy == currBlockSize )
+                {
+                    // Reading the whole block. Skip the intermediate copy
+                    mPackFile->decompressBlock( mEntry, blockIdx, dst + totalRead, mScratch );
+                }
+                else
+                {
+                    if( mCurrentBlock != blockIdx )
+                    {
+                        mBlockData.resize( blockSize );
+                        mPackFile->decompressBlock( mEntry, blockIdx, mBlockData.data(), mScratch );
+                        mCurrentBlock = blockIdx;
+                    }
+                    memcpy( dst + totalRead, mBlockData.data() + offsetInBlock, toCopy );
+                }
+
+                totalRead += toCopy;
+                mPos += toCopy;
+            }
+
+            return totalRead;
+        }
+
+        void skip( long count ) override
+        {
+            const size_t newPos = static_cast<size_t>( static_cast<long>( mPos ) + count );
+            assert( newPos <= mSize );
+            mPos = std::min( newPos, mSize );
+        }
+
+        void seek( size_t pos ) override
+        {
+            assert( pos <= mSize );
+            mPos = std::min( pos, mSize );
+        }
+
+        size_t tell() const override { return mPos; }
+
+        bool eof() const override { return mPos >= mSize; }
+
+        void close() override
+        {
+            mAccess = 0;
+            mPackFile.reset();
+            mBlockData.clear();
+            mScratch.clear();
+        }
+    };
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    struct PackDecompressJob
+    {
+        PackFile           *packFile;
+        const PackEntry    *entry;
+        uint8              *dst;
+        std::atomic<size_t> nextBlock;
+        LightweightMutex    mutex;
+        std::exception_ptr  exception;  // GUARDED_BY( mutex )
+    };
+
+    static void decompressBlocks( PackDecompressJob &job )
+    {
+        const size_t numBlocks = job.entry->numBlocks;
+        const size_t blockSize = job.packFile->mBlockSize;
+        vector<uint8>::type scratch;
+        try
+        {
+            size_t blockIdx;
+            while( ( blockIdx = job.nextBlock.fetch_add( 1u ) ) < numBlocks )
+            {
+                job.packFile->decompressBlock( *job.entry, blockIdx, job.dst + blockIdx * blockSize,
+                                               scratch );
+            }
+        }
+        catch( ... )
+        {
+            ScopedLock lock( job.mutex );
+            if( !job.exception )
+                job.exception = std::current_exception();
+            job.nextBlock = numBlocks;  // Make the other threads stop
+        }
+    }
+
+    static unsigned long decompressBlocksThread( ThreadHandle *threadHandle )
+    {
+        decompressBlocks( *reinterpret_cast<PackDecompressJob *>( threadHandle->getUserParam() ) );
+        return 0;
+    }
+    THREAD_DECLARE( decompressBlocksThread );
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    PackArchive::PackArchive( const String &name, const String &archType ) :
+        Archive( name, archType )
+    {
+    }
+    //-----------------------------------------------------------------------
+    PackArchive::~PackArchive() { unload(); }
+    //-----------------------------------------------------------------------
+    void PackArchive::load()
+    {
+        if( mPackFile )
+            return;
+
+        mPackFile.reset( OGRE_NEW PackFile( mName ) );
+
+        set<String>::type folders;
+
+        const size_t numEntries = mPackFile->mEntries.size();
+        for( size_t i = 0u; i < numEntries; ++i )
+        {
+            const PackEntry &entry = mPackFile->mEntries[i];
+            mEntryLookup[entry.name] = i;
+
+            FileInfo info;
+            info.archive = this;
+            info.filename = entry.name;
+            StringUtil::splitFilename( entry.name, info.basename, info.path );
+            info.compressedSize = static_cast<size_t>( entry.compressedSize );
+            info.uncompressedSize = static_cast<size_t>( entry.size );
+            mFileList.push_back( info );
+
+            // Synthesise the folders, which aren't stored in the pack
+            String path = info.path;
+            while( !path.empty() && folders.insert( path ).second )
+            {
+                FileInfo folderInfo;
+                folderInfo.archive = this;
+                folderInfo.filename = path.substr( 0, path.size() - 1u );
+                StringUtil::splitFilename( folderInfo.filename, folderInfo.basename,
+                                           folderInfo.path );
+                folderInfo.compressedSize = size_t( -1 );
+                folderInfo.uncompressedSize = 0u;
+                mFileList.push_back( folderInfo );
+                path = folderInfo.path;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void PackArchive::unload()
+    {
+        // Streams still open keep the PackFile alive
+        mPackFile.reset();
+        mFileList.clear();
+        mEntryLookup.clear();
+    }
+    //-----------------------------------------------------------------------
+    DataStreamPtr PackArchive::decompressInParallel( size_t entryIdx )
+    {
+        const PackEntry &entry = mPackFile->mEntries[entryIdx];
+
+        uint32 numThreads = msNumDecompressionThreads;
+        if( numThreads == 0u )
+            numThreads = std::max( 1u, PlatformInformation::getNumLogicalCores() );
+        numThreads = static_cast<uint32>( std::min<size_t>( numThreads, entry.numBlocks ) );
+
+        const size_t size = static_cast<size_t>( entry.size );
+        uchar *data = OGRE_ALLOC_T( uchar, size, MEMCATEGORY_GENERAL );
+
+        PackDecompressJob job;
+        job.packFile = mPackFile.get();
+        job.entry = &entry;
+        job.dst = data;
+        job.nextBlock = 0u;
+
+        // The calling thread works too
+        ThreadHandleVec workerThreads;
+        workerThreads.resize( numThreads - 1u );
+        for( size_t i = 0u; i < workerThreads.size(); ++i )
+        {
+            workerThreads[i] =
+                Threads::CreateThread( THREAD_GET( decompressBlocksThread ), i + 1u, &job );
+        }
+        decompressBlocks( job );
+        Threads::WaitForThreads( workerThreads );
+
+        if( job.exception )
+        {
+            OGRE_FREE( data, MEMCATEGORY_GENERAL );
+            std::rethrow_exception( job.exception );
+        }
+
+        return DataStreamPtr( OGRE_NEW MemoryDataStream( entry.name, data, size, true, true ) );
+    }
+    //-----------------------------------------------------------------------
+    DataStreamPtr PackArchive::open( const String &filename, bool readOnly )
+    {
+        if( !readOnly )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Pack archives are read-only",
+                         "PackArchive::open" );
+        }
+
+        map<String, size_t>::type::const_iterator itor = mEntryLookup.find( filename );
+        if( itor == mEntryLookup.end() )
+        {
+            LogManager::getSingleton().logMessage(
+                mName + " - Unable to open file " + filename + ", file not found", LML_CRITICAL );
+            return DataStreamPtr();
+        }
+
+        const PackEntry &entry = mPackFile->mEntries[itor->second];
+
+        const uint8 *storedPtr = mPackFile->getStoredPtr( entry );
+        if( storedPtr )
+        {
+            // Served straight from the mapping. The stream keeps the mapping alive
+            SharedPtr<PackFile> packFile = mPackFile;
+            MemoryDataStream *stream = OGRE_NEW MemoryDataStream(
+                entry.name, const_cast<uint8 *>( storedPtr ), static_cast<size_t>( entry.size ),
+                false, true );
+            return DataStreamPtr( stream, [packFile]( DataStream *ptr ) { OGRE_DELETE ptr; } );
+        }
+
+        if( msNumDecompressionThreads != 1u && entry.size >= msParallelMinSize &&
+            entry.numBlocks > 1u )
+        {
+            return decompressInParallel( itor->second );
+        }
+
+        return DataStreamPtr( OGRE_NEW PackDataStream( mPackFile, entry ) );
+    }
+    //-----------------------------------------------------------------------
+    StringVectorPtr PackArchive::list( bool recursive, bool dirs )
+    {
+        StringVectorPtr ret =
+            StringVectorPtr( OGRE_NEW_T( StringVector, MEMCATEGORY_GENERAL )(), SPFM_DELETE_T );
+
+        for( const FileInfo &fi : mFileList )
+            if( ( dirs == ( fi.compressedSize == size_t( -1 ) ) ) && ( recursive || fi.path.empty() ) )
+                ret->push_back( fi.filename );
+
+        return ret;
+    }
+    //-----------------------------------------------------------------------
+    FileInfoListPtr PackArchive::listFileInfo( bool recursive, bool dirs )
+    {
+        FileInfoList *fil = OGRE_NEW_T( FileInfoList, MEMCATEGORY_GENERAL )();
+        for( const FileInfo &fi : mFileList )
+            if( ( dirs == ( fi.compressedSize == size_t( -1 ) ) ) && ( recursive || fi.path.empty() ) )
+                fil->push_back( fi );
+
+        return FileInfoListPtr( fil, SPFM_DELETE_T );
+    }
+    //-----------------------------------------------------------------------
+    StringVectorPtr PackArchive::find( const String &pattern, bool recursive, bool dirs )
+    {
+        StringVectorPtr ret =
+            StringVectorPtr( OGRE_NEW_T( StringVector, MEMCATEGORY_GENERAL )(), SPFM_DELETE_T );
+
+        FileInfoListPtr fileInfos = findFileInfo( pattern, recursive, dirs );
+        ret->reserve( fileInfos->size() );
+        for( const FileInfo &fi : *fileInfos )
+            ret->push_back( fi.filename );
+
+        return ret;
+    }
+    //-----------------------------------------------------------------------
+    FileInfoListPtr PackArchive::findFileInfo( const String &pattern, bool recursive, bool dirs )
+    {
+        FileInfoListPtr ret =
+            FileInfoListPtr( OGRE_NEW_T( FileInfoList, MEMCATEGORY_GENERAL )(), SPFM_DELETE_T );
+        // If pattern contains a directory name, do a full match
+        const bool full_match = pattern.find( '/' ) != String::npos;
+        const bool wildCard = pattern.find( "*" ) != String::npos;
+
+        for( const FileInfo &fi : mFileList )
+            if( ( dirs == ( fi.compressedSize == size_t( -1 ) ) ) &&
+                ( recursive || full_match || wildCard || fi.path.empty() ) )
+                if( StringUtil::match( full_match ? fi.filename : fi.basename, pattern, true ) )
+                    ret->push_back( fi );
+
+        return ret;
+    }
+    //-----------------------------------------------------------------------
+    bool PackArchive::exists( const String &filename )
+    {
+        return mEntryLookup.find( filename ) != mEntryLookup.end();
+    }
+    //-----------------------------------------------------------------------
+    time_t PackArchive::getModifiedTime( const String &filename )
+    {
+        map<String, size_t>::type::const_iterator itor = mEntryLookup.find( filename );
+        if( itor != mEntryLookup.end() && mPackFile->mEntries[itor->second].modifiedTime != 0 )
+            return static_cast<time_t>( mPackFile->mEntries[itor->second].modifiedTime );
+
+        // Fall back to the time of the pack itself
+        struct stat tagStat;
+        if( stat( mName.c_str(), &tagStat ) == 0 )
+            return tagStat.st_mtime;
+        return 0;
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    const String &PackArchiveFactory::getType() const
+    {
+        static String name = "Pack";
+        return name;
+    }
+    //-----------------------------------------------------------------------
+    //-----------------------------------------------------------------------
+    PackArchiveWriter::PackArchiveWriter( const String &filename, uint32 blockSize ) :
+        mFile( 0 ),
+        mFilename( filename ),
+        mBlockSize( blockSize ),
+        mNumEntries( 0u )
+    {
+        if( blockSize == 0u )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "blockSize can't be 0",
+                         "PackArchiveWriter::PackArchiveWriter" );
+        }
+
+        mFile = OGRE_NEW_T( std::ofstream, MEMCATEGORY_GENERAL )();
+        mFile->open( filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc );
+        if( mFile->fail() )
+        {
+            OGRE_DELETE_T( mFile, basic_ofstream, MEMCATEGORY_GENERAL );
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Cannot create file: " + filename,
+                         "PackArchiveWriter::PackArchiveWriter" );
+        }
+
+        // Placeholder. finish() writes the real header
+        PackHeader header;
+        memset( &header, 0, sizeof( header ) );
+        mFile->write( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+    }
+    //-----------------------------------------------------------------------
+    PackArchiveWriter::~PackArchiveWriter()
+    {
+        if( mFile )
+        {
+            try
+            {
+                finish();
+            }
+            catch( Exception &e )
+            {
+                LogManager::getSingleton().logMessage( e.getFullDescription(), LML_CRITICAL );
+                if( mFile )
+                    OGRE_DELETE_T( mFile, basic_ofstream, MEMCATEGORY_GENERAL );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    template <typename T>
+    static void appendToToc( vector<uint8>::type &toc, const T &value )
+    {
+        const size_t offset = toc.size();
+        toc.resize( offset + sizeof( T ) );
+        memcpy( toc.data() + offset, &value, sizeof( T ) );
+    }
+    //-----------------------------------------------------------------------
+    void PackArchiveWriter::writeBlock( const uint8 *data, size_t size, PackArchive::Codec codec,
+                                        vector<uint8>::type &outBlocksToc )
+    {
+        const uint8 *blockData = data;
+        size_t blockSize = size;
+
+        if( codec == PackArchive::CodecLz4 )
+        {
+            // Only keep it if it's smaller, thus a bound of size - 1
+            mCompressed.resize( size );
+            const size_t compressedSize = lz4Compress( data, size, mCompressed.data(), size - 1u );
+            if( compressedSize != 0u )
+            {
+                blockData = mCompressed.data();
+                blockSize = compressedSize;
+            }
+        }
+        else if( codec == PackArchive::CodecDeflate )
+        {
+#if OGRE_NO_ZIP_ARCHIVE == 0
+            uLongf destLen = compressBound( static_cast<uLong>( size ) );
+            mCompressed.resize( destLen );
+            if( compress2( mCompressed.data(), &destLen, data, static_cast<uLong>( size ),
+                           Z_DEFAULT_COMPRESSION ) == Z_OK &&
+                destLen < size )
+            {
+                blockData = mCompressed.data();
+                blockSize = static_cast<size_t>( destLen );
+            }
+#endif
+        }
+
+        appendToToc( outBlocksToc, static_cast<uint64>( mFile->tellp() ) );
+        appendToToc( outBlocksToc, static_cast<uint32>( blockSize ) );
+        mFile->write( reinterpret_cast<const char *>( blockData ),
+                      static_cast<std::streamsize>( blockSize ) );
+    }
+    //-----------------------------------------------------------------------
+    void PackArchiveWriter::addFile( const String &name, const void *data, size_t size,
+                                     PackArchive::Codec codec, time_t modifiedTime )
+    {
+        MemoryDataStream *memStream =
+            OGRE_NEW MemoryDataStream( name, const_cast<void *>( data ), size, false, true );
+        DataStreamPtr stream( memStream );
+        addFile( name, stream, codec, modifiedTime );
+    }
+    //-----------------------------------------------------------------------
+    void PackArchiveWriter::addFile( const String &name, DataStreamPtr &stream,
+                                     PackArchive::Codec codec, time_t modifiedTime )
+    {
+        if( !mFile )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALID_CALL, "finish() was already called",
+                         "PackArchiveWriter::addFile" );
+        }
+        if( name.size() > std::numeric_limits<uint16>::max() )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS, "Name too long: " + name,
+                         "PackArchiveWriter::addFile" );
+        }
+#if OGRE_NO_ZIP_ARCHIVE != 0
+        if( codec == PackArchive::CodecDeflate )
+        {
+            OGRE_EXCEPT( Exception::ERR_INVALIDPARAMS,
+                         "Ogre was built without zlib. CodecDeflate is not available",
+                         "PackArchiveWriter::addFile" );
+        }
+#endif
+
+        // The TOC entry needs the total size, which isn't known until all blocks are written
+        vector<uint8>::type blocksToc;
+        uint64 totalSize = 0u;
+        vector<uint8>::type blockData( mBlockSize );
+        size_t bytesRead;
+        while( ( bytesRead = stream->read( blockData.data(), mBlockSize ) ) != 0u )
+        {
+            writeBlock( blockData.data(), bytesRead, codec, blocksToc );
+            totalSize += bytesRead;
+            if( bytesRead < mBlockSize )
+                break;
+        }
+
+        appendToToc( mToc, static_cast<uint16>( name.size() ) );
+        mToc.insert( mToc.end(), name.begin(), name.end() );
+        appendToToc( mToc, totalSize );
+        appendToToc( mToc, static_cast<int64>( modifiedTime ) );
+        appendToToc( mToc, static_cast<uint8>( codec ) );
+        mToc.insert( mToc.end(), blocksToc.begin(), blocksToc.end() );
+
+        ++mNumEntries;
+
+        if( mFile->fail() )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Error writing to " + mFilename,
+                         "PackArchiveWriter::addFile" );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void PackArchiveWriter::finish()
+    {
+        if( !mFile )
+            return;
+
+        PackHeader header;
+        header.magic = OGRE_PACK_MAGIC;
+        header.version = OGRE_PACK_VERSION;
+        header.blockSize = mBlockSize;
+        header.numEntries = mNumEntries;
+        header.tocOffset = static_cast<uint64>( mFile->tellp() );
+        header.tocSize = mToc.size();
+
+        mFile->write( reinterpret_cast<const char *>( mToc.data() ),
+                      static_cast<std::streamsize>( mToc.size() ) );
+        mFile->seekp( 0, std::ios::beg );
+        mFile->write( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+
+        const bool failed = mFile->fail();
+        OGRE_DELETE_T( mFile, basic_ofstream, MEMCATEGORY_GENERAL );
+        mFile = 0;
+        mToc.clear();
+
+        if( failed )
+        {
+            OGRE_EXCEPT( Exception::ERR_CANNOT_WRITE_TO_FILE, "Error writing to " + mFilename,
+                         "PackArchiveWriter::finish" );
+        }
+    }
+}  // namespace Ogre
@@ -31,6 +31,7 @@ THE SOFTWARE.
 #include "OgrePixelFormatGpuUtils.h"
 
 #include "OgreBitwise.h"
+#include "OgreBlockCompression.h"
 #include "OgreColourValue.h"
 #include "OgreCommon.h"
 #include "OgreException.h"
@@ -1454,9 +1455,31 @@ namespace Ogre
 
         if( isCompressed( srcFormat ) || isCompressed( dstFormat ) )
         {
-            OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
-                         "This method can not be used to compress or decompress images",
-                         "PixelFormatGpuUtils::bulkPixelConversion" );
+            if( verticalFlip )
+            {
+                OGRE_EXCEPT( Exception::ERR_NOT_IMPLEMENTED,
+                             "Compressed images can not be flipped vertically",
+                             "PixelFormatGpuUtils::bulkPixelConversion" );
+            }
+
+            if( isCompressed( srcFormat ) && isCompressed( dstFormat ) )
+            {
+                // Transcode through an uncompressed image
+                const PixelFormatGpu rgbaFormat = BlockCompression::getUncompressedFormat( srcFormat );
+                const uint32 depthOrSlices = src.getDepthOrSlices();
+                TextureBox tmpBox( src.width, src.height, src.depth, src.numSlices, 4u, src.width * 4u,
+                                   src.width * src.height * 4u );
+                tmpBox.data = OGRE_MALLOC_SIMD( tmpBox.bytesPerImage * depthOrSlices,
+                                                MEMCATEGORY_RESOURCE );
+                BlockCompression::decompress( src, srcFormat, tmpBox, rgbaFormat );
+                BlockCompression::compress( tmpBox, rgbaFormat, dst, dstFormat );
+                OGRE_FREE_SIMD( tmpBox.data, MEMCATEGORY_RESOURCE );
+            }
+            else if( isCompressed( srcFormat ) )
+                BlockCompression::decompress( src, srcFormat, dst, dstFormat );
+            else
+                BlockCompression::compress( src, srcFormat, dst, dstFormat );
+            return;
         }
 
         assert( src.equalSize( dst ) );
@@ -38,6 +38,9 @@ THE SOFTWARE.
     #if _MSC_VER >= 1400
         #include <intrin.h>
     #endif
+    #if _MSC_FULL_VER >= 160040219
+        #include <immintrin.h>  // For _xgetbv
+    #endif
 #elif (OGRE_COMPILER == OGRE_COMPILER_GNUC || OGRE_COMPILER == OGRE_COMPILER_CLANG)
 #include <signal.h>
 #include <setjmp.h>
@@ -282,10 +285,89 @@ namespace Ogre {
 #endif
     }
 
+    //---------------------------------------------------------------------
+    // Reads XCR0, which tells which register states the OS saves on context switch.
+    // Must only be called if CPUID reports OSXSAVE.
+    static uint64 _readXcr0()
+    {
+#if OGRE_COMPILER == OGRE_COMPILER_MSVC
+    #if _MSC_FULL_VER >= 160040219
+        return _xgetbv( 0 );
+    #elif OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
+        // Compilers older than VS2010 SP1 don't have the intrinsic nor know the opcode
+        uint32 eaxVal, edxVal;
+        __asm
+        {
+            xor ecx, ecx
+            _emit 0x0f  // xgetbv
+            _emit 0x01
+            _emit 0xd0
+            mov eaxVal, eax
+            mov edxVal, edx
+        }
+        return ( static_cast<uint64>( edxVal ) << 32u ) | eaxVal;
+    #else
+        // x64 compilers older than VS2010 SP1 have neither _xgetbv nor inline asm.
+        // Report no YMM state; AVX stays disabled
+        return 0;
+    #endif
+#elif (OGRE_COMPILER == OGRE_COMPILER_GNUC || OGRE_COMPILER == OGRE_COMPILER_CLANG) && OGRE_PLATFORM != OGRE_PLATFORM_EMSCRIPTEN
+        uint32 eax, edx;
+        __asm__ __volatile__ ( "xgetbv" : "=a" (eax), "=d" (edx) : "c" (0) );
+        return ( static_cast<uint64>( edx ) << 32u ) | eax;
+#else
+        // Unreachable: _isSupportCpuid() returns false for this compiler, thus
+        // CPUID never reports OSXSAVE
+        return 0;
+#endif
+    }
+
     //---------------------------------------------------------------------
     // Compiler-independent routines
     //---------------------------------------------------------------------
 
+#define CPUID_STD_FMA               (1<<12)     // ECX[12] - FMA3
+#define CPUID_STD_SSE41             (1<<19)     // ECX[19] - SSE4.1
+#define CPUID_STD_SSE42             (1<<20)     // ECX[20] - SSE4.2
+#define CPUID_STD_OSXSAVE           (1<<27)     // ECX[27] - OS uses XSAVE, XGETBV is available
+#define CPUID_STD_AVX               (1<<28)     // ECX[28] - AVX
+
+#define CPUID_STD7_AVX2             (1<<5)      // EBX[5] of standard function 7, subleaf 0 - AVX2
+
+#define XCR0_SSE_AVX_STATE          0x06        // XMM & YMM state both enabled by the OS
+
+    // Checks SSE4.x / AVX / AVX2 / FMA. 'stdFeatures' must contain the result of standard function 1.
+    static uint queryExtendedSimdFeatures(uint maxStdQuery, const CpuidResult& stdFeatures)
+    {
+        uint features = 0;
+
+        if (stdFeatures._ecx & CPUID_STD_SSE41)
+            features |= PlatformInformation::CPU_FEATURE_SSE41;
+        if (stdFeatures._ecx & CPUID_STD_SSE42)
+            features |= PlatformInformation::CPU_FEATURE_SSE42;
+
+        // The CPU may support AVX, but if the OS doesn't save the YMM registers on context
+        // switch, we can't use it.
+        if ((stdFeatures._ecx & CPUID_STD_OSXSAVE) && (stdFeatures._ecx & CPUID_STD_AVX) &&
+            (_readXcr0() & XCR0_SSE_AVX_STATE) == XCR0_SSE_AVX_STATE)
+        {
+            features |= PlatformInformation::CPU_FEATURE_AVX;
+
+            if (stdFeatures._ecx & CPUID_STD_FMA)
+                features |= PlatformInformation::CPU_FEATURE_FMA;
+
+            if (maxStdQuery >= 7)
+            {
+                CpuidResult result;
+                _performCpuid(7, result);
+                if (result._ebx & CPUID_STD7_AVX2)
+                    features |= PlatformInformation::CPU_FEATURE_AVX2;
+            }
+        }
+
+        return features;
+    }
+    //---------------------------------------------------------------------
     static uint queryCpuFeatures()
     {
 #define CPUID_STD_FPU               (1<<0)
@@ -317,9 +399,11 @@ namespace Ogre {
             if (_performCpuid(0, result))
             {
                 // Check vendor strings
+                const uint maxStdQuery = result._eax;
+
                 if (memcmp(&result._ebx, "GenuineIntel", 12) == 0)
                 {
-                    if (result._eax > 2)
+                    if (maxStdQuery > 2)
                         features |= PlatformInformation::CPU_FEATURE_PRO;
 
                     // Check standard feature
@@ -341,6 +425,8 @@ namespace Ogre {
                     if (result._ecx & CPUID_STD_SSE3)
                         features |= PlatformInformation::CPU_FEATURE_SSE3;
 
+                    features |= queryExtendedSimdFeatures(maxStdQuery, result);
+
                     // Check to see if this is a Pentium 4 or later processor
                     if ((result._eax & CPUID_EXT_FAMILY_ID_MASK) ||
                         (result._eax & CPUID_FAMILY_ID_MASK) == CPUID_PENTIUM4_ID)
@@ -373,6 +459,8 @@ namespace Ogre {
                     if (result._ecx & CPUID_STD_SSE3)
                         features |= PlatformInformation::CPU_FEATURE_SSE3;
 
+                    features |= queryExtendedSimdFeatures(maxStdQuery, result);
+
                     // Has extended feature ?
                     if (_performCpuid(0x80000000, result) > 0x80000000)
                     {
@@ -723,6 +811,16 @@ namespace Ogre {
                 " *     SSE2: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_SSE2), true));
             pLog->logMessage(
                 " *     SSE3: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_SSE3), true));
+            pLog->logMessage(
+                " *   SSE4.1: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_SSE41), true));
+            pLog->logMessage(
+                " *   SSE4.2: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_SSE42), true));
+            pLog->logMessage(
+                " *      AVX: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_AVX), true));
+            pLog->logMessage(
+                " *     AVX2: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_AVX2), true));
+            pLog->logMessage(
+                " *      FMA: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_FMA), true));
             pLog->logMessage(
                 " *      MMX: " + StringConverter::toString(hasCpuFeature(CPU_FEATURE_MMX), true));
             pLog->logMessage(
@@ -33,12 +33,14 @@ THE SOFTWARE.
 #include "CommandBuffer/OgreCbPipelineStateObject.h"
 #include "CommandBuffer/OgreCbShaderBuffer.h"
 #include "CommandBuffer/OgreCommandBuffer.h"
+#include "OgreCamera.h"
 #include "OgreHardwareBufferManager.h"
 #include "OgreHlms.h"
 #include "OgreHlmsDatablock.h"
 #include "OgreHlmsManager.h"
 #include "OgreMaterial.h"
 #include "OgreMaterialManager.h"
+#include "OgreMesh2Optimizer.h"
 #include "OgreMovableObject.h"
 #include "OgrePass.h"
 #include "OgreProfiler.h"
@@ -60,6 +62,12 @@ namespace Ogre
 
     const HlmsCache c_dummyCache( 0, HLMS_MAX, HlmsPso() );
 
+    /// StableSort uses radix sort instead of std::stable_sort when there's at least these many
+    static const size_t c_radixSortThreshold = 1024u;
+    /// CoherentSort gives up on insertion sort when it performed more than these many moves
+    /// per renderable (on average) and falls back to a full sort.
+    static const size_t c_maxAvgInsertionSortMoves = 8u;
+
     // clang-format off
     const int RqBits::SubRqIdBits           = 3;
     const int RqBits::TransparencyBits      = 1;
@@ -97,7 +105,12 @@ namespace Ogre
         mLastIndexData( 0 ),
         mLastTextureHash( 0 ),
         mCommandBuffer( 0 ),
-        mRenderingStarted( 0u )
+        mRenderingStarted( 0u ),
+        mFrameCount( 0u ),
+        mParallelSortThreshold( 4096u ),
+        mParallelSortFirstRq( 0u ),
+        mParallelSortLastRq( 0u ),
+        mClusterCulling( false )
     {
         mCommandBuffer = new CommandBuffer();
 
@@ -184,6 +197,7 @@ namespace Ogre
             while( itor != endt )
             {
                 itor->q.clear();
+                itor->numExtraClusterDraws = 0u;
                 ++itor;
             }
 
@@ -264,6 +278,13 @@ namespace Ogre
 
             VertexArrayObject *vao = vaos[meshLod];
             meshHash = vao->getRenderQueueId();
+
+            // For sizing the indirect buffer, in case cluster culling is enabled by then
+            if( !casterPass )
+            {
+                mRenderQueues[rqId].mQueuedRenderablesPerThread[threadIdx].numExtraClusterDraws +=
+                    pRend->getMaxExtraClusterDraws();
+            }
         }
         // TODO: Account for skeletal animation in any of the hashes (preferently on the material side)
         // TODO: Account for auto instancing animation in any of the hashes
@@ -356,6 +377,8 @@ namespace Ogre
                      mRenderQueues[i].mQueuedRenderablesPerThread )
                 {
                     numNeededV2Draws += threadRenderQueue.q.size();
+                    if( mClusterCulling && !casterPass )
+                        numNeededV2Draws += threadRenderQueue.numExtraClusterDraws;
                 }
             }
             else if( mRenderQueues[i].mMode == PARTICLE_SYSTEM )
@@ -370,6 +393,9 @@ namespace Ogre
 
         numNeededDraws = numNeededV2Draws + numNeededParticleDraws;
 
+        // Must happen before mParallelHlmsCompileQueue.start() since it may use the worker threads.
+        sortRenderQueues( firstRq, lastRq, casterPass );
+
         mCommandBuffer->setCurrentRenderSystem( rs );
 
         ParallelHlmsCompileQueue *parallelCompileQueue = 0;
@@ -405,56 +431,6 @@ namespace Ogre
 
         for( size_t i = firstRq; i < lastRq; ++i )
         {
-            QueuedRenderableArray &queuedRenderables = mRenderQueues[i].mQueuedRenderables;
-            QueuedRenderableArrayPerThread &perThreadQueue =
-                mRenderQueues[i].mQueuedRenderablesPerThread;
-
-            if( !mRenderQueues[i].mSorted )
-            {
-                OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
-
-                size_t numRenderables = 0;
-                QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
-                QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
-
-                while( itor != endt )
-                {
-                    numRenderables += itor->q.size();
-                    ++itor;
-                }
-
-                queuedRenderables.reserve( numRenderables );
-
-                itor = perThreadQueue.begin();
-                while( itor != endt )
-                {
-                    queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
-                    ++itor;
-                }
-
-                // TODO: Exploit temporal coherence across frames then use insertion sorts.
-                // As explained by L. Spiro in
-                // http://www.gamedev.net/topic/661114-temporal-coherence-and-render-queue-sorting/?view=findpost&p=5181408
-                // Keep a list of sorted indices from the previous frame (one per camera).
-                // If we have the sorted list "5, 1, 4, 3, 2, 0":
-                //  * If it grew from last frame, append: 5, 1, 4, 3, 2, 0, 6, 7 and use insertion sort.
-                //  * If it's the same, leave it as is, and use insertion sort just in case.
-                //  * If it's shorter, reset the indices 0, 1, 2, 3, 4; probably use quicksort or other
-                //  generic sort
-                //
-                // TODO2: Explore sorting first on multiple threads, then merge sort into one.
-                if( mRenderQueues[i].mSortMode == NormalSort )
-                {
-                    std::sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-                else if( mRenderQueues[i].mSortMode == StableSort )
-                {
-                    std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
-                    mRenderQueues[i].mSorted = true;
-                }
-            }
-
             if( mRenderQueues[i].mMode == V1_LEGACY )
             {
                 if( mLastVaoName )
@@ -522,6 +498,334 @@ namespace Ogre
         OgreProfileEndGroup( "Command Execution", OGREPROF_RENDERING );
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::sortRenderQueues( const uint8 firstRq, const uint8 lastRq,
+                                        const bool casterPass )
+    {
+        OgreProfileGroupAggregate( "Sorting", OGREPROF_RENDERING );
+
+        // When there are no worker threads mForceMainThread is true and there is only one queue.
+        const bool canSortInParallel = mSceneManager->getNumWorkerThreads() > 1u;
+        bool anySortPerThread = false;
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            RenderQueueGroup &rqGroup = mRenderQueues[i];
+            rqGroup.mSortPerThread = false;
+
+            if( !rqGroup.mSorted && canSortInParallel &&
+                ( rqGroup.mSortMode == NormalSort || rqGroup.mSortMode == StableSort ) )
+            {
+                size_t numRenderables = 0;
+                for( const ThreadRenderQueue &threadRenderQueue : rqGroup.mQueuedRenderablesPerThread )
+                    numRenderables += threadRenderQueue.q.size();
+
+                rqGroup.mSortPerThread = numRenderables >= mParallelSortThreshold;
+                anySortPerThread |= rqGroup.mSortPerThread;
+            }
+        }
+
+        if( anySortPerThread )
+        {
+            // Sort each thread's queue in parallel (see RenderQueue::execute), merge them later.
+            mParallelSortFirstRq = firstRq;
+            mParallelSortLastRq = lastRq;
+            mSceneManager->executeUserScalableTask( this, true );
+        }
+
+        const Camera *camera = mSceneManager->getCamerasInProgress().renderingCamera;
+
+        for( size_t i = firstRq; i < lastRq; ++i )
+        {
+            RenderQueueGroup &rqGroup = mRenderQueues[i];
+
+            if( rqGroup.mSorted )
+                continue;
+
+            if( rqGroup.mSortPerThread )
+            {
+                mergeSortedPerThreadQueues( rqGroup );
+                rqGroup.mSortPerThread = false;
+                rqGroup.mSorted = true;
+                continue;
+            }
+
+            QueuedRenderableArray &queuedRenderables = rqGroup.mQueuedRenderables;
+            QueuedRenderableArrayPerThread &perThreadQueue = rqGroup.mQueuedRenderablesPerThread;
+
+            size_t numRenderables = 0;
+            QueuedRenderableArrayPerThread::const_iterator itor = perThreadQueue.begin();
+            QueuedRenderableArrayPerThread::const_iterator endt = perThreadQueue.end();
+
+            while( itor != endt )
+            {
+                numRenderables += itor->q.size();
+                ++itor;
+            }
+
+            queuedRenderables.reserve( numRenderables );
+
+            itor = perThreadQueue.begin();
+            while( itor != endt )
+            {
+                queuedRenderables.appendPOD( itor->q.begin(), itor->q.end() );
+                ++itor;
+            }
+
+            switch( rqGroup.mSortMode )
+            {
+            case DisableSort:
+                break;
+            case NormalSort:
+                std::sort( queuedRenderables.begin(), queuedRenderables.end() );
+                rqGroup.mSorted = true;
+                break;
+            case StableSort:
+                if( numRenderables >= c_radixSortThreshold )
+                    _radixSort( queuedRenderables, mSortScratch );
+                else
+                    std::stable_sort( queuedRenderables.begin(), queuedRenderables.end() );
+                rqGroup.mSorted = true;
+                break;
+            case CoherentSort:
+                coherentSort( rqGroup, static_cast<uint8>( i ), camera, casterPass );
+                rqGroup.mSorted = true;
+                break;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::execute( size_t threadId, size_t numThreads )
+    {
+        for( size_t i = mParallelSortFirstRq; i < mParallelSortLastRq; ++i )
+        {
+            RenderQueueGroup &rqGroup = mRenderQueues[i];
+            if( rqGroup.mSortPerThread )
+            {
+                OGRE_ASSERT_MEDIUM( rqGroup.mQueuedRenderablesPerThread.size() == numThreads );
+                QueuedRenderableArray &q = rqGroup.mQueuedRenderablesPerThread[threadId].q;
+                if( rqGroup.mSortMode == NormalSort )
+                    std::sort( q.begin(), q.end() );
+                else
+                    std::stable_sort( q.begin(), q.end() );
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::mergeSortedPerThreadQueues( RenderQueueGroup &rqGroup )
+    {
+        QueuedRenderableArray &queuedRenderables = rqGroup.mQueuedRenderables;
+        QueuedRenderableArrayPerThread &perThreadQueue = rqGroup.mQueuedRenderablesPerThread;
+
+        // Concatenate all sorted runs and keep track of where each one starts
+        mSortRunOffsets.clear();
+        size_t numRenderables = 0;
+        for( const ThreadRenderQueue &threadRenderQueue : perThreadQueue )
+        {
+            if( !threadRenderQueue.q.empty() )
+            {
+                mSortRunOffsets.push_back( numRenderables );
+                numRenderables += threadRenderQueue.q.size();
+            }
+        }
+        mSortRunOffsets.push_back( numRenderables );
+
+        queuedRenderables.reserve( numRenderables );
+        for( const ThreadRenderQueue &threadRenderQueue : perThreadQueue )
+            queuedRenderables.appendPOD( threadRenderQueue.q.begin(), threadRenderQueue.q.end() );
+
+        _mergeSortedRuns( queuedRenderables, mSortRunOffsets, mSortScratch );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_mergeSortedRuns( QueuedRenderableArray &inOut, FastArray<size_t> &inOutRunOffsets,
+                                        QueuedRenderableArray &scratch )
+    {
+        const size_t numRenderables = inOut.size();
+        scratch.resizePOD( numRenderables );
+
+        // Merge adjacent runs pairwise, ping-ponging between both buffers. std::merge takes
+        // from the first range on ties, thus merging in run order is stable.
+        QueuedRenderableArray *src = &inOut;
+        QueuedRenderableArray *dst = &scratch;
+
+        size_t numRuns = inOutRunOffsets.size() - 1u;
+        while( numRuns > 1u )
+        {
+            size_t *offsets = inOutRunOffsets.begin();
+            size_t numMergedRuns = 0u;
+            for( size_t r = 0u; r < numRuns; r += 2u )
+            {
+                const size_t runStart = offsets[r];
+                const size_t runMiddle = offsets[r + 1u];
+                const size_t runEnd = offsets[std::min( r + 2u, numRuns )];
+
+                std::merge( src->begin() + runStart, src->begin() + runMiddle,
+                            src->begin() + runMiddle, src->begin() + runEnd,
+                            dst->begin() + runStart );
+                offsets[numMergedRuns++] = runStart;
+            }
+            offsets[numMergedRuns] = numRenderables;
+            inOutRunOffsets.resizePOD( numMergedRuns + 1u );
+            numRuns = numMergedRuns;
+            std::swap( src, dst );
+        }
+
+        if( src != &inOut )
+            inOut.swap( scratch );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::coherentSort( RenderQueueGroup &rqGroup, const uint8 rqId, const Camera *camera,
+                                    const bool casterPass )
+    {
+        CoherentSortEntry *entry = 0;
+        CoherentSortEntryVec::iterator itor = mCoherentSortCache.begin();
+        CoherentSortEntryVec::iterator endt = mCoherentSortCache.end();
+        while( itor != endt && !entry )
+        {
+            if( itor->camera == camera && itor->rqId == rqId && itor->casterPass == casterPass )
+                entry = &( *itor );
+            ++itor;
+        }
+
+        if( !entry )
+        {
+            mCoherentSortCache.push_back( CoherentSortEntry() );
+            entry = &mCoherentSortCache.back();
+            entry->camera = camera;
+            entry->rqId = rqId;
+            entry->casterPass = casterPass;
+        }
+
+        entry->lastFrame = mFrameCount;
+
+        _coherentSort( rqGroup.mQueuedRenderables, entry->order, mCoherentSortKeys, mSortScratch );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_coherentSort( QueuedRenderableArray &inOut, vector<uint32>::type &inOutOrder,
+                                     CoherentSortKeyArray &keyArray, QueuedRenderableArray &scratch )
+    {
+        const size_t numRenderables = inOut.size();
+        const size_t prevNumRenderables = inOutOrder.size();
+
+        keyArray.resizePOD( numRenderables );
+        CoherentSortKey *keys = keyArray.begin();
+
+        bool needsFullSort = true;
+
+        if( prevNumRenderables > 0u && numRenderables >= prevNumRenderables )
+        {
+            // Start from last frame's order. If the list grew, the new ones get appended at the end.
+            for( size_t i = 0u; i < prevNumRenderables; ++i )
+            {
+                keys[i].hash = inOut[inOutOrder[i]].hash;
+                keys[i].idx = inOutOrder[i];
+            }
+            for( size_t i = prevNumRenderables; i < numRenderables; ++i )
+            {
+                keys[i].hash = inOut[i].hash;
+                keys[i].idx = static_cast<uint32>( i );
+            }
+
+            // Insertion sort. It's very fast when the list is almost sorted, but
+            // it is O(N^2) otherwise; hence give up if it's taking too long.
+            size_t movesLeft = numRenderables * c_maxAvgInsertionSortMoves;
+            needsFullSort = false;
+            for( size_t i = 1u; i < numRenderables && !needsFullSort; ++i )
+            {
+                const CoherentSortKey key = keys[i];
+                size_t j = i;
+                while( j > 0u && key < keys[j - 1u] )
+                {
+                    keys[j] = keys[j - 1u];
+                    --j;
+                }
+                keys[j] = key;
+
+                const size_t numMoves = i - j;
+                if( numMoves > movesLeft )
+                    needsFullSort = true;
+                else
+                    movesLeft -= numMoves;
+            }
+        }
+        else
+        {
+            // The list shrank (we can't tell which ones are gone) or this is the first frame.
+            for( size_t i = 0u; i < numRenderables; ++i )
+            {
+                keys[i].hash = inOut[i].hash;
+                keys[i].idx = static_cast<uint32>( i );
+            }
+        }
+
+        if( needsFullSort )
+            std::sort( keys, keys + numRenderables );
+
+        scratch.resizePOD( numRenderables );
+        inOutOrder.resize( numRenderables );
+        for( size_t i = 0u; i < numRenderables; ++i )
+        {
+            scratch[i] = inOut[keys[i].idx];
+            inOutOrder[i] = keys[i].idx;
+        }
+
+        inOut.swap( scratch );
+    }
+    //-----------------------------------------------------------------------
+    void RenderQueue::_radixSort( QueuedRenderableArray &inOut, QueuedRenderableArray &scratch )
+    {
+        const size_t numElements = inOut.size();
+        if( numElements <= 1u )
+            return;
+
+        // Build the histograms of all 8 passes at once
+        size_t histograms[8][256];
+        memset( histograms, 0, sizeof( histograms ) );
+
+        {
+            QueuedRenderableArray::const_iterator itor = inOut.begin();
+            QueuedRenderableArray::const_iterator endt = inOut.end();
+            while( itor != endt )
+            {
+                const uint64 hash = itor->hash;
+                for( size_t pass = 0u; pass < 8u; ++pass )
+                    ++histograms[pass][( hash >> ( pass * 8u ) ) & 0xFF];
+                ++itor;
+            }
+        }
+
+        scratch.resizePOD( numElements );
+
+        QueuedRenderable *src = inOut.begin();
+        QueuedRenderable *dst = scratch.begin();
+
+        for( size_t pass = 0u; pass < 8u; ++pass )
+        {
+            const size_t shift = pass * 8u;
+            size_t *histogram = histograms[pass];
+
+            // All keys share the same byte. Nothing to do in this pass (very common
+            // since many RqBits fields are usually the same, e.g. SubRqId)
+            if( histogram[( src[0].hash >> shift ) & 0xFF] == numElements )
+                continue;
+
+            size_t offset = 0u;
+            for( size_t i = 0u; i < 256u; ++i )
+            {
+                const size_t count = histogram[i];
+                histogram[i] = offset;
+                offset += count;
+            }
+
+            for( size_t i = 0u; i < numElements; ++i )
+                dst[histogram[( src[i].hash >> shift ) & 0xFF]++] = src[i];
+
+            std::swap( src, dst );
+        }
+
+        if( src != inOut.begin() )
+            inOut.swap( scratch );
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::warmUpShadersCollect( const uint8 firstRq, const uint8 lastRq,
                                             const bool casterPass )
     {
@@ -574,11 +878,39 @@ namespace Ogre
     {
         OgreProfileBeginGroup( "RenderQueue::warmUpShadersTrigger", OGREPROF_RENDERING );
 
-        if( rs->supportsMultithreadedShaderCompilation() && mSceneManager->getNumWorkerThreads() > 1u )
+        const size_t numWorkerThreads = mSceneManager->getNumWorkerThreads();
+
+        if( rs->supportsMultithreadedShaderCompilation() && numWorkerThreads > 1u )
             mParallelHlmsCompileQueue.fireWarmUpParallel( mSceneManager );
         else
+        {
+            if( numWorkerThreads > 1u )
+            {
+                // Only compilation must happen in this thread. Parse the templates in parallel.
+                for( size_t i = 0; i < HLMS_MAX; ++i )
+                {
+                    Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+                    if( hlms )
+                        hlms->_setNumThreads( numWorkerThreads );
+                }
+
+                mParallelHlmsCompileQueue.fireWarmUpPregenerateParallel( mSceneManager,
+                                                                         mHlmsManager );
+            }
+
             mParallelHlmsCompileQueue.warmUpSerial( mHlmsManager, mPendingPassCaches.data() );
 
+            if( numWorkerThreads > 1u )
+            {
+                for( size_t i = 0; i < HLMS_MAX; ++i )
+                {
+                    Hlms *hlms = mHlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+                    if( hlms )
+                        hlms->_clearPregeneratedShaderCode();
+                }
+            }
+        }
+
         mPendingPassCaches.clear();
 
         OgreProfileEndGroup( "RenderQueue::warmUpShadersTrigger", OGREPROF_RENDERING );
@@ -851,6 +1183,28 @@ namespace Ogre
         CbDrawCall *drawCmd = 0;
         CbSharedDraw *drawCountPtr = 0;
 
+        // See setClusterCulling
+        const Camera *clusterCamera = 0;
+        Plane clusterPlanes[6];
+        size_t numClusterPlanes = 0u;
+        if( mClusterCulling && !casterPass && !dualParaboloid && !isUsingInstancedStereo )
+        {
+            const CamerasInProgress cameras = mSceneManager->getCamerasInProgress();
+            if( cameras.renderingCamera && cameras.cullingCamera )
+            {
+                clusterCamera = cameras.renderingCamera;
+                const Plane *planes = cameras.cullingCamera->getFrustumPlanes();
+                for( size_t i = 0u; i < 6u; ++i )
+                {
+                    // Skip the far plane if the frustum is infinite
+                    if( i != FRUSTUM_PLANE_FAR || cameras.cullingCamera->getFarClipDistance() != 0 )
+                        clusterPlanes[numClusterPlanes++] = planes[i];
+                }
+            }
+        }
+        const bool clusterWindingFlipped =
+            clusterCamera && ( clusterCamera->isReflected() || rs->getInvertVertexWinding() );
+
         RenderingMetrics stats;
 
         const QueuedRenderableArray &queuedRenderables = renderQueueGroup.mQueuedRenderables;
@@ -887,6 +1241,12 @@ namespace Ogre
             uint32 baseInstance = hlms->fillBuffersForV2( hlmsCache, queuedRenderable, casterPass,
                                                           lastHlmsCacheHash, mCommandBuffer );
 
+            // Null for skinned & posed Renderables: their vertices may leave the clusters' bounds
+            const MeshClusterArray *clusters = 0;
+            if( clusterCamera && vao->mIndexBuffer && vao->getOperationType() == OT_TRIANGLE_LIST )
+                clusters = queuedRenderable.renderable->getMeshClusters( meshLod );
+            uint32 numPrimsDrawn = vao->mPrimCount;
+
             if( drawCmd != mCommandBuffer->getLastCommand() || lastVaoName != vao->getVaoName() )
             {
                 // Different mesh, vertex buffers or layout. Make a new draw call.
@@ -924,7 +1284,56 @@ namespace Ogre
                 stats.mDrawCount += 1u;
             }
 
-            if( lastVao != vao )
+            if( clusters )
+            {
+                const Matrix4 &worldMatrix =
+                    queuedRenderable.movableObject->_getParentNodeFullTransform();
+
+                // Back-facing clusters can only be culled if the GPU culls those triangles too
+                Vector3 localCameraPos;
+                const Vector3 *localCameraPosPtr = 0;
+                if( !clusterWindingFlipped && !worldMatrix.hasNegativeScale() &&
+                    datablock->getMacroblock( casterPass )->mCullMode == CULL_CLOCKWISE )
+                {
+                    localCameraPos = worldMatrix.inverseAffine().transformAffine(
+                        clusterCamera->getDerivedPosition() );
+                    localCameraPosPtr = &localCameraPos;
+                }
+
+                mClusterRanges.clear();
+                numPrimsDrawn = static_cast<uint32>(
+                    MeshOptimizer::cullClusters( *clusters, worldMatrix, clusterPlanes, numClusterPlanes,
+                                                 localCameraPosPtr, mClusterRanges ) );
+
+                // Keep one (empty) draw even if everything got culled
+                if( mClusterRanges.empty() )
+                {
+                    mClusterRanges.push_back( 0u );
+                    mClusterRanges.push_back( 0u );
+                }
+
+                const uint32 firstVertexIndex =
+                    uint32( vao->mIndexBuffer->_getFinalBufferStart() + vao->mPrimStart );
+                for( size_t i = 0u; i < mClusterRanges.size(); i += 2u )
+                {
+                    ++drawCmd->numDraws;
+
+                    CbDrawIndexed *drawIndexedPtr = reinterpret_cast<CbDrawIndexed *>( indirectDraw );
+                    indirectDraw += sizeof( CbDrawIndexed );
+
+                    drawIndexedPtr->primCount = mClusterRanges[i + 1u];
+                    drawIndexedPtr->instanceCount = instancesPerDraw;
+                    drawIndexedPtr->firstVertexIndex = firstVertexIndex + mClusterRanges[i];
+                    drawIndexedPtr->baseVertex =
+                        uint32( vao->mBaseVertexBuffer->_getFinalBufferStart() );
+                    drawIndexedPtr->baseInstance = baseInstance << baseInstanceShift;
+                }
+
+                // The next Renderable can't be instanced on top of our draws
+                lastVao = 0;
+                stats.mInstanceCount += instancesPerDraw;
+            }
+            else if( lastVao != vao )
             {
                 // Different mesh, but same vertex buffers & layouts. Advance indirection buffer.
                 ++drawCmd->numDraws;
@@ -975,17 +1384,17 @@ namespace Ogre
             switch( vao->getOperationType() )
             {
             case OT_TRIANGLE_LIST:
-                stats.mFaceCount += ( vao->mPrimCount / 3u ) * instancesPerDraw;
+                stats.mFaceCount += ( numPrimsDrawn / 3u ) * instancesPerDraw;
                 break;
             case OT_TRIANGLE_STRIP:
             case OT_TRIANGLE_FAN:
-                stats.mFaceCount += ( vao->mPrimCount - 2u ) * instancesPerDraw;
+                stats.mFaceCount += ( numPrimsDrawn - 2u ) * instancesPerDraw;
                 break;
             default:
                 break;
             }
 
-            stats.mVertexCount += vao->mPrimCount * instancesPerDraw;
+            stats.mVertexCount += numPrimsDrawn * instancesPerDraw;
 
             ++itor;
         }
@@ -1176,6 +1585,12 @@ namespace Ogre
                                                       mPendingPassCaches.data() );
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::_warmUpShadersPregenerateThread( const size_t threadIdx )
+    {
+        mParallelHlmsCompileQueue.updateWarmUpPregenerateThread( threadIdx, mHlmsManager,
+                                                                 mPendingPassCaches.data() );
+    }
+    //-----------------------------------------------------------------------
     void RenderQueue::_compileShadersThread( size_t threadIdx )
     {
         mParallelHlmsCompileQueue.updateThread( threadIdx, mHlmsManager );
@@ -1282,6 +1697,72 @@ namespace Ogre
         mRequests.clear();
     }
     //-----------------------------------------------------------------------
+    void ParallelHlmsCompileQueue::fireWarmUpPregenerateParallel( SceneManager *sceneManager,
+                                                                  HlmsManager *hlmsManager )
+    {
+        mNextPregenerateRequest.store( 0u, std::memory_order_relaxed );
+        sceneManager->_fireWarmUpShadersPregenerate();
+        // See comments in ParallelHlmsCompileQueue::stopAndWait implementation.
+        if( mExceptionFound )
+        {
+            for( size_t i = 0; i < HLMS_MAX; ++i )
+            {
+                Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( i ) );
+                if( hlms )
+                    hlms->_clearPregeneratedShaderCode();
+            }
+
+            std::exception_ptr threadedException = mThreadedException;
+            mRequests.clear();
+            mThreadedException = nullptr;
+            mExceptionFound = false;
+            std::rethrow_exception( threadedException );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void ParallelHlmsCompileQueue::updateWarmUpPregenerateThread( size_t threadIdx,
+                                                                  HlmsManager *hlmsManager,
+                                                                  const HlmsCache *passCaches )
+    {
+#ifdef OGRE_SHADER_THREADING_BACKWARDS_COMPATIBLE_API
+#    ifdef OGRE_SHADER_THREADING_USE_TLS
+        Hlms::msThreadId = static_cast<uint32>( threadIdx );
+#    endif
+#endif
+        // mRequests is not modified until warmUpSerial(), which will run in the same order
+        // (thus the shaders get the same names as if we hadn't pregenerated anything).
+        const size_t numRequests = mRequests.size();
+        while( true )
+        {
+            const size_t idx = mNextPregenerateRequest.fetch_add( 1u, std::memory_order_relaxed );
+            if( idx >= numRequests )
+                break;
+
+            const Request &request = mRequests[idx];
+            const HlmsDatablock *datablock = request.queuedRenderable.renderable->getDatablock();
+            Hlms *hlms = hlmsManager->getHlms( static_cast<HlmsTypes>( datablock->mType ) );
+            try
+            {
+                hlms->_pregenerateStubEntry( passCaches[reinterpret_cast<size_t>( request.passCache )],
+                                             request.reservedStubEntry, request.queuedRenderable,
+                                             request.renderableHash, threadIdx );
+            }
+            catch( Exception & )
+            {
+                ScopedLock lock( mMutex );
+                // We can only report one exception.
+                if( !mExceptionFound )
+                {
+                    // Signal other threads to stop early. mRequests can't be cleared
+                    // as they may still be reading it.
+                    mNextPregenerateRequest.store( numRequests, std::memory_order_relaxed );
+                    mExceptionFound = true;
+                    mThreadedException = std::current_exception();
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------
     void ParallelHlmsCompileQueue::updateThread( size_t threadIdx, HlmsManager *hlmsManager )
     {
 #ifdef OGRE_SHADER_THREADING_BACKWARDS_COMPATIBLE_API
@@ -1436,6 +1917,23 @@ namespace Ogre
         mFreeIndirectBuffers.insert( mFreeIndirectBuffers.end(), mUsedIndirectBuffers.begin(),
                                      mUsedIndirectBuffers.end() );
         mUsedIndirectBuffers.clear();
+
+        // Forget the order of cameras / RQs that weren't rendered this frame
+        ++mFrameCount;
+        CoherentSortEntryVec::iterator itor = mCoherentSortCache.begin();
+        CoherentSortEntryVec::iterator endt = mCoherentSortCache.end();
+        while( itor != endt )
+        {
+            if( itor->lastFrame + 1u < mFrameCount )
+            {
+                itor = efficientVectorRemove( mCoherentSortCache, itor );
+                endt = mCoherentSortCache.end();
+            }
+            else
+            {
+                ++itor;
+            }
+        }
     }
     //-----------------------------------------------------------------------
     void RenderQueue::setRenderQueueMode( uint8 rqId, Modes newMode )
@@ -1458,11 +1956,17 @@ namespace Ogre
         return mRenderQueues[rqId].mSortMode;
     }
     //-----------------------------------------------------------------------
+    void RenderQueue::setParallelSortThreshold( size_t threshold )
+    {
+        mParallelSortThreshold = threshold;
+    }
+    //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
     ParallelHlmsCompileQueue::ParallelHlmsCompileQueue() :
         mSemaphore( 0u ),
         mKeepCompiling( false ),
+        mNextPregenerateRequest( 0u ),
         mExceptionFound( false )
     {
     }
@@ -34,8 +34,10 @@ THE SOFTWARE.
 #include "OgreHlmsManager.h"
 #include "OgreLogManager.h"
 #include "OgreMaterialManager.h"
+#include "OgreMesh2Optimizer.h"
 #include "OgrePass.h"
 #include "OgreRoot.h"
+#include "OgreSubMesh2.h"
 #include "OgreTechnique.h"
 
 namespace Ogre
@@ -43,6 +45,7 @@ namespace Ogre
     uint8 Renderable::msDefaultRenderQueueSubGroup = 0;
     //-----------------------------------------------------------------------------------
     Renderable::Renderable() :
+        mClusteredSubMesh( 0 ),
         mHlmsHash( 0 ),
         mHlmsCasterHash( 0 ),
         mHlmsDatablock( 0 ),
@@ -222,6 +225,24 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     MaterialPtr Renderable::getMaterial() const { return mMaterial; }
     //-----------------------------------------------------------------------------------
+    const MeshClusterArray *Renderable::getMeshClusters( uint8 meshLod ) const
+    {
+        if( !mClusteredSubMesh || mHasSkeletonAnimation || mPoseData )
+            return 0;
+
+        const vector<MeshClusterArray>::type &clusters = mClusteredSubMesh->mClusters;
+        if( meshLod >= clusters.size() || clusters[meshLod].empty() )
+            return 0;
+        return &clusters[meshLod];
+    }
+    //-----------------------------------------------------------------------------------
+    uint32 Renderable::getMaxExtraClusterDraws() const
+    {
+        if( !mClusteredSubMesh || mHasSkeletonAnimation || mPoseData )
+            return 0u;
+        return mClusteredSubMesh->getMaxExtraClusterDraws();
+    }
+    //-----------------------------------------------------------------------------------
     unsigned short Renderable::getNumPoses() const { return mPoseData ? mPoseData->numPoses : 0; }
     //-----------------------------------------------------------------------------------
     bool Renderable::getPoseHalfPrecision() const
@@ -33,11 +33,14 @@ THE SOFTWARE.
 #include "OgreArchiveManager.h"
 #include "OgreException.h"
 #include "OgreLogManager.h"
+#include "OgrePlatformInformation.h"
 #include "OgreResourceManager.h"
 #include "OgreSceneManager.h"
 #include "OgreScriptLoader.h"
 #include "OgreString.h"
+#include "Threading/OgreThreads.h"
 
+#include <atomic>
 #include <sstream>
 
 namespace Ogre
@@ -59,7 +62,10 @@ namespace Ogre
     long ResourceGroupManager::RESOURCE_SYSTEM_NUM_REFERENCE_COUNTS = 3;
     //-----------------------------------------------------------------------
     //-----------------------------------------------------------------------
-    ResourceGroupManager::ResourceGroupManager() : mLoadingListener( 0 ), mCurrentGroup( 0 )
+    ResourceGroupManager::ResourceGroupManager() :
+        mLoadingListener( 0 ),
+        mNumScriptParsingThreads( 0u ),
+        mCurrentGroup( 0 )
     {
         // Create the 'General' group
         createResourceGroup( DEFAULT_RESOURCE_GROUP_NAME );
@@ -1063,6 +1069,52 @@ namespace Ogre
         return 0;  // No loader was found
     }
     //-----------------------------------------------------------------------
+    struct ScriptParseJob
+    {
+        ScriptLoader      *loader;
+        String             filename;
+        DataStreamPtr      stream;
+        time_t             modifiedTime;
+        bool               skipped;
+        Any                prepared;
+        std::exception_ptr exception;
+    };
+    /// Scripts prepared in parallel, see ResourceGroupManager::parseScriptBatch
+    struct ScriptParseJobs
+    {
+        vector<ScriptParseJob>::type jobs;
+        std::atomic<size_t>          nextJob;
+    };
+
+    static void prepareScripts( ScriptParseJobs &scriptJobs )
+    {
+        const size_t numJobs = scriptJobs.jobs.size();
+        size_t jobIdx;
+        while( ( jobIdx = scriptJobs.nextJob.fetch_add( 1u ) ) < numJobs )
+        {
+            ScriptParseJob &job = scriptJobs.jobs[jobIdx];
+            if( !job.stream )
+                continue;
+            // Errors are raised later on the main thread, when the script gets
+            // parsed, so that they happen in the same order as when parsing serially
+            try
+            {
+                job.prepared = job.loader->prepareScript( job.stream, job.modifiedTime );
+            }
+            catch( ... )
+            {
+                job.exception = std::current_exception();
+            }
+        }
+    }
+
+    static unsigned long prepareScriptsThread( ThreadHandle *threadHandle )
+    {
+        prepareScripts( *reinterpret_cast<ScriptParseJobs *>( threadHandle->getUserParam() ) );
+        return 0;
+    }
+    THREAD_DECLARE( prepareScriptsThread );
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::parseResourceGroupScripts( ResourceGroup *grp )
     {
         LogManager::getSingleton().logMessage( "Parsing scripts for resource group " + grp->name );
@@ -1093,15 +1145,28 @@ namespace Ogre
             }
             scriptLoaderFileList.push_back( LoaderFileListPair( su, fileListList ) );
         }
+
+        uint32 numThreads = mNumScriptParsingThreads;
+        if( numThreads == 0u )
+            numThreads = std::max( 1u, PlatformInformation::getNumLogicalCores() );
+
         // Fire scripting event
         fireResourceGroupScriptingStarted( grp->name, scriptCount );
 
+        // Scripts whose loader supportsPrepareScript are gathered in batches, prepared in
+        // parallel, then parsed one at a time in the original order. The batch size bounds
+        // how many scripts are open & copied to memory at once.
+        const size_t batchSize = numThreads * 16u;
+        ScriptParseJobs scriptJobs;
+        scriptJobs.jobs.reserve( numThreads > 1u ? std::min( batchSize, scriptCount ) : 0u );
+
         // Iterate over scripts and parse
         // Note we respect original ordering
         for( ScriptLoaderFileList::iterator slfli = scriptLoaderFileList.begin();
              slfli != scriptLoaderFileList.end(); ++slfli )
         {
             ScriptLoader *su = slfli->first;
+            const bool prepareInBatches = numThreads > 1u && su->supportsPrepareScript();
             // Iterate over each list
             for( FileListList::iterator flli = slfli->second->begin(); flli != slfli->second->end();
                  ++flli )
@@ -1112,10 +1177,47 @@ namespace Ogre
                     bool skipScript = false;
                     fireScriptStarted( fii->filename, skipScript );
                     if( skipScript )
-                    {
                         LogManager::getSingleton().logMessage( "Skipping script " + fii->filename );
+
+                    if( prepareInBatches )
+                    {
+                        ScriptParseJob job;
+                        job.loader = su;
+                        job.filename = fii->filename;
+                        job.modifiedTime = 0;
+                        job.skipped = skipScript;
+                        if( !skipScript )
+                        {
+                            job.stream = fii->archive->open( fii->filename );
+                            if( job.stream )
+                            {
+                                if( mLoadingListener )
+                                {
+                                    mLoadingListener->resourceStreamOpened( fii->filename, grp->name,
+                                                                            0, job.stream );
+                                }
+                                job.modifiedTime = fii->archive->getModifiedTime( fii->filename );
+                                // Workers must never touch the archives (e.g. Zip
+                                // streams can't be read from several threads)
+                                if( !job.stream->getDataPtr() )
+                                {
+                                    job.stream.reset( OGRE_NEW MemoryDataStream(
+                                        job.stream->getName(), job.stream ) );
+                                }
+                            }
+                        }
+                        scriptJobs.jobs.push_back( job );
+
+                        if( scriptJobs.jobs.size() >= batchSize )
+                            parseScriptBatch( scriptJobs, numThreads, grp->name );
+                        continue;
                     }
-                    else
+
+                    // Scripts parsed serially must wait for the ones before them
+                    if( !scriptJobs.jobs.empty() )
+                        parseScriptBatch( scriptJobs, numThreads, grp->name );
+
+                    if( !skipScript )
                     {
                         LogManager::getSingleton().logMessage( "Parsing script " + fii->filename );
                         DataStreamPtr stream = fii->archive->open( fii->filename );
@@ -1126,7 +1228,7 @@ namespace Ogre
                                                                         stream );
 
                             if( fii->archive->getType() == "FileSystem" &&
-                                stream->size() <= 1024 * 1024 )
+                                stream->size() <= 1024 * 1024 && !stream->getDataPtr() )
                             {
                                 DataStreamPtr cachedCopy;
                                 cachedCopy.reset(
@@ -1142,11 +1244,58 @@ namespace Ogre
             }
         }
 
+        if( !scriptJobs.jobs.empty() )
+            parseScriptBatch( scriptJobs, numThreads, grp->name );
+
         fireResourceGroupScriptingEnded( grp->name );
         LogManager::getSingleton().logMessage( "Finished parsing scripts for resource group " +
                                                grp->name );
     }
     //-----------------------------------------------------------------------
+    void ResourceGroupManager::parseScriptBatch( ScriptParseJobs &scriptJobs, uint32 numThreads,
+                                                 const String &groupName )
+    {
+        numThreads = static_cast<uint32>( std::min<size_t>( numThreads, scriptJobs.jobs.size() ) );
+
+        scriptJobs.nextJob = 0u;
+        if( numThreads > 1u )
+        {
+            // The calling thread works too
+            ThreadHandleVec workerThreads;
+            workerThreads.resize( numThreads - 1u );
+            for( size_t i = 0u; i < workerThreads.size(); ++i )
+            {
+                workerThreads[i] =
+                    Threads::CreateThread( THREAD_GET( prepareScriptsThread ), i + 1u, &scriptJobs );
+            }
+            prepareScripts( scriptJobs );
+            Threads::WaitForThreads( workerThreads );
+        }
+        else
+        {
+            prepareScripts( scriptJobs );
+        }
+
+        for( vector<ScriptParseJob>::type::iterator itor = scriptJobs.jobs.begin();
+             itor != scriptJobs.jobs.end(); ++itor )
+        {
+            if( !itor->skipped )
+            {
+                LogManager::getSingleton().logMessage( "Parsing script " + itor->filename );
+                if( itor->exception )
+                    std::rethrow_exception( itor->exception );
+                if( itor->stream )
+                    itor->loader->parsePreparedScript( itor->prepared, groupName );
+                // Release the script's memory as soon as possible
+                itor->stream.reset();
+                itor->prepared = Any();
+            }
+            fireScriptEnded( itor->filename, itor->skipped );
+        }
+
+        scriptJobs.jobs.clear();
+    }
+    //-----------------------------------------------------------------------
     void ResourceGroupManager::createDeclaredResources( ResourceGroup *grp )
     {
         for( ResourceDeclarationList::iterator i = grp->resourceDeclarations.begin();
@@ -67,6 +67,7 @@ THE SOFTWARE.
 #include "OgreMeshManager2.h"
 #include "OgreNameGenerator.h"
 #include "OgreOldSkeletonManager.h"
+#include "OgrePackArchive.h"
 #include "OgreParticleSystemManager.h"
 #include "OgrePlatformInformation.h"
 #include "OgrePlugin.h"
@@ -245,6 +246,8 @@ namespace Ogre
 
         mFileSystemArchiveFactory = OGRE_NEW FileSystemArchiveFactory();
         ArchiveManager::getSingleton().addArchiveFactory( mFileSystemArchiveFactory );
+        mPackArchiveFactory = OGRE_NEW PackArchiveFactory();
+        ArchiveManager::getSingleton().addArchiveFactory( mPackArchiveFactory );
 #if OGRE_NO_ZIP_ARCHIVE == 0
         mZipArchiveFactory = OGRE_NEW ZipArchiveFactory();
         ArchiveManager::getSingleton().addArchiveFactory( mZipArchiveFactory );
@@ -382,6 +385,7 @@ namespace Ogre
         OGRE_DELETE mEmbeddedZipArchiveFactory;
 #endif
         OGRE_DELETE mFileSystemArchiveFactory;
+        OGRE_DELETE mPackArchiveFactory;
 
         OGRE_DELETE mOldSkeletonManager;
         OGRE_DELETE mSkeletonManager;
@@ -987,6 +991,9 @@ namespace Ogre
         if( v1::HardwareBufferManager::getSingletonPtr() )
             v1::HardwareBufferManager::getSingleton()._releaseBufferCopies();
 
+        // Stream in the Mesh LODs requested this frame, evict the unneeded ones
+        mMeshManager->_updateLodStreaming();
+
         // Tell the queue to process responses
         mWorkQueue->processResponses();
 
@@ -103,12 +103,17 @@ namespace Ogre
     //---------------------------------------------------------------------
     Codec::DecodeResult STBIImageCodec::decode( DataStreamPtr &input ) const
     {
-        // Buffer stream into memory (TODO: override IO functions instead?)
-        MemoryDataStream memStream( input, true );
+        // Buffer stream into memory unless it's already there (TODO: override IO functions instead?)
+        DataStreamPtr memStream = input;
+        if( !input->getDataPtr() )
+            memStream.reset( OGRE_NEW MemoryDataStream( input, true ) );
+        const size_t offset = memStream->tell();
 
         int width, height, components;
-        stbi_uc *pixelData = stbi_load_from_memory(
-            memStream.getPtr(), static_cast<int>( memStream.size() ), &width, &height, &components, 0 );
+        stbi_uc *pixelData =
+            stbi_load_from_memory( memStream->getDataPtr() + offset,
+                                   static_cast<int>( memStream->size() - offset ), &width, &height,
+                                   &components, 0 );
 
         if( !pixelData )
         {
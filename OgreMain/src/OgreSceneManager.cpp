@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "Compositor/OgreCompositorShadowNode.h"
 #include "Compositor/Pass/PassScene/OgreCompositorPassSceneDef.h"
 #include "Math/Array/OgreBooleanMask.h"
+#include "Math/Array/OgreObjectSpatialIndex.h"
 #include "OgreAnimation.h"
 #include "OgreAtmosphereComponent.h"
 #include "OgreBillboardChain.h"
@@ -107,6 +108,24 @@ namespace Ogre
 
     static NullAtmosphereComponent c_nullAtmosphere;
 
+    typedef CullFrustumRequest::ObjectMemoryManagerVec ObjectMemoryManagerVec;
+
+    /// Changes whenever objects get added to or removed from any of the given managers
+    static uint32 getLayoutRevision( const ObjectMemoryManagerVec &objectMemManagers )
+    {
+        uint32 retVal = 0u;
+        ObjectMemoryManagerVec::const_iterator itor = objectMemManagers.begin();
+        ObjectMemoryManagerVec::const_iterator endt = objectMemManagers.end();
+        while( itor != endt )
+        {
+            retVal += ( *itor )->getLayoutRevision();
+            ++itor;
+        }
+        return retVal;
+    }
+
+    const size_t SceneManager::c_noPackList = std::numeric_limits<size_t>::max();
+
     //-----------------------------------------------------------------------
     uint32 SceneManager::QUERY_ENTITY_DEFAULT_MASK = 0x80000000;
     uint32 SceneManager::QUERY_FX_DEFAULT_MASK = 0x40000000;
@@ -174,6 +193,12 @@ namespace Ogre
         mUserTask( 0 ),
         mRequestType( NUM_REQUESTS ),
         mWorkerThreadsBarrier( 0 ),
+        mConcurrentCullingEnabled( false ),
+        mNumPreCulledFrustums( 0 ),
+        mFirstPendingPreCull( 0 ),
+        mPreCullPreparedData( 0 ),
+        mPreCullPreparedDataCapacity( 0 ),
+        mCurrentPreCulledFrustum( 0 ),
         mSuppressRenderStateChanges( false ),
         mLastLightHash( 0 ),
         mLastLightLimit( 0 ),
@@ -283,6 +308,13 @@ namespace Ogre
         OGRE_DELETE mRadialDensityMask;
         mRadialDensityMask = 0;
 
+        if( mPreCullPreparedData )
+        {
+            OGRE_FREE_SIMD( mPreCullPreparedData, MEMCATEGORY_SCENE_CONTROL );
+            mPreCullPreparedData = 0;
+            mPreCullPreparedDataCapacity = 0;
+        }
+
         fireSceneManagerDestroyed();
         for( size_t i = 0; i < NUM_SCENE_MEMORY_MANAGER_TYPES; ++i )
         {
@@ -1386,30 +1418,14 @@ namespace Ogre
 
                 // Quick way of reducing overhead/stress on VisibleObjectsBoundsInfo
                 // calculation (lastRq can be up to 255)
-                uint8 realFirstRq = firstRq;
-                uint8 realLastRq = 0;
-                {
-                    ObjectMemoryManagerVec::const_iterator itor =
-                        mEntitiesMemoryManagerCulledList.begin();
-                    ObjectMemoryManagerVec::const_iterator endt = mEntitiesMemoryManagerCulledList.end();
-                    while( itor != endt )
-                    {
-                        realFirstRq =
-                            (uint8)std::min<size_t>( realFirstRq, ( *itor )->_getTotalRenderQueues() );
-                        realLastRq =
-                            (uint8)std::max<size_t>( realLastRq, ( *itor )->_getTotalRenderQueues() );
-                        ++itor;
-                    }
-
-                    // clamp RQ values to the real RQ range
-                    realFirstRq = std::min( realLastRq, std::max( realFirstRq, firstRq ) );
-                    realLastRq = std::min( realLastRq, std::max( realFirstRq, lastRq ) );
-                }
+                uint8 realFirstRq, realLastRq;
+                getRealRenderQueueRange( firstRq, lastRq, realFirstRq, realLastRq );
 
                 CullFrustumRequest cullRequest(
                     realFirstRq, realLastRq, mIlluminationStage == IRS_RENDER_TO_TEXTURE, true, false,
                     &mEntitiesMemoryManagerCulledList, cullCamera, lodCamera );
-                fireCullFrustumThreads( cullRequest );
+                if( !consumePreCulledFrustum( cullRequest ) )
+                    fireCullFrustumThreads( cullRequest );
             }
         }  // end lock on scene graph mutex
         else
@@ -1698,6 +1714,19 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
+    void SceneManager::_fireWarmUpShadersPregenerate()
+    {
+        mRequestType = WARM_UP_SHADERS_PREGENERATE;
+
+        if( mForceMainThread )
+            updateWorkerThreadImpl( 0 );
+        else
+        {
+            mWorkerThreadsBarrier->sync();  // Fire threads
+            mWorkerThreadsBarrier->sync();  // Wait them to complete
+        }
+    }
+    //-----------------------------------------------------------------------
     void SceneManager::_fireParallelHlmsCompile()
     {
         mRequestType = PARALLEL_HLMS_COMPILE;
@@ -1730,7 +1759,12 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------
-    void SceneManager::_frameEnded() { mRenderQueue->frameEnded(); }
+    void SceneManager::_frameEnded()
+    {
+        mRenderQueue->frameEnded();
+        // Start the next frame from scratch, even if updateSceneGraph doesn't get called
+        clearPreCulledFrustums();
+    }
     //-----------------------------------------------------------------------
     void SceneManager::_setDestinationRenderSystem( RenderSystem *sys )
     {
@@ -1811,15 +1845,8 @@ namespace Ogre
 
             while( itByDef != enByDef )
             {
-                FastArray<SkeletonInstance *>::iterator itor =
-                    itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx];
-                FastArray<SkeletonInstance *>::iterator endt =
-                    itByDef->skeletons.begin() + itByDef->threadStarts[threadIdx + 1];
-                while( itor != endt )
-                {
-                    ( *itor )->update();
-                    ++itor;
-                }
+                itByDef->_updateAnimations( threadIdx, ( *it )->poseSharingFrameTolerance,
+                                            ( *it )->poseSharingWeightTolerance );
 
                 if( !itByDef->skeletons.empty() )
                     updateAnimationTransforms( *itByDef, threadIdx );
@@ -1891,16 +1918,13 @@ namespace Ogre
     void SceneManager::updateAllTransformsThread( const UpdateTransformRequest &request,
                                                   size_t threadIdx )
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
-
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        Node::updateAllTransforms( numNodes, t );
+        size_t toAdvance, numNodes;
+        while( mWorkStealingRange.acquire( threadIdx, toAdvance, numNodes ) )
+        {
+            Transform t( request.t );
+            t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            Node::updateAllTransforms( numNodes, t );
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransforms()
@@ -1924,16 +1948,12 @@ namespace Ogre
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
                 if( numNodes )
                 {
                     // Send them to worker threads. We need to go depth by depth because
                     // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
+                    mUpdateTransformRequest = UpdateTransformRequest( t, numNodes );
+                    mWorkStealingRange.reset( numNodes, mNumWorkerThreads, ARRAY_PACKED_REALS );
                     fireWorkerThreadsAndWait();
                     // Node::updateAllTransforms( numNodes, t );
                 }
@@ -1972,16 +1992,12 @@ namespace Ogre
                 Transform t;
                 const size_t numNodes = nodeMemoryManager->getFirstNode( t, i );
 
-                // nodesPerThread must be multiple of ARRAY_PACKED_REALS
-                size_t nodesPerThread = ( numNodes + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                nodesPerThread = ( ( nodesPerThread + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                                 ARRAY_PACKED_REALS;
-
                 if( numNodes )
                 {
                     // Send them to worker threads. We need to go depth by depth because
                     // we may depend on parents which could be processed by different threads.
-                    mUpdateTransformRequest = UpdateTransformRequest( t, nodesPerThread, numNodes );
+                    mUpdateTransformRequest = UpdateTransformRequest( t, numNodes );
+                    mWorkStealingRange.reset( numNodes, mNumWorkerThreads, ARRAY_PACKED_REALS );
                     fireWorkerThreadsAndWait();
                 }
             }
@@ -1993,74 +2009,52 @@ namespace Ogre
     void SceneManager::updateAllTransformsBoneToTagThread( const UpdateTransformRequest &request,
                                                            size_t threadIdx )
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
-
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        TagPoint::updateAllTransformsBoneToTag( numNodes, t );
+        size_t toAdvance, numNodes;
+        while( mWorkStealingRange.acquire( threadIdx, toAdvance, numNodes ) )
+        {
+            Transform t( request.t );
+            t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            TagPoint::updateAllTransformsBoneToTag( numNodes, t );
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllTransformsTagOnTagThread( const UpdateTransformRequest &request,
                                                           size_t threadIdx )
     {
-        Transform t( request.t );
-        const size_t toAdvance =
-            std::min( threadIdx * request.numNodesPerThread, request.numTotalNodes );
-
-        // Prevent going out of bounds (usually in the last threadIdx, or
-        // when there are less nodes than ARRAY_PACKED_REALS
-        const size_t numNodes = std::min( request.numNodesPerThread, request.numTotalNodes - toAdvance );
-        t.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-        TagPoint::updateAllTransformsTagOnTag( numNodes, t );
+        size_t toAdvance, numNodes;
+        while( mWorkStealingRange.acquire( threadIdx, toAdvance, numNodes ) )
+        {
+            Transform t( request.t );
+            t.advancePack( toAdvance / ARRAY_PACKED_REALS );
+            TagPoint::updateAllTransformsTagOnTag( numNodes, t );
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllBoundsThread( const ObjectMemoryManagerVec &objectMemManager,
                                               size_t threadIdx )
     {
-        ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
-        ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
-
-        while( it != en )
-        {
-            ObjectMemoryManager *memoryManager = *it;
-            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
-
-            for( size_t i = 0; i < numRenderQueues; ++i )
-            {
-                ObjectData objData;
-                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
-
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-                MovableObject::updateAllBounds( numObjs, objData );
-            }
-
-            ++it;
-        }
+        // The work was laid out by prepareObjectWork( objectMemManager )
+        ObjectWorkCursor cursor;
+        ObjectData objData;
+        size_t numObjs, rqId;
+        while( acquireObjectWork( threadIdx, cursor, objData, numObjs, rqId ) )
+            MovableObject::updateAllBounds( numObjs, objData );
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllBounds( const ObjectMemoryManagerVec &objectMemManager )
     {
         mUpdateBoundsRequest = &objectMemManager;
         mRequestType = UPDATE_ALL_BOUNDS;
+        prepareObjectWork( objectMemManager, 0u, std::numeric_limits<size_t>::max() );
         fireWorkerThreadsAndWait();
+
+        ObjectMemoryManagerVec::const_iterator itor = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator endt = objectMemManager.end();
+        while( itor != endt )
+        {
+            ( *itor )->_updateSpatialIndices();
+            ++itor;
+        }
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllLodsThread( const UpdateLodRequest &request, size_t threadIdx )
@@ -2068,40 +2062,13 @@ namespace Ogre
         LodStrategy *lodStrategy = LodStrategyManager::getSingleton().getDefaultStrategy();
 
         const Camera *lodCamera = request.lodCamera;
-        ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
-        ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
 
-        while( it != en )
-        {
-            ObjectMemoryManager *memoryManager = *it;
-            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
-
-            size_t firstRq = std::min<size_t>( request.firstRq, numRenderQueues );
-            size_t lastRq = std::min<size_t>( request.lastRq, numRenderQueues );
-
-            for( size_t i = firstRq; i < lastRq; ++i )
-            {
-                ObjectData objData;
-                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
-
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-                lodStrategy->lodUpdateImpl( numObjs, objData, lodCamera, request.lodBias );
-            }
-
-            ++it;
-        }
+        // The work was laid out by prepareObjectWork( request.objectMemManager )
+        ObjectWorkCursor cursor;
+        ObjectData objData;
+        size_t numObjs, rqId;
+        while( acquireObjectWork( threadIdx, cursor, objData, numObjs, rqId ) )
+            lodStrategy->lodUpdateImpl( numObjs, objData, lodCamera, request.lodBias );
     }
     //-----------------------------------------------------------------------
     void SceneManager::updateAllLods( const Camera *lodCamera, Real lodBias, uint8 firstRq,
@@ -2114,6 +2081,8 @@ namespace Ogre
         mUpdateLodRequest.camera->getFrustumPlanes();
         mUpdateLodRequest.lodCamera->getFrustumPlanes();
 
+        prepareObjectWork( mEntitiesMemoryManagerCulledList, firstRq, lastRq );
+
         fireWorkerThreadsAndWait();
     }
     //-----------------------------------------------------------------------
@@ -2138,13 +2107,62 @@ namespace Ogre
         const uint32 visibilityMask =
             request.cullingLights
                 ? ( camera->getLastViewport()->getLightVisibilityMask() & mLightMask )
-                : ( ( camera->getLastViewport()->getVisibilityMask() & this->getVisibilityMask() ) |
-                    ( camera->getLastViewport()->getVisibilityMask() &
-                      ~VisibilityFlags::RESERVED_VISIBILITY_FLAGS ) );
+                : getCombinedVisibilityMask( camera->getLastViewport()->getVisibilityMask() );
 
         CullFrustumPreparedData preparedData;
         MovableObject::cullFrustumPrepare( camera, visibilityMask, lodCamera, preparedData );
 
+        // The work was laid out by prepareObjectWork( request.objectMemManager ).
+        // Empty RQs are skipped. Profiling shows there is considerable gains.
+        // Too much (255 queues, most of them empty, multiples scene passes...)
+        ObjectWorkCursor cursor;
+        ObjectData objData;
+        size_t numObjs, rqId;
+        while( acquireObjectWork( threadIdx, cursor, objData, numObjs, rqId ) )
+        {
+            MovableObject::MovableObjectArray &outVisibleObjects =
+                *( visibleObjectsPerRq.begin() + rqId );
+
+            const uint8 currRqId = static_cast<uint8>( rqId );
+
+            MovableObject::cullFrustum( numObjs, objData, camera, outVisibleObjects, preparedData );
+
+            if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
+                request.addToRenderQueue )
+            {
+                // V2 meshes can be added to the render queue in parallel
+                addToRenderQueueV2( outVisibleObjects, currRqId, request.casterPass, threadIdx );
+                outVisibleObjects.clear();
+            }
+        }
+
+        addParticleSystems2ToRenderQueue( request, visibilityMask, threadIdx );
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::addToRenderQueueV2( const MovableObject::MovableObjectArray &visibleObjects,
+                                           uint8 rqId, bool casterPass, size_t threadIdx )
+    {
+        MovableObject::MovableObjectArray::const_iterator itor = visibleObjects.begin();
+        MovableObject::MovableObjectArray::const_iterator endt = visibleObjects.end();
+
+        while( itor != endt )
+        {
+            RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
+            RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
+
+            while( itRend != enRend )
+            {
+                if( ( *itRend )->mRenderableVisible )
+                    mRenderQueue->addRenderableV2( threadIdx, rqId, casterPass, *itRend, *itor );
+                ++itRend;
+            }
+            ++itor;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::addParticleSystems2ToRenderQueue( const CullFrustumRequest &request,
+                                                         uint32 visibilityMask, size_t threadIdx )
+    {
         ObjectMemoryManagerVec::const_iterator it = request.objectMemManager->begin();
         ObjectMemoryManagerVec::const_iterator en = request.objectMemManager->end();
 
@@ -2158,75 +2176,150 @@ namespace Ogre
 
             for( size_t i = firstRq; i < lastRq; ++i )
             {
-                MovableObject::MovableObjectArray &outVisibleObjects =
-                    *( visibleObjectsPerRq.begin() + i );
-
-                ObjectData objData;
-                const size_t totalObjs = memoryManager->getFirstObjectData( objData, i );
-
                 const uint8 currRqId = static_cast<uint8>( i );
 
-                // Skip if totalObjs == 0u. Profiling shows there is considerable gains.
-                // Too much (255 queues, most of them empty, multiples scene passes...)
-                if( totalObjs > 0u )
+                if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::PARTICLE_SYSTEM &&
+                    request.addToRenderQueue )
                 {
-                    // Distribute the work evenly across all threads (not perfect), taking into
-                    // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                    size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                    numObjs = ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) *
-                              ARRAY_PACKED_REALS;
+                    mParticleSystemManager2->_addToRenderQueue( threadIdx, mNumWorkerThreads,
+                                                                mRenderQueue, currRqId, visibilityMask,
+                                                                !request.casterPass );
+                }
+            }
 
-                    const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
+            ++it;
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::preCullFrustumsThread( size_t threadIdx )
+    {
+        const size_t numPending = mNumPreCulledFrustums - mFirstPendingPreCull;
 
-                    // Prevent going out of bounds (usually in the last threadIdx, or
-                    // when there are less entities than ARRAY_PACKED_REALS
-                    numObjs = std::min( numObjs, totalObjs - toAdvance );
-                    objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
+        for( size_t i = 0u; i < numPending; ++i )
+        {
+            VisibleObjectsPerRq &visibleObjectsPerRq =
+                mPreCulledFrustums[mFirstPendingPreCull + i].visibleObjects[threadIdx];
+            visibleObjectsPerRq.resize( 255 );
+            VisibleObjectsPerRq::iterator itor = visibleObjectsPerRq.begin();
+            VisibleObjectsPerRq::iterator endt = visibleObjectsPerRq.end();
 
-                    MovableObject::cullFrustum( numObjs, objData, camera, outVisibleObjects,
-                                                preparedData );
+            while( itor != endt )
+            {
+                itor->clear();
+                ++itor;
+            }
+        }
 
-                    if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST &&
-                        request.addToRenderQueue )
-                    {
-                        // V2 meshes can be added to the render queue in parallel
-                        bool casterPass = request.casterPass;
-                        MovableObject::MovableObjectArray::const_iterator itor =
-                            outVisibleObjects.begin();
-                        MovableObject::MovableObjectArray::const_iterator endt = outVisibleObjects.end();
+        // The work of all pending frustums was laid out by _flushPreCullFrustums
+        // in a single range, so that threads can steal from each other's cameras.
+        ObjectWorkCursor cursor;
+        ObjectData objData;
+        size_t numObjs, rqId;
+        while( acquireObjectWork( threadIdx, cursor, objData, numObjs, rqId ) )
+        {
+            PreCulledFrustum &preCulled = mPreCulledFrustums[mFirstPendingPreCull + cursor.requestIdx];
+            MovableObject::cullFrustum( numObjs, objData, preCulled.request.camera,
+                                        preCulled.visibleObjects[threadIdx][rqId],
+                                        mPreCullPreparedData[cursor.requestIdx] );
+        }
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::addPreCulledToRenderQueueThread( PreCulledFrustum &preCulled,
+                                                        size_t threadIdx )
+    {
+        VisibleObjectsPerRq &visibleObjectsPerRq = mVisibleObjects[threadIdx];
+        visibleObjectsPerRq.swap( preCulled.visibleObjects[threadIdx] );
 
-                        while( itor != endt )
-                        {
-                            RenderableArray::const_iterator itRend = ( *itor )->mRenderables.begin();
-                            RenderableArray::const_iterator enRend = ( *itor )->mRenderables.end();
+        const CullFrustumRequest &request = preCulled.request;
 
-                            while( itRend != enRend )
-                            {
-                                if( ( *itRend )->mRenderableVisible )
-                                {
-                                    mRenderQueue->addRenderableV2( threadIdx, currRqId, casterPass,
-                                                                   *itRend, *itor );
-                                }
-                                ++itRend;
-                            }
-                            ++itor;
-                        }
+        for( size_t i = request.firstRq; i < request.lastRq; ++i )
+        {
+            MovableObject::MovableObjectArray &visibleObjects = visibleObjectsPerRq[i];
 
-                        outVisibleObjects.clear();
-                    }
-                }
+            // preCullFrustumsThread couldn't write the distances (frustums were
+            // culled concurrently), but RenderQueue needs them for sorting.
+            MovableObject::MovableObjectArray::const_iterator itor = visibleObjects.begin();
+            MovableObject::MovableObjectArray::const_iterator endt = visibleObjects.end();
+            while( itor != endt )
+            {
+                ( *itor )->_updateCachedDistanceToCamera( request.camera );
+                ++itor;
+            }
 
-                if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::PARTICLE_SYSTEM &&
-                    request.addToRenderQueue )
+            const uint8 currRqId = static_cast<uint8>( i );
+            if( mRenderQueue->getRenderQueueMode( currRqId ) == RenderQueue::FAST )
+            {
+                addToRenderQueueV2( visibleObjects, currRqId, request.casterPass, threadIdx );
+                visibleObjects.clear();
+            }
+        }
+
+        addParticleSystems2ToRenderQueue( request, preCulled.visibilityMask, threadIdx );
+    }
+    //-----------------------------------------------------------------------
+    bool SceneManager::consumePreCulledFrustum( const CullFrustumRequest &request )
+    {
+        for( size_t i = 0u; i < mFirstPendingPreCull; ++i )
+        {
+            PreCulledFrustum &preCulled = mPreCulledFrustums[i];
+
+            if( !preCulled.consumed && preCulled.request.camera == request.camera &&
+                preCulled.request.lodCamera == request.lodCamera &&
+                preCulled.request.firstRq == request.firstRq &&
+                preCulled.request.lastRq == request.lastRq &&
+                preCulled.request.casterPass == request.casterPass &&
+                preCulled.request.objectMemManager == request.objectMemManager )
+            {
+                // Whether it is still valid or not, we won't be needing it again
+                preCulled.consumed = true;
+
+                const Camera *camera = request.camera;
+                const Camera *lodCamera = request.lodCamera;
+
+                const uint32 visibilityMask =
+                    getCombinedVisibilityMask( camera->getLastViewport()->getVisibilityMask() );
+                const Plane *frustumPlanes = camera->getFrustumPlanes();
+                lodCamera->getFrustumPlanes();
+
+                // Objects created since then would be missing; destroyed ones dangling
+                if( getLayoutRevision( *request.objectMemManager ) != preCulled.layoutRevision ||
+                    visibilityMask != preCulled.visibilityMask ||
+                    !std::equal( frustumPlanes, frustumPlanes + 6u, preCulled.planes ) ||
+                    lodCamera->_getCachedDerivedPosition() != preCulled.lodCameraPos ||
+                    lodCamera->getUseRenderingDistance() != preCulled.lodUseRenderingDistance )
                 {
-                    mParticleSystemManager2->_addToRenderQueue( threadIdx, mNumWorkerThreads,
-                                                                mRenderQueue, currRqId, visibilityMask,
-                                                                !request.casterPass );
+                    return false;
                 }
+
+                mCurrentPreCulledFrustum = &preCulled;
+                mRequestType = ADD_PRE_CULLED_TO_RENDER_QUEUE;
+                fireWorkerThreadsAndWait();
+                mCurrentPreCulledFrustum = 0;
+                return true;
             }
+        }
 
-            ++it;
+        return false;
+    }
+    //-----------------------------------------------------------------------
+    void SceneManager::getRealRenderQueueRange( uint8 firstRq, uint8 lastRq, uint8 &outRealFirstRq,
+                                                uint8 &outRealLastRq ) const
+    {
+        uint8 realFirstRq = firstRq;
+        uint8 realLastRq = 0;
+
+        ObjectMemoryManagerVec::const_iterator itor = mEntitiesMemoryManagerCulledList.begin();
+        ObjectMemoryManagerVec::const_iterator endt = mEntitiesMemoryManagerCulledList.end();
+        while( itor != endt )
+        {
+            realFirstRq = (uint8)std::min<size_t>( realFirstRq, ( *itor )->_getTotalRenderQueues() );
+            realLastRq = (uint8)std::max<size_t>( realLastRq, ( *itor )->_getTotalRenderQueues() );
+            ++itor;
         }
+
+        // clamp RQ values to the real RQ range
+        outRealFirstRq = std::min( realLastRq, std::max( realFirstRq, firstRq ) );
+        outRealLastRq = std::min( realLastRq, std::max( outRealFirstRq, lastRq ) );
     }
     //-----------------------------------------------------------------------
     inline bool OrderLightByShadowCastThenId( const Light *_l, const Light *_r )
@@ -2445,6 +2538,8 @@ namespace Ogre
         {
             // Now fire the threads again, to build the per-MovableObject lists
             mRequestType = BUILD_LIGHT_LIST02;
+            prepareObjectWork( mEntitiesMemoryManagerCulledList, 0u,
+                               std::numeric_limits<size_t>::max() );
             if( mForceMainThread )
                 updateWorkerThreadImpl( 0 );
             else
@@ -2510,37 +2605,13 @@ namespace Ogre
     //-----------------------------------------------------------------------
     void SceneManager::buildLightListThread02( size_t threadIdx )
     {
-        // Global light list built. Now build a per-movable object light list
-        ObjectMemoryManagerVec::const_iterator it = mEntitiesMemoryManagerCulledList.begin();
-        ObjectMemoryManagerVec::const_iterator en = mEntitiesMemoryManagerCulledList.end();
-        while( it != en )
-        {
-            ObjectMemoryManager *objMemoryManager = *it;
-            const size_t numRenderQueues = objMemoryManager->getNumRenderQueues();
-
-            for( size_t i = 0; i < numRenderQueues; ++i )
-            {
-                ObjectData objData;
-                const size_t totalObjs = objMemoryManager->getFirstObjectData( objData, i );
-
-                // Distribute the work evenly across all threads (not perfect), taking into
-                // account we need to distribute in multiples of ARRAY_PACKED_REALS
-                size_t numObjs = ( totalObjs + ( mNumWorkerThreads - 1 ) ) / mNumWorkerThreads;
-                numObjs =
-                    ( ( numObjs + ARRAY_PACKED_REALS - 1 ) / ARRAY_PACKED_REALS ) * ARRAY_PACKED_REALS;
-
-                const size_t toAdvance = std::min( threadIdx * numObjs, totalObjs );
-
-                // Prevent going out of bounds (usually in the last threadIdx, or
-                // when there are less entities than ARRAY_PACKED_REALS
-                numObjs = std::min( numObjs, totalObjs - toAdvance );
-                objData.advancePack( toAdvance / ARRAY_PACKED_REALS );
-
-                MovableObject::buildLightList( numObjs, objData, mGlobalLightList );
-            }
-
-            ++it;
-        }
+        // Global light list built. Now build a per-movable object light list.
+        // The work was laid out by prepareObjectWork( mEntitiesMemoryManagerCulledList )
+        ObjectWorkCursor cursor;
+        ObjectData objData;
+        size_t numObjs, rqId;
+        while( acquireObjectWork( threadIdx, cursor, objData, numObjs, rqId ) )
+            MovableObject::buildLightList( numObjs, objData, mGlobalLightList );
     }
     //-----------------------------------------------------------------------
     void SceneManager::warmUpShaders( const CullFrustumRequest &request, size_t threadIdx )
@@ -2706,6 +2777,9 @@ namespace Ogre
 
         OgreProfileGroup( "updateSceneGraph", OGREPROF_GENERAL );
 
+        // Whatever was culled ahead of time is stale now
+        clearPreCulledFrustums();
+
         // Update controllers
         ControllerManager &controllerManager = ControllerManager::getSingleton();
         controllerManager.updateAllControllers();
@@ -4134,6 +4208,13 @@ namespace Ogre
         return q;
     }
     //---------------------------------------------------------------------
+    BatchRaySceneQuery *SceneManager::createBatchRayQuery( uint32 mask )
+    {
+        DefaultBatchRaySceneQuery *q = OGRE_NEW DefaultBatchRaySceneQuery( this );
+        q->setQueryMask( mask );
+        return q;
+    }
+    //---------------------------------------------------------------------
     void SceneManager::destroyQuery( SceneQuery *query ) { OGRE_DELETE query; }
     //---------------------------------------------------------------------
     SceneManager::MovableObjectCollection *SceneManager::getMovableObjectCollection(
@@ -4597,6 +4678,232 @@ namespace Ogre
             mGpuParamsDirty = 0;
         }
     }
+    //---------------------------------------------------------------------
+    void SceneManager::prepareObjectWork( const ObjectMemoryManagerVec &objectMemManager,
+                                          size_t firstRq, size_t lastRq, const Camera *cullCamera )
+    {
+        mObjectWorkSegments.clear();
+        mObjectWorkPacks.clear();
+        const size_t totalObjs =
+            appendObjectWork( objectMemManager, firstRq, lastRq, 0u, 0u, cullCamera );
+        mWorkStealingRange.reset( totalObjs, mNumWorkerThreads, ARRAY_PACKED_REALS );
+    }
+    //---------------------------------------------------------------------
+    size_t SceneManager::appendObjectWork( const ObjectMemoryManagerVec &objectMemManager,
+                                           size_t firstRq, size_t lastRq, size_t requestIdx,
+                                           size_t totalObjs, const Camera *cullCamera )
+    {
+        ObjectMemoryManagerVec::const_iterator it = objectMemManager.begin();
+        ObjectMemoryManagerVec::const_iterator en = objectMemManager.end();
+
+        while( it != en )
+        {
+            ObjectMemoryManager *memoryManager = *it;
+            const size_t numRenderQueues = memoryManager->getNumRenderQueues();
+
+            const size_t rqStart = std::min( firstRq, numRenderQueues );
+            const size_t rqEnd = std::min( lastRq, numRenderQueues );
+
+            for( size_t i = rqStart; i < rqEnd; ++i )
+            {
+                ObjectData objData;
+                const size_t numObjs = memoryManager->getFirstObjectData( objData, i );
+
+                if( numObjs > 0u )
+                {
+                    ObjectWorkSegment segment;
+                    segment.memoryManager = memoryManager;
+                    segment.rqId = i;
+                    segment.start = totalObjs;
+                    segment.numObjs = numObjs;
+                    segment.requestIdx = requestIdx;
+                    segment.firstPack = c_noPackList;
+                    segment.rqNumObjs = numObjs;
+
+                    const ObjectSpatialIndex *spatialIndex =
+                        cullCamera ? memoryManager->getSpatialIndex( i ) : 0;
+                    if( spatialIndex )
+                    {
+                        segment.firstPack = mObjectWorkPacks.size();
+                        spatialIndex->cullFrustum( cullCamera->_getCachedFrustumPlanes(),
+                                                   mObjectWorkPacks );
+                        segment.numObjs =
+                            ( mObjectWorkPacks.size() - segment.firstPack ) * ARRAY_PACKED_REALS;
+                        if( segment.numObjs == 0u )
+                            continue;
+                    }
+
+                    mObjectWorkSegments.push_back( segment );
+
+                    // Keep every segment starting at a multiple of ARRAY_PACKED_REALS.
+                    // Only count the packs that survived the spatial index, if any.
+                    totalObjs += alignToNextMultiple<size_t>( segment.numObjs, ARRAY_PACKED_REALS );
+                }
+            }
+
+            ++it;
+        }
+
+        return totalObjs;
+    }
+    //---------------------------------------------------------------------
+    bool SceneManager::acquireObjectWork( size_t threadIdx, ObjectWorkCursor &cursor,
+                                          ObjectData &outObjData, size_t &outNumObjs,
+                                          size_t &outRqId )
+    {
+        while( true )
+        {
+            if( cursor.count == 0u )
+            {
+                if( !mWorkStealingRange.acquire( threadIdx, cursor.start, cursor.count ) )
+                    return false;
+
+                // Find the segment containing cursor.start
+                ObjectWorkSegmentArray::const_iterator itSegment = std::lower_bound(
+                    mObjectWorkSegments.begin(), mObjectWorkSegments.end(), cursor.start + 1u );
+                OGRE_ASSERT_MEDIUM( itSegment != mObjectWorkSegments.begin() );
+                cursor.segmentIdx = static_cast<size_t>( itSegment - mObjectWorkSegments.begin() ) - 1u;
+            }
+
+            // A chunk may span multiple segments; we must return them one at a time.
+            const ObjectWorkSegment &segment = mObjectWorkSegments[cursor.segmentIdx];
+            const size_t localStart = cursor.start - segment.start;
+            const size_t segmentEnd =
+                segment.start + alignToNextMultiple<size_t>( segment.numObjs, ARRAY_PACKED_REALS );
+            const size_t numToConsume = std::min( cursor.count, segmentEnd - cursor.start );
+
+            // Past the last pack, the chunk gets skipped below like any padding
+            if( segment.firstPack != c_noPackList && localStart < segment.numObjs )
+            {
+                // Packs culled by the spatial index are not contiguous. Return them one at a time
+                const uint32 packIdx =
+                    mObjectWorkPacks[segment.firstPack + localStart / ARRAY_PACKED_REALS];
+
+                cursor.start += ARRAY_PACKED_REALS;
+                cursor.count -= ARRAY_PACKED_REALS;
+                if( cursor.start == segmentEnd )
+                    ++cursor.segmentIdx;
+
+                segment.memoryManager->getFirstObjectData( outObjData, segment.rqId );
+                outObjData.advancePack( packIdx );
+                outNumObjs = std::min<size_t>( ARRAY_PACKED_REALS,
+                                               segment.rqNumObjs - packIdx * ARRAY_PACKED_REALS );
+                outRqId = segment.rqId;
+                cursor.requestIdx = segment.requestIdx;
+                return true;
+            }
+
+            cursor.start += numToConsume;
+            cursor.count -= numToConsume;
+            ++cursor.segmentIdx;
+
+            if( localStart < segment.numObjs )
+            {
+                segment.memoryManager->getFirstObjectData( outObjData, segment.rqId );
+                outObjData.advancePack( localStart / ARRAY_PACKED_REALS );
+                outNumObjs = std::min( numToConsume, segment.numObjs - localStart );
+                outRqId = segment.rqId;
+                cursor.requestIdx = segment.requestIdx;
+                return true;
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::setWorkStealingEnabled( bool bEnabled )
+    {
+        mWorkStealingRange.setStealingEnabled( bEnabled );
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::setConcurrentCullingEnabled( bool bEnabled )
+    {
+        mConcurrentCullingEnabled = bEnabled;
+        clearPreCulledFrustums();
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::clearPreCulledFrustums()
+    {
+        mNumPreCulledFrustums = 0u;
+        mFirstPendingPreCull = 0u;
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::_queuePreCullFrustum( const Camera *camera, const Camera *lodCamera,
+                                             uint8 firstRq, uint8 lastRq,
+                                             uint32 viewportVisibilityMask )
+    {
+        if( !mConcurrentCullingEnabled || !mFindVisibleObjects )
+            return;
+
+        if( mNumPreCulledFrustums == mPreCulledFrustums.size() )
+            mPreCulledFrustums.push_back( PreCulledFrustum() );
+
+        uint8 realFirstRq, realLastRq;
+        getRealRenderQueueRange( firstRq, lastRq, realFirstRq, realLastRq );
+
+        PreCulledFrustum &preCulled = mPreCulledFrustums[mNumPreCulledFrustums++];
+        preCulled.request = CullFrustumRequest( realFirstRq, realLastRq,
+                                                mIlluminationStage == IRS_RENDER_TO_TEXTURE, true,
+                                                false, &mEntitiesMemoryManagerCulledList, camera,
+                                                lodCamera );
+        preCulled.visibilityMask = getCombinedVisibilityMask( viewportVisibilityMask );
+        preCulled.consumed = false;
+    }
+    //---------------------------------------------------------------------
+    void SceneManager::_flushPreCullFrustums()
+    {
+        const size_t numPending = mNumPreCulledFrustums - mFirstPendingPreCull;
+        if( !numPending )
+            return;
+
+        OgreProfileGroup( "Frustum Culling", OGREPROF_CULLING );
+
+        OGRE_LOCK_MUTEX( sceneGraphMutex );
+
+        if( numPending > mPreCullPreparedDataCapacity )
+        {
+            if( mPreCullPreparedData )
+                OGRE_FREE_SIMD( mPreCullPreparedData, MEMCATEGORY_SCENE_CONTROL );
+            mPreCullPreparedData = reinterpret_cast<CullFrustumPreparedData *>( OGRE_MALLOC_SIMD(
+                sizeof( CullFrustumPreparedData ) * numPending, MEMCATEGORY_SCENE_CONTROL ) );
+            mPreCullPreparedDataCapacity = numPending;
+        }
+
+        mObjectWorkSegments.clear();
+        mObjectWorkPacks.clear();
+        size_t totalObjs = 0u;
+
+        for( size_t i = 0u; i < numPending; ++i )
+        {
+            PreCulledFrustum &preCulled = mPreCulledFrustums[mFirstPendingPreCull + i];
+            const CullFrustumRequest &request = preCulled.request;
+
+            // Update the frustum planes now; see fireCullFrustumThreads
+            const Plane *frustumPlanes = request.camera->getFrustumPlanes();
+            request.lodCamera->getFrustumPlanes();
+
+            std::copy( frustumPlanes, frustumPlanes + 6u, preCulled.planes );
+            preCulled.lodCameraPos = request.lodCamera->_getCachedDerivedPosition();
+            preCulled.lodUseRenderingDistance = request.lodCamera->getUseRenderingDistance();
+            preCulled.layoutRevision = getLayoutRevision( *request.objectMemManager );
+            preCulled.visibleObjects.resize( mNumWorkerThreads );
+
+            CullFrustumPreparedData &preparedData = mPreCullPreparedData[i];
+            MovableObject::cullFrustumPrepare( request.camera, preCulled.visibilityMask,
+                                               request.lodCamera, preparedData );
+            // The same object may be visible from many of the frustums
+            preparedData.updateDistanceToCamera = false;
+
+            totalObjs = appendObjectWork( *request.objectMemManager, request.firstRq, request.lastRq,
+                                          i, totalObjs, request.camera );
+        }
+
+        mWorkStealingRange.reset( totalObjs, mNumWorkerThreads, ARRAY_PACKED_REALS );
+
+        mRequestType = PRE_CULL_FRUSTUMS;
+        fireWorkerThreadsAndWait();
+
+        mFirstPendingPreCull = mNumPreCulledFrustums;
+    }
+    //---------------------------------------------------------------------
     void SceneManager::fireWorkerThreadsAndWait()
     {
         if( mForceMainThread )
@@ -4618,6 +4925,8 @@ namespace Ogre
         // in case they weren't up to date.
         mCurrentCullFrustumRequest.camera->getFrustumPlanes();
         mCurrentCullFrustumRequest.lodCamera->getFrustumPlanes();
+        prepareObjectWork( *request.objectMemManager, request.firstRq, request.lastRq,
+                           request.camera );
         fireWorkerThreadsAndWait();
     }
     //---------------------------------------------------------------------
@@ -4738,12 +5047,21 @@ namespace Ogre
         case WARM_UP_SHADERS_COMPILE:
             mRenderQueue->_warmUpShadersThread( threadIdx );
             break;
+        case WARM_UP_SHADERS_PREGENERATE:
+            mRenderQueue->_warmUpShadersPregenerateThread( threadIdx );
+            break;
         case PARALLEL_HLMS_COMPILE:
             mRenderQueue->_compileShadersThread( threadIdx );
             break;
         case PARTICLE_SYSTEM_MANAGER2:
             mParticleSystemManager2->_updateParallel( threadIdx, mNumWorkerThreads );
             break;
+        case PRE_CULL_FRUSTUMS:
+            preCullFrustumsThread( threadIdx );
+            break;
+        case ADD_PRE_CULLED_TO_RENDER_QUEUE:
+            addPreCulledToRenderQueueThread( *mCurrentPreCulledFrustum, threadIdx );
+            break;
         case USER_UNIFORM_SCALABLE_TASK:
             mUserTask->execute( threadIdx, mNumWorkerThreads );
             break;
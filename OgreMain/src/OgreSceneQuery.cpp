@@ -219,6 +219,25 @@ namespace Ogre
         return true;
     }
     //-----------------------------------------------------------------------
+    BatchRaySceneQuery::BatchRaySceneQuery( SceneManager *mgr ) :
+        SceneQuery( mgr ),
+        mMaxDistance( std::numeric_limits<Real>::infinity() ),
+        mTriangleLevel( false )
+    {
+    }
+    //-----------------------------------------------------------------------
+    BatchRaySceneQuery::~BatchRaySceneQuery() {}
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::setRays( const Ray *rays, size_t numRays )
+    {
+        mRays.clear();
+        mRays.append( rays, rays + numRays );
+    }
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::setMaxDistance( Real maxDistance ) { mMaxDistance = maxDistance; }
+    //-----------------------------------------------------------------------
+    void BatchRaySceneQuery::setTriangleLevel( bool triangleLevel ) { mTriangleLevel = triangleLevel; }
+    //-----------------------------------------------------------------------
     /*
     PyramidSceneQuery::PyramidSceneQuery(SceneManager* mgr) : RegionSceneQuery(mgr)
     {
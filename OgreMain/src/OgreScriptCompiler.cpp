@@ -30,6 +30,8 @@ THE SOFTWARE.
 
 #include "OgreScriptCompiler.h"
 
+#include "OgreArchive.h"
+#include "OgreIdString.h"
 #include "OgreLogManager.h"
 #include "OgreResourceGroupManager.h"
 #include "OgreScriptParser.h"
@@ -37,6 +39,14 @@ THE SOFTWARE.
 #include "OgreString.h"
 #include "OgreStringConverter.h"
 
+#include "Hash/MurmurHash3.h"
+
+#if OGRE_ARCH_TYPE == OGRE_ARCHITECTURE_32
+#    define OGRE_HASH128_FUNC MurmurHash3_x86_128
+#else
+#    define OGRE_HASH128_FUNC MurmurHash3_x64_128
+#endif
+
 namespace Ogre
 {
     // AbstractNode
@@ -1697,9 +1707,157 @@ namespace Ogre
         return ( *msSingleton );
     }
     //-----------------------------------------------------------------------
+    // ScriptCompilerManager's AST cache
+    static const uint32 c_astCacheMagic = 0x5453414F;  // 'OAST'
+    static const uint16 c_astCacheVersion = 1u;
+
+    template <typename T>
+    static void writeAstValue( vector<uint8>::type &buffer, const T &value )
+    {
+        const uint8 *src = reinterpret_cast<const uint8 *>( &value );
+        buffer.insert( buffer.end(), src, src + sizeof( T ) );
+    }
+
+    static void writeAstString( vector<uint8>::type &buffer, const String &value )
+    {
+        writeAstValue( buffer, static_cast<uint32>( value.size() ) );
+        buffer.insert( buffer.end(), value.begin(), value.end() );
+    }
+
+    static void writeAstNodes( vector<uint8>::type &buffer, const ConcreteNodeList &nodes )
+    {
+        writeAstValue( buffer, static_cast<uint32>( nodes.size() ) );
+        for( ConcreteNodeList::const_iterator itor = nodes.begin(); itor != nodes.end(); ++itor )
+        {
+            const ConcreteNode *node = itor->get();
+            writeAstValue( buffer, static_cast<uint8>( node->type ) );
+            writeAstValue( buffer, static_cast<uint32>( node->line ) );
+            writeAstString( buffer, node->token );
+            writeAstNodes( buffer, node->children );
+        }
+    }
+
+    /// Reads what writeAstNodes wrote. All reads are bounds-checked; a truncated or
+    /// corrupt entry just makes them return false
+    struct AstReader
+    {
+        const uint8 *ptr;
+        const uint8 *end;
+
+        template <typename T>
+        bool read( T &outValue )
+        {
+            if( static_cast<size_t>( end - ptr ) < sizeof( T ) )
+                return false;
+            memcpy( &outValue, ptr, sizeof( T ) );
+            ptr += sizeof( T );
+            return true;
+        }
+
+        bool readString( String &outValue )
+        {
+            uint32 length;
+            if( !read( length ) || static_cast<size_t>( end - ptr ) < length )
+                return false;
+            outValue.assign( reinterpret_cast<const char *>( ptr ), length );
+            ptr += length;
+            return true;
+        }
+
+        bool readNodes( ConcreteNodeList &outNodes, ConcreteNode *parent, const String &source )
+        {
+            uint32 numNodes;
+            if( !read( numNodes ) )
+                return false;
+
+            for( uint32 i = 0u; i < numNodes; ++i )
+            {
+                uint8 type;
+                uint32 line;
+                if( !read( type ) || !read( line ) || type > CNT_COLON )
+                    return false;
+
+                ConcreteNodePtr node( OGRE_NEW ConcreteNode() );
+                if( !readString( node->token ) )
+                    return false;
+                node->file = source;
+                node->line = line;
+                node->type = static_cast<ConcreteNodeType>( type );
+                node->parent = parent;
+                if( !readNodes( node->children, node.get(), source ) )
+                    return false;
+                outNodes.push_back( node );
+            }
+
+            return true;
+        }
+    };
+
+    static ConcreteNodeListPtr loadCachedAst( Archive *archive, const String &cacheName,
+                                              time_t modifiedTime, const uint64 sourceHash[2],
+                                              const String &source )
+    {
+        if( !archive->exists( cacheName ) )
+            return ConcreteNodeListPtr();
+
+        DataStreamPtr cacheStream = archive->open( cacheName );
+        if( !cacheStream )
+            return ConcreteNodeListPtr();
+
+        MemoryDataStream data( cacheStream );
+        AstReader reader;
+        reader.ptr = data.getPtr();
+        reader.end = data.getPtr() + data.size();
+
+        uint32 magic;
+        uint16 version;
+        int64 cachedModifiedTime;
+        uint64 cachedHash[2];
+        String cachedSource;
+        if( !reader.read( magic ) || !reader.read( version ) || !reader.read( cachedModifiedTime ) ||
+            !reader.read( cachedHash ) || !reader.readString( cachedSource ) )
+        {
+            return ConcreteNodeListPtr();
+        }
+
+        if( magic != c_astCacheMagic || version != c_astCacheVersion ||
+            cachedModifiedTime != static_cast<int64>( modifiedTime ) ||
+            cachedHash[0] != sourceHash[0] || cachedHash[1] != sourceHash[1] ||
+            cachedSource != source )
+        {
+            return ConcreteNodeListPtr();
+        }
+
+        ConcreteNodeListPtr nodes( OGRE_NEW_T( ConcreteNodeList, MEMCATEGORY_GENERAL )(),
+                                   SPFM_DELETE_T );
+        if( !reader.readNodes( *nodes, 0, source ) )
+            return ConcreteNodeListPtr();
+
+        return nodes;
+    }
+
+    static void saveCachedAst( Archive *archive, const String &cacheName, time_t modifiedTime,
+                               const uint64 sourceHash[2], const String &source,
+                               const ConcreteNodeList &nodes )
+    {
+        vector<uint8>::type buffer;
+        writeAstValue( buffer, c_astCacheMagic );
+        writeAstValue( buffer, c_astCacheVersion );
+        writeAstValue( buffer, static_cast<int64>( modifiedTime ) );
+        writeAstValue( buffer, sourceHash[0] );
+        writeAstValue( buffer, sourceHash[1] );
+        writeAstString( buffer, source );
+        writeAstNodes( buffer, nodes );
+
+        DataStreamPtr cacheStream = archive->create( cacheName );
+        cacheStream->write( buffer.data(), buffer.size() );
+    }
+
+    // ScriptCompilerManager
     ScriptCompilerManager::ScriptCompilerManager() :
         mListener( 0 ),
-        OGRE_THREAD_POINTER_INIT( mScriptCompiler )
+        OGRE_THREAD_POINTER_INIT( mScriptCompiler ),
+        mAstCache( 0 )
     {
         OGRE_LOCK_AUTO_MUTEX;
         mScriptPatterns.push_back( "*.program" );
@@ -1789,7 +1947,50 @@ namespace Ogre
         return 90.0f;
     }
     //-----------------------------------------------------------------------
+    void ScriptCompilerManager::setAstCache( Archive *archive ) { mAstCache = archive; }
+    //-----------------------------------------------------------------------
     void ScriptCompilerManager::parseScript( DataStreamPtr &stream, const String &groupName )
+    {
+        parsePreparedScript( prepareScript( stream, 0 ), groupName );
+    }
+    //-----------------------------------------------------------------------
+    Any ScriptCompilerManager::prepareScript( DataStreamPtr &stream, time_t modifiedTime )
+    {
+        // Runs on worker threads. Only the lexer and the parser are used here; they are
+        // stateless, unlike the compiler (which also creates resources)
+        const String sourceCode = stream->getAsString();
+        const String &source = stream->getName();
+
+        Archive *astCache = mAstCache;
+        uint64 sourceHash[2] = { 0u, 0u };
+        String cacheName;
+        if( astCache )
+        {
+            OGRE_HASH128_FUNC( sourceCode.c_str(), static_cast<int>( sourceCode.size() ),
+                               IdString::Seed, sourceHash );
+            uint32 sourceNameHash;
+            MurmurHash3_x86_32( source.c_str(), static_cast<int>( source.size() ), IdString::Seed,
+                                &sourceNameHash );
+            cacheName = "ScriptAst_" +
+                        StringConverter::toString( sourceNameHash, 8u, '0', std::ios::hex ) + ".bin";
+
+            ConcreteNodeListPtr nodes =
+                loadCachedAst( astCache, cacheName, modifiedTime, sourceHash, source );
+            if( nodes )
+                return Any( nodes );
+        }
+
+        ScriptLexer lexer;
+        ScriptParser parser;
+        ConcreteNodeListPtr nodes = parser.parse( lexer.tokenize( sourceCode ), source );
+
+        if( astCache )
+            saveCachedAst( astCache, cacheName, modifiedTime, sourceHash, source, *nodes );
+
+        return Any( nodes );
+    }
+    //-----------------------------------------------------------------------
+    void ScriptCompilerManager::parsePreparedScript( const Any &prepared, const String &groupName )
     {
 #if OGRE_THREAD_SUPPORT
         // check we have an instance for this thread (should always have one for main thread)
@@ -1806,7 +2007,7 @@ namespace Ogre
             OGRE_THREAD_POINTER_GET( mScriptCompiler )->setListener( mListener );
         }
         OGRE_THREAD_POINTER_GET( mScriptCompiler )
-            ->compile( stream->getAsString(), stream->getName(), groupName );
+            ->compile( any_cast<ConcreteNodeListPtr>( prepared ), groupName );
     }
 
     //-------------------------------------------------------------------------
@@ -1828,3 +2029,5 @@ namespace Ogre
     //-------------------------------------------------------------------------
     String CreateCompositorScriptCompilerEvent::eventType = "createCompositor";
 }  // namespace Ogre
+
+#undef OGRE_HASH128_FUNC
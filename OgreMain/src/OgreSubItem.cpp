@@ -49,6 +49,7 @@ namespace Ogre
         mMaterialLodIndex = 0;
         mVaoPerLod[VpNormal] = subMeshBasis->mVao[VpNormal];
         mVaoPerLod[VpShadow] = subMeshBasis->mVao[VpShadow];
+        mClusteredSubMesh = subMeshBasis;
 
         setupSkeleton();
 
@@ -97,6 +98,17 @@ namespace Ogre
         Renderable::_setHlmsHashes( hash, casterHash );
     }
     //-----------------------------------------------------------------------
+    void SubItem::_updateVaosFromSubMesh()
+    {
+        mVaoPerLod[VpNormal] = mSubMesh->mVao[VpNormal];
+
+        // Keep disabling the optimized shadow mapping buffers for alpha tested materials
+        if( mHlmsDatablock && mHlmsDatablock->getAlphaTest() != CMPF_ALWAYS_PASS )
+            mVaoPerLod[VpShadow] = mSubMesh->mVao[VpNormal];
+        else
+            mVaoPerLod[VpShadow] = mSubMesh->mVao[VpShadow];
+    }
+    //-----------------------------------------------------------------------
     const LightList &SubItem::getLights() const { return mParentItem->queryLights(); }
     //-----------------------------------------------------------------------------
     void SubItem::getRenderOperation( v1::RenderOperation &op, bool casterPass )
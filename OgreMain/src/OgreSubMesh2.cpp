@@ -29,6 +29,7 @@ THE SOFTWARE.
 
 #include "OgreSubMesh2.h"
 
+#include "Math/Array/OgreTriangleBvh.h"
 #include "OgreBitwise.h"
 #include "OgreException.h"
 #include "OgreHardwareBufferManager.h"
@@ -40,6 +41,7 @@ THE SOFTWARE.
 #include "OgreVertexShadowMapHelper.h"
 #include "Vao/OgreAsyncTicket.h"
 #include "Vao/OgreVaoManager.h"
+#include "Vao/OgreVertexBufferDownloadHelper.h"
 
 namespace Ogre
 {
@@ -50,7 +52,8 @@ namespace Ogre
         mNumPoses( 0 ),
         mPoseHalfPrecision( false ),
         mPoseNormals( false ),
-        mPoseTexBuffer( 0 )
+        mPoseTexBuffer( 0 ),
+        mMaxExtraClusterDraws( 0u )
     {
     }
     //-----------------------------------------------------------------------
@@ -475,6 +478,8 @@ namespace Ogre
 
         newSub->mBoneAssignments = mBoneAssignments;
         newSub->mBoneAssignmentsOutOfDate = mBoneAssignmentsOutOfDate;
+        newSub->mClusters = mClusters;
+        newSub->mMaxExtraClusterDraws = mMaxExtraClusterDraws;
 
         const uint8 numVaoPasses = mParent->hasIndependentShadowMappingVaos() + 1;
         for( uint8 i = 0; i < numVaoPasses; ++i )
@@ -1496,6 +1501,502 @@ namespace Ogre
         return data;
     }
     //---------------------------------------------------------------------
+    /// Decodes VES_POSITION into packed XYZ floats. Returns false if it's not in a float format.
+    static bool readPositionsForOptimizer( const VertexArrayObject                *vao,
+                                           const MeshOptimizer::VertexStreamArray &streams,
+                                           size_t numVertices, vector<float>::type &outPositions )
+    {
+        size_t bufferIdx = 0, offset = 0;
+        const VertexElement2 *element = vao->findBySemantic( VES_POSITION, bufferIdx, offset );
+        if( !element || v1::VertexElement::getTypeCount( element->mType ) < 3u )
+            return false;
+
+        const VertexElementType baseType = v1::VertexElement::getBaseType( element->mType );
+        if( baseType != VET_FLOAT1 && baseType != VET_HALF2 )
+            return false;
+
+        const uint8 *srcData = streams[bufferIdx].data + offset;
+        const size_t bytesPerVertex = streams[bufferIdx].bytesPerVertex;
+
+        outPositions.resize( numVertices * 3u );
+        for( size_t i = 0; i < numVertices; ++i )
+        {
+            for( size_t j = 0; j < 3u; ++j )
+            {
+                if( baseType == VET_FLOAT1 )
+                {
+                    memcpy( &outPositions[i * 3u + j], srcData + j * sizeof( float ), sizeof( float ) );
+                }
+                else
+                {
+                    uint16 halfValue;
+                    memcpy( &halfValue, srcData + j * sizeof( uint16 ), sizeof( uint16 ) );
+                    outPositions[i * 3u + j] = Bitwise::halfToFloat( halfValue );
+                }
+            }
+            srcData += bytesPerVertex;
+        }
+
+        return true;
+    }
+    //---------------------------------------------------------------------
+    MeshOptimizer::Report SubMesh::optimizeGeometry( uint32 flags, float overdrawThreshold )
+    {
+        MeshOptimizer::Report report;
+
+        VaoManager *vaoManager = mParent->mVaoManager;
+        VertexArrayObjectArray &vaos = mVao[VpNormal];
+
+        const bool independentShadowVaos =
+            !vaos.empty() && !mVao[VpShadow].empty() && vaos[0] != mVao[VpShadow][0];
+
+        // The pose buffer refers to the vertices by their position in the vertex buffer
+        if( mNumPoses > 0u )
+            flags &= ~uint32( MeshOptimizer::OptimizeVertexFetch | MeshOptimizer::WeldVertices );
+
+        const uint32 c_invalidIndex = 0xFFFFFFFF;
+
+        VertexArrayObjectArray newVaos( vaos );
+        VertexArrayObjectArray oldVaos;
+        vector<bool>::type processed( vaos.size(), false );
+
+        for( size_t lodIdx = 0; lodIdx < vaos.size(); ++lodIdx )
+        {
+            if( processed[lodIdx] )
+                continue;
+
+            // LODs sharing the vertex buffers must be optimized together,
+            // since they all get remapped to the new vertex order.
+            const VertexBufferPackedVec &vertexBuffers = vaos[lodIdx]->getVertexBuffers();
+            FastArray<size_t> lods;
+            bool canOptimize = !vertexBuffers.empty();
+            for( size_t i = lodIdx; i < vaos.size(); ++i )
+            {
+                const VertexArrayObject *vao = vaos[i];
+                if( vao->getVertexBuffers() == vertexBuffers )
+                {
+                    lods.push_back( i );
+                    processed[i] = true;
+                    if( !vao->getIndexBuffer() || vao->getIndexBuffer()->getNumElements() == 0u ||
+                        vao->getOperationType() != OT_TRIANGLE_LIST )
+                    {
+                        canOptimize = false;
+                    }
+                }
+            }
+
+            if( !canOptimize )
+                continue;
+
+            const size_t numVertices = vertexBuffers[0]->getNumElements();
+
+            vector<AsyncTicketPtr>::type asyncTickets;
+            MeshOptimizer::VertexStreamArray streams;
+            for( size_t i = 0; i < vertexBuffers.size(); ++i )
+            {
+                AsyncTicketPtr asyncTicket =
+                    vertexBuffers[i]->readRequest( 0, vertexBuffers[i]->getNumElements() );
+                asyncTickets.push_back( asyncTicket );
+
+                MeshOptimizer::VertexStream stream;
+                stream.data = reinterpret_cast<const uint8 *>( asyncTicket->map() );
+                stream.bytesPerVertex = vertexBuffers[i]->getBytesPerElement();
+                streams.push_back( stream );
+            }
+
+            // Gather the indices of all the LODs in a single 32-bit array
+            vector<uint32>::type indices;
+            FastArray<size_t> indexOffsets;
+            for( size_t i = 0; i < lods.size(); ++i )
+            {
+                IndexBufferPacked *indexBuffer = vaos[lods[i]]->getIndexBuffer();
+                indexOffsets.push_back( indices.size() );
+
+                AsyncTicketPtr asyncTicket =
+                    indexBuffer->readRequest( 0, indexBuffer->getNumElements() );
+                const void *indexData = asyncTicket->map();
+                if( indexBuffer->getIndexType() == IndexBufferPacked::IT_16BIT )
+                {
+                    const uint16 *srcIndices = reinterpret_cast<const uint16 *>( indexData );
+                    indices.insert( indices.end(), srcIndices,
+                                    srcIndices + indexBuffer->getNumElements() );
+                }
+                else
+                {
+                    const uint32 *srcIndices = reinterpret_cast<const uint32 *>( indexData );
+                    indices.insert( indices.end(), srcIndices,
+                                    srcIndices + indexBuffer->getNumElements() );
+                }
+                asyncTicket->unmap();
+            }
+
+            // Only the range each LOD renders gets its triangles reordered & measured
+            FastArray<size_t> rangeStarts;
+            FastArray<size_t> rangeCounts;
+            for( size_t i = 0; i < lods.size(); ++i )
+            {
+                const VertexArrayObject *vao = vaos[lods[i]];
+                rangeStarts.push_back( indexOffsets[i] + vao->getPrimitiveStart() );
+                rangeCounts.push_back( vao->getPrimitiveCount() - vao->getPrimitiveCount() % 3u );
+
+                MeshOptimizer::Stats stats = MeshOptimizer::analyze(
+                    &indices[rangeStarts[i]], rangeCounts[i], numVertices );
+                if( i != 0u )
+                    stats.numVerticesStored = 0u;  // Shared with the first LOD
+                report.before.merge( stats );
+            }
+
+            vector<uint32>::type weldRemap;
+            if( flags & MeshOptimizer::WeldVertices )
+            {
+                weldRemap.resize( numVertices );
+                MeshOptimizer::weldVertices( streams, numVertices, &weldRemap[0] );
+                for( size_t i = 0; i < indices.size(); ++i )
+                    indices[i] = weldRemap[indices[i]];
+            }
+
+            vector<float>::type positions;
+            const bool canOptimizeOverdraw =
+                ( flags & MeshOptimizer::OptimizeOverdraw ) &&
+                readPositionsForOptimizer( vaos[lodIdx], streams, numVertices, positions );
+
+            for( size_t i = 0; i < lods.size(); ++i )
+            {
+                uint32 *lodIndices = &indices[rangeStarts[i]];
+                if( flags & MeshOptimizer::OptimizeVertexCache )
+                    MeshOptimizer::optimizeVertexCache( lodIndices, rangeCounts[i], numVertices );
+                if( canOptimizeOverdraw )
+                {
+                    MeshOptimizer::optimizeOverdraw( lodIndices, rangeCounts[i], &positions[0],
+                                                     numVertices, overdrawThreshold );
+                }
+            }
+
+            vector<uint32>::type vertexRemap( numVertices );
+            size_t newNumVertices = 0u;
+            if( flags & MeshOptimizer::OptimizeVertexFetch )
+            {
+                newNumVertices = MeshOptimizer::optimizeVertexFetch( &indices[0], indices.size(),
+                                                                     numVertices, &vertexRemap[0] );
+            }
+            else
+            {
+                // Keep the order, removing the duplicates if we welded
+                for( size_t i = 0; i < numVertices; ++i )
+                {
+                    const bool isUnique = weldRemap.empty() || weldRemap[i] == i;
+                    vertexRemap[i] =
+                        isUnique ? static_cast<uint32>( newNumVertices++ ) : c_invalidIndex;
+                }
+            }
+
+            for( size_t i = 0; i < indices.size(); ++i )
+                indices[i] = vertexRemap[indices[i]];
+
+            if( lodIdx == 0u && !mBoneAssignments.empty() &&
+                ( flags & ( MeshOptimizer::OptimizeVertexFetch | MeshOptimizer::WeldVertices ) ) )
+            {
+                VertexBoneAssignmentVec boneAssignments;
+                boneAssignments.reserve( mBoneAssignments.size() );
+                VertexBoneAssignmentVec::const_iterator itor = mBoneAssignments.begin();
+                VertexBoneAssignmentVec::const_iterator endt = mBoneAssignments.end();
+                while( itor != endt )
+                {
+                    if( vertexRemap[itor->vertexIndex] != c_invalidIndex )
+                    {
+                        boneAssignments.push_back( *itor );
+                        boneAssignments.back().vertexIndex = vertexRemap[itor->vertexIndex];
+                    }
+                    ++itor;
+                }
+                std::stable_sort( boneAssignments.begin(), boneAssignments.end(),
+                                  []( const VertexBoneAssignment &a, const VertexBoneAssignment &b )
+                                  { return a.vertexIndex < b.vertexIndex; } );
+                mBoneAssignments.swap( boneAssignments );
+            }
+
+            VertexBufferPackedVec newVertexBuffers;
+            for( size_t i = 0; i < vertexBuffers.size(); ++i )
+            {
+                const size_t bytesPerVertex = streams[i].bytesPerVertex;
+                uint8 *data = reinterpret_cast<uint8 *>(
+                    OGRE_MALLOC_SIMD( newNumVertices * bytesPerVertex, MEMCATEGORY_GEOMETRY ) );
+                FreeOnDestructor dataPtrContainer( data );
+
+                for( size_t j = 0; j < numVertices; ++j )
+                {
+                    if( vertexRemap[j] != c_invalidIndex )
+                    {
+                        memcpy( data + vertexRemap[j] * bytesPerVertex,
+                                streams[i].data + j * bytesPerVertex, bytesPerVertex );
+                    }
+                }
+
+                const bool keepAsShadow = vertexBuffers[i]->getShadowCopy() != 0;
+                newVertexBuffers.push_back( vaoManager->createVertexBuffer(
+                    vertexBuffers[i]->getVertexElements(), newNumVertices,
+                    vertexBuffers[i]->getBufferType(), data, keepAsShadow ) );
+
+                if( keepAsShadow )  // Don't free the pointer ourselves
+                    dataPtrContainer.ptr = 0;
+            }
+
+            for( size_t i = 0; i < asyncTickets.size(); ++i )
+                asyncTickets[i]->unmap();
+            asyncTickets.clear();
+
+            for( size_t i = 0; i < lods.size(); ++i )
+            {
+                VertexArrayObject *vao = vaos[lods[i]];
+                IndexBufferPacked *indexBuffer = vao->getIndexBuffer();
+                const size_t numIndices = indexBuffer->getNumElements();
+                const uint32 *srcIndices = &indices[indexOffsets[i]];
+
+                void *indexData =
+                    OGRE_MALLOC_SIMD( indexBuffer->getTotalSizeBytes(), MEMCATEGORY_GEOMETRY );
+                FreeOnDestructor dataPtrContainer( indexData );
+
+                if( indexBuffer->getIndexType() == IndexBufferPacked::IT_16BIT )
+                {
+                    uint16 *dstIndices = reinterpret_cast<uint16 *>( indexData );
+                    for( size_t j = 0; j < numIndices; ++j )
+                        dstIndices[j] = static_cast<uint16>( srcIndices[j] );
+                }
+                else
+                {
+                    memcpy( indexData, srcIndices, numIndices * sizeof( uint32 ) );
+                }
+
+                const bool keepAsShadow = indexBuffer->getShadowCopy() != 0;
+                IndexBufferPacked *newIndexBuffer = vaoManager->createIndexBuffer(
+                    indexBuffer->getIndexType(), numIndices, indexBuffer->getBufferType(), indexData,
+                    keepAsShadow );
+                if( keepAsShadow )  // Don't free the pointer ourselves
+                    dataPtrContainer.ptr = 0;
+
+                VertexArrayObject *newVao = vaoManager->createVertexArrayObject(
+                    newVertexBuffers, newIndexBuffer, vao->getOperationType() );
+                newVao->setPrimitiveRange( vao->getPrimitiveStart(), vao->getPrimitiveCount() );
+
+                newVaos[lods[i]] = newVao;
+                oldVaos.push_back( vao );
+
+                MeshOptimizer::Stats stats = MeshOptimizer::analyze(
+                    &indices[rangeStarts[i]], rangeCounts[i], newNumVertices );
+                if( i != 0u )
+                    stats.numVerticesStored = 0u;
+                report.after.merge( stats );
+            }
+        }
+
+        if( oldVaos.empty() )
+            return report;
+
+        vaos.swap( newVaos );
+        destroyVaos( oldVaos, vaoManager );
+        clearClusters();
+
+        if( independentShadowVaos )
+        {
+            destroyShadowMappingVaos();
+            VertexShadowMapHelper::optimizeForShadowMapping( vaoManager, mVao[VpNormal],
+                                                             mVao[VpShadow] );
+        }
+        else if( !mVao[VpShadow].empty() )
+        {
+            mVao[VpShadow] = mVao[VpNormal];
+        }
+
+        return report;
+    }
+    //---------------------------------------------------------------------
+    void SubMesh::buildClusters( uint32 maxTriangles )
+    {
+        const VertexArrayObjectArray &vaos = mVao[VpNormal];
+
+        clearClusters();
+        mClusters.resize( vaos.size() );
+
+        for( size_t lodIdx = 0; lodIdx < vaos.size(); ++lodIdx )
+        {
+            const VertexArrayObject *vao = vaos[lodIdx];
+            IndexBufferPacked *indexBuffer = vao->getIndexBuffer();
+            const VertexBufferPackedVec &vertexBuffers = vao->getVertexBuffers();
+            if( !indexBuffer || vertexBuffers.empty() || vao->getOperationType() != OT_TRIANGLE_LIST )
+                continue;
+
+            size_t bufferIdx = 0, offset = 0;
+            if( !vao->findBySemantic( VES_POSITION, bufferIdx, offset ) )
+                continue;
+
+            // Only the buffer with the positions needs to be downloaded
+            const size_t numVertices = vertexBuffers[0]->getNumElements();
+            AsyncTicketPtr vertexTicket =
+                vertexBuffers[bufferIdx]->readRequest( 0, vertexBuffers[bufferIdx]->getNumElements() );
+            MeshOptimizer::VertexStreamArray streams;
+            streams.resize( vertexBuffers.size() );
+            streams[bufferIdx].data = reinterpret_cast<const uint8 *>( vertexTicket->map() );
+            streams[bufferIdx].bytesPerVertex = vertexBuffers[bufferIdx]->getBytesPerElement();
+
+            vector<float>::type positions;
+            const bool hasPositions =
+                readPositionsForOptimizer( vao, streams, numVertices, positions );
+            vertexTicket->unmap();
+
+            const size_t numIndices = vao->getPrimitiveCount();
+            if( !hasPositions || numIndices < 3u )
+                continue;
+
+            vector<uint32>::type indices( numIndices );
+            AsyncTicketPtr indexTicket =
+                indexBuffer->readRequest( vao->getPrimitiveStart(), numIndices );
+            const void *indexData = indexTicket->map();
+            if( indexBuffer->getIndexType() == IndexBufferPacked::IT_16BIT )
+            {
+                const uint16 *srcIndices = reinterpret_cast<const uint16 *>( indexData );
+                std::copy( srcIndices, srcIndices + numIndices, indices.begin() );
+            }
+            else
+            {
+                memcpy( &indices[0], indexData, numIndices * sizeof( uint32 ) );
+            }
+            indexTicket->unmap();
+
+            MeshOptimizer::buildClusters( &indices[0], numIndices, &positions[0], numVertices,
+                                          maxTriangles, mClusters[lodIdx] );
+        }
+
+        updateMaxExtraClusterDraws();
+    }
+    //---------------------------------------------------------------------
+    void SubMesh::clearClusters()
+    {
+        mClusters.clear();
+        mMaxExtraClusterDraws = 0u;
+    }
+    //---------------------------------------------------------------------
+    void SubMesh::updateMaxExtraClusterDraws()
+    {
+        mMaxExtraClusterDraws = 0u;
+        for( const MeshClusterArray &clusters : mClusters )
+        {
+            // Every other cluster visible. The first range replaces the regular draw
+            const uint32 numClusters = static_cast<uint32>( clusters.size() );
+            if( numClusters > 1u )
+            {
+                mMaxExtraClusterDraws =
+                    std::max( mMaxExtraClusterDraws, ( numClusters + 1u ) / 2u - 1u );
+            }
+        }
+    }
+    //---------------------------------------------------------------------
+    size_t SubMesh::_addTrianglesToBvh( TriangleBvh &bvh ) const
+    {
+        // Non-resident LODs point to the finest resident one
+        const VertexArrayObjectArray &vaos = mVao[VpNormal];
+        if( vaos.empty() )
+            return 0u;
+
+        const VertexArrayObject *vao = vaos[0];
+        IndexBufferPacked *indexBuffer = vao->getIndexBuffer();
+        const VertexBufferPackedVec &vertexBuffers = vao->getVertexBuffers();
+        if( vertexBuffers.empty() || vao->getOperationType() != OT_TRIANGLE_LIST )
+            return 0u;
+
+        size_t bufferIdx = 0, offset = 0;
+        if( !vao->findBySemantic( VES_POSITION, bufferIdx, offset ) )
+            return 0u;
+
+        // Only the buffer with the positions is needed. Avoid stalling the GPU
+        // by reading from its shadow copy when there is one.
+        VertexBufferPacked *vertexBuffer = vertexBuffers[bufferIdx];
+        const size_t numVertices = vertexBuffers[0]->getNumElements();
+        VertexBufferDownloadHelper downloadHelper;
+        MeshOptimizer::VertexStreamArray streams;
+        streams.resize( vertexBuffers.size() );
+        if( vertexBuffer->getShadowCopy() )
+        {
+            streams[bufferIdx].data = reinterpret_cast<const uint8 *>( vertexBuffer->getShadowCopy() );
+        }
+        else
+        {
+            VertexElementSemanticFullArray semanticsToDownload;
+            semanticsToDownload.push_back( VES_POSITION );
+            downloadHelper.queueDownload( vao, semanticsToDownload );
+            downloadHelper.map( &streams[bufferIdx].data );
+        }
+        streams[bufferIdx].bytesPerVertex = vertexBuffer->getBytesPerElement();
+
+        vector<float>::type positions;
+        const bool hasPositions = readPositionsForOptimizer( vao, streams, numVertices, positions );
+        if( !vertexBuffer->getShadowCopy() )
+            downloadHelper.unmap();
+
+        if( !hasPositions )
+            return 0u;
+
+        const size_t primStart = vao->getPrimitiveStart();
+        const size_t numIndices = vao->getPrimitiveCount();
+        const size_t numTriangles = numIndices / 3u;
+
+        vector<uint32>::type indices( numTriangles * 3u );
+        if( indexBuffer )
+        {
+            AsyncTicketPtr indexTicket;
+            const uint8 *indexData;
+            if( indexBuffer->getShadowCopy() )
+            {
+                indexData = reinterpret_cast<const uint8 *>( indexBuffer->getShadowCopy() ) +
+                            primStart * indexBuffer->getBytesPerElement();
+            }
+            else
+            {
+                indexTicket = indexBuffer->readRequest( primStart, numIndices );
+                indexData = reinterpret_cast<const uint8 *>( indexTicket->map() );
+            }
+
+            if( indexBuffer->getIndexType() == IndexBufferPacked::IT_16BIT )
+            {
+                const uint16 *srcIndices = reinterpret_cast<const uint16 *>( indexData );
+                std::copy( srcIndices, srcIndices + indices.size(), indices.begin() );
+            }
+            else if( !indices.empty() )
+            {
+                memcpy( &indices[0], indexData, indices.size() * sizeof( uint32 ) );
+            }
+
+            if( indexTicket )
+                indexTicket->unmap();
+        }
+        else
+        {
+            for( size_t i = 0; i < indices.size(); ++i )
+                indices[i] = static_cast<uint32>( primStart + i );
+        }
+
+        for( size_t i = 0; i < numTriangles; ++i )
+        {
+            Vector3 v[3];
+            for( size_t j = 0; j < 3u; ++j )
+            {
+                // Out of range indices become degenerate triangles, to keep the numbering
+                const size_t vertexIdx = indices[i * 3u + j];
+                if( vertexIdx < numVertices )
+                {
+                    v[j] = Vector3( positions[vertexIdx * 3u + 0u], positions[vertexIdx * 3u + 1u],
+                                    positions[vertexIdx * 3u + 2u] );
+                }
+                else
+                {
+                    v[j] = Vector3::ZERO;
+                }
+            }
+            bvh.addTriangle( v[0], v[1], v[2] );
+        }
+
+        return numTriangles;
+    }
+    //---------------------------------------------------------------------
     void SubMesh::destroyVaos( VertexArrayObjectArray &vaos, VaoManager *vaoManager,
                                bool destroyIndexBuffer )
     {
@@ -1508,6 +2009,13 @@ namespace Ogre
         {
             VertexArrayObject *vao = *itor;
 
+            if( itor != vaos.begin() && vao == *( itor - 1 ) )
+            {
+                // Non-resident LODs alias the finest resident one (see Mesh::msLodStreaming)
+                ++itor;
+                continue;
+            }
+
             const VertexBufferPackedVec &vertexBuffers = vao->getVertexBuffers();
             VertexBufferPackedVec::const_iterator itBuffers = vertexBuffers.begin();
             VertexBufferPackedVec::const_iterator enBuffers = vertexBuffers.end();
@@ -101,11 +101,22 @@ namespace Ogre
                 filtersVec.push_back( OGRE_NEW TextureFilter::PremultiplyAlpha() );
             }
 
+            bool compressOnLoad = false;
+            if( filters & TextureFilter::TypeCompressOnLoad )
+            {
+                compressOnLoad = CompressOnLoad::getDestinationFormat(
+                                     finalPixelFormat, image, texture->getTextureManager() ) !=
+                                 finalPixelFormat;
+            }
+
             // Add mipmap generation as one of the last steps
             if( filters & TextureFilter::TypeGenerateDefaultMipmaps )
             {
-                const uint8 mipmapGen =
+                uint8 mipmapGen =
                     selectMipmapGen( filters, image, finalPixelFormat, texture->getTextureManager() );
+                // Compressed formats can't generate mipmaps on the GPU. Do it before compressing
+                if( compressOnLoad && mipmapGen == DefaultMipmapGen::HwMode )
+                    mipmapGen = DefaultMipmapGen::SwMode;
                 // If the user wants Mipmaps when loading OnStorage -> OnSystemRam
                 // then he should either explicitly ask only for SW filters, or
                 // load the texture to Resident first, then download to OnSystemRam.
@@ -115,6 +126,10 @@ namespace Ogre
                     filtersVec.push_back( OGRE_NEW TextureFilter::GenerateSwMipmaps() );
             }
 
+            // Compression must see the final pixels, including mipmaps
+            if( compressOnLoad )
+                filtersVec.push_back( OGRE_NEW TextureFilter::CompressOnLoad() );
+
             filtersVec.swap( outFilters );
         }
         //-----------------------------------------------------------------------------------
@@ -142,11 +157,20 @@ namespace Ogre
             if( filters & TextureFilter::TypeLeaveChannelR )
                 inOutPixelFormat = LeaveChannelR::getDestinationFormat( inOutPixelFormat );
 
+            PixelFormatGpu compressedFormat = inOutPixelFormat;
+            if( filters & TextureFilter::TypeCompressOnLoad )
+            {
+                compressedFormat =
+                    CompressOnLoad::getDestinationFormat( inOutPixelFormat, image, textureGpuManager );
+            }
+
             // Add mipmap generation as one of the last steps
             if( filters & TextureFilter::TypeGenerateDefaultMipmaps )
             {
-                const uint8 mipmapGen =
+                uint8 mipmapGen =
                     selectMipmapGen( filters, image, inOutPixelFormat, textureGpuManager );
+                if( compressedFormat != inOutPixelFormat && mipmapGen == DefaultMipmapGen::HwMode )
+                    mipmapGen = DefaultMipmapGen::SwMode;
 
                 const bool canDoMipmaps =
                     ( mipmapGen == DefaultMipmapGen::HwMode &&
@@ -163,6 +187,8 @@ namespace Ogre
                         image.getWidth(), image.getHeight(), image.getDepth() );
                 }
             }
+
+            inOutPixelFormat = compressedFormat;
         }
         //-----------------------------------------------------------------------------------
         uint32 GenerateSwMipmaps::getFilter( const Image2 &image )
@@ -181,7 +207,8 @@ namespace Ogre
             const Image2::Filter filter = static_cast<Image2::Filter>( getFilter( image ) );
 
             const bool isSRgb = PixelFormatGpuUtils::isSRgb( texture->getPixelFormat() );
-            image.generateMipmaps( isSRgb, filter );
+            image.generateMipmaps( isSRgb, filter,
+                                   texture->getTextureManager()->getNumSwMipmapThreads() );
             if( texture->getNumMipmaps() != image.getNumMipmaps() )
                 texture->setNumMipmaps( image.getNumMipmaps() );
         }
@@ -493,5 +520,124 @@ namespace Ogre
                 }
             }
         }
+        //-----------------------------------------------------------------------------------
+        PixelFormatGpu CompressOnLoad::getDestinationFormat( PixelFormatGpu srcFormat,
+                                                             const Image2 &image,
+                                                             const TextureGpuManager *textureManager )
+        {
+            // Compressed textures must be a multiple of the block size
+            if( ( image.getWidth() & 0x03u ) || ( image.getHeight() & 0x03u ) )
+                return srcFormat;
+
+            return getDestinationFormat( srcFormat, image.getTextureType(), textureManager );
+        }
+        //-----------------------------------------------------------------------------------
+        PixelFormatGpu CompressOnLoad::getDestinationFormat( PixelFormatGpu srcFormat,
+                                                             TextureTypes::TextureTypes textureType,
+                                                             const TextureGpuManager *textureManager )
+        {
+            PixelFormatGpu bcFormat = PFG_UNKNOWN;
+            PixelFormatGpu etcFormat = PFG_UNKNOWN;
+
+            switch( PixelFormatGpuUtils::getEquivalentLinear( srcFormat ) )
+            {
+            case PFG_R8_UNORM:
+                bcFormat = PFG_BC4_UNORM;
+                etcFormat = PFG_EAC_R11_UNORM;
+                break;
+            case PFG_R8_SNORM:
+                bcFormat = PFG_BC4_SNORM;
+                etcFormat = PFG_EAC_R11_SNORM;
+                break;
+            case PFG_RG8_UNORM:
+                bcFormat = PFG_BC5_UNORM;
+                etcFormat = PFG_EAC_R11G11_UNORM;
+                break;
+            case PFG_RG8_SNORM:
+                bcFormat = PFG_BC5_SNORM;
+                etcFormat = PFG_EAC_R11G11_SNORM;
+                break;
+            case PFG_RGB8_UNORM:
+            case PFG_BGRX8_UNORM:
+                bcFormat = PFG_BC1_UNORM;
+                etcFormat = PFG_ETC2_RGB8_UNORM;
+                break;
+            case PFG_RGBA8_UNORM:
+            case PFG_BGRA8_UNORM:
+                bcFormat = PFG_BC7_UNORM;
+                if( !textureManager->checkSupport( bcFormat, textureType, 0u ) )
+                    bcFormat = PFG_BC3_UNORM;
+                etcFormat = PFG_ETC2_RGBA8_UNORM;
+                break;
+            default:
+                // Not supported
+                return srcFormat;
+            }
+
+            if( PixelFormatGpuUtils::isSRgb( srcFormat ) )
+            {
+                bcFormat = PixelFormatGpuUtils::getEquivalentSRGB( bcFormat );
+                etcFormat = PixelFormatGpuUtils::getEquivalentSRGB( etcFormat );
+            }
+
+            if( textureManager->checkSupport( bcFormat, textureType, 0u ) )
+                return bcFormat;
+            if( textureManager->checkSupport( etcFormat, textureType, 0u ) )
+                return etcFormat;
+
+            return srcFormat;
+        }
+        //-----------------------------------------------------------------------------------
+        void CompressOnLoad::_executeStreaming( Image2 &image, TextureGpu *texture )
+        {
+            OgreProfileExhaustive( "CompressOnLoad::_executeStreaming" );
+
+            // If the texture is sRGB, compress the pixels as they are (i.e. no conversion
+            // to linear) into the sRGB variant.
+            PixelFormatGpu srcFormat = image.getPixelFormat();
+            if( PixelFormatGpuUtils::isSRgb( texture->getPixelFormat() ) )
+                srcFormat = PixelFormatGpuUtils::getEquivalentSRGB( srcFormat );
+
+            const PixelFormatGpu dstFormat =
+                getDestinationFormat( srcFormat, image, texture->getTextureManager() );
+
+            if( dstFormat == srcFormat )
+                return;
+
+            const uint8 numMipmaps = image.getNumMipmaps();
+
+            const uint32 rowAlignment = 4u;
+            const size_t dstSizeBytes =
+                PixelFormatGpuUtils::calculateSizeBytes( image.getWidth(),      //
+                                                         image.getHeight(),     //
+                                                         image.getDepth(),      //
+                                                         image.getNumSlices(),  //
+                                                         dstFormat,             //
+                                                         numMipmaps,            //
+                                                         rowAlignment );
+
+            void *data = OGRE_MALLOC_SIMD( dstSizeBytes, MEMCATEGORY_RESOURCE );
+
+            {
+                // Only used to get the boxes of each mip. Does not own data
+                Image2 dstImage;
+                dstImage.loadDynamicImage( data, image.getWidth(), image.getHeight(),
+                                           image.getDepthOrSlices(), image.getTextureType(), dstFormat,
+                                           false, numMipmaps );
+
+                for( uint8 mip = 0; mip < numMipmaps; ++mip )
+                {
+                    TextureBox srcBox = image.getData( mip );
+                    TextureBox dstBox = dstImage.getData( mip );
+                    PixelFormatGpuUtils::bulkPixelConversion( srcBox, srcFormat, dstBox, dstFormat );
+                }
+            }
+
+            assert( image.getAutoDelete() && "This should be impossible. Memory will leak." );
+            image.loadDynamicImage( data, image.getWidth(), image.getHeight(), image.getDepthOrSlices(),
+                                    image.getTextureType(), dstFormat, true, numMipmaps );
+            if( texture->getPixelFormat() != dstFormat )
+                texture->setPixelFormat( dstFormat );
+        }
     }  // namespace TextureFilter
 }  // namespace Ogre
@@ -109,6 +109,7 @@ namespace Ogre
         mAddedNewLoadRequests( false ),
         mMultiLoadsSemaphore( 0u ),
         mPendingMultiLoads( 0u ),
+        mNumSwMipmapThreads( 1u ),
         mEntriesToProcessPerIteration( 3u ),
         mMaxPreloadBytes( 256u * 1024u * 1024u ),  // A value of 512MB begins to shake driver bugs.
         mTextureGpuManagerListener( &sDefaultTextureGpuManagerListener ),
@@ -1434,6 +1435,68 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     const TextureGpuManager::BudgetEntryVec &TextureGpuManager::getBudget() const { return mBudget; }
     //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setNumSwMipmapThreads( uint32 numThreads )
+    {
+        mNumSwMipmapThreads.store( std::max( numThreads, 1u ), std::memory_order_relaxed );
+    }
+    //-----------------------------------------------------------------------------------
+    void TextureGpuManager::setCompressOnLoadCacheFolder( const String &folder )
+    {
+        mCompressOnLoadCacheFolder = folder;
+    }
+    //-----------------------------------------------------------------------------------
+    String TextureGpuManager::getCompressOnLoadCachePath( const LoadRequest &loadRequest ) const
+    {
+        if( mCompressOnLoadCacheFolder.empty() || !loadRequest.archive ||
+            !( loadRequest.filters & TextureFilter::TypeCompressOnLoad ) ||
+            loadRequest.sliceOrDepth != std::numeric_limits<uint32>::max() )
+        {
+            return BLANKSTRING;
+        }
+
+        // Flatten the path into a valid file name
+        String fileName = loadRequest.name;
+        for( size_t i = 0u; i < fileName.size(); ++i )
+        {
+            if( fileName[i] == '/' || fileName[i] == '\\' || fileName[i] == ':' )
+                fileName[i] = '_';
+        }
+
+        const time_t modifiedTime = loadRequest.archive->getModifiedTime( loadRequest.name );
+
+        // The compressed format (BCn vs ETC/EAC, BC7 vs BC3) depends on what the RenderSystem
+        // supports. We don't know the source format until the file is decoded, so hash the
+        // format every possible source would be compressed to.
+        const PixelFormatGpu srcFormats[] = { PFG_R8_UNORM,   PFG_R8_SNORM,    PFG_RG8_UNORM,
+                                              PFG_RG8_SNORM,  PFG_RGB8_UNORM,  PFG_RGBA8_UNORM,
+                                              PFG_RGBA8_UNORM_SRGB };
+        const TextureTypes::TextureTypes textureType = loadRequest.texture->getTextureType();
+        uint32 dstFormatsHash = 0u;
+        for( size_t i = 0u; i < sizeof( srcFormats ) / sizeof( srcFormats[0] ); ++i )
+        {
+            const PixelFormatGpu dstFormat = TextureFilter::CompressOnLoad::getDestinationFormat(
+                srcFormats[i], textureType, this );
+            dstFormatsHash = HashCombine( dstFormatsHash, dstFormat );
+        }
+
+        return mCompressOnLoadCacheFolder + "/" + fileName + "_" +
+               StringConverter::toString( static_cast<uint64>( modifiedTime ) ) + "_" +
+               StringConverter::toString( loadRequest.filters ) + "_" +
+               StringConverter::toString( dstFormatsHash ) + ".oitd";
+    }
+    //-----------------------------------------------------------------------------------
+    DataStreamPtr TextureGpuManager::openCompressOnLoadCache( const String &cachePath )
+    {
+        DataStreamPtr retVal;
+        std::ifstream *ifs = OGRE_NEW_T( std::ifstream, MEMCATEGORY_GENERAL );
+        ifs->open( cachePath.c_str(), std::ios::in | std::ios::binary );
+        if( !*ifs )
+            OGRE_DELETE_T( ifs, basic_ifstream, MEMCATEGORY_GENERAL );
+        else
+            retVal.reset( OGRE_NEW FileStreamDataStream( cachePath, ifs ) );
+        return retVal;
+    }
+    //-----------------------------------------------------------------------------------
     void TextureGpuManager::setTrylockMutexFailureLimit( uint32 tryLockFailureLimit )
     {
         mTryLockMutexFailureLimit = tryLockFailureLimit;
@@ -2721,17 +2784,27 @@ namespace Ogre
                 }
 
                 DataStreamPtr data;
+                String imageName = loadRequest.name;
                 if( !loadRequest.archive )
                     data = loadRequest.loadingListener->grouplessResourceLoading( loadRequest.name );
                 else
                 {
                     try
                     {
-                        data = loadRequest.archive->open( loadRequest.name );
-                        if( loadRequest.loadingListener )
+                        const String cachePath = getCompressOnLoadCachePath( loadRequest );
+                        if( !cachePath.empty() )
+                            data = openCompressOnLoadCache( cachePath );
+
+                        if( data )
+                            imageName = cachePath;
+                        else
                         {
-                            loadRequest.loadingListener->grouplessResourceOpened(
-                                loadRequest.name, loadRequest.archive, data );
+                            data = loadRequest.archive->open( loadRequest.name );
+                            if( loadRequest.loadingListener )
+                            {
+                                loadRequest.loadingListener->grouplessResourceOpened(
+                                    loadRequest.name, loadRequest.archive, data );
+                            }
                         }
                     }
                     catch( Exception & )
@@ -2750,7 +2823,7 @@ namespace Ogre
 
                     try
                     {
-                        img->load2( data, loadRequest.name );
+                        img->load2( data, imageName );
                     }
                     catch( Exception & )
                     {
@@ -2840,18 +2913,29 @@ namespace Ogre
                 LML_CRITICAL );
         }
 
+        const String compressCachePath = getCompressOnLoadCachePath( loadRequest );
+
         DataStreamPtr data;
+        String imageName = loadRequest.name;
         if( !loadRequest.archive && !loadRequest.image )
             data = loadRequest.loadingListener->grouplessResourceLoading( loadRequest.name );
         else if( !loadRequest.image )
         {
             try
             {
-                data = loadRequest.archive->open( loadRequest.name );
-                if( loadRequest.loadingListener )
+                if( !compressCachePath.empty() )
+                    data = openCompressOnLoadCache( compressCachePath );
+
+                if( data )
+                    imageName = compressCachePath;
+                else
                 {
-                    loadRequest.loadingListener->grouplessResourceOpened( loadRequest.name,
-                                                                          loadRequest.archive, data );
+                    data = loadRequest.archive->open( loadRequest.name );
+                    if( loadRequest.loadingListener )
+                    {
+                        loadRequest.loadingListener->grouplessResourceOpened(
+                            loadRequest.name, loadRequest.archive, data );
+                    }
                 }
             }
             catch( Exception &e )
@@ -2883,7 +2967,7 @@ namespace Ogre
                 try
                 {
                     if( data )
-                        img->load2( data, loadRequest.name );
+                        img->load2( data, imageName );
                 }
                 catch( Exception &e )
                 {
@@ -2983,6 +3067,8 @@ namespace Ogre
                     loadRequest.texture->setNumMipmaps( img->getNumMipmaps() );
                 }
 
+                const bool wasCompressed = PixelFormatGpuUtils::isCompressed( img->getPixelFormat() );
+
                 FilterBaseArray::const_iterator itFilters = filters.begin();
                 FilterBaseArray::const_iterator enFilters = filters.end();
                 while( itFilters != enFilters )
@@ -2991,6 +3077,23 @@ namespace Ogre
                     ++itFilters;
                 }
 
+                if( !compressCachePath.empty() && !wasCompressed &&
+                    PixelFormatGpuUtils::isCompressed( img->getPixelFormat() ) )
+                {
+                    // TextureFilter::CompressOnLoad did its job. Save it so it doesn't
+                    // have to be done again next time
+                    try
+                    {
+                        img->save( compressCachePath, 0u, img->getNumMipmaps() );
+                    }
+                    catch( Exception &e )
+                    {
+                        LogManager::getSingleton().logMessage(
+                            "WARNING: Could not save compressed texture cache " + compressCachePath +
+                            ". Error: " + e.getFullDescription() );
+                    }
+                }
+
                 const bool needsMultipleImages =
                     img->getTextureType() != loadRequest.texture->getTextureType() &&
                     loadRequest.texture->getTextureType() != TextureTypes::Type1D;
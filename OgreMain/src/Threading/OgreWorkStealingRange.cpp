@@ -0,0 +1,118 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Threading/OgreWorkStealingRange.h"
+
+#include "OgreCommon.h"
+
+namespace Ogre
+{
+    WorkStealingRange::WorkStealingRange() :
+        mSlices( 0 ),
+        mNumSlices( 0u ),
+        mCapacity( 0u ),
+        mChunkSize( 1u ),
+        mStealingEnabled( true )
+    {
+    }
+    //-------------------------------------------------------------------------
+    WorkStealingRange::~WorkStealingRange()
+    {
+        delete[] mSlices;
+        mSlices = 0;
+    }
+    //-------------------------------------------------------------------------
+    void WorkStealingRange::reset( size_t numItems, size_t numThreads, size_t granularity,
+                                   size_t chunksPerThread )
+    {
+        OGRE_ASSERT_LOW( numThreads > 0u && granularity > 0u && chunksPerThread > 0u );
+
+        if( numThreads > mCapacity )
+        {
+            delete[] mSlices;
+            mSlices = new Slice[numThreads];
+            mCapacity = numThreads;
+        }
+        mNumSlices = numThreads;
+
+        // Items per thread must be multiple of granularity
+        size_t itemsPerThread = ( numItems + numThreads - 1u ) / numThreads;
+        itemsPerThread = alignToNextMultiple( itemsPerThread, granularity );
+
+        mChunkSize = ( itemsPerThread + chunksPerThread - 1u ) / chunksPerThread;
+        mChunkSize = std::max( alignToNextMultiple( mChunkSize, granularity ), granularity );
+
+        for( size_t i = 0u; i < numThreads; ++i )
+        {
+            const size_t start = std::min( i * itemsPerThread, numItems );
+            mSlices[i].next.store( start, std::memory_order_relaxed );
+            mSlices[i].end = std::min( start + itemsPerThread, numItems );
+        }
+    }
+    //-------------------------------------------------------------------------
+    inline bool WorkStealingRange::acquireFrom( Slice &slice, size_t &outStart, size_t &outCount )
+    {
+        // Plain load first to avoid hammering the cache line of exhausted slices with RMWs
+        if( slice.next.load( std::memory_order_relaxed ) >= slice.end )
+            return false;
+
+        const size_t start = slice.next.fetch_add( mChunkSize, std::memory_order_relaxed );
+        if( start >= slice.end )
+            return false;
+
+        outStart = start;
+        outCount = std::min( mChunkSize, slice.end - start );
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    bool WorkStealingRange::acquire( size_t threadIdx, size_t &outStart, size_t &outCount )
+    {
+        OGRE_ASSERT_MEDIUM( threadIdx < mNumSlices );
+
+        if( acquireFrom( mSlices[threadIdx], outStart, outCount ) )
+            return true;
+
+        if( mStealingEnabled )
+        {
+            // Our slice is done. Steal from the others, starting from our neighbour
+            // so that not every thread goes after the same victim.
+            for( size_t i = 1u; i < mNumSlices; ++i )
+            {
+                size_t victimIdx = threadIdx + i;
+                if( victimIdx >= mNumSlices )
+                    victimIdx -= mNumSlices;
+                if( acquireFrom( mSlices[victimIdx], outStart, outCount ) )
+                    return true;
+            }
+        }
+
+        return false;
+    }
+}  // namespace Ogre
@@ -73,4 +73,12 @@ namespace Ogre
     //-----------------------------------------------------------------------------------
     void BufferInterface::_ensureDelayedImmutableBuffersAreReady() {}
     //-----------------------------------------------------------------------------------
+    void BufferInterface::_setInternalBufferStart( size_t internalBufferStart )
+    {
+        // Keep the dynamic frame offset
+        mBuffer->mFinalBufferStart =
+            internalBufferStart + ( mBuffer->mFinalBufferStart - mBuffer->mInternalBufferStart );
+        mBuffer->mInternalBufferStart = internalBufferStart;
+    }
+    //-----------------------------------------------------------------------------------
 }  // namespace Ogre
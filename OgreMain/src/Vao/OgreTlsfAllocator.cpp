@@ -0,0 +1,394 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "OgreStableHeaders.h"
+
+#include "Vao/OgreTlsfAllocator.h"
+
+#include "OgreBitwise.h"
+#include "OgreCommon.h"
+
+namespace Ogre
+{
+    TlsfAllocator::TlsfAllocator() :
+        mFirstNode( c_invalidNode ),
+        mNumFl( 0u ),
+        mFlBitmap( 0u ),
+        mCapacity( 0u ),
+        mFreeBytes( 0u ),
+        mNumFreeBlocks( 0u )
+    {
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::mapping( uint64 size, uint32 &outFl, uint32 &outSl )
+    {
+        if( size < c_slCount )
+        {
+            // Small sizes get a linear list each
+            outFl = 0u;
+            outSl = static_cast<uint32>( size );
+        }
+        else
+        {
+            const uint32 msb = 63u - Bitwise::clz64( size );
+            outSl = static_cast<uint32>( size >> ( msb - c_slCountLog2 ) ) ^ c_slCount;
+            outFl = msb - c_slCountLog2 + 1u;
+        }
+    }
+    //-------------------------------------------------------------------------
+    uint32 TlsfAllocator::findFreeListHead( uint64 size ) const
+    {
+        // Round up to the next list so that any node in it is big enough
+        if( size >= c_slCount )
+        {
+            const uint32 msb = 63u - Bitwise::clz64( size );
+            size += ( uint64( 1u ) << ( msb - c_slCountLog2 ) ) - 1u;
+        }
+
+        uint32 fl, sl;
+        mapping( size, fl, sl );
+        if( fl >= mNumFl )
+            return c_invalidNode;
+
+        uint32 slBitmap = mSlBitmaps[fl] & ( ~0u << sl );
+        if( !slBitmap )
+        {
+            const uint64 flBitmap = mFlBitmap & ( ~uint64( 0u ) << ( fl + 1u ) );
+            if( !flBitmap )
+                return c_invalidNode;
+            fl = Bitwise::ctz64( flBitmap );
+            slBitmap = mSlBitmaps[fl];
+        }
+        sl = Bitwise::ctz32( slBitmap );
+
+        return mFreeHeads[fl * c_slCount + sl];
+    }
+    //-------------------------------------------------------------------------
+    bool TlsfAllocator::fits( uint32 nodeIdx, size_t size, size_t alignment ) const
+    {
+        const Node &node = mNodes[nodeIdx];
+        const size_t padding = alignToNextMultiple( node.offset, alignment ) - node.offset;
+        return padding + size <= node.size;
+    }
+    //-------------------------------------------------------------------------
+    uint32 TlsfAllocator::findFreeNode( size_t size, size_t alignment ) const
+    {
+        uint32 nodeIdx = findFreeListHead( size );
+        if( nodeIdx != c_invalidNode && fits( nodeIdx, size, alignment ) )
+            return nodeIdx;
+
+        if( alignment > 1u )
+        {
+            // Any node of this size fits, whatever the padding needed
+            nodeIdx = findFreeListHead( uint64( size ) + alignment - 1u );
+            if( nodeIdx != c_invalidNode )
+                return nodeIdx;
+        }
+
+        // Last resort: rounding up skipped the list 'size' belongs to,
+        // which may still contain big enough nodes
+        uint32 fl, sl;
+        mapping( size, fl, sl );
+        if( fl >= mNumFl )
+            return c_invalidNode;
+
+        nodeIdx = mFreeHeads[fl * c_slCount + sl];
+        while( nodeIdx != c_invalidNode && !fits( nodeIdx, size, alignment ) )
+            nodeIdx = mNodes[nodeIdx].nextFree;
+
+        return nodeIdx;
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::insertFreeNode( uint32 nodeIdx )
+    {
+        Node &node = mNodes[nodeIdx];
+        uint32 fl, sl;
+        mapping( node.size, fl, sl );
+
+        const uint32 listIdx = fl * c_slCount + sl;
+        node.prevFree = c_invalidNode;
+        node.nextFree = mFreeHeads[listIdx];
+        if( node.nextFree != c_invalidNode )
+            mNodes[node.nextFree].prevFree = nodeIdx;
+        mFreeHeads[listIdx] = nodeIdx;
+
+        mSlBitmaps[fl] |= 1u << sl;
+        mFlBitmap |= uint64( 1u ) << fl;
+        ++mNumFreeBlocks;
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::removeFreeNode( uint32 nodeIdx )
+    {
+        const Node &node = mNodes[nodeIdx];
+
+        if( node.prevFree != c_invalidNode )
+            mNodes[node.prevFree].nextFree = node.nextFree;
+        if( node.nextFree != c_invalidNode )
+            mNodes[node.nextFree].prevFree = node.prevFree;
+
+        if( node.prevFree == c_invalidNode )
+        {
+            // It was the head of its list
+            uint32 fl, sl;
+            mapping( node.size, fl, sl );
+            const uint32 listIdx = fl * c_slCount + sl;
+            mFreeHeads[listIdx] = node.nextFree;
+            if( node.nextFree == c_invalidNode )
+            {
+                mSlBitmaps[fl] &= ~( 1u << sl );
+                if( !mSlBitmaps[fl] )
+                    mFlBitmap &= ~( uint64( 1u ) << fl );
+            }
+        }
+
+        --mNumFreeBlocks;
+    }
+    //-------------------------------------------------------------------------
+    uint32 TlsfAllocator::createNode( size_t offset, size_t size )
+    {
+        uint32 nodeIdx;
+        if( !mUnusedNodes.empty() )
+        {
+            nodeIdx = mUnusedNodes.back();
+            mUnusedNodes.pop_back();
+        }
+        else
+        {
+            nodeIdx = static_cast<uint32>( mNodes.size() );
+            mNodes.push_back( Node() );
+        }
+
+        Node &node = mNodes[nodeIdx];
+        node.offset = offset;
+        node.size = size;
+        node.prevPhys = c_invalidNode;
+        node.nextPhys = c_invalidNode;
+        node.prevFree = c_invalidNode;
+        node.nextFree = c_invalidNode;
+        node.used = false;
+
+        return nodeIdx;
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::releaseNode( uint32 nodeIdx ) { mUnusedNodes.push_back( nodeIdx ); }
+    //-------------------------------------------------------------------------
+    uint32 TlsfAllocator::splitNode( uint32 nodeIdx, size_t size )
+    {
+        const uint32 newIdx =
+            createNode( mNodes[nodeIdx].offset + size, mNodes[nodeIdx].size - size );
+
+        Node &node = mNodes[nodeIdx];
+        Node &newNode = mNodes[newIdx];
+        newNode.prevPhys = nodeIdx;
+        newNode.nextPhys = node.nextPhys;
+        if( node.nextPhys != c_invalidNode )
+            mNodes[node.nextPhys].prevPhys = newIdx;
+        node.nextPhys = newIdx;
+        node.size = size;
+
+        return newIdx;
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::mergeWithNext( uint32 nodeIdx )
+    {
+        Node &node = mNodes[nodeIdx];
+        const uint32 nextIdx = node.nextPhys;
+        const Node &next = mNodes[nextIdx];
+
+        node.size += next.size;
+        node.nextPhys = next.nextPhys;
+        if( next.nextPhys != c_invalidNode )
+            mNodes[next.nextPhys].prevPhys = nodeIdx;
+
+        releaseNode( nextIdx );
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::initialize( size_t capacity )
+    {
+        mNodes.clear();
+        mUnusedNodes.clear();
+        mUsedNodes.clear();
+
+        {
+            uint32 fl, sl;
+            mapping( capacity, fl, sl );
+            mNumFl = fl + 1u;
+        }
+        mFlBitmap = 0u;
+        mSlBitmaps.resizePOD( mNumFl, 0u );
+        mFreeHeads.resizePOD( mNumFl * c_slCount, c_invalidNode );
+        std::fill( mSlBitmaps.begin(), mSlBitmaps.end(), 0u );
+        std::fill( mFreeHeads.begin(), mFreeHeads.end(), c_invalidNode );
+
+        mCapacity = capacity;
+        mFreeBytes = capacity;
+        mNumFreeBlocks = 0u;
+
+        mFirstNode = c_invalidNode;
+        if( capacity > 0u )
+        {
+            mFirstNode = createNode( 0u, capacity );
+            insertFreeNode( mFirstNode );
+        }
+    }
+    //-------------------------------------------------------------------------
+    size_t TlsfAllocator::allocateFrom( uint32 nodeIdx, size_t sizeBytes, size_t alignment )
+    {
+        removeFreeNode( nodeIdx );
+
+        const size_t offset = mNodes[nodeIdx].offset;
+        const size_t alignedOffset = alignToNextMultiple( offset, alignment );
+        if( alignedOffset != offset )
+        {
+            // The padding stays free, so it's recovered when the neighbours are freed
+            const uint32 paddingIdx = nodeIdx;
+            nodeIdx = splitNode( paddingIdx, alignedOffset - offset );
+            insertFreeNode( paddingIdx );
+        }
+
+        if( mNodes[nodeIdx].size > sizeBytes )
+            insertFreeNode( splitNode( nodeIdx, sizeBytes ) );
+
+        Node &node = mNodes[nodeIdx];
+        node.used = true;
+
+        mFreeBytes -= sizeBytes;
+        mUsedNodes[alignedOffset] = nodeIdx;
+
+        return alignedOffset;
+    }
+    //-------------------------------------------------------------------------
+    bool TlsfAllocator::allocate( size_t sizeBytes, size_t alignment, size_t &outOffset )
+    {
+        OGRE_ASSERT_LOW( alignment > 0u );
+
+        // Zero-sized ranges still need a unique offset
+        sizeBytes = std::max<size_t>( sizeBytes, 1u );
+        if( sizeBytes > mFreeBytes )
+            return false;
+
+        const uint32 nodeIdx = findFreeNode( sizeBytes, alignment );
+        if( nodeIdx == c_invalidNode )
+            return false;
+
+        outOffset = allocateFrom( nodeIdx, sizeBytes, alignment );
+        return true;
+    }
+    //-------------------------------------------------------------------------
+    bool TlsfAllocator::allocateBelow( size_t sizeBytes, size_t alignment, size_t maxOffset,
+                                       size_t &outOffset )
+    {
+        OGRE_ASSERT_LOW( alignment > 0u );
+
+        sizeBytes = std::max<size_t>( sizeBytes, 1u );
+
+        uint32 nodeIdx = mFirstNode;
+        while( nodeIdx != c_invalidNode && mNodes[nodeIdx].offset < maxOffset )
+        {
+            const Node &node = mNodes[nodeIdx];
+            if( !node.used && fits( nodeIdx, sizeBytes, alignment ) &&
+                alignToNextMultiple( node.offset, alignment ) < maxOffset )
+            {
+                outOffset = allocateFrom( nodeIdx, sizeBytes, alignment );
+                return true;
+            }
+            nodeIdx = node.nextPhys;
+        }
+
+        return false;
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::deallocate( size_t offset )
+    {
+        UsedNodeMap::iterator itor = mUsedNodes.find( offset );
+        OGRE_ASSERT_LOW( itor != mUsedNodes.end() && "Range was never allocated or already freed" );
+
+        uint32 nodeIdx = itor->second;
+        mUsedNodes.erase( itor );
+
+        mNodes[nodeIdx].used = false;
+        mFreeBytes += mNodes[nodeIdx].size;
+
+        const uint32 prevIdx = mNodes[nodeIdx].prevPhys;
+        if( prevIdx != c_invalidNode && !mNodes[prevIdx].used )
+        {
+            removeFreeNode( prevIdx );
+            mergeWithNext( prevIdx );
+            nodeIdx = prevIdx;
+        }
+
+        const uint32 nextIdx = mNodes[nodeIdx].nextPhys;
+        if( nextIdx != c_invalidNode && !mNodes[nextIdx].used )
+        {
+            removeFreeNode( nextIdx );
+            mergeWithNext( nodeIdx );
+        }
+
+        insertFreeNode( nodeIdx );
+    }
+    //-------------------------------------------------------------------------
+    size_t TlsfAllocator::getLargestFreeBlock() const
+    {
+        if( !mFlBitmap )
+            return 0u;
+
+        // The last non-empty list holds the biggest nodes, but they're not sorted
+        const uint32 fl = 63u - Bitwise::clz64( mFlBitmap );
+        const uint32 sl = 31u - Bitwise::clz32( mSlBitmaps[fl] );
+
+        size_t largest = 0u;
+        uint32 nodeIdx = mFreeHeads[fl * c_slCount + sl];
+        while( nodeIdx != c_invalidNode )
+        {
+            largest = std::max( largest, mNodes[nodeIdx].size );
+            nodeIdx = mNodes[nodeIdx].nextFree;
+        }
+
+        return largest;
+    }
+    //-------------------------------------------------------------------------
+    float TlsfAllocator::getFragmentation() const
+    {
+        if( !mFreeBytes )
+            return 0.0f;
+        return 1.0f - float( getLargestFreeBlock() ) / float( mFreeBytes );
+    }
+    //-------------------------------------------------------------------------
+    void TlsfAllocator::getBlocks( BlockVec &outBlocks ) const
+    {
+        outBlocks.clear();
+        uint32 nodeIdx = mFirstNode;
+        while( nodeIdx != c_invalidNode )
+        {
+            const Node &node = mNodes[nodeIdx];
+            const Block block = { node.offset, node.size, node.used };
+            outBlocks.push_back( block );
+            nodeIdx = node.nextPhys;
+        }
+    }
+}  // namespace Ogre
@@ -66,7 +66,8 @@ namespace Ogre
             64 * 1024 *
             1024 ),  // Minimum guaranteed by GL. Intel HD Graphics 3000-5000/Iris provide 64M only
         mReadOnlyBufferMaxSize( 64 * 1024 * 1024 ),
-        mUavBufferMaxSize( 16 * 1024 * 1024 )  // Minimum guaranteed by GL.
+        mUavBufferMaxSize( 16 * 1024 * 1024 ),  // Minimum guaranteed by GL.
+        mDefragmentationBudget( 0 )
     {
         mTimer = OGRE_NEW Timer();
 
@@ -675,8 +676,45 @@ namespace Ogre
         }
     }
     //-----------------------------------------------------------------------------------
+    void VaoManager::setDefragmentationBudget( size_t bytesPerFrame )
+    {
+        mDefragmentationBudget = bytesPerFrame;
+    }
+    //-----------------------------------------------------------------------------------
+    void VaoManager::getRelocatableBuffers( BufferPackedVec &outBuffers ) const
+    {
+        outBuffers.clear();
+
+        const BufferPackedTypes bufferTypes[2] = { BP_TYPE_VERTEX, BP_TYPE_INDEX };
+
+        for( size_t i = 0; i < 2u; ++i )
+        {
+            BufferPackedSet::const_iterator itor = mBuffers[bufferTypes[i]].begin();
+            BufferPackedSet::const_iterator endt = mBuffers[bufferTypes[i]].end();
+
+            while( itor != endt )
+            {
+                BufferPacked *buffer = *itor;
+                bool relocatable = buffer->getBufferType() <= BT_DEFAULT && !buffer->isCurrentlyMapped();
+#ifdef _OGRE_MULTISOURCE_VBO
+                if( bufferTypes[i] == BP_TYPE_VERTEX )
+                {
+                    relocatable &=
+                        static_cast<VertexBufferPacked *>( buffer )->getMultiSourcePool() == 0;
+                }
+#endif
+                if( relocatable )
+                    outBuffers.push_back( buffer );
+                ++itor;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void VaoManager::_update()
     {
+        if( mDefragmentationBudget )
+            defragment( mDefragmentationBudget );
+
         Root::getSingleton()._renderingFrameEnded();
         ++mFrameCount;
     }
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include "OgreGL3PlusPrerequisites.h"
 
 #include "OgrePixelFormatGpu.h"
+#include "Vao/OgreTlsfAllocator.h"
 #include "Vao/OgreVaoManager.h"
 
 namespace Ogre
@@ -56,34 +57,7 @@ namespace Ogre
 
             Block( size_t _offset, size_t _size ) : offset( _offset ), size( _size ) {}
         };
-        struct StrideChanger
-        {
-            size_t offsetAfterPadding;
-            size_t paddedBytes;
-
-            StrideChanger() : offsetAfterPadding( 0 ), paddedBytes( 0 ) {}
-            StrideChanger( size_t _offsetAfterPadding, size_t _paddedBytes ) :
-                offsetAfterPadding( _offsetAfterPadding ),
-                paddedBytes( _paddedBytes )
-            {
-            }
-
-            bool operator()( const StrideChanger &left, size_t right ) const
-            {
-                return left.offsetAfterPadding < right;
-            }
-            bool operator()( size_t left, const StrideChanger &right ) const
-            {
-                return left < right.offsetAfterPadding;
-            }
-            bool operator()( const StrideChanger &left, const StrideChanger &right ) const
-            {
-                return left.offsetAfterPadding < right.offsetAfterPadding;
-            }
-        };
-
-        typedef vector<Block>::type         BlockVec;
-        typedef vector<StrideChanger>::type StrideChangerVec;
+        typedef vector<Block>::type BlockVec;
 
     protected:
         struct Vbo
@@ -92,8 +66,8 @@ namespace Ogre
             size_t                sizeBytes;
             GL3PlusDynamicBuffer *dynamicBuffer;  // Null for CPU_INACCESSIBLE BOs.
 
-            BlockVec         freeBlocks;
-            StrideChangerVec strideChangers;
+            /// Finds free ranges in O(1). Alignment padding is kept as free blocks
+            TlsfAllocator allocator;
         };
 
         struct Vao
@@ -189,9 +163,12 @@ namespace Ogre
         void deallocateVbo( size_t vboIdx, size_t bufferOffset, size_t sizeBytes,
                             BufferType bufferType );
 
+#ifdef _OGRE_MULTISOURCE_VBO
     public:
+        /// Only GL3PlusMultiSourceVertexBufferPool still tracks free blocks by hand.
         /// @see StagingBuffer::mergeContiguousBlocks
         static void mergeContiguousBlocks( BlockVec::iterator blockToMerge, BlockVec &blocks );
+#endif
 
     protected:
         VertexBufferPacked *createVertexBufferImpl( size_t numElements, uint32 bytesPerElement,
@@ -262,6 +239,12 @@ namespace Ogre
         void getMemoryStats( MemoryStatsEntryVec &outStats, size_t &outCapacityBytes,
                              size_t &outFreeBytes, Log *log, bool &outIncludesTextures ) const override;
 
+        void getFragmentationStats( PoolFragmentationEntryVec &outStats ) const override;
+
+        /// Relocates with glCopyBufferSubData within the same pool, so the GL
+        /// buffer names (and thus the VAOs) don't change
+        size_t defragment( size_t maxBytesToMove ) override;
+
         void cleanupEmptyPools() override;
 
         /// Binds the Draw ID to the currently bound vertex array object.
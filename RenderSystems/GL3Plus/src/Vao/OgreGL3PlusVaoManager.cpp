@@ -280,6 +280,8 @@ namespace Ogre
         tmpBuffer.resize( 512 * 1024 );  // 512kb per line should be way more than enough
         LwString text( LwString::FromEmptyPointer( &tmpBuffer[0], tmpBuffer.size() ) );
 
+        TlsfAllocator::BlockVec blocks;
+
         if( log )
             log->logMessage( "Pool Type;Offset;Size Bytes;Pool Idx;Pool Capacity", LML_CRITICAL );
 
@@ -294,66 +296,151 @@ namespace Ogre
                 const size_t poolIdx = static_cast<size_t>( itor - mVbos[vboIdx].begin() );
                 capacityBytes += vbo.sizeBytes;
 
+                freeBytes += vbo.allocator.getFreeBytes();
+
+                // Report contiguous allocations as a single used block
+                vbo.allocator.getBlocks( blocks );
                 Block usedBlock( 0, 0 );
+                TlsfAllocator::BlockVec::const_iterator itBlock = blocks.begin();
+                TlsfAllocator::BlockVec::const_iterator enBlock = blocks.end();
 
-                BlockVec freeBlocks = vbo.freeBlocks;
-                while( !freeBlocks.empty() )
+                while( itBlock != enBlock )
                 {
-                    // Find the free block that comes next
-                    BlockVec::iterator nextBlock;
+                    if( itBlock->used )
                     {
-                        BlockVec::iterator itBlock = freeBlocks.begin();
-                        BlockVec::iterator enBlock = freeBlocks.end();
-
-                        nextBlock = itBlock;
-
-                        while( itBlock != enBlock )
-                        {
-                            if( itBlock->offset < nextBlock->offset )
-                                nextBlock = itBlock;
-                            ++itBlock;
-                        }
+                        if( usedBlock.size == 0u )
+                            usedBlock.offset = itBlock->offset;
+                        usedBlock.size += itBlock->size;
                     }
-
-                    freeBytes += nextBlock->size;
-                    usedBlock.size = nextBlock->offset - usedBlock.offset;
-
-                    // usedBlock.size could be 0 if:
-                    //  1. All of memory is free
-                    //  2. There's two contiguous free blocks, which should not happen
-                    //     due to mergeContiguousBlocks
-                    if( usedBlock.size > 0u )
+                    else if( usedBlock.size > 0u )
                     {
                         getMemoryStats( usedBlock, vboIdx, poolIdx, vbo.sizeBytes, text, statsVec, log );
+                        usedBlock.size = 0u;
                     }
-
-                    usedBlock.offset += usedBlock.size;
-                    usedBlock.size = 0;
-                    efficientVectorRemove( freeBlocks, nextBlock );
+                    ++itBlock;
                 }
 
-                if( usedBlock.size > 0u || ( usedBlock.offset == 0 && usedBlock.size == 0 ) )
-                {
-                    if( vbo.freeBlocks.empty() )
-                    {
-                        // Deal with edge case when we're 100% full
-                        OGRE_ASSERT_LOW( usedBlock.offset == 0 && usedBlock.size == 0 );
-                        usedBlock.offset = 0u;
-                        usedBlock.size = vbo.sizeBytes;
-                    }
+                // Empty pools still get an entry, so that their capacity is accounted for
+                if( usedBlock.size > 0u || vbo.allocator.isEmpty() )
                     getMemoryStats( usedBlock, vboIdx, poolIdx, vbo.sizeBytes, text, statsVec, log );
-                }
 
                 ++itor;
             }
         }
 
+        if( log )
+        {
+            PoolFragmentationEntryVec fragmentationStats;
+            getFragmentationStats( fragmentationStats );
+
+            log->logMessage( "Pool Type;Pool Idx;Pool Capacity;Free Bytes;Largest Free Block;"
+                             "Free Blocks;Fragmentation",
+                             LML_CRITICAL );
+
+            PoolFragmentationEntryVec::const_iterator itor = fragmentationStats.begin();
+            PoolFragmentationEntryVec::const_iterator endt = fragmentationStats.end();
+
+            while( itor != endt )
+            {
+                text.clear();
+                text.a( c_vboTypes[itor->poolType], ";", (uint64)itor->poolIdx, ";" );
+                text.a( (uint64)itor->poolCapacity, ";", (uint64)itor->freeBytes, ";" );
+                text.a( (uint64)itor->largestFreeBlock, ";", (uint64)itor->numFreeBlocks, ";",
+                        itor->getFragmentation() );
+                log->logMessage( text.c_str(), LML_CRITICAL );
+                ++itor;
+            }
+        }
+
         outCapacityBytes = capacityBytes;
         outFreeBytes = freeBytes;
         outIncludesTextures = false;
         statsVec.swap( outStats );
     }
     //-----------------------------------------------------------------------------------
+    void GL3PlusVaoManager::getFragmentationStats( PoolFragmentationEntryVec &outStats ) const
+    {
+        outStats.clear();
+
+        for( unsigned vboIdx = 0; vboIdx < MAX_VBO_FLAG; ++vboIdx )
+        {
+            VboVec::const_iterator itor = mVbos[vboIdx].begin();
+            VboVec::const_iterator endt = mVbos[vboIdx].end();
+
+            while( itor != endt )
+            {
+                PoolFragmentationEntry entry;
+                entry.poolType = vboIdx;
+                entry.poolIdx = static_cast<uint32>( itor - mVbos[vboIdx].begin() );
+                entry.poolCapacity = itor->sizeBytes;
+                entry.freeBytes = itor->allocator.getFreeBytes();
+                entry.largestFreeBlock = itor->allocator.getLargestFreeBlock();
+                entry.numFreeBlocks = itor->allocator.getNumFreeBlocks();
+                outStats.push_back( entry );
+                ++itor;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    struct HigherBufferOffset
+    {
+        bool operator()( const BufferPacked *a, const BufferPacked *b ) const
+        {
+            return a->_getInternalBufferStart() * a->getBytesPerElement() >
+                   b->_getInternalBufferStart() * b->getBytesPerElement();
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    size_t GL3PlusVaoManager::defragment( size_t maxBytesToMove )
+    {
+        BufferPackedVec buffers;
+        getRelocatableBuffers( buffers );
+
+        // Move the highest buffers first, into the lowest holes
+        std::sort( buffers.begin(), buffers.end(), HigherBufferOffset() );
+
+        size_t bytesMoved = 0;
+
+        BufferPackedVec::const_iterator itor = buffers.begin();
+        BufferPackedVec::const_iterator endt = buffers.end();
+
+        while( itor != endt && bytesMoved < maxBytesToMove )
+        {
+            BufferPacked *buffer = *itor;
+            GL3PlusBufferInterface *bufferInterface =
+                static_cast<GL3PlusBufferInterface *>( buffer->getBufferInterface() );
+
+            const VboFlag vboFlag = bufferTypeToVboFlag( buffer->getBufferType() );
+            Vbo &vbo = mVbos[vboFlag][bufferInterface->getVboPoolIndex()];
+
+            const size_t bytesPerElement = buffer->getBytesPerElement();
+            const size_t oldOffset = buffer->_getInternalBufferStart() * bytesPerElement;
+            const size_t sizeBytes = buffer->_getInternalTotalSizeBytes();
+
+            size_t newOffset;
+            if( vbo.allocator.allocateBelow( sizeBytes, bytesPerElement, oldOffset, newOffset ) )
+            {
+                // Both ranges are in the same buffer but don't overlap, which GL allows.
+                // GL executes commands in order, hence draws already issued still read the
+                // old range, and the old range can be reused right away.
+                OCGE( glBindBuffer( GL_COPY_READ_BUFFER, vbo.vboName ) );
+                OCGE( glBindBuffer( GL_COPY_WRITE_BUFFER, vbo.vboName ) );
+                OCGE( glCopyBufferSubData(
+                    GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, static_cast<GLintptr>( oldOffset ),
+                    static_cast<GLintptr>( newOffset ), static_cast<GLsizeiptr>( sizeBytes ) ) );
+
+                vbo.allocator.deallocate( oldOffset );
+                bufferInterface->_setInternalBufferStart( newOffset / bytesPerElement );
+
+                bytesMoved += sizeBytes;
+            }
+
+            ++itor;
+        }
+
+        return bytesMoved;
+    }
+    //-----------------------------------------------------------------------------------
     void GL3PlusVaoManager::switchVboPoolIndexImpl( unsigned internalVboBufferType, size_t oldPoolIdx,
                                                     size_t newPoolIdx, BufferPacked *buffer )
     {
@@ -382,7 +469,7 @@ namespace Ogre
             while( itor != end )
             {
                 Vbo &vbo = *itor;
-                if( vbo.freeBlocks.size() == 1u && vbo.sizeBytes == vbo.freeBlocks.back().size )
+                if( vbo.allocator.isEmpty() )
                 {
 #if OGRE_DEBUG_MODE >= OGRE_DEBUG_LOW
                     VaoVec::const_iterator itVao = mVaos.begin();
@@ -445,173 +532,108 @@ namespace Ogre
         if( bufferType >= BT_DYNAMIC_DEFAULT )
             sizeBytes *= mDynamicBufferMultiplier;
 
-        VboVec::const_iterator itor = mVbos[vboFlag].begin();
-        VboVec::const_iterator end = mVbos[vboFlag].end();
-
-        // Find a suitable VBO that can hold the requested size. We prefer those free
-        // blocks that have a matching stride (the current offset is a multiple of
-        // bytesPerElement) in order to minimize the amount of memory padding.
-        size_t bestVboIdx = std::numeric_limits<size_t>::max();
-        ptrdiff_t bestBlockIdx = -1;
-        bool foundMatchingStride = false;
+        // Each pool finds a suitable free block in constant time
+        VboVec::iterator itor = mVbos[vboFlag].begin();
+        VboVec::iterator endt = mVbos[vboFlag].end();
 
-        while( itor != end && !foundMatchingStride )
+        while( itor != endt )
         {
-            BlockVec::const_iterator blockIt = itor->freeBlocks.begin();
-            BlockVec::const_iterator blockEn = itor->freeBlocks.end();
-
-            while( blockIt != blockEn && !foundMatchingStride )
+            if( itor->allocator.allocate( sizeBytes, alignment, outBufferOffset ) )
             {
-                const Block &block = *blockIt;
-
-                // Round to next multiple of alignment
-                size_t newOffset = ( ( block.offset + alignment - 1 ) / alignment ) * alignment;
-                size_t padding = newOffset - block.offset;
-
-                if( sizeBytes + padding <= block.size )
-                {
-                    bestVboIdx = static_cast<size_t>( itor - mVbos[vboFlag].begin() );
-                    bestBlockIdx = blockIt - itor->freeBlocks.begin();
-
-                    if( newOffset == block.offset )
-                        foundMatchingStride = true;
-                }
-
-                ++blockIt;
+                outVboIdx = static_cast<size_t>( itor - mVbos[vboFlag].begin() );
+                return;
             }
-
             ++itor;
         }
 
-        if( bestBlockIdx == -1 )
-        {
-            bestVboIdx = mVbos[vboFlag].size();
-            bestBlockIdx = 0;
-            foundMatchingStride = true;
+        Vbo newVbo;
 
-            Vbo newVbo;
+        size_t poolSize = std::max( mDefaultPoolSize[vboFlag], sizeBytes );
 
-            size_t poolSize = std::max( mDefaultPoolSize[vboFlag], sizeBytes );
+        // No luck, allocate a new buffer.
+        OCGE( glGenBuffers( 1, &newVbo.vboName ) );
+        OCGE( glBindBuffer( GL_ARRAY_BUFFER, newVbo.vboName ) );
 
-            // No luck, allocate a new buffer.
-            OCGE( glGenBuffers( 1, &newVbo.vboName ) );
-            OCGE( glBindBuffer( GL_ARRAY_BUFFER, newVbo.vboName ) );
+        GLenum error = 0;
+        int trustCounter = 1000;
+        // Reset the error code. Trust counter prevents an infinite loop
+        // just in case we encounter a moronic GL implementation.
+        while( glGetError() && trustCounter-- )
+            ;
 
-            GLenum error = 0;
-            int trustCounter = 1000;
-            // Reset the error code. Trust counter prevents an infinite loop
-            // just in case we encounter a moronic GL implementation.
-            while( glGetError() && trustCounter-- )
-                ;
+        if( mArbBufferStorage )
+        {
+            GLbitfield flags = 0;
 
-            if( mArbBufferStorage )
+            if( vboFlag >= CPU_ACCESSIBLE_DEFAULT )
             {
-                GLbitfield flags = 0;
+                flags |= GL_MAP_WRITE_BIT;
 
-                if( vboFlag >= CPU_ACCESSIBLE_DEFAULT )
+                if( vboFlag >= CPU_ACCESSIBLE_PERSISTENT )
                 {
-                    flags |= GL_MAP_WRITE_BIT;
-
-                    if( vboFlag >= CPU_ACCESSIBLE_PERSISTENT )
-                    {
-                        flags |= GL_MAP_PERSISTENT_BIT;
+                    flags |= GL_MAP_PERSISTENT_BIT;
 
-                        if( vboFlag >= CPU_ACCESSIBLE_PERSISTENT_COHERENT )
-                            flags |= GL_MAP_COHERENT_BIT;
-                    }
+                    if( vboFlag >= CPU_ACCESSIBLE_PERSISTENT_COHERENT )
+                        flags |= GL_MAP_COHERENT_BIT;
                 }
-
-                glBufferStorage( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( poolSize ), 0, flags );
-
-                error = glGetError();
             }
-            else
-            {
-                glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( poolSize ), 0,
-                              vboFlag == CPU_INACCESSIBLE ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW );
 
-                error = glGetError();
-            }
-
-            // OpenGL can't continue after any GL_OUT_OF_MEMORY has been raised,
-            // thus ignore the trustCounter in that case.
-            if( ( error != 0 && trustCounter != 0 ) || error == GL_OUT_OF_MEMORY )
-            {
-                OGRE_EXCEPT( Exception::ERR_RENDERINGAPI_ERROR,
-                             "Out of GPU memory or driver refused.\n"
-                             "glGetError code: " +
-                                 StringConverter::toString( error ) +
-                                 ".\n"
-                                 "Requested: " +
-                                 StringConverter::toString( poolSize ) + " bytes.",
-                             "GL3PlusVaoManager::allocateVbo" );
-            }
-
-            OCGE( glBindBuffer( GL_ARRAY_BUFFER, 0 ) );
+            glBufferStorage( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( poolSize ), 0, flags );
 
-            newVbo.sizeBytes = poolSize;
-            newVbo.freeBlocks.push_back( Block( 0, poolSize ) );
-            newVbo.dynamicBuffer = 0;
+            error = glGetError();
+        }
+        else
+        {
+            glBufferData( GL_ARRAY_BUFFER, static_cast<GLsizeiptr>( poolSize ), 0,
+                          vboFlag == CPU_INACCESSIBLE ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW );
 
-            if( vboFlag != CPU_INACCESSIBLE )
-            {
-                newVbo.dynamicBuffer = new GL3PlusDynamicBuffer(
-                    newVbo.vboName, (GLuint)newVbo.sizeBytes, this, bufferType );
-            }
+            error = glGetError();
+        }
 
-            mVbos[vboFlag].push_back( newVbo );
+        // OpenGL can't continue after any GL_OUT_OF_MEMORY has been raised,
+        // thus ignore the trustCounter in that case.
+        if( ( error != 0 && trustCounter != 0 ) || error == GL_OUT_OF_MEMORY )
+        {
+            OGRE_EXCEPT( Exception::ERR_RENDERINGAPI_ERROR,
+                         "Out of GPU memory or driver refused.\n"
+                         "glGetError code: " +
+                             StringConverter::toString( error ) +
+                             ".\n"
+                             "Requested: " +
+                             StringConverter::toString( poolSize ) + " bytes.",
+                         "GL3PlusVaoManager::allocateVbo" );
         }
 
-        Vbo &bestVbo = mVbos[vboFlag][bestVboIdx];
-        Block &bestBlock = bestVbo.freeBlocks[static_cast<size_t>( bestBlockIdx )];
+        OCGE( glBindBuffer( GL_ARRAY_BUFFER, 0 ) );
 
-        size_t newOffset = ( ( bestBlock.offset + alignment - 1 ) / alignment ) * alignment;
-        size_t padding = newOffset - bestBlock.offset;
-        // Shrink our records about available data.
-        bestBlock.size -= sizeBytes + padding;
-        bestBlock.offset = newOffset + sizeBytes;
+        newVbo.sizeBytes = poolSize;
+        newVbo.allocator.initialize( poolSize );
+        newVbo.dynamicBuffer = 0;
 
-        if( !foundMatchingStride )
+        if( vboFlag != CPU_INACCESSIBLE )
         {
-            // This is a stride changer, record as such.
-            StrideChangerVec::iterator itStride =
-                std::lower_bound( bestVbo.strideChangers.begin(), bestVbo.strideChangers.end(),
-                                  newOffset, StrideChanger() );
-            bestVbo.strideChangers.insert( itStride, StrideChanger( newOffset, padding ) );
+            newVbo.dynamicBuffer = new GL3PlusDynamicBuffer(
+                newVbo.vboName, (GLuint)newVbo.sizeBytes, this, bufferType );
         }
 
-        if( bestBlock.size == 0 )
-            bestVbo.freeBlocks.erase( bestVbo.freeBlocks.begin() + bestBlockIdx );
+        mVbos[vboFlag].push_back( newVbo );
 
-        outVboIdx = bestVboIdx;
-        outBufferOffset = newOffset;
+        outVboIdx = mVbos[vboFlag].size() - 1u;
+        const bool allocated =
+            mVbos[vboFlag].back().allocator.allocate( sizeBytes, alignment, outBufferOffset );
+        OGRE_ASSERT_LOW( allocated && "The new pool can't hold the request?" );
+        OGRE_UNUSED_VAR( allocated );
     }
     //-----------------------------------------------------------------------------------
     void GL3PlusVaoManager::deallocateVbo( size_t vboIdx, size_t bufferOffset, size_t sizeBytes,
                                            BufferType bufferType )
     {
+        // The allocator remembers the size of each range
         VboFlag vboFlag = bufferTypeToVboFlag( bufferType );
-
-        if( bufferType >= BT_DYNAMIC_DEFAULT )
-            sizeBytes *= mDynamicBufferMultiplier;
-
-        Vbo &vbo = mVbos[vboFlag][vboIdx];
-        StrideChangerVec::iterator itStride = std::lower_bound(
-            vbo.strideChangers.begin(), vbo.strideChangers.end(), bufferOffset, StrideChanger() );
-
-        if( itStride != vbo.strideChangers.end() && itStride->offsetAfterPadding == bufferOffset )
-        {
-            bufferOffset -= itStride->paddedBytes;
-            sizeBytes += itStride->paddedBytes;
-
-            vbo.strideChangers.erase( itStride );
-        }
-
-        // See if we're contiguous to a free block and make that block grow.
-        vbo.freeBlocks.push_back( Block( bufferOffset, sizeBytes ) );
-        mergeContiguousBlocks( vbo.freeBlocks.end() - 1, vbo.freeBlocks );
+        mVbos[vboFlag][vboIdx].allocator.deallocate( bufferOffset );
     }
     //-----------------------------------------------------------------------------------
+#ifdef _OGRE_MULTISOURCE_VBO
     void GL3PlusVaoManager::mergeContiguousBlocks( BlockVec::iterator blockToMerge, BlockVec &blocks )
     {
         BlockVec::iterator itor = blocks.begin();
@@ -657,6 +679,7 @@ namespace Ogre
             }
         }
     }
+#endif
     //-----------------------------------------------------------------------------------
     VertexBufferPacked *GL3PlusVaoManager::createVertexBufferImpl( size_t numElements,
                                                                    uint32 bytesPerElement,
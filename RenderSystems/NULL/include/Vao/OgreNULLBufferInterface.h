@@ -42,6 +42,9 @@ namespace Ogre
     {
     protected:
         size_t mVboPoolIdx;
+        /// Where the buffer was sub-allocated in its pool. Unlike the real backends, this is
+        /// not mInternalBufferStart since mNullDataPtr only holds this buffer's data
+        size_t mVboPoolOffset;
         void  *mMappedPtr;
 
         uint8 *mNullDataPtr;
@@ -49,10 +52,14 @@ namespace Ogre
         size_t advanceFrame( bool bAdvanceFrame );
 
     public:
-        NULLBufferInterface( size_t vboPoolIdx );
+        NULLBufferInterface( size_t vboPoolIdx, size_t vboPoolOffset );
         ~NULLBufferInterface() override;
 
         size_t getVboPoolIndex() { return mVboPoolIdx; }
+        size_t getVboPoolOffset() { return mVboPoolOffset; }
+
+        void _setVboPoolIndex( size_t newVboPool ) { mVboPoolIdx = newVboPool; }
+        void _setVboPoolOffset( size_t newVboPoolOffset ) { mVboPoolOffset = newVboPoolOffset; }
 
         uint8 *getNullDataPtr() { return mNullDataPtr; }
 
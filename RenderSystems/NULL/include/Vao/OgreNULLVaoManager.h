@@ -31,6 +31,7 @@ THE SOFTWARE.
 
 #include "OgreNULLPrerequisites.h"
 
+#include "Vao/OgreTlsfAllocator.h"
 #include "Vao/OgreVaoManager.h"
 
 namespace Ogre
@@ -55,42 +56,16 @@ namespace Ogre
 
             Block( size_t _offset, size_t _size ) : offset( _offset ), size( _size ) {}
         };
-        struct StrideChanger
-        {
-            size_t offsetAfterPadding;
-            size_t paddedBytes;
-
-            StrideChanger() : offsetAfterPadding( 0 ), paddedBytes( 0 ) {}
-            StrideChanger( size_t _offsetAfterPadding, size_t _paddedBytes ) :
-                offsetAfterPadding( _offsetAfterPadding ),
-                paddedBytes( _paddedBytes )
-            {
-            }
-
-            bool operator()( const StrideChanger &left, size_t right ) const
-            {
-                return left.offsetAfterPadding < right;
-            }
-            bool operator()( size_t left, const StrideChanger &right ) const
-            {
-                return left < right.offsetAfterPadding;
-            }
-            bool operator()( const StrideChanger &left, const StrideChanger &right ) const
-            {
-                return left.offsetAfterPadding < right.offsetAfterPadding;
-            }
-        };
-
-        typedef vector<Block>::type         BlockVec;
-        typedef vector<StrideChanger>::type StrideChangerVec;
+        typedef vector<Block>::type BlockVec;
 
     protected:
+        /// There is no GPU memory behind a pool (each buffer keeps its own copy),
+        /// but ranges are still sub-allocated the same way the real backends do
         struct Vbo
         {
             size_t sizeBytes;
 
-            BlockVec         freeBlocks;
-            StrideChangerVec strideChangers;
+            TlsfAllocator allocator;
         };
 
         struct Vao
@@ -126,12 +101,38 @@ namespace Ogre
         typedef vector<Vao>::type VaoVec;
 
         VboVec mVbos[MAX_VBO_FLAG];
+        size_t mDefaultPoolSize[MAX_VBO_FLAG];
 
         VaoVec mVaos;
 
         VertexBufferPacked *mDrawId;
 
     protected:
+        /** Asks for allocating buffer space in a VBO (i.e. pool).
+        @param sizeBytes
+            Requested size in bytes
+        @param alignment
+            The required alignment of the offset, in bytes
+        @param bufferType
+            Type of buffer
+        @param outVboIdx [out]
+            The index to the mVbos.
+        @param outBufferOffset [out]
+            The offset in bytes at which the buffer data should be placed.
+        */
+        void allocateVbo( size_t sizeBytes, size_t alignment, BufferType bufferType,
+                          size_t &outVboIdx, size_t &outBufferOffset );
+
+        /** Deallocates a buffer allocated with @allocateVbo.
+        @param vboIdx
+            The index to the mVbos pool that was returned by allocateVbo
+        @param bufferOffset
+            The buffer offset that was returned by allocateVbo
+        @param bufferType
+            The type of buffer that was passed to allocateVbo
+        */
+        void deallocateVbo( size_t vboIdx, size_t bufferOffset, BufferType bufferType );
+
         VertexBufferPacked *createVertexBufferImpl( size_t numElements, uint32 bytesPerElement,
                                                     BufferType bufferType, void *initialData,
                                                     bool                     keepAsShadow,
@@ -192,6 +193,12 @@ namespace Ogre
         void getMemoryStats( MemoryStatsEntryVec &outStats, size_t &outCapacityBytes,
                              size_t &outFreeBytes, Log *log, bool &outIncludesTextures ) const override;
 
+        void getFragmentationStats( PoolFragmentationEntryVec &outStats ) const override;
+
+        /// There is nothing to copy since each buffer keeps its own data,
+        /// but the ranges move exactly like in the real backends
+        size_t defragment( size_t maxBytesToMove ) override;
+
         void cleanupEmptyPools() override;
 
         bool supportsArbBufferStorage() const { return false; }
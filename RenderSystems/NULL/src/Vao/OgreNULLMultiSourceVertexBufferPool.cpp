@@ -100,7 +100,7 @@ namespace Ogre
         {
             for( size_t i = 0; i < mVertexElementsBySource.size(); ++i )
             {
-                NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+                NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0, 0 );
                 void *_initialData = 0;
                 if( initialData )
                     _initialData = initialData[i];
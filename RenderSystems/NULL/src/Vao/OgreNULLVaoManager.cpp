@@ -28,6 +28,8 @@ THE SOFTWARE.
 
 #include "Vao/OgreNULLVaoManager.h"
 
+#include "OgreLogManager.h"
+#include "OgreLwString.h"
 #include "OgreRenderQueue.h"
 #include "OgreStringConverter.h"
 #include "OgreTimer.h"
@@ -45,8 +47,21 @@ THE SOFTWARE.
 
 namespace Ogre
 {
+    static const char *c_vboTypes[] = {
+        "CPU_INACCESSIBLE",
+        "CPU_ACCESSIBLE_DEFAULT",
+        "CPU_ACCESSIBLE_PERSISTENT",
+        "CPU_ACCESSIBLE_PERSISTENT_COHERENT",
+    };
+
     NULLVaoManager::NULLVaoManager() : VaoManager( 0 ), mDrawId( 0 )
     {
+        // Same pool sizes as GL3+
+        mDefaultPoolSize[CPU_INACCESSIBLE] = 64 * 1024 * 1024;
+        for( size_t i = CPU_ACCESSIBLE_DEFAULT; i <= CPU_ACCESSIBLE_PERSISTENT_COHERENT; ++i )
+            mDefaultPoolSize[i] = 4 * 1024 * 1024;
+        mDefaultPoolSize[CPU_ACCESSIBLE_PERSISTENT] = 16 * 1024 * 1024;
+
         mConstBufferAlignment = 256;
         mTexBufferAlignment = 256;
 
@@ -77,12 +92,207 @@ namespace Ogre
                                          size_t &outFreeBytes, Log *log,
                                          bool &outIncludesTextures ) const
     {
-        outCapacityBytes = 0;
-        outFreeBytes = 0;
+        size_t capacityBytes = 0;
+        size_t freeBytes = 0;
+        MemoryStatsEntryVec statsVec;
+        statsVec.swap( outStats );
+
+        char tmpBuffer[512];
+        LwString text( LwString::FromEmptyPointer( tmpBuffer, sizeof( tmpBuffer ) ) );
+
+        TlsfAllocator::BlockVec blocks;
+
+        if( log )
+            log->logMessage( "Pool Type;Offset;Size Bytes;Pool Idx;Pool Capacity", LML_CRITICAL );
+
+        for( unsigned vboIdx = 0; vboIdx < MAX_VBO_FLAG; ++vboIdx )
+        {
+            VboVec::const_iterator itor = mVbos[vboIdx].begin();
+            VboVec::const_iterator endt = mVbos[vboIdx].end();
+
+            while( itor != endt )
+            {
+                const Vbo &vbo = *itor;
+                const uint32 poolIdx = static_cast<uint32>( itor - mVbos[vboIdx].begin() );
+                capacityBytes += vbo.sizeBytes;
+                freeBytes += vbo.allocator.getFreeBytes();
+
+                // Report each used range. Empty pools still get an entry,
+                // so that their capacity is accounted for
+                vbo.allocator.getBlocks( blocks );
+                TlsfAllocator::BlockVec::const_iterator itBlock = blocks.begin();
+                TlsfAllocator::BlockVec::const_iterator enBlock = blocks.end();
+
+                while( itBlock != enBlock )
+                {
+                    if( itBlock->used || vbo.allocator.isEmpty() )
+                    {
+                        const size_t usedSize = itBlock->used ? itBlock->size : 0u;
+                        statsVec.push_back( MemoryStatsEntry( vboIdx, poolIdx, itBlock->offset,
+                                                              usedSize, vbo.sizeBytes, false ) );
+                        if( log )
+                        {
+                            text.clear();
+                            text.a( c_vboTypes[vboIdx], ";", (uint64)itBlock->offset, ";",
+                                    (uint64)usedSize, ";" );
+                            text.a( poolIdx, ";", (uint64)vbo.sizeBytes );
+                            log->logMessage( text.c_str(), LML_CRITICAL );
+                        }
+                    }
+                    ++itBlock;
+                }
+
+                ++itor;
+            }
+        }
+
+        outCapacityBytes = capacityBytes;
+        outFreeBytes = freeBytes;
         outIncludesTextures = false;
+        statsVec.swap( outStats );
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::cleanupEmptyPools() {}
+    void NULLVaoManager::getFragmentationStats( PoolFragmentationEntryVec &outStats ) const
+    {
+        outStats.clear();
+
+        for( unsigned vboIdx = 0; vboIdx < MAX_VBO_FLAG; ++vboIdx )
+        {
+            VboVec::const_iterator itor = mVbos[vboIdx].begin();
+            VboVec::const_iterator endt = mVbos[vboIdx].end();
+
+            while( itor != endt )
+            {
+                PoolFragmentationEntry entry;
+                entry.poolType = vboIdx;
+                entry.poolIdx = static_cast<uint32>( itor - mVbos[vboIdx].begin() );
+                entry.poolCapacity = itor->sizeBytes;
+                entry.freeBytes = itor->allocator.getFreeBytes();
+                entry.largestFreeBlock = itor->allocator.getLargestFreeBlock();
+                entry.numFreeBlocks = itor->allocator.getNumFreeBlocks();
+                outStats.push_back( entry );
+                ++itor;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    struct HigherVboPoolOffset
+    {
+        bool operator()( const BufferPacked *a, const BufferPacked *b ) const
+        {
+            return static_cast<NULLBufferInterface *>( a->getBufferInterface() )->getVboPoolOffset() >
+                   static_cast<NULLBufferInterface *>( b->getBufferInterface() )->getVboPoolOffset();
+        }
+    };
+    //-----------------------------------------------------------------------------------
+    size_t NULLVaoManager::defragment( size_t maxBytesToMove )
+    {
+        BufferPackedVec buffers;
+        getRelocatableBuffers( buffers );
+
+        // Move the highest buffers first, into the lowest holes
+        std::sort( buffers.begin(), buffers.end(), HigherVboPoolOffset() );
+
+        size_t bytesMoved = 0;
+
+        BufferPackedVec::const_iterator itor = buffers.begin();
+        BufferPackedVec::const_iterator endt = buffers.end();
+
+        while( itor != endt && bytesMoved < maxBytesToMove )
+        {
+            BufferPacked *buffer = *itor;
+            NULLBufferInterface *bufferInterface =
+                static_cast<NULLBufferInterface *>( buffer->getBufferInterface() );
+
+            const VboFlag vboFlag = bufferTypeToVboFlag( buffer->getBufferType() );
+            Vbo &vbo = mVbos[vboFlag][bufferInterface->getVboPoolIndex()];
+
+            const size_t oldOffset = bufferInterface->getVboPoolOffset();
+            const size_t sizeBytes = buffer->getTotalSizeBytes();
+
+            size_t newOffset;
+            if( vbo.allocator.allocateBelow( sizeBytes, buffer->getBytesPerElement(), oldOffset,
+                                             newOffset ) )
+            {
+                vbo.allocator.deallocate( oldOffset );
+                bufferInterface->_setVboPoolOffset( newOffset );
+                bytesMoved += sizeBytes;
+            }
+
+            ++itor;
+        }
+
+        return bytesMoved;
+    }
+    //-----------------------------------------------------------------------------------
+    void NULLVaoManager::cleanupEmptyPools()
+    {
+        for( unsigned vboIdx = 0; vboIdx < MAX_VBO_FLAG; ++vboIdx )
+        {
+            VboVec::iterator itor = mVbos[vboIdx].begin();
+            VboVec::iterator end = mVbos[vboIdx].end();
+
+            while( itor != end )
+            {
+                if( itor->allocator.isEmpty() )
+                {
+                    // There's (unrelated) live buffers whose vboIdx will now point out of bounds.
+                    // We need to update them so they don't crash deallocateVbo later.
+                    switchVboPoolIndex( vboIdx, (size_t)( mVbos[vboIdx].size() - 1u ),
+                                        (size_t)( itor - mVbos[vboIdx].begin() ) );
+
+                    itor = efficientVectorRemove( mVbos[vboIdx], itor );
+                    end = mVbos[vboIdx].end();
+                }
+                else
+                {
+                    ++itor;
+                }
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
+    void NULLVaoManager::allocateVbo( size_t sizeBytes, size_t alignment, BufferType bufferType,
+                                      size_t &outVboIdx, size_t &outBufferOffset )
+    {
+        assert( alignment > 0 );
+
+        VboFlag vboFlag = bufferTypeToVboFlag( bufferType );
+
+        if( bufferType >= BT_DYNAMIC_DEFAULT )
+            sizeBytes *= mDynamicBufferMultiplier;
+
+        VboVec::iterator itor = mVbos[vboFlag].begin();
+        VboVec::iterator endt = mVbos[vboFlag].end();
+
+        while( itor != endt )
+        {
+            if( itor->allocator.allocate( sizeBytes, alignment, outBufferOffset ) )
+            {
+                outVboIdx = static_cast<size_t>( itor - mVbos[vboFlag].begin() );
+                return;
+            }
+            ++itor;
+        }
+
+        // No luck, create a new pool.
+        Vbo newVbo;
+        newVbo.sizeBytes = std::max( mDefaultPoolSize[vboFlag], sizeBytes );
+        newVbo.allocator.initialize( newVbo.sizeBytes );
+        mVbos[vboFlag].push_back( newVbo );
+
+        outVboIdx = mVbos[vboFlag].size() - 1u;
+        const bool allocated =
+            mVbos[vboFlag].back().allocator.allocate( sizeBytes, alignment, outBufferOffset );
+        OGRE_ASSERT_LOW( allocated && "The new pool can't hold the request?" );
+        OGRE_UNUSED_VAR( allocated );
+    }
+    //-----------------------------------------------------------------------------------
+    void NULLVaoManager::deallocateVbo( size_t vboIdx, size_t bufferOffset, BufferType bufferType )
+    {
+        VboFlag vboFlag = bufferTypeToVboFlag( bufferType );
+        mVbos[vboFlag][vboIdx].allocator.deallocate( bufferOffset );
+    }
     //-----------------------------------------------------------------------------------
     VertexBufferPacked *NULLVaoManager::createVertexBufferImpl( size_t numElements,
                                                                 uint32 bytesPerElement,
@@ -90,7 +300,12 @@ namespace Ogre
                                                                 bool keepAsShadow,
                                                                 const VertexElement2Vec &vElements )
     {
-        NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+        size_t vboIdx;
+        size_t bufferOffset;
+
+        allocateVbo( numElements * bytesPerElement, bytesPerElement, bufferType, vboIdx, bufferOffset );
+
+        NULLBufferInterface *bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         VertexBufferPacked *retVal =
             OGRE_NEW VertexBufferPacked( 0, numElements, bytesPerElement, 0, bufferType, initialData,
                                          keepAsShadow, this, bufferInterface, vElements );
@@ -101,7 +316,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::destroyVertexBufferImpl( VertexBufferPacked *vertexBuffer ) {}
+    void NULLVaoManager::destroyVertexBufferImpl( VertexBufferPacked *vertexBuffer )
+    {
+        NULLBufferInterface *bufferInterface =
+            static_cast<NULLBufferInterface *>( vertexBuffer->getBufferInterface() );
+        deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                       vertexBuffer->getBufferType() );
+    }
     //-----------------------------------------------------------------------------------
 #ifdef _OGRE_MULTISOURCE_VBO
     MultiSourceVertexBufferPool *NULLVaoManager::createMultiSourceVertexBufferPoolImpl(
@@ -117,7 +338,12 @@ namespace Ogre
                                                               BufferType bufferType, void *initialData,
                                                               bool keepAsShadow )
     {
-        NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+        size_t vboIdx;
+        size_t bufferOffset;
+
+        allocateVbo( numElements * bytesPerElement, bytesPerElement, bufferType, vboIdx, bufferOffset );
+
+        NULLBufferInterface *bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         IndexBufferPacked *retVal =
             OGRE_NEW IndexBufferPacked( 0, numElements, bytesPerElement, 0, bufferType, initialData,
                                         keepAsShadow, this, bufferInterface );
@@ -128,7 +354,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::destroyIndexBufferImpl( IndexBufferPacked *indexBuffer ) {}
+    void NULLVaoManager::destroyIndexBufferImpl( IndexBufferPacked *indexBuffer )
+    {
+        NULLBufferInterface *bufferInterface =
+            static_cast<NULLBufferInterface *>( indexBuffer->getBufferInterface() );
+        deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                       indexBuffer->getBufferType() );
+    }
     //-----------------------------------------------------------------------------------
     ConstBufferPacked *NULLVaoManager::createConstBufferImpl( size_t sizeBytes, BufferType bufferType,
                                                               void *initialData, bool keepAsShadow )
@@ -146,7 +378,12 @@ namespace Ogre
             sizeBytes = ( ( sizeBytes + alignment - 1 ) / alignment ) * alignment;
         }
 
-        NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+        size_t vboIdx;
+        size_t bufferOffset;
+
+        allocateVbo( sizeBytes, alignment, bufferType, vboIdx, bufferOffset );
+
+        NULLBufferInterface *bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         ConstBufferPacked *retVal =
             OGRE_NEW NULLConstBufferPacked( 0, sizeBytes, 1, 0, bufferType, initialData, keepAsShadow,
                                             this, bufferInterface, bindableSize );
@@ -157,7 +394,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::destroyConstBufferImpl( ConstBufferPacked *constBuffer ) {}
+    void NULLVaoManager::destroyConstBufferImpl( ConstBufferPacked *constBuffer )
+    {
+        NULLBufferInterface *bufferInterface =
+            static_cast<NULLBufferInterface *>( constBuffer->getBufferInterface() );
+        deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                       constBuffer->getBufferType() );
+    }
     //-----------------------------------------------------------------------------------
     TexBufferPacked *NULLVaoManager::createTexBufferImpl( PixelFormatGpu pixelFormat, size_t sizeBytes,
                                                           BufferType bufferType, void *initialData,
@@ -176,7 +419,12 @@ namespace Ogre
             sizeBytes = ( ( sizeBytes + alignment - 1 ) / alignment ) * alignment;
         }
 
-        NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+        size_t vboIdx;
+        size_t bufferOffset;
+
+        allocateVbo( sizeBytes, alignment, bufferType, vboIdx, bufferOffset );
+
+        NULLBufferInterface *bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         TexBufferPacked *retVal =
             OGRE_NEW NULLTexBufferPacked( 0, sizeBytes, 1, 0, bufferType, initialData, keepAsShadow,
                                           this, bufferInterface, pixelFormat );
@@ -187,7 +435,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::destroyTexBufferImpl( TexBufferPacked *texBuffer ) {}
+    void NULLVaoManager::destroyTexBufferImpl( TexBufferPacked *texBuffer )
+    {
+        NULLBufferInterface *bufferInterface =
+            static_cast<NULLBufferInterface *>( texBuffer->getBufferInterface() );
+        deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                       texBuffer->getBufferType() );
+    }
     //-----------------------------------------------------------------------------------
     ReadOnlyBufferPacked *NULLVaoManager::createReadOnlyBufferImpl( PixelFormatGpu pixelFormat,
                                                                     size_t sizeBytes,
@@ -208,7 +462,12 @@ namespace Ogre
             sizeBytes = ( ( sizeBytes + alignment - 1 ) / alignment ) * alignment;
         }
 
-        NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+        size_t vboIdx;
+        size_t bufferOffset;
+
+        allocateVbo( sizeBytes, alignment, bufferType, vboIdx, bufferOffset );
+
+        NULLBufferInterface *bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         ReadOnlyBufferPacked *retVal =
             OGRE_NEW NULLReadOnlyBufferPacked( 0, sizeBytes, 1, 0, bufferType, initialData, keepAsShadow,
                                                this, bufferInterface, pixelFormat );
@@ -219,13 +478,27 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::destroyReadOnlyBufferImpl( ReadOnlyBufferPacked *readOnlyBuffer ) {}
+    void NULLVaoManager::destroyReadOnlyBufferImpl( ReadOnlyBufferPacked *readOnlyBuffer )
+    {
+        NULLBufferInterface *bufferInterface =
+            static_cast<NULLBufferInterface *>( readOnlyBuffer->getBufferInterface() );
+        deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                       readOnlyBuffer->getBufferType() );
+    }
     //-----------------------------------------------------------------------------------
     UavBufferPacked *NULLVaoManager::createUavBufferImpl( size_t numElements, uint32 bytesPerElement,
                                                           uint32 bindFlags, void *initialData,
                                                           bool keepAsShadow )
     {
-        NULLBufferInterface *bufferInterface = new NULLBufferInterface( 0 );
+        size_t vboIdx;
+        size_t bufferOffset;
+
+        size_t alignment = Math::lcm( mUavBufferAlignment, bytesPerElement );
+
+        // UAV Buffers can't be dynamic.
+        allocateVbo( numElements * bytesPerElement, alignment, BT_DEFAULT, vboIdx, bufferOffset );
+
+        NULLBufferInterface *bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         UavBufferPacked *retVal =
             OGRE_NEW NULLUavBufferPacked( 0, numElements, bytesPerElement, bindFlags, initialData,
                                           keepAsShadow, this, bufferInterface );
@@ -236,7 +509,13 @@ namespace Ogre
         return retVal;
     }
     //-----------------------------------------------------------------------------------
-    void NULLVaoManager::destroyUavBufferImpl( UavBufferPacked *uavBuffer ) {}
+    void NULLVaoManager::destroyUavBufferImpl( UavBufferPacked *uavBuffer )
+    {
+        NULLBufferInterface *bufferInterface =
+            static_cast<NULLBufferInterface *>( uavBuffer->getBufferInterface() );
+        deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                       uavBuffer->getBufferType() );
+    }
     //-----------------------------------------------------------------------------------
     IndirectBufferPacked *NULLVaoManager::createIndirectBufferImpl( size_t sizeBytes,
                                                                     BufferType bufferType,
@@ -244,7 +523,6 @@ namespace Ogre
                                                                     bool keepAsShadow )
     {
         const size_t alignment = 4;
-        // size_t bufferOffset = 0;
 
         if( bufferType >= BT_DYNAMIC_DEFAULT )
         {
@@ -258,7 +536,12 @@ namespace Ogre
         NULLBufferInterface *bufferInterface = 0;
         if( mSupportsIndirectBuffers )
         {
-            bufferInterface = new NULLBufferInterface( 0 );
+            size_t vboIdx;
+            size_t bufferOffset;
+
+            allocateVbo( sizeBytes, alignment, bufferType, vboIdx, bufferOffset );
+
+            bufferInterface = new NULLBufferInterface( vboIdx, bufferOffset );
         }
 
         IndirectBufferPacked *retVal = OGRE_NEW IndirectBufferPacked(
@@ -283,6 +566,10 @@ namespace Ogre
     {
         if( mSupportsIndirectBuffers )
         {
+            NULLBufferInterface *bufferInterface =
+                static_cast<NULLBufferInterface *>( indirectBuffer->getBufferInterface() );
+            deallocateVbo( bufferInterface->getVboPoolIndex(), bufferInterface->getVboPoolOffset(),
+                           indirectBuffer->getBufferType() );
         }
     }
     //-----------------------------------------------------------------------------------
@@ -409,5 +696,16 @@ namespace Ogre
     void NULLVaoManager::switchVboPoolIndexImpl( unsigned internalVboBufferType, size_t oldPoolIdx,
                                                  size_t newPoolIdx, BufferPacked *buffer )
     {
+        if( mSupportsIndirectBuffers || buffer->getBufferPackedType() != BP_TYPE_INDIRECT )
+        {
+            VboFlag vboFlag = bufferTypeToVboFlag( buffer->getBufferType() );
+            if( vboFlag == internalVboBufferType )
+            {
+                NULLBufferInterface *bufferInterface =
+                    static_cast<NULLBufferInterface *>( buffer->getBufferInterface() );
+                if( bufferInterface->getVboPoolIndex() == oldPoolIdx )
+                    bufferInterface->_setVboPoolIndex( newPoolIdx );
+            }
+        }
     }
 }  // namespace Ogre
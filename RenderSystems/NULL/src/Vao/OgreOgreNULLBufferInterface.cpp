@@ -33,8 +33,9 @@ THE SOFTWARE.
 
 namespace Ogre
 {
-    NULLBufferInterface::NULLBufferInterface( size_t vboPoolIdx ) :
+    NULLBufferInterface::NULLBufferInterface( size_t vboPoolIdx, size_t vboPoolOffset ) :
         mVboPoolIdx( vboPoolIdx ),
+        mVboPoolOffset( vboPoolOffset ),
         mMappedPtr( 0 ),
         mNullDataPtr( 0 )
     {
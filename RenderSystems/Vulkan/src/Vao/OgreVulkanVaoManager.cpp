@@ -339,6 +339,8 @@ namespace Ogre
         tmpBuffer.resize( 512 * 1024 );  // 512kb per line should be way more than enough
         LwString text( LwString::FromEmptyPointer( &tmpBuffer[0], tmpBuffer.size() ) );
 
+        TlsfAllocator::BlockVec blocks;
+
         if( log )
             log->logMessage( "Pool Type;Offset;Size Bytes;Pool Idx;Pool Capacity", LML_CRITICAL );
 
@@ -353,68 +355,92 @@ namespace Ogre
                 const size_t poolIdx = static_cast<size_t>( itor - mVbos[vboIdx].begin() );
                 capacityBytes += vbo.sizeBytes;
 
+                freeBytes += vbo.allocator.getFreeBytes();
+
+                // Report contiguous allocations as a single used block
+                vbo.allocator.getBlocks( blocks );
                 Block usedBlock( 0, 0 );
+                TlsfAllocator::BlockVec::const_iterator itBlock = blocks.begin();
+                TlsfAllocator::BlockVec::const_iterator enBlock = blocks.end();
 
-                BlockVec freeBlocks = vbo.freeBlocks;
-                while( !freeBlocks.empty() )
+                while( itBlock != enBlock )
                 {
-                    // Find the free block that comes next
-                    BlockVec::iterator nextBlock;
+                    if( itBlock->used )
                     {
-                        BlockVec::iterator itBlock = freeBlocks.begin();
-                        BlockVec::iterator enBlock = freeBlocks.end();
-
-                        nextBlock = itBlock;
-
-                        while( itBlock != enBlock )
-                        {
-                            if( itBlock->offset < nextBlock->offset )
-                                nextBlock = itBlock;
-                            ++itBlock;
-                        }
+                        if( usedBlock.size == 0u )
+                            usedBlock.offset = itBlock->offset;
+                        usedBlock.size += itBlock->size;
                     }
-
-                    freeBytes += nextBlock->size;
-                    usedBlock.size = nextBlock->offset - usedBlock.offset;
-
-                    OGRE_ASSERT_LOW( usedBlock.size <= vbo.sizeBytes );
-                    OGRE_ASSERT_LOW( usedBlock.offset + usedBlock.size <= vbo.sizeBytes );
-
-                    // usedBlock.size could be 0 if:
-                    //  1. All of memory is free
-                    //  2. There's two contiguous free blocks, which should not happen
-                    //     due to mergeContiguousBlocks
-                    if( usedBlock.size > 0u )
+                    else if( usedBlock.size > 0u )
                     {
                         getMemoryStats( usedBlock, vboIdx, poolIdx, vbo.sizeBytes, text, statsVec, log );
+                        usedBlock.size = 0u;
                     }
-
-                    usedBlock.offset += usedBlock.size;
-                    usedBlock.size = 0;
-                    efficientVectorRemove( freeBlocks, nextBlock );
+                    ++itBlock;
                 }
 
-                if( usedBlock.size > 0u || ( usedBlock.offset == 0 && usedBlock.size == 0 ) )
-                {
-                    if( vbo.freeBlocks.empty() )
-                    {
-                        OGRE_ASSERT_LOW( usedBlock.offset == 0 && usedBlock.size == 0 );
-                        usedBlock.offset = 0u;
-                        usedBlock.size = vbo.sizeBytes;
-                    }
+                // Empty pools still get an entry, so that their capacity is accounted for
+                if( usedBlock.size > 0u || vbo.allocator.isEmpty() )
                     getMemoryStats( usedBlock, vboIdx, poolIdx, vbo.sizeBytes, text, statsVec, log );
-                }
 
                 ++itor;
             }
         }
 
+        if( log )
+        {
+            PoolFragmentationEntryVec fragmentationStats;
+            getFragmentationStats( fragmentationStats );
+
+            log->logMessage( "Pool Type;Pool Idx;Pool Capacity;Free Bytes;Largest Free Block;"
+                             "Free Blocks;Fragmentation",
+                             LML_CRITICAL );
+
+            PoolFragmentationEntryVec::const_iterator itor = fragmentationStats.begin();
+            PoolFragmentationEntryVec::const_iterator endt = fragmentationStats.end();
+
+            while( itor != endt )
+            {
+                text.clear();
+                text.a( c_vboTypes[itor->poolType], ";", (uint64)itor->poolIdx, ";" );
+                text.a( (uint64)itor->poolCapacity, ";", (uint64)itor->freeBytes, ";" );
+                text.a( (uint64)itor->largestFreeBlock, ";", (uint64)itor->numFreeBlocks, ";",
+                        itor->getFragmentation() );
+                log->logMessage( text.c_str(), LML_CRITICAL );
+                ++itor;
+            }
+        }
+
         outCapacityBytes = capacityBytes;
         outFreeBytes = freeBytes;
         outIncludesTextures = true;
         statsVec.swap( outStats );
     }
     //-----------------------------------------------------------------------------------
+    void VulkanVaoManager::getFragmentationStats( PoolFragmentationEntryVec &outStats ) const
+    {
+        outStats.clear();
+
+        for( unsigned vboIdx = 0; vboIdx < MAX_VBO_FLAG; ++vboIdx )
+        {
+            VboVec::const_iterator itor = mVbos[vboIdx].begin();
+            VboVec::const_iterator endt = mVbos[vboIdx].end();
+
+            while( itor != endt )
+            {
+                PoolFragmentationEntry entry;
+                entry.poolType = vboIdx;
+                entry.poolIdx = static_cast<uint32>( itor - mVbos[vboIdx].begin() );
+                entry.poolCapacity = itor->sizeBytes;
+                entry.freeBytes = itor->allocator.getFreeBytes();
+                entry.largestFreeBlock = itor->allocator.getLargestFreeBlock();
+                entry.numFreeBlocks = itor->allocator.getNumFreeBlocks();
+                outStats.push_back( entry );
+                ++itor;
+            }
+        }
+    }
+    //-----------------------------------------------------------------------------------
     void VulkanVaoManager::deallocateEmptyVbos( const bool bDeviceStall )
     {
         if( mEmptyVboPools.empty() )
@@ -449,7 +475,7 @@ namespace Ogre
                 delete vbo.dynamicBuffer;
                 vbo.dynamicBuffer = 0;
 
-                vbo.freeBlocks.clear();
+                vbo.allocator.initialize( 0u );
                 vbo.emptyFrame = mFrameCount;
 
                 mUnallocatedVbos[itor->vboFlag].push_back( itor->vboIdx );
@@ -587,7 +613,7 @@ namespace Ogre
             while( itor != endt )
             {
                 Vbo &vbo = *itor;
-                if( vbo.freeBlocks.size() == 1u && vbo.sizeBytes == vbo.freeBlocks.back().size )
+                if( vbo.allocator.isEmpty() )
                 {
                     VaoVec::iterator itVao = mVaos.begin();
                     VaoVec::iterator enVao = mVaos.end();
@@ -952,59 +978,41 @@ namespace Ogre
 
         VboVec &vboVec = mVbos[vboFlag];
 
-        VboVec::const_iterator itor = vboVec.begin();
-        VboVec::const_iterator endt = vboVec.end();
+        VboVec::iterator itor = vboVec.begin();
+        VboVec::iterator endt = vboVec.end();
 
-        // clang-format off
-        // Find a suitable VBO that can hold the requested size. We prefer those free
-        // blocks that have a matching stride (the current offset is a multiple of
-        // bytesPerElement) in order to minimize the amount of memory padding.
-        size_t bestVboIdx   = std::numeric_limits<size_t>::max();
-        ptrdiff_t bestBlockIdx = -1;
-        bool foundMatchingStride = false;
-        // clang-format on
+        // Each pool finds a suitable free block in constant time
+        size_t bestVboIdx = std::numeric_limits<size_t>::max();
 
-        while( itor != endt && !foundMatchingStride )
+        while( itor != endt && bestVboIdx == std::numeric_limits<size_t>::max() )
         {
             // First check the allocation can be done inside this Vbo
             if( ( 1u << itor->vkMemoryTypeIdx ) & textureMemTypeBits )
             {
-                BlockVec::const_iterator blockIt = itor->freeBlocks.begin();
-                BlockVec::const_iterator blockEn = itor->freeBlocks.end();
-
-                while( blockIt != blockEn && !foundMatchingStride )
+                const bool wasEmpty = itor->isEmpty();
+                if( itor->allocator.allocate( sizeBytes, alignment, outBufferOffset ) )
                 {
-                    const Block &block = *blockIt;
+                    bestVboIdx = static_cast<size_t>( itor - vboVec.begin() );
 
-                    // Round to next multiple of alignment
-                    size_t newOffset = ( ( block.offset + alignment - 1 ) / alignment ) * alignment;
-                    size_t padding = newOffset - block.offset;
-
-                    if( sizeBytes + padding <= block.size )
+                    if( wasEmpty )
                     {
-                        // clang-format off
-                        bestVboIdx      = static_cast<size_t>( itor - vboVec.begin());
-                        bestBlockIdx    = blockIt - itor->freeBlocks.begin();
-                        // clang-format on
-
-                        if( newOffset == block.offset )
-                            foundMatchingStride = true;
+                        // The pool will no longer be empty, hence unschedule it from destruction
+                        VboIndex vboIndex;
+                        vboIndex.vboFlag = vboFlag;
+                        vboIndex.vboIdx = static_cast<uint32>( bestVboIdx );
+                        OGRE_ASSERT_HIGH( mEmptyVboPools.find( vboIndex ) != mEmptyVboPools.end() &&
+                                          "If the Vbo pool was empty, it should be in mEmptyVboPools" );
+                        mEmptyVboPools.erase( vboIndex );
                     }
-
-                    ++blockIt;
                 }
             }
 
             ++itor;
         }
 
-        if( bestBlockIdx == -1 )
+        if( bestVboIdx == std::numeric_limits<size_t>::max() )
         {
-            // clang-format off
-            bestVboIdx      = vboVec.size();
-            bestBlockIdx    = 0;
-            foundMatchingStride = true;
-            // clang-format on
+            bestVboIdx = vboVec.size();
 
             Vbo newVbo;
 
@@ -1140,7 +1148,7 @@ namespace Ogre
             }
 
             newVbo.sizeBytes = usablePoolSize;
-            newVbo.freeBlocks.push_back( Block( 0, usablePoolSize ) );
+            newVbo.allocator.initialize( usablePoolSize );
             newVbo.dynamicBuffer = 0;
 
             if( vboFlag != CPU_INACCESSIBLE )
@@ -1161,53 +1169,14 @@ namespace Ogre
             {
                 vboVec.push_back( newVbo );
             }
-        }
-        else
-        {
-            Vbo &bestVbo = vboVec[bestVboIdx];
-            if( bestVbo.isEmpty() )
-            {
-                OGRE_ASSERT_HIGH( bestVbo.isAllocated() );
-
-                // The block will no longer be empty, hence no unschedule from destruction
-                VboIndex vboIndex;
-                vboIndex.vboFlag = vboFlag;
-                vboIndex.vboIdx = static_cast<uint32>( bestVboIdx );
-                OGRE_ASSERT_HIGH( mEmptyVboPools.find( vboIndex ) != mEmptyVboPools.end() &&
-                                  "If the Vbo pool was empty, it should be in mEmptyVboPools" );
-                mEmptyVboPools.erase( vboIndex );
-            }
-        }
-
-        // clang-format off
-        Vbo &bestVbo        = vboVec[bestVboIdx];
-        Block &bestBlock    = bestVbo.freeBlocks[static_cast<size_t>(bestBlockIdx)];
-        // clang-format on
 
-        size_t newOffset = ( ( bestBlock.offset + alignment - 1 ) / alignment ) * alignment;
-        size_t padding = newOffset - bestBlock.offset;
-        // clang-format off
-        // Shrink our records about available data.
-        bestBlock.size   -= sizeBytes + padding;
-        bestBlock.offset = newOffset + sizeBytes;
-        // clang-format on
-
-        if( !foundMatchingStride )
-        {
-            // This is a stride changer, record as such.
-            StrideChangerVec::iterator itStride = std::lower_bound( bestVbo.strideChangers.begin(),
-                                                                    bestVbo.strideChangers.end(),  //
-                                                                    newOffset, StrideChanger() );
-            bestVbo.strideChangers.insert( itStride, StrideChanger( newOffset, padding ) );
+            const bool allocated =
+                vboVec[bestVboIdx].allocator.allocate( sizeBytes, alignment, outBufferOffset );
+            OGRE_ASSERT_LOW( allocated && "The new pool can't hold the request?" );
+            OGRE_UNUSED_VAR( allocated );
         }
 
-        if( bestBlock.size == 0u )
-            bestVbo.freeBlocks.erase( bestVbo.freeBlocks.begin() + bestBlockIdx );
-
-        // clang-format off
-        outVboIdx       = bestVboIdx;
-        outBufferOffset = newOffset;
-        // clang-format on
+        outVboIdx = bestVboIdx;
     }
     //-----------------------------------------------------------------------------------
     void VulkanVaoManager::deallocateVbo( size_t vboIdx, size_t bufferOffset, size_t sizeBytes,
@@ -1245,30 +1214,14 @@ namespace Ogre
             }
         }
 
+        // The allocator remembers the size of each range
         Vbo &vbo = mVbos[vboFlag][vboIdx];
-        StrideChangerVec::iterator itStride =
-            std::lower_bound( vbo.strideChangers.begin(), vbo.strideChangers.end(),  //
-                              bufferOffset, StrideChanger() );
-
-        if( itStride != vbo.strideChangers.end() && itStride->offsetAfterPadding == bufferOffset )
-        {
-            // clang-format off
-            bufferOffset    -= itStride->paddedBytes;
-            sizeBytes       += itStride->paddedBytes;
-            // clang-format on
-
-            vbo.strideChangers.erase( itStride );
-        }
-
-        // See if we're contiguous to a free block and make that block grow.
-        vbo.freeBlocks.push_back( Block( bufferOffset, sizeBytes ) );
-        mergeContiguousBlocks( vbo.freeBlocks.end() - 1u, vbo.freeBlocks );
+        vbo.allocator.deallocate( bufferOffset );
 
         if( vbo.isEmpty() )
         {
             // This pool is empty. Schedule for removal
             // We may reuse their memory if more memory is requested before they're actually removed.
-            OGRE_ASSERT_LOW( vbo.strideChangers.empty() );
             vbo.emptyFrame = mFrameCount;
             VboIndex vboIndex;
             vboIndex.vboFlag = vboFlag;
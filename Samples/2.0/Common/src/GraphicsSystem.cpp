@@ -673,9 +673,23 @@ namespace Demo
                     {
                         diskCache.copyFrom( hlms );
 
-                        Ogre::DataStreamPtr diskCacheFile = rwAccessFolderArchive->create(
-                            "hlmsDiskCache" + Ogre::StringConverter::toString( i ) + ".bin" );
-                        diskCache.saveTo( diskCacheFile );
+                        const Ogre::String filename =
+                            "hlmsDiskCache" + Ogre::StringConverter::toString( i ) + ".bin";
+
+                        // Only write the new entries if the file is still valid
+                        bool bAppended = false;
+                        if( rwAccessFolderArchive->exists( filename ) )
+                        {
+                            Ogre::DataStreamPtr diskCacheFile =
+                                rwAccessFolderArchive->open( filename, false );
+                            bAppended = diskCache.appendTo( diskCacheFile );
+                        }
+
+                        if( !bAppended )
+                        {
+                            Ogre::DataStreamPtr diskCacheFile = rwAccessFolderArchive->create( filename );
+                            diskCache.saveTo( diskCacheFile );
+                        }
                     }
                 }
             }
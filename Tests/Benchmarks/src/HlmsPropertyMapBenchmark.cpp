@@ -0,0 +1,100 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Benchmarks.h"
+
+#include "OgreHlms.h"
+#include "OgreHlmsPropertyMap.h"
+#include "OgreTimer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace Ogre;
+
+void hlmsPropertyMapBenchmark()
+{
+    srand( 0 );
+
+    // Typical PBS permutation: ~100 PBS properties of which roughly half are set, plus the base
+    // properties. Templates query all of them (plenty of misses).
+    std::vector<IdString> keys;
+    HlmsPropertyVec propertyVec;
+    for( int i = 0; i < 105; ++i )
+    {
+        char tmpBuffer[32];
+        sprintf( tmpBuffer, "pbs_prop%i", i );
+        keys.push_back( IdString( tmpBuffer ) );
+        if( rand() % 2 )
+            Hlms::setProperty( propertyVec, keys.back(), rand() % 4 );
+    }
+    for( int i = 0; i < 96; ++i )
+    {
+        char tmpBuffer[32];
+        sprintf( tmpBuffer, "hlms_base_prop%i", i );
+        keys.push_back( IdString( tmpBuffer ) );
+        Hlms::setProperty( propertyVec, keys.back(), i );
+    }
+
+    HlmsPropertyMap propertyMap;
+    propertyMap.setProperties( propertyVec );
+
+    const int numIterations = 2000;
+    Timer timer;
+
+    int64 vecSum = 0;
+    timer.reset();
+    for( int i = 0; i < numIterations; ++i )
+    {
+        for( size_t j = 0; j < keys.size(); ++j )
+            vecSum += Hlms::getProperty( propertyVec, keys[j], 0 );
+    }
+    const uint64 vecTime = timer.getMicroseconds();
+
+    int64 mapSum = 0;
+    timer.reset();
+    for( int i = 0; i < numIterations; ++i )
+    {
+        for( size_t j = 0; j < keys.size(); ++j )
+            mapSum += propertyMap.getProperty( keys[j], 0 );
+    }
+    const uint64 mapTime = timer.getMicroseconds();
+
+    // Building the map is paid once per permutation
+    timer.reset();
+    for( int i = 0; i < numIterations; ++i )
+        propertyMap.setProperties( propertyVec );
+    const uint64 buildTime = timer.getMicroseconds();
+
+    printf( "%i x %i lookups over %i properties. HlmsPropertyVec: %i us. "
+            "HlmsPropertyMap: %i us (+%i us building it)%s\n",
+            numIterations, static_cast<int>( keys.size() ), static_cast<int>( propertyVec.size() ),
+            static_cast<int>( vecTime ), static_cast<int>( mapTime ),
+            static_cast<int>( buildTime ), vecSum != mapSum ? ". RESULTS DIFFER!" : "" );
+}
@@ -0,0 +1,150 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Benchmarks.h"
+
+#include "OgreImage2.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgrePlatformInformation.h"
+#include "OgreTextureBox.h"
+#include "OgreTimer.h"
+
+#include <math.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Ogre;
+
+/// Plain per pixel loop for RGBA8 with the bilinear filter's rules (the last column & row
+/// only sample what's left of the 2x2 box inside the image). Same results as
+/// Image2::generateMipmaps, used as baseline.
+static void downsampleReference( const TextureBox &src, TextureBox &dst, bool sRgb )
+{
+    for( uint32 y = 0; y < dst.height; ++y )
+    {
+        const uint32 kEndY = std::min( dst.height - 1u - y, 1u );
+        for( uint32 x = 0; x < dst.width; ++x )
+        {
+            const uint32 kEndX = std::min( dst.width - 1u - x, 1u );
+
+            uint32 accum[4] = { 0, 0, 0, 0 };
+            uint32 divisor = 0;
+            for( uint32 k_y = 0; k_y <= kEndY; ++k_y )
+            {
+                for( uint32 k_x = 0; k_x <= kEndX; ++k_x )
+                {
+                    const uint8 *srcPixel =
+                        reinterpret_cast<const uint8 *>( src.at( x * 2u + k_x, y * 2u + k_y, 0 ) );
+                    for( size_t c = 0; c < 3u; ++c )
+                        accum[c] += sRgb ? srcPixel[c] * srcPixel[c] : srcPixel[c];
+                    accum[3] += srcPixel[3];
+                    ++divisor;
+                }
+            }
+
+            const float invDivisor = 1.0f / static_cast<float>( divisor );
+            uint8 *dstPixel = reinterpret_cast<uint8 *>( dst.at( x, y, 0 ) );
+            for( size_t c = 0; c < 3u; ++c )
+            {
+                const float value = static_cast<float>( accum[c] ) * invDivisor;
+                dstPixel[c] = static_cast<uint8>( ( sRgb ? sqrtf( value ) : value ) + 0.5f );
+            }
+            dstPixel[3] = static_cast<uint8>( ( accum[3] + divisor - 1u ) / divisor );
+        }
+    }
+}
+
+static bool compareMips( const Image2 &a, const Image2 &b )
+{
+    for( uint8 mip = 1u; mip < a.getNumMipmaps(); ++mip )
+    {
+        const TextureBox boxA = a.getData( mip );
+        const TextureBox boxB = b.getData( mip );
+        if( memcmp( boxA.data, boxB.data, boxA.getSizeBytes() ) )
+            return false;
+    }
+    return true;
+}
+
+void imageMipmapBenchmark()
+{
+    srand( 0 );
+
+    const uint32 resolution = 4096u;
+    const uint32 numCores = std::max( PlatformInformation::getNumLogicalCores(), 1u );
+    const uint8 numMipmaps = PixelFormatGpuUtils::getMaxMipmapCount( resolution, resolution );
+
+    for( int sRgb = 0; sRgb < 2; ++sRgb )
+    {
+        const PixelFormatGpu format = sRgb ? PFG_RGBA8_UNORM_SRGB : PFG_RGBA8_UNORM;
+
+        Image2 reference;
+        reference.createEmptyImage( resolution, resolution, 1u, TextureTypes::Type2D, format,
+                                    numMipmaps );
+        {
+            const TextureBox box = reference.getData( 0 );
+            uint8 *data = reinterpret_cast<uint8 *>( box.data );
+            for( size_t i = 0; i < box.getSizeBytes(); ++i )
+                data[i] = static_cast<uint8>( rand() );
+        }
+
+        Timer timer;
+
+        timer.reset();
+        for( uint8 mip = 1u; mip < numMipmaps; ++mip )
+        {
+            TextureBox dst = reference.getData( mip );
+            downsampleReference( reference.getData( mip - 1u ), dst, sRgb != 0 );
+        }
+        const uint64 referenceTime = timer.getMicroseconds();
+
+        uint64 times[2];
+        bool bMatches = true;
+        const uint32 numThreads[2] = { 1u, numCores };
+        for( size_t i = 0; i < 2u; ++i )
+        {
+            Image2 image;
+            image.createEmptyImage( resolution, resolution, 1u, TextureTypes::Type2D, format );
+            memcpy( image.getData( 0 ).data, reference.getData( 0 ).data,
+                    reference.getData( 0 ).getSizeBytes() );
+
+            timer.reset();
+            image.generateMipmaps( sRgb != 0, Image2::FILTER_BILINEAR, numThreads[i] );
+            times[i] = timer.getMicroseconds();
+
+            bMatches &= image.getNumMipmaps() == numMipmaps && compareMips( reference, image );
+        }
+
+        printf( "Image2::generateMipmaps %ux%u %s: reference loop %i us. "
+                "1 thread: %i us. %u threads: %i us%s\n",
+                resolution, resolution, sRgb ? "RGBA8_UNORM_SRGB" : "RGBA8_UNORM",
+                static_cast<int>( referenceTime ), static_cast<int>( times[0] ), numCores,
+                static_cast<int>( times[1] ), bMatches ? "" : ". RESULTS DIFFER!" );
+    }
+}
@@ -0,0 +1,79 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "Benchmarks.h"
+
+#include "OgreLogManager.h"
+
+#include <cstdio>
+#include <cstring>
+
+typedef void ( *BenchmarkFunc )();
+
+struct BenchmarkEntry
+{
+    const char *name;
+    BenchmarkFunc func;
+};
+
+static const BenchmarkEntry c_benchmarks[] = {
+    { "HlmsPropertyMap", hlmsPropertyMapBenchmark },
+    { "ImageMipmap", imageMipmapBenchmark },
+};
+
+/// Usage: Benchmark_Ogre [name]
+/// Runs all benchmarks, or only the one whose name matches
+int main( int argc, char *argv[] )
+{
+    Ogre::LogManager logManager;
+    logManager.createLog( "Benchmark_Ogre.log", true, false, false );
+
+    const char *filter = argc > 1 ? argv[1] : 0;
+
+    bool bFound = false;
+    const size_t numBenchmarks = sizeof( c_benchmarks ) / sizeof( c_benchmarks[0] );
+    for( size_t i = 0; i < numBenchmarks; ++i )
+    {
+        if( !filter || !strcmp( filter, c_benchmarks[i].name ) )
+        {
+            printf( "--- %s\n", c_benchmarks[i].name );
+            c_benchmarks[i].func();
+            bFound = true;
+        }
+    }
+
+    if( !bFound )
+    {
+        printf( "Unknown benchmark '%s'. Available:\n", filter );
+        for( size_t i = 0; i < numBenchmarks; ++i )
+            printf( "    %s\n", c_benchmarks[i].name );
+        return 1;
+    }
+
+    return 0;
+}
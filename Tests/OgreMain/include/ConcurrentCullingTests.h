@@ -0,0 +1,100 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __ConcurrentCullingTests_H__
+#define __ConcurrentCullingTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgrePrerequisites.h"
+
+#include <vector>
+
+class NULLRenderSystemRoot;
+
+class ConcurrentCullingTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(ConcurrentCullingTests);
+    CPPUNIT_TEST(testQueueAndFlush);
+    CPPUNIT_TEST(testClearedEveryFrame);
+    CPPUNIT_TEST(testClearedWithoutSceneGraphUpdate);
+    CPPUNIT_TEST(testMatchesSerial);
+    CPPUNIT_TEST(testFlagsChangedBeforeFlush);
+    CPPUNIT_TEST(testFlagsChangedAfterFlush);
+    CPPUNIT_TEST(testObjectsChangedAfterFlush);
+    CPPUNIT_TEST(testSpatialIndex);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef std::vector<Ogre::MovableObject *> ObjectVec;
+
+    NULLRenderSystemRoot *mRoot;
+    Ogre::SceneManager *mSceneManager;
+    Ogre::Camera *mCamera;
+    /// Cameras culled as shadow caster passes
+    std::vector<Ogre::Camera *> mShadowCameras;
+    Ogre::Viewport *mViewport;
+    Ogre::Viewport *mShadowViewport;
+    /// Bound while culling, as the compositor would
+    Ogre::RenderPassDescriptor *mPassDesc;
+    ObjectVec mObjects;
+
+    void queueFrustum();
+
+    void createObjects(size_t numObjects);
+    void destroyObject(size_t idx);
+    /// Queues the main camera and all shadow cameras
+    void queueAllFrustums();
+    /// Runs _cullPhase01 for the main camera and then every shadow camera, and returns
+    /// what each of them saw, sorted. Uses the pre-culled results if there are any.
+    void cullAll(std::vector<ObjectVec> &outVisibleObjects);
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// Flushing culls exactly the frustums queued since the last flush
+    void testQueueAndFlush();
+    /// Frustums queued (and culled) in one frame must not carry over to the next one
+    void testClearedEveryFrame();
+    /// Same, when the app renders without calling SceneManager::updateSceneGraph
+    void testClearedWithoutSceneGraphUpdate();
+    /// Culling all cameras at once sees the same objects as culling them one by one
+    void testMatchesSerial();
+    /// Objects are culled by _flushPreCullFrustums, thus changes made before it are seen
+    void testFlagsChangedBeforeFlush();
+    /// Changes to visibility flags after _flushPreCullFrustums aren't seen (documented)
+    void testFlagsChangedAfterFlush();
+    /// Creating or destroying objects after _flushPreCullFrustums discards the results
+    void testObjectsChangedAfterFlush();
+    /// Serial and batched culling must see the same objects with the spatial index enabled
+    void testSpatialIndex();
+};
+
+#endif
@@ -48,6 +48,7 @@ class FileSystemArchiveTests : public CppUnit::TestFixture
     CPPUNIT_TEST(testFindFileInfoNonRecursive);
     CPPUNIT_TEST(testFindFileInfoRecursive);
     CPPUNIT_TEST(testFileRead);
+    CPPUNIT_TEST(testFileReadMapped);
     CPPUNIT_TEST(testReadInterleave);
     CPPUNIT_TEST(testCreateAndRemoveFile);
     CPPUNIT_TEST_SUITE_END();
@@ -70,6 +71,7 @@ public:
     void testFindFileInfoNonRecursive();
     void testFindFileInfoRecursive();
     void testFileRead();
+    void testFileReadMapped();
     void testReadInterleave();
     void testCreateAndRemoveFile();
 };
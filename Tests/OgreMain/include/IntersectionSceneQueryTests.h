@@ -0,0 +1,79 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __IntersectionSceneQueryTests_H__
+#define __IntersectionSceneQueryTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgrePrerequisites.h"
+
+class NULLRenderSystemRoot;
+
+class IntersectionSceneQueryTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(IntersectionSceneQueryTests);
+    CPPUNIT_TEST(testCoherentMotion);
+    CPPUNIT_TEST(testReusedSlots);
+    CPPUNIT_TEST(testSweepAxisSwitch);
+    CPPUNIT_TEST(testThreaded);
+    CPPUNIT_TEST_SUITE_END();
+
+    NULLRenderSystemRoot *mRoot;
+    Ogre::SceneManager *mSceneManager;
+    std::vector<Ogre::MovableObject *> mObjects;
+    Ogre::uint32 mRandomSeed;
+
+    Ogre::Real randomReal(Ogre::Real minValue, Ogre::Real maxValue);
+    /// Creates a box of random size at a random position inside the given extents
+    void createObject(const Ogre::Vector3 &extents);
+    void destroyObject(size_t idx);
+    /// Moves every object by a random offset of up to maxOffset units
+    void moveObjects(Ogre::Real maxOffset);
+    /// Moves every object to a random position inside the given extents
+    void scatterObjects(const Ogre::Vector3 &extents);
+    /// Updates the world aabbs, then checks the query against testing every pair
+    void checkAgainstBruteForce(Ogre::IntersectionSceneQuery *query);
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// Executing again after small movements (reusing the previous sorted order) is exact
+    void testCoherentMotion();
+    /// Objects created in the slots of destroyed ones carry stale ranks, which must not matter
+    void testReusedSlots();
+    /// Switching the sweep axis discards the previous order, and results must not change
+    void testSweepAxisSwitch();
+    /// Large scenes sweep in the worker threads with the same results in the same order
+    void testThreaded();
+};
+
+#endif
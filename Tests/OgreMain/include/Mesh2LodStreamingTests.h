@@ -0,0 +1,70 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __Mesh2LodStreamingTests_H__
+#define __Mesh2LodStreamingTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgrePrerequisites.h"
+
+class NULLRenderSystemRoot;
+
+class Mesh2LodStreamingTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(Mesh2LodStreamingTests);
+    CPPUNIT_TEST(testCoarsestStepFirst);
+    CPPUNIT_TEST(testStreamIn);
+    CPPUNIT_TEST(testEvictOverBudget);
+    CPPUNIT_TEST(testMissingFile);
+    CPPUNIT_TEST_SUITE_END();
+
+    NULLRenderSystemRoot *mRoot;
+    Ogre::String mMeshPath;
+
+    /// Exports a mesh with 3 LODs, each with its own vertex buffer, to mMeshPath
+    void exportLodMesh();
+    /// Runs the end of frame work of Root, which streams LODs in & out
+    void endFrame();
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// Only the coarsest LOD gets loaded. The finer ones use its Vao.
+    void testCoarsestStepFirst();
+    /// Requesting a LOD streams in every step up to it
+    void testStreamIn();
+    /// Streamed in LODs get evicted when over budget
+    void testEvictOverBudget();
+    /// Failing to open the file keeps the coarsest LOD, and doesn't retry every frame
+    void testMissingFile();
+};
+
+#endif
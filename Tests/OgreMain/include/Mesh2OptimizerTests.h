@@ -0,0 +1,73 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __Mesh2OptimizerTests_H__
+#define __Mesh2OptimizerTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgrePrerequisites.h"
+
+#include <vector>
+
+class Mesh2OptimizerTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(Mesh2OptimizerTests);
+    CPPUNIT_TEST(testVertexCache);
+    CPPUNIT_TEST(testOverdraw);
+    CPPUNIT_TEST(testOverdrawSortsByPosition);
+    CPPUNIT_TEST(testVertexFetch);
+    CPPUNIT_TEST(testWeldVertices);
+    CPPUNIT_TEST(testClusters);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    size_t mNumVertices;
+    /// XYZ of every vertex of a bumpy grid
+    std::vector<float> mPositions;
+    /// Triangles of the grid, in random order
+    std::vector<Ogre::uint32> mIndices;
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// ACMR must improve and the triangles must remain the same
+    void testVertexCache();
+    /// ACMR must stay within the threshold and the triangles must remain the same
+    void testOverdraw();
+    /// Clusters facing away from the centre of the mesh must be drawn first
+    void testOverdrawSortsByPosition();
+    void testVertexFetch();
+    void testWeldVertices();
+    /// Clusters must cover all triangles, and culling must skip the hidden ones
+    void testClusters();
+};
+
+#endif
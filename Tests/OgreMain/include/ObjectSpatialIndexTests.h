@@ -0,0 +1,76 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ObjectSpatialIndexTests_H__
+#define __ObjectSpatialIndexTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Math/Array/OgreObjectSpatialIndex.h"
+#include "OgrePrerequisites.h"
+
+#include <vector>
+
+class ObjectSpatialIndexTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(ObjectSpatialIndexTests);
+    CPPUNIT_TEST(testQueries);
+    CPPUNIT_TEST(testRefit);
+    CPPUNIT_TEST(testUnusedSlots);
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    size_t mNumObjects;
+    Ogre::ObjectData mObjData;
+    Ogre::ArrayAabb *mWorldAabbs;
+    std::vector<Ogre::Real> mWorldRadius;
+    std::vector<Ogre::MovableObject *> mOwners;
+    /// Every other field of ObjectData points here, they're not used by the index
+    std::vector<Ogre::Real> mUnusedReals;
+    std::vector<Ogre::uint32> mUnusedFlags;
+    std::vector<Ogre::Node *> mUnusedParents;
+
+    void setObject(size_t idx, const Ogre::Aabb &aabb, Ogre::Real radius);
+    Ogre::Aabb getObject(size_t idx) const;
+    /// Checks that every pack with an object hit by the brute force tests is returned by the index
+    void checkQueries(const Ogre::ObjectSpatialIndex &spatialIndex);
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// Every query must return all the packs of the objects that pass it, and skip most others
+    void testQueries();
+    /// Moved objects must be found after refitting
+    void testRefit();
+    /// Slots without an owner must not contribute to the bounds
+    void testUnusedSlots();
+};
+
+#endif
@@ -0,0 +1,64 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __RenderQueueSortTests_H__
+#define __RenderQueueSortTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgreRenderQueue.h"
+
+class RenderQueueSortTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(RenderQueueSortTests);
+    CPPUNIT_TEST(testRadixSort);
+    CPPUNIT_TEST(testMergeSortedRuns);
+    CPPUNIT_TEST(testCoherentSort);
+    CPPUNIT_TEST_SUITE_END();
+
+    typedef Ogre::RenderQueue::QueuedRenderableArray QueuedRenderableArray;
+
+    void generate(QueuedRenderableArray &outQueue, size_t numRenderables, size_t numUniqueHashes);
+    void checkSameAsStableSort(const QueuedRenderableArray &unsorted,
+                               const QueuedRenderableArray &sorted);
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// RenderQueue::_radixSort must produce the same order as std::stable_sort
+    void testRadixSort();
+    /// Merging per-thread sorted runs must produce the same order as std::stable_sort
+    void testMergeSortedRuns();
+    /// RenderQueue::_coherentSort must produce the same order as std::stable_sort every frame
+    void testCoherentSort();
+};
+
+#endif
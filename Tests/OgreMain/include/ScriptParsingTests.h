@@ -0,0 +1,70 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#ifndef __ScriptParsingTests_H__
+#define __ScriptParsingTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgrePrerequisites.h"
+
+class NULLRenderSystemRoot;
+
+class ScriptParsingTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(ScriptParsingTests);
+    CPPUNIT_TEST(testSerial);
+    CPPUNIT_TEST(testParallel);
+    CPPUNIT_TEST(testWithoutPrepareSupport);
+    CPPUNIT_TEST_SUITE_END();
+
+    NULLRenderSystemRoot *mRoot;
+    Ogre::StringVector mScriptPaths;
+
+    /// Parses the test scripts with the given thread count & loader, skipping every
+    /// third script. Returns the listener & loader events, in order.
+    Ogre::StringVector parseScripts(Ogre::uint32 numThreads, bool supportsPrepare,
+                                    size_t &outNumPrepared);
+    /// Checks the events are in the order they'd be in when parsing serially,
+    /// allowing scriptParseStarted to run ahead
+    void checkEventOrder(const Ogre::StringVector &events);
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// With one thread, scripts are opened & parsed exactly like before there were threads
+    void testSerial();
+    /// Batches get prepared in parallel. Skipped scripts are never opened nor prepared.
+    void testParallel();
+    /// Loaders that don't supportsPrepareScript are always parsed serially
+    void testWithoutPrepareSupport();
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#ifndef __SkeletonPoseSharingTests_H__
+#define __SkeletonPoseSharingTests_H__
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "OgrePrerequisites.h"
+
+#include "Animation/OgreSkeletonDef.h"
+
+class NULLRenderSystemRoot;
+
+class SkeletonPoseSharingTests : public CppUnit::TestFixture
+{
+    // CppUnit macros for setting up the test suite
+    CPPUNIT_TEST_SUITE(SkeletonPoseSharingTests);
+    CPPUNIT_TEST(testCopiedPoseMatchesEvaluated);
+    CPPUNIT_TEST(testDifferentPosesNotShared);
+    CPPUNIT_TEST_SUITE_END();
+
+    NULLRenderSystemRoot *mRoot;
+    Ogre::SceneManager *mSceneManager;
+    Ogre::SkeletonDefPtr mSkeletonDef;
+
+    /// Creates an instance with pose sharing enabled, playing "Walk" at the given frame
+    Ogre::SkeletonInstance *createInstance(Ogre::Real frame);
+    /// Evaluates the animations of every instance, sharing poses where allowed
+    void updateAnimations();
+
+public:
+    void setUp();
+    void tearDown();
+
+    /// Instances that copy the pose of another must end up with the pose they would evaluate
+    void testCopiedPoseMatchesEvaluated();
+    /// Instances whose frame, weight or per-bone weights differ must never be merged
+    void testDifferentPosesNotShared();
+};
+
+#endif
@@ -0,0 +1,268 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ArrayDispatchTests.h"
+#include "UnitTestSuite.h"
+
+#include "Animation/OgreSkeletonTrack.h"
+#include "Math/Array/OgreArrayAabb.h"
+#include "Math/Array/OgreArrayDispatch.h"
+#include "Math/Array/OgreBoneTransform.h"
+#include "Math/Array/OgreKfTransformArrayMemoryManager.h"
+#include "Math/Array/OgreMathlib.h"
+#include "OgreCamera.h"
+#include "OgreMovableObject.h"
+#include "OgrePlane.h"
+
+#include <stdlib.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ArrayDispatchTests);
+
+static Real randomReal(Real minValue, Real maxValue)
+{
+    return minValue + (maxValue - minValue) * Real(rand()) / Real(RAND_MAX);
+}
+
+static Vector3 randomVector3(Real minValue, Real maxValue)
+{
+    return Vector3(randomReal(minValue, maxValue), randomReal(minValue, maxValue),
+                   randomReal(minValue, maxValue));
+}
+
+//--------------------------------------------------------------------------
+void ArrayDispatchTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    mOldUseAvx2 = ArrayDispatch::useAvx2();
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void ArrayDispatchTests::tearDown()
+{
+    ArrayDispatch::setAvx2Enabled(mOldUseAvx2);
+}
+//--------------------------------------------------------------------------
+void ArrayDispatchTests::testSetAvx2Enabled()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ArrayDispatch::setAvx2Enabled(false);
+    CPPUNIT_ASSERT(!ArrayDispatch::useAvx2());
+
+    ArrayDispatch::setAvx2Enabled(true);
+    CPPUNIT_ASSERT_EQUAL(ArrayDispatch::isAvx2Supported(), ArrayDispatch::useAvx2());
+
+#if !OGRE_ARRAY_DISPATCH_AVX2
+    CPPUNIT_ASSERT(!ArrayDispatch::isAvx2Supported());
+#endif
+}
+//--------------------------------------------------------------------------
+void ArrayDispatchTests::testKeyFrameBlending()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numKeyFrames = 10u;
+    KfTransformArrayMemoryManager memoryManager(0, numKeyFrames * ARRAY_PACKED_REALS,
+                                                std::numeric_limits<size_t>::max(),
+                                                numKeyFrames * ARRAY_PACKED_REALS);
+    memoryManager.initialize();
+
+    SkeletonTrack track(0, &memoryManager);
+    for (size_t k = 0; k < numKeyFrames; ++k)
+        track.addKeyFrame(Real(k), 1.0f);
+    for (size_t k = 0; k < numKeyFrames; ++k)
+    {
+        for (uint32 slot = 0; slot < ARRAY_PACKED_REALS; ++slot)
+        {
+            Quaternion rot(randomReal(-1.0f, 1.0f), randomReal(-1.0f, 1.0f),
+                           randomReal(-1.0f, 1.0f), randomReal(-1.0f, 1.0f));
+            rot.normalise();
+            track.setKeyFrameTransform(Real(k), slot, randomVector3(-10.0f, 10.0f), rot,
+                                       randomVector3(0.5f, 2.0f));
+        }
+    }
+
+    ArrayVector3 *positions = reinterpret_cast<ArrayVector3 *>(
+        OGRE_MALLOC_SIMD(sizeof(ArrayVector3) * 2u, MEMCATEGORY_ANIMATION));
+    ArrayVector3 *scales = reinterpret_cast<ArrayVector3 *>(
+        OGRE_MALLOC_SIMD(sizeof(ArrayVector3) * 2u, MEMCATEGORY_ANIMATION));
+    ArrayQuaternion *orientations = reinterpret_cast<ArrayQuaternion *>(
+        OGRE_MALLOC_SIMD(sizeof(ArrayQuaternion) * 2u, MEMCATEGORY_ANIMATION));
+    ArrayReal *boneWeights = reinterpret_cast<ArrayReal *>(
+        OGRE_MALLOC_SIMD(sizeof(ArrayReal), MEMCATEGORY_ANIMATION));
+    *boneWeights = Mathlib::SetAll(1.0f);
+
+    const ArrayReal animWeight = Mathlib::SetAll(0.75f);
+    const float frames[] = { 0.0f, 0.3f, 2.5f, 4.99f, 8.0f, 8.75f };
+
+    for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); ++f)
+    {
+        // [0] is blended with the baseline kernel, [1] with the AVX2 one (if supported)
+        for (size_t i = 0; i < 2u; ++i)
+        {
+            ArrayDispatch::setAvx2Enabled(i == 1u);
+
+            positions[i] = ArrayVector3::ZERO;
+            scales[i] = ArrayVector3::UNIT_SCALE;
+            orientations[i] = ArrayQuaternion::IDENTITY;
+
+            BoneTransform boneTransform;
+            boneTransform.mPosition = &positions[i];
+            boneTransform.mScale = &scales[i];
+            boneTransform.mOrientation = &orientations[i];
+            TransformArray boneTransforms;
+            boneTransforms.push_back(boneTransform);
+
+            KeyFrameRigVec::const_iterator lastKnownKeyFrame = track.getKeyFrames().begin();
+            track.applyKeyFrameRigAt(lastKnownKeyFrame, frames[f], animWeight, boneWeights,
+                                     boneTransforms);
+        }
+
+        for (size_t j = 0; j < ARRAY_PACKED_REALS; ++j)
+        {
+            Vector3 pos[2], scale[2];
+            Quaternion rot[2];
+            for (size_t i = 0; i < 2u; ++i)
+            {
+                positions[i].getAsVector3(pos[i], j);
+                scales[i].getAsVector3(scale[i], j);
+                orientations[i].getAsQuaternion(rot[i], j);
+            }
+            // FMA rounds differently; but not by much
+            CPPUNIT_ASSERT(pos[0].positionEquals(pos[1], 1e-4f));
+            CPPUNIT_ASSERT(scale[0].positionEquals(scale[1], 1e-5f));
+            CPPUNIT_ASSERT(Math::Abs(rot[0].Dot(rot[1])) > 1.0f - 1e-5f);
+        }
+    }
+
+    OGRE_FREE_SIMD(boneWeights, MEMCATEGORY_ANIMATION);
+    OGRE_FREE_SIMD(orientations, MEMCATEGORY_ANIMATION);
+    OGRE_FREE_SIMD(scales, MEMCATEGORY_ANIMATION);
+    OGRE_FREE_SIMD(positions, MEMCATEGORY_ANIMATION);
+}
+//--------------------------------------------------------------------------
+void ArrayDispatchTests::testCullFrustum()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numObjects = 1000u;
+    const size_t numPacks = numObjects / ARRAY_PACKED_REALS;
+
+    ArrayAabb *worldAabbs = reinterpret_cast<ArrayAabb *>(
+        OGRE_MALLOC_SIMD(sizeof(ArrayAabb) * numPacks, MEMCATEGORY_SCENE_OBJECTS));
+    std::vector<Real> worldRadius(numObjects, 1.0f);
+    std::vector<Real> upperDistance(numObjects, std::numeric_limits<Real>::max());
+    std::vector<RealAsUint> distanceToCamera(numObjects, 0u);
+    std::vector<uint32> visibilityFlags(numObjects, VisibilityFlags::LAYER_VISIBILITY | 1u);
+    std::vector<MovableObject *> owners(numObjects);
+    std::vector<Aabb> aabbs(numObjects);
+
+    for (size_t i = 0; i < numObjects; ++i)
+    {
+        aabbs[i] = Aabb(randomVector3(-200.0f, 200.0f), randomVector3(0.1f, 20.0f));
+        worldAabbs[i / ARRAY_PACKED_REALS].setFromAabb(aabbs[i], i % ARRAY_PACKED_REALS);
+        // The owners are only pushed into the output, never dereferenced
+        owners[i] = reinterpret_cast<MovableObject *>((i + 1u) * 16u);
+    }
+
+    ObjectData objData;
+    objData.mIndex = 0;
+    objData.mOwner = &owners[0];
+    objData.mWorldAabb = worldAabbs;
+    objData.mWorldRadius = &worldRadius[0];
+    objData.mUpperDistance[0] = &upperDistance[0];
+    objData.mUpperDistance[1] = &upperDistance[0];
+    objData.mDistanceToCamera = &distanceToCamera[0];
+    objData.mVisibilityFlags = &visibilityFlags[0];
+
+    // Six inward-facing planes enclosing a slanted box, so every plane is hit by some objects
+    Plane planes[6];
+    const Vector3 axes[3] = { Vector3(1.0f, 0.2f, 0.0f).normalisedCopy(),
+                              Vector3(0.0f, 1.0f, -0.3f).normalisedCopy(),
+                              Vector3(0.1f, 0.0f, 1.0f).normalisedCopy() };
+    for (size_t i = 0; i < 3u; ++i)
+    {
+        // Plane's constructor negates d
+        planes[i * 2u + 0u] = Plane(axes[i], -100.0f);
+        planes[i * 2u + 1u] = Plane(-axes[i], -100.0f);
+    }
+
+    CullFrustumPreparedData pd;
+    pd.cameraPos.setAll(Vector3::ZERO);
+    pd.cameraDir.setAll(Vector3::NEGATIVE_UNIT_Z);
+    pd.lodCameraPos.setAll(Vector3::ZERO);
+    pd.includeNonCasters = Mathlib::SetAll(VisibilityFlags::LAYER_SHADOW_CASTER);
+    pd.sceneFlags = Mathlib::SetAll(0xFFFFFFFFu);
+    for (size_t i = 0; i < 6u; ++i)
+    {
+        pd.planes[i].planeNormal.setAll(planes[i].normal);
+        pd.planes[i].signFlip.setAll(planes[i].normal);
+        pd.planes[i].signFlip.setToSign();
+        pd.planes[i].planeNegD = Mathlib::SetAll(-planes[i].d);
+    }
+    pd.ignoreRenderingDistance = CastIntToReal(Mathlib::SetAll(0xFFFFFFFFu));
+    pd.cameraSortMode = Camera::SortModeDepth;
+    pd.isShadowMappingCasterPass = false;
+    pd.updateDistanceToCamera = true;
+
+    // Brute force: the AABB's corner furthest along each plane normal must be in front of it
+    std::vector<MovableObject *> expected;
+    for (size_t i = 0; i < numObjects; ++i)
+    {
+        bool visible = true;
+        for (size_t p = 0; p < 6u && visible; ++p)
+        {
+            const Vector3 &n = planes[p].normal;
+            const Vector3 corner =
+                aabbs[i].mCenter + aabbs[i].mHalfSize * Vector3(n.x >= 0 ? 1.0f : -1.0f,
+                                                                n.y >= 0 ? 1.0f : -1.0f,
+                                                                n.z >= 0 ? 1.0f : -1.0f);
+            visible = n.dotProduct(corner) + planes[p].d > 0;
+        }
+        if (visible)
+            expected.push_back(owners[i]);
+    }
+    CPPUNIT_ASSERT(!expected.empty() && expected.size() < numObjects);
+
+    for (size_t i = 0; i < 2u; ++i)
+    {
+        ArrayDispatch::setAvx2Enabled(i == 1u);
+
+        MovableObject::MovableObjectArray culledObjects;
+        MovableObject::cullFrustum(numObjects, objData, 0, culledObjects, pd);
+
+        CPPUNIT_ASSERT_EQUAL(expected.size(), culledObjects.size());
+        for (size_t j = 0; j < expected.size(); ++j)
+            CPPUNIT_ASSERT_EQUAL(expected[j], culledObjects[j]);
+    }
+
+    OGRE_FREE_SIMD(worldAabbs, MEMCATEGORY_SCENE_OBJECTS);
+}
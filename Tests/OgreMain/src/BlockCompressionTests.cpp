@@ -0,0 +1,222 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "BlockCompressionTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreBlockCompression.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureBox.h"
+
+#include <math.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(BlockCompressionTests);
+
+/// Returns the PSNR in dB of the first numChannels channels of two RGBA8 images
+static double computePsnr( const uint8 *a, const uint8 *b, size_t numPixels, size_t numChannels )
+{
+    double sqError = 0;
+    for( size_t i = 0; i < numPixels; ++i )
+    {
+        for( size_t c = 0; c < numChannels; ++c )
+        {
+            const double diff = double( a[i * 4u + c] ) - double( b[i * 4u + c] );
+            sqError += diff * diff;
+        }
+    }
+    if( sqError == 0 )
+        return 99.0;
+    const double mse = sqError / double( numPixels * numChannels );
+    return 10.0 * log10( 255.0 * 255.0 / mse );
+}
+//--------------------------------------------------------------------------
+void BlockCompressionTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void BlockCompressionTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void BlockCompressionTests::testDecodeKnownBlocks()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint8 rgba[64];
+
+    // BC1: c0 = red, c1 = blue (c0 > c1, 4 colours). Rows use indices 0, 1, 2, 3
+    const uint8 bc1Block[8] = { 0x00, 0xF8, 0x1F, 0x00, 0x00, 0x55, 0xAA, 0xFF };
+    BlockCompression::decodeBlock( bc1Block, PFG_BC1_UNORM, rgba );
+    const uint8 bc1Expected[4][4] = {
+        { 255, 0, 0, 255 }, { 0, 0, 255, 255 }, { 170, 0, 85, 255 }, { 85, 0, 170, 255 }
+    };
+    for( size_t y = 0; y < 4u; ++y )
+    {
+        for( size_t x = 0; x < 4u; ++x )
+            CPPUNIT_ASSERT( memcmp( rgba + ( y * 4u + x ) * 4u, bc1Expected[y], 4u ) == 0 );
+    }
+
+    // BC1: c0 <= c1 switches to 3 colours + transparent black. All pixels use index 3
+    const uint8 bc1AlphaBlock[8] = { 0x1F, 0x00, 0x00, 0xF8, 0xFF, 0xFF, 0xFF, 0xFF };
+    BlockCompression::decodeBlock( bc1AlphaBlock, PFG_BC1_UNORM, rgba );
+    for( size_t i = 0; i < 64u; ++i )
+        CPPUNIT_ASSERT_EQUAL( (int)0, (int)rgba[i] );
+
+    // ETC1 individual mode, flip = 0. Left base = 0x88, right base = 0x44 (4-bit 8 & 4),
+    // table 0 (2, 8) on both sides. All pixels use index 0 (+2)
+    const uint8 etcBlock[8] = { 0x84, 0x84, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    BlockCompression::decodeBlock( etcBlock, PFG_ETC1_RGB8_UNORM, rgba );
+    for( size_t y = 0; y < 4u; ++y )
+    {
+        for( size_t x = 0; x < 4u; ++x )
+        {
+            const uint8 *pixel = rgba + ( y * 4u + x ) * 4u;
+            const int expected = x < 2u ? 0x88 + 2 : 0x44 + 2;
+            CPPUNIT_ASSERT_EQUAL( expected, (int)pixel[0] );
+            CPPUNIT_ASSERT_EQUAL( expected, (int)pixel[1] );
+            CPPUNIT_ASSERT_EQUAL( expected, (int)pixel[2] );
+            CPPUNIT_ASSERT_EQUAL( 255, (int)pixel[3] );
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void BlockCompressionTests::testSolidColours()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    uint8 src[64];
+    uint8 dst[64];
+    uint8 block[16];
+
+    for( int i = 0; i < 100; ++i )
+    {
+        const uint8 colour[4] = { uint8( rand() % 256 ), uint8( rand() % 256 ), uint8( rand() % 256 ),
+                                  uint8( rand() % 256 ) };
+        for( size_t j = 0; j < 16u; ++j )
+            memcpy( src + j * 4u, colour, 4u );
+
+        BlockCompression::encodeBlock( src, PFG_BC7_UNORM, block );
+        BlockCompression::decodeBlock( block, PFG_BC7_UNORM, dst );
+        CPPUNIT_ASSERT( memcmp( src, dst, sizeof( src ) ) == 0 );
+
+        BlockCompression::encodeBlock( src, PFG_BC4_UNORM, block );
+        BlockCompression::decodeBlock( block, PFG_BC4_UNORM, dst );
+        for( size_t j = 0; j < 16u; ++j )
+            CPPUNIT_ASSERT_EQUAL( (int)colour[0], (int)dst[j * 4u] );
+    }
+}
+//--------------------------------------------------------------------------
+void BlockCompressionTests::testRoundTripQuality()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    struct FormatTest
+    {
+        PixelFormatGpu format;
+        size_t numChannels;
+        double minPsnr;
+    };
+
+    const FormatTest formats[] = {
+        { PFG_BC1_UNORM, 3u, 30.0 },         { PFG_BC2_UNORM, 4u, 30.0 },
+        { PFG_BC3_UNORM, 4u, 30.0 },         { PFG_BC4_UNORM, 1u, 45.0 },
+        { PFG_BC5_UNORM, 2u, 44.0 },         { PFG_BC7_UNORM, 4u, 32.0 },
+        { PFG_ETC1_RGB8_UNORM, 3u, 30.0 },   { PFG_ETC2_RGBA8_UNORM, 4u, 30.0 },
+        { PFG_EAC_R11_UNORM, 1u, 45.0 },     { PFG_EAC_R11G11_UNORM, 2u, 45.0 },
+    };
+
+    // Not a multiple of the block size, to exercise the padding
+    const uint32 width = 30u;
+    const uint32 height = 18u;
+
+    std::vector<uint8> srcData( width * height * 4u );
+    for( uint32 y = 0; y < height; ++y )
+    {
+        for( uint32 x = 0; x < width; ++x )
+        {
+            uint8 *pixel = &srcData[( y * width + x ) * 4u];
+            pixel[0] = uint8( x * 8u );
+            pixel[1] = uint8( y * 12u );
+            pixel[2] = uint8( 128u + ( rand() % 8 ) );
+            // Keep alpha >= 128 so BC1 doesn't switch to punch-through alpha
+            pixel[3] = uint8( 255u - x * 2u - y * 2u );
+        }
+    }
+
+    TextureBox srcBox( width, height, 1u, 1u, 4u, width * 4u, width * height * 4u );
+    srcBox.data = &srcData[0];
+
+    std::vector<uint8> resultData( srcData.size() );
+    TextureBox resultBox = srcBox;
+    resultBox.data = &resultData[0];
+
+    for( size_t i = 0; i < sizeof( formats ) / sizeof( formats[0] ); ++i )
+    {
+        const PixelFormatGpu format = formats[i].format;
+        CPPUNIT_ASSERT( BlockCompression::canEncode( format ) );
+
+        std::vector<uint8> compressed(
+            PixelFormatGpuUtils::getSizeBytes( width, height, 1u, 1u, format, 1u ) );
+        TextureBox compressedBox(
+            width, height, 1u, 1u, 0u,
+            (uint32)PixelFormatGpuUtils::getSizeBytes( width, 1u, 1u, 1u, format, 1u ),
+            compressed.size() );
+        compressedBox.setCompressedPixelFormat( format );
+        compressedBox.data = &compressed[0];
+
+        PixelFormatGpuUtils::bulkPixelConversion( srcBox, PFG_RGBA8_UNORM, compressedBox, format );
+        PixelFormatGpuUtils::bulkPixelConversion( compressedBox, format, resultBox, PFG_RGBA8_UNORM );
+
+        const double psnr = computePsnr( &srcData[0], &resultData[0], width * height,
+                                         formats[i].numChannels );
+        CPPUNIT_ASSERT_MESSAGE( PixelFormatGpuUtils::toString( format ), psnr >= formats[i].minPsnr );
+    }
+
+    // Transcoding between two compressed formats
+    const size_t bcSizeBytes =
+        PixelFormatGpuUtils::getSizeBytes( width, height, 1u, 1u, PFG_BC7_UNORM, 1u );
+    std::vector<uint8> bc7( bcSizeBytes );
+    std::vector<uint8> bc3( bcSizeBytes );
+    TextureBox bc7Box( width, height, 1u, 1u, 0u,
+                       (uint32)PixelFormatGpuUtils::getSizeBytes( width, 1u, 1u, 1u, PFG_BC7_UNORM, 1u ),
+                       bcSizeBytes );
+    bc7Box.setCompressedPixelFormat( PFG_BC7_UNORM );
+    bc7Box.data = &bc7[0];
+    TextureBox bc3Box = bc7Box;
+    bc3Box.setCompressedPixelFormat( PFG_BC3_UNORM );
+    bc3Box.data = &bc3[0];
+
+    PixelFormatGpuUtils::bulkPixelConversion( srcBox, PFG_RGBA8_UNORM, bc7Box, PFG_BC7_UNORM );
+    PixelFormatGpuUtils::bulkPixelConversion( bc7Box, PFG_BC7_UNORM, bc3Box, PFG_BC3_UNORM );
+    PixelFormatGpuUtils::bulkPixelConversion( bc3Box, PFG_BC3_UNORM, resultBox, PFG_RGBA8_UNORM );
+    CPPUNIT_ASSERT( computePsnr( &srcData[0], &resultData[0], width * height, 4u ) >= 28.0 );
+}
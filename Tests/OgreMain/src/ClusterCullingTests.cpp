@@ -0,0 +1,220 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ClusterCullingTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "OgreFileSystem.h"
+#include "OgreHlms.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsManager.h"
+#include "OgreItem.h"
+#include "OgreMesh2.h"
+#include "OgreMeshManager2.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSubItem.h"
+#include "OgreSubMesh2.h"
+#include "Vao/OgreVaoManager.h"
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+#    include "macUtils.h"
+#endif
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ClusterCullingTests);
+
+namespace
+{
+    /// Items need a default datablock. This Hlms provides it without compiling anything
+    class ClusterCullingHlms : public Hlms
+    {
+    protected:
+        void setupRootLayout(RootLayout &rootLayout, size_t tid) override {}
+        HlmsDatablock *createDatablockImpl(IdString datablockName, const HlmsMacroblock *macroblock,
+                                           const HlmsBlendblock *blendblock,
+                                           const HlmsParamVec &paramVec) override
+        {
+            return OGRE_NEW HlmsDatablock(datablockName, this, macroblock, blendblock, paramVec);
+        }
+        uint32 fillBuffersFor(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                              bool casterPass, uint32 lastCacheHash,
+                              uint32 lastTextureHash) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV1(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                bool casterPass, uint32 lastCacheHash,
+                                CommandBuffer *commandBuffer) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV2(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                bool casterPass, uint32 lastCacheHash,
+                                CommandBuffer *commandBuffer) override
+        {
+            return 0;
+        }
+
+    public:
+        ClusterCullingHlms(Archive *dataFolder) : Hlms(HLMS_PBS, "pbs", dataFolder, 0) {}
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ClusterCullingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+    const String hlmsPath = macBundlePath() + "/Contents/Resources/Media/Hlms";
+#elif OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+    const String hlmsPath = "../../Samples/Media/Hlms";
+#else
+    const String hlmsPath = "./Samples/Media/Hlms";
+#endif
+
+    mRoot = new NULLRenderSystemRoot();
+
+    // Hlms refuses to be created without a folder with templates
+    mDataFolder = OGRE_NEW FileSystemArchive(hlmsPath + "/Pbs/GLSL", "FileSystem", true);
+    mDataFolder->load();
+    mRoot->getRoot()->getHlmsManager()->registerHlms(OGRE_NEW ClusterCullingHlms(mDataFolder));
+
+    mSceneManager = mRoot->getRoot()->createSceneManager(ST_GENERIC, 1u);
+}
+//--------------------------------------------------------------------------
+void ClusterCullingTests::tearDown()
+{
+    delete mRoot;
+    mRoot = 0;
+    mSceneManager = 0;
+    OGRE_DELETE mDataFolder;
+    mDataFolder = 0;
+}
+//--------------------------------------------------------------------------
+MeshPtr ClusterCullingTests::createGridMesh(const String &name, uint32 gridSize)
+{
+    VaoManager *vaoManager = mRoot->getVaoManager();
+
+    const uint32 numVertices = (gridSize + 1u) * (gridSize + 1u);
+    float *vertices = reinterpret_cast<float *>(
+        OGRE_MALLOC_SIMD(numVertices * 3u * sizeof(float), MEMCATEGORY_GEOMETRY));
+    for (uint32 y = 0; y <= gridSize; ++y)
+    {
+        for (uint32 x = 0; x <= gridSize; ++x)
+        {
+            float *vertex = vertices + (y * (gridSize + 1u) + x) * 3u;
+            vertex[0] = float(x);
+            vertex[1] = float(y);
+            vertex[2] = 0.0f;
+        }
+    }
+
+    const uint32 numIndices = gridSize * gridSize * 6u;
+    uint16 *indices = reinterpret_cast<uint16 *>(
+        OGRE_MALLOC_SIMD(numIndices * sizeof(uint16), MEMCATEGORY_GEOMETRY));
+    for (uint32 quad = 0; quad < gridSize * gridSize; ++quad)
+    {
+        const uint16 v0 = static_cast<uint16>((quad / gridSize) * (gridSize + 1u) + quad % gridSize);
+        const uint16 v2 = static_cast<uint16>(v0 + gridSize + 1u);
+        const uint16 quadIndices[6] = { v0, v2, static_cast<uint16>(v0 + 1u),
+                                        static_cast<uint16>(v0 + 1u), v2,
+                                        static_cast<uint16>(v2 + 1u) };
+        memcpy(indices + quad * 6u, quadIndices, sizeof(quadIndices));
+    }
+
+    VertexElement2Vec vertexElements;
+    vertexElements.push_back(VertexElement2(VET_FLOAT3, VES_POSITION));
+    VertexBufferPackedVec vertexBuffers;
+    vertexBuffers.push_back(vaoManager->createVertexBuffer(vertexElements, numVertices,
+                                                           BT_IMMUTABLE, vertices, true));
+    IndexBufferPacked *indexBuffer = vaoManager->createIndexBuffer(
+        IndexBufferPacked::IT_16BIT, numIndices, BT_IMMUTABLE, indices, true);
+
+    MeshPtr mesh = MeshManager::getSingleton().createManual(
+        name, ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    SubMesh *subMesh = mesh->createSubMesh();
+    subMesh->mVao[VpNormal].push_back(
+        vaoManager->createVertexArrayObject(vertexBuffers, indexBuffer, OT_TRIANGLE_LIST));
+    subMesh->mVao[VpShadow].push_back(subMesh->mVao[VpNormal][0]);
+
+    const float halfSize = float(gridSize) * 0.5f;
+    mesh->_setBounds(Aabb(Vector3(halfSize, halfSize, 0.0f), Vector3(halfSize, halfSize, 0.0f)));
+    mesh->_setBoundingSphereRadius(halfSize * 1.5f);
+
+    subMesh->buildClusters(128u);
+
+    return mesh;
+}
+//--------------------------------------------------------------------------
+void ClusterCullingTests::testStaticItem()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // 32x32 quads = 2048 triangles = 16 clusters
+    MeshPtr mesh = createGridMesh("ClusterCullingTests Static", 32u);
+    CPPUNIT_ASSERT_EQUAL((size_t)16u, mesh->getSubMesh(0)->mClusters[0].size());
+    // Every other cluster visible: 8 ranges, the first one replaces the regular draw
+    CPPUNIT_ASSERT_EQUAL((uint32)7u, mesh->getSubMesh(0)->getMaxExtraClusterDraws());
+
+    Item *item = mSceneManager->createItem(mesh);
+    SubItem *subItem = item->getSubItem(0);
+    CPPUNIT_ASSERT(!subItem->hasSkeletonAnimation());
+    CPPUNIT_ASSERT(subItem->getMeshClusters(0) == &mesh->getSubMesh(0)->mClusters[0]);
+    CPPUNIT_ASSERT(subItem->getMeshClusters(1) == 0);
+    CPPUNIT_ASSERT_EQUAL((uint32)7u, subItem->getMaxExtraClusterDraws());
+
+    mSceneManager->destroyItem(item);
+    MeshManager::getSingleton().remove(mesh);
+}
+//--------------------------------------------------------------------------
+void ClusterCullingTests::testAnimatedItem()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr mesh = createGridMesh("ClusterCullingTests Animated", 32u);
+    // Skinned: the vertices follow the bones, away from the clusters' bind pose bounds
+    mesh->getSubMesh(0)->mBlendIndexToBoneIndexMap.push_back(0u);
+    CPPUNIT_ASSERT(!mesh->getSubMesh(0)->mClusters[0].empty());
+
+    Item *item = mSceneManager->createItem(mesh);
+    SubItem *subItem = item->getSubItem(0);
+    CPPUNIT_ASSERT(subItem->hasSkeletonAnimation());
+
+    // Without clusters, RenderQueue draws the whole SubItem (it's never partially culled),
+    // and doesn't reserve indirect draws for it
+    CPPUNIT_ASSERT(subItem->getMeshClusters(0) == 0);
+    CPPUNIT_ASSERT_EQUAL((uint32)0u, subItem->getMaxExtraClusterDraws());
+
+    mSceneManager->destroyItem(item);
+    MeshManager::getSingleton().remove(mesh);
+}
@@ -0,0 +1,425 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "ConcurrentCullingTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "OgreCamera.h"
+#include "OgreMovableObject.h"
+#include "OgreRenderPassDescriptor.h"
+#include "OgreRenderSystem.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+#include "OgreStringConverter.h"
+#include "OgreViewport.h"
+#include "OgreWindow.h"
+
+#include <algorithm>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ConcurrentCullingTests);
+
+namespace
+{
+    /// RenderQueue::V1_FAST by default, thus the culling results stay in
+    /// SceneManager::_getVisibleObjects instead of going to the RenderQueue.
+    /// Objects are spread over two of them.
+    const uint8 c_renderQueueId = 100u;
+
+    class CullBox : public MovableObject
+    {
+    public:
+        CullBox(SceneManager *sceneManager, uint8 renderQueueId) :
+            MovableObject(Id::generateNewId<MovableObject>(),
+                          &sceneManager->_getEntityMemoryManager(SCENE_DYNAMIC), sceneManager,
+                          renderQueueId)
+        {
+            setLocalAabb(Aabb(Vector3::ZERO, Vector3(1.5f)));
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType = "CullBox";
+            return movableType;
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = new NULLRenderSystemRoot();
+    mSceneManager = mRoot->getRoot()->createSceneManager(ST_GENERIC, 4u);
+    mCamera = mSceneManager->createCamera("ConcurrentCullingTests");
+    mSceneManager->setConcurrentCullingEnabled(true);
+
+    mCamera->setNearClipDistance(0.1f);
+    mCamera->setFarClipDistance(100.0f);
+    mCamera->setPosition(0, 0, 60);
+    mCamera->lookAt(0, 0, 0);
+
+    // Like a shadow node with 3 splits/lights seeing the scene from different sides
+    const Vector3 shadowCameraPositions[3] = { Vector3(60, 0, 0), Vector3(5, 60, 5),
+                                               Vector3(-40, -40, -40) };
+    for (size_t i = 0; i < 3u; ++i)
+    {
+        Camera *camera = mSceneManager->createCamera("ConcurrentCullingTests/Shadow" +
+                                                     StringConverter::toString(i));
+        camera->setNearClipDistance(0.1f);
+        camera->setFarClipDistance(120.0f);
+        camera->setPosition(shadowCameraPositions[i]);
+        camera->lookAt(0, 0, 0);
+        mShadowCameras.push_back(camera);
+    }
+
+    mViewport = new Viewport();
+    mViewport->_setVisibilityMask(0xFFFFFFFF & ~VisibilityFlags::LAYER_SHADOW_CASTER, 0xFFFFFFFF);
+    mShadowViewport = new Viewport();
+    mShadowViewport->_setVisibilityMask(0xFFFFFFFF, 0xFFFFFFFF);
+
+    mCamera->_notifyViewport(mViewport);
+    for (size_t i = 0; i < mShadowCameras.size(); ++i)
+        mShadowCameras[i]->_notifyViewport(mShadowViewport);
+
+    mPassDesc = mRoot->getRenderSystem()->createRenderPassDescriptor();
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::tearDown()
+{
+    while (!mObjects.empty())
+        destroyObject(mObjects.size() - 1u);
+
+    mRoot->getRenderSystem()->destroyRenderPassDescriptor(mPassDesc);
+    mPassDesc = 0;
+
+    delete mRoot;
+    mRoot = 0;
+    mSceneManager = 0;
+    mCamera = 0;
+    mShadowCameras.clear();
+
+    delete mViewport;
+    mViewport = 0;
+    delete mShadowViewport;
+    mShadowViewport = 0;
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::createObjects(size_t numObjects)
+{
+    for (size_t i = 0; i < numObjects; ++i)
+    {
+        // Deterministic scatter in [-50; 50)
+        const size_t idx = mObjects.size();
+        const uint8 renderQueueId = idx % 3u == 2u ? c_renderQueueId + 1u : c_renderQueueId;
+        MovableObject *object = new CullBox(mSceneManager, renderQueueId);
+
+        SceneNode *sceneNode = mSceneManager->getRootSceneNode()->createChildSceneNode();
+        sceneNode->setPosition(Real((idx * 37u) % 100u) - 50.0f, Real((idx * 59u) % 100u) - 50.0f,
+                               Real((idx * 83u) % 100u) - 50.0f);
+        sceneNode->attachObject(object);
+
+        if (idx % 5u == 1u)
+            object->setCastShadows(false);
+        if (idx % 7u == 3u)
+            object->setVisible(false);
+
+        mObjects.push_back(object);
+    }
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::destroyObject(size_t idx)
+{
+    MovableObject *object = mObjects[idx];
+    SceneNode *sceneNode = object->getParentSceneNode();
+    delete object;
+    mSceneManager->destroySceneNode(sceneNode);
+
+    mObjects[idx] = mObjects.back();
+    mObjects.pop_back();
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::queueAllFrustums()
+{
+    mSceneManager->_setCurrentRenderStage(SceneManager::IRS_NONE);
+    mSceneManager->_queuePreCullFrustum(mCamera, mCamera, 0u, 255u,
+                                        mViewport->getVisibilityMask());
+
+    mSceneManager->_setCurrentRenderStage(SceneManager::IRS_RENDER_TO_TEXTURE);
+    for (size_t i = 0; i < mShadowCameras.size(); ++i)
+    {
+        mSceneManager->_queuePreCullFrustum(mShadowCameras[i], mCamera, 0u, 255u,
+                                            mShadowViewport->getVisibilityMask());
+    }
+    mSceneManager->_setCurrentRenderStage(SceneManager::IRS_NONE);
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::cullAll(std::vector<ObjectVec> &outVisibleObjects)
+{
+    outVisibleObjects.clear();
+    outVisibleObjects.resize(1u + mShadowCameras.size());
+
+    // Preparing the Hlms pass needs a bound render target, as the compositor would do
+    const Vector4 viewportSize(0, 0, 1, 1);
+    RenderSystem *renderSystem = mRoot->getRenderSystem();
+    renderSystem->beginRenderPassDescriptor(mPassDesc, mRoot->getWindow()->getTexture(), 0u,
+                                            &viewportSize, &viewportSize, 1u, false, false);
+
+    for (size_t i = 0; i < outVisibleObjects.size(); ++i)
+    {
+        Camera *camera = i == 0u ? mCamera : mShadowCameras[i - 1u];
+        mSceneManager->_setCurrentRenderStage(i == 0u ? SceneManager::IRS_NONE
+                                                      : SceneManager::IRS_RENDER_TO_TEXTURE);
+        mSceneManager->_cullPhase01(camera, camera, mCamera, 0u, 255u, false);
+
+        const VisibleObjectsPerThreadArray &visibleObjects = mSceneManager->_getVisibleObjects();
+        for (size_t j = 0; j < visibleObjects.size(); ++j)
+        {
+            for (size_t rqId = c_renderQueueId; rqId < visibleObjects[j].size() &&
+                                                rqId <= c_renderQueueId + 1u; ++rqId)
+            {
+                const MovableObject::MovableObjectArray &objs = visibleObjects[j][rqId];
+                outVisibleObjects[i].insert(outVisibleObjects[i].end(), objs.begin(), objs.end());
+            }
+        }
+        std::sort(outVisibleObjects[i].begin(), outVisibleObjects[i].end());
+    }
+    mSceneManager->_setCurrentRenderStage(SceneManager::IRS_NONE);
+    renderSystem->endRenderPassDescriptor();
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::queueFrustum()
+{
+    mSceneManager->_queuePreCullFrustum(mCamera, mCamera, 0u, 255u, 0xFFFFFFFF);
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testQueueAndFlush()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    mSceneManager->setConcurrentCullingEnabled(false);
+    queueFrustum();
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPreCulledFrustums());
+
+    mSceneManager->setConcurrentCullingEnabled(true);
+    queueFrustum();
+    queueFrustum();
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mSceneManager->_getNumPreCulledFrustums());
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mSceneManager->_getNumPendingPreCullFrustums());
+
+    mSceneManager->_flushPreCullFrustums();
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, mSceneManager->_getNumPreCulledFrustums());
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPendingPreCullFrustums());
+
+    // Only the new one is pending
+    queueFrustum();
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, mSceneManager->_getNumPreCulledFrustums());
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, mSceneManager->_getNumPendingPreCullFrustums());
+    mSceneManager->_flushPreCullFrustums();
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPendingPreCullFrustums());
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testClearedEveryFrame()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    for (size_t frame = 0; frame < 3u; ++frame)
+    {
+        // Queued and culled
+        queueFrustum();
+        mSceneManager->_flushPreCullFrustums();
+        // Queued but never culled
+        queueFrustum();
+        CPPUNIT_ASSERT_EQUAL((size_t)2u, mSceneManager->_getNumPreCulledFrustums());
+        CPPUNIT_ASSERT_EQUAL((size_t)1u, mSceneManager->_getNumPendingPreCullFrustums());
+
+        mRoot->getRoot()->renderOneFrame();
+
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPreCulledFrustums());
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPendingPreCullFrustums());
+    }
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testClearedWithoutSceneGraphUpdate()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    for (size_t frame = 0; frame < 3u; ++frame)
+    {
+        queueFrustum();
+        mSceneManager->_flushPreCullFrustums();
+        queueFrustum();
+
+        // The frame ends without going through Root::renderOneFrame (thus no
+        // updateSceneGraph). The NULL Window can't render a workspace, so
+        // notify what the RenderQueue & VaoManager would.
+        mRoot->getRoot()->_notifyRenderingFrameStarted();
+        mRoot->getRoot()->_renderingFrameEnded();
+
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPreCulledFrustums());
+        CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getNumPendingPreCullFrustums());
+    }
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testMatchesSerial()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createObjects(300u);
+    mSceneManager->updateSceneGraph();
+
+    std::vector<ObjectVec> serial;
+    cullAll(serial);
+
+    queueAllFrustums();
+    mSceneManager->_flushPreCullFrustums();
+    std::vector<ObjectVec> batched;
+    cullAll(batched);
+
+    for (size_t i = 0; i < serial.size(); ++i)
+    {
+        // Make sure the scene actually tests something
+        CPPUNIT_ASSERT(!serial[i].empty());
+        CPPUNIT_ASSERT(serial[i].size() < mObjects.size());
+        CPPUNIT_ASSERT(serial[i] == batched[i]);
+    }
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testFlagsChangedBeforeFlush()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createObjects(300u);
+    mSceneManager->updateSceneGraph();
+
+    queueAllFrustums();
+    for (size_t i = 0; i < mObjects.size(); i += 4u)
+    {
+        mObjects[i]->setVisible(!mObjects[i]->getVisible());
+        mObjects[i]->setCastShadows(!mObjects[i]->getCastShadows());
+    }
+    mSceneManager->_flushPreCullFrustums();
+
+    std::vector<ObjectVec> batched;
+    cullAll(batched);
+    // Nothing is queued anymore; this culls again
+    std::vector<ObjectVec> serial;
+    cullAll(serial);
+
+    for (size_t i = 0; i < serial.size(); ++i)
+        CPPUNIT_ASSERT(serial[i] == batched[i]);
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testFlagsChangedAfterFlush()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createObjects(300u);
+    mSceneManager->updateSceneGraph();
+
+    std::vector<ObjectVec> before;
+    cullAll(before);
+
+    queueAllFrustums();
+    mSceneManager->_flushPreCullFrustums();
+    for (size_t i = 0; i < mObjects.size(); ++i)
+        mObjects[i]->setVisible(false);
+
+    // See SceneManager::setConcurrentCullingEnabled: the results culled by the flush are used
+    std::vector<ObjectVec> batched;
+    cullAll(batched);
+    for (size_t i = 0; i < before.size(); ++i)
+        CPPUNIT_ASSERT(before[i] == batched[i]);
+
+    // Culling again sees the change
+    std::vector<ObjectVec> serial;
+    cullAll(serial);
+    for (size_t i = 0; i < serial.size(); ++i)
+        CPPUNIT_ASSERT(serial[i].empty());
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testObjectsChangedAfterFlush()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createObjects(300u);
+    mSceneManager->updateSceneGraph();
+
+    queueAllFrustums();
+    mSceneManager->_flushPreCullFrustums();
+
+    // Destroyed objects would be dangling pointers in the pre-culled results
+    for (size_t i = 0; i < 20u; ++i)
+        destroyObject(i * 7u);
+    createObjects(10u);
+
+    std::vector<ObjectVec> batched;
+    cullAll(batched);
+    std::vector<ObjectVec> serial;
+    cullAll(serial);
+
+    for (size_t i = 0; i < serial.size(); ++i)
+        CPPUNIT_ASSERT(serial[i] == batched[i]);
+}
+//--------------------------------------------------------------------------
+void ConcurrentCullingTests::testSpatialIndex()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    createObjects(300u);
+    mSceneManager->updateSceneGraph();
+
+    std::vector<ObjectVec> reference;
+    cullAll(reference);
+
+    ObjectMemoryManager &memoryManager = mSceneManager->_getEntityMemoryManager(SCENE_DYNAMIC);
+    memoryManager.setSpatialIndexEnabled(true);
+    mSceneManager->updateSceneGraph();
+    CPPUNIT_ASSERT(memoryManager.getSpatialIndex(c_renderQueueId));
+    CPPUNIT_ASSERT(memoryManager.getSpatialIndex(c_renderQueueId + 1u));
+
+    // Only some packs of each render queue survive the index
+    std::vector<ObjectVec> serial;
+    cullAll(serial);
+
+    queueAllFrustums();
+    mSceneManager->_flushPreCullFrustums();
+    std::vector<ObjectVec> batched;
+    cullAll(batched);
+
+    for (size_t i = 0; i < reference.size(); ++i)
+    {
+        CPPUNIT_ASSERT(reference[i] == serial[i]);
+        CPPUNIT_ASSERT(reference[i] == batched[i]);
+    }
+}
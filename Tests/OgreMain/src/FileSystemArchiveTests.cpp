@@ -298,6 +298,33 @@ void FileSystemArchiveTests::testFileRead()
     CPPUNIT_ASSERT(stream->eof());
 }
 //--------------------------------------------------------------------------
+void FileSystemArchiveTests::testFileReadMapped()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FileSystemArchive arch(mTestPath, "FileSystem", true);
+    arch.load();
+
+    const bool oldMapFiles = FileSystemArchive::getMemoryMapFiles();
+    const size_t oldMinSize = FileSystemArchive::getMemoryMapMinSize();
+    FileSystemArchive::setMemoryMapFiles(true);
+    FileSystemArchive::setMemoryMapMinSize(0u);
+    DataStreamPtr stream = arch.open("rootfile.txt");
+    FileSystemArchive::setMemoryMapFiles(oldMapFiles);
+    FileSystemArchive::setMemoryMapMinSize(oldMinSize);
+
+    CPPUNIT_ASSERT(stream->getDataPtr() != 0);
+    CPPUNIT_ASSERT_EQUAL(mFileSizeRoot1, stream->size());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 1 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(0, memcmp(stream->getDataPtr() + stream->tell(), "this is line 2", 14));
+    CPPUNIT_ASSERT_EQUAL(String("this is line 2 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 3 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 4 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 5 in file 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(BLANKSTRING, stream->getLine()); // blank at end of file
+    CPPUNIT_ASSERT(stream->eof());
+}
+//--------------------------------------------------------------------------
 void FileSystemArchiveTests::testReadInterleave()
 {
     UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
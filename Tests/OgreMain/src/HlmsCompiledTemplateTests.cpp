@@ -0,0 +1,224 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "HlmsCompiledTemplateTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreFileSystem.h"
+#include "OgreHlms.h"
+#include "OgreHlmsCompiledTemplate.h"
+#include "OgreHlmsPropertyMap.h"
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+#include "macUtils.h"
+#endif
+
+#include <set>
+#include <stdlib.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsCompiledTemplateTests);
+
+namespace
+{
+    /// Gives access to the string passes (Hlms::parseMath, parseForEach & parseProperties)
+    class StringPassesHlms : public Hlms
+    {
+    protected:
+        void setupRootLayout(RootLayout &rootLayout, size_t tid) override {}
+        HlmsDatablock *createDatablockImpl(IdString datablockName, const HlmsMacroblock *macroblock,
+                                           const HlmsBlendblock *blendblock,
+                                           const HlmsParamVec &paramVec) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersFor(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                              bool casterPass, uint32 lastCacheHash,
+                              uint32 lastTextureHash) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV1(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                bool casterPass, uint32 lastCacheHash,
+                                CommandBuffer *commandBuffer) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV2(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                bool casterPass, uint32 lastCacheHash,
+                                CommandBuffer *commandBuffer) override
+        {
+            return 0;
+        }
+
+    public:
+        StringPassesHlms(Archive *dataFolder) : Hlms(HLMS_USER3, "StringPasses", dataFolder, 0) {}
+
+        /// Same as Hlms::parseTemplate does for piece files when the file can't be compiled.
+        /// Compiled templates keep going after a syntax error too, so the outputs still match.
+        bool parse(const String &source, HlmsPropertyVec &inOutProperties, String &outString)
+        {
+            mT[0].setProperties = inOutProperties;
+
+            String inString = source;
+            bool syntaxError = false;
+            syntaxError |= this->parseMath(inString, outString, 0u);
+            while (outString.find("@foreach") != String::npos)
+            {
+                syntaxError |= this->parseForEach(outString, inString, 0u);
+                inString.swap(outString);
+            }
+            syntaxError |= this->parseProperties(outString, inString, 0u);
+
+            outString.swap(inString);
+            inOutProperties = mT[0].setProperties;
+            return syntaxError;
+        }
+    };
+
+    /// All the words in the file; most of them aren't properties but that doesn't matter
+    void collectWords(const String &source, std::set<String> &outWords)
+    {
+        size_t wordStart = String::npos;
+        for (size_t i = 0; i <= source.size(); ++i)
+        {
+            const char c = i < source.size() ? source[i] : ' ';
+            const bool isWordChar = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                                    (c >= '0' && c <= '9') || c == '_';
+            if (isWordChar && wordStart == String::npos)
+                wordStart = i;
+            else if (!isWordChar && wordStart != String::npos)
+            {
+                outWords.insert(source.substr(wordStart, i - wordStart));
+                wordStart = String::npos;
+            }
+        }
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+    mHlmsPath = macBundlePath() + "/Contents/Resources/Media/Hlms";
+#elif OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+    mHlmsPath = "../../Samples/Media/Hlms";
+#else
+    mHlmsPath = "./Samples/Media/Hlms";
+#endif
+}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void HlmsCompiledTemplateTests::testStockTemplates()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    FileSystemArchive archive(mHlmsPath, "FileSystem", true);
+    archive.load();
+
+    // Hlms refuses to be created without a folder with templates
+    FileSystemArchive pbsArchive(mHlmsPath + "/Pbs/GLSL", "FileSystem", true);
+    pbsArchive.load();
+    StringPassesHlms hlms(&pbsArchive);
+
+    StringVectorPtr files = archive.list(true, false);
+    CPPUNIT_ASSERT(!files->empty());
+
+    HlmsPropertyMap scratchMap;
+    size_t numFilesTested = 0u;
+
+    StringVector::const_iterator itor = files->begin();
+    StringVector::const_iterator endt = files->end();
+
+    while (itor != endt)
+    {
+        const String &filename = *itor;
+        const size_t extPos = filename.find_last_of('.');
+        const String ext = extPos != String::npos ? filename.substr(extPos) : BLANKSTRING;
+
+        if (ext == ".glsl" || ext == ".hlsl" || ext == ".metal" || ext == ".any")
+        {
+            DataStreamPtr inFile = archive.open(filename);
+            const String source = inFile->getAsString();
+
+            HlmsCompiledTemplate compiledTemplate;
+            CPPUNIT_ASSERT_MESSAGE(filename + " could not be precompiled",
+                                   compiledTemplate.compile(source));
+
+            std::set<String> words;
+            collectWords(source, words);
+            const std::vector<String> wordVec(words.begin(), words.end());
+
+            // Random property sets. Values of 0 & 1 are the most common in practice; larger
+            // values are needed to unroll @foreach blocks and pick @pset/@padd branches
+            for (size_t i = 0; i < 16u; ++i)
+            {
+                HlmsPropertyVec properties;
+                if (!wordVec.empty())
+                {
+                    const size_t numProperties = static_cast<size_t>(rand()) % wordVec.size();
+                    for (size_t j = 0; j < numProperties; ++j)
+                    {
+                        const String &word = wordVec[static_cast<size_t>(rand()) % wordVec.size()];
+                        const int32 value = (rand() % 4) == 0 ? rand() % 5 : rand() % 2;
+                        Hlms::setProperty(properties, IdString(word), value);
+                    }
+                }
+
+                HlmsPropertyVec stringProperties = properties;
+                String stringOutput;
+                const bool stringSyntaxError = hlms.parse(source, stringProperties, stringOutput);
+
+                HlmsPropertyVec compiledProperties = properties;
+                String compiledOutput;
+                const bool compiledSyntaxError =
+                    compiledTemplate.evaluate(compiledProperties, scratchMap, compiledOutput);
+
+                CPPUNIT_ASSERT_EQUAL(stringSyntaxError, compiledSyntaxError);
+                CPPUNIT_ASSERT_MESSAGE(filename + ": output differs from the string passes",
+                                       stringOutput == compiledOutput);
+                CPPUNIT_ASSERT_MESSAGE(filename + ": properties differ from the string passes",
+                                       stringProperties == compiledProperties);
+            }
+
+            ++numFilesTested;
+        }
+
+        ++itor;
+    }
+
+    CPPUNIT_ASSERT(numFilesTested > 0u);
+}
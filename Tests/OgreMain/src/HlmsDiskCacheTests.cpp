@@ -0,0 +1,408 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "HlmsDiskCacheTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "OgreFileSystem.h"
+#include "OgreHlms.h"
+#include "OgreHlmsDatablock.h"
+#include "OgreHlmsDiskCache.h"
+#include "OgreHlmsManager.h"
+#include "OgreRenderSystem.h"
+#include "OgreRoot.h"
+#include "OgreStringConverter.h"
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+#include "macUtils.h"
+#endif
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsDiskCacheTests);
+
+namespace
+{
+    /// Bare Hlms that exposes its shader cache
+    class DiskCacheHlms : public Hlms
+    {
+    protected:
+        void setupRootLayout(RootLayout &rootLayout, size_t tid) override {}
+        HlmsDatablock *createDatablockImpl(IdString datablockName, const HlmsMacroblock *macroblock,
+                                           const HlmsBlendblock *blendblock,
+                                           const HlmsParamVec &paramVec) override
+        {
+            // registerHlms creates the default datablock
+            return OGRE_NEW HlmsDatablock(datablockName, this, macroblock, blendblock, paramVec);
+        }
+        uint32 fillBuffersFor(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                              bool casterPass, uint32 lastCacheHash,
+                              uint32 lastTextureHash) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV1(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                bool casterPass, uint32 lastCacheHash,
+                                CommandBuffer *commandBuffer) override
+        {
+            return 0;
+        }
+        uint32 fillBuffersForV2(const HlmsCache *cache, const QueuedRenderable &queuedRenderable,
+                                bool casterPass, uint32 lastCacheHash,
+                                CommandBuffer *commandBuffer) override
+        {
+            return 0;
+        }
+
+    public:
+        DiskCacheHlms(Archive *dataFolder) : Hlms(HLMS_USER3, "DiskCacheTests", dataFolder, 0) {}
+
+        const HlmsCacheVec &getShaderCacheEntries() const { return mShaderCache; }
+        using Hlms::clearShaderCache;
+    };
+
+    /// Fills diskCache with numSources shaders and numPsos PSOs using the given blocks, as if
+    /// it had been copied from hlms. The first entries are the same regardless of the counts.
+    void fillCache(HlmsDiskCache &diskCache, Hlms *hlms, const HlmsMacroblock &macroblock,
+                   const HlmsBlendblock &blendblock, size_t numSources = 1u, size_t numPsos = 1u)
+    {
+        diskCache.clearCache();
+        diskCache.mCache.type = hlms->getType();
+        diskCache.mShaderProfile = hlms->getShaderProfile();
+        diskCache.mNativeShadingLangVer = hlms->getRenderSystem()->getNativeShadingLanguageVersion();
+        diskCache.mPrecisionMode = hlms->getSupportedPrecisionMode();
+        diskCache.mFastShaderBuildHack = hlms->getFastShaderBuildHack();
+        hlms->getTemplateChecksum(diskCache.mCache.templateHash);
+
+        for (size_t i = 0; i < numSources; ++i)
+        {
+            HlmsDiskCache::SourceCode sourceCode;
+            Hlms::setProperty(sourceCode.mergedCache.setProperties, "disk_cache_test",
+                              static_cast<int32>(i + 1u));
+            sourceCode.sourceFile[VertexShader] =
+                "void main() { /* vs " + StringConverter::toString(i) + " */ }";
+            sourceCode.sourceFile[PixelShader] =
+                "void main() { /* ps " + StringConverter::toString(i) + " */ }";
+            diskCache.calculateKey(sourceCode, sourceCode.key);
+            diskCache.mCache.sourceCode.push_back(sourceCode);
+        }
+
+        for (size_t i = 0; i < numPsos; ++i)
+        {
+            HlmsDiskCache::Pso pso;
+            Hlms::setProperty(pso.renderableCache.setProperties, "disk_cache_test",
+                              static_cast<int32>(i + 1u));
+            pso.pso.initialize();
+            pso.macroblock = macroblock;
+            pso.blendblock = blendblock;
+            // Must not depend on numSources. The key doesn't include the shader
+            pso.sourceCodeIdx = static_cast<uint32>(i % std::min<size_t>(numSources, 2u));
+            diskCache.calculateKey(pso, pso.key);
+            diskCache.mCache.pso.push_back(pso);
+        }
+    }
+
+    /// Runs diskCache through saveTo & loadFrom
+    void saveAndLoad(HlmsDiskCache &diskCache, HlmsDiskCache &outLoaded)
+    {
+        MemoryDataStream *saved = OGRE_NEW MemoryDataStream(64u * 1024u);
+        DataStreamPtr savedPtr(saved);
+        diskCache.saveTo(savedPtr);
+
+        // loadFrom reads the end of the stream, and keeps it to read the source later
+        MemoryDataStream *trimmed = OGRE_NEW MemoryDataStream(saved->tell());
+        memcpy(trimmed->getPtr(), saved->getPtr(), saved->tell());
+        DataStreamPtr trimmedPtr(trimmed);
+        outLoaded.loadFrom(trimmedPtr);
+    }
+
+    /// Checks loaded has the same records as expected, with the same contents
+    void checkSameRecords(HlmsDiskCache &loaded, const HlmsDiskCache &expected)
+    {
+        CPPUNIT_ASSERT_EQUAL(expected.mCache.sourceCode.size(), loaded.mCache.sourceCode.size());
+        CPPUNIT_ASSERT_EQUAL(expected.mCache.pso.size(), loaded.mCache.pso.size());
+
+        loaded.readStoredSources();
+
+        for (size_t i = 0; i < expected.mCache.sourceCode.size(); ++i)
+        {
+            const HlmsDiskCache::SourceCode &expectedSource = expected.mCache.sourceCode[i];
+
+            bool found = false;
+            for (size_t j = 0; j < loaded.mCache.sourceCode.size() && !found; ++j)
+            {
+                const HlmsDiskCache::SourceCode &loadedSource = loaded.mCache.sourceCode[j];
+                if (loadedSource.key[0] == expectedSource.key[0] &&
+                    loadedSource.key[1] == expectedSource.key[1])
+                {
+                    found = true;
+                    CPPUNIT_ASSERT(loadedSource.mergedCache.setProperties ==
+                                   expectedSource.mergedCache.setProperties);
+
+                    String expectedFiles[NumShaderTypes];
+                    String loadedFiles[NumShaderTypes];
+                    CPPUNIT_ASSERT(expectedSource.getSourceFiles(expectedFiles));
+                    CPPUNIT_ASSERT(loadedSource.getSourceFiles(loadedFiles));
+                    for (size_t k = 0; k < NumShaderTypes; ++k)
+                        CPPUNIT_ASSERT_EQUAL(expectedFiles[k], loadedFiles[k]);
+                }
+            }
+            CPPUNIT_ASSERT(found);
+        }
+
+        for (size_t i = 0; i < expected.mCache.pso.size(); ++i)
+        {
+            const HlmsDiskCache::Pso &expectedPso = expected.mCache.pso[i];
+            const HlmsDiskCache::SourceCode &expectedSource =
+                expected.mCache.sourceCode[expectedPso.sourceCodeIdx];
+
+            bool found = false;
+            for (size_t j = 0; j < loaded.mCache.pso.size() && !found; ++j)
+            {
+                const HlmsDiskCache::Pso &loadedPso = loaded.mCache.pso[j];
+                if (loadedPso.key[0] == expectedPso.key[0] && loadedPso.key[1] == expectedPso.key[1])
+                {
+                    found = true;
+                    CPPUNIT_ASSERT(loadedPso.macroblock == expectedPso.macroblock);
+                    CPPUNIT_ASSERT(loadedPso.blendblock == expectedPso.blendblock);
+
+                    // Must reference the same shader, wherever it ended up
+                    CPPUNIT_ASSERT(loadedPso.sourceCodeIdx < loaded.mCache.sourceCode.size());
+                    const HlmsDiskCache::SourceCode &loadedSource =
+                        loaded.mCache.sourceCode[loadedPso.sourceCodeIdx];
+                    CPPUNIT_ASSERT(loadedSource.key[0] == expectedSource.key[0] &&
+                                   loadedSource.key[1] == expectedSource.key[1]);
+                }
+            }
+            CPPUNIT_ASSERT(found);
+        }
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+#if OGRE_PLATFORM == OGRE_PLATFORM_APPLE
+    const String hlmsPath = macBundlePath() + "/Contents/Resources/Media/Hlms";
+#elif OGRE_PLATFORM == OGRE_PLATFORM_WIN32
+    const String hlmsPath = "../../Samples/Media/Hlms";
+#else
+    const String hlmsPath = "./Samples/Media/Hlms";
+#endif
+
+    mRoot = new NULLRenderSystemRoot();
+
+    // Hlms refuses to be created without a folder with templates
+    mDataFolder = OGRE_NEW FileSystemArchive(hlmsPath + "/Pbs/GLSL", "FileSystem", true);
+    mDataFolder->load();
+    mHlms = OGRE_NEW DiskCacheHlms(mDataFolder);
+    mRoot->getRoot()->getHlmsManager()->registerHlms(mHlms);
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::tearDown()
+{
+    delete mRoot;
+    mRoot = 0;
+    mHlms = 0;
+    OGRE_DELETE mDataFolder;
+    mDataFolder = 0;
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testAppliedPsosOwnBlocks()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    HlmsManager *hlmsManager = mRoot->getRoot()->getHlmsManager();
+
+    // Settings no other block uses
+    HlmsMacroblock macroblockRef;
+    macroblockRef.mDepthBiasConstant = 3.0f;
+    HlmsBlendblock blendblockRef;
+    blendblockRef.mSourceBlendFactor = SBF_ONE_MINUS_DEST_COLOUR;
+
+    HlmsDiskCache diskCache(hlmsManager);
+    fillCache(diskCache, mHlms, macroblockRef, blendblockRef);
+
+    HlmsDiskCache loaded(hlmsManager);
+    saveAndLoad(diskCache, loaded);
+    CPPUNIT_ASSERT_EQUAL(size_t(1u), loaded.mCache.pso.size());
+
+    loaded.applyTo(mHlms, 1u);
+
+    const HlmsCacheVec &shaderCache =
+        static_cast<DiskCacheHlms *>(mHlms)->getShaderCacheEntries();
+    CPPUNIT_ASSERT_EQUAL(size_t(1u), shaderCache.size());
+    const HlmsCache *entry = shaderCache.front();
+    CPPUNIT_ASSERT(entry->ownsBlocks);
+
+    const HlmsMacroblock *macroblock = entry->pso.macroblock;
+    const HlmsBlendblock *blendblock = entry->pso.blendblock;
+    CPPUNIT_ASSERT_EQUAL(uint16(1u), macroblock->mRefCount);
+    CPPUNIT_ASSERT_EQUAL(uint16(1u), blendblock->mRefCount);
+
+    // Create blocks that would take over the slots if the PSO's blocks were inactive
+    std::vector<const HlmsMacroblock *> otherMacroblocks;
+    std::vector<const HlmsBlendblock *> otherBlendblocks;
+    for (int i = 0; i < 8; ++i)
+    {
+        HlmsMacroblock otherMacroblock;
+        otherMacroblock.mDepthBiasConstant = 10.0f + static_cast<float>(i);
+        otherMacroblocks.push_back(hlmsManager->getMacroblock(otherMacroblock));
+
+        HlmsBlendblock otherBlendblock;
+        otherBlendblock.mDestBlendFactor = static_cast<SceneBlendFactor>(i + 1);
+        otherBlendblocks.push_back(hlmsManager->getBlendblock(otherBlendblock));
+    }
+
+    CPPUNIT_ASSERT(*macroblock == macroblockRef);
+    CPPUNIT_ASSERT(*blendblock == blendblockRef);
+
+    for (size_t i = 0; i < otherMacroblocks.size(); ++i)
+    {
+        hlmsManager->destroyMacroblock(otherMacroblocks[i]);
+        hlmsManager->destroyBlendblock(otherBlendblocks[i]);
+    }
+
+    // Block pointers remain valid (although inactive) during HlmsManager's lifetime
+    static_cast<DiskCacheHlms *>(mHlms)->clearShaderCache();
+    CPPUNIT_ASSERT_EQUAL(uint16(0u), macroblock->mRefCount);
+    CPPUNIT_ASSERT_EQUAL(uint16(0u), blendblock->mRefCount);
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testRoundTrip()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    HlmsManager *hlmsManager = mRoot->getRoot()->getHlmsManager();
+
+    HlmsDiskCache diskCache(hlmsManager);
+    fillCache(diskCache, mHlms, HlmsMacroblock(), HlmsBlendblock(), 3u, 7u);
+
+    HlmsDiskCache loaded(hlmsManager);
+    saveAndLoad(diskCache, loaded);
+    CPPUNIT_ASSERT(!loaded.mTemplatesOutOfDate);
+
+    // The source is read on demand
+    for (size_t i = 0; i < loaded.mCache.sourceCode.size(); ++i)
+        CPPUNIT_ASSERT(loaded.mCache.sourceCode[i].storedSource.empty());
+
+    checkSameRecords(loaded, diskCache);
+
+    // Saving what was loaded must give the same cache back
+    HlmsDiskCache reloaded(hlmsManager);
+    saveAndLoad(loaded, reloaded);
+    checkSameRecords(reloaded, diskCache);
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testAppend()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    HlmsManager *hlmsManager = mRoot->getRoot()->getHlmsManager();
+
+    const String filename = "HlmsDiskCacheTests.bin";
+    FileSystemArchive folder(".", "FileSystem", false);
+    folder.load();
+
+    HlmsDiskCache diskCache(hlmsManager);
+    fillCache(diskCache, mHlms, HlmsMacroblock(), HlmsBlendblock(), 2u, 3u);
+    {
+        DataStreamPtr file = folder.create(filename);
+        diskCache.saveTo(file);
+    }
+
+    // A run that found more permutations. Only the new ones get written
+    fillCache(diskCache, mHlms, HlmsMacroblock(), HlmsBlendblock(), 4u, 9u);
+    size_t fileSize;
+    {
+        DataStreamPtr file = folder.open(filename, false);
+        CPPUNIT_ASSERT(diskCache.appendTo(file));
+        file->close();
+        fileSize = folder.open(filename)->size();
+    }
+    {
+        HlmsDiskCache loaded(hlmsManager);
+        DataStreamPtr file = folder.open(filename);
+        loaded.loadFrom(file);
+        checkSameRecords(loaded, diskCache);
+    }
+
+    // Appending the same permutations again is a no-op
+    {
+        DataStreamPtr file = folder.open(filename, false);
+        CPPUNIT_ASSERT(diskCache.appendTo(file));
+        file->close();
+        CPPUNIT_ASSERT_EQUAL(fileSize, folder.open(filename)->size());
+    }
+
+    // Different templates. Must be saved from scratch
+    {
+        HlmsDiskCache otherCache(hlmsManager);
+        fillCache(otherCache, mHlms, HlmsMacroblock(), HlmsBlendblock(), 4u, 9u);
+        otherCache.mCache.templateHash[0] ^= 1u;
+        DataStreamPtr file = folder.open(filename, false);
+        CPPUNIT_ASSERT(!otherCache.appendTo(file));
+    }
+
+    folder.remove(filename);
+}
+//--------------------------------------------------------------------------
+void HlmsDiskCacheTests::testTruncated()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    HlmsManager *hlmsManager = mRoot->getRoot()->getHlmsManager();
+
+    HlmsDiskCache diskCache(hlmsManager);
+    fillCache(diskCache, mHlms, HlmsMacroblock(), HlmsBlendblock(), 2u, 3u);
+
+    MemoryDataStream *saved = OGRE_NEW MemoryDataStream(64u * 1024u);
+    DataStreamPtr savedPtr(saved);
+    diskCache.saveTo(savedPtr);
+    const size_t savedSize = saved->tell();
+
+    // e.g. the app was killed while saving or appending
+    const size_t truncatedSizes[] = { savedSize - 1u, savedSize - 20u, savedSize / 2u };
+    for (size_t i = 0; i < sizeof(truncatedSizes) / sizeof(truncatedSizes[0]); ++i)
+    {
+        MemoryDataStream *truncated = OGRE_NEW MemoryDataStream(truncatedSizes[i]);
+        memcpy(truncated->getPtr(), saved->getPtr(), truncatedSizes[i]);
+        DataStreamPtr truncatedPtr(truncated);
+
+        HlmsDiskCache loaded(hlmsManager);
+        loaded.loadFrom(truncatedPtr);
+        CPPUNIT_ASSERT(loaded.mCache.sourceCode.empty());
+        CPPUNIT_ASSERT(loaded.mCache.pso.empty());
+
+        truncatedPtr->seek(0);
+        CPPUNIT_ASSERT(!diskCache.appendTo(truncatedPtr));
+    }
+}
@@ -0,0 +1,144 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "HlmsPropertyMapTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreHlms.h"
+#include "OgreHlmsPropertyMap.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(HlmsPropertyMapTests);
+
+// Properties HlmsPbs sets (see PbsProperty in OgreHlmsPbs.cpp)
+static const char *c_pbsPropertyNames[] = {
+    "use_light_buffers", "hw_gamma_read", "hw_gamma_write", "materials_per_buffer",
+    "lower_gpu_overhead", "debug_pssm_splits", "industry_compatible", "perceptual_roughness",
+    "has_planar_reflections", "num_pass_const_buffers", "set0_texture_slot_end",
+    "set1_texture_slot_end", "num_textures", "num_samplers", "diffuse_map_grayscale",
+    "emissive_map_grayscale", "normal_map", "fresnel_scalar", "use_texture_alpha",
+    "transparent_mode", "fresnel_workflow", "metallic_workflow", "two_sided_lighting",
+    "receive_shadows", "use_planar_reflections", "normal_sampling_format", "normal_la",
+    "normal_rg_unorm", "normal_rg_snorm", "normal_bc3_unorm", "normal_weight",
+    "normal_weight_tex", "normal_weight_detail0", "normal_weight_detail1",
+    "normal_weight_detail2", "normal_weight_detail3", "detail_weights", "detail_offsets0",
+    "detail_offsets1", "detail_offsets2", "detail_offsets3", "uv_diffuse", "uv_normal",
+    "uv_specular", "uv_roughness", "uv_detail_weight", "uv_detail0", "uv_detail1", "uv_detail2",
+    "uv_detail3", "uv_detail_nm0", "uv_detail_nm1", "uv_detail_nm2", "uv_detail_nm3",
+    "uv_emissive", "blend_mode_idx0", "blend_mode_idx1", "blend_mode_idx2", "blend_mode_idx3",
+    "detail_maps_diffuse", "detail_maps_normal", "first_valid_detail_map_nm",
+    "emissive_constant", "emissive_as_lightmap", "pcf", "pcf_iterations",
+    "shadows_receive_on_ps", "exponential_shadow_maps", "envmap_scale",
+    "light_profiles_texture", "ltc_texture_available", "ambient_fixed", "ambient_hemisphere",
+    "ambient_hemisphere_inverted", "ambient_sh", "ambient_sh_monochrome", "target_envprobe_map",
+    "parallax_correct_cubemaps", "use_parallax_correct_cubemaps", "hlms_enable_cubemaps_auto",
+    "hlms_cubemaps_use_dpm", "cubemaps_as_diffuse_gi", "irradiance_volumes", "vct_num_probes",
+    "vct_cone_dirs", "vct_disable_diffuse", "vct_disable_specular", "vct_anisotropic",
+    "vct_ambient_hemisphere", "irradiance_field", "obb_restraint_approx", "obb_restraint_ltc",
+    "BRDF_Default", "BRDF_CookTorrance", "BRDF_BlinnPhong", "fresnel_has_diffuse",
+    "fresnel_separate_diffuse", "GGX_height_correlated", "clear_coat", "legacy_math_brdf",
+    "roughness_is_shininess", "use_envprobe_map", "needs_view_dir", "needs_refl_dir",
+    "needs_env_brdf",
+};
+
+static const size_t c_numPbsPropertyNames =
+    sizeof( c_pbsPropertyNames ) / sizeof( c_pbsPropertyNames[0] );
+
+//--------------------------------------------------------------------------
+void HlmsPropertyMapTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void HlmsPropertyMapTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void HlmsPropertyMapTests::testMatchesPropertyVec()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    std::vector<IdString> keys;
+    for( size_t i = 0; i < c_numPbsPropertyNames; ++i )
+        keys.push_back( IdString( c_pbsPropertyNames[i] ) );
+
+    HlmsPropertyVec propertyVec;
+    HlmsPropertyMap propertyMap;
+
+    for( int i = 0; i < 100000; ++i )
+    {
+        const IdString key = keys[static_cast<size_t>( rand() ) % keys.size()];
+        const int32 value = rand() % 16;
+
+        switch( rand() % 4 )
+        {
+        case 0:
+        case 1:
+            Hlms::setProperty( propertyVec, key, value );
+            propertyMap.setProperty( key, value );
+            break;
+        case 2:
+        {
+            HlmsPropertyVec::iterator itor =
+                std::lower_bound( propertyVec.begin(), propertyVec.end(), HlmsProperty( key, 0 ),
+                                  OrderPropertyByIdString );
+            if( itor != propertyVec.end() && itor->keyName == key )
+                propertyVec.erase( itor );
+            propertyMap.unsetProperty( key );
+            break;
+        }
+        default:
+            CPPUNIT_ASSERT_EQUAL( Hlms::getProperty( propertyVec, key, -1 ),
+                                  propertyMap.getProperty( key, -1 ) );
+            break;
+        }
+
+        CPPUNIT_ASSERT_EQUAL( propertyVec.size(), propertyMap.size() );
+
+        if( i % 1000 == 0 )
+        {
+            HlmsPropertyVec sortedProperties;
+            propertyMap.getSortedProperties( sortedProperties );
+            CPPUNIT_ASSERT( sortedProperties == propertyVec );
+        }
+    }
+
+    HlmsPropertyMap rebuiltMap;
+    rebuiltMap.setProperties( propertyVec );
+    for( size_t i = 0; i < keys.size(); ++i )
+    {
+        CPPUNIT_ASSERT_EQUAL( Hlms::getProperty( propertyVec, keys[i], -1 ),
+                              rebuiltMap.getProperty( keys[i], -1 ) );
+    }
+
+    propertyMap.clear();
+    CPPUNIT_ASSERT( propertyMap.empty() );
+    CPPUNIT_ASSERT_EQUAL( propertyMap.getProperty( keys[0], -1 ), -1 );
+}
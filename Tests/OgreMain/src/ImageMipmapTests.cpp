@@ -0,0 +1,180 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ImageMipmapTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreImage2.h"
+#include "OgrePixelFormatGpuUtils.h"
+#include "OgreTextureBox.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ImageMipmapTests);
+
+/// Per pixel loop with the same rules as the generic 5x5 kernel path for the bilinear filter:
+/// the last column & row only sample what's left of the kernel inside the dst image.
+static void downsampleReference( const TextureBox &src, TextureBox &dst, bool sRgb )
+{
+    for( uint32 y = 0; y < dst.height; ++y )
+    {
+        const uint32 kEndY = std::min( dst.height - 1u - y, 1u );
+        for( uint32 x = 0; x < dst.width; ++x )
+        {
+            const uint32 kEndX = std::min( dst.width - 1u - x, 1u );
+
+            uint32 accum[4] = { 0, 0, 0, 0 };
+            uint32 divisor = 0;
+            for( uint32 k_y = 0; k_y <= kEndY; ++k_y )
+            {
+                for( uint32 k_x = 0; k_x <= kEndX; ++k_x )
+                {
+                    const uint8 *srcPixel =
+                        reinterpret_cast<const uint8 *>( src.at( x * 2u + k_x, y * 2u + k_y, 0 ) );
+                    for( size_t c = 0; c < 3u; ++c )
+                        accum[c] += sRgb ? srcPixel[c] * srcPixel[c] : srcPixel[c];
+                    accum[3] += srcPixel[3];
+                    ++divisor;
+                }
+            }
+
+            const float invDivisor = 1.0f / static_cast<float>( divisor );
+            uint8 *dstPixel = reinterpret_cast<uint8 *>( dst.at( x, y, 0 ) );
+            for( size_t c = 0; c < 3u; ++c )
+            {
+                const float value = static_cast<float>( accum[c] ) * invDivisor;
+                dstPixel[c] = static_cast<uint8>( ( sRgb ? sqrtf( value ) : value ) + 0.5f );
+            }
+            dstPixel[3] = static_cast<uint8>( ( accum[3] + divisor - 1u ) / divisor );
+        }
+    }
+}
+//--------------------------------------------------------------------------
+static void fillRandom( Image2 &image )
+{
+    const TextureBox box = image.getData( 0 );
+    for( uint32 y = 0; y < box.height; ++y )
+    {
+        uint8 *row = reinterpret_cast<uint8 *>( box.at( 0, y, 0 ) );
+        for( size_t i = 0; i < box.width * box.bytesPerPixel; ++i )
+            row[i] = static_cast<uint8>( rand() );
+    }
+}
+//--------------------------------------------------------------------------
+static bool compareMip( const Image2 &a, const Image2 &b, uint8 mip )
+{
+    const TextureBox boxA = a.getData( mip );
+    const TextureBox boxB = b.getData( mip );
+    for( uint32 z = 0; z < boxA.getDepthOrSlices(); ++z )
+    {
+        for( uint32 y = 0; y < boxA.height; ++y )
+        {
+            if( memcmp( boxA.at( 0, y, z ), boxB.at( 0, y, z ), boxA.width * boxA.bytesPerPixel ) )
+                return false;
+        }
+    }
+    return true;
+}
+//--------------------------------------------------------------------------
+void ImageMipmapTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void ImageMipmapTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void ImageMipmapTests::testBilinearMatchesReference()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const uint32 sizes[][2] = { { 1u, 1u }, { 2u, 2u }, { 3u, 5u }, { 17u, 9u }, { 301u, 157u } };
+
+    for( size_t i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); ++i )
+    {
+        for( int sRgb = 0; sRgb < 2; ++sRgb )
+        {
+            Image2 image;
+            image.createEmptyImage( sizes[i][0], sizes[i][1], 1u, TextureTypes::Type2D,
+                                    sRgb ? PFG_RGBA8_UNORM_SRGB : PFG_RGBA8_UNORM );
+            fillRandom( image );
+
+            Image2 expected;
+            expected.createEmptyImage( image.getWidth(), image.getHeight(), 1u,
+                                       TextureTypes::Type2D, image.getPixelFormat(),
+                                       PixelFormatGpuUtils::getMaxMipmapCount(
+                                           image.getWidth(), image.getHeight() ) );
+            memcpy( expected.getData( 0 ).data, image.getData( 0 ).data,
+                    image.getData( 0 ).getSizeBytes() );
+
+            CPPUNIT_ASSERT( image.generateMipmaps( sRgb != 0, Image2::FILTER_BILINEAR ) );
+            CPPUNIT_ASSERT_EQUAL( expected.getNumMipmaps(), image.getNumMipmaps() );
+
+            for( uint8 mip = 1u; mip < expected.getNumMipmaps(); ++mip )
+            {
+                TextureBox dst = expected.getData( mip );
+                downsampleReference( expected.getData( mip - 1u ), dst, sRgb != 0 );
+                CPPUNIT_ASSERT( compareMip( expected, image, mip ) );
+            }
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void ImageMipmapTests::testThreadsMatchSingleThread()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const PixelFormatGpu formats[] = { PFG_RGBA8_UNORM, PFG_RGBA8_UNORM_SRGB, PFG_RG8_UNORM,
+                                       PFG_R8_UNORM, PFG_RGBA32_FLOAT };
+    const Image2::Filter filters[] = { Image2::FILTER_BILINEAR, Image2::FILTER_GAUSSIAN,
+                                       Image2::FILTER_GAUSSIAN_HIGH };
+
+    for( size_t i = 0; i < sizeof( formats ) / sizeof( formats[0] ); ++i )
+    {
+        for( size_t j = 0; j < sizeof( filters ) / sizeof( filters[0] ); ++j )
+        {
+            Image2 single;
+            single.createEmptyImage( 777u, 513u, 1u, TextureTypes::Type2D, formats[i] );
+            fillRandom( single );
+
+            Image2 multi;
+            multi.createEmptyImage( single.getWidth(), single.getHeight(), 1u,
+                                    TextureTypes::Type2D, formats[i] );
+            memcpy( multi.getData( 0 ).data, single.getData( 0 ).data,
+                    single.getData( 0 ).getSizeBytes() );
+
+            CPPUNIT_ASSERT( single.generateMipmaps( false, filters[j], 1u ) );
+            CPPUNIT_ASSERT( multi.generateMipmaps( false, filters[j], 5u ) );
+
+            for( uint8 mip = 1u; mip < single.getNumMipmaps(); ++mip )
+                CPPUNIT_ASSERT( compareMip( single, multi, mip ) );
+        }
+    }
+}
@@ -0,0 +1,311 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "IntersectionSceneQueryTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "OgreMovableObject.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSceneNode.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(IntersectionSceneQueryTests);
+
+namespace
+{
+    class QueryBox : public MovableObject
+    {
+    public:
+        QueryBox(SceneManager *sceneManager, const Vector3 &halfSize) :
+            MovableObject(Id::generateNewId<MovableObject>(),
+                          &sceneManager->_getEntityMemoryManager(SCENE_DYNAMIC), sceneManager, 0u)
+        {
+            setLocalAabb(Aabb(Vector3::ZERO, halfSize));
+        }
+
+        const String &getMovableType() const override
+        {
+            static const String movableType = "QueryBox";
+            return movableType;
+        }
+    };
+
+    /// Exposes the sweep axis, to know whether the previous order could be reused
+    class TestIntersectionQuery : public DefaultIntersectionSceneQuery
+    {
+    public:
+        TestIntersectionQuery(SceneManager *sceneManager) :
+            DefaultIntersectionSceneQuery(sceneManager)
+        {
+        }
+
+        uint32 getSweepAxis() const { return mSweepAxis; }
+    };
+
+    typedef std::pair<MovableObject *, MovableObject *> ObjectPair;
+    typedef std::vector<ObjectPair> ObjectPairVec;
+
+    ObjectPair makeSortedPair(MovableObject *a, MovableObject *b)
+    {
+        return a < b ? ObjectPair(a, b) : ObjectPair(b, a);
+    }
+
+    class PairCollector : public IntersectionSceneQueryListener
+    {
+    public:
+        ObjectPairVec pairs;
+
+        bool queryResult(MovableObject *first, MovableObject *second) override
+        {
+            pairs.push_back(ObjectPair(first, second));
+            return true;
+        }
+        bool queryResult(MovableObject *movable, SceneQuery::WorldFragment *fragment) override
+        {
+            return true;
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = new NULLRenderSystemRoot();
+    mSceneManager = mRoot->getRoot()->createSceneManager(ST_GENERIC, 4u);
+    mRandomSeed = 12345u;
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::tearDown()
+{
+    while (!mObjects.empty())
+        destroyObject(mObjects.size() - 1u);
+
+    delete mRoot;
+    mRoot = 0;
+    mSceneManager = 0;
+}
+//--------------------------------------------------------------------------
+Real IntersectionSceneQueryTests::randomReal(Real minValue, Real maxValue)
+{
+    // Same LCG on every platform, so failures can be reproduced
+    mRandomSeed = mRandomSeed * 1664525u + 1013904223u;
+    return minValue + (maxValue - minValue) * Real(mRandomSeed >> 8u) / Real(1u << 24u);
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::createObject(const Vector3 &extents)
+{
+    const Vector3 halfSize(randomReal(0.1f, 2.0f), randomReal(0.1f, 2.0f), randomReal(0.1f, 2.0f));
+    MovableObject *object = new QueryBox(mSceneManager, halfSize);
+
+    SceneNode *sceneNode = mSceneManager->getRootSceneNode()->createChildSceneNode();
+    sceneNode->setPosition(randomReal(-extents.x, extents.x), randomReal(-extents.y, extents.y),
+                           randomReal(-extents.z, extents.z));
+    sceneNode->attachObject(object);
+
+    // Some objects don't pass the query mask
+    if (mObjects.size() % 7u == 3u)
+        object->setQueryFlags(0u);
+
+    mObjects.push_back(object);
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::destroyObject(size_t idx)
+{
+    MovableObject *object = mObjects[idx];
+    SceneNode *sceneNode = object->getParentSceneNode();
+    delete object;
+    mSceneManager->destroySceneNode(sceneNode);
+
+    mObjects[idx] = mObjects.back();
+    mObjects.pop_back();
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::moveObjects(Real maxOffset)
+{
+    for (size_t i = 0; i < mObjects.size(); ++i)
+    {
+        mObjects[i]->getParentSceneNode()->translate(randomReal(-maxOffset, maxOffset),
+                                                     randomReal(-maxOffset, maxOffset),
+                                                     randomReal(-maxOffset, maxOffset));
+    }
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::scatterObjects(const Vector3 &extents)
+{
+    for (size_t i = 0; i < mObjects.size(); ++i)
+    {
+        mObjects[i]->getParentSceneNode()->setPosition(randomReal(-extents.x, extents.x),
+                                                       randomReal(-extents.y, extents.y),
+                                                       randomReal(-extents.z, extents.z));
+    }
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::checkAgainstBruteForce(IntersectionSceneQuery *query)
+{
+    mSceneManager->updateSceneGraph();
+
+    ObjectPairVec expected;
+    for (size_t i = 0; i < mObjects.size(); ++i)
+    {
+        if (!mObjects[i]->getQueryFlags())
+            continue;
+
+        const Aabb aabb = mObjects[i]->getWorldAabb();
+        for (size_t j = i + 1u; j < mObjects.size(); ++j)
+        {
+            if (mObjects[j]->getQueryFlags() && aabb.intersects(mObjects[j]->getWorldAabb()))
+                expected.push_back(makeSortedPair(mObjects[i], mObjects[j]));
+        }
+    }
+
+    PairCollector collector;
+    query->execute(&collector);
+
+    ObjectPairVec found;
+    for (size_t i = 0; i < collector.pairs.size(); ++i)
+        found.push_back(makeSortedPair(collector.pairs[i].first, collector.pairs[i].second));
+
+    std::sort(expected.begin(), expected.end());
+    std::sort(found.begin(), found.end());
+
+    // Also catches pairs reported twice
+    CPPUNIT_ASSERT_EQUAL(expected.size(), found.size());
+    CPPUNIT_ASSERT(expected == found);
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::testCoherentMotion()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const Vector3 extents(30.0f, 8.0f, 8.0f);
+    for (size_t i = 0; i < 500u; ++i)
+        createObject(extents);
+
+    TestIntersectionQuery query(mSceneManager);
+    checkAgainstBruteForce(&query);
+    const uint32 sweepAxis = query.getSweepAxis();
+    CPPUNIT_ASSERT_EQUAL((uint32)0u, sweepAxis);
+
+    for (size_t frame = 0; frame < 8u; ++frame)
+    {
+        moveObjects(0.5f);
+        checkAgainstBruteForce(&query);
+        // The rank hints of the previous execution were used
+        CPPUNIT_ASSERT_EQUAL(sweepAxis, query.getSweepAxis());
+    }
+
+    // Large jumps leave the previous order far from sorted
+    moveObjects(30.0f);
+    checkAgainstBruteForce(&query);
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::testReusedSlots()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const Vector3 extents(20.0f, 20.0f, 6.0f);
+    for (size_t i = 0; i < 400u; ++i)
+        createObject(extents);
+
+    TestIntersectionQuery query(mSceneManager);
+    checkAgainstBruteForce(&query);
+
+    for (size_t frame = 0; frame < 6u; ++frame)
+    {
+        // Destroy a random third, then create objects that take over their slots
+        const size_t numToDestroy = mObjects.size() / 3u;
+        for (size_t i = 0; i < numToDestroy; ++i)
+        {
+            const size_t idx = static_cast<size_t>(randomReal(0.0f, Real(mObjects.size())));
+            destroyObject(std::min(idx, mObjects.size() - 1u));
+        }
+        checkAgainstBruteForce(&query);
+
+        const size_t numToCreate = numToDestroy + (frame % 2u ? 40u : 0u);
+        for (size_t i = 0; i < numToCreate; ++i)
+            createObject(extents);
+        moveObjects(0.25f);
+        checkAgainstBruteForce(&query);
+    }
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::testSweepAxisSwitch()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    for (size_t i = 0; i < 300u; ++i)
+        createObject(Vector3(80.0f, 5.0f, 5.0f));
+
+    TestIntersectionQuery query(mSceneManager);
+    checkAgainstBruteForce(&query);
+    CPPUNIT_ASSERT_EQUAL((uint32)0u, query.getSweepAxis());
+
+    scatterObjects(Vector3(5.0f, 5.0f, 80.0f));
+    checkAgainstBruteForce(&query);
+    CPPUNIT_ASSERT_EQUAL((uint32)2u, query.getSweepAxis());
+
+    // Back to coherent motion along the new axis
+    moveObjects(0.5f);
+    checkAgainstBruteForce(&query);
+    CPPUNIT_ASSERT_EQUAL((uint32)2u, query.getSweepAxis());
+
+    scatterObjects(Vector3(5.0f, 80.0f, 5.0f));
+    checkAgainstBruteForce(&query);
+    CPPUNIT_ASSERT_EQUAL((uint32)1u, query.getSweepAxis());
+}
+//--------------------------------------------------------------------------
+void IntersectionSceneQueryTests::testThreaded()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    CPPUNIT_ASSERT(mSceneManager->getNumWorkerThreads() > 1u);
+
+    const Vector3 extents(60.0f, 15.0f, 15.0f);
+    const size_t numObjects = DefaultIntersectionSceneQuery::c_minProxiesForThreads * 2u;
+    for (size_t i = 0; i < numObjects; ++i)
+        createObject(extents);
+
+    TestIntersectionQuery query(mSceneManager);
+    checkAgainstBruteForce(&query);
+
+    moveObjects(0.5f);
+    checkAgainstBruteForce(&query);
+
+    // Without changes, the same pairs are reported in the same order
+    PairCollector first, second;
+    query.execute(&first);
+    query.execute(&second);
+    CPPUNIT_ASSERT(!first.pairs.empty());
+    CPPUNIT_ASSERT(first.pairs == second.pairs);
+}
@@ -0,0 +1,260 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "Mesh2LodStreamingTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "OgreMesh.h"
+#include "OgreMesh2.h"
+#include "OgreMesh2Serializer.h"
+#include "OgreMeshManager.h"
+#include "OgreMeshManager2.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreRoot.h"
+#include "OgreSubMesh2.h"
+#include "Vao/OgreVaoManager.h"
+
+#include <cstdio>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(Mesh2LodStreamingTests);
+
+namespace
+{
+    const char *c_groupName = "Mesh2LodStreamingTests";
+    const char *c_meshName = "Mesh2LodStreamingTests.mesh";
+
+    /// A flat grid of gridSize x gridSize quads, with its own vertex & index buffers
+    VertexArrayObject *createGridVao(VaoManager *vaoManager, uint32 gridSize)
+    {
+        const uint32 numVertices = (gridSize + 1u) * (gridSize + 1u);
+        float *vertices = reinterpret_cast<float *>(
+            OGRE_MALLOC_SIMD(numVertices * 3u * sizeof(float), MEMCATEGORY_GEOMETRY));
+        for (uint32 i = 0; i < numVertices; ++i)
+        {
+            vertices[i * 3u + 0u] = float(i % (gridSize + 1u));
+            vertices[i * 3u + 1u] = float(i / (gridSize + 1u));
+            vertices[i * 3u + 2u] = 0.0f;
+        }
+
+        const uint32 numIndices = gridSize * gridSize * 6u;
+        uint16 *indices = reinterpret_cast<uint16 *>(
+            OGRE_MALLOC_SIMD(numIndices * sizeof(uint16), MEMCATEGORY_GEOMETRY));
+        for (uint32 quad = 0; quad < gridSize * gridSize; ++quad)
+        {
+            const uint16 v0 =
+                static_cast<uint16>((quad / gridSize) * (gridSize + 1u) + quad % gridSize);
+            const uint16 v2 = static_cast<uint16>(v0 + gridSize + 1u);
+            const uint16 quadIndices[6] = { v0, v2, static_cast<uint16>(v0 + 1u),
+                                            static_cast<uint16>(v0 + 1u), v2,
+                                            static_cast<uint16>(v2 + 1u) };
+            memcpy(indices + quad * 6u, quadIndices, sizeof(quadIndices));
+        }
+
+        VertexElement2Vec vertexElements;
+        vertexElements.push_back(VertexElement2(VET_FLOAT3, VES_POSITION));
+        VertexBufferPackedVec vertexBuffers;
+        vertexBuffers.push_back(vaoManager->createVertexBuffer(vertexElements, numVertices,
+                                                               BT_IMMUTABLE, vertices, true));
+        IndexBufferPacked *indexBuffer = vaoManager->createIndexBuffer(
+            IndexBufferPacked::IT_16BIT, numIndices, BT_IMMUTABLE, indices, true);
+
+        return vaoManager->createVertexArrayObject(vertexBuffers, indexBuffer, OT_TRIANGLE_LIST);
+    }
+
+    size_t getNumVertices(const VertexArrayObject *vao)
+    {
+        return vao->getVertexBuffers()[0]->getNumElements();
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = new NULLRenderSystemRoot();
+    mMeshPath = String("./") + c_meshName;
+
+    exportLodMesh();
+
+    ResourceGroupManager::getSingleton().addResourceLocation("./", "FileSystem", c_groupName);
+    Mesh::msLodStreaming = true;
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::tearDown()
+{
+    Mesh::msLodStreaming = false;
+    delete mRoot;
+    mRoot = 0;
+    remove(mMeshPath.c_str());
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::exportLodMesh()
+{
+    // Mesh2 only gets LOD values from files & v1 meshes
+    v1::MeshPtr meshV1 = v1::MeshManager::getSingleton().createManual(
+        "Mesh2LodStreamingTests v1", ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    meshV1->_setLodInfo(3u);
+    for (unsigned short i = 1u; i < 3u; ++i)
+    {
+        v1::MeshLodUsage usage;
+        usage.userValue = Real(i * 100u);
+        usage.value = usage.userValue;
+        usage.edgeData = 0;
+        meshV1->_setLodUsage(i, usage);
+    }
+
+    MeshPtr mesh = MeshManager::getSingleton().createManual(
+        "Mesh2LodStreamingTests export", ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+    mesh->importV1(meshV1.get(), false, false, false);
+    CPPUNIT_ASSERT_EQUAL((uint16)3u, mesh->getNumLodLevels());
+
+    // 8x8, 4x4 & 2x2 quads. As no LOD uses the vertices of another one,
+    // each LOD can be streamed in & out on its own
+    VaoManager *vaoManager = mRoot->getVaoManager();
+    SubMesh *subMesh = mesh->createSubMesh();
+    for (uint32 gridSize = 8u; gridSize >= 2u; gridSize /= 2u)
+        subMesh->mVao[VpNormal].push_back(createGridVao(vaoManager, gridSize));
+    subMesh->mVao[VpShadow] = subMesh->mVao[VpNormal];
+
+    mesh->_setBounds(Aabb(Vector3(4.0f, 4.0f, 0.0f), Vector3(4.0f, 4.0f, 0.0f)));
+    mesh->_setBoundingSphereRadius(6.0f);
+
+    MeshSerializer serializer(vaoManager);
+    serializer.exportMesh(mesh.get(), mMeshPath);
+
+    MeshManager::getSingleton().remove(mesh);
+    v1::MeshManager::getSingleton().remove(meshV1);
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::endFrame()
+{
+    Root *root = mRoot->getRoot();
+    root->_fireFrameRenderingQueued();
+    root->_fireFrameEnded();
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::testCoarsestStepFirst()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr mesh = MeshManager::getSingleton().load(c_meshName, c_groupName);
+    CPPUNIT_ASSERT(mesh->_getLodStreamingInfo() != 0);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, mesh->_getLodStreamingInfo()->stepLods.size());
+    CPPUNIT_ASSERT_EQUAL((uint8)2u, mesh->getFirstResidentLod());
+
+    const VertexArrayObjectArray &vaos = mesh->getSubMesh(0)->mVao[VpNormal];
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, vaos.size());
+    CPPUNIT_ASSERT_EQUAL((size_t)9u, getNumVertices(vaos[2]));
+    CPPUNIT_ASSERT(vaos[0] == vaos[2] && vaos[1] == vaos[2]);
+
+    // The LOD strategy gets told it can only use the coarsest LOD
+    CPPUNIT_ASSERT_EQUAL((uint8)2u, mesh->_getLodStreamingState()->request(0u));
+
+    MeshManager::getSingleton().remove(mesh);
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::testStreamIn()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr mesh = MeshManager::getSingleton().load(c_meshName, c_groupName);
+    CPPUNIT_ASSERT_EQUAL((uint8)2u, mesh->getFirstResidentLod());
+
+    mesh->_getLodStreamingState()->request(0u);
+    endFrame();
+
+    // Without threads the WorkQueue is synchronous. Otherwise the response
+    // arrives at the end of one of the next frames
+    for (size_t i = 0; i < 1000u && mesh->getFirstResidentLod() != 0u; ++i)
+        endFrame();
+
+    CPPUNIT_ASSERT_EQUAL((uint8)0u, mesh->getFirstResidentLod());
+    CPPUNIT_ASSERT_EQUAL((uint8)255u, mesh->_getLodStreamingInfo()->pendingLod);
+
+    const VertexArrayObjectArray &vaos = mesh->getSubMesh(0)->mVao[VpNormal];
+    CPPUNIT_ASSERT_EQUAL((size_t)81u, getNumVertices(vaos[0]));
+    CPPUNIT_ASSERT_EQUAL((size_t)25u, getNumVertices(vaos[1]));
+    CPPUNIT_ASSERT_EQUAL((size_t)9u, getNumVertices(vaos[2]));
+
+    // The coarsest step doesn't count towards the budget
+    endFrame();
+    const MeshLodStreamingInfo *info = mesh->_getLodStreamingInfo();
+    CPPUNIT_ASSERT_EQUAL(info->stepBytes[0] + info->stepBytes[1],
+                         MeshManager::getSingleton().getLodStreamingUsage());
+
+    MeshManager::getSingleton().remove(mesh);
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::testEvictOverBudget()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr mesh = MeshManager::getSingleton().load(c_meshName, c_groupName);
+
+    mesh->_getLodStreamingState()->request(0u);
+    for (size_t i = 0; i < 1000u && mesh->getFirstResidentLod() != 0u; ++i)
+        endFrame();
+    CPPUNIT_ASSERT_EQUAL((uint8)0u, mesh->getFirstResidentLod());
+
+    // Nothing requests the finer LODs anymore, so they go away as soon as
+    // they haven't been used for a frame
+    MeshManager::getSingleton().setLodStreamingBudget(0u);
+    endFrame();
+    CPPUNIT_ASSERT_EQUAL((uint8)2u, mesh->getFirstResidentLod());
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, MeshManager::getSingleton().getLodStreamingUsage());
+
+    const VertexArrayObjectArray &vaos = mesh->getSubMesh(0)->mVao[VpNormal];
+    CPPUNIT_ASSERT(vaos[0] == vaos[2] && vaos[1] == vaos[2]);
+    CPPUNIT_ASSERT_EQUAL((size_t)9u, getNumVertices(vaos[2]));
+
+    MeshManager::getSingleton().setLodStreamingBudget(std::numeric_limits<size_t>::max());
+    MeshManager::getSingleton().remove(mesh);
+}
+//--------------------------------------------------------------------------
+void Mesh2LodStreamingTests::testMissingFile()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    MeshPtr mesh = MeshManager::getSingleton().load(c_meshName, c_groupName);
+    remove(mMeshPath.c_str());
+
+    mesh->_getLodStreamingState()->request(0u);
+    endFrame();
+
+    CPPUNIT_ASSERT_EQUAL((uint8)2u, mesh->getFirstResidentLod());
+    CPPUNIT_ASSERT(mesh->_getLodStreamingInfo()->pendingLod != 255u);
+
+    const VertexArrayObjectArray &vaos = mesh->getSubMesh(0)->mVao[VpNormal];
+    CPPUNIT_ASSERT(vaos[0] == vaos[2]);
+
+    MeshManager::getSingleton().remove(mesh);
+}
@@ -0,0 +1,261 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "Mesh2OptimizerTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgreMatrix4.h"
+#include "OgreMesh2Optimizer.h"
+#include "OgrePlane.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(Mesh2OptimizerTests);
+
+typedef std::vector<std::vector<uint32> > TriangleList;
+
+static TriangleList sortedTriangles(const std::vector<uint32> &indices)
+{
+    TriangleList triangles;
+    for (size_t i = 0; i < indices.size(); i += 3u)
+        triangles.push_back(std::vector<uint32>(indices.begin() + i, indices.begin() + i + 3u));
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+
+    const uint32 gridSize = 64u;
+    mNumVertices = (gridSize + 1u) * (gridSize + 1u);
+
+    for (uint32 y = 0; y <= gridSize; ++y)
+    {
+        for (uint32 x = 0; x <= gridSize; ++x)
+        {
+            mPositions.push_back(float(x));
+            mPositions.push_back(float(y));
+            mPositions.push_back(sinf(float(x) * 0.2f) * cosf(float(y) * 0.2f) * 4.0f);
+        }
+    }
+
+    std::vector<uint32> triangleOrder(gridSize * gridSize * 2u);
+    for (size_t i = 0; i < triangleOrder.size(); ++i)
+        triangleOrder[i] = static_cast<uint32>(i);
+    for (size_t i = triangleOrder.size() - 1u; i > 0u; --i)
+        std::swap(triangleOrder[i], triangleOrder[size_t(rand()) % (i + 1u)]);
+
+    for (size_t i = 0; i < triangleOrder.size(); ++i)
+    {
+        const uint32 quad = triangleOrder[i] / 2u;
+        const uint32 v0 = (quad / gridSize) * (gridSize + 1u) + quad % gridSize;
+        const uint32 v1 = v0 + 1u;
+        const uint32 v2 = v0 + gridSize + 1u;
+        const uint32 v3 = v2 + 1u;
+        const uint32 triangle[2][3] = { { v0, v2, v1 }, { v1, v2, v3 } };
+        mIndices.insert(mIndices.end(), triangle[triangleOrder[i] % 2u],
+                        triangle[triangleOrder[i] % 2u] + 3u);
+    }
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::tearDown()
+{
+    mPositions.clear();
+    mIndices.clear();
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::testVertexCache()
+{
+    const MeshOptimizer::Stats before =
+        MeshOptimizer::analyze(mIndices.data(), mIndices.size(), mNumVertices);
+
+    std::vector<uint32> indices(mIndices);
+    MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), mNumVertices);
+
+    const MeshOptimizer::Stats after =
+        MeshOptimizer::analyze(indices.data(), indices.size(), mNumVertices);
+
+    CPPUNIT_ASSERT_EQUAL(before.numTriangles, after.numTriangles);
+    CPPUNIT_ASSERT_EQUAL(mNumVertices, after.numVertices);
+    CPPUNIT_ASSERT(before.getAcmr() > 2.0f);
+    CPPUNIT_ASSERT(after.getAcmr() < 0.8f);
+    CPPUNIT_ASSERT(sortedTriangles(indices) == sortedTriangles(mIndices));
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::testOverdraw()
+{
+    std::vector<uint32> indices(mIndices);
+    MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), mNumVertices);
+    const float acmr =
+        MeshOptimizer::analyze(indices.data(), indices.size(), mNumVertices).getAcmr();
+
+    MeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), mPositions.data(),
+                                    mNumVertices, 1.05f);
+    const float newAcmr =
+        MeshOptimizer::analyze(indices.data(), indices.size(), mNumVertices).getAcmr();
+
+    CPPUNIT_ASSERT(newAcmr <= acmr * 1.1f);
+    CPPUNIT_ASSERT(sortedTriangles(indices) == sortedTriangles(mIndices));
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::testOverdrawSortsByPosition()
+{
+    // Three quads facing +Z with no shared vertices, thus each one is a cluster. The mesh
+    // centre is at Z = 1, so the quad at Z = 4 faces away from it and the one at Z = -2
+    // faces towards it.
+    const float quadZ[3] = { -2.0f, 1.0f, 4.0f };
+    std::vector<float> positions;
+    std::vector<uint32> indices;
+    for (uint32 i = 0; i < 3u; ++i)
+    {
+        const float corners[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+        for (size_t j = 0; j < 4u; ++j)
+        {
+            positions.push_back(corners[j][0]);
+            positions.push_back(corners[j][1]);
+            positions.push_back(quadZ[i]);
+        }
+        const uint32 quad[6] = { i * 4u, i * 4u + 1u, i * 4u + 2u, i * 4u, i * 4u + 2u, i * 4u + 3u };
+        indices.insert(indices.end(), quad, quad + 6u);
+    }
+
+    std::vector<uint32> expected;
+    expected.insert(expected.end(), indices.begin() + 12u, indices.end());
+    expected.insert(expected.end(), indices.begin() + 6u, indices.begin() + 12u);
+    expected.insert(expected.end(), indices.begin(), indices.begin() + 6u);
+
+    MeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), positions.data(), 12u);
+
+    CPPUNIT_ASSERT(indices == expected);
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::testVertexFetch()
+{
+    // Leave the last vertex unreferenced
+    const size_t numVertices = mNumVertices + 1u;
+    std::vector<uint32> remap(numVertices);
+    const size_t newNumVertices =
+        MeshOptimizer::optimizeVertexFetch(mIndices.data(), mIndices.size(), numVertices,
+                                           remap.data());
+
+    CPPUNIT_ASSERT_EQUAL(mNumVertices, newNumVertices);
+    CPPUNIT_ASSERT_EQUAL((uint32)0xFFFFFFFF, remap.back());
+
+    // New vertex indices must appear in increasing order of first use
+    uint32 nextVertex = 0u;
+    for (size_t i = 0; i < mIndices.size(); ++i)
+    {
+        const uint32 newIdx = remap[mIndices[i]];
+        CPPUNIT_ASSERT(newIdx <= nextVertex);
+        if (newIdx == nextVertex)
+            ++nextVertex;
+    }
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::testWeldVertices()
+{
+    // Duplicate the first 10 vertices at the end
+    std::vector<float> positions(mPositions);
+    positions.insert(positions.end(), mPositions.begin(), mPositions.begin() + 30u);
+    const size_t numVertices = positions.size() / 3u;
+
+    MeshOptimizer::VertexStream stream;
+    stream.data = reinterpret_cast<const uint8 *>(positions.data());
+    stream.bytesPerVertex = sizeof(float) * 3u;
+    MeshOptimizer::VertexStreamArray streams;
+    streams.push_back(stream);
+
+    std::vector<uint32> remap(numVertices);
+    const size_t numUnique = MeshOptimizer::weldVertices(streams, numVertices, remap.data());
+
+    CPPUNIT_ASSERT_EQUAL(mNumVertices, numUnique);
+    for (size_t i = 0; i < mNumVertices; ++i)
+        CPPUNIT_ASSERT_EQUAL((uint32)i, remap[i]);
+    for (size_t i = 0; i < 10u; ++i)
+        CPPUNIT_ASSERT_EQUAL((uint32)i, remap[mNumVertices + i]);
+}
+//--------------------------------------------------------------------------
+void Mesh2OptimizerTests::testClusters()
+{
+    std::vector<uint32> indices(mIndices);
+    MeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), mNumVertices);
+
+    MeshClusterArray clusters;
+    MeshOptimizer::buildClusters(indices.data(), indices.size(), mPositions.data(), mNumVertices,
+                                 64u, clusters);
+
+    CPPUNIT_ASSERT(clusters.size() >= indices.size() / (64u * 3u));
+    uint32 nextIndex = 0u;
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        const MeshCluster &cluster = clusters[i];
+        CPPUNIT_ASSERT_EQUAL(nextIndex, cluster.indexStart);
+        CPPUNIT_ASSERT(cluster.indexCount > 0u && cluster.indexCount <= 64u * 3u);
+        nextIndex += cluster.indexCount;
+
+        for (uint32 j = cluster.indexStart; j < cluster.indexStart + cluster.indexCount; ++j)
+        {
+            const float *pos = &mPositions[indices[j] * 3u];
+            const Vector3 vPos(pos[0], pos[1], pos[2]);
+            CPPUNIT_ASSERT(cluster.center.distance(vPos) <= cluster.radius + 1e-3f);
+        }
+    }
+    CPPUNIT_ASSERT_EQUAL((uint32)indices.size(), nextIndex);
+
+    // Nothing culled: all clusters are merged in a single range
+    FastArray<uint32> ranges;
+    size_t numVisible =
+        MeshOptimizer::cullClusters(clusters, Matrix4::IDENTITY, 0, 0u, 0, ranges);
+    CPPUNIT_ASSERT_EQUAL(indices.size(), numVisible);
+    CPPUNIT_ASSERT_EQUAL(size_t(2u), ranges.size());
+
+    // Only keep x <= 16
+    const Plane plane(Vector3::NEGATIVE_UNIT_X, -16.0f);
+    ranges.clear();
+    numVisible = MeshOptimizer::cullClusters(clusters, Matrix4::IDENTITY, &plane, 1u, 0, ranges);
+    CPPUNIT_ASSERT(numVisible > 0u && numVisible < indices.size() / 2u);
+
+    // The grid faces -Z. Seen from below nothing gets culled, from above some of it does
+    const Vector3 cameraBelow(32.0f, 32.0f, -1000.0f);
+    const Vector3 cameraAbove(32.0f, 32.0f, 1000.0f);
+    ranges.clear();
+    numVisible =
+        MeshOptimizer::cullClusters(clusters, Matrix4::IDENTITY, 0, 0u, &cameraBelow, ranges);
+    CPPUNIT_ASSERT_EQUAL(indices.size(), numVisible);
+    ranges.clear();
+    numVisible =
+        MeshOptimizer::cullClusters(clusters, Matrix4::IDENTITY, 0, 0u, &cameraAbove, ranges);
+    CPPUNIT_ASSERT(numVisible < indices.size());
+}
@@ -0,0 +1,64 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "NULLRenderSystemRoot.h"
+
+#include "OgreAbiUtils.h"
+#include "OgreNULLRenderSystem.h"
+#include "OgreRoot.h"
+#include "OgreWindow.h"
+
+using namespace Ogre;
+
+//--------------------------------------------------------------------------
+NULLRenderSystemRoot::NULLRenderSystemRoot() : mRoot(0), mRenderSystem(0), mWindow(0)
+{
+    const AbiCookie abiCookie = generateAbiCookie();
+    // No plugins nor config files. The LogManager was created by UnitTestSuite
+    mRoot = OGRE_NEW Root(&abiCookie, "", "", "");
+
+    mRenderSystem = OGRE_NEW NULLRenderSystem();
+    mRoot->addRenderSystem(mRenderSystem);
+    mRoot->setRenderSystem(mRenderSystem);
+    mRoot->initialise(false);
+    mWindow = mRoot->createRenderWindow("NULLRenderSystemRoot", 1u, 1u, false);
+}
+//--------------------------------------------------------------------------
+NULLRenderSystemRoot::~NULLRenderSystemRoot()
+{
+    OGRE_DELETE mRoot;
+    mRoot = 0;
+    // Root does not own render systems added via addRenderSystem
+    OGRE_DELETE mRenderSystem;
+    mRenderSystem = 0;
+}
+//--------------------------------------------------------------------------
+VaoManager *NULLRenderSystemRoot::getVaoManager() const
+{
+    return mRenderSystem->getVaoManager();
+}
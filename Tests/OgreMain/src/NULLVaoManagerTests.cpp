@@ -0,0 +1,258 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "NULLVaoManagerTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "Vao/OgreAsyncTicket.h"
+#include "Vao/OgreVaoManager.h"
+#include "Vao/OgreVertexBufferPacked.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(NULLVaoManagerTests);
+
+namespace
+{
+    /// Pool type of BT_DEFAULT and BT_IMMUTABLE buffers
+    const uint32 c_cpuInaccessible = 0u;
+
+    /// Returns the stats of the pools that hold BT_DEFAULT buffers, sorted by pool index
+    VaoManager::PoolFragmentationEntryVec getDefaultPools(const VaoManager *vaoManager)
+    {
+        VaoManager::PoolFragmentationEntryVec allPools;
+        vaoManager->getFragmentationStats(allPools);
+
+        VaoManager::PoolFragmentationEntryVec retVal;
+        for (size_t i = 0; i < allPools.size(); ++i)
+        {
+            if (allPools[i].poolType == c_cpuInaccessible)
+            {
+                CPPUNIT_ASSERT_EQUAL((uint32)retVal.size(), allPools[i].poolIdx);
+                retVal.push_back(allPools[i]);
+            }
+        }
+        return retVal;
+    }
+
+    /// getMemoryStats must agree with getFragmentationStats
+    void checkMemoryStats(VaoManager *vaoManager)
+    {
+        VaoManager::PoolFragmentationEntryVec pools;
+        vaoManager->getFragmentationStats(pools);
+
+        size_t capacityBytes = 0;
+        size_t freeBytes = 0;
+        for (size_t i = 0; i < pools.size(); ++i)
+        {
+            capacityBytes += pools[i].poolCapacity;
+            freeBytes += pools[i].freeBytes;
+        }
+
+        VaoManager::MemoryStatsEntryVec memoryStats;
+        size_t statsCapacityBytes;
+        size_t statsFreeBytes;
+        bool includesTextures;
+        vaoManager->getMemoryStats(memoryStats, statsCapacityBytes, statsFreeBytes, 0,
+                                   includesTextures);
+        CPPUNIT_ASSERT_EQUAL(capacityBytes, statsCapacityBytes);
+        CPPUNIT_ASSERT_EQUAL(freeBytes, statsFreeBytes);
+
+        size_t usedBytes = 0;
+        for (size_t i = 0; i < memoryStats.size(); ++i)
+            usedBytes += memoryStats[i].sizeBytes;
+        CPPUNIT_ASSERT_EQUAL(capacityBytes - freeBytes, usedBytes);
+    }
+
+    /// Each buffer gets different contents, so that mixing them up gets caught
+    void fillBuffer(VertexBufferPacked *buffer, float value)
+    {
+        vector<float>::type data(buffer->getNumElements() * 4u, value);
+        buffer->upload(&data[0], 0, buffer->getNumElements());
+    }
+
+    void checkBuffer(VertexBufferPacked *buffer, float value)
+    {
+        AsyncTicketPtr ticket = buffer->readRequest(0, buffer->getNumElements());
+        const float *data = reinterpret_cast<const float *>(ticket->map());
+        for (size_t i = 0; i < buffer->getNumElements() * 4u; ++i)
+            CPPUNIT_ASSERT_EQUAL(value, data[i]);
+        ticket->unmap();
+    }
+}
+//--------------------------------------------------------------------------
+void NULLVaoManagerTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = new NULLRenderSystemRoot();
+    mVaoManager = mRoot->getVaoManager();
+}
+//--------------------------------------------------------------------------
+void NULLVaoManagerTests::tearDown()
+{
+    delete mRoot;
+    mRoot = 0;
+    mVaoManager = 0;
+}
+//--------------------------------------------------------------------------
+VertexBufferPacked *NULLVaoManagerTests::createVertexBuffer(size_t numVertices)
+{
+    // 16 bytes per vertex, so that no padding is needed between consecutive buffers
+    VertexElement2Vec vertexElements;
+    vertexElements.push_back(VertexElement2(VET_FLOAT4, VES_POSITION));
+    return mVaoManager->createVertexBuffer(vertexElements, numVertices, BT_DEFAULT, 0, false);
+}
+//--------------------------------------------------------------------------
+void NULLVaoManagerTests::testSubAllocation()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const VaoManager::PoolFragmentationEntryVec initialPools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT(!initialPools.empty());
+    const VaoManager::PoolFragmentationEntry &initialPool = initialPools.front();
+
+    VertexBufferPacked *buffers[3];
+    for (size_t i = 0; i < 3u; ++i)
+        buffers[i] = createVertexBuffer(1000u);
+
+    VaoManager::PoolFragmentationEntryVec pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPools.size(), pools.size());
+    CPPUNIT_ASSERT_EQUAL(initialPool.freeBytes - 48000u, pools.front().freeBytes);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks, pools.front().numFreeBlocks);
+    checkMemoryStats(mVaoManager);
+
+    // Destroying the middle one leaves a hole
+    mVaoManager->destroyVertexBuffer(buffers[1]);
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPool.freeBytes - 32000u, pools.front().freeBytes);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks + 1u, pools.front().numFreeBlocks);
+    CPPUNIT_ASSERT(pools.front().getFragmentation() > 0.0f);
+    checkMemoryStats(mVaoManager);
+
+    // Which merges back with its neighbours
+    mVaoManager->destroyVertexBuffer(buffers[0]);
+    mVaoManager->destroyVertexBuffer(buffers[2]);
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPool.freeBytes, pools.front().freeBytes);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks, pools.front().numFreeBlocks);
+    CPPUNIT_ASSERT_EQUAL(initialPool.largestFreeBlock, pools.front().largestFreeBlock);
+    checkMemoryStats(mVaoManager);
+}
+//--------------------------------------------------------------------------
+void NULLVaoManagerTests::testCleanupEmptyPools()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const VaoManager::PoolFragmentationEntryVec initialPools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, initialPools.size());
+
+    // 40MB each. Only one fits in each 64MB pool
+    const size_t numVertices = 40u * 1024u * 1024u / 16u;
+    VertexBufferPacked *buffers[3];
+    for (size_t i = 0; i < 3u; ++i)
+        buffers[i] = createVertexBuffer(numVertices);
+
+    VaoManager::PoolFragmentationEntryVec pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL((size_t)3u, pools.size());
+    checkMemoryStats(mVaoManager);
+
+    // The last pool takes the place of the second one
+    mVaoManager->destroyVertexBuffer(buffers[1]);
+    mVaoManager->cleanupEmptyPools();
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL((size_t)2u, pools.size());
+    CPPUNIT_ASSERT(pools[0].freeBytes < pools[0].poolCapacity - 40u * 1024u * 1024u);
+    CPPUNIT_ASSERT_EQUAL(pools[1].poolCapacity - 40u * 1024u * 1024u, pools[1].freeBytes);
+    checkMemoryStats(mVaoManager);
+
+    // Must be released from the pool it was moved to
+    mVaoManager->destroyVertexBuffer(buffers[2]);
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(pools[1].poolCapacity, pools[1].freeBytes);
+
+    mVaoManager->cleanupEmptyPools();
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, pools.size());
+
+    mVaoManager->destroyVertexBuffer(buffers[0]);
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPools.front().freeBytes, pools.front().freeBytes);
+    checkMemoryStats(mVaoManager);
+}
+//--------------------------------------------------------------------------
+void NULLVaoManagerTests::testDefragment()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const VaoManager::PoolFragmentationEntryVec initialPools = getDefaultPools(mVaoManager);
+    const VaoManager::PoolFragmentationEntry &initialPool = initialPools.front();
+
+    VertexBufferPacked *buffers[6];
+    for (size_t i = 0; i < 6u; ++i)
+    {
+        buffers[i] = createVertexBuffer(1000u);
+        fillBuffer(buffers[i], (float)i);
+    }
+
+    // Every other buffer leaves a hole: [free, 1, free, 3, free, 5, free...]
+    for (size_t i = 0; i < 6u; i += 2u)
+        mVaoManager->destroyVertexBuffer(buffers[i]);
+
+    VaoManager::PoolFragmentationEntryVec pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks + 3u, pools.front().numFreeBlocks);
+    CPPUNIT_ASSERT(pools.front().getFragmentation() > 0.0f);
+
+    // The budget is reached after the first buffer: 5 goes to the first hole
+    CPPUNIT_ASSERT_EQUAL((size_t)16000u, mVaoManager->defragment(1u));
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks + 1u, pools.front().numFreeBlocks);
+
+    // 3 goes to the second hole. 1 has nowhere lower to go
+    CPPUNIT_ASSERT_EQUAL((size_t)16000u, mVaoManager->defragment(1024u * 1024u));
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPool.freeBytes - 48000u, pools.front().freeBytes);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks, pools.front().numFreeBlocks);
+    CPPUNIT_ASSERT_EQUAL(initialPool.largestFreeBlock - 48000u, pools.front().largestFreeBlock);
+    checkMemoryStats(mVaoManager);
+
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mVaoManager->defragment(1024u * 1024u));
+
+    for (size_t i = 1; i < 6u; i += 2u)
+        checkBuffer(buffers[i], (float)i);
+
+    // The ranges are released from where they were moved to
+    for (size_t i = 1; i < 6u; i += 2u)
+        mVaoManager->destroyVertexBuffer(buffers[i]);
+    pools = getDefaultPools(mVaoManager);
+    CPPUNIT_ASSERT_EQUAL(initialPool.freeBytes, pools.front().freeBytes);
+    CPPUNIT_ASSERT_EQUAL(initialPool.numFreeBlocks, pools.front().numFreeBlocks);
+    checkMemoryStats(mVaoManager);
+}
@@ -0,0 +1,240 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ObjectSpatialIndexTests.h"
+#include "UnitTestSuite.h"
+
+#include "Math/Array/OgreObjectSpatialIndex.h"
+#include "OgreMath.h"
+#include "OgrePlane.h"
+#include "OgreRay.h"
+#include "OgreSphere.h"
+
+#include <set>
+#include <stdlib.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ObjectSpatialIndexTests);
+
+/// Any non-null pointer will do, the index never dereferences the owners
+static MovableObject *const c_fakeOwner = reinterpret_cast<MovableObject *>(size_t(16u));
+
+static Real randomReal(Real minValue, Real maxValue)
+{
+    return minValue + (maxValue - minValue) * Real(rand()) / Real(RAND_MAX);
+}
+
+static Vector3 randomVector3(Real minValue, Real maxValue)
+{
+    return Vector3(randomReal(minValue, maxValue), randomReal(minValue, maxValue),
+                   randomReal(minValue, maxValue));
+}
+
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+
+    mNumObjects = 4001u;
+    const size_t numPacks = (mNumObjects + ARRAY_PACKED_REALS - 1u) / ARRAY_PACKED_REALS;
+    const size_t numSlots = numPacks * ARRAY_PACKED_REALS;
+
+    mWorldAabbs = reinterpret_cast<ArrayAabb *>(
+        OGRE_MALLOC_SIMD(sizeof(ArrayAabb) * numPacks, MEMCATEGORY_SCENE_OBJECTS));
+    mWorldRadius.resize(numSlots, 0);
+    mOwners.resize(numSlots, 0);
+    mUnusedReals.resize(numSlots, 0);
+    mUnusedFlags.resize(numSlots, 0);
+    mUnusedParents.resize(numSlots, 0);
+
+    mObjData.mIndex = 0;
+    mObjData.mParents = &mUnusedParents[0];
+    mObjData.mOwner = &mOwners[0];
+    mObjData.mLocalAabb = mWorldAabbs;
+    mObjData.mWorldAabb = mWorldAabbs;
+    mObjData.mLocalRadius = &mUnusedReals[0];
+    mObjData.mWorldRadius = &mWorldRadius[0];
+    mObjData.mDistanceToCamera = &mUnusedFlags[0];
+    mObjData.mUpperDistance[0] = &mUnusedReals[0];
+    mObjData.mUpperDistance[1] = &mUnusedReals[0];
+    mObjData.mVisibilityFlags = &mUnusedFlags[0];
+    mObjData.mQueryFlags = &mUnusedFlags[0];
+    mObjData.mLightMask = &mUnusedFlags[0];
+
+    for (size_t i = 0; i < numSlots; ++i)
+        mWorldAabbs[i / ARRAY_PACKED_REALS].setFromAabb(Aabb::BOX_INFINITE, i % ARRAY_PACKED_REALS);
+
+    // Objects are created in random order, thus packs are not spatially coherent.
+    // The index must still reject most of them since its leaves are the objects.
+    for (size_t i = 0; i < mNumObjects; ++i)
+    {
+        const Vector3 halfSize = randomVector3(0.1f, 2.0f);
+        setObject(i, Aabb(randomVector3(-500.0f, 500.0f), halfSize), halfSize.length());
+        mOwners[i] = c_fakeOwner;
+    }
+}
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::tearDown()
+{
+    OGRE_FREE_SIMD(mWorldAabbs, MEMCATEGORY_SCENE_OBJECTS);
+    mWorldAabbs = 0;
+}
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::setObject(size_t idx, const Aabb &aabb, Real radius)
+{
+    mWorldAabbs[idx / ARRAY_PACKED_REALS].setFromAabb(aabb, idx % ARRAY_PACKED_REALS);
+    mWorldRadius[idx] = radius;
+}
+//--------------------------------------------------------------------------
+Aabb ObjectSpatialIndexTests::getObject(size_t idx) const
+{
+    return mWorldAabbs[idx / ARRAY_PACKED_REALS].getAsAabb(idx % ARRAY_PACKED_REALS);
+}
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::checkQueries(const ObjectSpatialIndex &spatialIndex)
+{
+    for (size_t n = 0; n < 20u; ++n)
+    {
+        const Aabb queryAabb(randomVector3(-500.0f, 500.0f), randomVector3(5.0f, 50.0f));
+        const Sphere querySphere(randomVector3(-500.0f, 500.0f), randomReal(5.0f, 50.0f));
+        const Ray queryRay(randomVector3(-500.0f, 500.0f), randomVector3(-1.0f, 1.0f).normalisedCopy());
+
+        // A box shaped frustum, with the planes facing inwards
+        const Vector3 frustumMin = randomVector3(-500.0f, 400.0f);
+        const Vector3 frustumMax = frustumMin + randomVector3(10.0f, 100.0f);
+        Plane planes[6];
+        for (size_t i = 0; i < 3u; ++i)
+        {
+            Vector3 normal(Vector3::ZERO);
+            normal[i] = 1.0f;
+            planes[i * 2u] = Plane(normal, frustumMin);
+            planes[i * 2u + 1u] = Plane(-normal, frustumMax);
+        }
+
+        FastArray<uint32> aabbPacks, spherePacks, rayPacks, frustumPacks;
+        spatialIndex.queryAabb(queryAabb, aabbPacks);
+        spatialIndex.querySphere(querySphere, spherePacks);
+        spatialIndex.queryRay(queryRay, rayPacks);
+        spatialIndex.cullFrustum(planes, frustumPacks);
+
+        const std::set<uint32> aabbSet(aabbPacks.begin(), aabbPacks.end());
+        const std::set<uint32> sphereSet(spherePacks.begin(), spherePacks.end());
+        const std::set<uint32> raySet(rayPacks.begin(), rayPacks.end());
+        const std::set<uint32> frustumSet(frustumPacks.begin(), frustumPacks.end());
+
+        // No pack may be returned twice
+        CPPUNIT_ASSERT_EQUAL(aabbSet.size(), aabbPacks.size());
+        CPPUNIT_ASSERT_EQUAL(frustumSet.size(), frustumPacks.size());
+
+        for (size_t i = 0; i < mNumObjects; ++i)
+        {
+            if (!mOwners[i])
+                continue;
+
+            const uint32 packIdx = static_cast<uint32>(i / ARRAY_PACKED_REALS);
+            const Aabb aabb = getObject(i);
+
+            if (aabb.intersects(queryAabb))
+                CPPUNIT_ASSERT(aabbSet.count(packIdx));
+            const Real sphereDistance = aabb.mCenter.distance(querySphere.getCenter());
+            if (sphereDistance <= querySphere.getRadius() + mWorldRadius[i])
+                CPPUNIT_ASSERT(sphereSet.count(packIdx));
+            if (queryRay.intersects(AxisAlignedBox(aabb.getMinimum(), aabb.getMaximum())).first)
+                CPPUNIT_ASSERT(raySet.count(packIdx));
+            if (aabb.intersects(Aabb::newFromExtents(frustumMin, frustumMax)))
+                CPPUNIT_ASSERT(frustumSet.count(packIdx));
+        }
+
+        // The index must be rejecting most of the scene
+        const size_t numPacks = (mNumObjects + ARRAY_PACKED_REALS - 1u) / ARRAY_PACKED_REALS;
+        CPPUNIT_ASSERT(aabbPacks.size() < numPacks / 4u);
+        CPPUNIT_ASSERT(frustumPacks.size() < numPacks / 4u);
+    }
+}
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::testQueries()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectSpatialIndex spatialIndex;
+    CPPUNIT_ASSERT(spatialIndex.needsRebuild());
+    spatialIndex.build(mObjData, mNumObjects, 0);
+    CPPUNIT_ASSERT(!spatialIndex.needsRebuild());
+    CPPUNIT_ASSERT_EQUAL(mNumObjects, spatialIndex.getNumObjects());
+    const uint32 lastPack = uint32((mNumObjects - 1u) / ARRAY_PACKED_REALS);
+    CPPUNIT_ASSERT_EQUAL(size_t(1u), spatialIndex.getNumObjectsInPack(lastPack));
+
+    checkQueries(spatialIndex);
+}
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::testRefit()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    ObjectSpatialIndex spatialIndex;
+    spatialIndex.build(mObjData, mNumObjects, 0);
+
+    // Teleport a few objects far away from their packs' neighbours
+    for (size_t i = 0; i < mNumObjects; i += 97u)
+        setObject(i, Aabb(randomVector3(-500.0f, 500.0f), Vector3(1.0f)), Math::Sqrt(3.0f));
+
+    spatialIndex.refit(mObjData, 0);
+    checkQueries(spatialIndex);
+
+    spatialIndex._notifyLayoutChanged();
+    CPPUNIT_ASSERT(spatialIndex.needsRebuild());
+}
+//--------------------------------------------------------------------------
+void ObjectSpatialIndexTests::testUnusedSlots()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // Unused slots have infinite boxes. If they were taken into account
+    // every query would return every pack.
+    for (size_t i = 0; i < mNumObjects; i += 3u)
+        mOwners[i] = 0;
+
+    ObjectSpatialIndex spatialIndex;
+    spatialIndex.build(mObjData, mNumObjects, 0);
+    for (size_t i = 0; i < mNumObjects; i += 3u)
+        setObject(i, Aabb::BOX_INFINITE, std::numeric_limits<Real>::infinity());
+    spatialIndex.refit(mObjData, 0);
+
+    checkQueries(spatialIndex);
+
+    // Objects with infinite bounds must always be found
+    mOwners[0] = c_fakeOwner;
+    spatialIndex.build(mObjData, mNumObjects, 0);
+
+    FastArray<uint32> packs;
+    spatialIndex.queryAabb(Aabb(Vector3(1e6f), Vector3(1.0f)), packs);
+    CPPUNIT_ASSERT_EQUAL(size_t(1u), packs.size());
+    CPPUNIT_ASSERT_EQUAL(uint32(0u), packs[0]);
+}
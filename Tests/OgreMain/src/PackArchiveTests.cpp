@@ -0,0 +1,261 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "PackArchiveTests.h"
+#include "UnitTestSuite.h"
+
+#include "OgrePackArchive.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(PackArchiveTests);
+
+/// Adds offsetDelta & sizeDelta to block blockIdx of the first entry in the TOC of the pack.
+/// The first entry must be named firstEntryName.
+static void patchFirstEntryBlock(const String &packPath, const String &firstEntryName,
+                                 size_t blockIdx, int64 offsetDelta, int32 sizeDelta)
+{
+    FILE *file = fopen(packPath.c_str(), "r+b");
+    CPPUNIT_ASSERT(file != 0);
+
+    // PackHeader: magic, version, blockSize, numEntries, then tocOffset
+    uint64 tocOffset = 0;
+    fseek(file, 16, SEEK_SET);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, fread(&tocOffset, sizeof(tocOffset), 1u, file));
+
+    // Entry: name length, name, size, modified time, codec, then 12 bytes per block
+    const long blockPos = static_cast<long>(tocOffset + 2u + firstEntryName.size() + 8u + 8u +
+                                            1u + blockIdx * 12u);
+    uint64 offset = 0;
+    uint32 size = 0;
+    fseek(file, blockPos, SEEK_SET);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, fread(&offset, sizeof(offset), 1u, file));
+    CPPUNIT_ASSERT_EQUAL((size_t)1, fread(&size, sizeof(size), 1u, file));
+
+    offset = static_cast<uint64>(static_cast<int64>(offset) + offsetDelta);
+    size = static_cast<uint32>(static_cast<int32>(size) + sizeDelta);
+    fseek(file, blockPos, SEEK_SET);
+    fwrite(&offset, sizeof(offset), 1u, file);
+    fwrite(&size, sizeof(size), 1u, file);
+    fclose(file);
+}
+
+//--------------------------------------------------------------------------
+void PackArchiveTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+
+    mPackPath = "./PackArchiveTest.pack";
+
+    mLargeFile.resize(3u * 1024u * 1024u + 123u);
+    for (size_t i = 0; i < mLargeFile.size(); ++i)
+        mLargeFile[i] = static_cast<uint8>((i / 7u) % 50u + rand() % 3);
+
+    mRandomFile.resize(100000u);
+    for (size_t i = 0; i < mRandomFile.size(); ++i)
+        mRandomFile[i] = static_cast<uint8>(rand());
+
+    writePack();
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::writePack()
+{
+    const char text[] = "this is line 1\nthis is line 2\n";
+
+    PackArchiveWriter writer(mPackPath, 64u * 1024u);
+    writer.addFile("models/large.bin", mLargeFile.data(), mLargeFile.size(), PackArchive::CodecLz4,
+                   1234);
+    writer.addFile("random.bin", mRandomFile.data(), mRandomFile.size(), PackArchive::CodecLz4);
+    writer.addFile("models/text/lines.txt", text, sizeof(text) - 1u, PackArchive::CodecStored);
+    writer.finish();
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::tearDown()
+{
+    remove(mPackPath.c_str());
+    PackArchive::setNumDecompressionThreads(0u);
+    PackArchive::setParallelMinSize(1024u * 1024u);
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::testListAndFind()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    PackArchive arch(mPackPath, "Pack");
+    arch.load();
+
+    StringVectorPtr files = arch.list(true, false);
+    CPPUNIT_ASSERT_EQUAL((size_t)3, files->size());
+
+    StringVectorPtr rootFiles = arch.list(false, false);
+    CPPUNIT_ASSERT_EQUAL((size_t)1, rootFiles->size());
+    CPPUNIT_ASSERT_EQUAL(String("random.bin"), rootFiles->at(0));
+
+    StringVectorPtr dirs = arch.list(true, true);
+    CPPUNIT_ASSERT_EQUAL((size_t)2, dirs->size());
+
+    StringVectorPtr found = arch.find("models/*.txt");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, found->size());
+    CPPUNIT_ASSERT_EQUAL(String("models/text/lines.txt"), found->at(0));
+
+    FileInfoListPtr infos = arch.findFileInfo("large.bin");
+    CPPUNIT_ASSERT_EQUAL((size_t)1, infos->size());
+    CPPUNIT_ASSERT_EQUAL(mLargeFile.size(), infos->at(0).uncompressedSize);
+    CPPUNIT_ASSERT(infos->at(0).compressedSize < infos->at(0).uncompressedSize);
+
+    CPPUNIT_ASSERT(arch.exists("models/large.bin"));
+    CPPUNIT_ASSERT(!arch.exists("large.bin"));
+    CPPUNIT_ASSERT_EQUAL((time_t)1234, arch.getModifiedTime("models/large.bin"));
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::testRead()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    PackArchive::setNumDecompressionThreads(1u);
+
+    PackArchive arch(mPackPath, "Pack");
+    arch.load();
+
+    DataStreamPtr stream = arch.open("models/large.bin");
+    std::vector<uint8> data(stream->size());
+    CPPUNIT_ASSERT_EQUAL(mLargeFile.size(), stream->read(data.data(), data.size()));
+    CPPUNIT_ASSERT(data == mLargeFile);
+    CPPUNIT_ASSERT(stream->eof());
+
+    stream = arch.open("random.bin");
+    data.resize(stream->size());
+    CPPUNIT_ASSERT_EQUAL(mRandomFile.size(), stream->read(data.data(), data.size()));
+    CPPUNIT_ASSERT(data == mRandomFile);
+
+    stream = arch.open("models/text/lines.txt");
+    CPPUNIT_ASSERT_EQUAL(String("this is line 1"), stream->getLine());
+    CPPUNIT_ASSERT_EQUAL(String("this is line 2"), stream->getLine());
+
+    // Streams outlive the archive
+    stream = arch.open("random.bin");
+    arch.unload();
+    data.clear();
+    data.resize(stream->size());
+    stream->read(data.data(), data.size());
+    CPPUNIT_ASSERT(data == mRandomFile);
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::testSeek()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    PackArchive::setNumDecompressionThreads(1u);
+
+    PackArchive arch(mPackPath, "Pack");
+    arch.load();
+
+    DataStreamPtr stream = arch.open("models/large.bin");
+    std::vector<uint8> data;
+    for (int i = 0; i < 100; ++i)
+    {
+        const size_t pos = static_cast<size_t>(rand()) % mLargeFile.size();
+        const size_t size =
+            std::min<size_t>(static_cast<size_t>(rand()) % 200000u, mLargeFile.size() - pos);
+        data.resize(size);
+        stream->seek(pos);
+        CPPUNIT_ASSERT_EQUAL(pos, stream->tell());
+        CPPUNIT_ASSERT_EQUAL(size, stream->read(data.data(), size));
+        CPPUNIT_ASSERT(size == 0u || memcmp(data.data(), &mLargeFile[pos], size) == 0);
+    }
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::testParallelRead()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    PackArchive::setNumDecompressionThreads(4u);
+    PackArchive::setParallelMinSize(0u);
+
+    PackArchive arch(mPackPath, "Pack");
+    arch.load();
+
+    DataStreamPtr stream = arch.open("models/large.bin");
+    CPPUNIT_ASSERT(stream->getDataPtr() != 0);
+    CPPUNIT_ASSERT_EQUAL(mLargeFile.size(), stream->size());
+    CPPUNIT_ASSERT(memcmp(stream->getDataPtr(), mLargeFile.data(), mLargeFile.size()) == 0);
+}
+//--------------------------------------------------------------------------
+void PackArchiveTests::testRejectsBadBlocks()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const String firstEntryName = "models/large.bin";
+    const size_t numBlocks = (mLargeFile.size() + 64u * 1024u - 1u) / (64u * 1024u);
+
+    struct Patch
+    {
+        size_t blockIdx;
+        int64 offsetDelta;
+        int32 sizeDelta;
+    };
+    const Patch patches[] = {
+        // Gap between two blocks
+        { 1u, 1, 0 },
+        // Overlaps the previous block
+        { 2u, -1, 0 },
+        // The last block runs into the TOC & past the end of the file
+        { numBlocks - 1u, 0, 16 * 1024 * 1024 },
+    };
+
+    for (size_t i = 0; i < sizeof(patches) / sizeof(patches[0]); ++i)
+    {
+        if (i != 0u)
+            writePack();
+
+        {
+            // The unpatched archive must load
+            PackArchive arch(mPackPath, "Pack");
+            arch.load();
+        }
+
+        patchFirstEntryBlock(mPackPath, firstEntryName, patches[i].blockIdx,
+                             patches[i].offsetDelta, patches[i].sizeDelta);
+
+        bool rejected = false;
+        try
+        {
+            PackArchive arch(mPackPath, "Pack");
+            arch.load();
+        }
+        catch (const InvalidParametersException &)
+        {
+            rejected = true;
+        }
+        CPPUNIT_ASSERT(rejected);
+    }
+}
@@ -0,0 +1,189 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "RenderQueueSortTests.h"
+#include "UnitTestSuite.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(RenderQueueSortTests);
+
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::generate(QueuedRenderableArray &outQueue, size_t numRenderables,
+                                    size_t numUniqueHashes)
+{
+    // Few unique hashes so that there are many ties. Spread the bits across
+    // the whole 64-bit range so that every radix sort pass gets exercised.
+    // The Renderable pointer is never dereferenced; it's a unique id to tell ties apart.
+    const size_t offset = outQueue.size();
+    for (size_t i = 0; i < numRenderables; ++i)
+    {
+        const uint64 hashId = static_cast<uint64>(rand()) % numUniqueHashes;
+        const uint64 hash = hashId * 0x9E3779B97F4A7C15ull;
+        outQueue.push_back(QueuedRenderable(
+            hash, reinterpret_cast<Renderable *>(static_cast<uintptr_t>(offset + i + 1u)), 0));
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::checkSameAsStableSort(const QueuedRenderableArray &unsorted,
+                                                 const QueuedRenderableArray &sorted)
+{
+    QueuedRenderableArray expected(unsorted);
+    std::stable_sort(expected.begin(), expected.end());
+
+    CPPUNIT_ASSERT_EQUAL(expected.size(), sorted.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        CPPUNIT_ASSERT(expected[i].hash == sorted[i].hash);
+        CPPUNIT_ASSERT(expected[i].renderable == sorted[i].renderable);
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::testRadixSort()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    QueuedRenderableArray scratch;
+
+    const size_t numRenderables[] = { 0u, 1u, 2u, 100u, 1024u, 5000u };
+    const size_t numUniqueHashes[] = { 1u, 3u, 50u, 100000u };
+
+    for (size_t i = 0; i < sizeof(numRenderables) / sizeof(numRenderables[0]); ++i)
+    {
+        for (size_t j = 0; j < sizeof(numUniqueHashes) / sizeof(numUniqueHashes[0]); ++j)
+        {
+            QueuedRenderableArray unsorted;
+            generate(unsorted, numRenderables[i], numUniqueHashes[j]);
+
+            QueuedRenderableArray sorted(unsorted);
+            RenderQueue::_radixSort(sorted, scratch);
+            checkSameAsStableSort(unsorted, sorted);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::testMergeSortedRuns()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    QueuedRenderableArray scratch;
+
+    for (size_t numRuns = 1u; numRuns <= 9u; ++numRuns)
+    {
+        // Each run is what one worker thread sorted on its own (may be empty).
+        QueuedRenderableArray unsorted;
+        QueuedRenderableArray runs;
+        FastArray<size_t> runOffsets;
+
+        for (size_t r = 0; r < numRuns; ++r)
+        {
+            const size_t runStart = unsorted.size();
+            generate(unsorted, static_cast<size_t>(rand()) % 300u, 20u);
+            runOffsets.push_back(runs.size());
+
+            QueuedRenderableArray run;
+            run.appendPOD(unsorted.begin() + runStart, unsorted.end());
+            std::stable_sort(run.begin(), run.end());
+            runs.appendPOD(run.begin(), run.end());
+        }
+        runOffsets.push_back(runs.size());
+
+        RenderQueue::_mergeSortedRuns(runs, runOffsets, scratch);
+        checkSameAsStableSort(unsorted, runs);
+    }
+}
+//--------------------------------------------------------------------------
+void RenderQueueSortTests::testCoherentSort()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    QueuedRenderableArray scratch;
+    RenderQueue::CoherentSortKeyArray keys;
+    vector<uint32>::type order;
+
+    // The same objects get queued every frame in the same order, but their hashes
+    // may change (e.g. sorted by depth) and some may appear or disappear.
+    QueuedRenderableArray frame;
+    generate(frame, 2000u, 200u);
+
+    for (size_t frameIdx = 0; frameIdx < 6u; ++frameIdx)
+    {
+        switch (frameIdx)
+        {
+        case 0:
+        case 1:
+            // First frame; then exactly the same as last frame
+            break;
+        case 2:
+            // Slight changes. Insertion sort should be enough
+            for (size_t i = 0; i < 20u; ++i)
+                frame[static_cast<size_t>(rand()) % frame.size()].hash += 0x9E3779B97F4A7C15ull;
+            break;
+        case 3:
+            // New objects appeared
+            generate(frame, 100u, 200u);
+            break;
+        case 4:
+            // Objects disappeared
+            frame.resizePOD(frame.size() / 2u);
+            break;
+        case 5:
+        {
+            // Everything changed. Must fallback to a full sort
+            QueuedRenderableArray newFrame;
+            generate(newFrame, frame.size(), 200u);
+            for (size_t i = 0; i < frame.size(); ++i)
+                frame[i].hash = newFrame[i].hash;
+            break;
+        }
+        }
+
+        QueuedRenderableArray sorted(frame);
+        RenderQueue::_coherentSort(sorted, order, keys, scratch);
+        checkSameAsStableSort(frame, sorted);
+
+        // order must map each sorted entry back to where it was queued
+        CPPUNIT_ASSERT_EQUAL(frame.size(), order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            CPPUNIT_ASSERT(sorted[i].renderable == frame[order[i]].renderable);
+    }
+}
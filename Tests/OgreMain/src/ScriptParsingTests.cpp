@@ -0,0 +1,310 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "ScriptParsingTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "OgreResourceGroupManager.h"
+#include "OgreScriptLoader.h"
+#include "OgreStringConverter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(ScriptParsingTests);
+
+namespace
+{
+    const char *c_groupName = "ScriptParsingTests";
+    const size_t c_numScripts = 40u;
+
+    bool isSkipped(const String &scriptName)
+    {
+        return StringConverter::parseUnsignedInt(scriptName.substr(19u, 2u)) % 3u == 1u;
+    }
+
+    /// Records what it's asked to parse. Each script contains its own name.
+    class TestScriptLoader : public ScriptLoader
+    {
+        StringVector mPatterns;
+        StringVector &mEvents;
+        bool mSupportsPrepare;
+
+    public:
+        std::atomic<size_t> mNumPrepared;
+
+        TestScriptLoader(StringVector &events, bool supportsPrepare) :
+            mEvents(events),
+            mSupportsPrepare(supportsPrepare),
+            mNumPrepared(0u)
+        {
+            mPatterns.push_back("*.rgmscript");
+        }
+
+        const StringVector &getScriptPatterns() const override { return mPatterns; }
+        void parseScript(DataStreamPtr &stream, const String &groupName) override
+        {
+            mEvents.push_back("parsed " + stream->getAsString());
+        }
+        bool supportsPrepareScript() const override { return mSupportsPrepare; }
+        Any prepareScript(DataStreamPtr &stream, time_t modifiedTime) override
+        {
+            ++mNumPrepared;
+            return Any(stream->getAsString());
+        }
+        void parsePreparedScript(const Any &prepared, const String &groupName) override
+        {
+            mEvents.push_back("parsed " + any_cast<String>(prepared));
+        }
+        Real getLoadingOrder() const override { return 1000.0f; }
+    };
+
+    /// Records the listener events, skipping every third script
+    class TestScriptListener : public ResourceGroupListener, public ResourceLoadingListener
+    {
+        StringVector &mEvents;
+
+    public:
+        TestScriptListener(StringVector &events) : mEvents(events) {}
+
+        void resourceGroupScriptingStarted(const String &groupName, size_t scriptCount) override
+        {
+            mEvents.push_back("group started " + StringConverter::toString(scriptCount));
+        }
+        void scriptParseStarted(const String &scriptName, bool &skipThisScript) override
+        {
+            skipThisScript = isSkipped(scriptName);
+            mEvents.push_back("started " + scriptName);
+        }
+        void scriptParseEnded(const String &scriptName, bool skipped) override
+        {
+            CPPUNIT_ASSERT_EQUAL(isSkipped(scriptName), skipped);
+            mEvents.push_back("ended " + scriptName);
+        }
+        void resourceGroupScriptingEnded(const String &groupName) override
+        {
+            mEvents.push_back("group ended");
+        }
+        void resourceGroupLoadStarted(const String &groupName, size_t resourceCount) override {}
+        void resourceLoadStarted(const ResourcePtr &resource) override {}
+        void resourceLoadEnded() override {}
+        void resourceGroupLoadEnded(const String &groupName) override {}
+
+        DataStreamPtr resourceLoading(const String &name, const String &group,
+                                      Resource *resource) override
+        {
+            return DataStreamPtr();
+        }
+        bool grouplessResourceExists(const String &name) override { return false; }
+        DataStreamPtr grouplessResourceLoading(const String &name) override
+        {
+            return DataStreamPtr();
+        }
+        DataStreamPtr grouplessResourceOpened(const String &name, Archive *archive,
+                                              DataStreamPtr &dataStream) override
+        {
+            return dataStream;
+        }
+        void resourceStreamOpened(const String &name, const String &group, Resource *resource,
+                                  DataStreamPtr &dataStream) override
+        {
+            mEvents.push_back("opened " + name);
+        }
+        bool resourceCollision(Resource *resource, ResourceManager *resourceManager) override
+        {
+            return false;
+        }
+    };
+}  // namespace
+
+//--------------------------------------------------------------------------
+void ScriptParsingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = new NULLRenderSystemRoot();
+
+    for (size_t i = 0; i < c_numScripts; ++i)
+    {
+        const String name = "ScriptParsingTests_" + StringConverter::toString(i, 2u, '0');
+        mScriptPaths.push_back("./" + name + ".rgmscript");
+        FILE *file = fopen(mScriptPaths.back().c_str(), "wb");
+        CPPUNIT_ASSERT(file != 0);
+        fwrite(name.c_str(), 1u, name.size(), file);
+        fclose(file);
+    }
+}
+//--------------------------------------------------------------------------
+void ScriptParsingTests::tearDown()
+{
+    delete mRoot;
+    mRoot = 0;
+
+    for (size_t i = 0; i < mScriptPaths.size(); ++i)
+        remove(mScriptPaths[i].c_str());
+    mScriptPaths.clear();
+}
+//--------------------------------------------------------------------------
+StringVector ScriptParsingTests::parseScripts(uint32 numThreads, bool supportsPrepare,
+                                              size_t &outNumPrepared)
+{
+    StringVector events;
+    TestScriptLoader loader(events, supportsPrepare);
+    TestScriptListener listener(events);
+
+    ResourceGroupManager &resourceGroupManager = ResourceGroupManager::getSingleton();
+    resourceGroupManager.addResourceLocation("./", "FileSystem", c_groupName);
+    resourceGroupManager._registerScriptLoader(&loader);
+    resourceGroupManager.addResourceGroupListener(&listener);
+    resourceGroupManager.setLoadingListener(&listener);
+    resourceGroupManager.setNumScriptParsingThreads(numThreads);
+
+    resourceGroupManager.initialiseResourceGroup(c_groupName, false);
+
+    resourceGroupManager.setLoadingListener(0);
+    resourceGroupManager.removeResourceGroupListener(&listener);
+    resourceGroupManager._unregisterScriptLoader(&loader);
+    resourceGroupManager.destroyResourceGroup(c_groupName);
+
+    outNumPrepared = loader.mNumPrepared;
+    return events;
+}
+//--------------------------------------------------------------------------
+void ScriptParsingTests::checkEventOrder(const StringVector &events)
+{
+    CPPUNIT_ASSERT_EQUAL(String("group started ") + StringConverter::toString(c_numScripts),
+                         events.front());
+    CPPUNIT_ASSERT_EQUAL(String("group ended"), events.back());
+
+    // Script names in the order scriptParseStarted saw them
+    StringVector started;
+    size_t numEnded = 0;
+    size_t numParsed = 0;
+    for (size_t i = 1u; i + 1u < events.size(); ++i)
+    {
+        const String &event = events[i];
+        if (event.compare(0, 8, "started ") == 0)
+        {
+            started.push_back(event.substr(8u));
+            continue;
+        }
+
+        if (event.compare(0, 7, "opened ") == 0)
+        {
+            // Opened after it started, and only if not skipped
+            const String openedName = event.substr(7u);
+            CPPUNIT_ASSERT(std::find(started.begin() + numEnded, started.end(), openedName) !=
+                           started.end());
+            CPPUNIT_ASSERT(!isSkipped(openedName));
+            continue;
+        }
+
+        // Every other event is about the oldest script that didn't end yet,
+        // as all scripts end in the order they started
+        CPPUNIT_ASSERT(numEnded < started.size());
+        const String &scriptName = started[numEnded];
+        const String baseName = scriptName.substr(0u, scriptName.find('.'));
+
+        if (event.compare(0, 7, "parsed ") == 0)
+        {
+            CPPUNIT_ASSERT_EQUAL("parsed " + baseName, event);
+            CPPUNIT_ASSERT(!isSkipped(scriptName));
+            ++numParsed;
+        }
+        else
+        {
+            CPPUNIT_ASSERT_EQUAL("ended " + scriptName, event);
+            // Parsed right before it ended, unless skipped
+            CPPUNIT_ASSERT(isSkipped(scriptName) || events[i - 1u] == "parsed " + baseName);
+            ++numEnded;
+        }
+    }
+
+    CPPUNIT_ASSERT_EQUAL(c_numScripts, started.size());
+    CPPUNIT_ASSERT_EQUAL(c_numScripts, numEnded);
+    CPPUNIT_ASSERT_EQUAL(c_numScripts - (c_numScripts + 1u) / 3u, numParsed);
+}
+//--------------------------------------------------------------------------
+void ScriptParsingTests::testSerial()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    size_t numPrepared = 0;
+    const StringVector events = parseScripts(1u, true, numPrepared);
+    checkEventOrder(events);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, numPrepared);
+
+    // started, opened, parsed, ended; one script at a time
+    for (size_t i = 1u; i + 1u < events.size(); ++i)
+    {
+        if (events[i].compare(0, 8, "started ") != 0)
+            continue;
+        const String scriptName = events[i].substr(8u);
+        if (isSkipped(scriptName))
+        {
+            CPPUNIT_ASSERT_EQUAL("ended " + scriptName, events[i + 1u]);
+        }
+        else
+        {
+            CPPUNIT_ASSERT_EQUAL("opened " + scriptName, events[i + 1u]);
+            CPPUNIT_ASSERT_EQUAL("ended " + scriptName, events[i + 3u]);
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void ScriptParsingTests::testParallel()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    // 2 threads prepare batches of 32 scripts, thus 40 scripts take 2 batches
+    size_t numPrepared = 0;
+    const StringVector events = parseScripts(2u, true, numPrepared);
+    checkEventOrder(events);
+    CPPUNIT_ASSERT_EQUAL(c_numScripts - (c_numScripts + 1u) / 3u, numPrepared);
+}
+//--------------------------------------------------------------------------
+void ScriptParsingTests::testWithoutPrepareSupport()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    size_t numPrepared = 0;
+    const StringVector events = parseScripts(4u, false, numPrepared);
+    checkEventOrder(events);
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, numPrepared);
+
+    // Same order as with a single thread
+    for (size_t i = 1u; i + 1u < events.size(); ++i)
+    {
+        if (events[i].compare(0, 8, "started ") == 0 && !isSkipped(events[i].substr(8u)))
+            CPPUNIT_ASSERT_EQUAL("opened " + events[i].substr(8u), events[i + 1u]);
+    }
+}
@@ -0,0 +1,237 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "SkeletonPoseSharingTests.h"
+#include "NULLRenderSystemRoot.h"
+#include "UnitTestSuite.h"
+
+#include "Animation/OgreSkeletonAnimManager.h"
+#include "Animation/OgreSkeletonAnimation.h"
+#include "Animation/OgreSkeletonInstance.h"
+#include "OgreAnimation.h"
+#include "OgreAnimationTrack.h"
+#include "OgreKeyFrame.h"
+#include "OgreOldBone.h"
+#include "OgreOldSkeletonManager.h"
+#include "OgreResourceGroupManager.h"
+#include "OgreRoot.h"
+#include "OgreSceneManager.h"
+#include "OgreSkeleton.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SkeletonPoseSharingTests);
+
+namespace
+{
+    struct BonePose
+    {
+        Vector3 position;
+        Quaternion orientation;
+        Vector3 scale;
+    };
+    typedef std::vector<BonePose> BonePoseVec;
+
+    BonePoseVec getLocalPose(SkeletonInstance *skeleton)
+    {
+        BonePoseVec retVal(skeleton->getNumBones());
+        for (size_t i = 0; i < retVal.size(); ++i)
+        {
+            Bone *bone = skeleton->getBone(i);
+            retVal[i].position = bone->getPosition();
+            retVal[i].orientation = bone->getOrientation();
+            retVal[i].scale = bone->getScale();
+        }
+        return retVal;
+    }
+
+    bool isSamePose(const BonePoseVec &a, const BonePoseVec &b)
+    {
+        for (size_t i = 0; i < a.size(); ++i)
+        {
+            if (!a[i].position.positionEquals(b[i].position, 1e-5f) ||
+                Math::Abs(a[i].orientation.Dot(b[i].orientation)) < 1.0f - 1e-6f ||
+                !a[i].scale.positionEquals(b[i].scale, 1e-5f))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace
+
+//--------------------------------------------------------------------------
+void SkeletonPoseSharingTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+
+    mRoot = new NULLRenderSystemRoot();
+    mSceneManager = mRoot->getRoot()->createSceneManager(ST_GENERIC, 1u);
+
+    // A root with 4 children (whole SIMD blocks per instance) and a grandchild
+    // (which shares its SIMD block with other instances)
+    v1::SkeletonPtr skeleton = v1::OldSkeletonManager::getSingleton().create(
+        "SkeletonPoseSharingTests", ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, true);
+    v1::OldBone *rootBone = skeleton->createBone("Root");
+    for (int i = 0; i < 4; ++i)
+    {
+        v1::OldBone *child = skeleton->createBone("Child" + StringConverter::toString(i));
+        child->setPosition(Vector3(Real(i), 1.0f, 0.0f));
+        rootBone->addChild(child);
+    }
+    v1::OldBone *tip = skeleton->createBone("Tip");
+    tip->setPosition(Vector3(0.0f, 1.0f, 0.0f));
+    skeleton->getBone("Child1")->addChild(tip);
+    skeleton->setBindingPose();
+
+    v1::Animation *animation = skeleton->createAnimation("Walk", 8.0f);
+    for (unsigned short i = 0; i < skeleton->getNumBones(); ++i)
+    {
+        v1::OldBone *bone = skeleton->getBone(i);
+        v1::OldNodeAnimationTrack *track = animation->createOldNodeTrack(i, bone);
+        for (int k = 0; k < 3; ++k)
+        {
+            v1::TransformKeyFrame *keyFrame = track->createNodeKeyFrame(Real(k * 4));
+            keyFrame->setTranslate(Vector3(Real(k * (i + 1)), Real(i), Real(-k)));
+            keyFrame->setRotation(Quaternion(Radian(Real(k + i) * 0.4f), Vector3::UNIT_Y));
+        }
+    }
+
+    mSkeletonDef = SkeletonDefPtr(new SkeletonDef(skeleton.get(), 1.0f));
+}
+//--------------------------------------------------------------------------
+void SkeletonPoseSharingTests::tearDown()
+{
+    delete mRoot;
+    mRoot = 0;
+    mSceneManager = 0;
+    mSkeletonDef.reset();
+}
+//--------------------------------------------------------------------------
+SkeletonInstance *SkeletonPoseSharingTests::createInstance(Real frame)
+{
+    SkeletonInstance *skeleton = mSceneManager->createSkeletonInstance(mSkeletonDef.get());
+    skeleton->setPoseSharing(true);
+    SkeletonAnimation *animation = skeleton->getAnimation("Walk");
+    animation->setEnabled(true);
+    animation->setFrame(frame);
+    return skeleton;
+}
+//--------------------------------------------------------------------------
+void SkeletonPoseSharingTests::updateAnimations()
+{
+    SkeletonAnimManager &animManager = mSceneManager->_getSkeletonAnimManager();
+    animManager.bySkeletonDefs.front()._updateAnimations(
+        0u, animManager.poseSharingFrameTolerance, animManager.poseSharingWeightTolerance);
+}
+//--------------------------------------------------------------------------
+void SkeletonPoseSharingTests::testCopiedPoseMatchesEvaluated()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    std::vector<SkeletonInstance *> skeletons;
+    for (size_t i = 0; i < 6u; ++i)
+        skeletons.push_back(createInstance(2.5f));
+
+    updateAnimations();
+    CPPUNIT_ASSERT_EQUAL(skeletons.size() - 1u,
+                         mSceneManager->_getSkeletonAnimManager().bySkeletonDefs.front()
+                             .getNumSharedPoses());
+
+    std::vector<BonePoseVec> copiedPoses;
+    for (size_t i = 0; i < skeletons.size(); ++i)
+    {
+        copiedPoses.push_back(getLocalPose(skeletons[i]));
+        skeletons[i]->setPoseSharing(false);
+    }
+
+    // The pose isn't the bind pose, otherwise the comparison below proves nothing
+    CPPUNIT_ASSERT(Math::Abs(copiedPoses[0][2].orientation.Dot(Quaternion::IDENTITY)) < 0.99f);
+
+    updateAnimations();
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, mSceneManager->_getSkeletonAnimManager()
+                                         .bySkeletonDefs.front()
+                                         .getNumSharedPoses());
+
+    for (size_t i = 0; i < skeletons.size(); ++i)
+        CPPUNIT_ASSERT(isSamePose(copiedPoses[i], getLocalPose(skeletons[i])));
+}
+//--------------------------------------------------------------------------
+void SkeletonPoseSharingTests::testDifferentPosesNotShared()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    SkeletonInstance *reference = createInstance(2.5f);
+    SkeletonInstance *samePose = createInstance(2.5f);
+    SkeletonInstance *otherFrame = createInstance(5.0f);
+    SkeletonInstance *otherWeight = createInstance(2.5f);
+    otherWeight->getAnimation("Walk")->mWeight = 0.5f;
+    SkeletonInstance *otherBoneWeight = createInstance(2.5f);
+    otherBoneWeight->getAnimation("Walk")->setBoneWeight("Child1", 0.25f);
+    SkeletonInstance *otherTipWeight = createInstance(2.5f);
+    otherTipWeight->getAnimation("Walk")->setBoneWeight("Tip", 0.0f);
+
+    SkeletonInstance *skeletons[] = { reference,   samePose,        otherFrame,
+                                      otherWeight, otherBoneWeight, otherTipWeight };
+    const size_t numSkeletons = sizeof(skeletons) / sizeof(skeletons[0]);
+
+    const SkeletonAnimManager &animManager = mSceneManager->_getSkeletonAnimManager();
+    const Real frameTolerance = animManager.poseSharingFrameTolerance;
+    const Real weightTolerance = animManager.poseSharingWeightTolerance;
+
+    CPPUNIT_ASSERT(reference->_hasSamePose(samePose, frameTolerance, weightTolerance));
+    CPPUNIT_ASSERT_EQUAL(reference->_getPoseHash(frameTolerance, weightTolerance),
+                         samePose->_getPoseHash(frameTolerance, weightTolerance));
+    for (size_t i = 2u; i < numSkeletons; ++i)
+    {
+        CPPUNIT_ASSERT(!reference->_hasSamePose(skeletons[i], frameTolerance, weightTolerance));
+        CPPUNIT_ASSERT(!skeletons[i]->_hasSamePose(reference, frameTolerance, weightTolerance));
+    }
+
+    updateAnimations();
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, animManager.bySkeletonDefs.front().getNumSharedPoses());
+
+    std::vector<BonePoseVec> sharedPoses;
+    for (size_t i = 0; i < numSkeletons; ++i)
+    {
+        sharedPoses.push_back(getLocalPose(skeletons[i]));
+        skeletons[i]->setPoseSharing(false);
+    }
+
+    updateAnimations();
+
+    for (size_t i = 0; i < numSkeletons; ++i)
+    {
+        const BonePoseVec evaluatedPose = getLocalPose(skeletons[i]);
+        CPPUNIT_ASSERT(isSamePose(sharedPoses[i], evaluatedPose));
+        // Every instance but samePose really ends up with a different pose
+        if (i > 1u)
+            CPPUNIT_ASSERT(!isSamePose(sharedPoses[0], evaluatedPose));
+    }
+}
@@ -0,0 +1,149 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+#include "SkeletonTrackCompressionTests.h"
+#include "UnitTestSuite.h"
+
+#include "Animation/OgreSkeletonTrack.h"
+#include "Math/Array/OgreKfTransformArrayMemoryManager.h"
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(SkeletonTrackCompressionTests);
+
+static const size_t c_numKeyFrames = 40u;
+
+/// Slot 0 moves linearly for the first half then follows a curve. Slot 1 is static
+static void fillTrack(SkeletonTrack &track)
+{
+    for (size_t k = 0; k < c_numKeyFrames; ++k)
+        track.addKeyFrame(Real(k), 1.0f);
+
+    const Vector3 axis = Vector3(0.3f, 1.0f, -0.2f).normalisedCopy();
+    for (size_t k = 0; k < c_numKeyFrames; ++k)
+    {
+        const Real z = k < c_numKeyFrames / 2u ? 0.0f : Math::Sin(Radian(k * 0.3f));
+        track.setKeyFrameTransform(Real(k), 0, Vector3(k * 0.5f, 2.0f, z),
+                                   Quaternion(Radian(k * 0.05f), axis), Vector3::UNIT_SCALE);
+        track.setKeyFrameTransform(Real(k), 1, Vector3(1.0f, 2.0f, 3.0f), Quaternion::IDENTITY,
+                                   Vector3::UNIT_SCALE);
+    }
+    track._bakeUnusedSlots();
+}
+
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::testCompression()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    KfTransformArrayMemoryManager memoryManager(0, c_numKeyFrames * ARRAY_PACKED_REALS,
+                                                std::numeric_limits<size_t>::max(),
+                                                c_numKeyFrames * ARRAY_PACKED_REALS);
+    memoryManager.initialize();
+
+    SkeletonTrack track(0, &memoryManager);
+    fillTrack(track);
+
+    std::vector<Vector3> originalPos(c_numKeyFrames);
+    std::vector<Quaternion> originalRot(c_numKeyFrames);
+    for (size_t k = 0; k < c_numKeyFrames; ++k)
+    {
+        Vector3 scale;
+        track.getKeyFrameTransform(k, 0, originalPos[k], originalRot[k], scale);
+    }
+
+    KeyFrameCompressionSettings settings;
+    KeyFrameCompressionReport report;
+    track._compress(settings, report);
+
+    CPPUNIT_ASSERT(track.isCompressed());
+    CPPUNIT_ASSERT_EQUAL(c_numKeyFrames, report.numKeyFramesBefore);
+    CPPUNIT_ASSERT_EQUAL(track.getKeyFrames().size(), report.numKeyFramesAfter);
+    // The linear half collapses to its ends
+    CPPUNIT_ASSERT(report.numKeyFramesAfter < c_numKeyFrames - c_numKeyFrames / 4u);
+    CPPUNIT_ASSERT(report.bytesAfter * 2u < report.bytesBefore);
+
+    // Quantization adds a little on top of the tolerance used to remove keyframes
+    CPPUNIT_ASSERT(report.maxPositionError < settings.positionTolerance * 2.0f);
+    CPPUNIT_ASSERT(report.maxRotationError < settings.rotationTolerance * 2.0f);
+    CPPUNIT_ASSERT(report.maxScaleError < settings.scaleTolerance);
+
+    // Surviving keyframes decode to their original values
+    const KeyFrameRigVec &keyFrames = track.getKeyFrames();
+    for (size_t k = 0; k < keyFrames.size(); ++k)
+    {
+        const size_t originalIdx = static_cast<size_t>(keyFrames[k].mFrame);
+        Vector3 pos, scale;
+        Quaternion rot;
+        track.getKeyFrameTransform(k, 0, pos, rot, scale);
+        CPPUNIT_ASSERT(pos.distance(originalPos[originalIdx]) < 1e-3f);
+        CPPUNIT_ASSERT(Math::Abs(rot.Dot(originalRot[originalIdx])) > 1.0f - 1e-6f);
+        CPPUNIT_ASSERT(scale.positionEquals(Vector3::UNIT_SCALE, 1e-6f));
+    }
+}
+//--------------------------------------------------------------------------
+void SkeletonTrackCompressionTests::testConstantChannels()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    KfTransformArrayMemoryManager memoryManager(0, c_numKeyFrames * ARRAY_PACKED_REALS,
+                                                std::numeric_limits<size_t>::max(),
+                                                c_numKeyFrames * ARRAY_PACKED_REALS);
+    memoryManager.initialize();
+
+    SkeletonTrack track(0, &memoryManager);
+    fillTrack(track);
+
+    KeyFrameCompressionSettings settings;
+    settings.removeKeyFrames = false;
+    KeyFrameCompressionReport report;
+    track._compress(settings, report);
+
+    CPPUNIT_ASSERT_EQUAL(c_numKeyFrames, track.getKeyFrames().size());
+
+    // Only positions and rotations are stored per keyframe; scale is constant
+    const size_t perKeyFrame = (6u * ARRAY_PACKED_REALS + 1u) * sizeof(uint16);
+    CPPUNIT_ASSERT(track.getCompressedSize() <
+                   c_numKeyFrames * perKeyFrame + 16u * sizeof(ArrayReal) + 1u);
+
+    Vector3 pos, scale;
+    Quaternion rot;
+    track.getKeyFrameTransform(c_numKeyFrames - 1u, 1, pos, rot, scale);
+    CPPUNIT_ASSERT(pos.positionEquals(Vector3(1.0f, 2.0f, 3.0f), 1e-4f));
+    CPPUNIT_ASSERT(Math::Abs(rot.Dot(Quaternion::IDENTITY)) > 1.0f - 1e-6f);
+    CPPUNIT_ASSERT(scale.positionEquals(Vector3::UNIT_SCALE, 1e-6f));
+}
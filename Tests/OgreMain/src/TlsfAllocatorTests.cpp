@@ -0,0 +1,198 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "TlsfAllocatorTests.h"
+#include "UnitTestSuite.h"
+
+#include "Vao/OgreTlsfAllocator.h"
+
+#include <stdlib.h>
+#include <map>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TlsfAllocatorTests);
+
+/// Checks the blocks tile the whole capacity, free ones are never
+/// contiguous, and the totals match the allocator's
+static void checkBlocks(const TlsfAllocator &allocator)
+{
+    TlsfAllocator::BlockVec blocks;
+    allocator.getBlocks(blocks);
+
+    size_t offset = 0;
+    size_t freeBytes = 0;
+    size_t numFreeBlocks = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        CPPUNIT_ASSERT_EQUAL(offset, blocks[i].offset);
+        if (!blocks[i].used)
+        {
+            CPPUNIT_ASSERT(i == 0 || blocks[i - 1u].used);
+            freeBytes += blocks[i].size;
+            ++numFreeBlocks;
+        }
+        offset += blocks[i].size;
+    }
+
+    CPPUNIT_ASSERT_EQUAL(allocator.getCapacity(), offset);
+    CPPUNIT_ASSERT_EQUAL(allocator.getFreeBytes(), freeBytes);
+    CPPUNIT_ASSERT_EQUAL(allocator.getNumFreeBlocks(), numFreeBlocks);
+}
+//--------------------------------------------------------------------------
+void TlsfAllocatorTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void TlsfAllocatorTests::tearDown() {}
+//--------------------------------------------------------------------------
+void TlsfAllocatorTests::testAllocate()
+{
+    TlsfAllocator allocator;
+    allocator.initialize(1000u);
+
+    size_t offsets[3];
+    CPPUNIT_ASSERT(allocator.allocate(10u, 1u, offsets[0]));
+    // Vertex buffers align to their vertex size, which isn't always a power of 2
+    CPPUNIT_ASSERT(allocator.allocate(24u, 12u, offsets[1]));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, offsets[1] % 12u);
+    CPPUNIT_ASSERT(offsets[1] >= offsets[0] + 10u || offsets[1] + 24u <= offsets[0]);
+    checkBlocks(allocator);
+
+    // Too big for what's left
+    CPPUNIT_ASSERT(!allocator.allocate(1000u, 1u, offsets[2]));
+    CPPUNIT_ASSERT(allocator.allocate(allocator.getLargestFreeBlock(), 1u, offsets[2]));
+    checkBlocks(allocator);
+
+    allocator.deallocate(offsets[1]);
+    allocator.deallocate(offsets[0]);
+    allocator.deallocate(offsets[2]);
+    checkBlocks(allocator);
+    CPPUNIT_ASSERT(allocator.isEmpty());
+    CPPUNIT_ASSERT_EQUAL((size_t)1u, allocator.getNumFreeBlocks());
+    CPPUNIT_ASSERT_EQUAL((size_t)1000u, allocator.getLargestFreeBlock());
+    CPPUNIT_ASSERT(allocator.getFragmentation() == 0.0f);
+
+    // Sizes right below a power of 2 fall in the same list as smaller ones
+    allocator.initialize(127u);
+    CPPUNIT_ASSERT(allocator.allocate(127u, 1u, offsets[0]));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, allocator.getFreeBytes());
+}
+//--------------------------------------------------------------------------
+void TlsfAllocatorTests::testRandom()
+{
+    const size_t capacity = 1024u * 1024u;
+    TlsfAllocator allocator;
+    allocator.initialize(capacity);
+
+    // Offset -> size
+    std::map<size_t, size_t> allocations;
+    size_t usedBytes = 0;
+
+    for (size_t i = 0; i < 5000u; ++i)
+    {
+        if (allocations.empty() || rand() % 3 != 0)
+        {
+            const size_t sizeBytes = 1u + size_t(rand()) % 4096u;
+            const size_t alignment = 1u + size_t(rand()) % 32u;
+            size_t offset;
+            if (allocator.allocate(sizeBytes, alignment, offset))
+            {
+                CPPUNIT_ASSERT_EQUAL((size_t)0u, offset % alignment);
+                CPPUNIT_ASSERT(offset + sizeBytes <= capacity);
+
+                std::map<size_t, size_t>::const_iterator next = allocations.lower_bound(offset);
+                if (next != allocations.end())
+                    CPPUNIT_ASSERT(offset + sizeBytes <= next->first);
+                if (next != allocations.begin())
+                {
+                    --next;
+                    CPPUNIT_ASSERT(next->first + next->second <= offset);
+                }
+
+                allocations[offset] = sizeBytes;
+                usedBytes += sizeBytes;
+            }
+        }
+        else
+        {
+            std::map<size_t, size_t>::iterator itor = allocations.begin();
+            std::advance(itor, size_t(rand()) % allocations.size());
+            allocator.deallocate(itor->first);
+            usedBytes -= itor->second;
+            allocations.erase(itor);
+        }
+
+        CPPUNIT_ASSERT_EQUAL(capacity - usedBytes, allocator.getFreeBytes());
+    }
+
+    checkBlocks(allocator);
+    CPPUNIT_ASSERT_EQUAL(allocations.size(), allocator.getNumAllocations());
+
+    while (!allocations.empty())
+    {
+        allocator.deallocate(allocations.begin()->first);
+        allocations.erase(allocations.begin());
+    }
+    CPPUNIT_ASSERT_EQUAL(capacity, allocator.getLargestFreeBlock());
+}
+//--------------------------------------------------------------------------
+void TlsfAllocatorTests::testAllocateBelow()
+{
+    TlsfAllocator allocator;
+    allocator.initialize(1000u);
+
+    size_t offsets[4];
+    for (size_t i = 0; i < 4u; ++i)
+    {
+        CPPUNIT_ASSERT(allocator.allocate(100u, 1u, offsets[i]));
+        CPPUNIT_ASSERT_EQUAL(i * 100u, offsets[i]);
+    }
+
+    // Holes at 0 and 200
+    allocator.deallocate(offsets[0]);
+    allocator.deallocate(offsets[2]);
+
+    size_t newOffset;
+    CPPUNIT_ASSERT(allocator.allocateBelow(100u, 1u, offsets[3], newOffset));
+    CPPUNIT_ASSERT_EQUAL((size_t)0u, newOffset);
+    CPPUNIT_ASSERT(!allocator.allocateBelow(100u, 1u, offsets[1], newOffset));
+
+    // The aligned start of the hole at 200 is past maxOffset
+    CPPUNIT_ASSERT(!allocator.allocateBelow(10u, 64u, 250u, newOffset));
+    CPPUNIT_ASSERT(allocator.allocateBelow(10u, 64u, 300u, newOffset));
+    CPPUNIT_ASSERT_EQUAL((size_t)256u, newOffset);
+    checkBlocks(allocator);
+
+    // The tail is free, but never below
+    CPPUNIT_ASSERT(!allocator.allocateBelow(100u, 1u, 200u, newOffset));
+    checkBlocks(allocator);
+}
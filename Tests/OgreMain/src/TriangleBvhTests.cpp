@@ -0,0 +1,167 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "TriangleBvhTests.h"
+#include "UnitTestSuite.h"
+
+#include "Math/Array/OgreTriangleBvh.h"
+#include "OgreRay.h"
+
+#include <stdlib.h>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(TriangleBvhTests);
+
+static Real randomReal(Real minValue, Real maxValue)
+{
+    return minValue + (maxValue - minValue) * Real(rand()) / Real(RAND_MAX);
+}
+
+static Vector3 randomVector3(Real minValue, Real maxValue)
+{
+    return Vector3(randomReal(minValue, maxValue), randomReal(minValue, maxValue),
+                   randomReal(minValue, maxValue));
+}
+
+/// Brute force reference. Returns the distance to the closest triangle, or maxDistance
+static Real bruteForce(const Ray &ray, const std::vector<Vector3> &vertices, Real maxDistance)
+{
+    Real closest = maxDistance;
+    for (size_t i = 0; i < vertices.size(); i += 3u)
+    {
+        const Vector3 edge1 = vertices[i + 1u] - vertices[i];
+        const Vector3 edge2 = vertices[i + 2u] - vertices[i];
+        const Vector3 pvec = ray.getDirection().crossProduct(edge2);
+        const Real det = edge1.dotProduct(pvec);
+        if (Math::Abs(det) <= Real(1e-20))
+            continue;
+
+        const Vector3 tvec = ray.getOrigin() - vertices[i];
+        const Real u = tvec.dotProduct(pvec) / det;
+        const Vector3 qvec = tvec.crossProduct(edge1);
+        const Real v = ray.getDirection().dotProduct(qvec) / det;
+        const Real t = edge2.dotProduct(qvec) / det;
+        if (u >= 0 && v >= 0 && u + v <= 1 && t >= 0 && t < closest)
+            closest = t;
+    }
+    return closest;
+}
+
+//--------------------------------------------------------------------------
+void TriangleBvhTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+    srand(0);
+}
+//--------------------------------------------------------------------------
+void TriangleBvhTests::tearDown() {}
+//--------------------------------------------------------------------------
+void TriangleBvhTests::testIntersects()
+{
+    const size_t numTriangles[] = {1u, 3u, 4u, 5u, 17u, 1000u};
+
+    for (size_t n = 0; n < sizeof(numTriangles) / sizeof(numTriangles[0]); ++n)
+    {
+        std::vector<Vector3> vertices;
+        TriangleBvh bvh;
+        for (size_t i = 0; i < numTriangles[n]; ++i)
+        {
+            const Vector3 center = randomVector3(-100.0f, 100.0f);
+            for (size_t j = 0; j < 3u; ++j)
+                vertices.push_back(center + randomVector3(-5.0f, 5.0f));
+            bvh.addTriangle(vertices[i * 3u], vertices[i * 3u + 1u], vertices[i * 3u + 2u]);
+        }
+        bvh.build();
+
+        CPPUNIT_ASSERT_EQUAL(numTriangles[n], bvh.getNumTriangles());
+
+        for (size_t i = 0; i < 500u; ++i)
+        {
+            // Aim at a random triangle half of the time, so that there are plenty of hits
+            Vector3 target = randomVector3(-100.0f, 100.0f);
+            if (i & 0x01)
+            {
+                const size_t triIdx = size_t(rand()) % numTriangles[n];
+                target = (vertices[triIdx * 3u] + vertices[triIdx * 3u + 1u] +
+                          vertices[triIdx * 3u + 2u]) / 3.0f;
+            }
+            const Vector3 origin = randomVector3(-120.0f, 120.0f);
+            const Ray ray(origin, (target - origin).normalisedCopy());
+
+            const Real expected = bruteForce(ray, vertices, Math::POS_INFINITY);
+            const bool expectedHit = expected != Math::POS_INFINITY;
+
+            TriangleBvh::Hit hit;
+            CPPUNIT_ASSERT_EQUAL(expectedHit, bvh.intersects(ray, Math::POS_INFINITY, hit));
+            CPPUNIT_ASSERT_EQUAL(expectedHit, bvh.intersectsAny(ray, Math::POS_INFINITY));
+            if (expectedHit)
+            {
+                const Real tolerance = 1e-3f * std::max(Real(1), expected);
+                CPPUNIT_ASSERT(Math::Abs(hit.distance - expected) <= tolerance);
+                CPPUNIT_ASSERT(hit.triangleIdx < numTriangles[n]);
+            }
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void TriangleBvhTests::testMaxDistance()
+{
+    TriangleBvh bvh;
+    const Ray ray(Vector3::ZERO, Vector3::UNIT_Z);
+    TriangleBvh::Hit hit;
+
+    bvh.build();
+    CPPUNIT_ASSERT(bvh.isEmpty());
+    CPPUNIT_ASSERT(!bvh.intersects(ray, Math::POS_INFINITY, hit));
+
+    // Two triangles facing the ray, at z = 10 and z = 20
+    bvh.addTriangle(Vector3(-1, -1, 20), Vector3(1, -1, 20), Vector3(0, 1, 20));
+    bvh.addTriangle(Vector3(-1, -1, 10), Vector3(0, 1, 10), Vector3(1, -1, 10));
+    bvh.build();
+
+    CPPUNIT_ASSERT(bvh.intersects(ray, Math::POS_INFINITY, hit));
+    CPPUNIT_ASSERT_EQUAL(uint32(1u), hit.triangleIdx);
+    CPPUNIT_ASSERT(Math::Abs(hit.distance - 10.0f) < 1e-4f);
+
+    CPPUNIT_ASSERT(!bvh.intersects(ray, 5.0f, hit));
+    CPPUNIT_ASSERT(!bvh.intersectsAny(ray, 5.0f));
+    CPPUNIT_ASSERT(bvh.intersectsAny(ray, 15.0f));
+
+    // Triangle 1 is anticlockwise as seen from the ray, triangle 0 is clockwise
+    CPPUNIT_ASSERT(bvh.intersects(ray, Math::POS_INFINITY, hit, CULL_ANTICLOCKWISE));
+    CPPUNIT_ASSERT_EQUAL(uint32(0u), hit.triangleIdx);
+    CPPUNIT_ASSERT(bvh.intersects(ray, Math::POS_INFINITY, hit, CULL_CLOCKWISE));
+    CPPUNIT_ASSERT_EQUAL(uint32(1u), hit.triangleIdx);
+    CPPUNIT_ASSERT(!bvh.intersectsAny(ray, 15.0f, CULL_ANTICLOCKWISE));
+
+    // Behind the origin
+    CPPUNIT_ASSERT(!bvh.intersects(Ray(Vector3(0, 0, 30), Vector3::UNIT_Z), Math::POS_INFINITY, hit));
+}
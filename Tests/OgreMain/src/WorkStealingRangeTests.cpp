@@ -0,0 +1,216 @@
+/*
+-----------------------------------------------------------------------------
+This source file is part of OGRE-Next
+    (Object-oriented Graphics Rendering Engine)
+For the latest info, see http://www.ogre3d.org/
+
+Copyright (c) 2000-2023 Torus Knot Software Ltd
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+-----------------------------------------------------------------------------
+*/
+
+#include "WorkStealingRangeTests.h"
+#include "UnitTestSuite.h"
+
+#include "Threading/OgreThreads.h"
+#include "Threading/OgreWorkStealingRange.h"
+
+#include <atomic>
+#include <vector>
+
+using namespace Ogre;
+
+// Register the test suite
+CPPUNIT_TEST_SUITE_REGISTRATION(WorkStealingRangeTests);
+
+namespace
+{
+    struct WorkStealingJob
+    {
+        WorkStealingRange *workRange;
+        std::atomic<uint32> *timesAcquired;
+        size_t granularity;
+        std::atomic<uint32> numMisalignedChunks;
+    };
+
+    unsigned long acquireAllThread(ThreadHandle *threadHandle)
+    {
+        WorkStealingJob *job = reinterpret_cast<WorkStealingJob *>(threadHandle->getUserParam());
+
+        size_t start, count;
+        while (job->workRange->acquire(threadHandle->getThreadIdx(), start, count))
+        {
+            if (start % job->granularity)
+                ++job->numMisalignedChunks;
+            for (size_t i = start; i < start + count; ++i)
+                ++job->timesAcquired[i];
+        }
+        return 0;
+    }
+    THREAD_DECLARE(acquireAllThread);
+}  // namespace
+
+//--------------------------------------------------------------------------
+void WorkStealingRangeTests::setUp()
+{
+    UnitTestSuite::getSingletonPtr()->startTestSetup(__FUNCTION__);
+}
+//--------------------------------------------------------------------------
+void WorkStealingRangeTests::tearDown()
+{
+}
+//--------------------------------------------------------------------------
+void WorkStealingRangeTests::testSingleThreaded()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numItems[] = { 0u, 1u, 3u, 4u, 17u, 1000u, 4099u };
+    const size_t numThreads[] = { 1u, 2u, 3u, 8u };
+
+    WorkStealingRange workRange;
+
+    for (size_t stealing = 0; stealing < 2u; ++stealing)
+    {
+        workRange.setStealingEnabled(stealing != 0u);
+
+        for (size_t i = 0; i < sizeof(numItems) / sizeof(numItems[0]); ++i)
+        {
+            for (size_t j = 0; j < sizeof(numThreads) / sizeof(numThreads[0]); ++j)
+            {
+                workRange.reset(numItems[i], numThreads[j], 4u, 3u);
+
+                std::vector<uint32> timesAcquired(numItems[i], 0u);
+
+                // Interleave the threads. When stealing is disabled, every thread
+                // keeps going until its own slice is exhausted.
+                std::vector<bool> threadDone(numThreads[j], false);
+                size_t numThreadsDone = 0u;
+                while (numThreadsDone < numThreads[j])
+                {
+                    for (size_t threadIdx = 0; threadIdx < numThreads[j]; ++threadIdx)
+                    {
+                        size_t start, count;
+                        if (threadDone[threadIdx])
+                            continue;
+                        if (!workRange.acquire(threadIdx, start, count))
+                        {
+                            threadDone[threadIdx] = true;
+                            ++numThreadsDone;
+                            continue;
+                        }
+
+                        CPPUNIT_ASSERT(count > 0u);
+                        CPPUNIT_ASSERT_EQUAL((size_t)0u, start % 4u);
+                        CPPUNIT_ASSERT(start + count <= numItems[i]);
+                        for (size_t k = start; k < start + count; ++k)
+                            ++timesAcquired[k];
+                    }
+                }
+
+                for (size_t k = 0; k < numItems[i]; ++k)
+                    CPPUNIT_ASSERT_EQUAL((uint32)1u, timesAcquired[k]);
+            }
+        }
+    }
+}
+//--------------------------------------------------------------------------
+void WorkStealingRangeTests::testNoStealing()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numItems = 1000u;
+    const size_t numThreads = 3u;
+    // ceil( 1000 / 3 ) aligned to 4
+    const size_t itemsPerThread = 336u;
+
+    WorkStealingRange workRange;
+    workRange.setStealingEnabled(false);
+
+    for (size_t threadIdx = 0; threadIdx < numThreads; ++threadIdx)
+    {
+        workRange.reset(numItems, numThreads, 4u);
+
+        // Only this thread runs. It must get its own slice, in order, and nothing else.
+        const size_t sliceStart = threadIdx * itemsPerThread;
+        const size_t sliceEnd = std::min(sliceStart + itemsPerThread, numItems);
+
+        size_t nextExpected = sliceStart;
+        size_t start, count;
+        while (workRange.acquire(threadIdx, start, count))
+        {
+            CPPUNIT_ASSERT_EQUAL(nextExpected, start);
+            nextExpected += count;
+        }
+        CPPUNIT_ASSERT_EQUAL(sliceEnd, nextExpected);
+    }
+
+    // With stealing, a lone thread gets everything
+    workRange.setStealingEnabled(true);
+    workRange.reset(numItems, numThreads, 4u);
+
+    size_t numAcquired = 0u;
+    size_t start, count;
+    while (workRange.acquire(1u, start, count))
+        numAcquired += count;
+    CPPUNIT_ASSERT_EQUAL(numItems, numAcquired);
+}
+//--------------------------------------------------------------------------
+void WorkStealingRangeTests::testMultiThreaded()
+{
+    UnitTestSuite::getSingletonPtr()->startTestMethod(__FUNCTION__);
+
+    const size_t numThreads = 4u;
+    const size_t numItems[] = { 5u, 4096u, 100003u };
+
+    WorkStealingRange workRange;
+
+    for (size_t stealing = 0; stealing < 2u; ++stealing)
+    {
+        workRange.setStealingEnabled(stealing != 0u);
+
+        for (size_t i = 0; i < sizeof(numItems) / sizeof(numItems[0]); ++i)
+        {
+            for (size_t repeat = 0; repeat < 10u; ++repeat)
+            {
+                std::vector<std::atomic<uint32> > timesAcquired(numItems[i]);
+                for (size_t k = 0; k < numItems[i]; ++k)
+                    timesAcquired[k] = 0u;
+
+                WorkStealingJob job;
+                job.workRange = &workRange;
+                job.timesAcquired = timesAcquired.data();
+                job.granularity = 4u;
+                job.numMisalignedChunks = 0u;
+
+                // Small chunks, to make the threads contend as much as possible
+                workRange.reset(numItems[i], numThreads, job.granularity, 64u);
+
+                ThreadHandlePtr threadHandles[numThreads];
+                for (size_t t = 0; t < numThreads; ++t)
+                    threadHandles[t] = Threads::CreateThread(THREAD_GET(acquireAllThread), t, &job);
+                Threads::WaitForThreads(numThreads, threadHandles);
+
+                CPPUNIT_ASSERT_EQUAL((uint32)0u, job.numMisalignedChunks.load());
+                for (size_t k = 0; k < numItems[i]; ++k)
+                    CPPUNIT_ASSERT_EQUAL((uint32)1u, timesAcquired[k].load());
+            }
+        }
+    }
+}
@@ -43,6 +43,10 @@ struct UpgradeOptions
     bool qTangents;
     bool optimizeForShadowMapping;
     bool stripShadowMapping;
+    /// Ogre::MeshOptimizer::Flags to apply to v2 meshes. 0 to not optimize.
+    Ogre::uint32 optimizeGeometry;
+    /// Max triangles per cluster for cluster culling. 0 to not build clusters.
+    Ogre::uint32 clusterTriangles;
 };
 
 extern UpgradeOptions opts;
@@ -111,6 +111,13 @@ void help()
     cout << "             u converts UVs to 16-bit floats." << endl;
     cout << "             s make shadow mapping passes have their own optimized buffers. Overrides existing ones if any." << endl;
     cout << "             S strips the buffers for shadow mapping (consumes less space and memory)." << endl;
+    cout << "-G cofw    = Optimize the geometry of v2 meshes (applied right before saving)." << endl;
+    cout << "             c reorders triangles for the post-transform vertex cache." << endl;
+    cout << "             o reorders clusters of triangles to reduce overdraw." << endl;
+    cout << "             f reorders vertices by first use and removes unused ones." << endl;
+    cout << "             w welds vertices whose data is exactly the same." << endl;
+    cout << "-C n       = Splits v2 meshes in clusters of up to n triangles (i.e. 128) for cluster" << endl;
+    cout << "             culling. Applied after -G." << endl;
     cout << "-U         = Performs the opposite of -O puq: Converts 16-bit half to to float and " << endl;
     cout << "             converts QTangents to Normal + Tangent + Reflection. Needed by many" << endl;
     cout << "             other options that have to read from position, normals or UVs." << endl;
@@ -170,6 +177,8 @@ void parseOpts(UnaryOptionList& unOpts, BinaryOptionList& binOpts)
     opts.qTangents      = false;
     opts.optimizeForShadowMapping = false;
     opts.stripShadowMapping = false;
+    opts.optimizeGeometry = 0;
+    opts.clusterTriangles = 0;
 
 
     UnaryOptionList::iterator ui = unOpts.find("-e");
@@ -368,6 +377,23 @@ void parseOpts(UnaryOptionList& unOpts, BinaryOptionList& binOpts)
         }
     }
 
+    bi = binOpts.find("-G");
+    if( !bi->second.empty() )
+    {
+        if( bi->second.find( 'c' ) != String::npos )
+            opts.optimizeGeometry |= MeshOptimizer::OptimizeVertexCache;
+        if( bi->second.find( 'o' ) != String::npos )
+            opts.optimizeGeometry |= MeshOptimizer::OptimizeOverdraw;
+        if( bi->second.find( 'f' ) != String::npos )
+            opts.optimizeGeometry |= MeshOptimizer::OptimizeVertexFetch;
+        if( bi->second.find( 'w' ) != String::npos )
+            opts.optimizeGeometry |= MeshOptimizer::WeldVertices;
+    }
+
+    bi = binOpts.find("-C");
+    if( !bi->second.empty() )
+        opts.clusterTriangles = StringConverter::parseUnsignedInt( bi->second );
+
     if( opts.interactive || opts.numLods || opts.lodAutoconfigure || opts.generateTangents )
         opts.unoptimizeBuffer = true;
 }
@@ -377,6 +403,8 @@ void vertexBufferReorg(v1::Mesh& mesh);
 void buildEdgeLists( v1::MeshPtr &mesh );
 void generateTangents( v1::MeshPtr &mesh );
 void recalcBounds( v1::MeshPtr &v1Mesh, MeshPtr &v2Mesh );
+void optimizeGeometry( MeshPtr &v2Mesh );
+void buildClusters( MeshPtr &v2Mesh );
 
 void printLodConfig(const LodConfig& lodConfig)
 {
@@ -1061,6 +1089,11 @@ void saveMesh( const String &destination, v1::MeshPtr &v1Mesh, MeshPtr &v2Mesh,
                     vertexBufferReorg( *v1Mesh.get() );
             }
 
+            if( opts.optimizeGeometry )
+                cout << "-G is ignored when saving v1 meshes" << endl;
+            if( opts.clusterTriangles )
+                cout << "-C is ignored when saving v1 meshes" << endl;
+
             cout << "Saving as a v1 mesh..." << endl;
             meshSerializer->exportMesh( v1Mesh.get(), destination, opts.targetVersion, opts.endian );
         }
@@ -1076,6 +1109,9 @@ void saveMesh( const String &destination, v1::MeshPtr &v1Mesh, MeshPtr &v2Mesh,
             if( v1Mesh )
                 v2Mesh->importV1( v1Mesh.get(), false, false, false );
 
+            optimizeGeometry( v2Mesh );
+            buildClusters( v2Mesh );
+
             cout << "Saving as a v2 mesh..." << endl;
             meshSerializer2.exportMesh( v2Mesh.get(), destination, opts.targetVersionV2, opts.endian );
         }
@@ -1236,6 +1272,8 @@ int main(int numargs, char** args)
         binOptList["-ts"] = "";
         binOptList["-V"] = "";
         binOptList["-O"] = "";
+        binOptList["-G"] = "";
+        binOptList["-C"] = "";
 
         int startIdx = findCommandLineOpts(numargs, args, unOptList, binOptList);
         parseOpts(unOptList, binOptList);
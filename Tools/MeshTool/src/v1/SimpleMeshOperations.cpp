@@ -254,3 +254,44 @@ void recalcBounds( v1::MeshPtr &v1Mesh, MeshPtr &v2Mesh )
         v2Mesh->_setBoundingSphereRadius( radius );
     }
 }
+
+void optimizeGeometry( MeshPtr &v2Mesh )
+{
+    if( !v2Mesh || !opts.optimizeGeometry )
+        return;
+
+    cout << "Optimizing geometry..." << endl;
+    const MeshOptimizer::Report report = v2Mesh->optimizeGeometry( opts.optimizeGeometry );
+    cout << "   ACMR:     " << report.before.getAcmr() << " -> " << report.after.getAcmr() << endl;
+    cout << "   ATVR:     " << report.before.getAtvr() << " -> " << report.after.getAtvr() << endl;
+    cout << "   Vertices: " << report.before.numVerticesStored << " -> "
+         << report.after.numVerticesStored << endl;
+}
+
+void buildClusters( MeshPtr &v2Mesh )
+{
+    if( !v2Mesh || !opts.clusterTriangles )
+        return;
+
+    cout << "Building clusters..." << endl;
+    v2Mesh->buildClusters( opts.clusterTriangles );
+
+    size_t numClusters = 0;
+    size_t numTriangles = 0;
+    for( const SubMesh *subMesh : v2Mesh->getSubMeshes() )
+    {
+        if( subMesh->mClusters.empty() )
+            continue;
+
+        // Only report LOD 0
+        for( const MeshCluster &cluster : subMesh->mClusters[0] )
+        {
+            ++numClusters;
+            numTriangles += cluster.indexCount / 3u;
+        }
+    }
+
+    cout << "   Clusters: " << numClusters << endl;
+    if( numClusters )
+        cout << "   Triangles per cluster: " << float( numTriangles ) / float( numClusters ) << endl;
+}